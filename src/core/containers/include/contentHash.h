@@ -0,0 +1,26 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: utils #]
+***/
+
+#pragma once
+
+BEGIN_BOOMER_NAMESPACE()
+
+//-----------------------------------------------------------------------------
+
+/// fast 64-bit hash of a memory block, meant for detecting content changes (NOT cryptographic)
+/// NOTE: this is the XXH3 64-bit hash (default secret, no seed), results are identical to XXH3_64bits() from xxHash 0.8 so they can be checked with external tools
+/// NOTE: several times faster than CRC64 on large blocks, use it instead of CRC for file content
+extern CORE_CONTAINERS_API uint64_t ContentHash64(const void* data, uint64_t size);
+
+/// combine hash of data into existing hash, order dependent
+/// NOTE: use for hashing big data in independent chunks (ie. in parallel) and merging the results in order
+extern CORE_CONTAINERS_API uint64_t ContentHashCombine(uint64_t hash, uint64_t chunkHash);
+
+//-----------------------------------------------------------------------------
+
+END_BOOMER_NAMESPACE()
@@ -16,6 +16,22 @@ BEGIN_BOOMER_NAMESPACE()
 
 //-----------------------------------------------------------------------------
 
+/// implementation of the bulk CRC calculation, all of them give identical results
+enum class CRCImplementation : uint8_t
+{
+    Basic, // byte at a time table lookup
+    Slicing, // slicing-by-16 for CRC32, slicing-by-8 for CRC64
+    CarrylessMultiply, // PCLMULQDQ folding, requires CPU support
+};
+
+/// get the implementation used by CRC32::append and CRC64::append, selected at startup based on the CPU features
+extern CORE_CONTAINERS_API CRCImplementation CRCCurrentImplementation();
+
+/// force specific implementation (mostly for testing), returns false if not supported on this CPU
+extern CORE_CONTAINERS_API bool CRCSelectImplementation(CRCImplementation implementation);
+
+//-----------------------------------------------------------------------------
+
 // CRC calculator for 32-bit CRC values, can be stored and updated as needed
 class CORE_CONTAINERS_API CRC32 : public NoCopy
 {
@@ -66,6 +82,8 @@ private:
 class CORE_CONTAINERS_API CRC64 : public NoCopy
 {
 public:
+    static const uint64_t CRCTable[256];
+
     INLINE CRC64(uint64_t initValue = 0xCBF29CE484222325)
         : m_crc(initValue)
     {};
@@ -106,8 +124,6 @@ private:
     CRC64& appendStatic2(uint16_t data);
     CRC64& appendStatic4(uint32_t data);
     CRC64& appendStatic8(uint64_t data);
-
-    static const uint64_t CRCTable[256];
 };
 
 //-----------------------------------------------------------------------------
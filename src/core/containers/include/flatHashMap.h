@@ -0,0 +1,159 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: containers #]
+***/
+
+#pragma once
+
+#include "array.h"
+#include "pairs.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+///--
+
+/// Hash map with directly accessible keys() and values() arrays, same API as HashMap
+/// Lookup is done in an open addressing table with one control byte per slot (7 bits of hash or empty/deleted marker), 16 control bytes are compared at once (SSE2)
+/// Slots only store index of the key/value in the dense arrays so iteration order is stable and the same as in the HashMap (removal moves last element into the hole)
+/// NOTE: there's no limit on the table size, unlike the HashMap that stops growing the buckets at 64K elements
+template< class K, class V >
+class FlatHashMap
+{
+public:
+    FlatHashMap() = default;
+    FlatHashMap(const FlatHashMap<K, V>& other);
+    FlatHashMap(FlatHashMap<K, V>&& other);
+    FlatHashMap& operator=(const FlatHashMap<K, V>& other);
+    FlatHashMap& operator=(FlatHashMap<K, V>&& other);
+    ~FlatHashMap();
+
+    //! Clear the whole hash map
+    /// NOTE: all memory is released, use reset() to preserve the memory
+    void clear();
+
+    //! Delete the children and clear the map
+    //! NOTE: will not compile if V is not a pointer
+    void clearPtr();
+
+    //! Clear the whole hash map without freeing the memory
+    void reset();
+
+    //! Is the hash map empty ?
+    bool empty() const;
+
+    //! Get number of elements in the hash map
+    uint32_t size() const;
+
+    //! Reserve space in the hash map
+    void reserve(uint32_t size);
+
+    ///--
+
+    //! Set/Create value for given key, returns pointer to the value (inside the map)
+    //! NOTE: if the value for given key is already defined than we change the existing element
+    V* set(const K& key, const V& val);
+
+    //! Remove key from map, returns true if the element was removed and also returns the value of the element removed
+    template< typename FK >
+    bool remove(const FK& key, V* outRemovedValue = nullptr);
+
+    //! Find value by key, returns pointer to the value (inside the map)
+    //! NOTE: the value may be modified freely
+    template< typename FK >
+    V* find(const FK& key);
+
+    //! Find value in a safe way
+    template< typename FK >
+    const V& findSafe(const FK& key, const V& defaultValue = V()) const;
+
+    //! Add key/value pairs from other hashmap into this one
+    //! NOTE: values associated with local keys will be replaced with incoming values
+    void append(const FlatHashMap<K, V>& other);
+
+    //! Find value by key (read only version), returns pointer to the value (inside the map)
+    //! NOTE: the value may not be modified
+    template< typename FK >
+    const V* find(const FK& key) const;
+
+    //! Find value by key
+    template< typename FK >
+    bool find(const FK& key, V& output) const;
+
+    //! Test if the map contains a value for given key
+    template< typename FK >
+    bool contains(const FK& key) const;
+
+    //----
+
+    //! Get entry value, if entry does not exist in the map an empty entry is created
+    V& operator[](const K& key);
+
+    //! Get entry value, if entry does not exist in the map we fatal assert
+    const V& operator[](const K& key) const;
+
+    //---
+
+    //! Get the array with values only
+    Array<V>& values();
+
+    //! Get the array with values only
+    const Array<V>& values() const;
+
+    //! Get the array with keys only
+    const Array<K>& keys() const;
+
+    //! Get table of pairs
+    const PairContainer<K, V> pairs() const;
+
+    //! Get table of pairs
+    PairContainer<K, V> pairs();
+
+protected:
+    static const uint32_t GROUP_SIZE = 16; // control bytes tested at once
+    static const uint32_t MIN_CAPACITY = 16;
+
+    static const int8_t CTRL_EMPTY = -128; // 0x80
+    static const int8_t CTRL_DELETED = -2; // 0xFE
+
+    Array<K> m_keys;
+    Array<V> m_values;
+
+    int8_t* m_ctrl = nullptr; // capacity + GROUP_SIZE bytes, first GROUP_SIZE-1 bytes are cloned at the end so a group can be loaded at any slot
+    uint32_t* m_slots = nullptr; // index into the key/value arrays
+    uint32_t m_capacity = 0; // always pow2
+    uint32_t m_numDeleted = 0; // tombstones, cleaned up on rehash
+
+    //--
+
+    struct HashParts
+    {
+        uint32_t position;
+        int8_t tag;
+    };
+
+    static HashParts SplitHash(uint32_t hash);
+
+    static uint32_t FirstMatch(uint32_t matches);
+    static uint32_t MatchGroup(const int8_t* ctrl, int8_t tag);
+    static uint32_t MatchEmpty(const int8_t* ctrl);
+    static uint32_t MatchEmptyOrDeleted(const int8_t* ctrl);
+
+    template< typename FK >
+    uint32_t findSlot(const FK& key) const; // slot index or INDEX_MAX
+
+    uint32_t findSlotForIndex(const K& key, uint32_t index) const;
+    uint32_t findFreeSlot(uint32_t hash) const;
+    void setCtrl(uint32_t slot, int8_t value);
+
+    void rehash(uint32_t newCapacity);
+    void releaseTable();
+
+    V* add(const K& key, const V& val);
+};
+
+END_BOOMER_NAMESPACE()
+
+#include "flatHashMap.inl"
@@ -0,0 +1,517 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: containers #]
+***/
+
+#pragma once
+
+#include "hash.inl"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+template< class K, class V >
+FlatHashMap<K, V>::FlatHashMap(const FlatHashMap<K, V>& other)
+    : m_keys(other.m_keys)
+    , m_values(other.m_values)
+{
+    if (other.m_capacity)
+    {
+        rehash(other.m_capacity);
+    }
+}
+
+template< class K, class V >
+ALWAYS_INLINE FlatHashMap<K, V>::FlatHashMap(FlatHashMap<K, V>&& other)
+    : m_keys(std::move(other.m_keys))
+    , m_values(std::move(other.m_values))
+    , m_ctrl(other.m_ctrl)
+    , m_slots(other.m_slots)
+    , m_capacity(other.m_capacity)
+    , m_numDeleted(other.m_numDeleted)
+{
+    other.m_ctrl = nullptr;
+    other.m_slots = nullptr;
+    other.m_capacity = 0;
+    other.m_numDeleted = 0;
+}
+
+template< class K, class V >
+FlatHashMap<K, V>& FlatHashMap<K, V>::operator=(const FlatHashMap<K, V>& other)
+{
+    if (this != &other)
+    {
+        m_keys = other.m_keys;
+        m_values = other.m_values;
+
+        releaseTable();
+        if (other.m_capacity)
+            rehash(other.m_capacity);
+    }
+
+    return *this;
+}
+
+template< class K, class V >
+FlatHashMap<K, V>& FlatHashMap<K, V>::operator=(FlatHashMap<K, V>&& other)
+{
+    if (this != &other)
+    {
+        m_keys = std::move(other.m_keys);
+        m_values = std::move(other.m_values);
+
+        releaseTable();
+        m_ctrl = other.m_ctrl;
+        m_slots = other.m_slots;
+        m_capacity = other.m_capacity;
+        m_numDeleted = other.m_numDeleted;
+
+        other.m_ctrl = nullptr;
+        other.m_slots = nullptr;
+        other.m_capacity = 0;
+        other.m_numDeleted = 0;
+    }
+
+    return *this;
+}
+
+template< class K, class V >
+ALWAYS_INLINE FlatHashMap<K, V>::~FlatHashMap()
+{
+    releaseTable();
+}
+
+//--
+
+template< class K, class V >
+INLINE void FlatHashMap<K, V>::clear()
+{
+    m_keys.clear();
+    m_values.clear();
+    releaseTable();
+}
+
+template< class K, class V >
+INLINE void FlatHashMap<K, V>::clearPtr()
+{
+    m_values.clearPtr();
+    clear();
+}
+
+template< class K, class V >
+INLINE bool FlatHashMap<K, V>::empty() const
+{
+    ASSERT(m_values.empty() == m_keys.empty());
+    return m_values.empty();
+}
+
+template< class K, class V >
+INLINE uint32_t FlatHashMap<K, V>::size() const
+{
+    ASSERT(m_values.size() == m_keys.size());
+    return m_values.size();
+}
+
+template< class K, class V >
+INLINE void FlatHashMap<K, V>::reserve(uint32_t size)
+{
+    if (size > m_keys.capacity())
+    {
+        m_keys.reserve(size);
+        m_values.reserve(size);
+    }
+
+    // keep the table at most 7/8 full
+    uint32_t capacity = MIN_CAPACITY;
+    while ((uint64_t)size * 8 > (uint64_t)capacity * 7)
+        capacity *= 2;
+
+    if (capacity > m_capacity)
+        rehash(capacity);
+}
+
+template< class K, class V >
+INLINE void FlatHashMap<K, V>::reset()
+{
+    m_keys.reset();
+    m_values.reset();
+
+    if (m_capacity)
+    {
+        memset(m_ctrl, (uint8_t)CTRL_EMPTY, m_capacity + GROUP_SIZE);
+        m_numDeleted = 0;
+    }
+}
+
+template< class K, class V >
+V* FlatHashMap<K, V>::set(const K& key, const V& val)
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+    {
+        auto& value = m_values[m_slots[slot]];
+        value = val;
+        return &value;
+    }
+
+    return add(key, val);
+}
+
+template< class K, class V >
+template< typename FK >
+bool FlatHashMap<K, V>::remove(const FK& key, V* outRemovedValue /*= nullptr*/)
+{
+    const auto slot = findSlot(key);
+    if (slot == INDEX_MAX)
+        return false;
+
+    const auto index = m_slots[slot];
+    setCtrl(slot, CTRL_DELETED);
+    m_numDeleted += 1;
+
+    // last element will be moved into the hole, update the slot that points to it
+    const auto lastIndex = m_keys.lastValidIndex();
+    if (index != lastIndex)
+    {
+        const auto lastSlot = findSlotForIndex(m_keys.typedData()[lastIndex], lastIndex);
+        m_slots[lastSlot] = index;
+    }
+
+    if (outRemovedValue)
+        *outRemovedValue = std::move(m_values.typedData()[index]);
+
+    m_keys.eraseUnordered(index);
+    m_values.eraseUnordered(index);
+    return true;
+}
+
+template< class K, class V >
+template< typename FK >
+ALWAYS_INLINE V* FlatHashMap<K, V>::find(const FK& key)
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+        return m_values.typedData() + m_slots[slot];
+
+    return nullptr;
+}
+
+template< class K, class V >
+template< typename FK >
+ALWAYS_INLINE const V* FlatHashMap<K, V>::find(const FK& key) const
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+        return m_values.typedData() + m_slots[slot];
+
+    return nullptr;
+}
+
+template< class K, class V >
+template< typename FK >
+INLINE bool FlatHashMap<K, V>::find(const FK& key, V& output) const
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+    {
+        output = m_values.typedData()[m_slots[slot]];
+        return true;
+    }
+
+    return false;
+}
+
+template< class K, class V >
+template< typename FK >
+INLINE const V& FlatHashMap<K, V>::findSafe(const FK& key, const V& defaultValue) const
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+        return m_values.typedData()[m_slots[slot]];
+    else
+        return defaultValue;
+}
+
+template< class K, class V >
+template< typename FK >
+ALWAYS_INLINE bool FlatHashMap<K, V>::contains(const FK& key) const
+{
+    return findSlot(key) != INDEX_MAX;
+}
+
+template< class K, class V >
+void FlatHashMap<K, V>::append(const FlatHashMap<K, V>& other)
+{
+    for (auto p : other.pairs())
+        set(p.key, p.value);
+}
+
+template< class K, class V >
+INLINE V& FlatHashMap<K, V>::operator[](const K& key)
+{
+    const auto slot = findSlot(key);
+    if (slot != INDEX_MAX)
+        return m_values[m_slots[slot]];
+
+    return *add(key, V());
+}
+
+template< class K, class V >
+INLINE const V& FlatHashMap<K, V>::operator[](const K& key) const
+{
+    auto ptr = find(key);
+    ASSERT_EX(ptr, "Element not found in map even though it was strongly expected");
+    return *ptr;
+}
+
+//--
+
+template< class K, class V >
+ALWAYS_INLINE Array<V>& FlatHashMap<K, V>::values()
+{
+    return m_values;
+}
+
+template< class K, class V >
+ALWAYS_INLINE const Array<V>& FlatHashMap<K, V>::values() const
+{
+    return m_values;
+}
+
+template< class K, class V >
+ALWAYS_INLINE const Array<K>& FlatHashMap<K, V>::keys() const
+{
+    return m_keys;
+}
+
+template< class K, class V >
+ALWAYS_INLINE const PairContainer<K, V> FlatHashMap<K, V>::pairs() const
+{
+    return PairContainer<K, V>(m_keys.typedData(), m_values.typedData(), size());
+}
+
+template< class K, class V >
+ALWAYS_INLINE PairContainer<K, V> FlatHashMap<K, V>::pairs()
+{
+    return PairContainer<K, V>(m_keys.typedData(), m_values.typedData(), size());
+}
+
+//--
+
+template< class K, class V >
+ALWAYS_INLINE typename FlatHashMap<K, V>::HashParts FlatHashMap<K, V>::SplitHash(uint32_t hash)
+{
+    // hashes of simple types are usually the value itself, mix it so both parts are usable
+    const auto mixed = (uint64_t)hash * 0x9E3779B97F4A7C15ULL;
+
+    HashParts ret;
+    ret.position = (uint32_t)(mixed >> 25);
+    ret.tag = (int8_t)(mixed >> 57); // 7 bits, never negative so it does not collide with the markers
+    return ret;
+}
+
+template< class K, class V >
+ALWAYS_INLINE uint32_t FlatHashMap<K, V>::MatchGroup(const int8_t* ctrl, int8_t tag)
+{
+#if defined(PLATFORM_SSE2)
+    const auto group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_SIZE; ++i)
+        mask |= (ctrl[i] == tag) ? (1U << i) : 0;
+    return mask;
+#endif
+}
+
+template< class K, class V >
+ALWAYS_INLINE uint32_t FlatHashMap<K, V>::FirstMatch(uint32_t matches)
+{
+#if defined(PLATFORM_MSVC)
+    unsigned long index = 0;
+    _BitScanForward(&index, matches);
+    return index;
+#else
+    return __builtin_ctz(matches);
+#endif
+}
+
+template< class K, class V >
+ALWAYS_INLINE uint32_t FlatHashMap<K, V>::MatchEmpty(const int8_t* ctrl)
+{
+    return MatchGroup(ctrl, CTRL_EMPTY);
+}
+
+template< class K, class V >
+ALWAYS_INLINE uint32_t FlatHashMap<K, V>::MatchEmptyOrDeleted(const int8_t* ctrl)
+{
+#if defined(PLATFORM_SSE2)
+    // both markers are < -1, tags are never negative
+    const auto group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_SIZE; ++i)
+        mask |= (ctrl[i] < -1) ? (1U << i) : 0;
+    return mask;
+#endif
+}
+
+template< class K, class V >
+template< typename FK >
+ALWAYS_INLINE uint32_t FlatHashMap<K, V>::findSlot(const FK& key) const
+{
+    if (!m_capacity)
+        return INDEX_MAX;
+
+    const auto parts = SplitHash(Hasher<K>::CalcHash(key));
+    const auto mask = m_capacity - 1;
+    const auto* keys = m_keys.typedData();
+
+    // triangular probing over groups visits every group once when capacity is pow2
+    auto pos = parts.position & mask;
+    for (uint32_t step = GROUP_SIZE; ; step += GROUP_SIZE)
+    {
+        auto matches = MatchGroup(m_ctrl + pos, parts.tag);
+        while (matches)
+        {
+            const auto slot = (pos + FirstMatch(matches)) & mask;
+            if (keys[m_slots[slot]] == key)
+                return slot;
+
+            matches &= matches - 1;
+        }
+
+        // key would have been placed in the first empty slot
+        if (MatchEmpty(m_ctrl + pos))
+            return INDEX_MAX;
+
+        pos = (pos + step) & mask;
+    }
+}
+
+template< class K, class V >
+uint32_t FlatHashMap<K, V>::findSlotForIndex(const K& key, uint32_t index) const
+{
+    const auto parts = SplitHash(Hasher<K>::CalcHash(key));
+    const auto mask = m_capacity - 1;
+
+    auto pos = parts.position & mask;
+    for (uint32_t step = GROUP_SIZE; ; step += GROUP_SIZE)
+    {
+        auto matches = MatchGroup(m_ctrl + pos, parts.tag);
+        while (matches)
+        {
+            const auto slot = (pos + FirstMatch(matches)) & mask;
+            if (m_slots[slot] == index)
+                return slot;
+
+            matches &= matches - 1;
+        }
+
+        ASSERT_EX(!MatchEmpty(m_ctrl + pos), "Element not found in hash table");
+        pos = (pos + step) & mask;
+    }
+}
+
+template< class K, class V >
+uint32_t FlatHashMap<K, V>::findFreeSlot(uint32_t hash) const
+{
+    const auto mask = m_capacity - 1;
+
+    auto pos = SplitHash(hash).position & mask;
+    for (uint32_t step = GROUP_SIZE; ; step += GROUP_SIZE)
+    {
+        if (const auto matches = MatchEmptyOrDeleted(m_ctrl + pos))
+            return (pos + FirstMatch(matches)) & mask;
+
+        pos = (pos + step) & mask;
+    }
+}
+
+template< class K, class V >
+ALWAYS_INLINE void FlatHashMap<K, V>::setCtrl(uint32_t slot, int8_t value)
+{
+    m_ctrl[slot] = value;
+
+    // keep the clone of the first group in sync
+    if (slot < GROUP_SIZE - 1)
+        m_ctrl[m_capacity + slot] = value;
+}
+
+template< class K, class V >
+void FlatHashMap<K, V>::rehash(uint32_t newCapacity)
+{
+    ASSERT_EX(newCapacity >= MIN_CAPACITY && (newCapacity & (newCapacity - 1)) == 0, "Invalid capacity");
+
+    releaseTable();
+
+    // control bytes first, they are probed the most, slot indices after them
+    const auto ctrlSize = (uint64_t)newCapacity + GROUP_SIZE;
+    const auto memorySize = ctrlSize + (uint64_t)newCapacity * sizeof(uint32_t);
+    auto* memory = GlobalPool<POOL_HASH_BUCKETS, uint8_t>::Alloc(memorySize, 16);
+
+    m_ctrl = (int8_t*)memory;
+    m_slots = (uint32_t*)(memory + ctrlSize);
+    m_capacity = newCapacity;
+    m_numDeleted = 0;
+    memset(m_ctrl, (uint8_t)CTRL_EMPTY, ctrlSize);
+
+    const auto* keys = m_keys.typedData();
+    for (uint32_t i = 0; i < m_keys.size(); ++i)
+    {
+        const auto hash = Hasher<K>::CalcHash(keys[i]);
+        const auto slot = findFreeSlot(hash);
+        setCtrl(slot, SplitHash(hash).tag);
+        m_slots[slot] = i;
+    }
+}
+
+template< class K, class V >
+void FlatHashMap<K, V>::releaseTable()
+{
+    if (m_ctrl)
+    {
+        GlobalPool<POOL_HASH_BUCKETS, uint8_t>::Free(m_ctrl);
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_numDeleted = 0;
+    }
+}
+
+template< class K, class V >
+V* FlatHashMap<K, V>::add(const K& key, const V& val)
+{
+    // grow when the table gets 7/8 full (including the tombstones), after growing it's at most 7/16 full
+    const auto requiredCount = m_keys.size() + 1;
+    if ((uint64_t)(requiredCount + m_numDeleted) * 8 > (uint64_t)m_capacity * 7)
+    {
+        uint32_t newCapacity = MIN_CAPACITY;
+        while ((uint64_t)requiredCount * 16 > (uint64_t)newCapacity * 7)
+            newCapacity *= 2;
+
+        // if it's mostly tombstones we just rebuild the table in place
+        rehash(std::max<uint32_t>(newCapacity, m_capacity));
+    }
+
+    const auto hash = Hasher<K>::CalcHash(key);
+    const auto slot = findFreeSlot(hash);
+    if (m_ctrl[slot] == CTRL_DELETED)
+        m_numDeleted -= 1;
+
+    setCtrl(slot, SplitHash(hash).tag);
+    m_slots[slot] = m_keys.size();
+
+    m_keys.emplaceBack(key);
+    m_values.emplaceBack(val);
+    return &m_values.back();
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
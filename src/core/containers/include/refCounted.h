@@ -25,19 +25,19 @@ public:
 
     void drop(); // invalidates all references EVEN if the object has a non-zero reference count (i.e. "you are dead to me")
 
-    IReferencable* lock(); // returns a valid referencable with +1 reference count or NULL
+    IReferencable* lock(); // returns a valid referencable with +1 reference count or NULL, does not take any lock
 
-    INLINE IReferencable* unsafe() const { return m_ptr; }
+    INLINE IReferencable* unsafe() const { return m_ptr.load(std::memory_order_relaxed); }
 
-    INLINE bool expired() const { return m_ptr == nullptr; }
+    INLINE bool expired() const { return m_ptr.load(std::memory_order_relaxed) == nullptr; }
 
 private:
     ~RefWeakContainer();
 
     std::atomic<uint32_t> m_refCount = 1;
-    IReferencable* m_ptr; // unreferenced
+    std::atomic<IReferencable*> m_ptr; // unreferenced
 
-    SpinLock m_lock;
+    std::atomic<uint32_t> m_numLockers = 0; // threads that are inside lock(), drop() waits for them so the object is not deleted under them
 };
 
 //---
@@ -62,6 +62,9 @@ public:
     // release a reference, when count reaches zero the dispose() function will be called
     void releaseRef();
 
+    // add a reference only if the object is still alive (reference count is not zero), used to upgrade weak references
+    bool tryAddRef();
+
     //--
 
     // lock a weak reference
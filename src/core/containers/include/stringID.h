@@ -75,6 +75,18 @@ public:
 
     //---
 
+    //! save all names known so far into a binary snapshot, used at cook time to capture the names used by the game
+    static Buffer SaveSnapshot();
+
+    //! pre-populate the name table with names from a snapshot (usually memory mapped at startup), returns number of added names
+    //! NOTE: names that are already known are skipped, loading a snapshot does not change the indices of existing names
+    static uint32_t LoadSnapshot(const void* data, uint64_t size);
+
+    //---
+
+    //! version of the hash function, bump when StringView::CalcHash changes, hashes stored in older name snapshots are not used
+    static const uint32_t HASH_VERSION = 1;
+
     INLINE static uint32_t CalcHash(StringID id);
     INLINE static uint32_t CalcHash(StringView txt);
     INLINE static uint32_t CalcHash(const char* txt);
@@ -17,43 +17,58 @@ namespace prv
 
 	///--
 
+	// append-only storage for the string data, strings are never moved within the table so the index is stable
+	// NOTE: placing is not thread safe, the global lock must be held
 	class StringIDDataStorage
 	{
 	public:
 		StringIDDataStorage();
 		~StringIDDataStorage();
 
+		INLINE uint32_t size() const { return m_stringTableWriteOffset; }
+
 		StringIDIndex place(StringView buf);
 
+		void reserve(uint32_t additionalSize);
+
 	private:
 		uint32_t m_stringTableSize = 0;
 		uint32_t m_stringTableWriteOffset = 0;
 
-		void resize();
+		void resize(uint32_t minSize);
 	};
 
 	///--
 
+	// concurrent open addressing map of string hashes to the string indices
+	// lookups are lock free, inserts must be done under the global lock
+	// NOTE: tables replaced by resize are kept alive until the map is destroyed so readers never see freed memory
 	class StringIDMap
 	{
 	public:
 		StringIDMap();
 		~StringIDMap();
 
-		StringIDIndex find(uint32_t stringHash, const char* stringData, uint32_t stringLength, uint32_t& outFreeBucket) const;
+		INLINE uint32_t size() const { return m_numEntries; }
 
-		void insertAfterFailedFind(uint32_t stringHash, StringIDIndex stringIndex, uint32_t freeBucket);
+		StringIDIndex find(uint32_t stringHash, const char* stringData, uint32_t stringLength) const;
 
-	private:
-		uint32_t m_numBuckets = 0;
-		uint32_t m_numEntries = 0;
-		uint32_t m_maxEntries = 0; // some % of the nubmer of buckets, roughly 70%
+		void insert(uint32_t stringHash, StringIDIndex stringIndex);
 
-		uint32_t* m_buckets = nullptr;
+		void reserve(uint32_t numEntries);
 
-		void resize();
+	private:
+		struct Table
+		{
+			uint32_t numBuckets = 0;
+			std::atomic<uint64_t>* buckets = nullptr; // (hash << 32) | string index, 0 for free bucket
+			Table* previous = nullptr;
+		};
+
+		std::atomic<Table*> m_table = nullptr;
+		uint32_t m_numEntries = 0;
 
-		void insertAfterResize(uint32_t stringHash, StringIDIndex stringIndex);
+		void resize(uint32_t minBuckets);
 	};
 
 	///--
@@ -61,4 +76,3 @@ namespace prv
 } // prv
 
 END_BOOMER_NAMESPACE()
-
@@ -0,0 +1,333 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: utils #]
+***/
+
+#include "build.h"
+#include "contentHash.h"
+
+#ifdef PLATFORM_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef PLATFORM_MSVC
+    #include <intrin.h>
+#endif
+
+// Implementation of the XXH3 64-bit hash, follows the reference implementation from xxHash 0.8
+// xxHash - Copyright (C) 2012-2021 Yann Collet, BSD 2-Clause License (https://github.com/Cyan4973/xxHash)
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    static const uint32_t PRIME32_1 = 0x9E3779B1U;
+    static const uint32_t PRIME32_2 = 0x85EBCA77U;
+    static const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+
+    static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    static const uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+    static const uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+    static const uint32_t SECRET_SIZE = 192;
+    static const uint32_t SECRET_SIZE_MIN = 136;
+    static const uint32_t STRIPE_LEN = 64;
+    static const uint32_t SECRET_CONSUME_RATE = 8;
+    static const uint32_t NUM_ACCS = STRIPE_LEN / sizeof(uint64_t);
+    static const uint32_t MIDSIZE_MAX = 240;
+
+    alignas(64) static const uint8_t Secret[SECRET_SIZE] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    //--
+
+    // NOTE: all supported platforms are little endian
+    static ALWAYS_INLINE uint32_t Read32(const uint8_t* ptr)
+    {
+        uint32_t ret;
+        memcpy(&ret, ptr, sizeof(ret));
+        return ret;
+    }
+
+    static ALWAYS_INLINE uint64_t Read64(const uint8_t* ptr)
+    {
+        uint64_t ret;
+        memcpy(&ret, ptr, sizeof(ret));
+        return ret;
+    }
+
+    static ALWAYS_INLINE uint32_t Swap32(uint32_t x)
+    {
+        return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) | ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+    }
+
+    static ALWAYS_INLINE uint64_t Swap64(uint64_t x)
+    {
+        return ((uint64_t)Swap32((uint32_t)x) << 32) | Swap32((uint32_t)(x >> 32));
+    }
+
+    static ALWAYS_INLINE uint64_t Rotl64(uint64_t x, uint32_t r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static ALWAYS_INLINE uint64_t Mul128Fold64(uint64_t a, uint64_t b)
+    {
+#if defined(PLATFORM_MSVC)
+        uint64_t high = 0;
+        const uint64_t low = _umul128(a, b, &high);
+        return low ^ high;
+#else
+        const auto product = (unsigned __int128)a * b;
+        return (uint64_t)product ^ (uint64_t)(product >> 64);
+#endif
+    }
+
+    static ALWAYS_INLINE uint64_t XXH64Avalanche(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static ALWAYS_INLINE uint64_t Avalanche(uint64_t h)
+    {
+        h ^= h >> 37;
+        h *= PRIME_MX1;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static ALWAYS_INLINE uint64_t Rrmxmx(uint64_t h, uint64_t len)
+    {
+        h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+        h *= PRIME_MX2;
+        h ^= (h >> 35) + len;
+        h *= PRIME_MX2;
+        return h ^ (h >> 28);
+    }
+
+    static ALWAYS_INLINE uint64_t Mix16B(const uint8_t* input, const uint8_t* secret)
+    {
+        return Mul128Fold64(Read64(input) ^ Read64(secret), Read64(input + 8) ^ Read64(secret + 8));
+    }
+
+    //--
+
+    static uint64_t HashLen0To16(const uint8_t* input, uint64_t len)
+    {
+        if (len > 8)
+        {
+            const auto lo = Read64(input) ^ (Read64(Secret + 24) ^ Read64(Secret + 32));
+            const auto hi = Read64(input + len - 8) ^ (Read64(Secret + 40) ^ Read64(Secret + 48));
+            return Avalanche(len + Swap64(lo) + hi + Mul128Fold64(lo, hi));
+        }
+        else if (len >= 4)
+        {
+            const auto input1 = Read32(input);
+            const auto input2 = Read32(input + len - 4);
+            const auto bitflip = Read64(Secret + 8) ^ Read64(Secret + 16);
+            const auto input64 = input2 + ((uint64_t)input1 << 32);
+            return Rrmxmx(input64 ^ bitflip, len);
+        }
+        else if (len)
+        {
+            const uint32_t c1 = input[0];
+            const uint32_t c2 = input[len >> 1];
+            const uint32_t c3 = input[len - 1];
+            const uint32_t combined = (c1 << 16) | (c2 << 24) | (c3 << 0) | ((uint32_t)len << 8);
+            const uint64_t bitflip = Read32(Secret) ^ Read32(Secret + 4);
+            return XXH64Avalanche((uint64_t)combined ^ bitflip);
+        }
+
+        return XXH64Avalanche(Read64(Secret + 56) ^ Read64(Secret + 64));
+    }
+
+    static uint64_t HashLen17To128(const uint8_t* input, uint64_t len)
+    {
+        uint64_t acc = len * PRIME64_1;
+
+        if (len > 32)
+        {
+            if (len > 64)
+            {
+                if (len > 96)
+                {
+                    acc += Mix16B(input + 48, Secret + 96);
+                    acc += Mix16B(input + len - 64, Secret + 112);
+                }
+
+                acc += Mix16B(input + 32, Secret + 64);
+                acc += Mix16B(input + len - 48, Secret + 80);
+            }
+
+            acc += Mix16B(input + 16, Secret + 32);
+            acc += Mix16B(input + len - 32, Secret + 48);
+        }
+
+        acc += Mix16B(input + 0, Secret + 0);
+        acc += Mix16B(input + len - 16, Secret + 16);
+        return Avalanche(acc);
+    }
+
+    static uint64_t HashLen129To240(const uint8_t* input, uint64_t len)
+    {
+        uint64_t acc = len * PRIME64_1;
+
+        for (uint32_t i = 0; i < 8; ++i)
+            acc += Mix16B(input + (16 * i), Secret + (16 * i));
+        acc = Avalanche(acc);
+
+        uint64_t accEnd = Mix16B(input + len - 16, Secret + SECRET_SIZE_MIN - 17);
+        const auto numRounds = (uint32_t)len / 16;
+        for (uint32_t i = 8; i < numRounds; ++i)
+            accEnd += Mix16B(input + (16 * i), Secret + (16 * (i - 8)) + 3);
+
+        return Avalanche(acc + accEnd);
+    }
+
+    //--
+
+#ifdef PLATFORM_SSE2
+    static ALWAYS_INLINE void Accumulate512(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+    {
+        auto* xacc = (__m128i*)acc;
+
+        for (uint32_t i = 0; i < STRIPE_LEN / sizeof(__m128i); ++i)
+        {
+            const auto dataVec = _mm_loadu_si128((const __m128i*)input + i);
+            const auto keyVec = _mm_loadu_si128((const __m128i*)secret + i);
+            const auto dataKey = _mm_xor_si128(dataVec, keyVec);
+            const auto dataKeyLo = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+            const auto product = _mm_mul_epu32(dataKey, dataKeyLo);
+            const auto dataSwap = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+            const auto sum = _mm_add_epi64(xacc[i], dataSwap);
+            xacc[i] = _mm_add_epi64(product, sum);
+        }
+    }
+
+    static ALWAYS_INLINE void ScrambleAcc(uint64_t* acc, const uint8_t* secret)
+    {
+        auto* xacc = (__m128i*)acc;
+        const auto prime32 = _mm_set1_epi32((int)PRIME32_1);
+
+        for (uint32_t i = 0; i < STRIPE_LEN / sizeof(__m128i); ++i)
+        {
+            const auto accVec = xacc[i];
+            const auto dataVec = _mm_xor_si128(accVec, _mm_srli_epi64(accVec, 47));
+            const auto keyVec = _mm_loadu_si128((const __m128i*)secret + i);
+            const auto dataKey = _mm_xor_si128(dataVec, keyVec);
+            const auto dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+            const auto productLo = _mm_mul_epu32(dataKey, prime32);
+            const auto productHi = _mm_mul_epu32(dataKeyHi, prime32);
+            xacc[i] = _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32));
+        }
+    }
+#else
+    static ALWAYS_INLINE void Accumulate512(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+    {
+        for (uint32_t i = 0; i < NUM_ACCS; ++i)
+        {
+            const auto dataVal = Read64(input + i * 8);
+            const auto dataKey = dataVal ^ Read64(secret + i * 8);
+            acc[i ^ 1] += dataVal; // swap adjacent lanes
+            acc[i] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+        }
+    }
+
+    static ALWAYS_INLINE void ScrambleAcc(uint64_t* acc, const uint8_t* secret)
+    {
+        for (uint32_t i = 0; i < NUM_ACCS; ++i)
+        {
+            auto acc64 = acc[i];
+            acc64 ^= acc64 >> 47;
+            acc64 ^= Read64(secret + i * 8);
+            acc64 *= PRIME32_1;
+            acc[i] = acc64;
+        }
+    }
+#endif
+
+    static ALWAYS_INLINE void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, uint64_t numStripes)
+    {
+        for (uint64_t i = 0; i < numStripes; ++i)
+            Accumulate512(acc, input + i * STRIPE_LEN, secret + i * SECRET_CONSUME_RATE);
+    }
+
+    static uint64_t HashLong(const uint8_t* input, uint64_t len)
+    {
+        alignas(16) uint64_t acc[NUM_ACCS] = { PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1 };
+
+        const uint64_t stripesPerBlock = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE;
+        const uint64_t blockLen = STRIPE_LEN * stripesPerBlock;
+        const uint64_t numBlocks = (len - 1) / blockLen;
+
+        for (uint64_t i = 0; i < numBlocks; ++i)
+        {
+            Accumulate(acc, input + i * blockLen, Secret, stripesPerBlock);
+            ScrambleAcc(acc, Secret + SECRET_SIZE - STRIPE_LEN);
+        }
+
+        // last partial block
+        const uint64_t numStripes = ((len - 1) - (blockLen * numBlocks)) / STRIPE_LEN;
+        Accumulate(acc, input + numBlocks * blockLen, Secret, numStripes);
+
+        // last stripe
+        Accumulate512(acc, input + len - STRIPE_LEN, Secret + SECRET_SIZE - STRIPE_LEN - 7);
+
+        // merge accumulators
+        uint64_t result = len * PRIME64_1;
+        for (uint32_t i = 0; i < 4; ++i)
+            result += Mul128Fold64(acc[2 * i] ^ Read64(Secret + 11 + 16 * i), acc[2 * i + 1] ^ Read64(Secret + 11 + 16 * i + 8));
+
+        return Avalanche(result);
+    }
+
+} // helper
+
+uint64_t ContentHash64(const void* data, uint64_t size)
+{
+    const auto* input = (const uint8_t*)data;
+
+    if (size <= 16)
+        return helper::HashLen0To16(input, size);
+    else if (size <= 128)
+        return helper::HashLen17To128(input, size);
+    else if (size <= helper::MIDSIZE_MAX)
+        return helper::HashLen129To240(input, size);
+    else
+        return helper::HashLong(input, size);
+}
+
+uint64_t ContentHashCombine(uint64_t hash, uint64_t chunkHash)
+{
+    const uint64_t values[2] = { hash, chunkHash };
+    return ContentHash64(values, sizeof(values));
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
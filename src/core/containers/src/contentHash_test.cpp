@@ -0,0 +1,160 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "contentHash.h"
+#include "crc.h"
+
+DECLARE_TEST_FILE(ContentHash);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    // same pattern as used to generate the reference values with xxHash 0.8
+    static void FillPattern(Array<uint8_t>& data, uint64_t size)
+    {
+        data.resize(size);
+        for (uint64_t i = 0; i < size; ++i)
+            data[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    static void FillRandom(Array<uint8_t>& data, uint64_t size)
+    {
+        srand(0);
+        data.resize(size);
+        for (auto& val : data)
+            val = (uint8_t)rand();
+    }
+
+} // helper
+
+TEST(ContentHash, KnownValueStrings)
+{
+    EXPECT_EQ(0x2d06800538d394c2ULL, ContentHash64("", 0));
+    EXPECT_EQ(0xe6c632b61e964e1fULL, ContentHash64("a", 1));
+    EXPECT_EQ(0x78af5f94892f3950ULL, ContentHash64("abc", 3));
+    EXPECT_EQ(0x673e3c493921a2d5ULL, ContentHash64("Hello World!", 12));
+    EXPECT_EQ(0xce7d19a5418fb365ULL, ContentHash64("The quick brown fox jumps over the lazy dog", 43));
+}
+
+TEST(ContentHash, KnownValueBlocks)
+{
+    Array<uint8_t> data;
+    helper::FillPattern(data, 1ULL << 20);
+
+    // each size goes through different code path
+    EXPECT_EQ(0x7e484c18d74895d0ULL, ContentHash64(data.typedData(), 16));
+    EXPECT_EQ(0x8c97158042fbf926ULL, ContentHash64(data.typedData(), 100));
+    EXPECT_EQ(0x12fdb864685f344dULL, ContentHash64(data.typedData(), 200));
+    EXPECT_EQ(0x989765d0ea7a5ecdULL, ContentHash64(data.typedData(), 1000));
+    EXPECT_EQ(0xa3c19f8174cde0bbULL, ContentHash64(data.typedData(), 4096));
+    EXPECT_EQ(0x269eb834f6c110a9ULL, ContentHash64(data.typedData(), 1ULL << 20));
+}
+
+TEST(ContentHash, UnalignedDataGivesSameResult)
+{
+    Array<uint8_t> data;
+    helper::FillRandom(data, 10000);
+
+    Array<uint8_t> copy;
+    copy.resize(data.size() + 16);
+
+    for (uint32_t size = 0; size < 2000; size += 7)
+    {
+        const auto expected = ContentHash64(data.typedData(), size);
+        for (uint32_t offset = 1; offset < 16; offset += 3)
+        {
+            memcpy(copy.typedData() + offset, data.typedData(), size);
+            EXPECT_EQ(expected, ContentHash64(copy.typedData() + offset, size));
+        }
+    }
+}
+
+TEST(ContentHash, SingleByteChangeIsDetected)
+{
+    Array<uint8_t> data;
+    helper::FillRandom(data, 100000);
+
+    const auto original = ContentHash64(data.typedData(), data.size());
+    for (uint32_t i = 0; i < data.size(); i += 997)
+    {
+        data[i] ^= 1;
+        EXPECT_NE(original, ContentHash64(data.typedData(), data.size()));
+        data[i] ^= 1;
+    }
+
+    EXPECT_EQ(original, ContentHash64(data.typedData(), data.size()));
+}
+
+TEST(ContentHash, CombineIsOrderDependent)
+{
+    const auto a = ContentHash64("first", 5);
+    const auto b = ContentHash64("second", 6);
+
+    EXPECT_EQ(ContentHashCombine(ContentHashCombine(0, a), b), ContentHashCombine(ContentHashCombine(0, a), b));
+    EXPECT_NE(ContentHashCombine(ContentHashCombine(0, a), b), ContentHashCombine(ContentHashCombine(0, b), a));
+    EXPECT_NE(ContentHashCombine(0, a), ContentHashCombine(1, a));
+}
+
+//--
+
+static const uint64_t HASH_PERF_BYTES_PER_TEST = 256ULL << 20;
+
+static void MeasureContentHashThroughput(uint64_t size)
+{
+    Array<uint8_t> data;
+    helper::FillRandom(data, size);
+
+    const auto numIterations = std::max<uint64_t>(2, HASH_PERF_BYTES_PER_TEST / size);
+
+    TimingStatistics statsHash, statsCRC;
+    uint64_t check = 0;
+    for (uint64_t i = 0; i < numIterations; ++i)
+    {
+        {
+            ScopeTimer timer;
+            check += ContentHash64(data.typedData(), size);
+            statsHash.update(timer.timeElapsed());
+        }
+
+        {
+            ScopeTimer timer;
+            check += CRC64().append(data.typedData(), size).crc();
+            statsCRC.update(timer.timeElapsed());
+        }
+    }
+
+    const auto throughputHash = (size / statsHash.mean()) / (double)(1ULL << 30);
+    const auto throughputCRC = (size / statsCRC.mean()) / (double)(1ULL << 30);
+    TRACE_WARNING("ContentHash {}: XXH3 {} GB/s, CRC64 {} GB/s ({})", MemSize(size), Prec(throughputHash, 2), Prec(throughputCRC, 2), check);
+}
+
+TEST(ContentHash, Perf_64B)
+{
+    MeasureContentHashThroughput(64);
+}
+
+TEST(ContentHash, Perf_4KB)
+{
+    MeasureContentHashThroughput(4ULL << 10);
+}
+
+TEST(ContentHash, Perf_1MB)
+{
+    MeasureContentHashThroughput(1ULL << 20);
+}
+
+TEST(ContentHash, Perf_256MB)
+{
+    MeasureContentHashThroughput(256ULL << 20);
+}
+
+END_BOOMER_NAMESPACE()
@@ -9,6 +9,17 @@
 #include "build.h"
 #include "crc.h"
 
+#if defined(PLATFORM_SSE2) && (defined(PLATFORM_MSVC) || defined(PLATFORM_GCC) || defined(PLATFORM_CLANG))
+    #define CRC_USE_CLMUL
+    #include <wmmintrin.h>
+    #ifdef PLATFORM_MSVC
+        #define CRC_TARGET_CLMUL
+    #else
+        #include <cpuid.h>
+        #define CRC_TARGET_CLMUL __attribute__((target("pclmul,sse2")))
+    #endif
+#endif
+
 BEGIN_BOOMER_NAMESPACE()
 
 ///----
@@ -215,14 +226,301 @@ const uint64_t CRC64::CRCTable[256] =
 
 //---
 
-CRC32& CRC32::append(const void* data, size_t size)
+// slicing tables, table N is the CRC of a byte followed by N zero bytes
+template< typename T, uint32_t N >
+struct CRCSlicingTables
 {
-    auto mem  = (const uint8_t*)data;
-    auto end  = mem + size;
-    auto crc = m_crc;
+    T slices[N][256];
+
+    CRCSlicingTables(const T* baseTable)
+    {
+        memcpy(slices[0], baseTable, sizeof(slices[0]));
+        for (uint32_t i = 0; i < 256; ++i)
+            for (uint32_t k = 1; k < N; ++k)
+                slices[k][i] = (slices[k - 1][i] >> 8) ^ baseTable[(uint8_t)slices[k - 1][i]];
+    }
+};
+
+#ifdef CRC_USE_CLMUL
+
+// x^k mod P in the reflected form expected by the carry-less multiply (bit i is the coefficient of x^(63-i))
+// NOTE: table[128] of a reflected CRC table is the reflected polynomial
+template< typename T >
+static uint64_t CRCPowerModPoly(const T* baseTable, uint32_t power)
+{
+    const T poly = baseTable[128];
+    T ret = (T)1 << (sizeof(T) * 8 - 1);
+    while (power--)
+        ret = (ret >> 1) ^ ((ret & 1) ? poly : 0);
+    return (uint64_t)ret << (64 - sizeof(T) * 8);
+}
+
+// constants for folding 128-bit lanes over 512 and 128 bits of data
+// NOTE: the product of two reflected 64-bit values comes out shifted down by one bit, hence the -1 in the powers
+struct CRCFoldingConstants
+{
+    __m128i fold512;
+    __m128i fold128;
+
+    template< typename T >
+    CRCFoldingConstants(const T* baseTable)
+    {
+        fold512 = _mm_set_epi64x(CRCPowerModPoly(baseTable, 512 - 1), CRCPowerModPoly(baseTable, 512 + 64 - 1));
+        fold128 = _mm_set_epi64x(CRCPowerModPoly(baseTable, 128 - 1), CRCPowerModPoly(baseTable, 128 + 64 - 1));
+    }
+};
+
+CRC_TARGET_CLMUL static INLINE __m128i CRCFold(__m128i lane, __m128i constants, __m128i data)
+{
+    const auto lo = _mm_clmulepi64_si128(lane, constants, 0x00);
+    const auto hi = _mm_clmulepi64_si128(lane, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), data);
+}
+
+// fold the data (at least 64 bytes, multiple of 16) into a single 128-bit value with the same CRC
+// the initial CRC is XORed into the first bytes so the result should be processed with a zero CRC
+CRC_TARGET_CLMUL static void CRCFoldBlocks(const CRCFoldingConstants& k, __m128i crc, const uint8_t* mem, uint64_t size, uint8_t* outRemainder)
+{
+    auto x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(mem + 0)), crc);
+    auto x2 = _mm_loadu_si128((const __m128i*)(mem + 16));
+    auto x3 = _mm_loadu_si128((const __m128i*)(mem + 32));
+    auto x4 = _mm_loadu_si128((const __m128i*)(mem + 48));
+    mem += 64;
+    size -= 64;
+
+    // four independent lanes to hide the latency of the multiply
+    while (size >= 64)
+    {
+        x1 = CRCFold(x1, k.fold512, _mm_loadu_si128((const __m128i*)(mem + 0)));
+        x2 = CRCFold(x2, k.fold512, _mm_loadu_si128((const __m128i*)(mem + 16)));
+        x3 = CRCFold(x3, k.fold512, _mm_loadu_si128((const __m128i*)(mem + 32)));
+        x4 = CRCFold(x4, k.fold512, _mm_loadu_si128((const __m128i*)(mem + 48)));
+        mem += 64;
+        size -= 64;
+    }
+
+    x1 = CRCFold(x1, k.fold128, x2);
+    x1 = CRCFold(x1, k.fold128, x3);
+    x1 = CRCFold(x1, k.fold128, x4);
+
+    while (size >= 16)
+    {
+        x1 = CRCFold(x1, k.fold128, _mm_loadu_si128((const __m128i*)mem));
+        mem += 16;
+        size -= 16;
+    }
+
+    _mm_storeu_si128((__m128i*)outRemainder, x1);
+}
+
+static bool CRCHasCarrylessMultiply()
+{
+#ifdef PLATFORM_MSVC
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 1)) != 0;
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & bit_PCLMUL) != 0;
+#endif
+}
+
+#endif
+
+//---
+
+// NOTE: created on first use, CRCs are calculated during static initialization
+struct CRCAccelerationTables
+{
+    CRCSlicingTables<uint32_t, 16> crc32;
+    CRCSlicingTables<uint64_t, 8> crc64;
+
+#ifdef CRC_USE_CLMUL
+    CRCFoldingConstants crc32Folding;
+    CRCFoldingConstants crc64Folding;
+#endif
+
+    CRCAccelerationTables()
+        : crc32(CRC32::CRCTable)
+        , crc64(CRC64::CRCTable)
+#ifdef CRC_USE_CLMUL
+        , crc32Folding(CRC32::CRCTable)
+        , crc64Folding(CRC64::CRCTable)
+#endif
+    {}
+
+    static const CRCAccelerationTables& GetInstance()
+    {
+        static CRCAccelerationTables theInstance;
+        return theInstance;
+    }
+};
+
+static bool IsCRCImplementationSupported(CRCImplementation implementation)
+{
+    switch (implementation)
+    {
+        case CRCImplementation::Basic:
+        case CRCImplementation::Slicing:
+            return true;
+
+#ifdef CRC_USE_CLMUL
+        case CRCImplementation::CarrylessMultiply:
+            return CRCHasCarrylessMultiply();
+#endif
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+static CRCImplementation DetectCRCImplementation()
+{
+    if (IsCRCImplementationSupported(CRCImplementation::CarrylessMultiply))
+        return CRCImplementation::CarrylessMultiply;
+    return CRCImplementation::Slicing;
+}
+
+// NOTE: zero initialized to the Basic implementation before the static initialization gets here
+static CRCImplementation GCRCImplementation = DetectCRCImplementation();
+
+//---
+
+static INLINE uint32_t CRC32Basic(uint32_t crc, const uint8_t* mem, uint64_t size)
+{
+    const auto* end = mem + size;
     while (mem < end)
-        crc = (crc >> 8) ^ CRCTable[*mem++ ^ (crc & 0x000000FF)];
-    m_crc = crc;
+        crc = (crc >> 8) ^ CRC32::CRCTable[*mem++ ^ (crc & 0x000000FF)];
+    return crc;
+}
+
+static uint32_t CRC32Slicing(uint32_t crc, const uint8_t* mem, uint64_t size)
+{
+    const auto& t = CRCAccelerationTables::GetInstance().crc32.slices;
+    while (size >= 16)
+    {
+        uint32_t a, b, c, d;
+        memcpy(&a, mem + 0, 4);
+        memcpy(&b, mem + 4, 4);
+        memcpy(&c, mem + 8, 4);
+        memcpy(&d, mem + 12, 4);
+        a ^= crc;
+
+        crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24]
+            ^ t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[9][(b >> 16) & 0xFF] ^ t[8][b >> 24]
+            ^ t[7][c & 0xFF] ^ t[6][(c >> 8) & 0xFF] ^ t[5][(c >> 16) & 0xFF] ^ t[4][c >> 24]
+            ^ t[3][d & 0xFF] ^ t[2][(d >> 8) & 0xFF] ^ t[1][(d >> 16) & 0xFF] ^ t[0][d >> 24];
+
+        mem += 16;
+        size -= 16;
+    }
+
+    return CRC32Basic(crc, mem, size);
+}
+
+static INLINE uint64_t CRC64Basic(uint64_t crc, const uint8_t* mem, uint64_t size)
+{
+    const auto* end = mem + size;
+    while (mem < end)
+        crc = (crc >> 8) ^ CRC64::CRCTable[*mem++ ^ (uint8_t)crc];
+    return crc;
+}
+
+static uint64_t CRC64Slicing(uint64_t crc, const uint8_t* mem, uint64_t size)
+{
+    const auto& t = CRCAccelerationTables::GetInstance().crc64.slices;
+    while (size >= 8)
+    {
+        uint64_t a;
+        memcpy(&a, mem, 8);
+        a ^= crc;
+
+        crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][(a >> 24) & 0xFF]
+            ^ t[3][(a >> 32) & 0xFF] ^ t[2][(a >> 40) & 0xFF] ^ t[1][(a >> 48) & 0xFF] ^ t[0][a >> 56];
+
+        mem += 8;
+        size -= 8;
+    }
+
+    return CRC64Basic(crc, mem, size);
+}
+
+#ifdef CRC_USE_CLMUL
+
+static uint32_t CRC32CarrylessMultiply(uint32_t crc, const uint8_t* mem, uint64_t size)
+{
+    if (size >= 64)
+    {
+        const auto blockSize = size & ~(uint64_t)15;
+
+        uint8_t remainder[16];
+        CRCFoldBlocks(CRCAccelerationTables::GetInstance().crc32Folding, _mm_cvtsi32_si128((int)crc), mem, blockSize, remainder);
+        crc = CRC32Slicing(0, remainder, sizeof(remainder));
+
+        mem += blockSize;
+        size -= blockSize;
+    }
+
+    return CRC32Slicing(crc, mem, size);
+}
+
+static uint64_t CRC64CarrylessMultiply(uint64_t crc, const uint8_t* mem, uint64_t size)
+{
+    if (size >= 64)
+    {
+        const auto blockSize = size & ~(uint64_t)15;
+
+        uint8_t remainder[16];
+        CRCFoldBlocks(CRCAccelerationTables::GetInstance().crc64Folding, _mm_set_epi64x(0, (int64_t)crc), mem, blockSize, remainder);
+        crc = CRC64Slicing(0, remainder, sizeof(remainder));
+
+        mem += blockSize;
+        size -= blockSize;
+    }
+
+    return CRC64Slicing(crc, mem, size);
+}
+
+#endif
+
+//---
+
+CRCImplementation CRCCurrentImplementation()
+{
+    return GCRCImplementation;
+}
+
+bool CRCSelectImplementation(CRCImplementation implementation)
+{
+    if (!IsCRCImplementationSupported(implementation))
+        return false;
+
+    GCRCImplementation = implementation;
+    return true;
+}
+
+//---
+
+CRC32& CRC32::append(const void* data, size_t size)
+{
+    const auto* mem = (const uint8_t*)data;
+
+    // small appends (single values, short strings) are not worth the setup
+    if (size < 16)
+        m_crc = CRC32Basic(m_crc, mem, size);
+#ifdef CRC_USE_CLMUL
+    else if (GCRCImplementation == CRCImplementation::CarrylessMultiply)
+        m_crc = CRC32CarrylessMultiply(m_crc, mem, size);
+#endif
+    else if (GCRCImplementation != CRCImplementation::Basic)
+        m_crc = CRC32Slicing(m_crc, mem, size);
+    else
+        m_crc = CRC32Basic(m_crc, mem, size);
+
     return *this;
 }
 
@@ -257,12 +555,19 @@ CRC32& CRC32::appendStatic8(uint64_t data)
 
 CRC64& CRC64::append(const void* data, size_t size)
 {
-    auto mem  = (const uint8_t*)data;
-    auto end  = mem + size;
-    auto crc = m_crc;
-    while (mem < end)
-        crc = (crc >> 8) ^ CRCTable[*mem++ ^ (uint8_t)crc];
-    m_crc = crc;
+    const auto* mem = (const uint8_t*)data;
+
+    if (size < 16)
+        m_crc = CRC64Basic(m_crc, mem, size);
+#ifdef CRC_USE_CLMUL
+    else if (GCRCImplementation == CRCImplementation::CarrylessMultiply)
+        m_crc = CRC64CarrylessMultiply(m_crc, mem, size);
+#endif
+    else if (GCRCImplementation != CRCImplementation::Basic)
+        m_crc = CRC64Slicing(m_crc, mem, size);
+    else
+        m_crc = CRC64Basic(m_crc, mem, size);
+
     return *this;
 }
 
@@ -0,0 +1,217 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "crc.h"
+
+DECLARE_TEST_FILE(CRC);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    static const CRCImplementation AllImplementations[] = { CRCImplementation::Basic, CRCImplementation::Slicing, CRCImplementation::CarrylessMultiply };
+
+    static const char* ImplementationName(CRCImplementation implementation)
+    {
+        switch (implementation)
+        {
+            case CRCImplementation::Basic: return "Basic";
+            case CRCImplementation::Slicing: return "Slicing";
+            case CRCImplementation::CarrylessMultiply: return "CarrylessMultiply";
+        }
+        return "Unknown";
+    }
+
+    // reference, byte at a time
+    static uint32_t ReferenceCRC32(const uint8_t* data, uint64_t size)
+    {
+        uint32_t crc = ~0U;
+        for (uint64_t i = 0; i < size; ++i)
+            crc = (crc >> 8) ^ CRC32::CRCTable[data[i] ^ (crc & 0xFF)];
+        return ~crc;
+    }
+
+    static uint64_t ReferenceCRC64(const uint8_t* data, uint64_t size)
+    {
+        uint64_t crc = 0xCBF29CE484222325;
+        for (uint64_t i = 0; i < size; ++i)
+            crc = (crc >> 8) ^ CRC64::CRCTable[data[i] ^ (uint8_t)crc];
+        return crc;
+    }
+
+    static void FillRandom(Array<uint8_t>& data, uint64_t size)
+    {
+        srand(0);
+        data.resize(size);
+        for (auto& val : data)
+            val = (uint8_t)rand();
+    }
+
+    // restores the default implementation
+    struct ImplementationScope
+    {
+        ImplementationScope()
+            : m_previous(CRCCurrentImplementation())
+        {}
+
+        ~ImplementationScope()
+        {
+            CRCSelectImplementation(m_previous);
+        }
+
+    private:
+        CRCImplementation m_previous;
+    };
+
+} // helper
+
+TEST(CRC, KnownValueCRC32)
+{
+    EXPECT_EQ(0xCBF43926, CRC32().append("123456789", 9).crc());
+    EXPECT_EQ(0U, CRC32().append("", 0).crc());
+}
+
+TEST(CRC, BasicAndSlicingAlwaysSupported)
+{
+    helper::ImplementationScope scope;
+    EXPECT_TRUE(CRCSelectImplementation(CRCImplementation::Basic));
+    EXPECT_EQ(CRCImplementation::Basic, CRCCurrentImplementation());
+    EXPECT_TRUE(CRCSelectImplementation(CRCImplementation::Slicing));
+    EXPECT_EQ(CRCImplementation::Slicing, CRCCurrentImplementation());
+}
+
+TEST(CRC, AllImplementationsMatchReference)
+{
+    helper::ImplementationScope scope;
+
+    Array<uint8_t> data;
+    helper::FillRandom(data, 70000);
+
+    for (const auto implementation : helper::AllImplementations)
+    {
+        if (!CRCSelectImplementation(implementation))
+            continue;
+
+        // all small sizes, odd alignments and some big ones
+        for (uint32_t size = 0; size < 600; ++size)
+        {
+            const auto* ptr = data.typedData() + (size % 17);
+            EXPECT_EQ(helper::ReferenceCRC32(ptr, size), CRC32().append(ptr, size).crc()) << helper::ImplementationName(implementation) << " size " << size;
+            EXPECT_EQ(helper::ReferenceCRC64(ptr, size), CRC64().append(ptr, size).crc()) << helper::ImplementationName(implementation) << " size " << size;
+        }
+
+        for (const uint32_t size : { 4095U, 4096U, 4097U, 65536U + 13U, 69000U })
+        {
+            const auto* ptr = data.typedData() + 3;
+            EXPECT_EQ(helper::ReferenceCRC32(ptr, size), CRC32().append(ptr, size).crc()) << helper::ImplementationName(implementation) << " size " << size;
+            EXPECT_EQ(helper::ReferenceCRC64(ptr, size), CRC64().append(ptr, size).crc()) << helper::ImplementationName(implementation) << " size " << size;
+        }
+    }
+}
+
+TEST(CRC, IncrementalMatchesSingleAppend)
+{
+    helper::ImplementationScope scope;
+
+    Array<uint8_t> data;
+    helper::FillRandom(data, 10000);
+
+    for (const auto implementation : helper::AllImplementations)
+    {
+        if (!CRCSelectImplementation(implementation))
+            continue;
+
+        CRC32 crc32;
+        CRC64 crc64;
+        uint32_t pos = 0;
+        uint32_t step = 1;
+        while (pos < data.size())
+        {
+            const auto size = std::min<uint32_t>(step, data.size() - pos);
+            crc32.append(data.typedData() + pos, size);
+            crc64.append(data.typedData() + pos, size);
+            pos += size;
+            step = (step * 3) + 1;
+        }
+
+        EXPECT_EQ(helper::ReferenceCRC32(data.typedData(), data.size()), crc32.crc()) << helper::ImplementationName(implementation);
+        EXPECT_EQ(helper::ReferenceCRC64(data.typedData(), data.size()), crc64.crc()) << helper::ImplementationName(implementation);
+    }
+}
+
+//--
+
+static const uint64_t CRC_PERF_BYTES_PER_TEST = 256ULL << 20;
+
+static void MeasureCRCThroughput(uint64_t size)
+{
+    helper::ImplementationScope scope;
+
+    Array<uint8_t> data;
+    helper::FillRandom(data, size);
+
+    const auto numIterations = std::max<uint64_t>(2, CRC_PERF_BYTES_PER_TEST / size);
+
+    for (const auto implementation : helper::AllImplementations)
+    {
+        if (!CRCSelectImplementation(implementation))
+            continue;
+
+        TimingStatistics stats32, stats64;
+        uint64_t check = 0;
+        for (uint64_t i = 0; i < numIterations; ++i)
+        {
+            {
+                ScopeTimer timer;
+                check += CRC32().append(data.typedData(), size).crc();
+                stats32.update(timer.timeElapsed());
+            }
+
+            {
+                ScopeTimer timer;
+                check += CRC64().append(data.typedData(), size).crc();
+                stats64.update(timer.timeElapsed());
+            }
+        }
+
+        const auto throughput32 = (size / stats32.mean()) / (double)(1ULL << 30);
+        const auto throughput64 = (size / stats64.mean()) / (double)(1ULL << 30);
+        TRACE_WARNING("CRC {} {}: CRC32 {} GB/s, CRC64 {} GB/s ({})", helper::ImplementationName(implementation), MemSize(size),
+            Prec(throughput32, 2), Prec(throughput64, 2), check);
+    }
+}
+
+TEST(CRC, Perf_4KB)
+{
+    MeasureCRCThroughput(4ULL << 10);
+}
+
+TEST(CRC, Perf_64KB)
+{
+    MeasureCRCThroughput(64ULL << 10);
+}
+
+TEST(CRC, Perf_1MB)
+{
+    MeasureCRCThroughput(1ULL << 20);
+}
+
+TEST(CRC, Perf_16MB)
+{
+    MeasureCRCThroughput(16ULL << 20);
+}
+
+TEST(CRC, Perf_256MB)
+{
+    MeasureCRCThroughput(256ULL << 20);
+}
+
+END_BOOMER_NAMESPACE()
@@ -0,0 +1,258 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "flatHashMap.h"
+#include "hashMap.h"
+
+DECLARE_TEST_FILE(FlatHashMap);
+
+BEGIN_BOOMER_NAMESPACE()
+
+typedef FlatHashMap<int, int> TestFlatIntMap;
+
+TEST(FlatHashMap, Empty)
+{
+    TestFlatIntMap x;
+    EXPECT_TRUE(x.empty());
+    EXPECT_EQ(0U, x.size());
+    EXPECT_FALSE(x.contains(5));
+    EXPECT_TRUE(x.find(5) == nullptr);
+}
+
+TEST(FlatHashMap, BuildLarge)
+{
+    TestFlatIntMap x;
+
+    for (int i = 0; i < 200000; ++i)
+        x.set(i, i * 2);
+
+    EXPECT_EQ(200000U, x.size());
+
+    for (int i = 0; i < 200000; ++i)
+        EXPECT_EQ(i * 2, x.findSafe(i, -1));
+
+    EXPECT_EQ(-1, x.findSafe(200000, -1));
+}
+
+TEST(FlatHashMap, IterationOrderIsInsertionOrder)
+{
+    TestFlatIntMap x;
+
+    for (int i = 1; i < 100; ++i)
+        x.set(i * 37, i);
+
+    int i = 1;
+    for (const auto& pair : x.pairs())
+    {
+        EXPECT_EQ(i * 37, pair.key);
+        EXPECT_EQ(i, pair.value);
+        i += 1;
+    }
+}
+
+TEST(FlatHashMap, Replace)
+{
+    TestFlatIntMap x;
+
+    for (int i = 1; i < 100; ++i)
+        x.set(i, i * i);
+
+    x.set(9, 666);
+    EXPECT_EQ(99U, x.size());
+    EXPECT_EQ(666, x.findSafe(9));
+
+    x[10] = 777;
+    EXPECT_EQ(99U, x.size());
+    EXPECT_EQ(777, x.findSafe(10));
+
+    x[1000] = 1;
+    EXPECT_EQ(100U, x.size());
+}
+
+TEST(FlatHashMap, RemoveMovesLastElement)
+{
+    TestFlatIntMap x;
+
+    for (int i = 0; i < 100; ++i)
+        x.set(i, i * i);
+
+    int removedValue = 0;
+    EXPECT_TRUE(x.remove(10, &removedValue));
+    EXPECT_EQ(100, removedValue);
+    EXPECT_FALSE(x.remove(10));
+
+    // same as in the HashMap last element takes the place of the removed one
+    EXPECT_EQ(99U, x.size());
+    EXPECT_EQ(99, x.keys()[10]);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i != 10)
+            EXPECT_EQ(i * i, x.findSafe(i, -1));
+    }
+}
+
+TEST(FlatHashMap, RemoveAndInsertMany)
+{
+    TestFlatIntMap x;
+    HashMap<int, int> reference;
+
+    // lots of tombstones, table must be cleaned up without growing forever
+    srand(0);
+    for (uint32_t i = 0; i < 300000; ++i)
+    {
+        const auto key = rand() % 5000;
+        if (rand() & 1)
+        {
+            x.set(key, i);
+            reference.set(key, i);
+        }
+        else
+        {
+            EXPECT_EQ(reference.remove(key), x.remove(key));
+        }
+    }
+
+    ASSERT_EQ(reference.size(), x.size());
+    for (const auto& pair : reference.pairs())
+        EXPECT_EQ(pair.value, x.findSafe(pair.key, -1));
+}
+
+TEST(FlatHashMap, CopyAndMove)
+{
+    TestFlatIntMap x;
+    for (int i = 0; i < 1000; ++i)
+        x.set(i, i + 1);
+
+    TestFlatIntMap copy(x);
+    EXPECT_EQ(1000U, copy.size());
+    EXPECT_EQ(501, copy.findSafe(500));
+
+    TestFlatIntMap moved(std::move(copy));
+    EXPECT_EQ(1000U, moved.size());
+    EXPECT_EQ(501, moved.findSafe(500));
+    EXPECT_TRUE(copy.empty());
+    EXPECT_FALSE(copy.contains(500));
+
+    copy = moved;
+    EXPECT_EQ(1000U, copy.size());
+    EXPECT_EQ(1000, copy.findSafe(999));
+}
+
+TEST(FlatHashMap, ResetKeepsWorking)
+{
+    TestFlatIntMap x;
+    for (int i = 0; i < 1000; ++i)
+        x.set(i, i);
+
+    x.reset();
+    EXPECT_TRUE(x.empty());
+    EXPECT_FALSE(x.contains(5));
+
+    x.set(5, 10);
+    EXPECT_EQ(10, x.findSafe(5));
+
+    x.clear();
+    EXPECT_TRUE(x.empty());
+    EXPECT_FALSE(x.contains(5));
+}
+
+TEST(FlatHashMap, StringKeys)
+{
+    FlatHashMap<StringBuf, int> x;
+    for (int i = 0; i < 1000; ++i)
+        x.set(TempString("Key{}", i), i);
+
+    EXPECT_EQ(500, x.findSafe(StringBuf("Key500"), -1));
+    EXPECT_EQ(-1, x.findSafe(StringBuf("Key1000"), -1));
+}
+
+//--
+
+namespace helper
+{
+    template< typename MapType >
+    static void MeasureMap(const char* name, uint32_t size)
+    {
+        // multiplying by an odd number is a bijection, keys are unique but scattered
+        // NOTE: keys are even so key+1 is never in the map
+        Array<uint32_t> keys;
+        keys.resize(size);
+        for (uint32_t i = 0; i < size; ++i)
+            keys[i] = ((i * 2654435761U) & 0x7FFFFFFF) << 1;
+
+        const auto numLookups = std::max<uint32_t>(size, 1000000);
+        const auto numRuns = std::max<uint32_t>(1, std::min<uint32_t>(20, 10000000 / size));
+
+        TimingStatistics buildStats, findStats, missStats;
+        uint64_t check = 0;
+        for (uint32_t run = 0; run < numRuns; ++run)
+        {
+            MapType map;
+
+            {
+                ScopeTimer timer;
+                for (uint32_t i = 0; i < size; ++i)
+                    map.set(keys[i], i);
+                buildStats.update(timer.timeElapsed() / size);
+            }
+
+            ASSERT_EQ(size, map.size());
+
+            {
+                ScopeTimer timer;
+                for (uint32_t i = 0; i < numLookups; ++i)
+                    if (const auto* value = map.find(keys[i % size]))
+                        check += *value;
+                findStats.update(timer.timeElapsed() / numLookups);
+            }
+
+            {
+                ScopeTimer timer;
+                for (uint32_t i = 0; i < numLookups; ++i)
+                    check += map.contains(keys[i % size] + 1);
+                missStats.update(timer.timeElapsed() / numLookups);
+            }
+        }
+
+        TRACE_WARNING("{} {}: insert {} ns, find {} ns, miss {} ns ({})", name, size,
+            Prec(buildStats.mean() * 1e9, 1), Prec(findStats.mean() * 1e9, 1), Prec(missStats.mean() * 1e9, 1), check);
+    }
+
+    static void CompareMaps(uint32_t size)
+    {
+        MeasureMap<HashMap<uint32_t, uint32_t>>("HashMap", size);
+        MeasureMap<FlatHashMap<uint32_t, uint32_t>>("FlatHashMap", size);
+    }
+
+} // helper
+
+TEST(FlatHashMap, Perf_Compare10)
+{
+    helper::CompareMaps(10);
+}
+
+TEST(FlatHashMap, Perf_Compare1K)
+{
+    helper::CompareMaps(1000);
+}
+
+TEST(FlatHashMap, Perf_Compare100K)
+{
+    helper::CompareMaps(100000);
+}
+
+TEST(FlatHashMap, Perf_Compare1M)
+{
+    helper::CompareMaps(1000000);
+}
+
+END_BOOMER_NAMESPACE()
@@ -11,6 +11,8 @@
 #include "refPtr.h"
 #include "refWeakPtr.h"
 
+#include "core/system/include/thread.h"
+
 #include <unordered_set>
 
 //#define TRACK_REF_PTR
@@ -47,22 +49,26 @@ void RefWeakContainer::releaseRef()
 
 void RefWeakContainer::drop()
 {
-    auto lock = CreateLock(m_lock);
-    m_ptr = nullptr;
+    m_ptr.store(nullptr);
+
+    // object is usually deleted right after it's dropped, wait for anybody that may still be touching it in lock()
+    // NOTE: any lock() that starts after this point will see the null pointer
+    while (m_numLockers.load() != 0)
+        Yield();
 }
 
 IReferencable* RefWeakContainer::lock()
 {
     IReferencable* ret = nullptr;
 
+    m_numLockers.fetch_add(1);
+    if (auto* ptr = m_ptr.load())
     {
-        auto lock = CreateLock(m_lock);
-        if (m_ptr)
-        {
-            m_ptr->addRef();
-            ret = m_ptr;
-        }
+        // object may be in the middle of the final release, do not resurrect it
+        if (ptr->tryAddRef())
+            ret = ptr;
     }
+    m_numLockers.fetch_sub(1);
 
     return ret;
 }
@@ -220,6 +226,18 @@ void IReferencable::addRef()
     ++m_refCount;
 }
 
+bool IReferencable::tryAddRef()
+{
+    auto refCount = m_refCount.load(std::memory_order_relaxed);
+    while (refCount != 0)
+    {
+        if (m_refCount.compare_exchange_weak(refCount, refCount + 1))
+            return true;
+    }
+
+    return false;
+}
+
 void IReferencable::releaseRef()
 {
     auto refCount = --m_refCount;
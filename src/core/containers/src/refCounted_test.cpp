@@ -0,0 +1,186 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/system/include/thread.h"
+
+#include "refCounted.h"
+#include "refPtr.h"
+#include "refWeakPtr.h"
+
+DECLARE_TEST_FILE(RefCounted);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace tests
+{
+    class RefCountedTest : public IReferencable
+    {
+    public:
+        RefCountedTest(std::atomic<uint32_t>* deleteCounter = nullptr)
+            : m_deleteCounter(deleteCounter)
+        {}
+
+        ~RefCountedTest()
+        {
+            if (m_deleteCounter)
+                *m_deleteCounter += 1;
+        }
+
+        uint32_t m_value = 42;
+
+    private:
+        std::atomic<uint32_t>* m_deleteCounter = nullptr;
+    };
+
+} // tests
+
+TEST(RefCounted, WeakPtrLocksLiveObject)
+{
+    auto obj = RefNew<tests::RefCountedTest>();
+    RefWeakPtr<tests::RefCountedTest> weak(obj.get());
+
+    auto locked = weak.lock();
+    EXPECT_EQ(obj.get(), locked.get());
+    EXPECT_FALSE(weak.expired());
+}
+
+TEST(RefCounted, WeakPtrDoesNotLockReleasedObject)
+{
+    std::atomic<uint32_t> numDeleted = 0;
+
+    auto obj = RefNew<tests::RefCountedTest>(&numDeleted);
+    RefWeakPtr<tests::RefCountedTest> weak(obj.get());
+    obj.reset();
+
+    EXPECT_EQ(1, numDeleted.load());
+    EXPECT_TRUE(weak.expired());
+    EXPECT_TRUE(weak.lock().empty());
+}
+
+TEST(RefCounted, LockedObjectIsKeptAlive)
+{
+    std::atomic<uint32_t> numDeleted = 0;
+
+    auto obj = RefNew<tests::RefCountedTest>(&numDeleted);
+    RefWeakPtr<tests::RefCountedTest> weak(obj.get());
+
+    auto locked = weak.lock();
+    obj.reset();
+    EXPECT_EQ(0, numDeleted.load());
+    EXPECT_FALSE(weak.expired());
+
+    locked.reset();
+    EXPECT_EQ(1, numDeleted.load());
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(RefCounted, LockRacingWithFinalRelease)
+{
+    static const uint32_t NUM_OBJECTS = 20000;
+    static const uint32_t NUM_LOCKERS = 4;
+
+    std::atomic<uint32_t> numDeleted = 0;
+    std::atomic<uint32_t> numErrors = 0;
+
+    for (uint32_t i = 0; i < NUM_OBJECTS; ++i)
+    {
+        auto obj = RefNew<tests::RefCountedTest>(&numDeleted);
+        RefWeakPtr<tests::RefCountedTest> weak(obj.get());
+
+        // lockers upgrade the weak pointer while the last strong reference goes away
+        Array<Thread> threads;
+        threads.resize(NUM_LOCKERS);
+        for (uint32_t j = 0; j < NUM_LOCKERS; ++j)
+        {
+            ThreadSetup setup;
+            setup.m_name = "RefCountedTest";
+            setup.m_function = [&weak, &numErrors]()
+            {
+                for (uint32_t k = 0; k < 16; ++k)
+                {
+                    // once we got the object it must be fully alive
+                    if (auto locked = weak.lock())
+                        if (locked->m_value != 42)
+                            numErrors += 1;
+                }
+            };
+            threads[j].init(setup);
+        }
+
+        obj.reset();
+
+        for (auto& thread : threads)
+            thread.close();
+
+        if (!weak.expired() || weak.lock())
+            numErrors += 1;
+    }
+
+    EXPECT_EQ(0, numErrors.load());
+    EXPECT_EQ(NUM_OBJECTS, numDeleted.load());
+}
+
+//--
+
+TEST(RefCounted, Perf_WeakLock)
+{
+    static const uint32_t NUM_LOCKS = 1000000; // per thread
+    static const uint32_t NUM_OBJECTS = 256;
+
+    Array<RefPtr<tests::RefCountedTest>> objects;
+    Array<RefWeakPtr<tests::RefCountedTest>> weakObjects;
+    for (uint32_t i = 0; i < NUM_OBJECTS; ++i)
+    {
+        objects.pushBack(RefNew<tests::RefCountedTest>());
+        weakObjects.pushBack(RefWeakPtr<tests::RefCountedTest>(objects.back().get()));
+    }
+
+    for (uint32_t numThreads = 1; numThreads <= 64; numThreads *= 2)
+    {
+        // all threads lock the same object (worst case) or each of them locks a different set of objects
+        for (uint32_t shared = 0; shared <= 1; ++shared)
+        {
+            std::atomic<uint64_t> check = 0;
+
+            ScopeTimer timer;
+            {
+                Array<Thread> threads;
+                threads.resize(numThreads);
+
+                for (uint32_t i = 0; i < numThreads; ++i)
+                {
+                    ThreadSetup setup;
+                    setup.m_name = "RefCountedPerf";
+                    setup.m_function = [i, shared, &weakObjects, &check]()
+                    {
+                        uint64_t localCheck = 0;
+                        for (uint32_t j = 0; j < NUM_LOCKS; ++j)
+                        {
+                            const auto index = shared ? 0 : ((i * 31 + j) % NUM_OBJECTS);
+                            if (auto locked = weakObjects[index].lock())
+                                localCheck += locked->m_value;
+                        }
+                        check += localCheck;
+                    };
+                    threads[i].init(setup);
+                }
+
+                for (auto& thread : threads)
+                    thread.close();
+            }
+
+            const auto timePerLock = timer.timeElapsed() / (NUM_LOCKS * (double)numThreads);
+            TRACE_WARNING("RefWeakPtr lock with {} threads ({}): {}, {} ns per lock ({})", numThreads, shared ? "same object" : "many objects", timer, Prec(timePerLock * 1e9, 1), check.load());
+        }
+    }
+}
+
+END_BOOMER_NAMESPACE()
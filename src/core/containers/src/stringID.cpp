@@ -11,6 +11,8 @@
 #include "stringID.h"
 #include "stringIDPrv.h"
 
+#include "core/memory/include/buffer.h"
+
 BEGIN_BOOMER_NAMESPACE()
 
 //---
@@ -18,9 +20,9 @@ BEGIN_BOOMER_NAMESPACE()
 struct StringIDGlobalState
 {
 	prv::StringIDDataStorage storage;
-
 	prv::StringIDMap globalMap;
-	SpinLock globalMapLock;
+
+	SpinLock insertLock; // only taken when new name is added, lookups are lock free
 
 	static StringIDGlobalState& GetInstance()
 	{
@@ -29,8 +31,6 @@ struct StringIDGlobalState
 	}
 };
 
-static TYPE_TLS prv::StringIDMap* GStringIDLocalMap = nullptr;
-
 static StringID GEmptyStringID;
 
 std::atomic<const char*> StringID::st_StringTable;
@@ -47,76 +47,149 @@ StringID StringID::Find(StringView txt)
 
 	const auto hash = CalcHash(txt);
 
-	// allocate local map on first use
-	if (!GStringIDLocalMap)
-		GStringIDLocalMap = new prv::StringIDMap();
+	auto& globalState = StringIDGlobalState::GetInstance();
+	return StringID(globalState.globalMap.find(hash, txt.data(), txt.length()));
+}
 
-	// find in local map
-	uint32_t freeLocalBucket = 0;
-	auto index = GStringIDLocalMap->find(hash, txt.data(), txt.length(), freeLocalBucket);
-	if (index)
-		return StringID(index);
+StringIDIndex StringID::Alloc(StringView txt)
+{
+	if (!txt)
+		return 0;
 
-	// get global state
+	const auto hash = CalcHash(txt);
+
+	// most of the names already exist, find them without locking
 	auto& globalState = StringIDGlobalState::GetInstance();
+	if (auto index = globalState.globalMap.find(hash, txt.data(), txt.length()))
+		return index;
 
-	// find in global map
-	{
-		auto lock = CreateLock(globalState.globalMapLock);
+	auto lock = CreateLock(globalState.insertLock);
 
-		uint32_t freeGlobalBucket = 0;
-		index = globalState.globalMap.find(hash, txt.data(), txt.length(), freeGlobalBucket);
+	// some other thread may have added the same name in the mean time
+	auto index = globalState.globalMap.find(hash, txt.data(), txt.length());
+	if (index == 0)
+	{
+		// place the string in the storage before publishing it in the map
+		index = globalState.storage.place(txt);
+		globalState.globalMap.insert(hash, index);
 	}
 
-	// if found in global map store in local as well
-	if (index)
-		GStringIDLocalMap->insertAfterFailedFind(hash, index, freeLocalBucket);
+	return index;
+}
+
+//---
+
+namespace prv
+{
+	struct StringIDSnapshotHeader
+	{
+		static const uint32_t MAGIC = 0x44494E53; // 'SNID'
+		static const uint32_t VERSION = 2;
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint32_t hashVersion = 0; // StringID::HASH_VERSION used to compute the stored hashes
+		uint32_t numNames = 0;
+		uint32_t dataSize = 0;
+	};
+} // prv
+
+Buffer StringID::SaveSnapshot()
+{
+	auto& globalState = StringIDGlobalState::GetInstance();
+	auto lock = CreateLock(globalState.insertLock);
+
+	// string table contains all names one after another, just skip the "NULL" element
+	const auto* stringTable = st_StringTable.load();
+	const auto dataSize = globalState.storage.size() - 1;
+	const auto numNames = globalState.globalMap.size();
+
+	prv::StringIDSnapshotHeader header;
+	header.magic = prv::StringIDSnapshotHeader::MAGIC;
+	header.version = prv::StringIDSnapshotHeader::VERSION;
+	header.hashVersion = HASH_VERSION;
+	header.numNames = numNames;
+	header.dataSize = dataSize;
+
+	const auto totalSize = sizeof(header) + (sizeof(uint32_t) * numNames) + dataSize;
+	auto ret = Buffer::Create(POOL_STRING_ID, totalSize);
+	if (!ret)
+		return nullptr;
+
+	auto* writePtr = ret.data();
+	memcpy(writePtr, &header, sizeof(header));
+	writePtr += sizeof(header);
+
+	// store hashes so loading does not have to compute them
+	auto* hashes = (uint32_t*)writePtr;
+	{
+		const auto* str = stringTable + 1;
+		const auto* strEnd = str + dataSize;
+		while (str < strEnd)
+		{
+			const auto length = (uint32_t)strlen(str);
+			*hashes++ = CalcHash(StringView(str, length));
+			str += length + 1;
+		}
+	}
 
-	return StringID(index);
+	memcpy(hashes, stringTable + 1, dataSize);
+	return ret;
 }
 
-StringIDIndex StringID::Alloc(StringView txt)
+uint32_t StringID::LoadSnapshot(const void* data, uint64_t size)
 {
-	if (!txt)
+	prv::StringIDSnapshotHeader header;
+	if (!data || size < sizeof(header))
 		return 0;
 
-	const auto hash = CalcHash(txt);
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != prv::StringIDSnapshotHeader::MAGIC || header.version != prv::StringIDSnapshotHeader::VERSION)
+		return 0;
 
-	// allocate local map on first use
-	if (!GStringIDLocalMap)
-		GStringIDLocalMap = new prv::StringIDMap();
+	const auto expectedSize = sizeof(header) + (sizeof(uint32_t) * (uint64_t)header.numNames) + header.dataSize;
+	if (size < expectedSize)
+		return 0;
 
-	// find in local map
-	uint32_t freeLocalBucket = 0;
-	auto index = GStringIDLocalMap->find(hash, txt.data(), txt.length(), freeLocalBucket);
-	if (index)
-		return index;
+	const auto* hashes = (const uint32_t*)((const uint8_t*)data + sizeof(header));
+	const auto* str = (const char*)(hashes + header.numNames);
+	const auto* strEnd = str + header.dataSize;
+
+	// snapshot must end with zero terminated string
+	if (header.dataSize && strEnd[-1] != 0)
+		return 0;
 
-	// get global state
 	auto& globalState = StringIDGlobalState::GetInstance();
+	auto lock = CreateLock(globalState.insertLock);
 
-	// find in global map
-	{
-		auto lock = CreateLock(globalState.globalMapLock);
+	// make space for everything up front
+	globalState.storage.reserve(header.dataSize);
+	globalState.globalMap.reserve(globalState.globalMap.size() + header.numNames);
 
-		uint32_t freeGlobalBucket = 0;
-		index = globalState.globalMap.find(hash, txt.data(), txt.length(), freeGlobalBucket);
+	// the stored hashes are only valid if the snapshot was created with the same hash function, otherwise we have to compute them
+	const bool useStoredHashes = (header.hashVersion == HASH_VERSION);
+	if (!useStoredHashes)
+		TRACE_WARNING("Name snapshot was created with different hash function ({} != {}), names will be rehashed", header.hashVersion, HASH_VERSION);
 
-		// allocate in global map
-		if (index == 0)
+	uint32_t numAdded = 0;
+	for (uint32_t i = 0; i < header.numNames && str < strEnd; ++i)
+	{
+		const auto length = (uint32_t)strlen(str);
+		if (length)
 		{
-			// place the string in the storage
-			index = globalState.storage.place(txt);
-
-			// store in global map
-			globalState.globalMap.insertAfterFailedFind(hash, index, freeGlobalBucket);
+			const auto hash = useStoredHashes ? hashes[i] : CalcHash(StringView(str, length));
+			if (!globalState.globalMap.find(hash, str, length))
+			{
+				const auto index = globalState.storage.place(StringView(str, length));
+				globalState.globalMap.insert(hash, index);
+				numAdded += 1;
+			}
 		}
-	}
 
-	// place in local map as well
-	GStringIDLocalMap->insertAfterFailedFind(hash, index, freeLocalBucket);
+		str += length + 1;
+	}
 
-	return index;
+	return numAdded;
 }
 
 END_BOOMER_NAMESPACE()
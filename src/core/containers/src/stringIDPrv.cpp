@@ -20,7 +20,7 @@ namespace prv
 
 	StringIDDataStorage::StringIDDataStorage()
 	{
-		resize();
+		resize(0);
 
 		// create the "NULL" element
 		m_stringTableWriteOffset = 1;
@@ -37,7 +37,7 @@ namespace prv
 	{
 		auto ret = m_stringTableWriteOffset;
 		if (m_stringTableWriteOffset + buf.length() + 1 >= m_stringTableSize)
-			resize();
+			resize(m_stringTableWriteOffset + buf.length() + 1);
 
 		auto* currentData = (char*)StringID::st_StringTable.load();
 		memcpy(currentData + ret, buf.data(), buf.length());
@@ -47,15 +47,24 @@ namespace prv
 		return ret;
 	}
 
-	void StringIDDataStorage::resize()
+	void StringIDDataStorage::reserve(uint32_t additionalSize)
+	{
+		if (m_stringTableWriteOffset + additionalSize >= m_stringTableSize)
+			resize(m_stringTableWriteOffset + additionalSize + 1);
+	}
+
+	void StringIDDataStorage::resize(uint32_t minSize)
 	{
 		static const uint32_t MIN_STORAGE_SIZE = 128 << 10; // 128 KB
 
 		// resize roughly 2x
-		const auto newSize = std::max<uint32_t>(MIN_STORAGE_SIZE, m_stringTableSize * 2);
+		auto newSize = std::max<uint32_t>(MIN_STORAGE_SIZE, m_stringTableSize * 2);
+		while (newSize < minSize)
+			newSize *= 2;
 		m_stringTableSize = newSize;
 
 		// resize buffer - do not reuse previous one - copy data first and than swap the pointer
+		// NOTE: previous buffer is not released as other threads may still be reading strings from it
 		auto* currentData = StringID::st_StringTable.load();
 		auto* newTable = (char*)AllocateBlock(POOL_STRING_ID, newSize, 1, "StringIDStrings");
 		memcpy(newTable, currentData, m_stringTableWriteOffset);
@@ -66,86 +75,112 @@ namespace prv
 
 	StringIDMap::StringIDMap()
 	{
-		resize();
+		resize(0);
 	}
 
 	StringIDMap::~StringIDMap()
 	{
-	}
-
-	void StringIDMap::insertAfterFailedFind(uint32_t stringHash, StringIDIndex stringIndex, uint32_t freeBucket)
-	{
-		if (m_numEntries < m_maxEntries)
-		{
-			ASSERT(m_buckets[freeBucket] == 0);
-			m_buckets[freeBucket] = stringIndex;
-		}
-		else
+		auto* table = m_table.exchange(nullptr);
+		while (table)
 		{
-			resize();
-			insertAfterResize(stringHash, stringIndex);
+			auto* previous = table->previous;
+			FreeBlock((void*)table->buckets);
+			delete table;
+			table = previous;
 		}
 	}
 
-	void StringIDMap::insertAfterResize(uint32_t stringHash, StringIDIndex stringIndex)
-	{
-		// find first free bucket starting at the initial one that depends on the string hash
-		auto bucketIndex = stringHash & (m_numBuckets - 1);
-		while (m_buckets[bucketIndex] != 0)
-			++bucketIndex;
-
-		// write the entry index there
-		m_buckets[bucketIndex] = stringIndex;
-	}
-			   
-	StringIDIndex StringIDMap::find(uint32_t stringHash, const char* stringData, uint32_t stringLength, uint32_t& outFreeBucket) const
+	StringIDIndex StringIDMap::find(uint32_t stringHash, const char* stringData, uint32_t stringLength) const
 	{
-		const auto* stringTable = StringID::st_StringTable.load();
+		const auto* table = m_table.load(std::memory_order_acquire);
+		const auto mask = table->numBuckets - 1;
 
 		// search the entry table starting from given entry
-		auto bucketIndex = stringHash & (m_numBuckets - 1);
-		while (m_buckets[bucketIndex] != 0)
+		auto bucketIndex = stringHash & mask;
+		while (true)
 		{
-			const auto bucketString = stringTable + m_buckets[bucketIndex];
-			if (0 == strncmp(stringData, bucketString, stringLength))
-				return m_buckets[bucketIndex];
+			const auto entry = table->buckets[bucketIndex].load(std::memory_order_acquire);
+			if (entry == 0)
+				return 0;
+
+			// compare the strings only if the hash matches
+			if ((uint32_t)(entry >> 32) == stringHash)
+			{
+				// NOTE: string table must be loaded after the bucket so the string is guaranteed to be there
+				const auto stringIndex = (StringIDIndex)(entry & 0xFFFFFFFF);
+				const auto* bucketString = StringID::st_StringTable.load(std::memory_order_acquire) + stringIndex;
+				// compare length first, the stored string may be shorter than the one we are looking for and we can't read past it
+				if (strnlen(bucketString, stringLength + 1) == stringLength && 0 == memcmp(stringData, bucketString, stringLength))
+					return stringIndex;
+			}
+
+			bucketIndex = (bucketIndex + 1) & mask;
+		}
+	}
 
-			++bucketIndex;
+	void StringIDMap::insert(uint32_t stringHash, StringIDIndex stringIndex)
+	{
+		// keep the occupancy below 50% so the probe sequences stay short
+		auto* table = m_table.load(std::memory_order_relaxed);
+		if ((m_numEntries + 1) * 2 > table->numBuckets)
+		{
+			resize(table->numBuckets * 2);
+			table = m_table.load(std::memory_order_relaxed);
 		}
 
-		// not found
-		outFreeBucket = bucketIndex;
-		return 0;
+		const auto mask = table->numBuckets - 1;
+		auto bucketIndex = stringHash & mask;
+		while (table->buckets[bucketIndex].load(std::memory_order_relaxed) != 0)
+			bucketIndex = (bucketIndex + 1) & mask;
+
+		// publish, string data was written before so readers that see the entry will also see the string
+		table->buckets[bucketIndex].store(((uint64_t)stringHash << 32) | stringIndex, std::memory_order_release);
+		m_numEntries += 1;
 	}
 
-	void StringIDMap::resize()
+	void StringIDMap::reserve(uint32_t numEntries)
+	{
+		auto* table = m_table.load(std::memory_order_relaxed);
+		if (numEntries * 2 > table->numBuckets)
+			resize(numEntries * 2);
+	}
+
+	void StringIDMap::resize(uint32_t minBuckets)
 	{
 		static const uint32_t MIN_SIZE = 65536;
 
-		// determine new size, roughly grow x2
-		auto oldBucketCount = m_numBuckets;
-		m_numBuckets = std::max<uint32_t>(MIN_SIZE, oldBucketCount * 2);
-		m_maxEntries = m_numBuckets / 4 * 3; // 75% occupancy
+		// determine new size, must be power of two
+		auto numBuckets = MIN_SIZE;
+		while (numBuckets < minBuckets)
+			numBuckets *= 2;
 
-		// allocate new bucket table
-		const auto* oldBuckets = m_buckets;
-		m_buckets = (uint32_t*)AllocateBlock(POOL_STRING_ID, sizeof(uint32_t) * m_numBuckets, 4, "StringIDBuckets");
-		memzero(m_buckets, sizeof(uint32_t) * m_numBuckets);
+		auto* newTable = new Table();
+		newTable->numBuckets = numBuckets;
+		newTable->buckets = (std::atomic<uint64_t>*)AllocateBlock(POOL_STRING_ID, sizeof(uint64_t) * numBuckets, 8, "StringIDBuckets");
+		memzero(newTable->buckets, sizeof(uint64_t) * numBuckets);
 
-		// using old bucket table initialize the new one
-		// NOTE: this is going to cost us roughly 80ms....
-		const auto* stringTable = StringID::st_StringTable.load();
-		for (uint32_t i = 0; i < oldBucketCount; ++i)
+		// move entries from the old table, the hash is stored in the entry so strings don't have to be hashed again
+		auto* oldTable = m_table.load(std::memory_order_relaxed);
+		if (oldTable)
 		{
-			const auto stringIndex = oldBuckets[i];
-			const auto* str = stringTable + stringIndex;
-
-			const auto strHash = StringView::CalcHash(str); // it's important to use the same hash
-			insertAfterResize(strHash, stringIndex); // there's guarantee of no duplicates
+			const auto mask = numBuckets - 1;
+			for (uint32_t i = 0; i < oldTable->numBuckets; ++i)
+			{
+				const auto entry = oldTable->buckets[i].load(std::memory_order_relaxed);
+				if (entry != 0)
+				{
+					auto bucketIndex = (uint32_t)(entry >> 32) & mask;
+					while (newTable->buckets[bucketIndex].load(std::memory_order_relaxed) != 0)
+						bucketIndex = (bucketIndex + 1) & mask;
+
+					newTable->buckets[bucketIndex].store(entry, std::memory_order_relaxed);
+				}
+			}
 		}
 
-		// now the original bucket table is not needed
-		FreeBlock((void*)oldBuckets);
+		// readers that still use the old table will just not see the new entries and fall back to the locked path
+		newTable->previous = oldTable;
+		m_table.store(newTable, std::memory_order_release);
 	}
 
 	///--
@@ -0,0 +1,266 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/system/include/thread.h"
+#include "core/memory/include/buffer.h"
+
+#include "stringID.h"
+
+DECLARE_TEST_FILE(StringID);
+
+BEGIN_BOOMER_NAMESPACE()
+
+TEST(StringID, EmptyName)
+{
+    StringID name;
+    EXPECT_TRUE(name.empty());
+    EXPECT_EQ(StringID::EMPTY(), name);
+    EXPECT_EQ(StringID::EMPTY(), StringID(""));
+    EXPECT_STREQ("", name.c_str());
+}
+
+TEST(StringID, SameTextGivesSameName)
+{
+    StringID a("TestStringID_Same");
+    StringID b(StringView("TestStringID_Same"));
+    EXPECT_EQ(a, b);
+    EXPECT_STREQ("TestStringID_Same", a.c_str());
+}
+
+TEST(StringID, PrefixIsDifferentName)
+{
+    StringID longName("TestStringID_PrefixLong");
+    StringID shortName("TestStringID_Prefix");
+    EXPECT_NE(longName, shortName);
+    EXPECT_STREQ("TestStringID_Prefix", shortName.c_str());
+    EXPECT_STREQ("TestStringID_PrefixLong", longName.c_str());
+}
+
+TEST(StringID, FindDoesNotAllocate)
+{
+    EXPECT_TRUE(StringID::Find("TestStringID_NeverAllocated").empty());
+
+    StringID name("TestStringID_Allocated");
+    EXPECT_EQ(name, StringID::Find("TestStringID_Allocated"));
+}
+
+TEST(StringID, ManyNamesSurviveResize)
+{
+    Array<StringID> names;
+    for (uint32_t i = 0; i < 100000; ++i)
+        names.pushBack(StringID(TempString("TestStringID_Many{}", i)));
+
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        ASSERT_EQ(names[i], StringID::Find(TempString("TestStringID_Many{}", i)));
+        ASSERT_EQ(names[i].view(), StringView(TempString("TestStringID_Many{}", i)));
+    }
+}
+
+TEST(StringID, ConcurrentAllocGivesSameNames)
+{
+    static const uint32_t NUM_THREADS = 8;
+    static const uint32_t NUM_NAMES = 20000;
+
+    Array<StringIDIndex> indices[NUM_THREADS];
+    Array<Thread> threads;
+    threads.resize(NUM_THREADS);
+
+    for (uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        indices[i].resizeWith(NUM_NAMES, 0);
+
+        ThreadSetup setup;
+        setup.m_name = "StringIDTest";
+        setup.m_function = [i, &indices]()
+        {
+            // each thread visits the names in different order
+            for (uint32_t j = 0; j < NUM_NAMES; ++j)
+            {
+                const auto nameIndex = (j * 7919 + i * 104729) % NUM_NAMES;
+                indices[i][nameIndex] = StringID(TempString("TestStringID_Concurrent{}", nameIndex)).index();
+            }
+        };
+        threads[i].init(setup);
+    }
+
+    for (auto& thread : threads)
+        thread.close();
+
+    for (uint32_t i = 1; i < NUM_THREADS; ++i)
+        for (uint32_t j = 0; j < NUM_NAMES; ++j)
+            ASSERT_EQ(indices[0][j], indices[i][j]);
+}
+
+TEST(StringID, SnapshotContainsExistingNames)
+{
+    StringID name("TestStringID_InSnapshot");
+
+    auto snapshot = StringID::SaveSnapshot();
+    ASSERT_TRUE(snapshot);
+
+    // all names in the snapshot are already known
+    EXPECT_EQ(0, StringID::LoadSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(name, StringID::Find("TestStringID_InSnapshot"));
+}
+
+TEST(StringID, InvalidSnapshotIsIgnored)
+{
+    auto snapshot = StringID::SaveSnapshot();
+    ASSERT_TRUE(snapshot);
+
+    EXPECT_EQ(0, StringID::LoadSnapshot(nullptr, 0));
+    EXPECT_EQ(0, StringID::LoadSnapshot(snapshot.data(), 8));
+    EXPECT_EQ(0, StringID::LoadSnapshot(snapshot.data(), snapshot.size() - 1));
+
+    snapshot.data()[0] ^= 0xFF;
+    EXPECT_EQ(0, StringID::LoadSnapshot(snapshot.data(), snapshot.size()));
+}
+
+namespace helper
+{
+    // header (magic, version, hash version, count, data size), hashes and the names
+    static void BuildSnapshot(uint32_t hashVersion, const char* names, uint32_t namesSize, const Array<uint32_t>& hashes, Array<uint32_t>& outData)
+    {
+        outData.pushBack(0x44494E53);
+        outData.pushBack(2);
+        outData.pushBack(hashVersion);
+        outData.pushBack(hashes.size());
+        outData.pushBack(namesSize);
+        for (auto hash : hashes)
+            outData.pushBack(hash);
+
+        const auto headerSize = outData.dataSize();
+        outData.resizeWith((headerSize + namesSize + 3) / 4, 0);
+        memcpy((uint8_t*)outData.data() + headerSize, names, namesSize);
+    }
+} // helper
+
+TEST(StringID, SnapshotWithSameHashVersionUsesStoredHashes)
+{
+    const char names[] = "TestStringID_SnapshotTrustedA\0TestStringID_SnapshotTrustedB";
+
+    Array<uint32_t> hashes;
+    hashes.pushBack(StringID::CalcHash("TestStringID_SnapshotTrustedA"));
+    hashes.pushBack(StringID::CalcHash("TestStringID_SnapshotTrustedB"));
+
+    Array<uint32_t> data;
+    helper::BuildSnapshot(StringID::HASH_VERSION, names, sizeof(names), hashes, data);
+
+    EXPECT_EQ(2, StringID::LoadSnapshot(data.data(), data.dataSize()));
+    EXPECT_STREQ("TestStringID_SnapshotTrustedA", StringID::Find("TestStringID_SnapshotTrustedA").c_str());
+    EXPECT_STREQ("TestStringID_SnapshotTrustedB", StringID::Find("TestStringID_SnapshotTrustedB").c_str());
+}
+
+TEST(StringID, SnapshotWithOtherHashVersionIsRehashed)
+{
+    const char names[] = "TestStringID_SnapshotOldA\0TestStringID_SnapshotOldB";
+
+    // hashes from different hash function
+    Array<uint32_t> hashes;
+    hashes.pushBack(StringID::CalcHash("TestStringID_SnapshotOldA") + 1);
+    hashes.pushBack(StringID::CalcHash("TestStringID_SnapshotOldB") + 1);
+
+    Array<uint32_t> data;
+    helper::BuildSnapshot(StringID::HASH_VERSION + 1, names, sizeof(names), hashes, data);
+
+    // names are still usable
+    EXPECT_EQ(2, StringID::LoadSnapshot(data.data(), data.dataSize()));
+    EXPECT_STREQ("TestStringID_SnapshotOldA", StringID::Find("TestStringID_SnapshotOldA").c_str());
+    EXPECT_STREQ("TestStringID_SnapshotOldB", StringID::Find("TestStringID_SnapshotOldB").c_str());
+    EXPECT_EQ(StringID::Find("TestStringID_SnapshotOldA"), StringID("TestStringID_SnapshotOldA"));
+}
+
+//--
+
+static const uint32_t STRINGID_PERF_NAMES = 50000;
+
+TEST(StringID, Perf_ConcurrentLookup)
+{
+    static const uint32_t NUM_LOOKUPS = 1000000; // per thread
+
+    for (uint32_t i = 0; i < STRINGID_PERF_NAMES; ++i)
+        StringID(TempString("TestStringID_Perf{}", i));
+
+    Array<StringBuf> texts;
+    for (uint32_t i = 0; i < STRINGID_PERF_NAMES; ++i)
+        texts.pushBack(StringBuf(TempString("TestStringID_Perf{}", i)));
+
+    for (uint32_t numThreads = 1; numThreads <= 32; numThreads *= 2)
+    {
+        std::atomic<uint64_t> check = 0;
+
+        ScopeTimer timer;
+        {
+            Array<Thread> threads;
+            threads.resize(numThreads);
+
+            for (uint32_t i = 0; i < numThreads; ++i)
+            {
+                ThreadSetup setup;
+                setup.m_name = "StringIDPerf";
+                setup.m_function = [i, &texts, &check]()
+                {
+                    uint64_t localCheck = 0;
+                    for (uint32_t j = 0; j < NUM_LOOKUPS; ++j)
+                        localCheck += StringID(texts[(j + i * 997) % texts.size()].view()).index();
+                    check += localCheck;
+                };
+                threads[i].init(setup);
+            }
+
+            for (auto& thread : threads)
+                thread.close();
+        }
+
+        const auto timePerLookup = timer.timeElapsed() / (NUM_LOOKUPS * (double)numThreads);
+        TRACE_WARNING("StringID lookup with {} threads: {}, {} ns per lookup ({})", numThreads, timer, Prec(timePerLookup * 1e9, 1), check.load());
+    }
+}
+
+TEST(StringID, Perf_StartupInsert)
+{
+    // simulate startup: many threads registering mostly unique names with some overlap
+    static const uint32_t NUM_THREADS = 16;
+
+    ScopeTimer timer;
+    {
+        Array<Thread> threads;
+        threads.resize(NUM_THREADS);
+
+        for (uint32_t i = 0; i < NUM_THREADS; ++i)
+        {
+            ThreadSetup setup;
+            setup.m_name = "StringIDPerf";
+            setup.m_function = [i]()
+            {
+                for (uint32_t j = 0; j < STRINGID_PERF_NAMES; ++j)
+                    StringID(TempString("TestStringID_Startup{}_{}", i / 2, j));
+            };
+            threads[i].init(setup);
+        }
+
+        for (auto& thread : threads)
+            thread.close();
+    }
+
+    TRACE_WARNING("StringID startup insert of {} names from {} threads: {}", STRINGID_PERF_NAMES * NUM_THREADS / 2, NUM_THREADS, timer);
+
+    // measure how long it takes to load a snapshot of everything we have (all names are known so this is the lookup cost)
+    auto snapshot = StringID::SaveSnapshot();
+    {
+        ScopeTimer loadTimer;
+        const auto numLoaded = StringID::LoadSnapshot(snapshot.data(), snapshot.size());
+        TRACE_WARNING("StringID snapshot of {} loaded in {} ({} new names)", MemSize(snapshot.size()), loadTimer, numLoaded);
+    }
+}
+
+END_BOOMER_NAMESPACE()
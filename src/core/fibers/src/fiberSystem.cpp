@@ -41,6 +41,7 @@ bool InitializeFibers(const IBaseCommandLine& commandline)
     auto fiberMode = commandline.singleValueAnsiStr("fiberMode");
 
     // use the platform specified scheduler
+    // NOTE: "-fiberMode=stealing" is handled by the platform scheduler itself (per-thread job queues with work stealing)
     if (0 == strcmp(fiberMode, "threads"))
         GFibers = new prv::ThreadBasedScheduler;
     else
@@ -31,6 +31,9 @@ namespace prv
     BaseScheduler::BaseScheduler()
     {
         GBaseScheduler = this;
+
+        m_wakeUpToken.job.name = "WakeUp";
+        m_wakeUpToken.isAllocated = true;
     }
 
     BaseScheduler::~BaseScheduler()
@@ -44,6 +47,12 @@ namespace prv
         ASSERT_EX(m_threads.empty(), "All threads should be closed");
     }
 
+    BaseScheduler::ThreadState::~ThreadState()
+    {
+        delete localJobs;
+        localJobs = nullptr;
+    }
+
     uint32_t BaseScheduler::determineWorkerThreadCount(const IBaseCommandLine& cmdLine)
     {
         // use all cores on the machine if possible, get the count
@@ -81,6 +90,11 @@ namespace prv
         m_pendingJobsQueue = IOrderedQueue::Create();
         m_mainThreadJobsQueue = IOrderedQueue::Create();
 
+        // work stealing mode - each thread has it's own queue for the jobs it spawns
+        m_workStealing = (0 == strcmp(cmdLine.singleValueAnsiStr("fiberMode"), "stealing"));
+        if (m_workStealing)
+            TRACE_INFO("Using work stealing fiber scheduler");
+
         // create the overflow functions
         m_fiberPool.refill = [this]()
         {
@@ -98,17 +112,22 @@ namespace prv
         // reserve space (since we don't want to realloc)
         m_threads.reserve(numThreads);
 
-        // create threads
+        // create thread states, all must exist before first thread starts since threads can steal work from each other
         for (uint32_t i = 0; i < numThreads; ++i)
         {
-            // create worker thread
             auto &state = m_threads.emplaceBack();
             state.index = range_cast<uint8_t>(m_threads.lastValidIndex());
             state.scheduler = this;
             sprintf(state.name, "FiberThread%u", i);
-            state.threadHandle = createWorkerThread(&state);
+
+            if (m_workStealing)
+                state.localJobs = new StealQueue();
         }
 
+        // create worker threads
+        for (auto& state : m_threads)
+            state.threadHandle = createWorkerThread(&state);
+
         // reserve space in the lists
         m_waitConterPool.init(MAX_JOBS * 4);
 
@@ -136,6 +155,18 @@ namespace prv
         if (!pendingJob->isMainThreadJob)
         {
             DEBUG_CHECK(pendingJob->sequenceNumber != 0);
+
+            // in the work stealing mode keep the jobs spawned on worker threads local
+            if (m_workStealing)
+            {
+                auto currentThread = currentThreadState();
+                if (currentThread && currentThread->localJobs && currentThread->localJobs->push(pendingJob))
+                {
+                    wakeUpIdleThread();
+                    return;
+                }
+            }
+
             m_pendingJobsQueue->push(pendingJob, pendingJob->sequenceNumber);
         }
         else
@@ -144,16 +175,118 @@ namespace prv
         }
     }
 
+    void BaseScheduler::wakeUpIdleThread()
+    {
+        // make sure the job we've just published is visible to anybody that is just about to go idle
+        // the idle threads will do one more pass over the queues after announcing it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // post wake up token only if there are not enough of them already posted
+        const auto numIdle = m_numIdleThreads.load();
+        if (numIdle > 0 && m_numPendingWakeUps.load() < numIdle)
+        {
+            ++m_numPendingWakeUps;
+            m_pendingJobsQueue->push(&m_wakeUpToken, 0);
+        }
+    }
+
+    void BaseScheduler::pushYieldedJob(ThreadState* thread, PendingJob* job)
+    {
+        ASSERT(job->next == nullptr);
+
+        if (thread->yieldedTail)
+            thread->yieldedTail->next = job;
+        else
+            thread->yieldedHead = job;
+        thread->yieldedTail = job;
+    }
+
+    BaseScheduler::PendingJob* BaseScheduler::popYieldedJob(ThreadState* thread)
+    {
+        auto* job = thread->yieldedHead;
+        if (job)
+        {
+            thread->yieldedHead = job->next;
+            if (!thread->yieldedHead)
+                thread->yieldedTail = nullptr;
+            job->next = nullptr;
+        }
+
+        return job;
+    }
+
+    BaseScheduler::PendingJob* BaseScheduler::findLocalOrStolenJob(ThreadState* thread)
+    {
+        // retry yielded jobs every few jobs so a constant stream of local work does not starve them
+        if (thread->yieldedHead && ++thread->numJobsSinceYieldedPoll >= YIELDED_POLL_INTERVAL)
+        {
+            thread->numJobsSinceYieldedPoll = 0;
+            return popYieldedJob(thread);
+        }
+
+        // recently spawned jobs first, they are most likely to have hot data
+        if (auto* job = thread->localJobs->pop())
+            return job;
+
+        // steal oldest jobs from other threads, start with the next one so we don't all hammer the first thread
+        const auto numThreads = m_threads.size();
+        for (uint32_t i = 1; i < numThreads; ++i)
+        {
+            auto& victim = m_threads[(thread->index + i) % numThreads];
+            if (auto* job = victim.localJobs->steal())
+                return job;
+        }
+
+        // nothing else to do, retry the yielded jobs before going idle
+        thread->numJobsSinceYieldedPoll = 0;
+        return popYieldedJob(thread);
+    }
+
+    BaseScheduler::PendingJob* BaseScheduler::fetchNextJob(ThreadState* thread)
+    {
+        if (thread->isMainThread)
+            return (PendingJob*)m_mainThreadJobsQueue->pop();
+
+        if (!m_workStealing)
+            return (PendingJob*)m_pendingJobsQueue->pop();
+
+        for (;;)
+        {
+            if (auto* job = findLocalOrStolenJob(thread))
+                return job;
+
+            // announce we are going idle and do one more pass, anybody pushing work after this point will post a wake up token
+            ++m_numIdleThreads;
+            if (auto* job = findLocalOrStolenJob(thread))
+            {
+                --m_numIdleThreads;
+                return job;
+            }
+
+            // wait for work on the shared queue, we will also get there the jobs scheduled from outside the worker threads
+            auto* job = (PendingJob*)m_pendingJobsQueue->pop();
+            --m_numIdleThreads;
+
+            if (job != &m_wakeUpToken)
+                return job; // NULL when exiting
+
+            --m_numPendingWakeUps;
+        }
+    }
+
     void BaseScheduler::scheduleInternal(const FiberJob& job, uint32_t numInvokations, bool child)
     {
         uint64_t fiberSequenceNumber = child ? currentJobSequenceId() : ++m_fiberSequenceNumber;
         if (fiberSequenceNumber == 0)
             fiberSequenceNumber = ++m_fiberSequenceNumber; // main thread is parent
 
+        // jobs are allocated from the thread's cache when possible
+        auto* currentThread = m_workStealing ? currentThreadState() : nullptr;
+
         m_numScheduledJobs += numInvokations;
         for (uint32_t i = 0; i < numInvokations; ++i)
         {
-            auto pendingJob  = m_pendingJobPool.alloc();
+            auto pendingJob  = currentThread ? m_pendingJobPool.alloc(currentThread->localCache) : m_pendingJobPool.alloc();
             ASSERT(pendingJob->fiber == nullptr);
             ASSERT(pendingJob->next == nullptr);
             ASSERT(pendingJob->isAllocated);
@@ -406,7 +539,7 @@ namespace prv
         }
     }
 
-    void BaseScheduler::cleanupPendingJob(PendingJob* job)
+    void BaseScheduler::cleanupPendingJob(ThreadState* thread, PendingJob* job)
     {
         ASSERT(job->fiber == nullptr);
         ASSERT(job->state.load() == PendingJobState::Finished);
@@ -424,7 +557,10 @@ namespace prv
         job->state = PendingJobState::Free;
 
         // release back
-        m_pendingJobPool.release(job);
+        if (m_workStealing)
+            m_pendingJobPool.release(thread->localCache, job);
+        else
+            m_pendingJobPool.release(job);
 
         // update global count of running jobs
         --m_numScheduledJobs;
@@ -544,7 +680,7 @@ namespace prv
             {
                 // wait for the pending list to become non-empty
                 // we periodically check the exit flag was not risen
-                auto job = (PendingJob *)(currentThread->isMainThread ? m_mainThreadJobsQueue->pop() : m_pendingJobsQueue->pop());
+                auto job = fetchNextJob(currentThread);
                 if (!job)
                 {
                     //TRACE_WARNING("Got NULL job on thread '{}', assuming we are exiting", currentThread->name);
@@ -556,7 +692,7 @@ namespace prv
                 if (job->fiber == nullptr)
                 {
                     ASSERT_EX(job->state.load() == PendingJobState::Scheduled, "Invalid state of popped job");
-                    job->fiber = m_fiberPool.allocFiber();
+                    job->fiber = m_workStealing ? m_fiberPool.allocFiber(currentThread->localCache) : m_fiberPool.allocFiber();
                     ASSERT(job->fiber != nullptr);
                     ASSERT(job->fiber->currentJob.load() == nullptr);
                     job->fiber->currentJob = job;
@@ -597,10 +733,13 @@ namespace prv
                 jobToRelease->fiber = nullptr;
 
                 // we've finished the top-level job, release it
-                cleanupPendingJob(jobToRelease);
+                cleanupPendingJob(currentThread, jobToRelease);
 
                 // free the fiber
-                m_fiberPool.releaseFiber(fiberToRelease);
+                if (m_workStealing)
+                    m_fiberPool.releaseFiber(currentThread->localCache, fiberToRelease);
+                else
+                    m_fiberPool.releaseFiber(fiberToRelease);
             }
 
             // reschedule another job
@@ -620,6 +759,11 @@ namespace prv
                         schedulePendingJob(jobToSchedule);
                     }
                 }
+                else if (m_workStealing && !jobToSchedule->isMainThreadJob)
+                {
+                    // we just yielded, put the job at the end of thread's yielded list so it does not get picked up again right away
+                    pushYieldedJob(currentThread, jobToSchedule);
+                }
                 else
                 {
                     // we just yielded
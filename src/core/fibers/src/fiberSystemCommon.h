@@ -57,6 +57,7 @@ namespace prv
         struct PendingJob;
         struct ThreadState;
         struct FiberState;
+        struct StealQueue;
 
         typedef void* ThreadHandle;
 
@@ -85,8 +86,23 @@ namespace prv
             std::atomic<bool> isRunning = false;
         };
 
+        /// per-thread cache of free jobs and fibers, used only by the owning thread (work stealing mode)
+        struct LocalCache
+        {
+            static const uint32_t MAX_CACHED_JOBS = 256; // half of that is returned to the global pool when exceeded
+            static const uint32_t MAX_CACHED_FIBERS = 16;
+
+            PendingJob* freeJobs = nullptr;
+            uint32_t numFreeJobs = 0;
+
+            FiberState* freeFibers = nullptr;
+            uint32_t numFreeFibers = 0;
+        };
+
         struct ThreadState
         {
+            ~ThreadState();
+
             BaseScheduler* scheduler = nullptr;
             FiberState idleFiber;
             ThreadHandle threadHandle;
@@ -99,6 +115,15 @@ namespace prv
             // commands as comming back from the fiber
             std::atomic<FiberState*> fiberToRelease = nullptr;
             std::atomic<PendingJob*> jobToReschedule = nullptr;
+
+            // work stealing mode only: jobs spawned on this thread + free list caches
+            StealQueue* localJobs = nullptr;
+            LocalCache localCache;
+
+            // work stealing mode only: jobs that yielded on this thread, retried in FIFO order
+            PendingJob* yieldedHead = nullptr;
+            PendingJob* yieldedTail = nullptr;
+            uint32_t numJobsSinceYieldedPoll = 0;
         };
 
         enum class PendingJobState
@@ -142,9 +167,16 @@ namespace prv
             PendingJob* alloc();
             void release(PendingJob* job);
 
+            // allocate/release via the thread's local cache, the global list is only touched in batches
+            PendingJob* alloc(LocalCache& cache);
+            void release(LocalCache& cache, PendingJob* job);
+
         private:
             Mutex lock;
 
+            void prepareJob(PendingJob* job);
+            void resetJob(PendingJob* job);
+
             PendingJob* freeList = nullptr;
             std::atomic<int> numAllocatedJobs = 0;
             std::atomic<int> numFreeJobs = 0;
@@ -157,17 +189,48 @@ namespace prv
             FiberState* activeFibers = nullptr;
             std::atomic<int> numUsedFibers = 0;
             std::atomic<int> numFreeFibers = 0;
+            std::atomic<int> numUsedLocalFibers = 0; // allocated via thread caches, not on the active list
             Mutex m_lock;
 
             typedef std::function<FiberState*()> TRefillFunction;
             TRefillFunction refill;
 
+            Array<FiberState*> allFibers; // all fibers ever created (for inspection)
+
             FiberState* allocFiber();
             void releaseFiber(FiberState* state);
+
+            // allocate/release via the thread's local cache, fibers served this way are not put on the active list
+            FiberState* allocFiber(LocalCache& cache);
+            void releaseFiber(LocalCache& cache, FiberState* state);
+
             void inspect(const std::function<void(const FiberState* state)>& inspector);
             void validate();
         };
 
+        /// Chase-Lev work stealing deque of fixed capacity
+        /// owner thread pushes and pops at the bottom (LIFO), other threads steal from the top (FIFO)
+        struct StealQueue : public NoCopy
+        {
+            static const uint32_t CAPACITY = 4096; // must be power of two
+            static const uint32_t MASK = CAPACITY - 1;
+
+            std::atomic<int64_t> top = 0;
+            std::atomic<int64_t> bottom = 0;
+            std::atomic<PendingJob*> entries[CAPACITY];
+
+            StealQueue();
+
+            // push job at the bottom of the queue, returns false if the queue is full, owner thread only
+            bool push(PendingJob* job);
+
+            // pop most recently pushed job, owner thread only
+            PendingJob* pop();
+
+            // steal oldest job from the queue, can be called from any thread
+            PendingJob* steal();
+        };
+
         struct WaitList : public NoCopy
         {
             FiberSemaphoreID localId = 0;
@@ -273,6 +336,13 @@ namespace prv
         IOrderedQueue* m_pendingJobsQueue;
         IOrderedQueue* m_mainThreadJobsQueue;
 
+        static const uint32_t YIELDED_POLL_INTERVAL = 16; // yielded jobs are retried at least every that many local jobs
+
+        bool m_workStealing = false; // "-fiberMode=stealing"
+        PendingJob m_wakeUpToken; // pushed to the shared queue to wake up idle threads when work is put on the local queues
+        std::atomic<uint32_t> m_numIdleThreads = 0;
+        std::atomic<uint32_t> m_numPendingWakeUps = 0;
+
         std::atomic<uint32_t> m_numScheduledJobs;
         std::atomic<uint64_t> m_fiberSequenceNumber;
 
@@ -285,13 +355,29 @@ namespace prv
         uint32_t determineWorkerThreadCount(const IBaseCommandLine& cmdLine);
 
         // add job to the proper queue, it will be picked up by free fiber thread once it's not busy
+        // NOTE: in work stealing mode jobs scheduled from worker threads go to the thread's local queue
         void schedulePendingJob(PendingJob* job);
 
+        // put yielded job at the end of thread's yielded list (work stealing mode)
+        void pushYieldedJob(ThreadState* thread, PendingJob* job);
+
+        // get oldest yielded job from thread's list
+        PendingJob* popYieldedJob(ThreadState* thread);
+
         // create internal pending job object
         void scheduleInternal(const FiberJob& job, uint32_t numInvokations, bool child);
 
         // cleanup finished job
-        void cleanupPendingJob(PendingJob* job);
+        void cleanupPendingJob(ThreadState* thread, PendingJob* job);
+
+        // get next job to run on given thread, blocks if there's nothing to do, returns NULL if we are exiting
+        PendingJob* fetchNextJob(ThreadState* thread);
+
+        // look for job in thread's local queue and steal from other threads if there's nothing
+        PendingJob* findLocalOrStolenJob(ThreadState* thread);
+
+        // wake up an idle thread if there are any (work stealing mode)
+        void wakeUpIdleThread();
 
         // get sequence ID of current job
         uint64_t currentJobSequenceId() const;
@@ -44,6 +44,7 @@ namespace prv
         else
         {
             ret = refill();
+            allFibers.pushBack(ret);
         }
 
         // add fiber to the used list
@@ -95,6 +96,87 @@ namespace prv
         state->isAllocated = false;
     }
 
+    BaseScheduler::FiberState* BaseScheduler::FiberPool::allocFiber(LocalCache& cache)
+    {
+        // refill the local cache with a batch of fibers from the global free list
+        if (!cache.freeFibers)
+        {
+            auto lock = CreateLock(m_lock);
+
+            while (freeFibers && cache.numFreeFibers < LocalCache::MAX_CACHED_FIBERS / 2)
+            {
+                auto state = freeFibers;
+                ASSERT(state->listPrev == nullptr);
+                freeFibers = state->listNext;
+
+                state->listNext = cache.freeFibers;
+                cache.freeFibers = state;
+                cache.numFreeFibers += 1;
+
+                auto numFree = --numFreeFibers;
+                ASSERT(numFree >= 0);
+            }
+
+            // nothing in the global pool as well, create new fiber
+            if (!cache.freeFibers)
+            {
+                auto state = refill();
+                allFibers.pushBack(state);
+
+                cache.freeFibers = state;
+                cache.numFreeFibers = 1;
+            }
+        }
+
+        // pop from local list
+        auto ret = cache.freeFibers;
+        cache.freeFibers = ret->listNext;
+        cache.numFreeFibers -= 1;
+        ret->listNext = nullptr;
+        ++numUsedLocalFibers;
+
+        // mark as allocated
+        ASSERT(ret->isAllocated == false);
+        ret->isAllocated = true;
+
+        return ret;
+    }
+
+    void BaseScheduler::FiberPool::releaseFiber(LocalCache& cache, FiberState* state)
+    {
+        ASSERT_EX(!state->isMainThreadFiber, "Cannot release main fiber");
+        ASSERT_EX(state->currentJob.load() == nullptr, "Freeing fiber that is in use");
+        ASSERT_EX(state->isAllocated == true, "Trying to release fiber that is allocated");
+
+        // mark as not allocated
+        state->isAllocated = false;
+        auto numActive = --numUsedLocalFibers;
+        ASSERT(numActive >= 0);
+
+        // add to local free list
+        ASSERT(state->listPrev == nullptr);
+        state->listNext = cache.freeFibers;
+        cache.freeFibers = state;
+        cache.numFreeFibers += 1;
+
+        // give half of the fibers back to the global pool if we cached too much
+        if (cache.numFreeFibers > LocalCache::MAX_CACHED_FIBERS)
+        {
+            auto lock = CreateLock(m_lock);
+
+            while (cache.numFreeFibers > LocalCache::MAX_CACHED_FIBERS / 2)
+            {
+                auto entry = cache.freeFibers;
+                cache.freeFibers = entry->listNext;
+                cache.numFreeFibers -= 1;
+
+                entry->listNext = freeFibers;
+                freeFibers = entry;
+                numFreeFibers++;
+            }
+        }
+    }
+
     void BaseScheduler::FiberPool::validate()
     {
         auto lock = CreateLock(m_lock);
@@ -126,9 +208,11 @@ namespace prv
 
     void BaseScheduler::FiberPool::inspect(const std::function<void(const FiberState* state)>& inspector)
     {
+        // NOTE: fibers allocated via the thread caches are not on the active list so we must visit all of them
         auto lock = CreateLock(m_lock);
-        for (auto cur  = activeFibers; cur; cur = cur->listNext)
-            inspector(cur);
+        for (auto* cur : allFibers)
+            if (cur->isAllocated)
+                inspector(cur);
     }
 
     ///---
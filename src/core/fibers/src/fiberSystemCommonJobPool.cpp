@@ -33,6 +33,35 @@ namespace prv
         , numFreeJobs(0)
     {}
 
+    void BaseScheduler::PendingJobPool::prepareJob(PendingJob* job)
+    {
+        ASSERT(!job->isAllocated);
+        ASSERT(!job->jobId);
+        ASSERT(!job->next);
+        job->isAllocated = true;
+        job->jobId = ++nextJobId;
+
+        ++numAllocatedJobs;
+    }
+
+    void BaseScheduler::PendingJobPool::resetJob(PendingJob* job)
+    {
+        ASSERT(!job->isMainThreadJob);
+        ASSERT(job->isAllocated);
+        ASSERT(job->next == nullptr);
+        ASSERT(job->waitList == nullptr);
+        ASSERT(job->jobId != 0);
+
+        job->isAllocated = false;
+        job->job.name = nullptr;
+        job->job.func = TJobFunc();
+        job->fiber = nullptr;
+        job->jobId = 0;
+
+        auto count = --numAllocatedJobs;
+        ASSERT(count >= 0);
+    }
+
     BaseScheduler::PendingJob* BaseScheduler::PendingJobPool::alloc()
     {
         auto lock = CreateLock(this->lock);
@@ -51,41 +80,86 @@ namespace prv
             ASSERT(count >= 0);
         }
 
-        ++numAllocatedJobs;
-
-        ASSERT(!job->isAllocated);
-        ASSERT(!job->jobId);
-        ASSERT(!job->next);
-        job->isAllocated = true;
-        job->jobId = ++nextJobId;
-
+        prepareJob(job);
         return job;
     }
 
     void BaseScheduler::PendingJobPool::release(PendingJob* job)
     {
-        auto lock = CreateLock(this->lock);
-
-        ASSERT(!job->isMainThreadJob);
-        ASSERT(job->isAllocated);
-        ASSERT(job->next == nullptr);
-        ASSERT(job->waitList == nullptr);
-        ASSERT(job->jobId != 0);
+        resetJob(job);
 
-        job->isAllocated = false;
-        job->job.name = nullptr;
-        job->job.func = TJobFunc();
-        job->fiber = nullptr;
-        job->jobId = 0;
+        auto lock = CreateLock(this->lock);
 
         job->next = freeList;
         freeList = job;
 
-        auto count = ++numAllocatedJobs;
-        ASSERT(count >= 0);
         ++numFreeJobs;
     }
 
+    BaseScheduler::PendingJob* BaseScheduler::PendingJobPool::alloc(LocalCache& cache)
+    {
+        // refill the local cache with a batch of jobs from the global list
+        if (!cache.freeJobs)
+        {
+            auto lock = CreateLock(this->lock);
+
+            while (freeList && cache.numFreeJobs < LocalCache::MAX_CACHED_JOBS / 2)
+            {
+                auto job = freeList;
+                freeList = job->next;
+
+                job->next = cache.freeJobs;
+                cache.freeJobs = job;
+                cache.numFreeJobs += 1;
+
+                auto count = --numFreeJobs;
+                ASSERT(count >= 0);
+            }
+        }
+
+        // still nothing, allocate new job
+        auto job = cache.freeJobs;
+        if (job == nullptr)
+        {
+            job = new PendingJob();
+        }
+        else
+        {
+            cache.freeJobs = job->next;
+            cache.numFreeJobs -= 1;
+            job->next = nullptr;
+        }
+
+        prepareJob(job);
+        return job;
+    }
+
+    void BaseScheduler::PendingJobPool::release(LocalCache& cache, PendingJob* job)
+    {
+        resetJob(job);
+
+        job->next = cache.freeJobs;
+        cache.freeJobs = job;
+        cache.numFreeJobs += 1;
+
+        // give half of the jobs back to the global list if we cached to much
+        if (cache.numFreeJobs > LocalCache::MAX_CACHED_JOBS)
+        {
+            auto lock = CreateLock(this->lock);
+
+            while (cache.numFreeJobs > LocalCache::MAX_CACHED_JOBS / 2)
+            {
+                auto entry = cache.freeJobs;
+                cache.freeJobs = entry->next;
+                cache.numFreeJobs -= 1;
+
+                entry->next = freeList;
+                freeList = entry;
+                ++numFreeJobs;
+            }
+        }
+    }
+
     ///---
 
 } // prv
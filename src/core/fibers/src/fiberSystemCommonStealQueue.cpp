@@ -0,0 +1,90 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: impl #]
+***/
+
+#include "build.h"
+#include "fiberSystemCommon.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
+{
+
+    ///---
+
+    // Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli)
+    // The capacity is fixed so we don't have to deal with reclamation of the old buffers, overflow goes to the shared queue
+
+    BaseScheduler::StealQueue::StealQueue()
+    {
+        for (auto& entry : entries)
+            entry.store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool BaseScheduler::StealQueue::push(PendingJob* job)
+    {
+        const auto b = bottom.load(std::memory_order_relaxed);
+        const auto t = top.load(std::memory_order_acquire);
+        if (b - t >= (int64_t)CAPACITY)
+            return false;
+
+        entries[b & MASK].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    BaseScheduler::PendingJob* BaseScheduler::StealQueue::pop()
+    {
+        const auto b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            // queue was empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto* job = entries[b & MASK].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // last element, race with the thieves
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    BaseScheduler::PendingJob* BaseScheduler::StealQueue::steal()
+    {
+        for (;;)
+        {
+            auto t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return nullptr;
+
+            auto* job = entries[t & MASK].load(std::memory_order_relaxed);
+            if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return job;
+
+            // lost the race with other thief or the owner, try again as long as there's something in the queue
+        }
+    }
+
+    ///---
+
+} // prv
+
+END_BOOMER_NAMESPACE()
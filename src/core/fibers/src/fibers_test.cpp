@@ -16,6 +16,101 @@
 
 DECLARE_TEST_FILE(Fibers);
 
+BEGIN_BOOMER_NAMESPACE()
+
+TEST(Fibers, ChildBatchRunsAllInvocations)
+{
+    static const uint32_t count = 4096;
+
+    std::atomic<uint32_t> visited[count];
+    for (auto& entry : visited)
+        entry = 0;
+
+    RunFiberLoop("TestBatch", count, -1, [&visited](uint32_t index)
+        {
+            visited[index] += 1;
+        });
+
+    for (uint32_t i = 0; i < count; ++i)
+        EXPECT_EQ(1U, visited[i].load());
+}
+
+TEST(Fibers, YieldedJobsAreResumed)
+{
+    static const uint32_t count = 256;
+
+    // half of the jobs yield until the other half has finished, yielded jobs must keep being resumed while there's other work
+    std::atomic<uint32_t> numProducers = 0;
+    std::atomic<uint32_t> numWaiters = 0;
+    RunFiberLoop("TestYield", count * 2, -1, [&numProducers, &numWaiters](uint32_t index)
+        {
+            if (index & 1)
+            {
+                numProducers += 1;
+            }
+            else
+            {
+                while (numProducers.load() < count)
+                    YieldFiber();
+
+                numWaiters += 1;
+            }
+        });
+
+    EXPECT_EQ(count, numProducers.load());
+    EXPECT_EQ(count, numWaiters.load());
+}
+
+static const auto FIBERS_PERF_ITERATIONS = 10;
+
+// NOTE: run with "-fiberMode=stealing" and different "-numThreads" to compare the schedulers
+TEST(Fibers, Perf_ChildBatchScaling)
+{
+    static const uint32_t NUM_BATCHES = 1024; // total number of small batches, split between spawners
+    static const uint32_t NUM_CHILDREN = 64; // small jobs per batch
+
+    const auto maxSpawners = std::max<uint32_t>(1, WorkerThreadCount());
+    for (uint32_t numSpawners = 1; numSpawners <= maxSpawners; numSpawners *= 2)
+    {
+        const auto batchesPerSpawner = NUM_BATCHES / numSpawners;
+        const auto expectedJobs = batchesPerSpawner * numSpawners * NUM_CHILDREN;
+
+        TimingStatistics stats;
+        for (uint32_t run = 0; run < FIBERS_PERF_ITERATIONS; ++run)
+        {
+            std::atomic<uint32_t> numExecuted = 0;
+
+            {
+                ScopeTimer timer;
+
+                // each spawner runs a sequence of child batches and waits for each of them, that's what most of the engine code does
+                RunFiberLoop("Spawner", numSpawners, -1, [&numExecuted, batchesPerSpawner](uint32_t)
+                    {
+                        for (uint32_t batch = 0; batch < batchesPerSpawner; ++batch)
+                        {
+                            RunFiberLoop("Child", NUM_CHILDREN, -1, [&numExecuted](uint32_t index)
+                                {
+                                    numExecuted += 1;
+                                });
+                        }
+                    });
+
+                stats.update(timer.timeElapsed());
+            }
+
+            EXPECT_EQ(expectedJobs, numExecuted.load());
+        }
+
+        TRACE_WARNING("Fibers ChildBatchScaling ({} threads, {} spawners): {} avg, {} dev, {} jobs/s",
+            WorkerThreadCount(), numSpawners, TimeInterval(stats.mean()), TimeInterval(stats.variance()),
+            (uint64_t)(expectedJobs / std::max(stats.mean(), 0.000001)));
+    }
+}
+
+END_BOOMER_NAMESPACE()
+
+//--
+
 #if 0
 
 BEGIN_BOOMER_NAMESPACE()
@@ -127,5 +222,3 @@ TEST_F(FibersFixture, MultipleJobInvocations1024)
 END_BOOMER_NAMESPACE()
 
 #endif
-
-
@@ -0,0 +1,117 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/system/include/orderedQueue.h"
+#include "core/system/include/thread.h"
+#include "core/containers/include/array.h"
+#include "core/containers/include/uniquePtr.h"
+
+DECLARE_TEST_FILE(OrderedQueue);
+
+BEGIN_BOOMER_NAMESPACE()
+
+TEST(OrderedQueue, PopsInOrderThenSubmission)
+{
+    UniquePtr<IOrderedQueue> queue(IOrderedQueue::Create());
+
+    queue->push((void*)3, 5);
+    queue->push((void*)1, 1);
+    queue->push((void*)2, 1);
+    queue->push((void*)4, 7);
+    queue->push((void*)0, 0);
+
+    for (uintptr_t i = 0; i < 5; ++i)
+        EXPECT_EQ(i, (uintptr_t)queue->pop());
+
+    queue->close();
+}
+
+TEST(OrderedQueue, PopReturnsNullAfterClose)
+{
+    UniquePtr<IOrderedQueue> queue(IOrderedQueue::Create());
+
+    void* result = (void*)1;
+
+    Thread waiter;
+    {
+        ThreadSetup setup;
+        setup.m_name = "QueueWaiter";
+        setup.m_function = [&queue, &result]() { result = queue->pop(); };
+        waiter.init(setup);
+    }
+
+    Sleep(10);
+    queue->close();
+    waiter.close();
+
+    EXPECT_EQ(nullptr, result);
+}
+
+static const auto ORDERED_QUEUE_PERF_ITERATIONS = 5;
+
+TEST(OrderedQueue, Perf_Contention32x32)
+{
+    static const uint32_t NUM_PRODUCERS = 32;
+    static const uint32_t NUM_CONSUMERS = 32;
+    static const uint32_t NUM_ITEMS = 100000; // per producer
+
+    TimingStatistics stats;
+    for (uint32_t run = 0; run < ORDERED_QUEUE_PERF_ITERATIONS; ++run)
+    {
+        UniquePtr<IOrderedQueue> queue(IOrderedQueue::Create());
+        std::atomic<uint64_t> numPopped = 0;
+
+        {
+            ScopeTimer timer;
+
+            Array<Thread> threads;
+            threads.resize(NUM_PRODUCERS + NUM_CONSUMERS);
+
+            for (uint32_t i = 0; i < NUM_CONSUMERS; ++i)
+            {
+                ThreadSetup setup;
+                setup.m_name = "QueueConsumer";
+                setup.m_function = [&queue, &numPopped]()
+                {
+                    for (uint32_t j = 0; j < NUM_ITEMS; ++j)
+                        if (queue->pop())
+                            numPopped += 1;
+                };
+                threads[i].init(setup);
+            }
+
+            // orders mimic the fiber scheduler: few interleaved sequences of small batches
+            for (uint32_t i = 0; i < NUM_PRODUCERS; ++i)
+            {
+                ThreadSetup setup;
+                setup.m_name = "QueueProducer";
+                setup.m_function = [&queue]()
+                {
+                    for (uint32_t j = 0; j < NUM_ITEMS; ++j)
+                        queue->push((void*)1, (j / 16) + 1);
+                };
+                threads[NUM_CONSUMERS + i].init(setup);
+            }
+
+            for (auto& thread : threads)
+                thread.close();
+
+            stats.update(timer.timeElapsed());
+        }
+
+        EXPECT_EQ((uint64_t)NUM_PRODUCERS * NUM_ITEMS, numPopped.load());
+        queue->close();
+    }
+
+    TRACE_WARNING("OrderedQueue Contention32x32: {} avg, {} dev", TimeInterval(stats.mean()), TimeInterval(stats.variance()));
+}
+
+END_BOOMER_NAMESPACE()
@@ -78,8 +78,19 @@ extern CORE_IO_API WriteFileHandlePtr OpenForWriting(StringView absoluteFilePath
 // open physical file for async reading
 extern CORE_IO_API AsyncFileHandlePtr OpenForAsyncReading(StringView absoluteFilePath);
 
+/// how are we going to access the memory mapped file, passed to the OS as a hint
+enum class FileMappingHint : uint8_t
+{
+    Normal, // no special treatment
+    Sequential, // we will read the file front to back (more aggressive read ahead, pages can be dropped after being read)
+    Random, // we will jump around the file (no read ahead)
+    WillNeed, // we will need the whole content soon, start reading it in the background right away
+};
+
 // create a READ ONLY memory mapped buffer view of a file, used by some asset loaders
-extern CORE_IO_API Buffer OpenMemoryMappedForReading(StringView absoluteFilePath);
+// NOTE: the file is unmapped when the last reference to the buffer is released, the data may be paged in lazily so the first access may stall
+// NOTE: the file should not be modified while it's mapped
+extern CORE_IO_API Buffer OpenMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint = FileMappingHint::Normal);
 
 //--
 
@@ -89,6 +100,17 @@ extern CORE_IO_API bool FileSize(StringView absoluteFilePath, uint64_t& outFileS
 //! Get file timestamp
 extern CORE_IO_API bool FileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, uint64_t* outFileSize = nullptr);
 
+/// identity of a file on disk, if any of the values changes the file content should be considered changed
+struct FileIdentity
+{
+    uint64_t fileId = 0; // unique ID of the file on the volume (inode/device on POSIX, file index/volume serial on Windows), changes when the file is replaced
+    uint64_t size = 0; // file size in bytes
+    uint64_t timestamp = 0; // last modification time, as in TimeStamp
+};
+
+//! Get file identity (ID, size and modification time) with a single query, faster than separate FileSize + FileTimeStamp calls
+extern CORE_IO_API bool FileIdentityInfo(StringView absoluteFilePath, FileIdentity& outIdentity);
+
 //! Make sure all directories along the way exist
 extern CORE_IO_API bool CreatePath(StringView absoluteFilePath);
 
@@ -8,38 +8,498 @@
 ***/
 
 #include "build.h"
-#include "fileHandlePOSIX.h"
 #include "asyncDispatcherPOSIX.h"
 
-#include <aio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
 
-namespace base
+BEGIN_BOOMER_NAMESPACE_EX(prv)
+
+//--
+
+// user data of the wake up request, tokens are never at this address
+static const uint64_t WAKE_UP_USER_DATA = 0;
+
+static int IOUringSetup(uint32_t entries, io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int IOUringEnter(int ringFd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+//--
+
+POSIXAsyncReadDispatcher::POSIXAsyncReadDispatcher(uint32_t maxInFlightRequests, bool allowRing, uint64_t maxSingleReadSize)
+    : m_exiting(0)
+    , m_numRequests(0)
+    , m_maxSingleReadSize(std::max<uint64_t>(maxSingleReadSize, 1))
+    , m_tokenPool(POOL_IO, maxInFlightRequests)
+    , m_wakeUpPending(false)
+    , m_pendingCounter(0, INT32_MAX) // any number of fibers may be waiting for a read, the limit applies only to the ring
 {
-    namespace io
+    if (allowRing && createRing(maxInFlightRequests))
     {
-        namespace prv
+        TRACE_INFO("Using io_uring for async reads ({} entries)", m_ringEntries);
+
+        ThreadSetup setup;
+        setup.m_name = "IORing";
+        setup.m_function = [this]() { ringThreadFunc(); };
+        setup.m_priority = ThreadPriority::AboveNormal;
+        m_ringThread.init(setup);
+    }
+    else
+    {
+        // io_uring not supported or disabled (containers often block it), use blocking reads on few threads
+        const auto numThreads = std::clamp<uint32_t>(GetNumberOfCores() / 2, 2, 8);
+        TRACE_INFO("io_uring not available, using {} threads for async reads", numThreads);
+
+        m_workerThreads.resize(numThreads);
+        for (auto& thread : m_workerThreads)
         {
+            ThreadSetup setup;
+            setup.m_name = "IOWorker";
+            setup.m_function = [this]() { workerThreadFunc(); };
+            setup.m_priority = ThreadPriority::AboveNormal;
+            thread.init(setup);
+        }
+    }
+}
+
+POSIXAsyncReadDispatcher::~POSIXAsyncReadDispatcher()
+{
+    m_exiting = 1;
+
+    // the IO threads finish all requests that were already made before exiting
+    if (m_ringFd >= 0)
+    {
+        uint64_t value = 1;
+        (void)!write(m_wakeUpFd, &value, sizeof(value));
+        m_ringThread.close();
+        destroyRing();
+    }
+    else
+    {
+        m_pendingCounter.release(m_workerThreads.size());
+        for (auto& thread : m_workerThreads)
+            thread.close();
+    }
+
+    // requests made while we were shutting down can't be serviced, fail them so the waiting fibers can continue
+    while (auto* token = popPending())
+    {
+        TRACE_WARNING("AsyncRead canceled, IO dispatcher is shutting down");
+        token->m_failed = true;
+        finishToken(token);
+    }
+}
+
+//--
+
+POSIXAsyncReadDispatcher::Token* POSIXAsyncReadDispatcher::allocToken()
+{
+    auto lock = CreateLock(m_tokenPoolLock);
+    return m_tokenPool.create();
+}
+
+void POSIXAsyncReadDispatcher::releaseToken(Token* token)
+{
+    auto lock = CreateLock(m_tokenPoolLock);
+    m_tokenPool.free(token);
+}
+
+void POSIXAsyncReadDispatcher::pushPending(Token* token)
+{
+    auto lock = CreateLock(m_pendingLock);
+
+    token->m_next = nullptr;
+    if (m_pendingTail)
+        m_pendingTail->m_next = token;
+    else
+        m_pendingHead = token;
+    m_pendingTail = token;
+}
+
+POSIXAsyncReadDispatcher::Token* POSIXAsyncReadDispatcher::popPending()
+{
+    auto lock = CreateLock(m_pendingLock);
+
+    auto* token = m_pendingHead;
+    if (token)
+    {
+        m_pendingHead = token->m_next;
+        if (!m_pendingHead)
+            m_pendingTail = nullptr;
+        token->m_next = nullptr;
+    }
 
-            POSIXAsyncReadDispatcher::POSIXAsyncReadDispatcher(uint32_t maxInFlightRequests)
-                : m_maxRequests(maxInFlightRequests)
+    return token;
+}
+
+void POSIXAsyncReadDispatcher::finishToken(Token* token)
+{
+    // write number of bytes we have read, errors are reported as nothing read (same as on Windows)
+    *token->m_numBytesRead = token->m_failed ? 0 : token->m_sizeRead;
+
+    // release token to pool
+    auto signal = token->m_signal;
+    releaseToken(token);
+
+    // signal to unblock the job
+    SignalFence(signal);
+}
+
+uint64_t POSIXAsyncReadDispatcher::readAsync(int hFile, uint64_t offset, uint64_t size, void* outMemory)
+{
+    ASSERT_EX(hFile >= 0, "Invalid file handle");
+
+    // nothing to read
+    if (!size)
+        return 0;
+
+    PC_SCOPE_LVL1(AsyncRead);
+
+    uint64_t numBytesRead = 0;
+    auto signal = CreateFence("IOCompletedSignal");
+
+    // setup
+    auto* token = allocToken();
+    token->m_hFile = hFile;
+    token->m_offset = offset;
+    token->m_memory = (uint8_t*)outMemory;
+    token->m_sizeLeft = size;
+    token->m_sizeRead = 0;
+    token->m_failed = false;
+    token->m_signal = signal;
+    token->m_numBytesRead = &numBytesRead;
+
+    // send to the IO thread(s)
+    pushPending(token);
+    if (m_ringFd >= 0)
+    {
+        // wake the ring thread only if it's not already about to look at the pending list, requests made in the meantime are submitted together
+        if (!m_wakeUpPending.exchange(true))
+        {
+            uint64_t value = 1;
+            (void)!write(m_wakeUpFd, &value, sizeof(value));
+        }
+    }
+    else
+    {
+        m_pendingCounter.release(1);
+    }
+
+    // NOTE: the request is already visible to the IO thread(s), the dispatcher is allowed to be destroyed from now on and will finish it
+    m_numRequests += 1;
+
+    // wait for the signal from IO thread, the fiber is suspended and the worker thread can run other jobs
+    WaitForFence(signal);
+    return numBytesRead;
+}
+
+//--
+
+bool POSIXAsyncReadDispatcher::createRing(uint32_t maxInFlightRequests)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    // one extra entry for the wake up read
+    const auto entries = std::clamp<uint32_t>(maxInFlightRequests + 1, 8, 4096);
+    auto ringFd = IOUringSetup(entries, &params);
+    if (ringFd < 0)
+        return false;
+
+    // map the rings, newer kernels share one mapping for both
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+    m_sqRingPtr = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRingPtr == MAP_FAILED)
+    {
+        m_sqRingPtr = nullptr;
+        close(ringFd);
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        m_cqRingPtr = m_sqRingPtr;
+    }
+    else
+    {
+        m_cqRingPtr = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (m_cqRingPtr == MAP_FAILED)
+        {
+            m_cqRingPtr = nullptr;
+            munmap(m_sqRingPtr, m_sqRingSize);
+            m_sqRingPtr = nullptr;
+            close(ringFd);
+            return false;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqesPtr = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (m_sqesPtr == MAP_FAILED)
+    {
+        m_sqesPtr = nullptr;
+        m_ringFd = ringFd; // so destroyRing closes it
+        destroyRing();
+        return false;
+    }
+
+    auto* sq = (uint8_t*)m_sqRingPtr;
+    m_sqHead = (uint32_t*)(sq + params.sq_off.head);
+    m_sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    m_sqMask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    m_sqArray = (uint32_t*)(sq + params.sq_off.array);
+
+    auto* cq = (uint8_t*)m_cqRingPtr;
+    m_cqHead = (uint32_t*)(cq + params.cq_off.head);
+    m_cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    m_cqMask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    m_cqes = cq + params.cq_off.cqes;
+
+    // we never have more requests in flight than we have SQ entries so the CQ (at least as big) can't overflow
+    m_ringEntries = params.sq_entries;
+
+    m_wakeUpFd = eventfd(0, EFD_CLOEXEC);
+    if (m_wakeUpFd < 0)
+    {
+        m_ringFd = ringFd;
+        destroyRing();
+        return false;
+    }
+
+    m_ringFd = ringFd;
+    return true;
+}
+
+void POSIXAsyncReadDispatcher::destroyRing()
+{
+    if (m_sqesPtr)
+        munmap(m_sqesPtr, m_sqesSize);
+    if (m_cqRingPtr && m_cqRingPtr != m_sqRingPtr)
+        munmap(m_cqRingPtr, m_cqRingSize);
+    if (m_sqRingPtr)
+        munmap(m_sqRingPtr, m_sqRingSize);
+
+    if (m_wakeUpFd >= 0)
+        close(m_wakeUpFd);
+    if (m_ringFd >= 0)
+        close(m_ringFd);
+
+    m_sqesPtr = nullptr;
+    m_cqRingPtr = nullptr;
+    m_sqRingPtr = nullptr;
+    m_wakeUpFd = -1;
+    m_ringFd = -1;
+}
+
+void POSIXAsyncReadDispatcher::queueRead(uint64_t userData, int hFile, iovec* vec, uint64_t offset)
+{
+    // we are the only producer, the kernel only moves the head
+    const auto tail = *m_sqTail;
+    const auto index = tail & *m_sqMask;
+
+    auto* sqe = (io_uring_sqe*)m_sqesPtr + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_READV; // READV is supported by every kernel with io_uring (5.1+), READ needs 5.6
+    sqe->fd = hFile;
+    sqe->addr = (uint64_t)vec;
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = userData;
+
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    m_numToSubmit += 1;
+    m_numInFlight += 1;
+}
+
+void POSIXAsyncReadDispatcher::queueTokenRead(Token* token)
+{
+    token->m_vec.iov_base = token->m_memory;
+    token->m_vec.iov_len = std::min<uint64_t>(token->m_sizeLeft, m_maxSingleReadSize);
+    queueRead((uint64_t)token, token->m_hFile, &token->m_vec, token->m_offset);
+}
+
+void POSIXAsyncReadDispatcher::handleRingCompletion(Token* token, int result)
+{
+    if (result == -EINTR || result == -EAGAIN)
+    {
+        // retry the same request
+        queueTokenRead(token);
+        return;
+    }
+
+    if (result < 0)
+    {
+        TRACE_ERROR("AsyncRead failed with {}", strerror(-result));
+        token->m_failed = true;
+        finishToken(token);
+        return;
+    }
+
+    token->m_offset += result;
+    token->m_memory += result;
+    token->m_sizeRead += result;
+    token->m_sizeLeft -= result;
+
+    // short read (or a split big read), read the rest unless we hit the end of file
+    if (result > 0 && token->m_sizeLeft > 0)
+    {
+        queueTokenRead(token);
+        return;
+    }
+
+    finishToken(token);
+}
+
+void POSIXAsyncReadDispatcher::ringThreadFunc()
+{
+    // the wake up read is always in flight, it completes when somebody adds a new request
+    m_wakeUpVec.iov_base = &m_wakeUpValue;
+    m_wakeUpVec.iov_len = sizeof(m_wakeUpValue);
+    queueRead(WAKE_UP_USER_DATA, m_wakeUpFd, &m_wakeUpVec, 0);
+
+    bool checkPending = false;
+    bool exiting = false;
+    for (;;)
+    {
+        // when exiting keep going until all requests made so far are done
+        if (exiting)
+            checkPending = true;
+
+        // move as many pending requests to the ring as we can, they will be submitted with a single syscall
+        if (checkPending)
+        {
+            while (m_numInFlight < m_ringEntries)
             {
+                auto* token = popPending();
+                if (!token)
+                {
+                    checkPending = false;
+                    break;
+                }
+
+                queueTokenRead(token);
             }
+        }
+
+        // pending list is empty and nothing is in flight (the wake up read is not requeued when exiting)
+        if (exiting && m_numInFlight == 0)
+            return;
+
+        // submit new requests and wait for at least one completion
+        auto ret = IOUringEnter(m_ringFd, m_numToSubmit, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+
+            FATAL_ERROR(TempString("io_uring_enter failed with {}", strerror(errno)).c_str());
+        }
 
-            POSIXAsyncReadDispatcher::~POSIXAsyncReadDispatcher()
+        m_numToSubmit -= ret;
+
+        // process completions
+        auto head = *m_cqHead;
+        const auto tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            const auto& cqe = ((const io_uring_cqe*)m_cqes)[head & *m_cqMask];
+            const auto userData = cqe.user_data;
+            const auto result = cqe.res;
+            head += 1;
+
+            m_numInFlight -= 1;
+
+            if (userData == WAKE_UP_USER_DATA)
             {
-            }
+                if (m_exiting.load())
+                {
+                    exiting = true;
+                    continue;
+                }
 
-            uint64_t POSIXAsyncReadDispatcher::readAsync(int hFile, uint64_t offset, uint64_t size, void* outMemory)
+                // clear the flag before looking at the list, anything pushed after this point will wake us again
+                m_wakeUpPending.exchange(false);
+                queueRead(WAKE_UP_USER_DATA, m_wakeUpFd, &m_wakeUpVec, 0);
+                checkPending = true;
+            }
+            else
             {
-                PC_SCOPE_LVL1(AsyncRead, profiler::colors::Red800);
+                handleRingCompletion((Token*)userData, result);
+            }
+        }
 
-                ScopeLock<> lock(m_lock);
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
 
-                lseek64(hFile, offset, SEEK_SET);
-                return read(hFile, outMemory, size);
+        // some slots were freed, requests that did not fit before can go now
+        if (m_numInFlight < m_ringEntries)
+            checkPending = true;
+    }
+}
+
+//--
+
+void POSIXAsyncReadDispatcher::workerThreadFunc()
+{
+    for (;;)
+    {
+        // wait for work, every request and every exiting thread releases the counter once
+        m_pendingCounter.wait();
+
+        // finish all requests before exiting
+        auto* token = popPending();
+        if (!token)
+        {
+            if (m_exiting.load())
+                break;
+
+            continue;
+        }
+
+        while (token->m_sizeLeft > 0)
+        {
+            const auto size = std::min<uint64_t>(token->m_sizeLeft, m_maxSingleReadSize);
+            const auto ret = pread(token->m_hFile, token->m_memory, size, token->m_offset);
+            if (ret < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+
+                TRACE_ERROR("AsyncRead failed with {}", strerror(errno));
+                token->m_failed = true;
+                break;
             }
 
-        } // prv
-    } // io
-} // base
+            // end of file
+            if (ret == 0)
+                break;
+
+            token->m_offset += ret;
+            token->m_memory += ret;
+            token->m_sizeRead += ret;
+            token->m_sizeLeft -= ret;
+        }
+
+        finishToken(token);
+    }
+}
+
+//--
 
+END_BOOMER_NAMESPACE_EX(prv)
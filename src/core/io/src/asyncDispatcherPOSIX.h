@@ -9,38 +9,128 @@
 
 #pragma once
 
-#include "absolutePath.h"
-#include "core/containers/include/stringBuf.h"
-#include "core/containers/include/threadSafeQueue.h"
+#include "core/containers/include/array.h"
+#include "core/memory/include/structurePool.h"
 #include "core/system/include/thread.h"
+#include "core/system/include/spinLock.h"
 #include "core/system/include/semaphoreCounter.h"
 #include "core/fibers/include/fiberSystem.h"
-#include "core/containers/include/threadSafeStructurePool.h"
 
-namespace base
+#include <sys/uio.h>
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
 {
-    namespace io
+
+    // dispatch for IO jobs
+    // uses io_uring if the kernel supports it (one thread owns the ring, reads are submitted in batches)
+    // falls back to a small pool of threads doing pread() if io_uring is not available
+    class POSIXAsyncReadDispatcher : public NoCopy
     {
-        namespace prv
+        RTTI_DECLARE_POOL(POOL_IO)
+
+    public:
+        // largest read we give to the kernel in one go, bigger reads are split (the kernel would do that anyway)
+        static const uint64_t DEFAULT_MAX_SINGLE_READ_SIZE = 1ULL << 30;
+
+        // NOTE: the ring and the size of single read are changed only by tests (to run the fallback path and the split reads)
+        POSIXAsyncReadDispatcher(uint32_t maxInFlightRequests, bool allowRing = true, uint64_t maxSingleReadSize = DEFAULT_MAX_SINGLE_READ_SIZE);
+        ~POSIXAsyncReadDispatcher(); // finishes the reads already requested, reads requested during shutdown fail (0 bytes read)
+
+        // process async IO request, returns the number of bytes read
+        // NOTE: the calling fiber is suspended until the read completes, worker thread is free to do other work
+        CAN_YIELD uint64_t readAsync(int hFile, uint64_t offset, uint64_t size, void* outMemory);
+
+        // are we using io_uring ?
+        INLINE bool usesRing() const { return m_ringFd >= 0; }
+
+        // number of reads requested so far
+        INLINE uint32_t numRequests() const { return m_numRequests.load(); }
+
+    private:
+        struct Token
         {
+            int m_hFile = -1;
+            uint64_t m_offset = 0; // current offset in file
+            uint8_t* m_memory = nullptr; // current write pointer
+            uint64_t m_sizeLeft = 0; // bytes still to read
+            uint64_t m_sizeRead = 0; // bytes read so far
+            bool m_failed = false;
+            FiberSemaphore m_signal;
+            uint64_t* m_numBytesRead = nullptr;
+            Token* m_next = nullptr;
+            iovec m_vec; // ring only, must stay alive until the kernel consumes the request
+        };
+
+        //--
+
+        std::atomic<uint32_t> m_exiting;
+        std::atomic<uint32_t> m_numRequests;
+        uint64_t m_maxSingleReadSize = DEFAULT_MAX_SINGLE_READ_SIZE;
+
+        StructurePool<Token> m_tokenPool;
+        SpinLock m_tokenPoolLock;
+
+        Token* m_pendingHead = nullptr; // requests not yet given to the kernel/worker
+        Token* m_pendingTail = nullptr;
+        SpinLock m_pendingLock;
+
+        Token* allocToken();
+        void releaseToken(Token* token);
+
+        void pushPending(Token* token);
+        Token* popPending();
+
+        void finishToken(Token* token);
+
+        //--
+
+        // io_uring
+        int m_ringFd = -1;
+        int m_wakeUpFd = -1; // eventfd, read by the ring thread so it can pick new requests while waiting for completions
+        std::atomic<bool> m_wakeUpPending;
+        uint64_t m_wakeUpValue = 0;
+        iovec m_wakeUpVec;
+
+        void* m_sqRingPtr = nullptr;
+        void* m_cqRingPtr = nullptr;
+        void* m_sqesPtr = nullptr;
+        uint64_t m_sqRingSize = 0;
+        uint64_t m_cqRingSize = 0;
+        uint64_t m_sqesSize = 0;
+
+        uint32_t* m_sqHead = nullptr;
+        uint32_t* m_sqTail = nullptr;
+        uint32_t* m_sqMask = nullptr;
+        uint32_t* m_sqArray = nullptr;
+        uint32_t* m_cqHead = nullptr;
+        uint32_t* m_cqTail = nullptr;
+        uint32_t* m_cqMask = nullptr;
+        void* m_cqes = nullptr;
+
+        uint32_t m_ringEntries = 0;
+        uint32_t m_numInFlight = 0; // ring thread only
+        uint32_t m_numToSubmit = 0; // ring thread only
+
+        Thread m_ringThread;
+
+        bool createRing(uint32_t maxInFlightRequests);
+        void destroyRing();
+        void ringThreadFunc();
+        void queueRead(uint64_t userData, int hFile, iovec* vec, uint64_t offset);
+        void queueTokenRead(Token* token);
+        void handleRingCompletion(Token* token, int result);
 
-            class POSIXFileHandle;
+        //--
 
-            // dispatch for IO jobs
-            class POSIXAsyncReadDispatcher
-            {
-            public:
-                POSIXAsyncReadDispatcher(uint32_t maxInFlightRequests);
-                ~POSIXAsyncReadDispatcher();
+        // fallback
+        Array<Thread> m_workerThreads;
+        Semaphore m_pendingCounter;
 
-                // process async IO request, returns the number of bytes read
-                CAN_YIELD uint64_t readAsync(int hFile, uint64_t offset, uint64_t size, void* outMemory);
+        void workerThreadFunc();
+    };
 
-            private:
-                Mutex m_lock;
-                uint32_t m_maxRequests;
-            };
+} // prv
 
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+END_BOOMER_NAMESPACE()
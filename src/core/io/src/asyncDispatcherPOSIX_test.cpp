@@ -0,0 +1,205 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+
+DECLARE_TEST_FILE(AsyncDispatcherPOSIX);
+
+#ifdef PLATFORM_POSIX
+
+#include "fileHandle.h"
+#include "io.h"
+#include "asyncDispatcherPOSIX.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BEGIN_BOOMER_NAMESPACE_EX(prv)
+
+namespace helper
+{
+    static const uint32_t TEST_FILE_SIZE = 100000; // not a multiple of the split size on purpose
+    static const uint64_t TEST_SPLIT_SIZE = 4096;
+
+    static uint8_t TestFileByte(uint64_t offset)
+    {
+        return (uint8_t)(offset * 31 + (offset >> 8));
+    }
+
+    // file with known content, opened the same way the POSIX file system opens files for async reading
+    struct TestFile : public NoCopy
+    {
+        StringBuf path;
+        int hFile = -1;
+
+        TestFile()
+        {
+            path = StringBuf(TempString("{}asyncDispatcherTest.bin", SystemPath(PathCategory::LocalTempDir)));
+
+            Array<uint8_t> data;
+            data.resize(TEST_FILE_SIZE);
+            for (uint32_t i = 0; i < TEST_FILE_SIZE; ++i)
+                data[i] = TestFileByte(i);
+
+            if (auto f = OpenForWriting(path, FileWriteMode::DirectWrite))
+                if (f->writeSync(data.data(), data.size()) == data.size())
+                    hFile = open(path.c_str(), O_RDONLY);
+        }
+
+        ~TestFile()
+        {
+            if (hFile >= 0)
+                close(hFile);
+            DeleteFile(path);
+        }
+    };
+
+    static bool ValidateData(const uint8_t* data, uint64_t offset, uint64_t size)
+    {
+        for (uint64_t i = 0; i < size; ++i)
+            if (data[i] != TestFileByte(offset + i))
+                return false;
+        return true;
+    }
+
+    // readAsync suspends the calling fiber, run it like the engine would
+    static uint64_t ReadInFiber(POSIXAsyncReadDispatcher& dispatcher, int hFile, uint64_t offset, uint64_t size, void* outMemory)
+    {
+        uint64_t numRead = 0;
+        RunFiberLoop("AsyncReadTest", 1, -1, [&](uint32_t)
+            {
+                numRead = dispatcher.readAsync(hFile, offset, size, outMemory);
+            });
+        return numRead;
+    }
+
+    static void TestSplitReads(bool allowRing)
+    {
+        TestFile file;
+        ASSERT_LE(0, file.hFile);
+
+        POSIXAsyncReadDispatcher dispatcher(16, allowRing, TEST_SPLIT_SIZE);
+        if (!allowRing)
+            EXPECT_FALSE(dispatcher.usesRing());
+
+        Array<uint8_t> data;
+        data.resize(TEST_FILE_SIZE);
+
+        // whole file, needs many reads
+        ASSERT_EQ(TEST_FILE_SIZE, ReadInFiber(dispatcher, file.hFile, 0, TEST_FILE_SIZE, data.data()));
+        EXPECT_TRUE(ValidateData(data.data(), 0, TEST_FILE_SIZE));
+
+        // unaligned part, the last split is partial
+        const uint64_t offset = 1234;
+        const uint64_t size = 5 * TEST_SPLIT_SIZE + 77;
+        ASSERT_EQ(size, ReadInFiber(dispatcher, file.hFile, offset, size, data.data()));
+        EXPECT_TRUE(ValidateData(data.data(), offset, size));
+    }
+
+    static void TestShortReadAtEOF(bool allowRing)
+    {
+        TestFile file;
+        ASSERT_LE(0, file.hFile);
+
+        POSIXAsyncReadDispatcher dispatcher(16, allowRing, TEST_SPLIT_SIZE);
+
+        Array<uint8_t> data;
+        data.resize(3 * TEST_SPLIT_SIZE);
+
+        // read crossing the end of file returns what's there
+        ASSERT_EQ(100, ReadInFiber(dispatcher, file.hFile, TEST_FILE_SIZE - 100, 1000, data.data()));
+        EXPECT_TRUE(ValidateData(data.data(), TEST_FILE_SIZE - 100, 100));
+
+        // same when the read is split
+        ASSERT_EQ(TEST_SPLIT_SIZE + 10, ReadInFiber(dispatcher, file.hFile, TEST_FILE_SIZE - TEST_SPLIT_SIZE - 10, data.size(), data.data()));
+        EXPECT_TRUE(ValidateData(data.data(), TEST_FILE_SIZE - TEST_SPLIT_SIZE - 10, TEST_SPLIT_SIZE + 10));
+
+        // nothing to read past the end of file
+        EXPECT_EQ(0, ReadInFiber(dispatcher, file.hFile, TEST_FILE_SIZE, 1000, data.data()));
+        EXPECT_EQ(0, ReadInFiber(dispatcher, file.hFile, TEST_FILE_SIZE + 5000, 1000, data.data()));
+    }
+
+    static void TestDrainOnShutdown(bool allowRing)
+    {
+        TestFile file;
+        ASSERT_LE(0, file.hFile);
+
+        // small ring so most of the requests wait in the pending list when we start shutting down
+        auto* dispatcher = new POSIXAsyncReadDispatcher(4, allowRing, TEST_SPLIT_SIZE);
+
+        static const uint32_t NUM_READS = 16;
+        static const uint64_t READ_SIZE = TEST_FILE_SIZE / NUM_READS;
+
+        Array<uint8_t> data;
+        data.resize(NUM_READS * READ_SIZE);
+
+        uint64_t numRead[NUM_READS];
+        memzero(numRead, sizeof(numRead));
+
+        auto fence = CreateFence("AsyncReadTest", NUM_READS);
+        for (uint32_t i = 0; i < NUM_READS; ++i)
+        {
+            RunFiber("AsyncReadTest") << [dispatcher, &file, &data, &numRead, fence, i](FIBER_FUNC)
+            {
+                numRead[i] = dispatcher->readAsync(file.hFile, i * READ_SIZE, READ_SIZE, data.data() + i * READ_SIZE);
+                SignalFence(fence);
+            };
+        }
+
+        // destroy the dispatcher as soon as all reads were requested
+        while (dispatcher->numRequests() < NUM_READS)
+            Sleep(1);
+        delete dispatcher;
+
+        // everything requested before the shutdown was read
+        WaitForFence(fence);
+        for (uint32_t i = 0; i < NUM_READS; ++i)
+            EXPECT_EQ(READ_SIZE, numRead[i]) << "Read " << i;
+        EXPECT_TRUE(ValidateData(data.data(), 0, data.size()));
+    }
+
+} // helper
+
+//--
+
+TEST(AsyncDispatcherPOSIX, SplitReads)
+{
+    helper::TestSplitReads(true);
+}
+
+TEST(AsyncDispatcherPOSIX, ShortReadAtEOF)
+{
+    helper::TestShortReadAtEOF(true);
+}
+
+TEST(AsyncDispatcherPOSIX, DrainOnShutdown)
+{
+    helper::TestDrainOnShutdown(true);
+}
+
+// same tests without io_uring, used on kernels/containers that don't allow it
+TEST(AsyncDispatcherPOSIX, FallbackSplitReads)
+{
+    helper::TestSplitReads(false);
+}
+
+TEST(AsyncDispatcherPOSIX, FallbackShortReadAtEOF)
+{
+    helper::TestShortReadAtEOF(false);
+}
+
+TEST(AsyncDispatcherPOSIX, FallbackDrainOnShutdown)
+{
+    helper::TestDrainOnShutdown(false);
+}
+
+END_BOOMER_NAMESPACE_EX(prv)
+
+#endif
@@ -10,323 +10,287 @@
 #include "build.h"
 #include "directoryWatcherPOSIX.h"
 #include "fileIteratorPOSIX.h"
-#include "absolutePath.h"
-
-#include "core/system/include/scopeLock.h"
-#include "core/system/include/thread.h"
 
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/inotify.h>
 
-namespace base
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
 {
-    namespace io
+
+    POSIXDirectoryWatcher::POSIXDirectoryWatcher(StringView rootPath)
     {
-        namespace prv
+        // create the notify interface
+        m_masterHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_masterHandle >= 0)
         {
+            TRACE_SPAM("Created directory watcher for '{}'", rootPath);
+
+            // start monitoring the root path
+            monitorPath(StringBuf(rootPath));
+
+            // create the watcher thread
+            ThreadSetup setup;
+            setup.m_name = "IODirectoryWatcher";
+            setup.m_priority = ThreadPriority::AboveNormal;
+            setup.m_function = [this]() { watch(); };
+            m_localThread.init(setup);
+        }
+        else
+        {
+            TRACE_WARNING("Cannot create a file system watcher for absolute path '{}': {}", rootPath, strerror(errno));
+        }
+    }
+
+    POSIXDirectoryWatcher::~POSIXDirectoryWatcher()
+    {
+        // stop thread before the handle goes away
+        m_requestExit = true;
+        m_localThread.close();
 
-            POSIXDirectoryWatcher::POSIXDirectoryWatcher(StringView rootPath)
+        // close the master handle
+        if (m_masterHandle >= 0)
+        {
+            // unmonitor all paths
             {
-                // create the notify interface
-                m_masterHandle = inotify_init1(IN_NONBLOCK);
-                if (m_masterHandle >= 0)
-                {
-                    TRACE_SPAM("Created directory watcher for '{}'", rootPath);
-                }
-                else
-                {
-                    TRACE_ERROR("Failed to create directory watcher");
-                }
+                auto lock = CreateLock(m_mapLock);
 
-                // create the watcher thread
-                ThreadSetup setup;
-                setup.m_name = "DirectoryWatcher";
-                setup.m_priority = Priority::AboveNormal;
-                setup.m_function = [this]() { watch(); };
-                m_localThread.init(setup);
+                for (auto watchId : m_handleToPath.keys())
+                    inotify_rm_watch(m_masterHandle, watchId);
 
-                // start monitoring the root path
-                monitorPath(rootPath);
+                m_handleToPath.clear();
+                m_pathToHandle.clear();
             }
 
-            POSIXDirectoryWatcher::~POSIXDirectoryWatcher()
-            {
-                // close the master handle
-                if (m_masterHandle >= 0)
-                {
-                    // unmonitor all paths
-                    {
-                        ScopeLock<SpinLock> lock(m_mapLock);
+            close(m_masterHandle);
+            m_masterHandle = -1;
+        }
+    }
 
-                        for (auto watchId  : m_handleToPath.keys())
-                            inotify_rm_watch(m_masterHandle, watchId);
+    void POSIXDirectoryWatcher::attachListener(IDirectoryWatcherListener* listener)
+    {
+        auto lock = CreateLock(m_listenersLock);
+        m_listeners.pushBackUnique(listener);
+    }
 
-                        m_handleToPath.clear();
-                        m_pathToHandle.clear();
-                    }
+    void POSIXDirectoryWatcher::dettachListener(IDirectoryWatcherListener* listener)
+    {
+        auto lock = CreateLock(m_listenersLock);
 
-                    // close the master handle
-                    close(m_masterHandle);
-                    m_masterHandle = -1;
-                }
+        auto index = m_listeners.find(listener);
+        if (INDEX_NONE != index)
+            m_listeners[index] = nullptr;
+    }
 
-                // stop thread
-                m_localThread.close();
-            }
+    void POSIXDirectoryWatcher::monitorPath(const StringBuf& path)
+    {
+        // we can create the watch only if we are initialized properly
+        if (m_masterHandle < 0)
+            return;
 
-            void POSIXDirectoryWatcher::attachListener(IDirectoryWatcherListener* listener)
-            {
-                ScopeLock<Mutex> lock(m_listenersLock);
-                m_listeners.pushBack(listener);
-            }
+        // create the watcher
+        auto watcherId = inotify_add_watch(m_masterHandle, path.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVE | IN_MODIFY | IN_ATTRIB);
+        if (watcherId == -1)
+        {
+            TRACE_WARNING("Failed to add directory watch to '{}': {}", path, strerror(errno));
+            return;
+        }
 
-            void POSIXDirectoryWatcher::dettachListener(IDirectoryWatcherListener* listener)
-            {
-                ScopeLock<Mutex> lock(m_listenersLock);
-                auto index  = m_listeners.find(listener);
-                if (index != -1)
-                    m_listeners[index] = nullptr;
-            }
+        TRACE_SPAM("Added directory watch to '{}', handle: {}", path, watcherId);
+
+        // add to map
+        {
+            auto lock = CreateLock(m_mapLock);
+            m_handleToPath.set(watcherId, path);
+            m_pathToHandle.set(path.view().calcCRC64(), watcherId);
+        }
+
+        // monitor the existing sub directories as well
+        for (POSIXFileIterator it(path.c_str(), "*.", false, true); it; ++it)
+            monitorPath(TempString("{}{}/", path, it.fileName()));
+    }
 
-            void POSIXDirectoryWatcher::monitorPath(StringView path)
+    void POSIXDirectoryWatcher::unmonitorPath(const StringBuf& path)
+    {
+        // remove current watcher, sub directories were already reported (and removed) by the kernel before the parent
+        auto lock = CreateLock(m_mapLock);
+
+        int watcherId = 0;
+        auto pathHash = path.view().calcCRC64();
+        if (m_pathToHandle.find(pathHash, watcherId))
+        {
+            // remove from tables
+            TRACE_SPAM("Removed directory watcher at '{}' ({})", path, watcherId);
+            m_pathToHandle.remove(pathHash);
+            m_handleToPath.remove(watcherId);
+
+            // remove from system
+            inotify_rm_watch(m_masterHandle, watcherId);
+        }
+    }
+
+    void POSIXDirectoryWatcher::watch()
+    {
+        while (!m_requestExit.load())
+        {
+            // read data from the kernel
+            auto dataSize = read(m_masterHandle, m_buffer, BUF_LEN);
+            if (dataSize < 0)
             {
-                // we can create the watch only if we are initialized properly
-                if (m_masterHandle >= 0)
+                if (errno == EAGAIN || errno == EINTR)
                 {
-                    // create the watcher
-                    auto watcherId  = inotify_add_watch(m_masterHandle, path.ansi_str().c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVE | IN_MODIFY | IN_ATTRIB);
-                    if (watcherId != -1)
-                    {
-                        TRACE_SPAM("Added directory watch to '{}', handle: {}", path, watcherId);
-
-                        // add to map
-                        {
-                            ScopeLock<SpinLock> lock(m_mapLock);
-                            m_handleToPath.set(watcherId, path);
-                            m_pathToHandle.set(path.view().calcCRC64(), watcherId);
-                        }
-
-                        // monitor the existing sub directories as well
-                        for (POSIXFileIterator it(path, L"*.", false, true); it; ++it)
-                        {
-                            auto subDirPath  = path.addDir(it.fileName());
-                            monitorPath(subDirPath);
-                        }
-                    }
+                    Sleep(10);
+                    continue;
                 }
+
+                TRACE_ERROR("Read error in the directory watcher data stream: {}", strerror(errno));
+                break;
             }
 
-            void POSIXDirectoryWatcher::unmonitorPath(StringView path)
+            // prepare tables
+            m_tempEvents.reset();
+            m_tempAddedDirectories.reset();
+            m_tempRemovedDirectories.reset();
+
+            // process data
+            auto cur = &m_buffer[0];
+            auto end = &m_buffer[dataSize];
+            while (cur < end)
             {
-                // un monitor the existing sub directories as well
-                for (POSIXFileIterator it(path, L"*.", false, true); it; ++it)
+                // get event
+                const auto& evt = *(const struct inotify_event*)cur;
+                cur += sizeof(struct inotify_event) + evt.len;
+
+                // identify the target path entry
+                StringBuf dirPath;
                 {
-                    auto subDirPath  = path.addDir(it.fileName());
-                    unmonitorPath(subDirPath);
+                    auto lock = CreateLock(m_mapLock);
+
+                    if (!m_handleToPath.find(evt.wd, dirPath))
+                    {
+                        TRACE_SPAM("IO event at unrecognized path, ID {}", evt.wd);
+                        continue;
+                    }
+
+                    // self deleted
+                    if (evt.mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                    {
+                        m_pathToHandle.remove(dirPath.view().calcCRC64());
+                        m_handleToPath.remove(evt.wd);
+                        continue;
+                    }
                 }
 
-                // remove current watcher
-                ScopeLock<SpinLock> lock(m_mapLock);
+                // watch was removed, nothing else will come from it
+                if (evt.mask & IN_IGNORED)
+                    continue;
 
-                int watcherId = 0;
-                auto pathHash  = path.view().calcCRC64();
-                if (m_pathToHandle.find(pathHash, watcherId))
+                // format full path
+                const bool isDir = (0 != (evt.mask & IN_ISDIR));
+                const auto fullPath = StringBuf(TempString("{}{}", dirPath, evt.len ? evt.name : ""));
+
+                // stuff was created
+                if (evt.mask & IN_CREATE)
                 {
-                    // remove from tables
-                    TRACE_SPAM("Removed directory watcher at '{}' ({})", path.c_str(), watcherId);
-                    m_pathToHandle.remove(pathHash);
-                    m_handleToPath.remove(watcherId);
+                    if (isDir)
+                    {
+                        // if a directory is added make sure to monitor it as well
+                        m_tempAddedDirectories.pushBack(TempString("{}/", fullPath));
 
-                    // remove from system
-                    inotify_rm_watch(m_masterHandle, watcherId);
+                        auto& info = m_tempEvents.emplaceBack();
+                        info.type = DirectoryWatcherEventType::DirectoryAdded;
+                        info.path = fullPath;
+                    }
+                    else
+                    {
+                        // report the file once it's fully written
+                        m_filesCreatedButNotYetClosed.pushBackUnique(fullPath);
+                    }
                 }
-            }
 
-            void POSIXDirectoryWatcher::watch()
-            {
-                for (;;)
+                // writable file was closed
+                if (evt.mask & IN_CLOSE_WRITE)
                 {
-                    // nothing to read
-                    if (m_masterHandle <= 0)
-                        break;
+                    if (m_filesCreatedButNotYetClosed.remove(fullPath))
+                    {
+                        m_filesModifiedButNotYetClosed.remove(fullPath);
 
-                    // read data from the crap
-                    auto dataSize  = read(m_masterHandle, m_buffer, BUF_LEN);
-                    if (dataSize < 0)
+                        auto& info = m_tempEvents.emplaceBack();
+                        info.type = DirectoryWatcherEventType::FileAdded;
+                        info.path = fullPath;
+                    }
+                    else if (m_filesModifiedButNotYetClosed.remove(fullPath))
                     {
-                        if (errno == EAGAIN)
-                        {
-                            Sleep(10);
-                            continue;
-                        }
-
-                        TRACE_ERROR("Read error in the directory watcher data stream: {}", errno);
-                        break;
+                        auto& info = m_tempEvents.emplaceBack();
+                        info.type = DirectoryWatcherEventType::FileContentChanged;
+                        info.path = fullPath;
                     }
+                }
 
-                    // prepare tables
-                    m_tempEvents.reset();
-                    m_tempAddedDirectories.reset();
-                    m_tempRemovedDirectories.reset();
+                // file was moved in
+                if (evt.mask & IN_MOVED_TO)
+                {
+                    if (isDir)
+                        m_tempAddedDirectories.pushBack(TempString("{}/", fullPath));
 
-                    // process data
-                    auto cur  = &m_buffer[0];
-                    auto end  = &m_buffer[dataSize];
-                    while (cur < end)
-                    {
-                        // get event
-                        auto &evt = *(struct inotify_event *) cur;
-
-                        // prevent modifications of the map table
-                        m_mapLock.acquire();
-
-                        // identify the target path entry
-                        auto pathEntry  = m_handleToPath.find(evt.wd);
-                        if (!pathEntry)
-                        {
-                            TRACE_INFO("IO event at unrecognized path, ID {}, '{}'", evt.wd, evt.name);
-                            m_mapLock.release();
-                            break;
-                        }
-
-                        TRACE_INFO("IO watcher: '{}' '{}' {}", pathEntry->c_str(), evt.name, Hex(evt.mask));
-
-                        // self deleted
-                        if (evt.mask & (IN_DELETE_SELF | IN_MOVE_SELF))
-                        {
-                            // find path
-                            TRACE_INFO("Observed directory '{}' self deleted", pathEntry->c_str());
-                            auto& info = m_tempEvents.emplaceBack();
-                            info.m_type = DirectoryWatcherEventType::DirectoryRemoved;
-                            info.m_path = *pathEntry;
-
-                            // unmap
-                            m_pathToHandle.remove(pathEntry->view().calcCRC64());
-                            m_handleToPath.remove(evt.wd);
-                            m_mapLock.release();
-                        }
-                        else
-                        {
-                            // format full path
-                            bool isDir = (0 != (evt.mask & IN_ISDIR));
-                            auto shortPath  = &evt.name[0];
-                            auto fullPath  = isDir ? pathEntry->addDir(shortPath) : pathEntry->addFile(shortPath);
-                            m_mapLock.release();
-
-                            // stuff was created
-                            if (evt.mask & IN_CREATE)
-                            {
-                                // if a directory is added make sure to monitor it as well
-                                if (isDir)
-                                {
-                                    m_tempAddedDirectories.pushBack(fullPath);
-
-                                    auto &evt = m_tempEvents.emplaceBack();
-                                    evt.m_type = isDir ? DirectoryWatcherEventType::DirectoryAdded : DirectoryWatcherEventType::FileAdded;
-                                    evt.m_path = fullPath;
-                                }
-                                else
-                                {
-                                    // remember the file around
-                                    m_filesCreatedButNotYetClosed.pushBackUnique(fullPath);
-                                }
-                            }
-
-                            // writable file was closed
-                            if (evt.mask & IN_CLOSE_WRITE)
-                            {
-                                // report event only if the fle was previously modified
-                                if (m_filesCreatedButNotYetClosed.remove(fullPath))
-                                {
-                                    auto &evt = m_tempEvents.emplaceBack();
-                                    evt.m_type = DirectoryWatcherEventType::FileAdded;
-                                    evt.m_path = fullPath;
-                                }
-
-                                // just modified
-                                if (m_filesModifiedButNotYetClosed.remove(fullPath))
-                                {
-                                    auto &evt = m_tempEvents.emplaceBack();
-                                    evt.m_type = DirectoryWatcherEventType::FileContentChanged;
-                                    evt.m_path = fullPath;
-                                }
-                            }
-
-                            // file was moved
-                            if (evt.mask & IN_MOVED_TO)
-                            {
-                                // if a directory is added make sure to monitor it as well
-                                if (isDir)
-                                    m_tempAddedDirectories.pushBack(fullPath);
-
-                                // create direct event
-                                auto &evt = m_tempEvents.emplaceBack();
-                                evt.m_type = isDir ? DirectoryWatcherEventType::DirectoryAdded : DirectoryWatcherEventType::FileAdded;
-                                evt.m_path = fullPath;
-                            }
-
-                            // stuff was removed
-                            if (evt.mask & (IN_DELETE | IN_MOVED_FROM))
-                            {
-                                // if a directory is added make sure to monitor it as well
-                                if (isDir)
-                                    m_tempRemovedDirectories.pushBack(fullPath);
-
-                                // create event
-                                auto &evt = m_tempEvents.emplaceBack();
-                                evt.m_type = isDir ? DirectoryWatcherEventType::DirectoryRemoved : DirectoryWatcherEventType::FileRemoved;
-                                evt.m_path = fullPath;
-                            }
-
-                            // stuff was changed
-                            if (evt.mask & (IN_MODIFY))
-                            {
-                                if (!isDir)
-                                {
-                                    // watch for file changes
-                                    m_filesModifiedButNotYetClosed.pushBackUnique(fullPath);
-                                }
-                            }
-
-                            // metadata changed
-                            if (evt.mask & (IN_ATTRIB))
-                            {
-                                auto &evt = m_tempEvents.emplaceBack();
-                                evt.m_type = DirectoryWatcherEventType::FileMetadataChanged;
-                                evt.m_path = fullPath;
-                            }
-                        }
-
-                        // advance
-                        cur += sizeof(struct inotify_event) + evt.len;
-                    }
+                    auto& info = m_tempEvents.emplaceBack();
+                    info.type = isDir ? DirectoryWatcherEventType::DirectoryAdded : DirectoryWatcherEventType::FileAdded;
+                    info.path = fullPath;
+                }
 
-                    // unmonitor directories that got removed
-                    for (auto &path : m_tempRemovedDirectories)
-                        unmonitorPath(path);
+                // stuff was removed
+                if (evt.mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    if (isDir)
+                        m_tempRemovedDirectories.pushBack(TempString("{}/", fullPath));
 
-                    // start monitoring directories that go added
-                    for (auto &path : m_tempAddedDirectories)
-                        monitorPath(path);
+                    m_filesCreatedButNotYetClosed.remove(fullPath);
+                    m_filesModifiedButNotYetClosed.remove(fullPath);
 
-                    // lock access to this thread only
-                    ScopeLock<Mutex> lock(m_listenersLock);
+                    auto& info = m_tempEvents.emplaceBack();
+                    info.type = isDir ? DirectoryWatcherEventType::DirectoryRemoved : DirectoryWatcherEventType::FileRemoved;
+                    info.path = fullPath;
+                }
 
-                    // send events to the listeners
-                    for (auto &evt : m_tempEvents)
-                    {
-                        for (auto listener  : m_listeners)
-                        {
-                            if (listener != nullptr)
-                                listener->handleEvent(evt);
-                        }
-                    }
+                // content changed, reported when the file is closed
+                if ((evt.mask & IN_MODIFY) && !isDir)
+                    m_filesModifiedButNotYetClosed.pushBackUnique(fullPath);
 
-                    // remove the empty listeners
-                    m_listeners.remove(nullptr);
+                // metadata changed
+                if ((evt.mask & IN_ATTRIB) && !isDir)
+                {
+                    auto& info = m_tempEvents.emplaceBack();
+                    info.type = DirectoryWatcherEventType::FileMetadataChanged;
+                    info.path = fullPath;
                 }
             }
 
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+            // unmonitor directories that got removed
+            for (const auto& path : m_tempRemovedDirectories)
+                unmonitorPath(path);
+
+            // start monitoring directories that got added
+            for (const auto& path : m_tempAddedDirectories)
+                monitorPath(path);
+
+            // send events to the listeners
+            {
+                auto lock = CreateLock(m_listenersLock);
+
+                for (const auto& evt : m_tempEvents)
+                    for (auto listener : m_listeners)
+                        if (listener)
+                            listener->handleEvent(evt);
+
+                m_listeners.removeUnorderedAll(nullptr);
+            }
+        }
+    }
+
+} // prv
+
+END_BOOMER_NAMESPACE()
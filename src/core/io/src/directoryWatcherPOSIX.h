@@ -4,11 +4,12 @@
 * Source code licensed under LGPL 3.0 license
 *
 * [#filter: io\system\watcher\posix #]
+* [#platform: posix #]
 ***/
 
 #pragma once
 
-#include "ioDirectoryWatcher.h"
+#include "directoryWatcher.h"
 
 #include "core/system/include/spinLock.h"
 #include "core/containers/include/array.h"
@@ -36,6 +37,7 @@ namespace prv
         static const uint32_t BUF_LEN = 1024 * 64;
 
         int m_masterHandle;
+        std::atomic<bool> m_requestExit = false;
 
         Mutex m_listenersLock;
         Array<IDirectoryWatcherListener*> m_listeners;
@@ -55,8 +57,8 @@ namespace prv
 
         uint8_t m_buffer[BUF_LEN];
 
-        void monitorPath(StringView path);
-        void unmonitorPath(StringView path);
+        void monitorPath(const StringBuf& path);
+        void unmonitorPath(const StringBuf& path);
 
         void watch();
     };
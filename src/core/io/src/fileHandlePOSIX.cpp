@@ -11,97 +11,286 @@
 #include "fileHandlePOSIX.h"
 #include "asyncDispatcherPOSIX.h"
 
-namespace base
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
 {
-    namespace io
+
+    //--
+
+    static const uint64_t ONE_IO_MAX = 1ULL << 30; // 1GB
+
+    static uint64_t FileHandleSize(int hHandle, StringView origin)
     {
-        namespace prv
+        struct stat st;
+        if (0 != fstat(hHandle, &st))
         {
+            TRACE_WARNING("POSIXIO: Failed to get file size for '{}', error: {}", origin, strerror(errno));
+            return 0;
+        }
 
-            POSIXFileHandle::POSIXFileHandle(int hFile, const StringBuf& origin, bool reader, bool writer, POSIXAsyncReadDispatcher* dispatcher)
-                : m_fileHandle(hFile)
-                , m_origin(origin)
-                , m_isReader(reader)
-                , m_isWriter(writer)
-                , m_dispatcher(dispatcher)
-            {
-            }
+        return (uint64_t)st.st_size;
+    }
 
-            POSIXFileHandle::~POSIXFileHandle()
-            {
-                close(m_fileHandle);
-                m_fileHandle = 0;
-            }
+    static uint64_t FileHandlePos(int hHandle, StringView origin)
+    {
+        const auto pos = lseek64(hHandle, 0, SEEK_CUR);
+        if (pos < 0)
+        {
+            TRACE_WARNING("POSIXIO: Failed to get file position for '{}', error: {}", origin, strerror(errno));
+            return 0;
+        }
 
-            int POSIXFileHandle::syncFileHandle() const
-            {
-                return m_fileHandle;
-            }
+        return (uint64_t)pos;
+    }
 
-            const StringBuf& POSIXFileHandle::originInfo() const
-            {
-                return m_origin;
-            }
+    static bool FileHandleSeek(int hHandle, StringView origin, uint64_t newPosition)
+    {
+        if (lseek64(hHandle, newPosition, SEEK_SET) != (off64_t)newPosition)
+        {
+            TRACE_WARNING("POSIXIO: Failed to seek file position for '{}', error: {}", origin, strerror(errno));
+            return false;
+        }
 
-            uint64_t POSIXFileHandle::size() const
-            {
-                auto pos  = lseek64(m_fileHandle, 0, SEEK_CUR);
-                auto size  = lseek64(m_fileHandle, 0, SEEK_END);
-                lseek64(m_fileHandle, pos, SEEK_SET);
-                return size;
-            }
+        return true;
+    }
 
-            uint64_t POSIXFileHandle::pos() const
-            {
-                return lseek64(m_fileHandle, 0, SEEK_CUR);
-            }
+    //--
 
-            bool POSIXFileHandle::pos(uint64_t newPosition)
+    POSIXReadFileHandle::POSIXReadFileHandle(int hFile, StringView path)
+        : m_hHandle(hFile)
+        , m_origin(path)
+    {
+    }
+
+    POSIXReadFileHandle::~POSIXReadFileHandle()
+    {
+        if (m_hHandle >= 0)
+        {
+            close(m_hHandle);
+            m_hHandle = -1;
+        }
+    }
+
+    uint64_t POSIXReadFileHandle::size() const
+    {
+        return FileHandleSize(m_hHandle, m_origin);
+    }
+
+    uint64_t POSIXReadFileHandle::pos() const
+    {
+        return FileHandlePos(m_hHandle, m_origin);
+    }
+
+    bool POSIXReadFileHandle::pos(uint64_t newPosition)
+    {
+        return FileHandleSeek(m_hHandle, m_origin, newPosition);
+    }
+
+    uint64_t POSIXReadFileHandle::readSync(void* data, uint64_t size)
+    {
+        uint64_t totalDataRead = 0;
+        while (size > 0)
+        {
+            // read data
+            const auto readSize = std::min<uint64_t>(ONE_IO_MAX, size);
+            const auto bytesRead = read(m_hHandle, data, readSize);
+            if (bytesRead < 0)
             {
-                auto newPos  = lseek64(m_fileHandle, newPosition, SEEK_SET);
-                return newPos == newPosition;
+                if (errno == EINTR)
+                    continue;
+
+                TRACE_WARNING("POSIXIO: Read failed for '{}' at offset {}, read size {}, error: {}", m_origin, pos(), readSize, strerror(errno));
+                break;
             }
 
-            bool POSIXFileHandle::isReadingAllowed() const
+            // accumulate total read count
+            totalDataRead += bytesRead;
+            size -= bytesRead;
+            data = (uint8_t*)data + bytesRead;
+
+            // end of file
+            if (bytesRead == 0)
             {
-                return m_isReader;
+                TRACE_WARNING("POSIXIO: Read was incomplete for '{}' at offset {}, {} bytes left to read", m_origin, pos(), size);
+                break;
             }
+        }
+
+        return totalDataRead;
+    }
+
+    //--
+
+    POSIXWriteFileHandle::POSIXWriteFileHandle(int hFile, StringView path)
+        : m_hHandle(hFile)
+        , m_origin(path)
+    {
+    }
+
+    POSIXWriteFileHandle::~POSIXWriteFileHandle()
+    {
+        if (m_hHandle >= 0)
+        {
+            close(m_hHandle);
+            m_hHandle = -1;
+        }
+    }
+
+    uint64_t POSIXWriteFileHandle::size() const
+    {
+        return FileHandleSize(m_hHandle, m_origin);
+    }
 
-            bool POSIXFileHandle::isWritingAllowed() const
+    uint64_t POSIXWriteFileHandle::pos() const
+    {
+        return FileHandlePos(m_hHandle, m_origin);
+    }
+
+    bool POSIXWriteFileHandle::pos(uint64_t newPosition)
+    {
+        return FileHandleSeek(m_hHandle, m_origin, newPosition);
+    }
+
+    uint64_t POSIXWriteFileHandle::writeSync(const void* data, uint64_t size)
+    {
+        uint64_t totalDataWritten = 0;
+        while (size > 0)
+        {
+            // write data
+            const auto writeSize = std::min<uint64_t>(ONE_IO_MAX, size);
+            const auto bytesWritten = write(m_hHandle, data, writeSize);
+            if (bytesWritten < 0)
             {
-                return m_isWriter;
+                if (errno == EINTR)
+                    continue;
+
+                TRACE_WARNING("POSIXIO: Write failed for '{}' at offset {}, write size {}, error: {}", m_origin, pos(), writeSize, strerror(errno));
+                break;
             }
 
-            uint64_t POSIXFileHandle::writeSync(const void* data, uint64_t size)
+            // accumulate total write count, short writes are continued
+            totalDataWritten += bytesWritten;
+            size -= bytesWritten;
+            data = (const uint8_t*)data + bytesWritten;
+
+            if (bytesWritten == 0)
             {
-                auto numWritten  = write(m_fileHandle, data, size);
-                if (numWritten != size)
-                {
-                    TRACE_ERROR("Write failed for '{}', written {} instead of {} at {}, size {}: error: {}",
-                            m_origin.c_str(), numWritten, size, pos(), size(), errno);
-                }
-
-                return numWritten;
+                TRACE_WARNING("POSIXIO: Write was incomplete for '{}' at offset {}, {} bytes left to write", m_origin, pos(), size);
+                break;
             }
+        }
 
-            uint64_t POSIXFileHandle::readSync(void* data, uint64_t size)
+        return totalDataWritten;
+    }
+
+    void POSIXWriteFileHandle::discardContent()
+    {
+        TRACE_WARNING("POSIXIO: Requested to discard content of non-dicardable write '{}'", m_origin);
+    }
+
+    //--
+
+    POSIXWriteTempFileHandle::POSIXWriteTempFileHandle(const StringBuf& targetPath, const StringBuf& tempFilePath, const WriteFileHandlePtr& tempFileWriter)
+        : m_tempFilePath(tempFilePath)
+        , m_targetFilePath(targetPath)
+        , m_tempFileWriter(tempFileWriter)
+    {}
+
+    POSIXWriteTempFileHandle::~POSIXWriteTempFileHandle()
+    {
+        if (m_tempFileWriter)
+        {
+            // close it
+            m_tempFileWriter.reset();
+
+            // move temp file to the target place, rename replaces the target file atomically
+            if (0 == rename(m_tempFilePath.c_str(), m_targetFilePath.c_str()))
             {
-                auto numRead  = read(m_fileHandle, data, size);
-                if (numRead != size)
-                {
-                    TRACE_ERROR("Read failed for '{}'", m_origin);
-                    return 0;
-                }
-
-                return numRead;
+                TRACE_INFO("POSIXIO: Finished staged writing for target '{}'", m_targetFilePath);
             }
-
-            CAN_YIELD uint64_t POSIXFileHandle::readAsync(uint64_t offset, uint64_t size, void* readBuffer)
+            else
             {
-                return m_dispatcher->readAsync(m_fileHandle, offset, size, readBuffer);
+                TRACE_WARNING("POSIXIO: Failed to move staged file to '{}', error: {}. New content remains saved at '{}'.",
+                    m_targetFilePath, strerror(errno), m_tempFilePath);
             }
+        }
+    }
+
+    uint64_t POSIXWriteTempFileHandle::size() const
+    {
+        if (m_tempFileWriter)
+            return m_tempFileWriter->size();
+        return 0;
+    }
+
+    uint64_t POSIXWriteTempFileHandle::pos() const
+    {
+        if (m_tempFileWriter)
+            return m_tempFileWriter->pos();
+        return 0;
+    }
+
+    bool POSIXWriteTempFileHandle::pos(uint64_t newPosition)
+    {
+        if (m_tempFileWriter)
+            return m_tempFileWriter->pos(newPosition);
+        return false;
+    }
+
+    uint64_t POSIXWriteTempFileHandle::writeSync(const void* data, uint64_t size)
+    {
+        if (m_tempFileWriter)
+            return m_tempFileWriter->writeSync(data, size);
+        return 0;
+    }
+
+    void POSIXWriteTempFileHandle::discardContent()
+    {
+        if (m_tempFileWriter)
+        {
+            TRACE_WARNING("POSIXIO: Discarded file writing for target '{}'. Temp file '{}' will be deleted.", m_targetFilePath, m_tempFilePath);
+            m_tempFileWriter.reset();
+            unlink(m_tempFilePath.c_str());
+        }
+    }
+
+    //--
+
+    POSIXAsyncFileHandle::POSIXAsyncFileHandle(int hFile, StringView origin, uint64_t size, POSIXAsyncReadDispatcher* dispatcher)
+        : m_hHandle(hFile)
+        , m_size(size)
+        , m_dispatcher(dispatcher)
+        , m_origin(origin)
+    {
+    }
+
+    POSIXAsyncFileHandle::~POSIXAsyncFileHandle()
+    {
+        if (m_hHandle >= 0)
+        {
+            close(m_hHandle);
+            m_hHandle = -1;
+        }
+    }
+
+    uint64_t POSIXAsyncFileHandle::size() const
+    {
+        return m_size;
+    }
+
+    uint64_t POSIXAsyncFileHandle::readAsync(uint64_t offset, uint64_t size, void* readBuffer)
+    {
+        return m_dispatcher->readAsync(m_hHandle, offset, size, readBuffer);
+    }
+
+    //--
 
-        } // prv
-    } // io
-} // base
+} // prv
 
+END_BOOMER_NAMESPACE()
@@ -9,54 +9,109 @@
 
 #pragma once
 
-#include "absolutePath.h"
 #include "core/containers/include/stringBuf.h"
 
-#include "ioFileHandle.h"
+#include "fileHandle.h"
+#include "asyncFileHandle.h"
 
-namespace base
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
 {
-    namespace io
+    ///--
+
+    // POSIX based file handle for sync READ operations
+    class POSIXReadFileHandle : public IReadFileHandle
     {
-        namespace prv
-        {
-            class POSIXAsyncReadDispatcher;
+    public:
+        POSIXReadFileHandle(int hFile, StringView path);
+        virtual ~POSIXReadFileHandle();
+
+        INLINE int handle() const { return m_hHandle; }
+
+        // IFileHandle implementation
+        virtual uint64_t size() const override final;
+        virtual uint64_t pos() const override final;
+        virtual bool pos(uint64_t newPosition) override final;
+        virtual uint64_t readSync(void* data, uint64_t size) override final;
+
+    protected:
+        int m_hHandle; // always there
+        StringBuf m_origin;
+    };
+
+    ///--
+
+    // POSIX based file handle for sync WRITE operations
+    class POSIXWriteFileHandle : public IWriteFileHandle
+    {
+    public:
+        POSIXWriteFileHandle(int hFile, StringView path);
+        virtual ~POSIXWriteFileHandle();
+
+        INLINE int handle() const { return m_hHandle; }
 
-            // POSIX based file handle
-            class POSIXFileHandle : public IFileHandle
-            {
-            public:
-                POSIXFileHandle(int hFile, const StringBuf& origin, bool reader, bool writer, POSIXAsyncReadDispatcher* dispatcher);
-                virtual ~POSIXFileHandle();
+        // IFileHandle implementation
+        virtual uint64_t size() const override final;
+        virtual uint64_t pos() const override final;
+        virtual bool pos(uint64_t newPosition) override final;
+        virtual uint64_t writeSync(const void* data, uint64_t size) override final;
+        virtual void discardContent() override final;
 
-                int syncFileHandle() const;
+    protected:
+        int m_hHandle; // always there
+        StringBuf m_origin;
+    };
 
-                // IFileHandle implementation
-                virtual const StringBuf& originInfo() const override final;
-                virtual uint64_t size() const override final;
-                virtual uint64_t pos() const override final;
-                virtual bool pos(uint64_t newPosition) override final;
+    ///--
+
+    // POSIX based file handle for staged WRITE operations, content is written to a temp file that replaces the target file when the handle is closed
+    class POSIXWriteTempFileHandle : public IWriteFileHandle
+    {
+    public:
+        POSIXWriteTempFileHandle(const StringBuf& targetPath, const StringBuf& tempFilePath, const WriteFileHandlePtr& tempFileWriter);
+        virtual ~POSIXWriteTempFileHandle();
+
+        // IFileHandle implementation
+        virtual uint64_t size() const override final;
+        virtual uint64_t pos() const override final;
+        virtual bool pos(uint64_t newPosition) override final;
+        virtual uint64_t writeSync(const void* data, uint64_t size) override final;
+        virtual void discardContent() override final;
+
+    protected:
+        StringBuf m_tempFilePath;
+        StringBuf m_targetFilePath;
+        WriteFileHandlePtr m_tempFileWriter;
+    };
+
+    //--
+
+    class POSIXAsyncReadDispatcher;
+
+    // POSIX based file handle for async reads, reads are executed by the dispatcher
+    class POSIXAsyncFileHandle : public IAsyncFileHandle
+    {
+    public:
+        POSIXAsyncFileHandle(int hFile, StringView origin, uint64_t size, POSIXAsyncReadDispatcher* dispatcher);
+        virtual ~POSIXAsyncFileHandle();
 
-                virtual bool isReadingAllowed() const override final;
-                virtual bool isWritingAllowed() const override final;
+        INLINE int handle() const { return m_hHandle; }
 
-                virtual uint64_t writeSync(const void* data, uint64_t size) override final;
-                virtual uint64_t readSync(void* data, uint64_t size) override final;
+        // IFileHandle implementation
+        virtual uint64_t size() const override final;
 
-                virtual CAN_YIELD uint64_t readAsync(uint64_t offset, uint64_t size, void* readBuffer) override final;
+        virtual CAN_YIELD uint64_t readAsync(uint64_t offset, uint64_t size, void* readBuffer) override final;
 
-                ///--
+    protected:
+        int m_hHandle; // always there
+        uint64_t m_size; // at the time file was opened
 
-            protected:
-                int m_fileHandle;
-                StringBuf m_origin;
+        POSIXAsyncReadDispatcher* m_dispatcher;
 
-                bool m_isReader : 1;
-                bool m_isWriter : 1;
+        StringBuf m_origin;
+    };
 
-                POSIXAsyncReadDispatcher* m_dispatcher;
-            };
+} // prv
 
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+END_BOOMER_NAMESPACE()
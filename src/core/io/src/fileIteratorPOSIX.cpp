@@ -10,128 +10,122 @@
 #include "build.h"
 #include "fileIteratorPOSIX.h"
 
-#include "core/containers/include/utf8StringFunctions.h"
-
 #include <dirent.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+BEGIN_BOOMER_NAMESPACE()
 
-namespace base
+namespace prv
 {
-    namespace io
+
+    POSIXFileIterator::POSIXFileIterator(const char* directoryPath, StringView pattern, bool allowFiles, bool allowDirs)
+        : m_dir(nullptr)
+        , m_entry(nullptr)
+        , m_allowDirs(allowDirs)
+        , m_allowFiles(allowFiles)
+        , m_searchPattern(pattern)
+    {
+        // "*.*" and "*." are the Windows way of saying "everything"
+        m_matchAll = pattern.empty() || pattern == "*" || pattern == "*.*" || pattern == "*.";
+
+        // Open the directory
+        m_dir = opendir(directoryPath);
+        m_entry = m_dir ? readdir((DIR*)m_dir) : nullptr;
+
+        // Get first valid entry
+        while (!validateEntry())
+            if (!nextEntry())
+                break;
+    }
+
+    POSIXFileIterator::~POSIXFileIterator()
+    {
+        // Close search handle
+        if (m_dir != nullptr)
+        {
+            closedir((DIR*)m_dir);
+            m_dir = nullptr;
+        }
+    }
+
+    const char* POSIXFileIterator::fileName() const
+    {
+        if (m_entry == nullptr)
+            return nullptr;
+
+        return ((struct dirent*)m_entry)->d_name;
+    }
+
+    bool POSIXFileIterator::validateEntry() const
     {
-        namespace prv
+        if (m_entry == nullptr)
+            return false;
+
+        auto fileEntry = ((struct dirent*)m_entry);
+        auto fileName = fileEntry->d_name;
+        if (0 == strcmp(fileName, "."))
+            return false;
+
+        if (0 == strcmp(fileName, ".."))
+            return false;
+
+        // some file systems don't report the type in the entry, ask for it directly
+        bool isDirectory = (fileEntry->d_type == DT_DIR);
+        if (fileEntry->d_type == DT_UNKNOWN || fileEntry->d_type == DT_LNK)
         {
+            struct stat st;
+            if (0 == fstatat(dirfd((DIR*)m_dir), fileName, &st, 0))
+                isDirectory = S_ISDIR(st.st_mode);
+        }
+
+        // Skip filtered
+        if ((isDirectory && !m_allowDirs) || (!isDirectory && !m_allowFiles))
+            return false;
+
+        // check pattern
+        if (!m_matchAll && !StringView(fileName).matchString(m_searchPattern))
+            return false;
+
+        // entry can be used
+        return true;
+    }
+
+    bool POSIXFileIterator::nextEntry()
+    {
+        if (m_dir == nullptr)
+            return false;
+
+        m_entry = readdir((DIR*)m_dir);
+        if (!m_entry)
+        {
+            closedir((DIR*)m_dir);
+            m_dir = nullptr;
+        }
+
+        return true;
+    }
+
+    void POSIXFileIterator::operator++(int)
+    {
+        while (nextEntry())
+            if (validateEntry())
+                break;
+    }
+
+    void POSIXFileIterator::operator++()
+    {
+        while (nextEntry())
+            if (validateEntry())
+                break;
+    }
+
+    POSIXFileIterator::operator bool() const
+    {
+        return m_entry != nullptr;
+    }
+
+} // prv
 
-            POSIXFileIterator::POSIXFileIterator(const StringBuf& path, const wchar_t* pattern, bool allowFiles, bool allowDirs)
-                : m_allowDirs(allowDirs)
-                , m_allowFiles(allowFiles)
-                , m_searchPath(path)
-                , m_searchPattern(pattern)
-                , m_dir(nullptr)
-                , m_entry(nullptr)
-            {
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), path.c_str(), wcslen(path.c_str()));
-
-                // Format the search path
-                m_dir = opendir(filePath);
-                m_entry = m_dir ? readdir((DIR*)m_dir) : nullptr;
-
-                // Get first valid entry
-                while (!validateEntry())
-                    if (!nextEntry())
-                        break;
-            }
-
-            POSIXFileIterator::~POSIXFileIterator()
-            {
-                // Close search handle
-                if (m_dir != 0)
-                {
-                    closedir((DIR*)m_dir);
-                    m_dir = 0;
-                }
-            }
-
-            const char* POSIXFileIterator::fileName() const
-            {
-                if (m_entry == 0)
-                    return nullptr;
-
-                return ((struct dirent*)m_entry)->d_name;
-            }
-
-            StringBuf POSIXFileIterator::filePath() const
-            {
-                if (m_entry == 0)
-                    return StringBuf();
-
-                const auto* fileName = (const char*) ((struct dirent*)m_entry)->d_name;
-                return TempString("{}{}", m_searchPath, fileName);
-            }
-
-            bool POSIXFileIterator::validateEntry() const
-            {
-                if (m_entry == 0)
-                    return false;
-
-                auto fileEntry  = ((struct dirent*)m_entry);
-                auto fileName  = fileEntry->d_name;
-                if (0 == strcmp(fileName, "."))
-                    return false;
-
-                if (0 == strcmp(fileName, ".."))
-                    return false;
-
-                // Skip filtered
-                bool isDirectory = (fileEntry->d_type == DT_DIR);
-                if ((isDirectory && !m_allowDirs) || (!isDirectory && !m_allowFiles))
-                    return false;
-
-                // check pattern
-                if (m_searchPattern != "*.*" && m_searchPattern != "*.")
-                {
-                    if (!StringView(fileName).matchString(m_searchPattern.view()))
-                        return false;
-                }
-
-                // entry can be used
-                return true;
-            }
-
-            bool POSIXFileIterator::nextEntry()
-            {
-                if (m_dir == 0)
-                    return false;
-
-                m_entry = readdir((DIR*)m_dir);
-                if (!m_entry)
-                {
-                    closedir((DIR*)m_dir);
-                    m_dir = nullptr;
-                }
-
-                return true;
-            }
-
-            void POSIXFileIterator::operator++(int)
-            {
-                while (nextEntry())
-                    if (validateEntry())
-                        break;
-            }
-
-            void POSIXFileIterator::operator++()
-            {
-                while (nextEntry())
-                    if (validateEntry())
-                        break;
-            }
-
-            POSIXFileIterator::operator bool() const
-            {
-                return m_entry != 0;
-            }
-
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+END_BOOMER_NAMESPACE()
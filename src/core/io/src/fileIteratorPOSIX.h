@@ -9,66 +9,57 @@
 
 #pragma once
 
-#include "absolutePath.h"
 #include "core/containers/include/stringBuf.h"
 
-namespace base
-{
-    namespace io
-    {
-        namespace prv
-        {
+BEGIN_BOOMER_NAMESPACE()
 
-            /// File iterator for enumerating directory structure
-            class POSIXFileIterator
-            {
-            public:
-                //! Get search path ( root directory )
-                INLINE const StringBuf& searchPath() const { return m_searchPath; }
+namespace prv
+{
 
-                //! Are directories allowed ?
-                INLINE bool areDirectoriesAllowed() const { return m_allowDirs; }
+    /// File iterator for enumerating directory structure
+    class POSIXFileIterator
+    {
+    public:
+        //! Are directories allowed ?
+        INLINE bool areDirectoriesAllowed() const { return m_allowDirs; }
 
-                //! Are files allowed ?
-                INLINE bool areFilesAllowed() const { return m_allowFiles; }
+        //! Are files allowed ?
+        INLINE bool areFilesAllowed() const { return m_allowFiles; }
 
-                //---
+        //---
 
-                POSIXFileIterator(const StringBuf& searchAbsolutePath, const char* pattern, bool allowFiles, bool allowDirs);
-                ~POSIXFileIterator();
+        POSIXFileIterator(const char* directoryPath, StringView pattern, bool allowFiles, bool allowDirs);
+        ~POSIXFileIterator();
 
-                //! Iterate to next
-                void operator++(int);
+        //! Iterate to next
+        void operator++(int);
 
-                //! Iterate to next
-                void operator++();
+        //! Iterate to next
+        void operator++();
 
-                //! Is the current file valid ?
-                operator bool() const;
+        //! Is the current file valid ?
+        operator bool() const;
 
-                //! Get current file path (full path + name and extension)
-                StringBuf filePath() const;
+        //! Get current file name (name and extension only) - UTF8 encoded
+        const char* fileName() const;
 
-                //! Get current file name ( name and extension only )
-                const char* fileName() const;
+    private:
+        //! Do we have a valid entry ?
+        bool validateEntry() const;
 
-            private:
-                //! Do we have a valid entry ?
-                bool validateEntry() const;
+        //! Skip until valid file is found
+        bool nextEntry();
 
-                //! Skip until valid file is found
-                bool nextEntry();
+        void* m_dir;
+        void* m_entry;
 
-                void* m_dir;
-                void* m_entry;
+        bool m_allowDirs;
+        bool m_allowFiles;
+        bool m_matchAll;
 
-                bool m_allowDirs;
-                bool m_allowFiles;
+        StringBuf m_searchPattern;
+    };
 
-                StringBuf m_searchPath;
-                StringBuf m_searchPattern;
-            };
+} // prv
 
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+END_BOOMER_NAMESPACE()
@@ -37,7 +37,7 @@ namespace prv
         virtual Buffer loadIntoMemoryForReading(StringView absoluteFilePath) = 0;
 
         // open a read only memory mapped access to file
-        virtual Buffer openMemoryMappedForReading(StringView absoluteFilePath) = 0;
+        virtual Buffer openMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint) = 0;
 
         //! Get file size, returns 0 if file does not exist (we are not interested in empty file either)
         virtual bool fileSize(StringView absoluteFilePath, uint64_t& outFileSize) = 0;
@@ -45,6 +45,9 @@ namespace prv
         //! Get file timestamp
         virtual bool fileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, uint64_t* outFileSize) = 0;
 
+        //! Get file identity (ID, size and modification time)
+        virtual bool fileIdentity(StringView absoluteFilePath, FileIdentity& outIdentity) = 0;
+
         //! Make sure all directories along the way exist
         virtual bool createPath(StringView absoluteFilePath) = 0;
 
@@ -3,636 +3,865 @@
 * Written by Tomasz Jonarski (RexDex)
 * Source code licensed under LGPL 3.0 license
 *
-* [#filter: io\system\impl #]
+* [#filter: io\system\posix #]
 * [#platform: posix #]
 ***/
 
 #include "build.h"
 
-#include "StringBuf.h"
-#include "StringBufBuilder.h"
 #include "timestamp.h"
 #include "fileFormat.h"
-#include "utils.h"
 
+#include "core/containers/include/stringBuilder.h"
+
+#include "io.h"
 #include "fileSystemPOSIX.h"
 #include "fileIteratorPOSIX.h"
 #include "fileHandlePOSIX.h"
-#include "asyncDispatcherPOSIX.h"
 #include "directoryWatcherPOSIX.h"
+#include "asyncDispatcherPOSIX.h"
 
-#include "core/containers/include/utf8StringFunctions.h"
-#include "core/containers/include/stringBuilder.h"
-
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <pwd.h>
+#include <limits.h>
 #include <sys/stat.h>
-#include <sys/unistd.h>
-#include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/types.h>
-#include <sys/time.h>
-#include <utime.h>
-#include <pwd.h>
-#include <ftw.h>
+#include <sys/sendfile.h>
+
+BEGIN_BOOMER_NAMESPACE()
 
-namespace base
+namespace prv
 {
-    namespace io
+
+    static bool GTraceIO = false;
+
+    //--
+
+    POSIXIOSystem::POSIXIOSystem()
+    {
+        // create the dispatcher for async IO operations
+        m_asyncDispatcher = new POSIXAsyncReadDispatcher(1024);
+    }
+
+    void POSIXIOSystem::deinit()
     {
-        namespace prv
+        delete m_asyncDispatcher;
+        m_asyncDispatcher = nullptr;
+    }
+
+    ReadFileHandlePtr POSIXIOSystem::openForReading(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
+
+        // Open file
+        auto handle = open(str.c_str(), O_RDONLY | O_CLOEXEC);
+        if (handle < 0)
         {
+            TRACE_WARNING("POSIXIO: Failed to create reading handle for '{}', error: {}", absoluteFilePath, strerror(errno));
+            return nullptr;
+        }
 
-            //---
+        // Return file reader
+        if (GTraceIO) TRACE_INFO("POSIXIO: Opened '{}' for reading", absoluteFilePath);
+        return RefNew<POSIXReadFileHandle>(handle, absoluteFilePath);
+    }
 
-            POSIXIOSystem::POSIXIOSystem()
-            {
-                // initialize async dispatcher
-                m_asyncDispatcher = CreateUniquePtr<POSIXAsyncReadDispatcher>(4096);
-            }
+    static StringBuf GenerateTempFilePath(StringView absoluteFilePath)
+    {
+        // keep the temp file in the same directory so it can be renamed over the target file
+        static std::atomic<uint32_t> GLocalAppUniqueFile = 1;
+        return TempString("{}/.__BoomerTemp_{}_{}.tmp", absoluteFilePath.beforeLast("/"), (uint32_t)getpid(), GLocalAppUniqueFile++);
+    }
 
-            POSIXIOSystem::~POSIXIOSystem()
-            {
-                m_asyncDispatcher.reset();
-            }
+    WriteFileHandlePtr POSIXIOSystem::openForWriting(const char* str, bool append)
+    {
+        // Open file
+        auto handle = open(str, O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), DEFFILEMODE);
+        if (handle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Failed to create writing handle for '{}', error: {}", str, strerror(errno));
+            return nullptr;
+        }
+
+        // Create the wrapper
+        if (GTraceIO) TRACE_INFO("POSIXIO: Opened '{}' for writing", str);
+        return RefNew<POSIXWriteFileHandle>(handle, str);
+    }
+
+    WriteFileHandlePtr POSIXIOSystem::openForWriting(StringView absoluteFilePath, FileWriteMode mode /*= FileWriteMode::StagedWrite*/)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-            bool POSIXIOSystem::servicesPath(const StringBuf& absoluteFilePath)
+        // Create path
+        if (!createPath(absoluteFilePath))
+        {
+            TRACE_WARNING("POSIXIO: Failed to create path for '{}'", absoluteFilePath);
+            return nullptr;
+        }
+
+        // Remove the read only flag
+        if (!readOnlyFlag(absoluteFilePath, false))
+        {
+            TRACE_WARNING("POSIXIO: Unable to remove read only flag from file '{}', assuming it's protected", absoluteFilePath);
+            return nullptr;
+        }
+
+        // Staged write
+        if (mode == FileWriteMode::StagedWrite)
+        {
+            // generate temp file path and open it
+            const auto tempFilePath = GenerateTempFilePath(absoluteFilePath);
+
+            // create temp file writer
+            auto tempFileWriter = openForWriting(tempFilePath.c_str(), false);
+            if (!tempFileWriter)
             {
-                // TODO: path should start with proper drive name
-                return true;
+                TRACE_WARNING("POSIXIO: Unable to create temp writing file for '{}'", absoluteFilePath);
+                return nullptr;
             }
 
-            FileHandlePtr POSIXIOSystem::openForReading(const StringBuf& absoluteFilePath)
-            {
-                // convert file path
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+            // create wrapper
+            if (GTraceIO) TRACE_INFO("POSIXIO: Opened '{}' for staged writing", absoluteFilePath);
+            return RefNew<POSIXWriteTempFileHandle>(str, tempFilePath, tempFileWriter);
+        }
 
-                // open file
-                auto handle  = open(filePath, O_RDONLY);
-                if (handle <= 0)
-                {
-                    TRACE_ERROR("Failed to create reading handle for '{}'", absoluteFilePath);
-                    return nullptr;
-                }
+        // open file
+        return openForWriting(str.c_str(), mode == FileWriteMode::DirectAppend);
+    }
 
-                // Return file reader
-                return RefNew<POSIXFileHandle>(handle, absoluteFilePath.ansi_str().c_str(), true, false, m_asyncDispatcher.get());
-            }
+    AsyncFileHandlePtr POSIXIOSystem::openForAsyncReading(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-            FileHandlePtr POSIXIOSystem::openForWriting(const StringBuf& absoluteFilePath, bool append)
-            {
-                // Create path
-                if (!createPath(absoluteFilePath))
-                {
-                    TRACE_ERROR("Failed to create path for '{}'", absoluteFilePath);
-                    return nullptr;
-                }
+        // Open file
+        auto handle = open(str.c_str(), O_RDONLY | O_CLOEXEC);
+        if (handle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Failed to create async reading handle for '{}', error: {}", absoluteFilePath, strerror(errno));
+            return nullptr;
+        }
+
+        struct stat st;
+        if (0 != fstat(handle, &st))
+        {
+            TRACE_WARNING("POSIXIO: Failed to get file size for '{}', error: {}", absoluteFilePath, strerror(errno));
+            close(handle);
+            return nullptr;
+        }
 
-                // Remove the read only flag
-                readOnlyFlag(absoluteFilePath, false);
+        // Return file reader
+        if (GTraceIO) TRACE_INFO("POSIXIO: Opened '{}' for async reading ({})", absoluteFilePath, MemSize(st.st_size));
+        return RefNew<POSIXAsyncFileHandle>(handle, absoluteFilePath, st.st_size, m_asyncDispatcher);
+    }
 
-                // convert file path
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+    //--
 
-                // Open file
-                auto handle  = open(filePath, O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC), DEFFILEMODE);
-                if (handle <= 0)
-                {
-                    auto ret  = errno;
-                    TRACE_ERROR("Failed to create writing handle for '{}': {}", filePath, ret);
-                    return nullptr;
-                }
+    Buffer POSIXIOSystem::loadIntoMemoryForReading(StringView absoluteFilePath)
+    {
+        const auto filePath = StringBuf(absoluteFilePath);
 
-                // Move file pointer
-                uint32_t pos = 0;
-                if (append)
-                    pos = lseek64(handle, 0, SEEK_END);
+        auto handle = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (handle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Failed to create reading handle for '{}', error: {}", absoluteFilePath, strerror(errno));
+            return nullptr;
+        }
 
-                // Create the wrapper
-                return RefNew<POSIXFileHandle>(handle, absoluteFilePath.ansi_str().c_str(), false, true, m_asyncDispatcher.get());
-            }
+        struct stat st;
+        if (0 != fstat(handle, &st))
+        {
+            TRACE_WARNING("POSIXIO: Unable to get size of file '{}', error: {}", absoluteFilePath, strerror(errno));
+            close(handle);
+            return nullptr;
+        }
+
+        const uint64_t size = st.st_size;
+        auto ret = Buffer::Create(POOL_IO, size, 4096);
+        if (!ret)
+        {
+            TRACE_WARNING("POSIXIO: Unable to allocate {} needed to load file '{}'", MemSize(size), absoluteFilePath);
+            close(handle);
+            return nullptr;
+        }
+
+        // we will read the whole thing once
+        posix_fadvise(handle, 0, size, POSIX_FADV_SEQUENTIAL);
 
-            FileHandlePtr POSIXIOSystem::openForReadingAndWriting(const StringBuf& absoluteFilePath, bool resetContent /*= false*/)
+        uint64_t offset = 0;
+        while (offset < size)
+        {
+            auto numRead = pread(handle, ret.data() + offset, size - offset, offset);
+            if (numRead < 0 && errno == EINTR)
+                continue;
+
+            if (numRead <= 0)
             {
-                // Create path
-                if (!createPath(absoluteFilePath))
-                {
-                    TRACE_ERROR("Failed to create path for '{}'", absoluteFilePath);
-                    return nullptr;
-                }
+                TRACE_WARNING("POSIXIO: IO error reading content of file '{}', error: {}", absoluteFilePath, strerror(errno));
+                close(handle);
+                return nullptr;
+            }
 
-                // Remove the read only flag
-                readOnlyFlag(absoluteFilePath, false);
+            offset += numRead;
+        }
 
-                // convert file path
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        if (GTraceIO) TRACE_INFO("POSIXIO: Loaded '{}' into memory ({})", absoluteFilePath, MemSize(size));
+        close(handle);
+        return ret;
+    }
 
-                // Open file
-                int handle = open(filePath, O_RDWR | O_CREAT, DEFFILEMODE);
-                if (handle <= 0)
-                {
-                    TRACE_ERROR("Failed to create read/write handle for '{}'", absoluteFilePath);
-                    return nullptr;
-                }
+    static void ReleaseMemoryMappedFile(PoolTag pool, void* memory, uint64_t size)
+    {
+        // NOTE: the size is rounded up to the page size by the kernel
+        munmap(memory, size);
+    }
 
-                // Create the wrapper
-                return RefNew<POSIXFileHandle>(handle, absoluteFilePath.ansi_str().c_str(), true, true, m_asyncDispatcher.get());
-            }
+    static int TranslateMappingHint(FileMappingHint hint)
+    {
+        switch (hint)
+        {
+            case FileMappingHint::Sequential: return MADV_SEQUENTIAL;
+            case FileMappingHint::Random: return MADV_RANDOM;
+            case FileMappingHint::WillNeed: return MADV_WILLNEED;
+        }
 
-            bool POSIXIOSystem::fileSize(const StringBuf& absoluteFilePath, uint64_t& outFileSize)
-            {
-                // convert file path
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        return MADV_NORMAL;
+    }
 
-                // get file stats
-                struct stat st;
-                if (0 != stat(filePath, &st))
-                    return false;
+    Buffer POSIXIOSystem::openMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint)
+    {
+        const auto filePath = StringBuf(absoluteFilePath);
 
-                outFileSize = st.st_size;
-                return true;
-            }
+        auto handle = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (handle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Failed to open '{}' for memory mapping, error: {}", absoluteFilePath, strerror(errno));
+            return nullptr;
+        }
 
-            bool POSIXIOSystem::fileTimeStamp(const StringBuf& absoluteFilePath, class TimeStamp& outTimeStamp)
-            {
-                // convert file path
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        struct stat st;
+        if (0 != fstat(handle, &st))
+        {
+            TRACE_WARNING("POSIXIO: Unable to get size of file '{}', error: {}", absoluteFilePath, strerror(errno));
+            close(handle);
+            return nullptr;
+        }
+
+        // empty files can't be mapped
+        const uint64_t size = st.st_size;
+        if (!size)
+        {
+            close(handle);
+            return nullptr;
+        }
 
-                // get file stats
-                struct stat st;
-                if (0 != stat(filePath, &st))
-                    return false;
+        // the mapping keeps its own reference to the file, we don't need the handle after this
+        auto* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, handle, 0);
+        close(handle);
 
-                outTimeStamp = TimeStamp::GetFromFileTime(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
-                return true;
-            }
+        if (memory == MAP_FAILED)
+        {
+            TRACE_WARNING("POSIXIO: Failed to memory map '{}' ({}), error: {}", absoluteFilePath, MemSize(size), strerror(errno));
+            return nullptr;
+        }
 
-            bool POSIXIOSystem::createPath(const StringBuf& absoluteFilePath)
-            {
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        // hints are not critical, ignore errors
+        if (hint != FileMappingHint::Normal)
+            madvise(memory, size, TranslateMappingHint(hint));
 
-                // Create path
-                char* path = filePath;
-                for (char *pos = path; *pos; pos++)
-                {
-                    if (*pos == '\\' || *pos == '/')
-                    {
-                        char was = *pos;
-                        *pos = 0;
-
-                        if (strlen(path) > 0)
-                        {
-                            if (0 != mkdir(path, ALLPERMS))
-                            {
-                                auto ret  = errno;
-                                if (ret != EEXIST)
-                                {
-                                    TRACE_ERROR("Failed to create path '{}': {}", path, ret);
-                                    return false;
-                                }
-                            }
-                        }
-
-                        *pos = was;
-                    }
-                }
+        if (GTraceIO) TRACE_INFO("POSIXIO: Mapped '{}' into memory ({})", absoluteFilePath, MemSize(size));
+        return Buffer::CreateExternal(POOL_IO, size, memory, &ReleaseMemoryMappedFile);
+    }
 
-                // Path created
-                return true;
-            }
+    bool POSIXIOSystem::fileSize(StringView absoluteFilePath, uint64_t& outFileSize)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-            bool POSIXIOSystem::moveFile(const StringBuf& srcStringBuf, const StringBuf& destStringBuf)
-            {
-                // convert source path
-                char srcFilePath[512];
-                utf8::FromUniChar(srcFilePath, sizeof(srcFilePath), srcStringBuf.c_str(), srcStringBuf.view().length());
+        struct stat st;
+        if (0 != stat(str.c_str(), &st))
+            return false;
 
-                // convert destination path
-                char destFilePath[512];
-                utf8::FromUniChar(destFilePath, sizeof(destFilePath), destStringBuf.c_str(), destStringBuf.view().length());
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileSize '{}': {}", absoluteFilePath, (uint64_t)st.st_size);
 
-                // Delete destination file
-                if (-1 != access(destFilePath, F_OK))
-                {
-                    if (0 != remove(destFilePath))
-                    {
-                        auto err  = errno;
-                        TRACE_ERROR("Unable to move file \"{}\" to \"{}\". Destination file cannot be removed. Error: {}", srcStringBuf, destStringBuf, err);
-                        return false;
-                    }
-                }
+        outFileSize = st.st_size;
+        return true;
+    }
 
-                // create target path
-                if (!createPath(destStringBuf))
-                {
-                    TRACE_ERROR("Unable to move file \"{}\" to \"{}\", Unable to create target path", srcStringBuf, destStringBuf);
-                    return false;
-                }
+    bool POSIXIOSystem::fileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, uint64_t* outFileSize)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-                // Move the file
-                if (0 != rename(srcFilePath, destFilePath))
-                {
-                    auto err  = errno;
-                    TRACE_ERROR("Unable to move file \"{}\" to \"{}\", Error: {}", srcStringBuf, destStringBuf, err);
-                    return false;
-                }
+        struct stat st;
+        if (0 != stat(str.c_str(), &st))
+            return false;
 
-                // File moved
-                return true;
-            }
+        if (outFileSize)
+            *outFileSize = st.st_size;
 
-            bool POSIXIOSystem::deleteFile(const StringBuf& absoluteFilePath)
-            {
-                if (!readOnlyFlag(absoluteFilePath, false))
-                    return false;
+        outTimeStamp = TimeStamp::GetFromFileTime(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
 
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileTimeStamp '{}': {}", absoluteFilePath, outTimeStamp);
+        return true;
+    }
 
-                // Delete the file
-                if (0 != remove(filePath))
-                {
-                    auto err  = errno;
-                    TRACE_ERROR("Unable to delete file \"{}\", Error: {}", absoluteFilePath, err);
-                    return false;
-                }
+    bool POSIXIOSystem::fileIdentity(StringView absoluteFilePath, FileIdentity& outIdentity)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-                // File deleted
-                return true;
-            }
+        // get all file stats at once
+        struct stat st;
+        if (0 != stat(str.c_str(), &st))
+            return false;
+
+        outIdentity.fileId = (uint64_t)st.st_ino ^ ((uint64_t)st.st_dev << 48);
+        outIdentity.size = st.st_size;
+        outIdentity.timestamp = TimeStamp::GetFromFileTime(st.st_mtim.tv_sec, st.st_mtim.tv_nsec).value();
+
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileIdentity '{}': ID {}, size {}, time {}", absoluteFilePath, Hex(outIdentity.fileId), outIdentity.size, TimeStamp(outIdentity.timestamp));
+        return true;
+    }
+
+    bool POSIXIOSystem::touchFile(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
+
+        // set both access and modification time to now
+        if (0 != utimensat(AT_FDCWD, str.c_str(), nullptr, 0))
+        {
+            TRACE_WARNING("POSIXIO: Unable to touch file '{}', error: {}", absoluteFilePath, strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
 
-            static int RemoveRecursive(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+    bool POSIXIOSystem::createPath(StringView absoluteFilePath)
+    {
+        auto str = StringBuf(absoluteFilePath);
+
+        // Create path, everything after the last separator is the file name
+        char* path = (char*)str.c_str();
+        for (char* pos = path + 1; *pos; pos++)
+        {
+            if (*pos == '/')
             {
-                int rv = remove(fpath);
+                *pos = 0;
+                const auto ok = (0 == mkdir(path, ACCESSPERMS)) || (errno == EEXIST);
+                *pos = '/';
 
-                if (rv)
+                if (!ok)
                 {
-                    auto err = errno;
-                    TRACE_ERROR("Unable to delete \"{}\", Error: {}", fpath, err);
+                    TRACE_WARNING("POSIXIO: Failed to create path '{}', error: {}", absoluteFilePath, strerror(errno));
+                    return false;
                 }
-
-                return rv;
             }
+        }
 
-            bool POSIXIOSystem::deleteDir(const StringBuf& abosluteDirPath)
-            {
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), abosluteDirPath.c_str(), abosluteDirPath.view().length());
+        // Path created
+        return true;
+    }
 
-                // delete all stuff
-                if (0 != nftw(filePath, RemoveRecursive, 64, FTW_DEPTH | FTW_PHYS))
-                    return false;
+    bool POSIXIOSystem::copyFile(StringView srcAbsolutePath, StringView destAbsolutePath)
+    {
+        ScopeTimer timer;
 
-                // all content deleted
-                return true;
-            }
+        // Delete destination file
+        if (fileExists(destAbsolutePath) && !deleteFile(destAbsolutePath))
+        {
+            TRACE_WARNING("POSIXIO: FileCopy unable to delete destination file \"{}\"", destAbsolutePath);
+            return false;
+        }
 
-            bool POSIXIOSystem::touchFile(const StringBuf& absoluteFilePath)
-            {
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
+        // Make sure target path exists
+        if (!createPath(destAbsolutePath))
+        {
+            TRACE_WARNING("POSIXIO: FileCopy unable to create target path for file \"{}\"", destAbsolutePath);
+            return false;
+        }
 
-                time_t curTime = 0;
-                time(&curTime);
+        const auto srcStr = StringBuf(srcAbsolutePath);
+        const auto destStr = StringBuf(destAbsolutePath);
 
-                utimbuf buf;
-                buf.modtime = curTime;
-                buf.actime = curTime;
-                utime(filePath, &buf);
+        auto srcHandle = open(srcStr.c_str(), O_RDONLY | O_CLOEXEC);
+        if (srcHandle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Unable to copy file \"{}\" to \"{}\", source can't be opened: {}", srcAbsolutePath, destAbsolutePath, strerror(errno));
+            return false;
+        }
 
-                return true;
-            }
+        struct stat st;
+        if (0 != fstat(srcHandle, &st))
+        {
+            TRACE_WARNING("POSIXIO: Unable to copy file \"{}\" to \"{}\", source can't be queried: {}", srcAbsolutePath, destAbsolutePath, strerror(errno));
+            close(srcHandle);
+            return false;
+        }
 
-            bool POSIXIOSystem::fileExists(const StringBuf& absoluteFilePath)
+        auto destHandle = open(destStr.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & ACCESSPERMS);
+        if (destHandle < 0)
+        {
+            TRACE_WARNING("POSIXIO: Unable to copy file \"{}\" to \"{}\", destination can't be created: {}", srcAbsolutePath, destAbsolutePath, strerror(errno));
+            close(srcHandle);
+            return false;
+        }
+
+        // copy in the kernel, no need to go through user space buffers
+        off_t offset = 0;
+        bool ok = true;
+        while (offset < st.st_size)
+        {
+            auto numCopied = sendfile(destHandle, srcHandle, &offset, st.st_size - offset);
+            if (numCopied < 0 && errno == EINTR)
+                continue;
+
+            if (numCopied <= 0)
             {
-                char filePath[512];
-                utf8::FromUniChar(filePath, sizeof(filePath), absoluteFilePath.c_str(), absoluteFilePath.view().length());
-                return (-1 != access(filePath, F_OK));
+                TRACE_WARNING("POSIXIO: Unable to copy file \"{}\" to \"{}\": {}", srcAbsolutePath, destAbsolutePath, strerror(errno));
+                ok = false;
+                break;
             }
+        }
 
-            bool POSIXIOSystem::isFileReadOnly(const StringBuf& absoluteFilePath)
-            {
-                /*auto attr = ::GetFileAttributesW(absoluteFilePath.c_str());
-                if (attr == INVALID_FILE_ATTRIBUTES)
-                    return false;
+        close(srcHandle);
+        close(destHandle);
 
-                // Check attribute
-                return (attr & FILE_ATTRIBUTE_READONLY) != 0;*/
-                return false;
-            }
+        if (!ok)
+        {
+            unlink(destStr.c_str());
+            return false;
+        }
 
-            bool POSIXIOSystem::readOnlyFlag(const StringBuf& absoluteFilePath, bool flag)
-            {
-                /*auto attr = ::GetFileAttributesW(absoluteFilePath.c_str());
-                auto srcAttr = attr;
+        // file copied
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileCopy '{}' to '{}', {}", srcAbsolutePath, destAbsolutePath, timer);
+        return true;
+    }
 
-                // Change read only flag
-                if (flag)
-                    attr |= FILE_ATTRIBUTE_READONLY;
-                else
-                    attr &= ~FILE_ATTRIBUTE_READONLY;
+    bool POSIXIOSystem::moveFile(StringView srcAbsolutePath, StringView destAbsolutePath)
+    {
+        ScopeTimer timer;
 
-                // same ?
-                if (attr == srcAttr)
-                    return true;
+        // Make sure target path exists
+        if (!createPath(destAbsolutePath))
+        {
+            TRACE_WARNING("POSIXIO: FileMove unable to create target path for file \"{}\"", destAbsolutePath);
+            return false;
+        }
+
+        // Move the file, existing destination file is replaced
+        const auto srcStr = StringBuf(srcAbsolutePath);
+        const auto destStr = StringBuf(destAbsolutePath);
+        if (0 != rename(srcStr.c_str(), destStr.c_str()))
+        {
+            TRACE_WARNING("POSIXIO: Unable to move file \"{}\" to \"{}\": {}", srcAbsolutePath, destAbsolutePath, strerror(errno));
+            return false;
+        }
 
-                if (SetFileAttributes(absoluteFilePath.c_str(), attr) != 0)
-                {
-                    TRACE_WARNING("unable to set read-only attribute of file \"{}\"", absoluteFilePath);
-                    return false;
-                }*/
+        // File moved
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileMove '{}' to '{}', {}", srcAbsolutePath, destAbsolutePath, timer);
+        return true;
+    }
 
-                return true;
-            }
+    bool POSIXIOSystem::deleteFile(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
+        if (0 != unlink(str.c_str()))
+        {
+            TRACE_WARNING("POSIXIO: Unable to delete file '{}', error: {}", absoluteFilePath, strerror(errno));
+            return false;
+        }
 
-            void POSIXIOSystem::findFiles(const StringBuf& absoluteFilePath, const wchar_t* searchPattern, Array< StringBuf >& absoluteFiles, bool recurse)
-            {
-                for (POSIXFileIterator it(absoluteFilePath, searchPattern, true, false); it; ++it)
-                    absoluteFiles.pushBack(it.filePath());
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileDelete '{}'", absoluteFilePath);
+        return true;
+    }
 
-                // Recurse to directories
-                if (recurse)
-                {
-                    for (POSIXFileIterator it(absoluteFilePath, L"*.", false, true); it; ++it)
-                    {
-                        auto newAbsoluteFilePath = absoluteFilePath.addDir(UTF16StringVector(it.fileName()));
-                        findFiles(newAbsoluteFilePath, searchPattern, absoluteFiles, recurse);
-                    }
-                }
-            }
+    bool POSIXIOSystem::deleteDir(StringView absoluteDirPath)
+    {
+        const auto str = StringBuf(absoluteDirPath);
+        if (0 != rmdir(str.c_str()))
+        {
+            TRACE_WARNING("POSIXIO: Unable to delete directory '{}', error: {}", absoluteDirPath, strerror(errno));
+            return false;
+        }
 
-            void POSIXIOSystem::findSubDirs(const StringBuf& absoluteFilePath, Array< UTF16StringVector >& outDirectoryNames)
-            {
-                for (POSIXFileIterator it(absoluteFilePath, L"*.", false, true); it; ++it)
-                    outDirectoryNames.emplaceBack(it.fileName());
-            }
+        if (GTraceIO) TRACE_INFO("POSIXIO: DirectoryDelete '{}'", absoluteDirPath);
+        return true;
+    }
 
-            void POSIXIOSystem::findLocalFiles(const StringBuf& absoluteFilePath, const wchar_t* searchPattern, Array< UTF16StringVector >& outFileNames)
-            {
-                for (POSIXFileIterator it(absoluteFilePath, searchPattern, true, false); it; ++it)
-                    outFileNames.emplaceBack(it.fileName());
-            }
+    bool POSIXIOSystem::fileExists(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-            static UTF16StringVector GetHomeDirectory()
-            {
-                const char *homedir;
-                if ((homedir = getenv("HOME")) == NULL)
-                    homedir = getpwuid(getuid())->pw_dir;
+        struct stat st;
+        const auto exists = (0 == stat(str.c_str(), &st)) && !S_ISDIR(st.st_mode);
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileExists '{}': {}", absoluteFilePath, exists);
 
-                UTF16StringVector ret(homedir);
-                ret += "/";
-                return ret;
-            }
+        return exists;
+    }
 
-            StringBuf POSIXIOSystem::systemPath(PathCategory category)
-            {
-                char buffer[512];
+    bool POSIXIOSystem::isFileReadOnly(StringView absoluteFilePath)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-                switch (category)
-                {
-                    case PathCategory::ExecutableFile:
-                    {
-                        auto length = readlink("/proc/self/exe", buffer, 512);
-                        buffer[length] = 0;
-                        return StringBuf::Build(UTF16StringVector(buffer));
-                    }
+        struct stat st;
+        if (0 != stat(str.c_str(), &st))
+            return false;
 
-                    case PathCategory::ExecutableDir:
-                    {
-                        return systemPath(PathCategory::ExecutableFile).basePath();
-                    }
+        const auto readOnly = 0 == (st.st_mode & (S_IWUSR | S_IWGRP | S_IWOTH));
+        if (GTraceIO) TRACE_INFO("POSIXIO: FileReadOnly '{}': {}", absoluteFilePath, readOnly);
 
-                    case PathCategory::TempDir:
-                    {
-                        auto path = StringBuf::Build("/var/tmp/BoomerEngine/");
-                        createPath(path);
-                        return path;
-                    }
+        return readOnly;
+    }
 
-                    case PathCategory::UserConfigDir:
-                    {
-                        auto path = StringBuf::Build(GetHomeDirectory());
-                        return path.addDir(L"BoomerEngine").addDir(L"config");
-                    }
-                }
+    bool POSIXIOSystem::readOnlyFlag(StringView absoluteFilePath, bool flag)
+    {
+        const auto str = StringBuf(absoluteFilePath);
 
-                return StringBuf();
-            }
+        // nothing to change on a file that does not exist yet
+        struct stat st;
+        if (0 != stat(str.c_str(), &st))
+            return true;
+
+        // Change read only flag, clearing it only gives the write access back to the owner
+        auto mode = st.st_mode & ALLPERMS;
+        if (flag)
+            mode &= ~(S_IWUSR | S_IWGRP | S_IWOTH);
+        else if (0 == (mode & (S_IWUSR | S_IWGRP | S_IWOTH)))
+            mode |= S_IWUSR;
+
+        // same ?
+        if (mode == (st.st_mode & ALLPERMS))
+            return true;
+
+        if (0 != chmod(str.c_str(), mode))
+        {
+            TRACE_WARNING("POSIXIO: Unable to set read-only attribute of file \"{}\": {}", absoluteFilePath, strerror(errno));
+            return false;
+        }
+
+        if (GTraceIO) TRACE_INFO("POSIXIO: SetFileReadOnly '{}': {}", absoluteFilePath, flag);
+        return true;
+    }
 
-            DirectoryWatcherPtr POSIXIOSystem::createDirectoryWatcher(const StringBuf& path)
+    bool POSIXIOSystem::findFilesInternal(const StringBuf& dirPath, StringView searchPattern, const std::function<bool(StringView fullPath, StringView fileName)>& enumFunc, bool recurse)
+    {
+        StringBuilder fullPath;
+
+        for (POSIXFileIterator it(dirPath.c_str(), searchPattern, true, false); it; ++it)
+        {
+            const auto* fileName = it.fileName();
+
+            fullPath.clear();
+            fullPath << dirPath;
+            fullPath << fileName;
+
+            if (enumFunc(fullPath.view(), fileName))
+                return true;
+        }
+
+        if (recurse)
+        {
+            for (POSIXFileIterator it(dirPath.c_str(), "*.", false, true); it; ++it)
             {
-                return RefNew<POSIXDirectoryWatcher>(path);
+                const auto subDirPath = StringBuf(TempString("{}{}/", dirPath, it.fileName()));
+                if (findFilesInternal(subDirPath, searchPattern, enumFunc, recurse))
+                    return true;
             }
+        }
 
-            void POSIXIOSystem::showFileExplorer(const StringBuf& path)
-            {
-                // TODO: add support for soemthing more than Ubuntu :(
+        return false;
+    }
 
-                auto command = BaseTempString<4096>("nautilus -w {}", path.c_str());
-                TRACE_INFO("Executing command '{}'", command.c_str());
-                FILE *f = popen(command.c_str(), "r");
-                fclose(f);
-            }
+    static StringBuf DirectoryPath(StringView absoluteFilePath)
+    {
+        if (absoluteFilePath.endsWith("/"))
+            return StringBuf(absoluteFilePath);
 
-            static void AppenFormatStrings(StringBuilder& builder, const Array<FileFormat>& formats, bool allowMultipleFormats)
-            {
-                if (!formats.empty())
-                {
-                    if (allowMultipleFormats && (formats.size() > 1))
-                    {
-                        StringBuilder formatDisplayString;
-                        StringBuilder formatFilterString;
+        return TempString("{}/", absoluteFilePath);
+    }
 
-                        for (auto &format : formats)
-                        {
-                            formatFilterString.appendf(" | *.{}", format.extension());
+    bool POSIXIOSystem::findFiles(StringView absoluteFilePath, StringView searchPattern, const std::function<bool(StringView fullPath, StringView fileName)>& enumFunc, bool recurse)
+    {
+        if (absoluteFilePath.empty())
+            return false;
 
-                            if (!formatDisplayString.empty())
-                                formatDisplayString.append(",");
-                            formatDisplayString.appendf("*.{}", format.extension());
-                        }
+        return findFilesInternal(DirectoryPath(absoluteFilePath), searchPattern, enumFunc, recurse);
+    }
 
-                        builder.appendf("--file-filter=\"All supported formats | {}\" ", formatFilterString.c_str());
-                    }
+    bool POSIXIOSystem::findSubDirs(StringView absoluteFilePath, const std::function<bool(StringView name)>& enumFunc)
+    {
+        const auto dirPath = StringBuf(absoluteFilePath);
+        for (POSIXFileIterator it(dirPath.c_str(), "*.", false, true); it; ++it)
+            if (enumFunc(it.fileName()))
+                return true;
 
-                    for (auto &format : formats)
-                        builder.appendf("--file-filter=\"{} [*.{}] | *.{}\" ", format.description(), format.extension(), format.extension());
+        return false;
+    }
 
-                    if (allowMultipleFormats)
-                        builder.append("--file-filter=\"All files [*.*] | *.*\" ");
-                }
+    bool POSIXIOSystem::findLocalFiles(StringView absoluteFilePath, StringView searchPattern, const std::function<bool(StringView name)>& enumFunc)
+    {
+        const auto dirPath = StringBuf(absoluteFilePath);
+        for (POSIXFileIterator it(dirPath.c_str(), searchPattern, true, false); it; ++it)
+            if (enumFunc(it.fileName()))
+                return true;
+
+        return false;
+    }
+
+    static const char* GetHomeDirectory()
+    {
+        if (const auto* homeDir = getenv("HOME"))
+            return homeDir;
+
+        if (const auto* info = getpwuid(getuid()))
+            return info->pw_dir;
+
+        return "/tmp";
+    }
+
+    static bool GetExecutablePath(char* path, uint32_t maxLength)
+    {
+        auto length = readlink("/proc/self/exe", path, maxLength - 1);
+        if (length <= 0)
+        {
+            path[0] = 0;
+            return false;
+        }
+
+        path[length] = 0;
+        return true;
+    }
+
+    void POSIXIOSystem::systemPath(PathCategory category, IFormatStream& f)
+    {
+        char path[PATH_MAX + 1];
+
+        switch (category)
+        {
+            case PathCategory::ExecutableFile:
+            {
+                GetExecutablePath(path, sizeof(path));
+                f << path;
+                break;
             }
 
-            static void SliceString(const wchar_t* str, wchar_t breakCh, Array< UTF16StringVector >& outTokens)
+            case PathCategory::ExecutableDir:
             {
-                const wchar_t* start = str;
-                for (;; )
+                GetExecutablePath(path, sizeof(path));
+
+                if (auto* ch = strrchr(path, '/'))
+                    ch[1] = 0;
+
+                f << path;
+                break;
+            }
+
+            case PathCategory::EngineDir:
+            {
+                GetExecutablePath(path, sizeof(path));
+
+                for (;;)
                 {
-                    // get the char from the text
-                    wchar_t ch = *str;
+                    auto* ch = strrchr(path, '/');
+                    if (!ch)
+                        break;
 
-                    // it's a break char
-                    if (ch == breakCh)
-                    {
-                        // emit token
-                        auto length = str - start;
-                        outTokens.emplaceBack(start, (uint32_t)length);
+                    ch[1] = 0;
+                    if (strlen(path) + strlen("project.xml") > PATH_MAX)
+                        break;
 
-                        // next token can start after this char
-                        start = str + 1;
-                    }
+                    strcat(ch, "project.xml");
 
-                    // that was it
-                    if (!*str )
+                    struct stat st;
+                    const auto exists = (0 == stat(path, &st)) && !S_ISDIR(st.st_mode);
+                    if (!exists)
                     {
-                        // emit final token
-                        auto length = str - start;
-                        outTokens.emplaceBack(start, (uint32_t)length);
+                        ch[0] = 0;
+                    }
+                    else
+                    {
+                        ch[1] = 0;
+                        f << path;
                         break;
                     }
-
-                    // move to next char
-                    str += 1;
                 }
+
+                break;
             }
 
-            bool POSIXIOSystem::showFileOpenDialog(uint64_t nativeWindowHandle, bool allowMultiple, const Array<FileFormat>& formats, Array<StringBuf>& outPaths, OpenSavePersistentData& persistentData)
+            case PathCategory::SystemTempDir:
             {
-                //zenity --file-selection --filename=dupa --multiple --file-filter="Portable Network Graphics [*.png] | *.png" --file-filter="Zip [*.zip] | *.zip"
+                const auto* tempDir = getenv("TMPDIR");
+                if (!tempDir || !*tempDir)
+                    tempDir = "/tmp";
+
+                f << tempDir;
+                if (tempDir[strlen(tempDir) - 1] != '/')
+                    f << "/";
+                f << "Boomer/";
+                break;
+            }
 
-                // change directory
-                if (!persistentData.m_directory.empty())
-                {
-                    StringBuf ansiPath(persistentData.m_directory.c_str());
-                    if (0 != chdir(ansiPath.c_str()))
-                    {
-                        TRACE_WARNING("Failed to enter directory {}'", persistentData.m_directory);
-                    }
-                }
+            case PathCategory::LocalTempDir:
+            {
+                GetExecutablePath(path, sizeof(path));
 
-                // format command
-                StringBuilder builder;
-                builder.appendf("zenity --file-selection --modal --attach={} ", nativeWindowHandle);
-                if (allowMultiple)
-                    builder.append("--multiple ");
+                if (auto* ch = strrchr(path, '/'))
+                    ch[1] = 0;
 
-                AppenFormatStrings(builder, formats, true);
+                f << path;
+                f << ".temp/local/";
+                break;
+            }
 
-                // get command
-                auto command = builder.toString();
-                TRACE_INFO("Executing command '{}'", command);
+            case PathCategory::UserConfigDir:
+            {
+                f << GetHomeDirectory();
+                f << "/.config/Boomer/";
+                break;
+            }
 
-                // show the dialog
-                FILE *f = popen(command.c_str(), "r");
-                if (NULL == f)
-                    return false;
+            case PathCategory::UserDocumentsDir:
+            {
+                f << GetHomeDirectory();
+                f << "/";
+                break;
+            }
+        }
+    }
 
-                // parse result
-                Array<char> buffer;
-                buffer.reserve(65536);
-                while (!feof(f))
-                {
-                    // load data from stream
-                    char data[4096];
-                    if (!fgets(data, sizeof(data), f))
-                        break;
+    DirectoryWatcherPtr POSIXIOSystem::createDirectoryWatcher(StringView path)
+    {
+        return RefNew<prv::POSIXDirectoryWatcher>(DirectoryPath(path));
+    }
 
-                    auto read = data;
-                    while (*read && *read != '\n')
-                        buffer.pushBack(*read++);
+    //--
 
-                    if (*read == '\n')
-                        break;
-                }
-                buffer.pushBack(0);
+    namespace helper
+    {
+        static void RunCommand(StringView command)
+        {
+            TRACE_INFO("POSIXIO: Executing command '{}'", command);
 
-                // convert to unicode
-                auto uniString = UTF16StringVector(buffer.typedData());
-                Array<UTF16StringVector> paths;
-                SliceString(uniString.c_str(), '|', paths);
+            const auto str = StringBuf(command);
+            if (auto* f = popen(str.c_str(), "r"))
+                pclose(f);
+        }
 
-                // emit paths
-                for (auto& path : paths)
+        static void AppendFormatStrings(StringBuilder& builder, const Array<FileFormat>& formats, bool allowMultipleFormats)
+        {
+            if (!formats.empty())
+            {
+                if (allowMultipleFormats && (formats.size() > 1))
                 {
-                    auto finalPath = StringBuf::Build(path);
-                    if (!finalPath.empty())
-                        outPaths.pushBack(finalPath);
-                }
+                    StringBuilder formatFilterString;
+                    for (auto& format : formats)
+                        formatFilterString.appendf(" *.{}", format.extension());
 
-                // update the directory
-                if (!outPaths.empty())
-                {
-                    persistentData.m_directory = outPaths[0].basePath();
-                    persistentData.m_filterExtension = StringBuf(outPaths[0].fileExtensions().c_str());
+                    builder.appendf("--file-filter=\"All supported files |{}\" ", formatFilterString.view());
                 }
 
-                // true if we have at least one valid path
-                return !outPaths.empty();
+                for (auto& format : formats)
+                    builder.appendf("--file-filter=\"{} [*.{}] | *.{}\" ", format.description(), format.extension(), format.extension());
             }
 
-            bool POSIXIOSystem::showFileSaveDialog(uint64_t nativeWindowHandle, const UTF16StringVector& currentFileName, const Array<FileFormat>& formats, StringBuf& outPath, OpenSavePersistentData& persistentData)
-            {
-                // change directory
-                if (!persistentData.m_directory.empty())
-                {
-                    StringBuf ansiPath(persistentData.m_directory.c_str());
-                    if (0 != chdir(ansiPath.c_str()))
-                    {
-                        TRACE_WARNING("Failed to enter directory {}'", persistentData.m_directory);
-                    }
-                }
+            if (allowMultipleFormats || formats.empty())
+                builder.append("--file-filter=\"All files | *\" ");
+        }
 
-                // format command
-                StringBuilder builder;
-                builder.appendf("zenity --file-selection --modal --save --attach={} ", nativeWindowHandle);
-                if (!currentFileName.empty())
-                    builder.appendf("--filename=\"{}\" ", currentFileName);
-                AppenFormatStrings(builder, formats, false);
+        static bool ReadCommandOutput(StringView command, StringBuf& outText)
+        {
+            TRACE_INFO("POSIXIO: Executing command '{}'", command);
 
-                // get command
-                auto command = builder.toString();
-                TRACE_INFO("Executing command '{}'", command);
+            const auto str = StringBuf(command);
+            auto* f = popen(str.c_str(), "r");
+            if (!f)
+                return false;
 
-                // show the dialog
-                FILE *f = popen(command.c_str(), "r");
-                if (NULL == f)
-                    return false;
+            StringBuilder output;
 
-                // load data from stream
-                char data[4096];
-                if (NULL == fgets(data, sizeof(data), f))
-                    return false;
+            char data[4096];
+            while (fgets(data, sizeof(data), f))
+                output << data;
 
-                // remove the '\n'
-                char* ptr = data;
-                while (*ptr != 0)
-                {
-                    if (*ptr == '\n')
-                    {
-                        *ptr = 0;
-                        break;
-                    }
+            // non zero exit code means the dialog was canceled
+            const auto ret = pclose(f);
+            if (ret != 0)
+                return false;
 
-                    ++ptr;
-                }
+            outText = StringBuf(output.view().beforeFirstOrFull("\n").trim());
+            return !outText.empty();
+        }
 
-                // convert to path
-                auto path = StringBuf::Build(UTF16StringVector(data));
-                if (path.empty())
-                    return false;
+    } // helper
 
-                // update the directory
-                persistentData.m_directory = path.basePath();
-                persistentData.m_filterExtension = StringBuf(path.fileExtensions().c_str());
+    void POSIXIOSystem::showFileExplorer(StringView path)
+    {
+        // open the containing directory with whatever file manager is registered
+        const auto dirPath = path.endsWith("/") ? path : path.beforeLast("/");
+        helper::RunCommand(TempString("xdg-open \"{}\" &", dirPath));
+    }
 
-                // valid save path selected
-                outPath = path;
-                return true;
-            }
+    bool POSIXIOSystem::showFileOpenDialog(uint64_t nativeWindowHandle, bool allowMultiple, const Array<FileFormat>& formats, Array<StringBuf>& outPaths, OpenSavePersistentData& persistentData)
+    {
+        // format command
+        StringBuilder builder;
+        builder.append("zenity --file-selection --modal --separator=\"|\" ");
+        if (allowMultiple)
+            builder.append("--multiple ");
+        if (!persistentData.directory.empty())
+            builder.appendf("--filename=\"{}/\" ", persistentData.directory);
+        helper::AppendFormatStrings(builder, formats, true);
+
+        // show the dialog
+        StringBuf result;
+        if (!helper::ReadCommandOutput(builder.view(), result))
+            return false;
+
+        // emit paths
+        Array<StringView> paths;
+        result.view().slice("|", false, paths);
+        for (const auto& path : paths)
+            outPaths.emplaceBack(path);
+
+        // update the directory
+        if (!outPaths.empty())
+        {
+            persistentData.directory = outPaths[0].stringBeforeLast("/");
+            persistentData.filterExtension = outPaths[0].stringAfterLast(".");
+        }
 
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+        return !outPaths.empty();
+    }
+
+    bool POSIXIOSystem::showFileSaveDialog(uint64_t nativeWindowHandle, const StringBuf& currentFileName, const Array<FileFormat>& formats, StringBuf& outPath, OpenSavePersistentData& persistentData)
+    {
+        // format command
+        StringBuilder builder;
+        builder.append("zenity --file-selection --modal --save --confirm-overwrite ");
+        if (!currentFileName.empty())
+            builder.appendf("--filename=\"{}{}\" ", persistentData.directory.empty() ? "" : TempString("{}/", persistentData.directory).c_str(), currentFileName);
+        else if (!persistentData.directory.empty())
+            builder.appendf("--filename=\"{}/\" ", persistentData.directory);
+        helper::AppendFormatStrings(builder, formats, false);
+
+        // show the dialog
+        StringBuf path;
+        if (!helper::ReadCommandOutput(builder.view(), path))
+            return false;
+
+        // update the directory
+        persistentData.directory = path.stringBeforeLast("/");
+        persistentData.filterExtension = path.stringAfterLast(".");
+
+        // valid save path selected
+        outPath = path;
+        return true;
+    }
+
+} // prv
+
+END_BOOMER_NAMESPACE()
@@ -9,59 +9,66 @@
 
 #pragma once
 
-#include "ioSystem.h"
 #include "fileSystem.h"
-#include "ioFileHandle.h"
+#include "fileHandle.h"
 
-namespace base
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
 {
-    namespace io
+
+    class POSIXAsyncReadDispatcher;
+
+    // the IO system implementation for Linux based systems
+    class POSIXIOSystem : public ISystemHandler, public ISingleton
     {
-        namespace prv
-        {
-
-            class POSIXAsyncReadDispatcher;
-
-            // the IO system implementation for Linux based systems
-            class POSIXIOSystem : public ISystemHandler
-            {
-            public:
-                POSIXIOSystem();
-                virtual ~POSIXIOSystem();
-
-                virtual bool servicesPath(const StringBuf& absoluteFilePath) override final;
-
-                virtual FileHandlePtr openForReading(const StringBuf& absoluteFilePath) override final;
-                virtual FileHandlePtr openForWriting(const StringBuf& absoluteFilePath, bool append) override final;
-                virtual FileHandlePtr openForReadingAndWriting(const StringBuf& absoluteFilePath, bool resetContent = false) override final;
-
-                virtual bool fileSize(const StringBuf& absoluteFilePath, uint64_t& outFileSize) override final;
-                virtual bool fileTimeStamp(const StringBuf& absoluteFilePath, class TimeStamp& outTimeStamp) override final;
-                virtual bool createPath(const StringBuf& absoluteFilePath) override final;
-                virtual bool moveFile(const StringBuf& srcStringBuf, const StringBuf& destStringBuf) override final;
-                virtual bool deleteFile(const StringBuf& absoluteFilePath) override final;
-                virtual bool deleteDir(const StringBuf& absoluteDirPath) override final;
-                virtual bool touchFile(const StringBuf& absoluteFilePath) override final;
-                virtual bool fileExists(const StringBuf& absoluteFilePath) override final;
-                virtual bool isFileReadOnly(const StringBuf& absoluteFilePath) override final;
-                virtual bool readOnlyFlag(const StringBuf& absoluteFilePath, bool flag) override final;
-                virtual void findFiles(const StringBuf& absoluteFilePath, const wchar_t* searchPattern, Array< StringBuf >& absoluteFiles, bool recurse) override final;
-                virtual void findSubDirs(const StringBuf& absoluteFilePath, Array< UTF16StringVector >& outDirectoryNames) override final;
-                virtual void findLocalFiles(const StringBuf& absoluteFilePath, const wchar_t* searchPattern, Array< UTF16StringVector >& outFileNames) override final;
-
-                virtual void rootPaths(Array<BrowsableRoot>& outRoots) override final;
-                virtual StringBuf systemPath(PathCategory category) override final;
-                virtual DirectoryWatcherPtr createDirectoryWatcher(const StringBuf& path) override final;
-
-                virtual void showFileExplorer(const StringBuf& path) override final;
-                virtual bool showFileOpenDialog(uint64_t nativeWindowHandle, bool allowMultiple, const Array<FileFormat>& formats, Array<StringBuf>& outPaths, OpenSavePersistentData& persistentData) override final;
-                virtual bool showFileSaveDialog(uint64_t nativeWindowHandle, const UTF16StringVector& currentFileName, const Array<FileFormat>& formats, StringBuf& outPath, OpenSavePersistentData& persistentData) override final;
-
-            private:
-                UniquePtr<POSIXAsyncReadDispatcher> m_asyncDispatcher;
-                StringBuf m_rootPath;
-            };
-
-        } // prv
-    } // io
-} // base
\ No newline at end of file
+        DECLARE_SINGLETON(POSIXIOSystem);
+
+    public:
+        POSIXIOSystem();
+
+        virtual ReadFileHandlePtr openForReading(StringView absoluteFilePath) override final;
+        virtual WriteFileHandlePtr openForWriting(StringView absoluteFilePath, FileWriteMode mode = FileWriteMode::StagedWrite) override final;
+        virtual AsyncFileHandlePtr openForAsyncReading(StringView absoluteFilePath) override final;
+
+        virtual Buffer loadIntoMemoryForReading(StringView absoluteFilePath) override final;
+        virtual Buffer openMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint) override final;
+
+        virtual bool fileSize(StringView absoluteFilePath, uint64_t& outFileSize) override final;
+        virtual bool fileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, uint64_t* outFileSize) override final;
+        virtual bool fileIdentity(StringView absoluteFilePath, FileIdentity& outIdentity) override final;
+        virtual bool createPath(StringView absoluteFilePath) override final;
+        virtual bool moveFile(StringView srcAbsolutePath, StringView destAbsolutePath) override final;
+        virtual bool copyFile(StringView srcAbsolutePath, StringView destAbsolutePath) override final;
+        virtual bool deleteFile(StringView absoluteFilePath) override final;
+        virtual bool deleteDir(StringView absoluteDirPath) override final;
+        virtual bool touchFile(StringView absoluteFilePath) override final;
+        virtual bool fileExists(StringView absoluteFilePath) override final;
+        virtual bool isFileReadOnly(StringView absoluteFilePath) override final;
+        virtual bool readOnlyFlag(StringView absoluteFilePath, bool flag) override final;
+        virtual bool findFiles(StringView absoluteFilePath, StringView searchPattern, const std::function<bool(StringView fullPath, StringView fileName)>& enumFunc, bool recurse) override final;
+        virtual bool findSubDirs(StringView absoluteFilePath, const std::function<bool(StringView name)>& enumFunc) override final;
+        virtual bool findLocalFiles(StringView absoluteFilePath, StringView searchPattern, const std::function<bool(StringView name)>& enumFunc) override final;
+
+        virtual void systemPath(PathCategory category, IFormatStream& f) override final;
+        virtual DirectoryWatcherPtr createDirectoryWatcher(StringView path) override final;
+
+        virtual void showFileExplorer(StringView path) override final;
+        virtual bool showFileOpenDialog(uint64_t nativeWindowHandle, bool allowMultiple, const Array<FileFormat>& formats, Array<StringBuf>& outPaths, OpenSavePersistentData& persistentData) override final;
+        virtual bool showFileSaveDialog(uint64_t nativeWindowHandle, const StringBuf& currentFileName, const Array<FileFormat>& formats, StringBuf& outPath, OpenSavePersistentData& persistentData) override final;
+
+        //--
+
+        WriteFileHandlePtr openForWriting(const char* absoluteFilePath, bool append);
+
+    private:
+        POSIXAsyncReadDispatcher* m_asyncDispatcher;
+
+        virtual void deinit() override;
+
+        bool findFilesInternal(const StringBuf& dirPath, StringView searchPattern, const std::function<bool(StringView fullPath, StringView fileName)>& enumFunc, bool recurse);
+    };
+
+} // prv
+
+END_BOOMER_NAMESPACE()
@@ -446,7 +446,7 @@ namespace prv
 
     //--
 
-    Buffer WinIOSystem::openMemoryMappedForReading(StringView absoluteFilePath)
+    Buffer WinIOSystem::openMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint)
     {
         // TODO: right now just read into memory buffer
         return loadIntoMemoryForReading(absoluteFilePath);
@@ -555,6 +555,33 @@ namespace prv
         return false;
     }
 
+    bool WinIOSystem::fileIdentity(StringView absoluteFilePath, FileIdentity& outIdentity)
+    {
+        TempPathStringBuffer str(absoluteFilePath);
+
+        // Open file, no access is required to query the information
+        HANDLE hHandle = CreateFileW(str, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        // Get all the information at once
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!::GetFileInformationByHandle(hHandle, &info))
+        {
+            ::CloseHandle(hHandle);
+            return false;
+        }
+
+        ::CloseHandle(hHandle);
+
+        outIdentity.fileId = (((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow) ^ ((uint64_t)info.dwVolumeSerialNumber << 48);
+        outIdentity.size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+        outIdentity.timestamp = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+
+        if (GTraceIO) TRACE_INFO("WinIO: FileIdentity '{}': ID {}, size {}, time {}", absoluteFilePath, Hex(outIdentity.fileId), outIdentity.size, TimeStamp(outIdentity.timestamp));
+        return true;
+    }
+
     bool WinIOSystem::touchFile(StringView absoluteFilePath)
     {
         return true; // TODO
@@ -33,10 +33,11 @@ namespace prv
         virtual AsyncFileHandlePtr openForAsyncReading(StringView absoluteFilePath) override final;
 
         virtual Buffer loadIntoMemoryForReading(StringView absoluteFilePath) override final;
-        virtual Buffer openMemoryMappedForReading(StringView absoluteFilePath) override final;
+        virtual Buffer openMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint) override final;
 
         virtual bool fileSize(StringView absoluteFilePath, uint64_t& outFileSize) override final;
         virtual bool fileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, uint64_t* outFileSize) override final;
+        virtual bool fileIdentity(StringView absoluteFilePath, FileIdentity& outIdentity) override final;
         virtual bool createPath(StringView absoluteFilePath) override final;
         virtual bool moveFile(StringView srcAbsolutePath, StringView destAbsolutePath) override final;
         virtual bool copyFile(StringView srcAbsolutePath, StringView destAbsolutePath) override final;
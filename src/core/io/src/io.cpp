@@ -41,9 +41,9 @@ AsyncFileHandlePtr OpenForAsyncReading(StringView absoluteFilePath)
     return NativeHandlerClass::GetInstance().openForAsyncReading(absoluteFilePath);
 }
 
-Buffer OpenMemoryMappedForReading(StringView absoluteFilePath)
+Buffer OpenMemoryMappedForReading(StringView absoluteFilePath, FileMappingHint hint /*= FileMappingHint::Normal*/)
 {
-    return NativeHandlerClass::GetInstance().openMemoryMappedForReading(absoluteFilePath);
+    return NativeHandlerClass::GetInstance().openMemoryMappedForReading(absoluteFilePath, hint);
 }
 
 Buffer LoadFileToBuffer(StringView absoluteFilePath)
@@ -61,6 +61,11 @@ bool FileTimeStamp(StringView absoluteFilePath, class TimeStamp& outTimeStamp, u
     return NativeHandlerClass::GetInstance().fileTimeStamp(absoluteFilePath, outTimeStamp, outFileSize);
 }
 
+bool FileIdentityInfo(StringView absoluteFilePath, FileIdentity& outIdentity)
+{
+    return NativeHandlerClass::GetInstance().fileIdentity(absoluteFilePath, outIdentity);
+}
+
 bool CreatePath(StringView absoluteFilePath)
 {
     return NativeHandlerClass::GetInstance().createPath(absoluteFilePath);
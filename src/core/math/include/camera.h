@@ -213,6 +213,31 @@ struct CORE_MATH_API VisibilityBox
     bool isInFrustum(const VisibilityFrustum& f) const;
 };
 
+/// packed (SoA) list of visibility boxes, tested against the frustum 4 at a time
+struct CORE_MATH_API VisibilityBoxList
+{
+    Array<float> minX, minY, minZ;
+    Array<float> maxX, maxY, maxZ;
+
+    INLINE uint32_t size() const { return minX.size(); }
+
+    // remove all boxes
+    void reset();
+
+    // add box at the end of the list
+    void add(const Box& box);
+
+    // update box at given index
+    void update(uint32_t index, const Box& box);
+
+    // remove box at given index, last box is moved in its place (same as Array::eraseUnordered)
+    void removeUnordered(uint32_t index);
+
+    // test range of boxes against the frustum, writes 1 for every box that is inside and 0 for the rest
+    // NOTE: same results as VisibilityBox::isInFrustum, ranges can be tested in parallel
+    void testFrustum(const VisibilityFrustum& f, uint32_t first, uint32_t count, uint8_t* outVisible) const;
+};
+
 //--
 
 END_BOOMER_NAMESPACE()
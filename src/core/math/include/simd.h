@@ -361,6 +361,9 @@ public:
     //! checks if all four components are non zero, usually used with the cmpXX or maskXX
     INLINE bool isAllSet() const;
 
+    //! get bit mask (Mask_X - Mask_W) of components with the sign bit set, usually used with the cmpXX or maskXX
+    INLINE uint32_t signMask() const;
+
     //! check if value is negative
     INLINE bool isNegative() const;
 
@@ -805,6 +805,11 @@ INLINE bool SIMDQuad::isAllSet() const
     return Mask_All != _mm_movemask_ps(quad);
 }
 
+INLINE uint32_t SIMDQuad::signMask() const
+{
+    return _mm_movemask_ps(quad);
+}
+
 INLINE bool SIMDQuad::isAnyMaskSet(MaskValue m) const
 {
     return 0 != (_mm_movemask_ps(quad) & m);
@@ -394,4 +394,115 @@ bool VisibilityBox::isInFrustum(const VisibilityFrustum& f) const
 
 ///--
 
+void VisibilityBoxList::reset()
+{
+    minX.reset();
+    minY.reset();
+    minZ.reset();
+    maxX.reset();
+    maxY.reset();
+    maxZ.reset();
+}
+
+void VisibilityBoxList::add(const Box& box)
+{
+    minX.pushBack(box.min.x);
+    minY.pushBack(box.min.y);
+    minZ.pushBack(box.min.z);
+    maxX.pushBack(box.max.x);
+    maxY.pushBack(box.max.y);
+    maxZ.pushBack(box.max.z);
+}
+
+void VisibilityBoxList::update(uint32_t index, const Box& box)
+{
+    minX[index] = box.min.x;
+    minY[index] = box.min.y;
+    minZ[index] = box.min.z;
+    maxX[index] = box.max.x;
+    maxY[index] = box.max.y;
+    maxZ[index] = box.max.z;
+}
+
+void VisibilityBoxList::removeUnordered(uint32_t index)
+{
+    minX.eraseUnordered(index);
+    minY.eraseUnordered(index);
+    minZ.eraseUnordered(index);
+    maxX.eraseUnordered(index);
+    maxY.eraseUnordered(index);
+    maxZ.eraseUnordered(index);
+}
+
+void VisibilityBoxList::testFrustum(const VisibilityFrustum& f, uint32_t first, uint32_t count, uint8_t* outVisible) const
+{
+    DEBUG_CHECK_RETURN(first + count <= size());
+
+    // box is outside if the corner that is furthest along the plane normal is behind any of the planes
+    // select that corner once for each plane, it's the same for all boxes
+    struct PlaneSetup
+    {
+        const float* x = nullptr;
+        const float* y = nullptr;
+        const float* z = nullptr;
+        SIMDQuad nx, ny, nz, d;
+    };
+
+    PlaneSetup planes[VisibilityFrustum::MAX_PLANES];
+    for (uint32_t i = 0; i < VisibilityFrustum::MAX_PLANES; ++i)
+    {
+        const auto& plane = f.planes[i];
+        planes[i].x = (plane[0] >= 0.0f) ? maxX.typedData() : minX.typedData();
+        planes[i].y = (plane[1] >= 0.0f) ? maxY.typedData() : minY.typedData();
+        planes[i].z = (plane[2] >= 0.0f) ? maxZ.typedData() : minZ.typedData();
+        planes[i].nx = plane.x();
+        planes[i].ny = plane.y();
+        planes[i].nz = plane.z();
+        planes[i].d = plane.w();
+    }
+
+    // 4 boxes at a time
+    const auto last = first + count;
+    auto index = first;
+    while (index + 4 <= last)
+    {
+        SIMDQuad outside;
+        for (const auto& plane : planes)
+        {
+            const auto dist = plane.nx * SIMDQuad(plane.x + index) + plane.ny * SIMDQuad(plane.y + index) + plane.nz * SIMDQuad(plane.z + index) + plane.d;
+            outside |= dist.maskL();
+        }
+
+        const auto mask = outside.signMask();
+        outVisible[0] = !(mask & Mask_X);
+        outVisible[1] = !(mask & Mask_Y);
+        outVisible[2] = !(mask & Mask_Z);
+        outVisible[3] = !(mask & Mask_W);
+
+        outVisible += 4;
+        index += 4;
+    }
+
+    // remaining boxes
+    while (index < last)
+    {
+        bool inside = true;
+        for (uint32_t i = 0; i < VisibilityFrustum::MAX_PLANES; ++i)
+        {
+            const auto& plane = f.planes[i];
+            const auto dist = plane[0] * planes[i].x[index] + plane[1] * planes[i].y[index] + plane[2] * planes[i].z[index] + plane[3];
+            if (dist < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+
+        *outVisible++ = inside;
+        index += 1;
+    }
+}
+
+///--
+
 END_BOOMER_NAMESPACE()
@@ -0,0 +1,171 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+#include "camera.h"
+#include "mathRandom.h"
+
+#include "core/test/include/gtest/gtest.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+DECLARE_TEST_FILE(Camera);
+
+//--
+
+static void SetupTestFrustum(VisibilityFrustum& outFrustum, const Angles& rotation)
+{
+    CameraSetup setup;
+    setup.position = Vector3(10.0f, -20.0f, 5.0f);
+    setup.rotation = rotation.toQuat();
+    setup.fov = 75.0f;
+    setup.nearPlane = 0.1f;
+    setup.farPlane = 300.0f;
+
+    Camera camera;
+    camera.setup(setup);
+
+    outFrustum.setup(camera);
+}
+
+static void SetupRandomBoxes(uint32_t count, Array<VisibilityBox>& outBoxes, VisibilityBoxList& outList)
+{
+    FastRandState rand(42);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto center = Vector3(rand.range(-500.0, 500.0), rand.range(-500.0, 500.0), rand.range(-100.0, 100.0));
+        const auto extents = Vector3(rand.range(0.1, 10.0), rand.range(0.1, 10.0), rand.range(0.1, 10.0));
+        const auto box = Box(center - extents, center + extents);
+
+        outBoxes.emplaceBack().setup(box);
+        outList.add(box);
+    }
+}
+
+TEST(VisibilityBoxList, SameResultsAsSingleBoxTest)
+{
+    Array<VisibilityBox> boxes;
+    VisibilityBoxList list;
+    SetupRandomBoxes(10003, boxes, list); // not a multiple of 4 on purpose
+
+    const Angles rotations[] = { Angles(0.0f, 0.0f, 0.0f), Angles(-30.0f, 45.0f, 0.0f), Angles(60.0f, 200.0f, 10.0f) };
+    for (const auto& rotation : rotations)
+    {
+        VisibilityFrustum frustum;
+        SetupTestFrustum(frustum, rotation);
+
+        Array<uint8_t> visible;
+        visible.resizeWith(list.size(), 2);
+        list.testFrustum(frustum, 0, list.size(), visible.typedData());
+
+        uint32_t numVisible = 0;
+        for (auto i : boxes.indexRange())
+        {
+            ASSERT_EQ(boxes[i].isInFrustum(frustum), visible[i] != 0) << "Box " << i;
+            numVisible += visible[i];
+        }
+
+        EXPECT_NE(0, numVisible);
+        EXPECT_NE(list.size(), numVisible);
+    }
+}
+
+TEST(VisibilityBoxList, PartialRangeTest)
+{
+    Array<VisibilityBox> boxes;
+    VisibilityBoxList list;
+    SetupRandomBoxes(1000, boxes, list);
+
+    VisibilityFrustum frustum;
+    SetupTestFrustum(frustum, Angles(-30.0f, 45.0f, 0.0f));
+
+    Array<uint8_t> visible;
+    visible.resizeWith(list.size(), 2);
+
+    // test in odd sized ranges, like the parallel culling does
+    for (uint32_t first = 0; first < list.size(); first += 77)
+    {
+        const auto count = std::min<uint32_t>(77, list.size() - first);
+        list.testFrustum(frustum, first, count, visible.typedData() + first);
+    }
+
+    for (auto i : boxes.indexRange())
+        ASSERT_EQ(boxes[i].isInFrustum(frustum), visible[i] != 0) << "Box " << i;
+}
+
+TEST(VisibilityBoxList, RemoveUnorderedKeepsBoxesInSync)
+{
+    VisibilityBoxList list;
+    list.add(Box(Vector3(0, 0, 0), Vector3(1, 1, 1)));
+    list.add(Box(Vector3(1, 1, 1), Vector3(2, 2, 2)));
+    list.add(Box(Vector3(2, 2, 2), Vector3(3, 3, 3)));
+
+    list.removeUnordered(0);
+    ASSERT_EQ(2, list.size());
+    EXPECT_EQ(2.0f, list.minX[0]);
+    EXPECT_EQ(3.0f, list.maxZ[0]);
+    EXPECT_EQ(1.0f, list.minY[1]);
+    EXPECT_EQ(2.0f, list.maxY[1]);
+}
+
+//--
+
+static void TestCullingPerformance(uint32_t count)
+{
+    Array<VisibilityBox> boxes;
+    VisibilityBoxList list;
+    SetupRandomBoxes(count, boxes, list);
+
+    VisibilityFrustum frustum;
+    SetupTestFrustum(frustum, Angles(-30.0f, 45.0f, 0.0f));
+
+    Array<uint8_t> visible;
+    visible.resize(count);
+
+    static const uint32_t NUM_ITERATIONS = 10;
+
+    uint32_t checkSingle = 0;
+    TimingStatistics statsSingle;
+    for (uint32_t j = 0; j < NUM_ITERATIONS; ++j)
+    {
+        ScopeTimer timer;
+        for (const auto& box : boxes)
+            checkSingle += box.isInFrustum(frustum);
+        statsSingle.update(timer.timeElapsed());
+    }
+
+    uint32_t checkList = 0;
+    TimingStatistics statsList;
+    for (uint32_t j = 0; j < NUM_ITERATIONS; ++j)
+    {
+        ScopeTimer timer;
+        list.testFrustum(frustum, 0, count, visible.typedData());
+        statsList.update(timer.timeElapsed());
+
+        for (const auto flag : visible)
+            checkList += flag;
+    }
+
+    EXPECT_EQ(checkSingle, checkList);
+
+    TRACE_WARNING("Culling {} boxes: single {}, packed {} ({}x), {} visible", count,
+        TimeInterval(statsSingle.mean()), TimeInterval(statsList.mean()), Prec(statsSingle.mean() / statsList.mean(), 2), checkList / NUM_ITERATIONS);
+}
+
+TEST(VisibilityBoxList, Perf_Culling100K)
+{
+    TestCullingPerformance(100000);
+}
+
+TEST(VisibilityBoxList, Perf_Culling1M)
+{
+    TestCullingPerformance(1000000);
+}
+
+END_BOOMER_NAMESPACE()
@@ -26,7 +26,7 @@ public:
     //--
 
     static const uint64_t BUFFER_SYSTEM_MEMORY_MIN_SIZE = 4 * 1024 * 1024; // buffer size that is allocated directly from system, bypassing any allocator we have
-    static const uint64_t BUFFER_SYSTEM_MEMORY_LARGE_PAGES_SIZE = 128 * 1024 * 1024; // buffer size that is allocated directly from system, bypassing any allocator we have
+    static const uint64_t BUFFER_SYSTEM_MEMORY_LARGE_PAGES_SIZE = 128 * 1024 * 1024; // buffer size that is allocated with large pages (if available)
     static const uint32_t BUFFER_DEFAULT_ALIGNMNET = 16; // buffers are usually big, this is useful alignment
 
     //--
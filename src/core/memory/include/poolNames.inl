@@ -4,6 +4,10 @@
 * Source code licensed under LGPL 3.0 license
 ***/
 
+// BOOMER_DECLARE_POOL(name, group, budget) - budget is the max size of the pool in MB, enforced only by the pool allocator
+// NOTE: 0 means unlimited - the pool shares the common arena and is only tracked in the pool stats
+// NOTE: no pool has a budget by default, right values depend on the game and platform so they are set with SetPoolBudget() by the application
+
 #ifdef BOOMER_DECLARE_POOL
 
 BOOMER_DECLARE_POOL(POOL_DEFAULT, "Core", 0)
@@ -38,9 +42,11 @@ BOOMER_DECLARE_POOL(POOL_MEM_BUFFER, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_EXTERNAL_BUFFER_TAG, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_ASYNC_BUFFER, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_SYSTEM_MEMORY, "Core", 0)
+BOOMER_DECLARE_POOL(POOL_SYSTEM_LARGE_PAGES, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_ZLIB, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_LZ4, "Core", 0)
 BOOMER_DECLARE_POOL(POOL_STUBS, "Core", 0)
+BOOMER_DECLARE_POOL(POOL_TESTS, "Core", 0)
 
 BOOMER_DECLARE_POOL(POOL_IO, "IO", 0)
 BOOMER_DECLARE_POOL(POOL_IO_OUTSTANDING, "IO", 0)
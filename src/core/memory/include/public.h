@@ -31,6 +31,26 @@ BEGIN_BOOMER_NAMESPACE()
 
 //--
 
+// Allocator used for the AllocateBlock/FreeBlock, selected at startup with the BOOMER_ALLOCATOR environment variable ("ansi", "pool", "debug")
+enum class AllocatorType : uint8_t
+{
+    Ansi, // pass-through to the CRT
+    Pool, // size class slabs with thread caches, pool budgets are enforced
+    Debug, // overrun/underrun checks and leak tracking
+};
+
+// get the allocator that is used
+extern CORE_MEMORY_API AllocatorType CurrentAllocatorType();
+
+// set max allowed size for given memory pool, allocations over the budget will fail (only in the pool allocator)
+// NOTE: 0 means unlimited (pool is still tracked separately), pools with the size specified in the poolNames.inl get the budget (in MB) at startup
+extern CORE_MEMORY_API void SetPoolBudget(PoolTag id, uint64_t maxSize);
+
+// release memory cached by current thread in the allocator, should be called before thread exits
+extern CORE_MEMORY_API void FinishThreadAllocTracking();
+
+//--
+
 // print memory leaks
 extern CORE_MEMORY_API void DumpMemoryLeaks();
 
@@ -39,8 +59,15 @@ extern CORE_MEMORY_API void ValidateHeap();
 
 //--
 
+//! Get size of the normal memory page in the system
+extern CORE_MEMORY_API size_t SystemPageSize();
+
+//! Get size of the large memory page in the system, 0 if not supported
+extern CORE_MEMORY_API size_t SystemLargePageSize();
+
 //! Allocate page of memory directly from the system
-//! NOTE: this memory is not tracked
+//! NOTE: large pages are used only for allocations of at least one large page, if they are not available normal pages are used
+//! NOTE: memory is reported in POOL_SYSTEM_MEMORY or POOL_SYSTEM_LARGE_PAGES with the size actually granted by the system
 extern CORE_MEMORY_API void* AllocSystemMemory(size_t size, bool largePages);
 
 //! Free page of memory directly to the system
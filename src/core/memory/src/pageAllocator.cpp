@@ -60,8 +60,7 @@ void PageAllocator::initialize(PoolTag pool /*= POOL_TEMP*/, uint32_t pageSize /
     ASSERT_EX(m_pageSize == 0, "Page allocator already initialized");
 
     // align page size to system size
-    // TODO: get system page size
-    const auto systemPageSize = 4096;
+    const auto systemPageSize = (uint32_t)SystemPageSize();
     m_pageSize = Align<uint32_t>(pageSize, systemPageSize);
     m_maxFreePagesToRetain = freePagesToKeep;
     m_poolID = pool;
@@ -71,7 +70,7 @@ void PageAllocator::initialize(PoolTag pool /*= POOL_TEMP*/, uint32_t pageSize /
     if (preallocatedPages)
     {
         const auto memorySize = (uint64_t)m_pageSize * (uint64_t)preallocatedPages; // we may have > 4GB in pages...
-        const auto largePages = false;// memorySize >= (256ULL << 20); // arbitrary choice..
+        const auto largePages = SystemLargePageSize() && (memorySize >= SystemLargePageSize()); // preallocated memory is never released, good candidate for large pages
         m_preallocatedMemoryStart = (uint8_t*)AllocSystemMemory(memorySize, largePages);
         m_preallocatedMemoryEnd = m_preallocatedMemoryStart + memorySize;
 
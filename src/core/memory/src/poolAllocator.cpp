@@ -0,0 +1,713 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: allocator\pool #]
+***/
+
+#include "build.h"
+#include "poolAllocator.h"
+#include "ansiAllocator.h"
+#include "poolStatsInternal.h"
+
+#include "core/system/include/scopeLock.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+namespace helper
+{
+    // NOTE: must stay a POD, it's in the TLS
+    struct PoolThreadCacheBin
+    {
+        void* head;
+        uint32_t count;
+    };
+
+    struct PoolThreadCache
+    {
+        PoolThreadCacheBin bins[PoolAllocator::NUM_SIZE_CLASSES];
+        uint32_t state; // 0 - not initialized, 1 - active, 2 - thread is exiting, cache is not used any more
+    };
+
+    static TYPE_TLS PoolThreadCache GPoolThreadCache;
+
+    static_assert(POOL_MAX <= 256, "Pool of the block in the shared arena is stored in one byte");
+
+    // returns the cached blocks when the thread exits
+    struct PoolThreadCacheReleaser
+    {
+        PoolAllocator* owner = nullptr;
+
+        ~PoolThreadCacheReleaser()
+        {
+            if (owner)
+                owner->releaseThreadCache();
+            GPoolThreadCache.state = 2;
+        }
+    };
+
+    static thread_local PoolThreadCacheReleaser GPoolThreadCacheReleaser;
+
+    // budgets (in MB) declared in the pool list
+    static const uint32_t GPoolBudgetsMB[] =
+    {
+#define BOOMER_DECLARE_POOL(name, group, size) size,
+#include "poolNames.inl"
+    };
+
+} // helper
+
+//--
+
+PoolAllocator::PoolAllocator()
+    : m_slabPages(POOL_ALLOCATOR, SLAB_SIZE, 0, 16)
+{
+    // size classes: 16 byte steps up to 128, then 4 steps per power of two
+    {
+        uint32_t index = 0;
+        for (uint32_t size = 16; size <= 128; size += 16)
+            m_classSizes[index++] = size;
+
+        for (uint32_t base = 128; base < MAX_SMALL_BLOCK_SIZE; base *= 2)
+            for (uint32_t step = 1; step <= 4; ++step)
+                m_classSizes[index++] = base + (base / 4) * step;
+
+        ASSERT(index == NUM_SIZE_CLASSES);
+    }
+
+    // lookup for the size class
+    {
+        uint32_t classIndex = 0;
+        for (uint32_t i = 0; i < ARRAY_COUNT(m_classForSize); ++i)
+        {
+            while (m_classSizes[classIndex] < i * 16)
+                classIndex += 1;
+            m_classForSize[i] = (uint8_t)classIndex;
+        }
+    }
+
+    // limit the thread cache to around 16KB of blocks per size class
+    for (uint32_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        m_classCacheLimits[i] = std::clamp<uint32_t>(16384 / m_classSizes[i], 4, 64);
+
+    // root of the slab map, reserved memory is not committed until used
+    m_slabMap = (std::atomic<SlabMapLeaf*>*)AllocSystemMemory(sizeof(std::atomic<SlabMapLeaf*>) << SLAB_MAP_ROOT_BITS, false);
+
+    for (auto& arena : m_poolArenas)
+        arena = nullptr;
+
+    // pools with budgets specified in the pool list get dedicated arenas from the start
+    for (uint32_t i = 0; i < ARRAY_COUNT(helper::GPoolBudgetsMB); ++i)
+        if (helper::GPoolBudgetsMB[i])
+            setPoolBudget((PoolTag)i, (uint64_t)helper::GPoolBudgetsMB[i] << 20);
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    // NOTE: allocator lives until the end of the process, memory is reclaimed by the OS
+}
+
+//--
+
+void* PoolAllocator::allocate(PoolTag id, size_t size, size_t alignment, const char* typeName)
+{
+    auto& arena = arenaForPool(id);
+
+    if (size <= MAX_SMALL_BLOCK_SIZE && alignment <= MAX_SMALL_BLOCK_ALIGNMENT)
+    {
+        auto* ret = allocateSmall(arena, sizeClassForSize(size ? size : 1));
+
+#ifndef BUILD_FINAL
+        // dedicated arenas report to the stats on their own
+        if (ret && !arena.dedicated)
+            notifySharedAllocation(findSlab(ret), ret, id);
+#endif
+
+        return ret;
+    }
+
+    return allocateLarge(arena.dedicated ? &arena : nullptr, id, size, alignment, typeName);
+}
+
+void PoolAllocator::deallocate(void* mem)
+{
+    if (mem)
+    {
+        if (auto* slab = findSlab(mem))
+        {
+            if (!slab->arena->dedicated)
+                notifySharedFree(slab, mem);
+
+            freeSmall(slab, mem);
+        }
+        else
+        {
+            freeLarge(mem);
+        }
+    }
+}
+
+void* PoolAllocator::reallocate(PoolTag id, void* mem, size_t newSize, size_t alignment, const char* typeName)
+{
+    if (newSize == 0)
+    {
+        deallocate(mem);
+        return nullptr;
+    }
+    else if (mem == nullptr)
+    {
+        return allocate(id, newSize, alignment, typeName);
+    }
+
+    // get the size of the current block, reuse it if the new size still fits
+    uint64_t currentSize = 0;
+    if (auto* slab = findSlab(mem))
+    {
+        currentSize = slab->blockSize;
+        if (newSize <= currentSize && alignment <= MAX_SMALL_BLOCK_ALIGNMENT && slab->arena == &arenaForPool(id))
+        {
+            // block may change the pool
+            if (!slab->arena->dedicated)
+            {
+                notifySharedFree(slab, mem);
+                notifySharedAllocation(slab, mem, id);
+            }
+
+            return mem;
+        }
+    }
+    else
+    {
+        const auto* header = LargeBlockHeaderFromPtr(mem);
+        currentSize = header->size;
+        if (newSize == currentSize && ((uint64_t)mem & (alignment - 1)) == 0)
+            return mem;
+    }
+
+    auto* ret = allocate(id, newSize, alignment, typeName);
+    if (ret)
+    {
+        memcpy(ret, mem, std::min<uint64_t>(currentSize, newSize));
+        deallocate(mem);
+    }
+
+    return ret;
+}
+
+size_t PoolAllocator::usableSize(void* mem) const
+{
+    if (!mem)
+        return 0;
+
+    if (const auto* slab = findSlab(mem))
+        return slab->blockSize;
+
+    return LargeBlockHeaderFromPtr(mem)->size;
+}
+
+//--
+
+void PoolAllocator::setPoolBudget(PoolTag id, uint64_t maxSize)
+{
+    DEBUG_CHECK_RETURN_EX(id < POOL_MAX, "Invalid pool");
+
+    {
+        auto lock = CreateLock(m_poolArenasLock);
+
+        auto* arena = m_poolArenas[id].load();
+        if (!arena)
+        {
+            arena = new Arena();
+            arena->pool = id;
+            arena->dedicated = true;
+        }
+
+        arena->budget = maxSize;
+        m_poolArenas[id].store(arena, std::memory_order_release);
+    }
+
+    prv::TheInternalPoolStats.budget(id, maxSize);
+}
+
+void PoolAllocator::releaseThreadCache()
+{
+    auto& cache = helper::GPoolThreadCache;
+    if (cache.state == 1)
+    {
+        for (uint32_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+            if (cache.bins[i].count)
+                flushThreadCache(i, cache.bins[i].count);
+    }
+}
+
+void PoolAllocator::sharedBlockCounts(size_t size, uint32_t& outNumTaken, uint32_t& outNumCachedByThisThread) const
+{
+    const auto sizeClass = sizeClassForSize(std::clamp<size_t>(size, 1, MAX_SMALL_BLOCK_SIZE));
+    outNumTaken = m_sharedArena.classes[sizeClass].numTaken;
+
+    const auto& cache = helper::GPoolThreadCache;
+    outNumCachedByThisThread = (cache.state == 1) ? cache.bins[sizeClass].count : 0;
+}
+
+//--
+
+void* PoolAllocator::allocateSmall(Arena& arena, uint32_t sizeClass)
+{
+    // dedicated arenas are not cached so the size tracking is exact
+    if (!arena.dedicated)
+    {
+        auto& cache = helper::GPoolThreadCache;
+        if (cache.state == 0)
+        {
+            cache.state = 1;
+            helper::GPoolThreadCacheReleaser.owner = this;
+        }
+
+        if (cache.state == 1)
+        {
+            auto& bin = cache.bins[sizeClass];
+            if (!bin.head)
+            {
+                // refill half of the cache in one go
+                FreeBlock* blocks[64];
+                const auto count = takeBlocks(arena, sizeClass, blocks, std::max<uint32_t>(1, m_classCacheLimits[sizeClass] / 2));
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    blocks[i]->next = (FreeBlock*)bin.head;
+                    bin.head = blocks[i];
+                }
+                bin.count += count;
+            }
+
+            if (auto* block = (FreeBlock*)bin.head)
+            {
+                bin.head = block->next;
+                bin.count -= 1;
+                return block;
+            }
+
+            return nullptr;
+        }
+    }
+
+    const auto blockSize = m_classSizes[sizeClass];
+    if (arena.dedicated && !reserveArenaSize(arena, blockSize))
+        return nullptr;
+
+    FreeBlock* block = nullptr;
+    if (!takeBlocks(arena, sizeClass, &block, 1))
+    {
+        if (arena.dedicated)
+            releaseArenaSize(arena, blockSize);
+        return nullptr;
+    }
+
+    return block;
+}
+
+void PoolAllocator::freeSmall(Slab* slab, void* mem)
+{
+    auto* block = (FreeBlock*)mem;
+    auto& arena = *slab->arena;
+
+    if (!arena.dedicated)
+    {
+        auto& cache = helper::GPoolThreadCache;
+        if (cache.state == 1)
+        {
+            // NOTE: block may have been allocated on different thread, that's fine, it's returned to the right slab when flushed
+            auto& bin = cache.bins[slab->sizeClass];
+            block->next = (FreeBlock*)bin.head;
+            bin.head = block;
+            bin.count += 1;
+
+            if (bin.count > m_classCacheLimits[slab->sizeClass])
+                flushThreadCache(slab->sizeClass, bin.count / 2);
+
+            return;
+        }
+    }
+    else
+    {
+        releaseArenaSize(arena, slab->blockSize);
+    }
+
+    Slab* slabToRelease = nullptr;
+    {
+        auto& sizeClass = arena.classes[slab->sizeClass];
+        auto lock = CreateLock(sizeClass.lock);
+        slabToRelease = returnBlockLocked(sizeClass, slab, block);
+    }
+
+    releaseSlabs(slabToRelease);
+}
+
+void PoolAllocator::flushThreadCache(uint32_t sizeClassIndex, uint32_t count)
+{
+    auto& bin = helper::GPoolThreadCache.bins[sizeClassIndex];
+    auto& sizeClass = m_sharedArena.classes[sizeClassIndex];
+
+    Slab* slabsToRelease = nullptr;
+    {
+        auto lock = CreateLock(sizeClass.lock);
+
+        while (count-- && bin.head)
+        {
+            auto* block = (FreeBlock*)bin.head;
+            bin.head = block->next;
+            bin.count -= 1;
+
+            if (auto* slab = returnBlockLocked(sizeClass, findSlab(block), block))
+            {
+                slab->next = slabsToRelease;
+                slabsToRelease = slab;
+            }
+        }
+    }
+
+    releaseSlabs(slabsToRelease);
+}
+
+//--
+
+uint32_t PoolAllocator::takeBlocks(Arena& arena, uint32_t sizeClassIndex, FreeBlock** outBlocks, uint32_t count)
+{
+    auto& sizeClass = arena.classes[sizeClassIndex];
+    auto lock = CreateLock(sizeClass.lock);
+
+    uint32_t numTaken = 0;
+    while (numTaken < count)
+    {
+        auto* slab = sizeClass.partialSlabs;
+        if (!slab)
+        {
+            slab = createSlab(arena, sizeClassIndex);
+            if (!slab)
+                break;
+
+            sizeClass.numSlabs += 1;
+            slab->partial = true;
+            sizeClass.partialSlabs = slab;
+        }
+
+        if (sizeClass.emptySlab == slab)
+            sizeClass.emptySlab = nullptr;
+
+        // take blocks from free list first, carve new ones only when needed to keep the slab memory untouched as long as possible
+        while (numTaken < count && slab->numUsed < slab->numBlocks)
+        {
+            FreeBlock* block = slab->freeList;
+            if (block)
+                slab->freeList = block->next;
+            else
+                block = (FreeBlock*)(slab->data + (slab->numCarved++ * slab->blockSize));
+
+            slab->numUsed += 1;
+            outBlocks[numTaken++] = block;
+        }
+
+        // full slabs are not tracked
+        if (slab->numUsed == slab->numBlocks)
+        {
+            sizeClass.partialSlabs = slab->next;
+            if (slab->next)
+                slab->next->prev = nullptr;
+            slab->next = nullptr;
+            slab->prev = nullptr;
+            slab->partial = false;
+        }
+    }
+
+    sizeClass.numTaken += numTaken;
+    return numTaken;
+}
+
+PoolAllocator::Slab* PoolAllocator::returnBlockLocked(SizeClass& sizeClass, Slab* slab, FreeBlock* block)
+{
+    DEBUG_CHECK_EX(slab && slab->numUsed > 0, "Block not allocated from pool allocator or double free");
+
+    block->next = slab->freeList;
+    slab->freeList = block;
+    slab->numUsed -= 1;
+    sizeClass.numTaken -= 1;
+
+    // slab has free blocks again
+    if (!slab->partial)
+    {
+        slab->prev = nullptr;
+        slab->next = sizeClass.partialSlabs;
+        if (sizeClass.partialSlabs)
+            sizeClass.partialSlabs->prev = slab;
+        sizeClass.partialSlabs = slab;
+        slab->partial = true;
+    }
+
+    if (slab->numUsed == 0)
+    {
+        // keep one empty slab around
+        if (!sizeClass.emptySlab)
+        {
+            sizeClass.emptySlab = slab;
+            return nullptr;
+        }
+
+        // unlink the slab, it will be released outside the lock
+        if (slab->prev)
+            slab->prev->next = slab->next;
+        else
+            sizeClass.partialSlabs = slab->next;
+        if (slab->next)
+            slab->next->prev = slab->prev;
+
+        slab->prev = nullptr;
+        slab->next = nullptr;
+        slab->partial = false;
+        sizeClass.numSlabs -= 1;
+        return slab;
+    }
+
+    return nullptr;
+}
+
+PoolAllocator::Slab* PoolAllocator::createSlab(Arena& arena, uint32_t sizeClass)
+{
+    auto* page = (uint8_t*)m_slabPages.allocatePage();
+    if (!page)
+        return nullptr;
+
+    // slab header is at the start of the page
+    const auto headerSize = Align<uint32_t>(sizeof(Slab), 64);
+
+    auto* slab = new (page) Slab();
+    slab->arena = &arena;
+    slab->sizeClass = sizeClass;
+    slab->blockSize = m_classSizes[sizeClass];
+
+#ifndef BUILD_FINAL
+    // blocks in the shared arena come from different pools, one byte per block after the header remembers the pool for the stats
+    if (!arena.dedicated)
+    {
+        slab->numBlocks = (SLAB_SIZE - headerSize - 16) / (slab->blockSize + 1);
+        slab->pools = page + headerSize;
+        slab->data = page + Align<uint32_t>(headerSize + slab->numBlocks, 16);
+    }
+    else
+#endif
+    {
+        slab->numBlocks = (SLAB_SIZE - headerSize) / slab->blockSize;
+        slab->data = page + headerSize;
+    }
+
+    registerSlab(slab, slab);
+    return slab;
+}
+
+void PoolAllocator::releaseSlabs(Slab* slabList)
+{
+    while (slabList)
+    {
+        auto* next = slabList->next;
+        registerSlab(slabList, nullptr);
+        m_slabPages.freePage(slabList);
+        slabList = next;
+    }
+}
+
+//--
+
+PoolAllocator::LargeBlockHeader* PoolAllocator::LargeBlockHeaderFromPtr(void* mem)
+{
+    auto* header = (LargeBlockHeader*)mem - 1;
+    ASSERT_EX(header->marker == LARGE_BLOCK_MARKER, "Block not allocated from pool allocator or memory corruption");
+    return header;
+}
+
+void* PoolAllocator::allocateLarge(Arena* arena, PoolTag id, size_t size, size_t alignment, const char* typeName)
+{
+    if (arena && !reserveArenaSize(*arena, size))
+        return nullptr;
+
+    // header is placed right before the returned pointer
+    const auto blockAlignment = std::max<size_t>(alignment, 16);
+    const auto headerSize = Align<size_t>(sizeof(LargeBlockHeader), blockAlignment);
+    const auto totalSize = Align<size_t>(headerSize + size, blockAlignment);
+
+    auto* systemBlock = (uint8_t*)AnsiAllocator::allocate(id, totalSize, blockAlignment, typeName);
+    if (!systemBlock)
+    {
+        if (arena)
+            releaseArenaSize(*arena, size);
+        return nullptr;
+    }
+
+    auto* ret = systemBlock + headerSize;
+    auto* header = (LargeBlockHeader*)ret - 1;
+    header->systemBlock = systemBlock;
+    header->arena = arena;
+    header->size = size;
+    header->pool = id;
+    header->marker = LARGE_BLOCK_MARKER;
+
+    // dedicated arenas reported the size when it was reserved
+    if (!arena)
+        prv::TheInternalPoolStats.notifyAllocation(id, size);
+
+    return ret;
+}
+
+void PoolAllocator::freeLarge(void* mem)
+{
+    auto* header = LargeBlockHeaderFromPtr(mem);
+    header->marker = 0;
+
+    if (header->arena)
+        releaseArenaSize(*header->arena, header->size);
+    else
+        prv::TheInternalPoolStats.notifyFree((PoolTag)header->pool, header->size);
+
+    AnsiAllocator::deallocate(header->systemBlock);
+}
+
+//--
+
+bool PoolAllocator::reserveArenaSize(Arena& arena, uint64_t size)
+{
+    auto used = arena.usedSize.load();
+    for (;;)
+    {
+        const auto newUsed = used + size;
+        if (arena.budget && newUsed > arena.budget)
+        {
+            TRACE_ERROR("Pool {} is over budget: allocating {} with {} already used out of {}", PoolName(arena.pool), MemSize(size), MemSize(used), MemSize(arena.budget));
+            return false;
+        }
+
+        if (arena.usedSize.compare_exchange_weak(used, newUsed))
+        {
+            // high water mark
+            auto peak = arena.peakSize.load();
+            while (peak < newUsed && !arena.peakSize.compare_exchange_weak(peak, newUsed)) {};
+            break;
+        }
+    }
+
+    arena.numAllocations += 1;
+    prv::TheInternalPoolStats.notifyAllocation(arena.pool, size);
+    return true;
+}
+
+void PoolAllocator::releaseArenaSize(Arena& arena, uint64_t size)
+{
+    arena.usedSize -= size;
+    arena.numAllocations -= 1;
+    prv::TheInternalPoolStats.notifyFree(arena.pool, size);
+}
+
+void PoolAllocator::notifySharedAllocation(Slab* slab, void* mem, PoolTag id)
+{
+#ifndef BUILD_FINAL
+    const auto blockIndex = ((uint8_t*)mem - slab->data) / slab->blockSize;
+    slab->pools[blockIndex] = (uint8_t)id;
+    prv::TheInternalPoolStats.notifyAllocation(id, slab->blockSize);
+#endif
+}
+
+void PoolAllocator::notifySharedFree(Slab* slab, void* mem)
+{
+#ifndef BUILD_FINAL
+    const auto blockIndex = ((uint8_t*)mem - slab->data) / slab->blockSize;
+    prv::TheInternalPoolStats.notifyFree((PoolTag)slab->pools[blockIndex], slab->blockSize);
+#endif
+}
+
+//--
+
+std::atomic<PoolAllocator::Slab*>* PoolAllocator::slabMapEntry(uint64_t address, bool create)
+{
+    const auto rootIndex = address >> (SLAB_MAP_LEAF_BITS + SLAB_MAP_PAGE_BITS);
+    const auto leafIndex = (address >> SLAB_MAP_PAGE_BITS) & ((1U << SLAB_MAP_LEAF_BITS) - 1);
+    DEBUG_CHECK_RETURN_EX_V(rootIndex < (1ULL << SLAB_MAP_ROOT_BITS), "Address outside the supported range", nullptr);
+
+    auto* leaf = m_slabMap[rootIndex].load(std::memory_order_acquire);
+    if (!leaf && create)
+    {
+        auto lock = CreateLock(m_slabMapLock);
+
+        leaf = m_slabMap[rootIndex].load(std::memory_order_acquire);
+        if (!leaf)
+        {
+            // NOTE: leaves are never released, each one covers 256MB of address space
+            leaf = (SlabMapLeaf*)AllocSystemMemory(sizeof(SlabMapLeaf), false);
+            m_slabMap[rootIndex].store(leaf, std::memory_order_release);
+        }
+    }
+
+    return leaf ? &(*leaf)[leafIndex] : nullptr;
+}
+
+void PoolAllocator::registerSlab(Slab* slab, Slab* value)
+{
+    const auto baseAddress = (uint64_t)slab;
+    for (uint32_t offset = 0; offset < SLAB_SIZE; offset += (1U << SLAB_MAP_PAGE_BITS))
+        if (auto* entry = slabMapEntry(baseAddress + offset, true))
+            entry->store(value, std::memory_order_release);
+}
+
+PoolAllocator::Slab* PoolAllocator::findSlab(const void* ptr) const
+{
+    const auto address = (uint64_t)ptr;
+    const auto rootIndex = address >> (SLAB_MAP_LEAF_BITS + SLAB_MAP_PAGE_BITS);
+    if (rootIndex >= (1ULL << SLAB_MAP_ROOT_BITS))
+        return nullptr;
+
+    if (const auto* leaf = m_slabMap[rootIndex].load(std::memory_order_acquire))
+        return (*leaf)[(address >> SLAB_MAP_PAGE_BITS) & ((1U << SLAB_MAP_LEAF_BITS) - 1)].load(std::memory_order_acquire);
+
+    return nullptr;
+}
+
+//--
+
+void PoolAllocator::printLeaks()
+{
+    for (const auto& arenaPtr : m_poolArenas)
+    {
+        if (const auto* arena = arenaPtr.load())
+        {
+            if (arena->numAllocations)
+                TRACE_INFO("Pool {}: {} blocks still allocated ({}), peak usage {}, budget {}", PoolName(arena->pool),
+                    arena->numAllocations.load(), MemSize(arena->usedSize.load()), MemSize(arena->peakSize.load()), MemSize(arena->budget));
+        }
+    }
+
+    for (uint32_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+    {
+        const auto& sizeClass = m_sharedArena.classes[i];
+        if (sizeClass.numSlabs > (sizeClass.emptySlab ? 1U : 0U))
+            TRACE_INFO("Size class {}: {} slabs still in use", m_classSizes[i], sizeClass.numSlabs);
+    }
+}
+
+void PoolAllocator::validateHeap(void* pointerOnHeap)
+{
+    if (pointerOnHeap)
+    {
+        if (const auto* slab = findSlab(pointerOnHeap))
+        {
+            const auto offset = (uint8_t*)pointerOnHeap - slab->data;
+            ASSERT_EX(offset >= 0 && (offset % slab->blockSize) == 0, "Pointer does not point to the start of a block");
+            ASSERT_EX(offset / slab->blockSize < slab->numCarved, "Pointer points to a block that was never allocated");
+        }
+        else
+        {
+            LargeBlockHeaderFromPtr(pointerOnHeap);
+        }
+    }
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
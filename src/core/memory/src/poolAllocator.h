@@ -0,0 +1,182 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: allocator\pool #]
+***/
+
+#pragma once
+
+#include "pageAllocator.h"
+
+#include "core/system/include/spinLock.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+/// Engine allocator, small blocks are allocated from size class slabs, big blocks go to the system allocator
+/// Each thread keeps a small cache of free blocks for every size class so most of the allocations never take a lock
+/// Pools with a budget get their own arena (separate slabs, no thread cache) with exact size tracking and a hard limit
+class PoolAllocator : public NoCopy
+{
+public:
+    PoolAllocator();
+    ~PoolAllocator();
+
+    static const uint32_t SLAB_SIZE = 65536; // size of the slab with the blocks of the same size, allocated from page allocator
+    static const uint32_t MAX_SMALL_BLOCK_SIZE = 2048; // bigger blocks are allocated directly from the system
+    static const uint32_t MAX_SMALL_BLOCK_ALIGNMENT = 16; // blocks with bigger alignment are allocated directly from the system
+    static const uint32_t NUM_SIZE_CLASSES = 24;
+
+    //--
+
+    //! Allocate memory
+    void* allocate(PoolTag id, size_t size, size_t alignment, const char* typeName);
+
+    //! Deallocate memory
+    void deallocate(void* mem);
+
+    //! Resize allocated memory block
+    void* reallocate(PoolTag id, void* mem, size_t newSize, size_t alignment, const char* typeName);
+
+    //! Get the actual size of the allocated block (may be bigger than requested)
+    size_t usableSize(void* mem) const;
+
+    //---
+
+    //! give the pool a dedicated arena with a hard budget (0 - no limit, just track the size)
+    //! NOTE: only allocations done after this call are counted in the pool's arena
+    void setPoolBudget(PoolTag id, uint64_t maxSize);
+
+    //! return blocks cached by the calling thread back to the slabs
+    void releaseThreadCache();
+
+    //! get number of blocks (of the size class used for given size) taken from the shared arena, including the ones in the thread caches, and how many of them are cached by the calling thread
+    void sharedBlockCounts(size_t size, uint32_t& outNumTaken, uint32_t& outNumCachedByThisThread) const;
+
+    //---
+
+    // print memory leaks to the output
+    void printLeaks();
+
+    // validate heap status
+    void validateHeap(void* pointerOnHeap);
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct Arena;
+
+    struct Slab
+    {
+        Arena* arena = nullptr;
+        uint32_t sizeClass = 0;
+        uint32_t blockSize = 0;
+        uint32_t numBlocks = 0;
+        uint32_t numUsed = 0; // blocks given away, including the ones sitting in the thread caches
+        uint32_t numCarved = 0; // blocks that were ever handed out, rest of the slab was never touched
+        FreeBlock* freeList = nullptr;
+        uint8_t* data = nullptr;
+        uint8_t* pools = nullptr; // pool of every block in the shared arena so the stats can be updated on free (not used in final builds)
+        Slab* prev = nullptr; // in the list of slabs with free blocks
+        Slab* next = nullptr;
+        bool partial = false; // is in the list of slabs with free blocks
+    };
+
+    struct SizeClass
+    {
+        SpinLock lock;
+        Slab* partialSlabs = nullptr; // slabs with free blocks
+        Slab* emptySlab = nullptr; // one fully free slab is kept around to avoid thrashing the page allocator
+        uint32_t numSlabs = 0;
+        uint32_t numTaken = 0; // blocks given away from the slabs
+    };
+
+    struct Arena
+    {
+        PoolTag pool = POOL_DEFAULT;
+        bool dedicated = false; // allocations from single pool, tracked and budgeted
+        uint64_t budget = 0;
+
+        std::atomic<uint64_t> usedSize = 0;
+        std::atomic<uint64_t> peakSize = 0;
+        std::atomic<uint32_t> numAllocations = 0;
+
+        SizeClass classes[NUM_SIZE_CLASSES];
+    };
+
+    struct LargeBlockHeader
+    {
+        void* systemBlock = nullptr;
+        Arena* arena = nullptr; // only set for the allocations from dedicated arenas
+        uint64_t size = 0;
+        uint32_t pool = 0; // for the stats
+        uint32_t marker = 0;
+    };
+
+    static const uint32_t LARGE_BLOCK_MARKER = 0xB16B10C5;
+
+    // slabs are found from the block address via a two level table indexed with the 4KB page number
+    // NOTE: pages from the page allocator are not aligned to the slab size so we can't just mask the address
+    static const uint32_t SLAB_MAP_PAGE_BITS = 12;
+    static const uint32_t SLAB_MAP_LEAF_BITS = 16;
+    static const uint32_t SLAB_MAP_ROOT_BITS = 48 - SLAB_MAP_LEAF_BITS - SLAB_MAP_PAGE_BITS;
+
+    typedef std::atomic<Slab*> SlabMapLeaf[1U << SLAB_MAP_LEAF_BITS];
+
+    Arena m_sharedArena;
+    std::atomic<Arena*> m_poolArenas[POOL_MAX];
+    SpinLock m_poolArenasLock;
+
+    PageAllocator m_slabPages;
+
+    std::atomic<SlabMapLeaf*>* m_slabMap = nullptr;
+    SpinLock m_slabMapLock;
+
+    uint32_t m_classSizes[NUM_SIZE_CLASSES];
+    uint32_t m_classCacheLimits[NUM_SIZE_CLASSES];
+    uint8_t m_classForSize[(MAX_SMALL_BLOCK_SIZE / 16) + 1];
+
+    //--
+
+    INLINE Arena& arenaForPool(PoolTag id)
+    {
+        auto* arena = m_poolArenas[id].load(std::memory_order_acquire);
+        return arena ? *arena : m_sharedArena;
+    }
+
+    INLINE uint32_t sizeClassForSize(size_t size) const
+    {
+        return m_classForSize[(size + 15) >> 4];
+    }
+
+    void* allocateSmall(Arena& arena, uint32_t sizeClass);
+    void freeSmall(Slab* slab, void* mem);
+
+    uint32_t takeBlocks(Arena& arena, uint32_t sizeClass, FreeBlock** outBlocks, uint32_t count);
+    Slab* returnBlockLocked(SizeClass& sizeClass, Slab* slab, FreeBlock* block);
+
+    Slab* createSlab(Arena& arena, uint32_t sizeClass);
+    void releaseSlabs(Slab* slabList);
+
+    void* allocateLarge(Arena* arena, PoolTag id, size_t size, size_t alignment, const char* typeName);
+    void freeLarge(void* mem);
+    static LargeBlockHeader* LargeBlockHeaderFromPtr(void* mem);
+
+    bool reserveArenaSize(Arena& arena, uint64_t size);
+    void releaseArenaSize(Arena& arena, uint64_t size);
+
+    void notifySharedAllocation(Slab* slab, void* mem, PoolTag id);
+    void notifySharedFree(Slab* slab, void* mem);
+
+    std::atomic<Slab*>* slabMapEntry(uint64_t address, bool create);
+    void registerSlab(Slab* slab, Slab* value);
+    Slab* findSlab(const void* ptr) const;
+
+    void flushThreadCache(uint32_t sizeClass, uint32_t count);
+};
+
+END_BOOMER_NAMESPACE()
@@ -0,0 +1,299 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+#include "poolAllocator.h"
+#include "poolStats.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/system/include/thread.h"
+
+DECLARE_TEST_FILE(PoolAllocator);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    // NOTE: thread caches are shared by all pool allocators, the test one is never destroyed and tests release the caches when done
+    static PoolAllocator& TestAllocator()
+    {
+        static auto* allocator = new PoolAllocator();
+        return *allocator;
+    }
+
+    // global pool allocator would use the same thread caches
+    static bool CanTestPoolAllocator()
+    {
+        return CurrentAllocatorType() != AllocatorType::Pool;
+    }
+
+    static uint64_t PoolSize(PoolTag pool)
+    {
+        PoolStatsData stats;
+        PoolStats(pool, stats);
+        return stats.m_totalSize;
+    }
+
+} // helper
+
+TEST(PoolAllocator, SmallBlocksFitSizeClasses)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+
+    for (size_t size = 1; size <= PoolAllocator::MAX_SMALL_BLOCK_SIZE; ++size)
+    {
+        auto* mem = allocator.allocate(POOL_TESTS, size, 16, nullptr);
+        ASSERT_NE(nullptr, mem);
+        EXPECT_EQ(0, (uint64_t)mem & 15) << "Size " << size;
+
+        // waste is limited by the size class spacing
+        const auto blockSize = allocator.usableSize(mem);
+        EXPECT_GE(blockSize, size);
+        EXPECT_LE(blockSize, size + std::max<size_t>(15, size / 4)) << "Size " << size;
+
+        memset(mem, 0xCD, size);
+        allocator.validateHeap(mem);
+        allocator.deallocate(mem);
+    }
+
+    allocator.releaseThreadCache();
+}
+
+TEST(PoolAllocator, LargeAndAlignedBlocks)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+
+    // too big for the size classes
+    auto* big = allocator.allocate(POOL_TESTS, 100000, 16, nullptr);
+    ASSERT_NE(nullptr, big);
+    EXPECT_EQ(0, (uint64_t)big & 15);
+    EXPECT_EQ(100000, allocator.usableSize(big));
+    memset(big, 0xCD, 100000);
+
+    // small but alignment is too big for the size classes
+    auto* aligned = allocator.allocate(POOL_TESTS, 100, 256, nullptr);
+    ASSERT_NE(nullptr, aligned);
+    EXPECT_EQ(0, (uint64_t)aligned & 255);
+
+    allocator.validateHeap(big);
+    allocator.validateHeap(aligned);
+    allocator.deallocate(big);
+    allocator.deallocate(aligned);
+}
+
+TEST(PoolAllocator, ReallocateKeepsContent)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+
+    auto* mem = (uint8_t*)allocator.allocate(POOL_TESTS, 100, 16, nullptr);
+    ASSERT_NE(nullptr, mem);
+    for (uint32_t i = 0; i < 100; ++i)
+        mem[i] = (uint8_t)i;
+
+    // shrinking stays in the same block
+    EXPECT_EQ(mem, allocator.reallocate(POOL_TESTS, mem, 50, 16, nullptr));
+
+    // growing to big block moves the data
+    auto* grown = (uint8_t*)allocator.reallocate(POOL_TESTS, mem, 10000, 16, nullptr);
+    ASSERT_NE(nullptr, grown);
+    for (uint32_t i = 0; i < 50; ++i)
+        ASSERT_EQ(i, grown[i]);
+
+    EXPECT_EQ(nullptr, allocator.reallocate(POOL_TESTS, grown, 0, 16, nullptr));
+
+    allocator.releaseThreadCache();
+}
+
+TEST(PoolAllocator, ThreadCacheRefillAndFlush)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+    allocator.releaseThreadCache();
+
+    static const size_t BLOCK_SIZE = 48;
+    static const uint32_t NUM_BLOCKS = 300;
+
+    uint32_t baseTaken = 0, cached = 0;
+    allocator.sharedBlockCounts(BLOCK_SIZE, baseTaken, cached);
+    EXPECT_EQ(0, cached);
+
+    // first allocation takes more blocks from the slabs than needed, rest waits in the cache
+    void* blocks[NUM_BLOCKS];
+    blocks[0] = allocator.allocate(POOL_TESTS, BLOCK_SIZE, 16, nullptr);
+    ASSERT_NE(nullptr, blocks[0]);
+
+    uint32_t taken = 0;
+    allocator.sharedBlockCounts(BLOCK_SIZE, taken, cached);
+    EXPECT_LT(0, cached);
+    EXPECT_EQ(baseTaken + cached + 1, taken);
+
+    for (uint32_t i = 1; i < NUM_BLOCKS; ++i)
+    {
+        blocks[i] = allocator.allocate(POOL_TESTS, BLOCK_SIZE, 16, nullptr);
+        ASSERT_NE(nullptr, blocks[i]);
+    }
+
+    // freed blocks go to the cache, the cache is bounded so most of them go back to the slabs
+    for (uint32_t i = 0; i < NUM_BLOCKS; ++i)
+        allocator.deallocate(blocks[i]);
+
+    allocator.sharedBlockCounts(BLOCK_SIZE, taken, cached);
+    EXPECT_LT(0, cached);
+    EXPECT_GT(NUM_BLOCKS / 2, cached);
+    EXPECT_EQ(baseTaken + cached, taken);
+
+    // everything goes back on request
+    allocator.releaseThreadCache();
+    allocator.sharedBlockCounts(BLOCK_SIZE, taken, cached);
+    EXPECT_EQ(0, cached);
+    EXPECT_EQ(baseTaken, taken);
+}
+
+TEST(PoolAllocator, ThreadCacheReleasedOnThreadExit)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+    allocator.releaseThreadCache();
+
+    static const size_t BLOCK_SIZE = 80;
+    static const uint32_t NUM_BLOCKS = 100;
+
+    uint32_t baseTaken = 0, cached = 0;
+    allocator.sharedBlockCounts(BLOCK_SIZE, baseTaken, cached);
+
+    void* blocks[NUM_BLOCKS];
+    for (uint32_t i = 0; i < NUM_BLOCKS; ++i)
+        blocks[i] = allocator.allocate(POOL_TESTS, BLOCK_SIZE, 16, nullptr);
+
+    allocator.releaseThreadCache();
+
+    // blocks allocated here are freed on other thread, they end up in it's cache
+    {
+        Thread thread;
+
+        ThreadSetup setup;
+        setup.m_name = "PoolAllocatorTest";
+        setup.m_function = [&allocator, &blocks]()
+        {
+            auto* own = allocator.allocate(POOL_TESTS, BLOCK_SIZE, 16, nullptr);
+            allocator.deallocate(own);
+
+            for (uint32_t i = 0; i < NUM_BLOCKS; ++i)
+                allocator.deallocate(blocks[i]);
+        };
+
+        thread.init(setup);
+        thread.close();
+    }
+
+    // thread returned everything when it exited
+    uint32_t taken = 0;
+    allocator.sharedBlockCounts(BLOCK_SIZE, taken, cached);
+    EXPECT_EQ(0, cached);
+    EXPECT_EQ(baseTaken, taken);
+}
+
+#ifndef BUILD_FINAL
+TEST(PoolAllocator, SharedArenaAllocationsAreInPoolStats)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    auto& allocator = helper::TestAllocator();
+
+    const auto baseSize = helper::PoolSize(POOL_TESTS);
+
+    auto* small = allocator.allocate(POOL_TESTS, 100, 16, nullptr);
+    auto* big = allocator.allocate(POOL_TESTS, 100000, 16, nullptr);
+    EXPECT_EQ(baseSize + allocator.usableSize(small) + allocator.usableSize(big), helper::PoolSize(POOL_TESTS));
+
+    // reused block moves to the new pool
+    const auto baseOtherSize = helper::PoolSize(POOL_TEMP);
+    EXPECT_EQ(small, allocator.reallocate(POOL_TEMP, small, 50, 16, nullptr));
+    EXPECT_EQ(baseSize + allocator.usableSize(big), helper::PoolSize(POOL_TESTS));
+    EXPECT_EQ(baseOtherSize + allocator.usableSize(small), helper::PoolSize(POOL_TEMP));
+
+    allocator.deallocate(small);
+    allocator.deallocate(big);
+    EXPECT_EQ(baseSize, helper::PoolSize(POOL_TESTS));
+
+    allocator.releaseThreadCache();
+}
+#endif
+
+TEST(PoolAllocator, BudgetIsEnforced)
+{
+    if (!helper::CanTestPoolAllocator())
+        GTEST_SKIP();
+
+    // pools with budget have own arena (without thread caches) so it's safe to use separate allocator
+    PoolAllocator allocator;
+
+    static const uint64_t BUDGET = 64 * 1024;
+    static const uint32_t MAX_BLOCKS = 1024;
+    allocator.setPoolBudget(POOL_TESTS, BUDGET);
+
+    const auto baseSize = helper::PoolSize(POOL_TESTS);
+
+    // allocate until we hit the budget
+    void* blocks[MAX_BLOCKS];
+    uint32_t numBlocks = 0;
+    uint64_t totalSize = 0;
+    while (numBlocks < MAX_BLOCKS)
+    {
+        auto* mem = allocator.allocate(POOL_TESTS, 100, 16, nullptr);
+        if (!mem)
+            break;
+
+        totalSize += allocator.usableSize(mem);
+        blocks[numBlocks++] = mem;
+    }
+
+    ASSERT_LT(numBlocks, MAX_BLOCKS);
+    EXPECT_LE(totalSize, BUDGET);
+    EXPECT_GT(totalSize + 128, BUDGET);
+
+    // big blocks are counted as well
+    EXPECT_EQ(nullptr, allocator.allocate(POOL_TESTS, 10000, 16, nullptr));
+
+    // freed memory can be used again
+    allocator.deallocate(blocks[--numBlocks]);
+    blocks[numBlocks] = allocator.allocate(POOL_TESTS, 100, 16, nullptr);
+    EXPECT_NE(nullptr, blocks[numBlocks]);
+    numBlocks += 1;
+
+#ifndef BUILD_FINAL
+    EXPECT_EQ(baseSize + totalSize, helper::PoolSize(POOL_TESTS));
+
+    PoolStatsData stats;
+    PoolStats(POOL_TESTS, stats);
+    EXPECT_EQ(BUDGET, stats.m_maxAllowedSize);
+#endif
+
+    for (uint32_t i = 0; i < numBlocks; ++i)
+        allocator.deallocate(blocks[i]);
+
+    EXPECT_EQ(baseSize, helper::PoolSize(POOL_TESTS));
+
+    allocator.setPoolBudget(POOL_TESTS, 0);
+}
+
+END_BOOMER_NAMESPACE()
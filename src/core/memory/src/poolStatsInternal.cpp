@@ -16,7 +16,7 @@ namespace prv
 {
     PoolStatsInternal::PoolStatsInternal()
     {
-        // TODO: setup budgets
+        // NOTE: budgets are set by the allocator
     }
 
     void PoolStatsInternal::resetGlobalStatistics()
@@ -42,12 +42,17 @@ public:
         auto& stats = m_stats[id];
         --stats.m_totalAllocations;
         stats.m_totalSize -= size;
-        stats.m_maxSize -= size;
         ++stats.m_curFrameFrees;
         stats.m_curFrameFreesSize += size;
 #endif
     }
 
+    /// set the max allowed size of the pool (informative, enforced by the allocator)
+    INLINE void budget(PoolTag id, uint64_t maxAllowedSize)
+    {
+        m_stats[id].m_maxAllowedSize = maxAllowedSize;
+    }
+
     ///--
 
     /// reset global statistics (max allocations & max size)
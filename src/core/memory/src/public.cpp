@@ -7,10 +7,16 @@
 #include "build.h"
 #include "ansiAllocator.h"
 #include "debugAllocator.h"
+#include "poolAllocator.h"
 #include "linearAllocator.h"
+#include "poolStatsInternal.h"
+
+#include "core/system/include/systemInfo.h"
+#include "core/system/include/scopeLock.h"
 
 #if defined(PLATFORM_POSIX)
     #include <sys/mman.h>
+    #include <unistd.h>
 #elif defined(PLATFORM_WINDOWS)
     #include <Windows.h>
 #endif
@@ -20,40 +26,90 @@ BEGIN_BOOMER_NAMESPACE()
 
 //-----------------------------------------------------------------------------
 
-#if defined(BUILD_RELEASE)
-typedef AnsiAllocator AllocatorClass;
-//typedef DebugAllocator AllocatorClass;
-#else
-typedef AnsiAllocator AllocatorClass;
-//typedef DebugAllocator AllocatorClass;
-#endif
+namespace helper
+{
+    // NOTE: allocator can't be changed once first allocation was made, we read the environment directly since no other system is running yet
+    static AllocatorType SelectAllocatorType()
+    {
+        const auto* name = GetEnv("BOOMER_ALLOCATOR");
+        if (0 == strcmp(name, "pool"))
+            return AllocatorType::Pool;
+        else if (0 == strcmp(name, "debug"))
+            return AllocatorType::Debug;
+        return AllocatorType::Ansi;
+    }
+
+    struct Allocators
+    {
+        AllocatorType type = AllocatorType::Ansi;
+        PoolAllocator* pool = nullptr;
+        DebugAllocator* debug = nullptr;
 
-static AllocatorClass& GetAllocator()
+        Allocators()
+        {
+            type = SelectAllocatorType();
+            if (type == AllocatorType::Pool)
+                pool = new PoolAllocator();
+            else if (type == AllocatorType::Debug)
+                debug = new DebugAllocator();
+        }
+    };
+
+    static Allocators& GetAllocators()
+    {
+        static Allocators* GTheAllocators = new Allocators();
+        return *GTheAllocators;
+    }
+
+} // helper
+
+//-----------------------------------------------------------------------------
+
+AllocatorType CurrentAllocatorType()
 {
-    static AllocatorClass* GTheAllocator = new AllocatorClass();
-    return *GTheAllocator;
+    return helper::GetAllocators().type;
 }
 
-//-----------------------------------------------------------------------------
+void SetPoolBudget(PoolTag id, uint64_t maxSize)
+{
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        allocators.pool->setPoolBudget(id, maxSize);
+    else
+        prv::TheInternalPoolStats.budget(id, maxSize);
+}
 
 void StartThreadAllocTracking()
 {
-    //GetAllocator().startThreadTracking();
 }
 
 void FinishThreadAllocTracking()
 {
-    //GetAllocator().finishThreadTracking();
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        allocators.pool->releaseThreadCache();
 }
 
 void DumpMemoryLeaks()
 {
-    GetAllocator().printLeaks();
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        allocators.pool->printLeaks();
+    else if (allocators.debug)
+        allocators.debug->printLeaks();
+    else
+        AnsiAllocator::printLeaks();
 }
 
 void ValidateHeap()
 {
-    GetAllocator().validateHeap(nullptr);
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        allocators.pool->validateHeap(nullptr);
+    else if (allocators.debug)
+        allocators.debug->validateHeap(nullptr);
+    else
+        AnsiAllocator::validateHeap(nullptr);
 }
 
 void* AllocateBlock(PoolTag id, size_t size, size_t alignment, const char* typeName)
@@ -64,12 +120,24 @@ void* AllocateBlock(PoolTag id, size_t size, size_t alignment, const char* typeN
         return nullptr;
     }
 
-    return GetAllocator().allocate(id, size, alignment, typeName);
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        return allocators.pool->allocate(id, size, alignment, typeName);
+    else if (allocators.debug)
+        return allocators.debug->allocate(id, size, alignment, typeName);
+    else
+        return AnsiAllocator::allocate(id, size, alignment, typeName);
 }
 
 void FreeBlock(void* mem)
 {
-    return GetAllocator().deallocate(mem);
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        allocators.pool->deallocate(mem);
+    else if (allocators.debug)
+        allocators.debug->deallocate(mem);
+    else
+        AnsiAllocator::deallocate(mem);
 }
 
 void* ResizeBlock(PoolTag id, void* mem, size_t size, size_t alignment, const char* typeName)
@@ -80,74 +148,254 @@ void* ResizeBlock(PoolTag id, void* mem, size_t size, size_t alignment, const ch
         return nullptr;
     }
 
-    return GetAllocator().reallocate(id, mem, size, alignment, typeName);
+    auto& allocators = helper::GetAllocators();
+    if (allocators.pool)
+        return allocators.pool->reallocate(id, mem, size, alignment, typeName);
+    else if (allocators.debug)
+        return allocators.debug->reallocate(id, mem, size, alignment, typeName);
+    else
+        return AnsiAllocator::reallocate(id, mem, size, alignment, typeName);
 }
 
 //-----------------------------------------------------------------------------
 
-static size_t RoundUpToPageSize(size_t size, size_t pageSize)
+namespace helper
 {
-    return (size + (pageSize-1)) & ~(pageSize-1);
-}
+    static size_t RoundUpToPageSize(size_t size, size_t pageSize)
+    {
+        return (size + (pageSize-1)) & ~(pageSize-1);
+    }
 
+    // page sizes supported by the system, detected once
+    struct SystemPageSizes
+    {
+        size_t smallPageSize = 4096;
+        size_t largePageSize = 0; // 0 if large pages are not supported
+
+        SystemPageSizes()
+        {
 #ifdef PLATFORM_WINAPI
-static size_t GetPageSize()
+            SYSTEM_INFO systemInfo;
+            GetSystemInfo(&systemInfo);
+            smallPageSize = systemInfo.dwPageSize;
+            largePageSize = GetLargePageMinimum();
+#elif defined(PLATFORM_POSIX)
+            smallPageSize = sysconf(_SC_PAGESIZE);
+
+    #if defined(PLATFORM_LINUX)
+            // default huge page size, line looks like "Hugepagesize:       2048 kB"
+            if (auto* file = fopen("/proc/meminfo", "r"))
+            {
+                char line[256];
+                while (fgets(line, sizeof(line), file))
+                {
+                    unsigned long long sizeKB = 0;
+                    if (1 == sscanf(line, "Hugepagesize: %llu kB", &sizeKB))
+                    {
+                        largePageSize = sizeKB * 1024;
+                        break;
+                    }
+                }
+
+                fclose(file);
+            }
+    #endif
+#endif
+        }
+    };
+
+    static const SystemPageSizes& GetSystemPageSizes()
+    {
+        static SystemPageSizes GPageSizes;
+        return GPageSizes;
+    }
+
+    // system allocations that were made with large pages, they are not rounded to normal page size so we need to remember how much was allocated
+    // NOTE: only big allocations end up here so it does not have to be fast
+    class LargePageMappings
+    {
+    public:
+        void add(void* memory, size_t allocatedSize, PoolTag pool)
+        {
+            auto* entry = (Entry*)malloc(sizeof(Entry));
+            entry->memory = memory;
+            entry->allocatedSize = allocatedSize;
+            entry->pool = pool;
+
+            auto lock = CreateLock(m_lock);
+            entry->next = m_entries;
+            m_entries = entry;
+        }
+
+        bool remove(void* memory, size_t& outAllocatedSize, PoolTag& outPool)
+        {
+            Entry* found = nullptr;
+
+            {
+                auto lock = CreateLock(m_lock);
+                for (auto** entryPtr = &m_entries; *entryPtr; entryPtr = &(*entryPtr)->next)
+                {
+                    if ((*entryPtr)->memory == memory)
+                    {
+                        found = *entryPtr;
+                        *entryPtr = found->next;
+                        break;
+                    }
+                }
+            }
+
+            if (!found)
+                return false;
+
+            outAllocatedSize = found->allocatedSize;
+            outPool = found->pool;
+            free(found);
+            return true;
+        }
+
+    private:
+        struct Entry
+        {
+            void* memory = nullptr;
+            size_t allocatedSize = 0;
+            PoolTag pool = POOL_SYSTEM_MEMORY;
+            Entry* next = nullptr;
+        };
+
+        SpinLock m_lock;
+        Entry* m_entries = nullptr;
+    };
+
+    static LargePageMappings& GetLargePageMappings()
+    {
+        static LargePageMappings* GTheMappings = new LargePageMappings();
+        return *GTheMappings;
+    }
+
+#if defined(PLATFORM_POSIX)
+    static void* MapLargePages(size_t allocSize, size_t largePageSize, PoolTag& outPool)
+    {
+    #if defined(MAP_HUGETLB)
+        // explicit huge pages, works only if the pages were reserved in the system (vm.nr_hugepages)
+        auto ret = mmap64(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+        if (ret != MAP_FAILED)
+        {
+            outPool = POOL_SYSTEM_LARGE_PAGES;
+            return ret;
+        }
+    #endif
+
+    #if defined(MADV_HUGEPAGE)
+        // transparent huge pages, the range must be aligned to the huge page size to be fully backed by them so map a bit more and trim the excess
+        const auto reservedSize = allocSize + largePageSize;
+        auto* base = (uint8_t*)mmap64(nullptr, reservedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            auto* aligned = (uint8_t*)RoundUpToPageSize((size_t)base, largePageSize);
+            if (aligned > base)
+                munmap(base, aligned - base);
+
+            auto* alignedEnd = aligned + allocSize;
+            auto* baseEnd = base + reservedSize;
+            if (baseEnd > alignedEnd)
+                munmap(alignedEnd, baseEnd - alignedEnd);
+
+            // NOTE: this is only a hint, memory is tracked as normal system memory
+            madvise(aligned, allocSize, MADV_HUGEPAGE);
+            outPool = POOL_SYSTEM_MEMORY;
+            return aligned;
+        }
+    #endif
+
+        return nullptr;
+    }
+#endif
+
+} // helper
+
+size_t SystemPageSize()
 {
-    SYSTEM_INFO systemInfo;
-    GetSystemInfo(&systemInfo);
-    return systemInfo.dwPageSize;
+    return helper::GetSystemPageSizes().smallPageSize;
+}
+
+size_t SystemLargePageSize()
+{
+    return helper::GetSystemPageSizes().largePageSize;
 }
-#endif
 
 void* AllocSystemMemory(size_t size, bool largePages)
 {
-#ifdef PLATFORM_WINAPI
-    static auto largePageSize = GetLargePageMinimum();
-    static auto smallPageSize = GetPageSize();
-    auto pageSize = largePages ? largePageSize : smallPageSize;
-    auto allocSize = RoundUpToPageSize(size, pageSize);
-    auto ret  = VirtualAlloc(NULL, allocSize, MEM_COMMIT | MEM_RESERVE | (largePages ? MEM_LARGE_PAGES : 0), PAGE_READWRITE);
-    if (largePages && ret == nullptr)
+    const auto& pageSizes = helper::GetSystemPageSizes();
+
+    void* ret = nullptr;
+    size_t allocSize = 0;
+    PoolTag pool = POOL_SYSTEM_MEMORY;
+
+    // large pages are only used if we can fill at least one
+    if (largePages && pageSizes.largePageSize && size >= pageSizes.largePageSize)
     {
-        // retry without the large pages
-        auto newAllocSize = RoundUpToPageSize(size, smallPageSize);
-        ret = VirtualAlloc(NULL, newAllocSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        allocSize = helper::RoundUpToPageSize(size, pageSizes.largePageSize);
+
+#ifdef PLATFORM_WINAPI
+        ret = VirtualAlloc(NULL, allocSize, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+        pool = POOL_SYSTEM_LARGE_PAGES;
+#elif defined(PLATFORM_POSIX)
+        ret = helper::MapLargePages(allocSize, pageSizes.largePageSize, pool);
+#endif
+
+        if (ret)
+            helper::GetLargePageMappings().add(ret, allocSize, pool);
     }
 
+    // normal pages
     if (!ret)
     {
-        FATAL_ERROR(TempString("System allocation of {} bytes failed", size));
-    }
+        allocSize = helper::RoundUpToPageSize(size, pageSizes.smallPageSize);
+        pool = POOL_SYSTEM_MEMORY;
+
+#ifdef PLATFORM_WINAPI
+        ret = VirtualAlloc(NULL, allocSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!ret)
+        {
+            FATAL_ERROR(TempString("System allocation of {} bytes failed", size));
+        }
 #elif defined(PLATFORM_POSIX)
-    static auto pageSize = 4096;
-    auto allocSize = RoundUpToPageSize(size, pageSize);
-    auto ret  = mmap64(nullptr, allocSize, PROT_READ | PROT_WRITE,  MAP_PRIVATE | MAP_ANON, -1, 0);
-    if (ret == MAP_FAILED)
-    {
-        FATAL_ERROR(TempString("System allocation of {} bytes failed, reason: {}", size, errno));
-    }
+        ret = mmap64(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (ret == MAP_FAILED)
+        {
+            FATAL_ERROR(TempString("System allocation of {} bytes failed, reason: {}", size, errno));
+        }
 #else
-#error "Implement this"
+    #error "Implement this"
 #endif
+    }
 
-    PoolNotifyAllocation(POOL_SYSTEM_MEMORY, size);
+    // report what we actually got from the system
+    PoolNotifyAllocation(pool, allocSize);
 
     return ret;
 }
 
 void FreeSystemMemory(void* page, size_t size)
 {
+    const auto& pageSizes = helper::GetSystemPageSizes();
+
+    size_t allocSize = 0;
+    PoolTag pool = POOL_SYSTEM_MEMORY;
+
+    // only allocations bigger than a large page could have used them
+    if (!pageSizes.largePageSize || size < pageSizes.largePageSize || !helper::GetLargePageMappings().remove(page, allocSize, pool))
+        allocSize = helper::RoundUpToPageSize(size, pageSizes.smallPageSize);
+
 #ifdef PLATFORM_WINAPI
     VirtualFree(page, 0, MEM_RELEASE);
 #elif defined(PLATFORM_POSIX)
-    static auto pageSize = 4096;
-    auto allocSize = RoundUpToPageSize(size, pageSize);
     munmap(page, allocSize);
 #else
 #error "Implement this"
 #endif
 
-    PoolNotifyFree(POOL_SYSTEM_MEMORY, size);
+    PoolNotifyFree(pool, allocSize);
 }
 
 //-----------------------------------------------------------------------------
@@ -15,11 +15,11 @@
 #include "core/system/include/mutex.h"
 #include "core/system/include/atomic.h"
 #include "core/containers/include/hashMap.h"
-#include "core/system/include/simpleStructurePool.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
 /// Global list of all objects that derive from IObject
+/// NOTE: registry is split into shards by object ID so creating and destroying objects on different threads does not fight over one lock
 class CORE_OBJECT_API ObjectGlobalRegistry : public ISingleton
 {
     DECLARE_SINGLETON(ObjectGlobalRegistry);
@@ -30,25 +30,26 @@ public:
     ///---
 
     // get total object count
-    INLINE uint32_t totalObjectCount() const { return m_objectCount.load(); }
+    uint32_t totalObjectCount() const;
 
     ///---
 
     /// get object by ID
+    /// NOTE: lookup does not take any lock
     ObjectPtr findObject(uint32_t id);
 
     ///---
 
     /// visit all objects with a function on EACH OBJECT, do I have to say it will be slow ? :) 
-    /// NOTE: registry is locked during this update 
+    /// NOTE: objects are collected first and the function is called outside the registry lock
     bool iterateAllObjects(const std::function<bool(IObject*)>& enumFunc);
 
-    /// visit all objects of specific class with a function, still slow
-    /// NOTE: registry is locked during this update 
+    /// visit all objects of specific class with a function, only objects of matching classes are visited
+    /// NOTE: objects are collected first and the function is called outside the registry lock
     bool iterateObjectsOfClass(ClassType objectClass, const std::function<bool(IObject*)>& enumFunc);
 
-    /// visit all objects of specific class with a function, still slow
-    /// NOTE: registry is locked during this update 
+    /// visit all objects of specific class with a function, only objects of matching classes are visited
+    /// NOTE: objects are collected first and the function is called outside the registry lock
     template< typename T >
     INLINE bool iterateObjectsOfClass(const std::function<bool(T*)>& enumFunc)
     {
@@ -66,26 +67,14 @@ protected:
 
     //--
 
-    static const uint32_t MAX_BUCKETS = 16 * 1024;
+    static const uint32_t NUM_SHARDS = 64;
 
-    struct ObjectEntry
-    {
-        uint32_t id = 0;
-        ObjectWeakPtr ptr;
-        ObjectEntry* nextBucket = nullptr;
-        ObjectEntry* nextAll = nullptr;
-        ObjectEntry* prevAll = nullptr;
-    };
-
-    SpinLock m_objectsLock;
-    ObjectEntry* m_objectListHead = nullptr;
-    ObjectEntry* m_objectListTail = nullptr;
-
-    SimpleStructurePool<ObjectEntry> m_objectEntryPool;
-    ObjectEntry* m_objectHashBuckets[MAX_BUCKETS];
-
-    std::atomic<uint32_t> m_objectCount = 0;
+    struct ObjectEntry;
+    struct ClassList;
+    struct LookupTable;
+    struct Shard;
 
+    Shard* m_shards = nullptr;
 
     //--
 
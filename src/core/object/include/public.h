@@ -81,6 +81,9 @@ class OpcodeIterator;
 class OpcodeReader;
 class OpcodeWriter;
 
+struct OpcodeBulkLayout;
+struct OpcodeBulkLayoutField;
+
 class LoadingResult;
 struct LoadingDependency;
 
@@ -287,9 +290,13 @@ static const uint32_t VER_ABSOLUTE_DEPOT_PATHS = 2;
 
 static const uint32_t VER_THREAD_SAFE_GRAPHS = 3;
 
+static const uint32_t VER_BULK_BINARY_DATA = 4;
+
+static const uint32_t VER_BULK_LAYOUT_TABLE = 5;
+
 //--
 
-static const uint32_t VER_CURRENT = VER_THREAD_SAFE_GRAPHS;
+static const uint32_t VER_CURRENT = VER_BULK_LAYOUT_TABLE;
 
 END_BOOMER_NAMESPACE()
 
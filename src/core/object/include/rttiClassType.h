@@ -68,6 +68,25 @@ public:
     virtual void writeXML(TypeSerializationContext& typeContext, xml::Node& node, const void* data, const void* defaultData) const override final;
     virtual void readXML(TypeSerializationContext& typeContext, const xml::Node& node, void* data) const override final;
 
+    // BULK SERIALIZATION
+
+    // get hash of the binary layout of this class, not zero only if all saved properties are raw data (directly or in nested structures)
+    // NOTE: classes with valid layout hash are saved as raw memory blocks that are loaded with memcpy as long as the layout did not change
+    uint64_t binaryLayoutHash() const;
+
+    // write continuous array of values of this class as a single memory block, valid only if binaryLayoutHash() is not zero
+    void writeBinaryBulk(TypeSerializationContext& typeContext, stream::OpcodeWriter& file, const void* data, uint32_t count) const;
+
+    // read continuous array of values of this class, values may be saved in bulk or one by one, values past the capacity are read and discarded
+    void readBinaryArray(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t count, uint32_t capacity) const;
+
+    // write layouts of all classes saved in bulk in the stream, the table must be placed at the head of the stream
+    // NOTE: the bulk blocks only reference the layouts so the data can be skipped without losing the layout needed by the later blocks
+    static void WriteBinaryLayoutTable(stream::OpcodeWriter& file, const Array<Type>& layouts);
+
+    // read the bulk layout table from the head of the stream, files saved before VER_BULK_LAYOUT_TABLE have no such table
+    static void ReadBinaryLayoutTable(stream::OpcodeReader& file);
+
     // DATA VIEW
     virtual DataViewResult describeDataView(StringView viewPath, const void* viewData, DataViewInfo& outInfo) const override final;
     virtual DataViewResult readDataView(StringView viewPath, const void* viewData, void* targetData, Type targetType) const override final;
@@ -213,6 +232,16 @@ protected:
     mutable TFunctionCache m_allFunctionsMap;
     mutable bool m_allFunctionsCached = false;
 
+    struct BinaryLayoutRange
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    mutable Array<BinaryLayoutRange> m_binaryLayoutRanges; // merged memory ranges of all saved properties
+    mutable uint64_t m_binaryLayoutHash = 0;
+    mutable bool m_binaryLayoutCached = false;
+
     mutable SpinLock m_allTablesLock;
 
     const IClassType* m_baseClass;
@@ -230,6 +259,12 @@ protected:
     bool handlePropertyMissing(TypeSerializationContext& context, StringID name, Type dataType, const void* data) const;
     bool handlePropertyTypeChange(TypeSerializationContext& context, StringID name, Type dataType, const void* data, Type currentType, void* currentData) const;
 
+    void readBinaryProperties(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t propertyCount) const;
+    void readBinaryBulk(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t count, uint32_t capacity) const;
+    void writeBinaryLayout(stream::OpcodeWriter& file) const;
+    void applyBinaryLayout(TypeSerializationContext& typeContext, const Array<stream::OpcodeBulkLayoutField>& fields, uint32_t firstField, uint32_t numFields, const uint8_t* srcData, uint32_t srcSize, void* data) const;
+    static void ReadBinaryLayout(stream::OpcodeReader& file, Array<stream::OpcodeBulkLayoutField>& outFields, uint32_t& outFirstField, uint32_t& outNumFields);
+
     virtual void cacheTypeData() override;
     virtual void releaseTypeReferences() override;
 };
@@ -141,6 +141,7 @@ struct TypeRuntimeTraits
     bool requiresConstructor = true; // call to construct() is not needed in all cases (no undefined state)
     bool requiresDestructor = true; // call to destroy() is not needed in all cases (no memory leaks)
     bool simpleCopyCompare = false; // use memcpy/memcmp instead of full copy() compare() calls
+    bool binaryRawData = false; // binary serialization writes just the raw memory of the value so it can be read/written in bulk
     bool hashable = false; // is this type hashable ? (can be used as Key in hashmap)
 
 };
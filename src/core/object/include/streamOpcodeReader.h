@@ -43,6 +43,29 @@ struct CORE_OBJECT_API OpcodeResolvedReferences : public NoCopy
 
 ///---
 
+/// description of single property in data saved in bulk (see IClassType::writeBinaryBulk)
+struct OpcodeBulkLayoutField
+{
+    StringID name;
+    Type type;
+    StringID typeName;
+    uint32_t offset = 0;
+    uint32_t firstChild = 0; // fields of nested structure
+    uint32_t numChildren = 0;
+};
+
+/// layout of structure saved in bulk, read once per stream (from the layout table at the head of the stream) and reused by all blocks with the same layout
+struct OpcodeBulkLayout
+{
+    uint64_t hash = 0;
+    uint32_t size = 0;
+    uint32_t firstField = 0;
+    uint32_t numFields = 0;
+    Array<OpcodeBulkLayoutField> fields;
+};
+
+///---
+
 class CORE_OBJECT_API OpcodeReader : public NoCopy
 {
 public:
@@ -115,16 +138,41 @@ public:
 
     ///---
 
+    /// get size of the next raw data block, works only in protected streams (returns false otherwise)
+    INLINE bool peekDataSize(uint64_t& outSize) const;
+
+    /// get bulk layout that was already read from this stream, NULL if there's no such layout
+    INLINE const OpcodeBulkLayout* bulkLayout(uint32_t index) const;
+
+    /// add new bulk layout read from this stream, layouts are indexed in the order they were added
+    INLINE OpcodeBulkLayout& addBulkLayout();
+
+    /// number of bulk layouts read so far
+    INLINE uint32_t numBulkLayouts() const { return m_bulkLayouts.size(); }
+
+    ///---
+
+    /// report that the data in the stream can't be loaded, the loading of the whole file will fail
+    INLINE void reportCorruption() { m_corrupted = true; }
+
+    /// was the stream reported as corrupted
+    INLINE bool corrupted() const { return m_corrupted; }
+
+    ///---
+
 private:
     const uint8_t* m_cur = nullptr;
     const uint8_t* m_end = nullptr;
     const uint8_t* m_base = nullptr;
 
     bool m_protectedStream = false;
+    bool m_corrupted = false;
     uint32_t m_version = 0;
 
     const OpcodeResolvedReferences& m_refs;
 
+    Array<OpcodeBulkLayout> m_bulkLayouts;
+
     INLINE uint64_t readCompressedNumber();
 
     INLINE void checkOp(StreamOpcode op);
@@ -192,6 +240,42 @@ INLINE void OpcodeReader::checkDataOp(uint64_t size)
 #endif
 }
 
+INLINE bool OpcodeReader::peekDataSize(uint64_t& outSize) const
+{
+#ifdef SUPPORT_PROTECTED_STREAM
+    if (m_protectedStream && m_cur < m_end && (StreamOpcode)*m_cur == StreamOpcode::DataRaw)
+    {
+        // decode the size without moving the read pointer
+        const auto* ptr = m_cur + 1;
+        uint64_t ret = 0;
+        uint32_t offset = 0;
+        while (ptr < m_end)
+        {
+            const auto singleByte = *ptr++;
+            ret |= (uint64_t)(singleByte & 0x7F) << offset;
+            offset += 7;
+
+            if (!(singleByte & 0x80))
+            {
+                outSize = ret;
+                return true;
+            }
+        }
+    }
+#endif
+    return false;
+}
+
+INLINE const OpcodeBulkLayout* OpcodeReader::bulkLayout(uint32_t index) const
+{
+    return (index < m_bulkLayouts.size()) ? &m_bulkLayouts[index] : nullptr;
+}
+
+INLINE OpcodeBulkLayout& OpcodeReader::addBulkLayout()
+{
+    return m_bulkLayouts.emplaceBack();
+}
+
 INLINE void OpcodeReader::enterCompound(uint32_t& outNumProperties)
 {
     checkOp(StreamOpcode::Compound);
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "core/containers/include/hashSet.h"
+#include "core/containers/include/hashMap.h"
 #include "core/containers/include/inplaceArray.h"
 
 #include "streamOpcodes.h"
@@ -79,6 +80,7 @@ public:
     //--
 
     INLINE void beginCompound(Type type);
+    INLINE void beginBulkCompound(Type type);
     INLINE void endCompound();
 
     INLINE void beginArray(uint32_t count);
@@ -97,6 +99,21 @@ public:
 
     //--
 
+    //! can classes with compatible binary layout be written as raw memory blocks
+    INLINE bool allowBulkData() const { return m_allowBulkData; }
+
+    //! enable/disable writing classes as raw memory blocks, when disabled the tagged properties are always written
+    //! NOTE: disabled by default, enabled by the file saver
+    INLINE void allowBulkData(bool flag) { m_allowBulkData = flag; }
+
+    //! get index of the bulk layout of given type in this stream, the layout itself is written separately in the layout table
+    INLINE uint32_t mapBulkLayout(Type type);
+
+    //! get types of all bulk layouts used in this stream, in the order of their indices
+    INLINE const Array<Type>& bulkLayouts() const { return m_bulkLayouts.keys(); }
+
+    //--
+
 private:
     OpcodeStream& m_stream;
     OpcodeWriterReferences& m_references;
@@ -104,6 +121,10 @@ private:
     InplaceArray<StreamOpcode, 20> m_stack;
     InplaceArray<StreamOpSkipHeader*, 20> m_skips;
     InplaceArray<StreamOpCompound*, 20> m_compounds;
+
+    HashMap<Type, uint32_t> m_bulkLayouts; // layouts used in the stream
+
+    bool m_allowBulkData = false;
 };
        
 ///---
@@ -141,6 +162,31 @@ INLINE void OpcodeWriter::beginCompound(Type type)
     m_stack.pushBack(StreamOpcode::Compound);
 }
 
+INLINE void OpcodeWriter::beginBulkCompound(Type type)
+{
+    auto op = m_stream.allocOpcode<StreamOpCompound>();
+    if (op)
+    {
+        op->numProperties = StreamOpCompound::BULK_LAYOUT;
+        op->type = type;
+    }
+
+    m_compounds.pushBack(nullptr); // no properties can be added
+    m_stack.pushBack(StreamOpcode::Compound);
+}
+
+INLINE uint32_t OpcodeWriter::mapBulkLayout(Type type)
+{
+    uint32_t index = 0;
+    if (!m_bulkLayouts.find(type, index))
+    {
+        index = m_bulkLayouts.size();
+        m_bulkLayouts[type] = index;
+    }
+
+    return index;
+}
+
 INLINE void OpcodeWriter::endCompound()
 {
     ASSERT_EX(!m_stack.empty(), "Invalid opcode stack - binary steam is mallformed, must be fixed");
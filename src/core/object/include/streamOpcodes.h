@@ -68,6 +68,8 @@ STREAM_OPCODE_DATA(Nop)
 
 STREAM_OPCODE_DATA(Compound)
 {
+    static const uint16_t BULK_LAYOUT = 0xFFFF; // special property count: compound data is saved as a raw memory block preceded by the index of the layout description
+
     Type type;
     uint16_t numProperties = 0;
 };
@@ -12,54 +12,282 @@
 
 #include "core/object/include/object.h"
 #include "core/system/include/scopeLock.h"
+#include "core/system/include/simpleStructurePool.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
+///--
+
+namespace helper
+{
+    template< typename T >
+    static void LinkEntry(T*& head, T* entry)
+    {
+        entry->prev = nullptr;
+        entry->next = head;
+        if (head)
+            head->prev = entry;
+        head = entry;
+    }
+
+    template< typename T >
+    static void UnlinkEntry(T*& head, T* entry)
+    {
+        if (entry->next)
+            entry->next->prev = entry->prev;
+
+        if (entry->prev)
+            entry->prev->next = entry->next;
+        else
+            head = entry->next;
+
+        entry->next = nullptr;
+        entry->prev = nullptr;
+    }
+
+} // helper
+
+///--
+
+// entry for single registered object, lives in one of the class lists (or on the pending list if the class is not yet known)
+struct ObjectGlobalRegistry::ObjectEntry
+{
+    uint32_t id = 0;
+    ObjectWeakPtr ptr;
+    ClassList* list = nullptr; // null for pending list
+    ObjectEntry* next = nullptr;
+    ObjectEntry* prev = nullptr;
+};
+
+// intrusive list of objects of exactly one class
+struct ObjectGlobalRegistry::ClassList
+{
+    ClassType cls;
+    ObjectEntry* head = nullptr;
+    uint32_t count = 0;
+};
+
+// open addressing table used for ID lookups, readers access it without the lock
+// NOTE: tables and weak holders removed from the table are retired and only freed once no reader is inside the shard
+struct ObjectGlobalRegistry::LookupTable
+{
+    static const uint32_t FREE_ID = 0;
+    static const uint32_t DELETED_ID = 0xFFFFFFFF;
+
+    uint32_t mask = 0;
+    uint32_t numUsed = 0; // including deleted slots
+    std::atomic<uint32_t>* ids = nullptr;
+    std::atomic<RefWeakContainer*>* holders = nullptr; // each slot keeps its own reference to the holder
+    ObjectEntry** entries = nullptr; // only accessed under the shard lock
+
+    LookupTable(uint32_t size)
+        : mask(size - 1)
+    {
+        ids = new std::atomic<uint32_t>[size];
+        holders = new std::atomic<RefWeakContainer*>[size];
+        entries = new ObjectEntry*[size];
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            ids[i].store(FREE_ID, std::memory_order_relaxed);
+            holders[i].store(nullptr, std::memory_order_relaxed);
+            entries[i] = nullptr;
+        }
+    }
+
+    ~LookupTable()
+    {
+        delete[] ids;
+        delete[] holders;
+        delete[] entries;
+    }
+
+    INLINE uint32_t size() const
+    {
+        return mask + 1;
+    }
+
+    INLINE uint32_t firstSlot(uint32_t id) const
+    {
+        // IDs are sequential, spread them a little bit
+        return ((id / NUM_SHARDS) * 2654435761U) & mask;
+    }
+};
+
+// single shard of the registry, padded so the locks of different shards don't share a cache line
+struct alignas(64) ObjectGlobalRegistry::Shard
+{
+    SpinLock lock;
+    std::atomic<LookupTable*> table = nullptr;
+    std::atomic<uint32_t> numReaders = 0;
+    std::atomic<uint32_t> numObjects = 0;
+
+    SimpleStructurePool<ObjectEntry> entryPool;
+    ObjectEntry* pendingList = nullptr;
+
+    HashMap<const IClassType*, ClassList*> classLists;
+
+    Array<RefWeakContainer*> retiredHolders;
+    Array<LookupTable*> retiredTables;
+
+    Shard()
+        : entryPool(4096 / sizeof(ObjectEntry))
+    {
+        table = new LookupTable(256);
+    }
+
+    ~Shard()
+    {
+        DEBUG_CHECK_EX(numObjects.load() == 0, "Deleting registry shard with objects");
+        DEBUG_CHECK_EX(numReaders.load() == 0, "Deleting registry shard that is being read");
+
+        releaseClassLists();
+        freeRetired();
+        delete table.load();
+    }
+
+    // move all objects back to the pending list and delete the class lists, they are rebuilt on next iteration
+    void releaseClassLists()
+    {
+        for (auto* list : classLists.values())
+        {
+            while (auto* entry = list->head)
+            {
+                helper::UnlinkEntry(list->head, entry);
+                helper::LinkEntry(pendingList, entry);
+                entry->list = nullptr;
+            }
+
+            delete list;
+        }
+
+        classLists.clear();
+    }
+
+    // free tables and holders removed from the lookup table, may only be called if no reader is inside the shard
+    void freeRetired()
+    {
+        for (auto* holder : retiredHolders)
+            holder->releaseRef();
+        retiredHolders.reset();
+
+        for (auto* retiredTable : retiredTables)
+            delete retiredTable;
+        retiredTables.reset();
+    }
+};
+
+///--
+
+
 ///--
 
 ObjectGlobalRegistry::ObjectGlobalRegistry()
-    : m_objectEntryPool(65536 / sizeof(ObjectEntry))
 {
-    memset(m_objectHashBuckets, 0, sizeof(m_objectHashBuckets));
+    m_shards = new Shard[NUM_SHARDS];
 }
 
 void ObjectGlobalRegistry::deinit()
 {
-        
+    if (!m_shards)
+        return;
+
+    for (uint32_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        auto& shard = m_shards[i];
+        auto lock = CreateLock(shard.lock);
+
+        shard.releaseClassLists();
+
+        if (shard.numReaders.load() == 0)
+            shard.freeRetired();
+    }
+
+    // NOTE: objects may still be destroyed after the registry is deinitialized, in that case we have to keep the shards alive
+    if (totalObjectCount() == 0)
+    {
+        delete[] m_shards;
+        m_shards = nullptr;
+    }
+}
+
+uint32_t ObjectGlobalRegistry::totalObjectCount() const
+{
+    if (!m_shards)
+        return 0;
+
+    uint32_t ret = 0;
+    for (uint32_t i = 0; i < NUM_SHARDS; ++i)
+        ret += m_shards[i].numObjects.load(std::memory_order_relaxed);
+    return ret;
 }
 
 ObjectPtr ObjectGlobalRegistry::findObject(uint32_t id)
 {
-    auto lock = CreateLock(m_objectsLock);
+    if (id == LookupTable::FREE_ID || id == LookupTable::DELETED_ID || !m_shards)
+        return nullptr;
 
-    // locate the entry
-    const auto bucketIndex = id % MAX_BUCKETS;
-    auto* curEntry = m_objectHashBuckets[bucketIndex];
-    while (curEntry)
+    auto& shard = m_shards[id % NUM_SHARDS];
+
+    // announce we are reading, nothing retired after this point will be freed until we are done
+    // NOTE: all accesses here and in unregisterObject are sequentially consistent, if the writer saw no readers we are guaranteed to see the slot already cleared
+    IReferencable* found = nullptr;
+    shard.numReaders.fetch_add(1, std::memory_order_seq_cst);
     {
-        if (curEntry->id == id)
-            return curEntry->ptr.lock();
-        curEntry = curEntry->nextBucket;
+        const auto* table = shard.table.load(std::memory_order_seq_cst);
+
+        auto slot = table->firstSlot(id);
+        while (true)
+        {
+            const auto slotId = table->ids[slot].load(std::memory_order_seq_cst);
+            if (slotId == id)
+            {
+                if (auto* holder = table->holders[slot].load(std::memory_order_seq_cst))
+                    found = holder->lock();
+                break;
+            }
+            else if (slotId == LookupTable::FREE_ID)
+            {
+                break;
+            }
+
+            slot = (slot + 1) & table->mask;
+        }
     }
+    shard.numReaders.fetch_sub(1, std::memory_order_seq_cst);
 
-    // object not found
-    return nullptr;
+    // lock() already provided reference, do not add another one
+    auto ret = ObjectPtr(NoAddRef(static_cast<IObject*>(found)));
+
+    // slot may have been reused while we were reading it
+    if (ret && ret->id() != id)
+        return nullptr;
+
+    return ret;
 }
 
 bool ObjectGlobalRegistry::iterateAllObjects(const std::function<bool(IObject*)>& enumFunc)
 {
     Array<ObjectWeakPtr> allObjects;
 
+    if (!m_shards)
+        return false;
+
     // extract objects
     {
-        auto lock = CreateLock(m_objectsLock);
-        allObjects.reserve(m_objectCount);
+        allObjects.reserve(totalObjectCount());
 
-        auto cur = m_objectListTail;
-        while (cur)
+        for (uint32_t i = 0; i < NUM_SHARDS; ++i)
         {
-            allObjects.pushBack(cur->ptr);
-            cur = cur->prevAll;
+            auto& shard = m_shards[i];
+            auto lock = CreateLock(shard.lock);
+
+            for (auto* cur = shard.pendingList; cur; cur = cur->next)
+                allObjects.pushBack(cur->ptr);
+
+            for (const auto* list : shard.classLists.values())
+                for (auto* cur = list->head; cur; cur = cur->next)
+                    allObjects.pushBack(cur->ptr);
         }
     }
 
@@ -74,112 +302,226 @@ bool ObjectGlobalRegistry::iterateAllObjects(const std::function<bool(IObject*)>
 
 bool ObjectGlobalRegistry::iterateObjectsOfClass(ClassType objectClass, const std::function<bool(IObject*)>& enumFunc)
 {
-    auto lock = CreateLock(m_objectsLock);
+    // NOTE: the strong references are released after the shard lock is released, releasing the last reference will call unregisterObject
+    Array<ObjectPtr> objects;
+    Array<ObjectPtr> classifiedObjects;
+
+    if (!m_shards)
+        return false;
 
-    auto cur = m_objectListTail;
-    while (cur)
+    for (uint32_t i = 0; i < NUM_SHARDS; ++i)
     {
-        if (auto obj = cur->ptr.lock())
-            if (obj->is(objectClass))
-                if (enumFunc(obj))
-                    return true;
+        auto& shard = m_shards[i];
+        auto lock = CreateLock(shard.lock);
 
-        cur = cur->prevAll;
+        // objects register themselves before their final class is known (from the IObject constructor), sort them now
+        // NOTE: object still being constructed on other thread will report a base class, we fix that below
+        auto* cur = shard.pendingList;
+        while (cur)
+        {
+            auto* next = cur->next;
+
+            if (auto obj = cur->ptr.lock())
+            {
+                auto* list = shard.classLists.findSafe(obj->cls().ptr(), nullptr);
+                if (!list)
+                {
+                    list = new ClassList;
+                    list->cls = obj->cls();
+                    shard.classLists[obj->cls().ptr()] = list;
+                }
+
+                helper::UnlinkEntry(shard.pendingList, cur);
+                helper::LinkEntry(list->head, cur);
+                cur->list = list;
+                list->count += 1;
+
+                classifiedObjects.pushBack(obj);
+            }
+
+            cur = next;
+        }
+
+        // list of base class may contain objects that were classified before they were fully constructed, move them to their final lists first
+        // NOTE: new lists are appended to the values and are visited by this loop as well, they only contain objects of exact class so nothing is moved from them
+        for (uint32_t j = 0; j < shard.classLists.values().size(); ++j)
+        {
+            auto* list = shard.classLists.values()[j];
+            if (list->cls == objectClass || !objectClass.is(list->cls) || !list->count)
+                continue;
+
+            auto* entry = list->head;
+            while (entry)
+            {
+                auto* next = entry->next;
+
+                if (auto obj = entry->ptr.lock())
+                {
+                    const auto cls = obj->cls();
+                    if (cls != list->cls)
+                    {
+                        auto* newList = shard.classLists.findSafe(cls.ptr(), nullptr);
+                        if (!newList)
+                        {
+                            newList = new ClassList;
+                            newList->cls = cls;
+                            shard.classLists[cls.ptr()] = newList;
+                        }
+
+                        helper::UnlinkEntry(list->head, entry);
+                        list->count -= 1;
+                        helper::LinkEntry(newList->head, entry);
+                        entry->list = newList;
+                        newList->count += 1;
+                    }
+
+                    classifiedObjects.pushBack(obj);
+                }
+
+                entry = next;
+            }
+        }
+
+        // collect objects from matching lists, including the ones that were just moved
+        for (const auto* list : shard.classLists.values())
+        {
+            if (list->cls.is(objectClass))
+            {
+                for (auto* entry = list->head; entry; entry = entry->next)
+                    if (auto obj = entry->ptr.lock())
+                        objects.pushBack(obj);
+            }
+        }
     }
 
+    // run enumerator
+    for (const auto& obj : objects)
+        if (enumFunc(obj))
+            return true;
+
     return false;
 }
 
 void ObjectGlobalRegistry::registerObject(uint32_t id, IObject* object)
 {
-    auto lock = CreateLock(m_objectsLock);
+    DEBUG_CHECK_EX(id != LookupTable::FREE_ID && id != LookupTable::DELETED_ID, TempString("Invalid object ID {}", id));
+    DEBUG_CHECK_RETURN_EX(m_shards, "Object created after the registry was deinitialized");
+
+    auto& shard = m_shards[id % NUM_SHARDS];
+    auto lock = CreateLock(shard.lock);
 
-    // allocate entry
-    m_objectCount += 1;
-    auto* entry = m_objectEntryPool.alloc();
-    memset(entry, 0, sizeof(ObjectEntry));
+    // allocate entry, class is not known yet so it goes to the pending list
+    auto* entry = new (shard.entryPool.alloc()) ObjectEntry();
     entry->id = id;
     entry->ptr = object;
-    entry->nextAll = nullptr;
-    entry->prevAll= nullptr;
-    entry->nextBucket  = nullptr;
+    helper::LinkEntry(shard.pendingList, entry);
 
-    // link in the global list
-    if (m_objectListHead != nullptr)
+    // grow the lookup table, readers may still use the old one
+    auto* table = shard.table.load(std::memory_order_relaxed);
+    if ((table->numUsed + 1) * 2 > table->size())
     {
-        m_objectListHead->prevAll = entry;
-        entry->nextAll = m_objectListHead;
+        auto newSize = table->size();
+        while ((shard.numObjects.load(std::memory_order_relaxed) + 1) * 4 > newSize)
+            newSize *= 2;
+
+        auto* newTable = new LookupTable(newSize);
+        for (uint32_t i = 0; i < table->size(); ++i)
+        {
+            if (auto* oldEntry = table->entries[i])
+            {
+                auto slot = newTable->firstSlot(oldEntry->id);
+                while (newTable->entries[slot])
+                    slot = (slot + 1) & newTable->mask;
+
+                // move the reference of the slot to new table
+                newTable->entries[slot] = oldEntry;
+                newTable->holders[slot].store(table->holders[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                newTable->ids[slot].store(oldEntry->id, std::memory_order_relaxed);
+                newTable->numUsed += 1;
+            }
+        }
+
+        shard.table.store(newTable);
+        shard.retiredTables.pushBack(table);
+        table = newTable;
     }
-    else
+
+    // insert into the lookup table, holder must be visible before the ID
     {
-        m_objectListTail = entry;
-    }
+        auto* holder = entry->ptr.holder();
+        holder->addRef();
 
-    m_objectListHead = entry;
+        auto slot = table->firstSlot(id);
+        while (table->entries[slot])
+            slot = (slot + 1) & table->mask;
 
-    // add entry to the hash buckets
-    const auto bucketIndex = id % MAX_BUCKETS;
-    entry->nextBucket = m_objectHashBuckets[bucketIndex];
-    m_objectHashBuckets[bucketIndex] = entry;
+        if (table->ids[slot].load(std::memory_order_relaxed) == LookupTable::FREE_ID)
+            table->numUsed += 1;
+
+        table->entries[slot] = entry;
+        table->holders[slot].store(holder, std::memory_order_release);
+        table->ids[slot].store(id, std::memory_order_release);
+    }
+
+    shard.numObjects += 1;
 }
 
 void ObjectGlobalRegistry::unregisterObject(uint32_t id, IObject* object)
 {
-    auto lock = CreateLock(m_objectsLock);
+    if (!m_shards)
+        return;
+
+    auto& shard = m_shards[id % NUM_SHARDS];
+    auto lock = CreateLock(shard.lock);
 
     // locate the entry
-    const auto bucketIndex = id % MAX_BUCKETS;
-    auto* prevLink = &m_objectHashBuckets[bucketIndex];
-    auto* curEntry = m_objectHashBuckets[bucketIndex];
-    while (curEntry)
+    auto* table = shard.table.load(std::memory_order_relaxed);
+    auto slot = table->firstSlot(id);
+    while (true)
     {
-        if (curEntry->id == id)
+        const auto slotId = table->ids[slot].load(std::memory_order_relaxed);
+        if (slotId == id || slotId == LookupTable::FREE_ID)
             break;
-        prevLink = &curEntry->nextBucket;
-        curEntry = curEntry->nextBucket;
+        slot = (slot + 1) & table->mask;
     }
 
     // object was not registered
-    DEBUG_CHECK_EX(curEntry != nullptr, TempString("Object ID {} not found in global registry", id));
-    if (curEntry == nullptr)
+    auto* entry = table->entries[slot];
+    DEBUG_CHECK_EX(entry != nullptr, TempString("Object ID {} not found in global registry", id));
+    if (entry == nullptr)
         return;
 
     // verify the object
-    DEBUG_CHECK_EX(curEntry->ptr.expired() || curEntry->ptr == object, TempString("Object ID {} is different that previoulsy registered", id));
+    DEBUG_CHECK_EX(entry->ptr.expired() || entry->ptr == object, TempString("Object ID {} is different that previoulsy registered", id));
 
-    // remove from hash bucket
-    *prevLink = curEntry->nextBucket;
+    // remove from lookup table, the holder may still be used by a reader
+    shard.retiredHolders.pushBack(table->holders[slot].load(std::memory_order_relaxed));
+    table->entries[slot] = nullptr;
+    table->holders[slot].store(nullptr, std::memory_order_seq_cst);
+    table->ids[slot].store(LookupTable::DELETED_ID, std::memory_order_seq_cst);
 
     // remove from object list
-    if (curEntry->nextAll)
+    if (auto* list = entry->list)
     {
-        DEBUG_CHECK(curEntry != m_objectListTail);
-        curEntry->nextAll->prevAll = curEntry->prevAll;
+        helper::UnlinkEntry(list->head, entry);
+        list->count -= 1;
     }
     else
     {
-        DEBUG_CHECK(curEntry == m_objectListTail);
-        m_objectListTail = curEntry->prevAll;
-    }
-
-    if (curEntry->prevAll)
-    {
-        DEBUG_CHECK(curEntry != m_objectListHead);
-        curEntry->prevAll->nextAll = curEntry->nextAll;
-    }
-    else
-    {
-        DEBUG_CHECK(curEntry == m_objectListHead);
-        m_objectListHead = curEntry->nextAll;
+        helper::UnlinkEntry(shard.pendingList, entry);
     }
 
     // release entry to memory pool
-    curEntry->ptr.reset();
-    m_objectEntryPool.release(curEntry);
-    m_objectCount -= 1;
+    entry->~ObjectEntry();
+    shard.entryPool.release(entry);
+    shard.numObjects -= 1;
+
+    // free retired data if no reader can see it
+    // NOTE: must be sequentially consistent with the stores above, see findObject
+    if (shard.numReaders.load(std::memory_order_seq_cst) == 0)
+        shard.freeRetired();
 }
 
 //--
 
 END_BOOMER_NAMESPACE()
-
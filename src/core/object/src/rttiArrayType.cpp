@@ -8,6 +8,7 @@
 
 #include "build.h"
 #include "rttiArrayType.h"
+#include "rttiClassType.h"
 
 #include "streamOpcodeWriter.h"
 #include "streamOpcodeReader.h"
@@ -65,6 +66,27 @@ void IArrayType::writeBinary(TypeSerializationContext& typeContext, stream::Opco
     uint32_t size = arraySize(data);
     file.beginArray(size);
 
+    // arrays of structures with raw data only are saved as one memory block
+    if (size && m_innerType->metaType() == MetaType::Class && file.allowBulkData())
+    {
+        const auto* innerClass = static_cast<const IClassType*>(m_innerType.ptr());
+        if (innerClass->binaryLayoutHash())
+        {
+            innerClass->writeBinaryBulk(typeContext, file, arrayElementData(data, 0), size);
+            file.endArray();
+            return;
+        }
+    }
+
+    // arrays of simple values are saved as one memory block
+    // NOTE: in unprotected streams this is the same data as saving the values one by one
+    if (size && m_innerType->traits().binaryRawData && file.allowBulkData())
+    {
+        file.writeData(arrayElementData(data, 0), size * m_innerType->size());
+        file.endArray();
+        return;
+    }
+
     // save elements
     const auto defaultSize = defaultData ? arraySize(defaultData) : 0;
     for (uint32_t i = 0; i < size; ++i)
@@ -98,8 +120,36 @@ void IArrayType::readBinary(TypeSerializationContext& typeContext, stream::Opcod
         auto* writePtr = (uint8_t*)arrayElementData(data, 0);
         auto writeStride = m_innerType->size();
 
-        // read elements
         auto capacity = maxArrayCapacity(data);
+
+        // structures may be saved as one memory block
+        if (m_innerType->metaType() == MetaType::Class)
+        {
+            static_cast<const IClassType*>(m_innerType.ptr())->readBinaryArray(typeContext, file, writePtr, size, capacity);
+            file.leaveArray();
+            return;
+        }
+
+        // simple values may be saved as one memory block in newer files, protected streams tell us the size of the block
+        uint64_t savedDataSize = 0;
+        if (m_innerType->traits().binaryRawData && file.version() >= VER_BULK_BINARY_DATA
+            && (!file.peekDataSize(savedDataSize) || savedDataSize == (uint64_t)size * writeStride))
+        {
+            if (size <= capacity)
+            {
+                file.readData(writePtr, size * writeStride);
+            }
+            else
+            {
+                const auto* readPtr = file.pointer(size * writeStride);
+                memcpy(writePtr, readPtr, capacity * writeStride);
+            }
+
+            file.leaveArray();
+            return;
+        }
+
+        // read elements
         for (uint32_t i = 0; i < size; ++i, writePtr += writeStride)
         {
             if (i < capacity)
@@ -18,6 +18,7 @@
 
 #include "streamOpcodeWriter.h"
 #include "streamOpcodeReader.h"
+#include "core/containers/include/crc.h"
 #include "core/xml/include/xmlWrappers.h"
 
 BEGIN_BOOMER_NAMESPACE()
@@ -253,6 +254,13 @@ void IClassType::writeBinary(TypeSerializationContext& typeContext, stream::Opco
 {
     TypeSerializationContextSetClass classContext(typeContext, this);
 
+    // classes with raw data only are saved as a memory block, no need to compare with defaults
+    if (file.allowBulkData() && binaryLayoutHash())
+    {
+        writeBinaryBulk(typeContext, file, data, 1);
+        return;
+    }
+
     // get the default context for saving if not specified
     if (!defaultData)
         defaultData = defaultObject();
@@ -333,12 +341,20 @@ namespace helper
 
 void IClassType::readBinary(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data) const
 {
-    TypeSerializationContextSetClass classContext(typeContext, this);
-
-    // enter compound block and read properties
+    // enter compound block, class may be saved as tagged properties or as a memory block
     uint32_t propertyCount = 0;
     file.enterCompound(propertyCount);
 
+    if (propertyCount == stream::StreamOpCompound::BULK_LAYOUT)
+        readBinaryBulk(typeContext, file, data, 1, 1);
+    else
+        readBinaryProperties(typeContext, file, data, propertyCount);
+}
+
+void IClassType::readBinaryProperties(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t propertyCount) const
+{
+    TypeSerializationContextSetClass classContext(typeContext, this);
+
     for (uint32_t i = 0; i < propertyCount; ++i)
     {
         // read the property reference
@@ -418,6 +434,395 @@ void IClassType::readBinary(TypeSerializationContext& typeContext, stream::Opcod
 
 //--
 
+void IClassType::ReadBinaryLayout(stream::OpcodeReader& file, Array<stream::OpcodeBulkLayoutField>& outFields, uint32_t& outFirstField, uint32_t& outNumFields)
+{
+    uint32_t count = 0;
+    file.enterArray(count);
+
+    // fields of one class are placed next to each other, nested fields are placed after them
+    outFirstField = outFields.size();
+    outNumFields = count;
+    outFields.resize(outFirstField + count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto index = outFirstField + i;
+        outFields[index].name = file.readStringID();
+        outFields[index].type = file.readType(outFields[index].typeName);
+        file.readTypedData(outFields[index].offset);
+
+        uint32_t firstChild = 0, numChildren = 0;
+        ReadBinaryLayout(file, outFields, firstChild, numChildren);
+        outFields[index].firstChild = firstChild;
+        outFields[index].numChildren = numChildren;
+    }
+
+    file.leaveArray();
+}
+
+void IClassType::WriteBinaryLayoutTable(stream::OpcodeWriter& file, const Array<Type>& layouts)
+{
+    file.beginArray(layouts.size());
+
+    for (const auto& type : layouts)
+    {
+        const auto* classType = static_cast<const IClassType*>(type.ptr());
+        file.writeTypedData<uint64_t>(classType->binaryLayoutHash());
+        file.writeTypedData<uint32_t>(classType->size());
+        classType->writeBinaryLayout(file);
+    }
+
+    file.endArray();
+}
+
+void IClassType::ReadBinaryLayoutTable(stream::OpcodeReader& file)
+{
+    uint32_t count = 0;
+    file.enterArray(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto& layout = file.addBulkLayout();
+        file.readTypedData(layout.hash);
+        file.readTypedData(layout.size);
+        ReadBinaryLayout(file, layout.fields, layout.firstField, layout.numFields);
+    }
+
+    file.leaveArray();
+}
+
+void IClassType::applyBinaryLayout(TypeSerializationContext& typeContext, const Array<stream::OpcodeBulkLayoutField>& fields, uint32_t firstField, uint32_t numFields, const uint8_t* srcData, uint32_t srcSize, void* data) const
+{
+    TypeSerializationContextSetClass classContext(typeContext, this);
+
+    for (uint32_t i = 0; i < numFields; ++i)
+    {
+        const auto& field = fields[firstField + i];
+
+        // we can't interpret data of a type that is gone
+        if (!field.type)
+        {
+            TRACE_WARNING("Lost property '{}' in bulk data of '{}': saved with missing type '{}'", field.name, name(), field.typeName);
+            continue;
+        }
+
+        // only the raw data and nested structures could have been saved in bulk
+        const auto* fieldClass = (field.numChildren && field.type->metaType() == MetaType::Class) ? static_cast<const IClassType*>(field.type.ptr()) : nullptr;
+        if (!fieldClass && !field.type->traits().binaryRawData)
+        {
+            TRACE_WARNING("Lost property '{}' in bulk data of '{}': type '{}' is no longer a raw data", field.name, name(), field.typeName);
+            continue;
+        }
+
+        if (field.offset > srcSize || (!fieldClass && field.offset + field.type->size() > srcSize))
+        {
+            TRACE_WARNING("Lost property '{}' in bulk data of '{}': data out of range", field.name, name());
+            continue;
+        }
+
+        const auto* fieldData = srcData + field.offset;
+        const auto fieldDataSize = srcSize - field.offset;
+
+        // property is gone, still allow for the recovery of raw values
+        const auto* prop = findProperty(field.name);
+        if (!prop)
+        {
+            if (!fieldClass)
+                handlePropertyMissing(typeContext, field.name, field.type, fieldData);
+            continue;
+        }
+
+        TypeSerializationContextSetProperty propertyContext(typeContext, prop);
+
+        void* targetData = prop->offsetPtr(data);
+        if (prop->type() == field.type)
+        {
+            if (fieldClass)
+                fieldClass->applyBinaryLayout(typeContext, fields, field.firstChild, field.numChildren, fieldData, fieldDataSize, targetData);
+            else
+                memcpy(targetData, fieldData, field.type->size());
+        }
+        else
+        {
+            // load to a temporary data holder
+            DataHolder tempData(field.type);
+            if (fieldClass)
+                fieldClass->applyBinaryLayout(typeContext, fields, field.firstChild, field.numChildren, fieldData, fieldDataSize, tempData.data());
+            else
+                memcpy(tempData.data(), fieldData, field.type->size());
+
+            // try automatic conversion
+            if (!ConvertData(tempData.data(), tempData.type(), targetData, prop->type()))
+            {
+                TRACE_INFO("Property '{}' in class '{}' was saved with type '{}' not now is of type '{}'. We will attempt automatic conversion",
+                    field.name, name(), field.typeName, prop->type());
+
+                handlePropertyTypeChange(typeContext, field.name, field.type, tempData.data(), prop->type(), targetData);
+            }
+        }
+    }
+}
+
+uint64_t IClassType::binaryLayoutHash() const
+{
+    if (!m_binaryLayoutCached)
+    {
+        // NOTE: computed outside the lock since it uses other cached tables (and layouts of nested classes)
+        const auto& props = allProperties();
+
+        // objects have custom serialization logic and scripted classes have no fixed layout
+        bool bulk = !traits().scripted && !is<IObject>() && !props.empty();
+
+        CRC64 crc;
+        crc << size();
+
+        Array<BinaryLayoutRange> ranges;
+        for (const auto* prop : props)
+        {
+            if (!bulk)
+                break;
+
+            // transient properties must stay untouched when loading
+            const auto propType = prop->type();
+            if (prop->flags().test(PropertyFlagBit::Transient))
+            {
+                bulk = false;
+            }
+            else if (propType->traits().binaryRawData)
+            {
+                auto& range = ranges.emplaceBack();
+                range.offset = prop->offset();
+                range.size = propType->size();
+                crc << prop->name() << prop->offset() << propType->name();
+            }
+            else if (propType->metaType() == MetaType::Class)
+            {
+                const auto* propClass = static_cast<const IClassType*>(propType.ptr());
+                if (const auto propClassHash = propClass->binaryLayoutHash())
+                {
+                    for (const auto& propRange : propClass->m_binaryLayoutRanges)
+                    {
+                        auto& range = ranges.emplaceBack();
+                        range.offset = prop->offset() + propRange.offset;
+                        range.size = propRange.size;
+                    }
+
+                    crc << prop->name() << prop->offset() << propType->name() << propClassHash;
+                }
+                else
+                {
+                    bulk = false;
+                }
+            }
+            else
+            {
+                bulk = false;
+            }
+        }
+
+        // merge adjacent ranges, overlapping properties are not supported
+        Array<BinaryLayoutRange> mergedRanges;
+        if (bulk)
+        {
+            std::sort(ranges.begin(), ranges.end(), [](const BinaryLayoutRange& a, const BinaryLayoutRange& b) { return a.offset < b.offset; });
+            for (const auto& range : ranges)
+            {
+                const auto lastEnd = mergedRanges.empty() ? 0 : mergedRanges.back().offset + mergedRanges.back().size;
+                if (lastEnd > range.offset)
+                {
+                    bulk = false;
+                    break;
+                }
+
+                if (!mergedRanges.empty() && lastEnd == range.offset)
+                    mergedRanges.back().size += range.size;
+                else
+                    mergedRanges.pushBack(range);
+            }
+
+            if (mergedRanges.empty() || mergedRanges.back().offset + mergedRanges.back().size > size())
+                bulk = false;
+        }
+
+        m_allTablesLock.acquire();
+
+        if (!m_binaryLayoutCached)
+        {
+            if (bulk)
+            {
+                m_binaryLayoutRanges = std::move(mergedRanges);
+                m_binaryLayoutHash = crc.crc() ? crc.crc() : 1;
+            }
+
+            m_binaryLayoutCached = true;
+        }
+
+        m_allTablesLock.release();
+    }
+
+    return m_binaryLayoutHash;
+}
+
+void IClassType::writeBinaryLayout(stream::OpcodeWriter& file) const
+{
+    const auto& props = allProperties();
+
+    file.beginArray(props.size());
+
+    for (const auto* prop : props)
+    {
+        file.writeStringID(prop->name());
+        file.writeType(prop->type());
+        file.writeTypedData<uint32_t>(prop->offset());
+
+        // nested structures describe their properties as well
+        if (prop->type()->metaType() == MetaType::Class)
+        {
+            static_cast<const IClassType*>(prop->type().ptr())->writeBinaryLayout(file);
+        }
+        else
+        {
+            file.beginArray(0);
+            file.endArray();
+        }
+    }
+
+    file.endArray();
+}
+
+void IClassType::writeBinaryBulk(TypeSerializationContext& typeContext, stream::OpcodeWriter& file, const void* data, uint32_t count) const
+{
+    DEBUG_CHECK_EX(binaryLayoutHash() != 0, "Class can't be saved in bulk");
+
+    file.beginBulkCompound(this);
+
+    // reference to the layout description in the layout table, allows to read the data even if the class has changed
+    const auto layoutIndex = file.mapBulkLayout(this);
+    file.writeTypedData<uint32_t>(layoutIndex);
+
+    // copy only the memory of the properties, padding and not exposed members are saved as zeros to keep the files deterministic
+    if (count)
+    {
+        const auto dataSize = size() * count;
+
+        InplaceArray<uint8_t, 1024> buffer;
+        buffer.resizeWith(dataSize, 0);
+
+        const auto* readPtr = (const uint8_t*)data;
+        auto* writePtr = buffer.data();
+        for (uint32_t i = 0; i < count; ++i, readPtr += size(), writePtr += size())
+            for (const auto& range : m_binaryLayoutRanges)
+                memcpy(writePtr + range.offset, readPtr + range.offset, range.size);
+
+        file.writeData(buffer.data(), dataSize);
+    }
+
+    file.endCompound();
+}
+
+void IClassType::readBinaryBulk(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t count, uint32_t capacity) const
+{
+    // layout description is stored in the layout table at the head of the stream
+    uint32_t layoutIndex = 0;
+    file.readTypedData(layoutIndex);
+
+    const auto* layout = file.bulkLayout(layoutIndex);
+    if (!layout && file.version() < VER_BULK_LAYOUT_TABLE && layoutIndex == file.numBulkLayouts())
+    {
+        // older files stored the layout with the first block of given type
+        auto& newLayout = file.addBulkLayout();
+        file.readTypedData(newLayout.hash);
+        file.readTypedData(newLayout.size);
+        ReadBinaryLayout(file, newLayout.fields, newLayout.firstField, newLayout.numFields);
+        layout = &newLayout;
+    }
+
+    if (!layout)
+    {
+        TRACE_WARNING("Invalid bulk layout index {} in data of '{}' ({} layouts in stream)", layoutIndex, name(), file.numBulkLayouts());
+        file.reportCorruption();
+
+        // without the layout we don't know the size of the data, we can skip it only in the protected stream
+        uint64_t dataSize = 0;
+        if (count && file.peekDataSize(dataSize))
+            file.pointer(dataSize);
+
+        file.leaveCompound();
+        return;
+    }
+
+    if (count)
+    {
+        const auto savedSize = layout->size;
+        const auto* srcData = (const uint8_t*)file.pointer((uint64_t)savedSize * count);
+        const auto numElements = std::min<uint32_t>(count, capacity);
+
+        if (layout->hash == binaryLayoutHash() && savedSize == size())
+        {
+            // same layout, if properties cover whole class we can copy everything at once
+            if (m_binaryLayoutRanges.size() == 1 && m_binaryLayoutRanges[0].offset == 0 && m_binaryLayoutRanges[0].size == size())
+            {
+                memcpy(data, srcData, (uint64_t)size() * numElements);
+            }
+            else
+            {
+                auto* writePtr = (uint8_t*)data;
+                for (uint32_t i = 0; i < numElements; ++i, srcData += size(), writePtr += size())
+                    for (const auto& range : m_binaryLayoutRanges)
+                        memcpy(writePtr + range.offset, srcData + range.offset, range.size);
+            }
+        }
+        else
+        {
+            // class changed since the data was saved, match the properties by name
+            auto* writePtr = (uint8_t*)data;
+            for (uint32_t i = 0; i < numElements; ++i, srcData += savedSize, writePtr += size())
+                applyBinaryLayout(typeContext, layout->fields, layout->firstField, layout->numFields, srcData, savedSize, writePtr);
+        }
+    }
+
+    file.leaveCompound();
+}
+
+void IClassType::readBinaryArray(TypeSerializationContext& typeContext, stream::OpcodeReader& file, void* data, uint32_t count, uint32_t capacity) const
+{
+    if (!count)
+        return;
+
+    // array of structures is saved in bulk or as separate compounds
+    uint32_t propertyCount = 0;
+    file.enterCompound(propertyCount);
+
+    if (propertyCount == stream::StreamOpCompound::BULK_LAYOUT)
+    {
+        readBinaryBulk(typeContext, file, data, count, capacity);
+        return;
+    }
+
+    auto* writePtr = (uint8_t*)data;
+    for (uint32_t i = 0; i < count; ++i, writePtr += size())
+    {
+        if (i < capacity)
+        {
+            if (i == 0)
+                readBinaryProperties(typeContext, file, writePtr, propertyCount);
+            else
+                readBinary(typeContext, file, writePtr);
+        }
+        else
+        {
+            // read and discard the elements that won't fit into the array
+            DataHolder holder(this);
+            if (i == 0)
+                readBinaryProperties(typeContext, file, holder.data(), propertyCount);
+            else
+                readBinary(typeContext, file, holder.data());
+        }
+    }
+}
+
+//--
+
 void IClassType::writeXML(TypeSerializationContext& typeContext, xml::Node& node, const void* data, const void* defaultData) const
 {
     TypeSerializationContextSetClass classContext(typeContext, this);
@@ -836,6 +1241,7 @@ void IClassType::baseClass(ClassType baseClass)
 
     m_baseClass = baseClass.ptr();
     m_allPropertiesCached = false;
+    m_binaryLayoutCached = false;
 
     if (m_baseClass && m_baseClass->name().view().endsWith("Metadata"))
     {
@@ -850,6 +1256,7 @@ void IClassType::addProperty(Property* property)
 
     m_localProperties.pushBack(property);
     m_allPropertiesCached = false;
+    m_binaryLayoutCached = false;
 }
 
 void IClassType::addFunction(Function* function)
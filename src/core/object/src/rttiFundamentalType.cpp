@@ -33,6 +33,7 @@ public:
         m_traits.requiresDestructor = false;
         m_traits.initializedFromZeroMem = true;
         m_traits.simpleCopyCompare = true;
+        m_traits.binaryRawData = true;
     }
 
     virtual void construct(void* object) const override final
@@ -131,6 +132,7 @@ public:
         m_traits.initializedFromZeroMem = true;
         m_traits.requiresDestructor = true;
         m_traits.simpleCopyCompare = false;
+        m_traits.binaryRawData = false;
     }
 
     virtual void printToText(IFormatStream& f, const void* data, uint32_t flags) const override
@@ -215,6 +217,7 @@ public:
         m_traits.initializedFromZeroMem = true;
         m_traits.requiresDestructor = false;
         m_traits.simpleCopyCompare = true;
+        m_traits.binaryRawData = false; // saved as name
     }
 
     virtual void printToText(IFormatStream& f, const void* data, uint32_t flags) const override
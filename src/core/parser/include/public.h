@@ -41,6 +41,7 @@ class IErrorReporter;
 class SimpleLanguageDefinitionBuilder;
 
 class TextParser;
+class TextIncludeCache;
 
 //-----
 
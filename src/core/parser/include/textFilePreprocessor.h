@@ -10,6 +10,7 @@
 
 #include "textToken.h"
 #include "textLanguageDefinition.h"
+#include "textIncludeCache.h"
 
 #include "core/memory/include/linearAllocator.h"
 #include "core/containers/include/hashMap.h"
@@ -41,6 +42,9 @@ public:
     /// process provided text content
     bool processContent(StringView content, StringView contextPath);
 
+    /// use shared cache of preprocessed included files, included files are processed only if they were not seen with the same macros before
+    void attachIncludeCache(TextIncludeCache* cache);
+
 protected:
     LinearAllocator& m_allocator;
 
@@ -80,6 +84,7 @@ protected:
         Array<StringBuf> m_arguments;
         Array<StringBuf> m_values;
         TokenList m_replacement;
+        uint64_t m_signature = 0; // hash of the definition, 0 if not defined
         bool m_hasArguments = false;
         bool m_defined = false;
     };
@@ -132,14 +137,46 @@ protected:
 
     //--
 
-    MacroDefinition* define(StringView name) const;
+    MacroDefinition* define(StringView name);
     MacroDefinition* createDefine(StringView name);
 
+    void macroChanged(MacroDefinition* macro);
+
     Token* copyToken(const Token* source, const Token* baseLocataion = nullptr);
     void copyTokens(const TokenList& list, TokenList& outList, const Token* baseLocataion = nullptr, bool isMacroArgument = false);
     bool createTokens(const Token* baseLocataion, StringView text, TokenList& outList);
 
     //--
+
+    // recording of the included file that is being processed, everything it used from outside and everything it changed
+    struct IncludeRecorder
+    {
+        const Token* lastTokenBefore = nullptr; // last output token before the file was included
+        uint32_t filterDepth = 0;
+
+        HashMap<StringBuf, uint64_t> macroReads;
+        HashMap<StringBuf, bool> pragmaOnceReads;
+        Array<TextIncludeCache::IncludeLoad> loads;
+
+        HashSet<StringBuf> macroWrites;
+        HashSet<StringBuf> pragmaOnceWrites;
+    };
+
+    TextIncludeCache* m_includeCache = nullptr;
+    Array<IncludeRecorder*> m_includeRecorders;
+
+    void recordMacroRead(StringView name, uint64_t signature);
+    void recordMacroWrite(StringView name);
+    void recordPragmaOnceRead(StringView path, bool processed);
+    void recordPragmaOnceWrite(StringView path);
+    void recordIncludeLoad(const TextIncludeCache::IncludeLoad& load);
+
+    bool processCachedInclude(uint64_t fileKey);
+    bool matchesCachedInclude(const TextIncludeCache::Variant& variant);
+    void applyCachedInclude(const TextIncludeCache::Variant& variant);
+    TextIncludeCache::Variant* createCachedInclude(const IncludeRecorder& recorder);
+
+    //--
 };
 
 ///----
@@ -0,0 +1,121 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: parser #]
+***/
+
+#pragma once
+
+#include "textToken.h"
+
+#include "core/memory/include/linearAllocator.h"
+#include "core/containers/include/hashMap.h"
+#include "core/containers/include/inplaceArray.h"
+
+BEGIN_BOOMER_NAMESPACE_EX(parser)
+
+///----
+
+/// cache of preprocessed included files, can be shared by many preprocessors running at the same time
+/// result of preprocessing an included file depends on the macros it used, every combination of used macros is stored as separate variant
+/// NOTE: variants are never released while the cache exists, preprocessed tokens point directly to the memory of the variant
+class CORE_PARSER_API TextIncludeCache : public NoCopy
+{
+public:
+    TextIncludeCache(uint32_t maxVariantsPerFile = 64);
+    ~TextIncludeCache();
+
+    //--
+
+    /// state of macro used by the included file, signature of 0 means macro was not defined
+    struct MacroRead
+    {
+        StringBuf name;
+        uint64_t signature = 0;
+    };
+
+    /// state of the "#pragma once" flag of a file the included file depended on
+    struct PragmaOnceRead
+    {
+        StringBuf path;
+        bool processed = false;
+    };
+
+    /// other file that was included
+    struct IncludeLoad
+    {
+        bool global = false;
+        StringBuf path;
+        StringBuf referencePath;
+        StringBuf resolvedPath;
+        uint64_t contentHash = 0;
+    };
+
+    /// macro that was defined or undefined by the included file
+    struct MacroWrite
+    {
+        StringBuf name;
+        Location definedAt;
+        Array<StringBuf> arguments;
+        TokenList replacement;
+        uint64_t signature = 0;
+        bool hasArguments = false;
+        bool defined = false;
+    };
+
+    /// result of preprocessing included file with particular state of macros
+    struct Variant : public NoCopy
+    {
+        LinearAllocator mem; // tokens and their text
+
+        Array<MacroRead> macroReads;
+        Array<PragmaOnceRead> pragmaOnceReads;
+        Array<IncludeLoad> loads;
+
+        TokenList tokens;
+        Array<MacroWrite> macroWrites;
+        Array<StringBuf> pragmaOnceWrites;
+
+        Variant();
+    };
+
+    //--
+
+    /// compute key of included file
+    static uint64_t CalcFileKey(StringView resolvedPath, uint64_t contentHash);
+
+    /// get existing variants of included file
+    void findVariants(uint64_t fileKey, Array<const Variant*>& outVariants) const;
+
+    /// store new variant of included file, the cache takes ownership
+    void storeVariant(uint64_t fileKey, Variant* variant);
+
+    //--
+
+    /// report use of the cache
+    void reportHit();
+    void reportMiss();
+
+    /// number of included files that were reused/processed
+    INLINE uint32_t numHits() const { return m_numHits.load(); }
+    INLINE uint32_t numMisses() const { return m_numMisses.load(); }
+
+    /// print stats
+    void print(IFormatStream& f) const;
+
+private:
+    uint32_t m_maxVariantsPerFile = 64;
+
+    SpinLock m_lock;
+    HashMap<uint64_t, Array<const Variant*>> m_files;
+    Array<Variant*> m_variants;
+
+    std::atomic<uint32_t> m_numHits = 0;
+    std::atomic<uint32_t> m_numMisses = 0;
+};
+
+///----
+
+END_BOOMER_NAMESPACE_EX(parser)
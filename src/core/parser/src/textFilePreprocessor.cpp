@@ -11,6 +11,9 @@
 #include "textParser.h"
 #include "textFilePreprocessor.h"
 
+#include "core/containers/include/crc.h"
+#include "core/containers/include/contentHash.h"
+
 //#define TRACE_DEEP(txt, ...) TRACE_INFO(txt, __VA_ARGS__)
 #define TRACE_DEEP(txt, ...) 
 
@@ -83,6 +86,7 @@ bool TextFilePreprocessor::defineSymbol(StringView name, StringView value)
     macro->m_arguments.clear();
     macro->m_replacement = std::move(replacements);
     macro->m_values.pushBack(valueStr);
+    macroChanged(macro);
 
     TRACE_DEEP("Defined '{}' = '{}'", name, macro->m_replacement);
     return true;
@@ -90,7 +94,7 @@ bool TextFilePreprocessor::defineSymbol(StringView name, StringView value)
 
 Token* TextFilePreprocessor::copyToken(const Token* source, const Token* baseLocataion)
 {
-    auto ret  = m_allocator.createNoCleanup<Token>(*source);
+    auto ret  = m_allocator.create<Token>(*source);
 
     if (!baseLocataion)
         ret->assignLocation(source->location());
@@ -133,7 +137,7 @@ bool TextFilePreprocessor::createTokens(const Token* baseLocataion, StringView t
         if (ptr == end)
             break;
 
-        auto token  = m_allocator.createNoCleanup<Token>();
+        auto token  = m_allocator.create<Token>();
         if (!m_parentLanguage.eatToken(ptr, end, *token))
             return false;
 
@@ -294,6 +298,7 @@ bool TextFilePreprocessor::processDefine(const Token* head, TokenList& line)
         macro->m_replacement = std::move(line);
     }
 
+    macroChanged(macro);
     return true;
 }
 
@@ -321,6 +326,7 @@ bool TextFilePreprocessor::processUndef(const Token* head, TokenList& line)
     macro->m_arguments.clear();
     macro->m_replacement.clear();
     macro->m_hasArguments = false;
+    macroChanged(macro);
     return true;
 }
 
@@ -371,6 +377,25 @@ bool TextFilePreprocessor::processInclude(const Token* head, TokenList& line)
             return false;
         }
 
+        // reuse results of previous processing of this file if the macros it used did not change
+        uint64_t cachedFileKey = 0;
+        if (m_includeCache)
+        {
+            TextIncludeCache::IncludeLoad load;
+            load.global = includeGlobal;
+            load.path = includePath;
+            load.referencePath = head->location().contextName();
+            load.resolvedPath = loadedContentContextPath;
+            load.contentHash = ContentHash64(loadedContent.data(), loadedContent.size());
+
+            if (!m_includeRecorders.empty())
+                recordIncludeLoad(load);
+
+            cachedFileKey = TextIncludeCache::CalcFileKey(loadedContentContextPath, load.contentHash);
+            if (processCachedInclude(cachedFileKey))
+                return true;
+        }
+
         m_currentIncludeStack.pushBack(loadedContentContextPath);
 
         auto contextName  = m_allocator.strcpy(loadedContentContextPath.c_str());
@@ -382,13 +407,29 @@ bool TextFilePreprocessor::processInclude(const Token* head, TokenList& line)
             includedContent = StringView((const char*)loadedContent.data(), (const char*)loadedContent.data() + loadedContent.size());
         }
 
-        if (!processContent(includedContent, loadedContentContextPath.view()))
+        IncludeRecorder recorder;
+        if (m_includeCache)
         {
-            m_currentIncludeStack.popBack();
-            return false;
+            recorder.lastTokenBefore = m_finalTokens.tail();
+            recorder.filterDepth = m_filterStack.size();
+            m_includeRecorders.pushBack(&recorder);
+        }
+
+        const auto valid = processContent(includedContent, loadedContentContextPath.view());
+
+        if (m_includeCache)
+        {
+            m_includeRecorders.popBack();
+
+            // NOTE: file that leaves unterminated #if behind can't be reused
+            if (valid && recorder.filterDepth == m_filterStack.size())
+                m_includeCache->storeVariant(cachedFileKey, createCachedInclude(recorder));
         }
 
         m_currentIncludeStack.popBack();
+
+        if (!valid)
+            return false;
     }
     else
     {
@@ -544,11 +585,23 @@ bool TextFilePreprocessor::processPragma(const Token* head, TokenList& line, boo
         if (!m_currentIncludeStack.empty())
         {
             auto includePath = m_currentIncludeStack.back();
-            if (!m_pragmaOnceFilePaths.insert(includePath))
+            const auto alreadyProcessed = m_pragmaOnceFilePaths.contains(includePath);
+
+            if (!m_includeRecorders.empty())
+                recordPragmaOnceRead(includePath, alreadyProcessed);
+
+            if (alreadyProcessed)
             {
                 TRACE_DEEP("{}: detected that file was already processed", head->location());
                 keepProcessing = false;
             }
+            else
+            {
+                m_pragmaOnceFilePaths.insert(includePath);
+
+                if (!m_includeRecorders.empty())
+                    recordPragmaOnceWrite(includePath);
+            }
         }
     }
     else if (pragmaType == "line")
@@ -660,10 +713,15 @@ bool TextFilePreprocessor::processContent(StringView content, StringView context
 
 //---
 
-TextFilePreprocessor::MacroDefinition* TextFilePreprocessor::define(StringView name) const
+TextFilePreprocessor::MacroDefinition* TextFilePreprocessor::define(StringView name)
 {
     MacroDefinition* ret = nullptr;
     m_defineMap.find(name, ret);
+
+    // result of processing included file depends on all the macros it looked at, even the not defined ones
+    if (!m_includeRecorders.empty())
+        recordMacroRead(name, ret ? ret->m_signature : 0);
+
     return ret;
 }
 
@@ -680,6 +738,234 @@ TextFilePreprocessor::MacroDefinition* TextFilePreprocessor::createDefine(String
     return ret;
 }
 
+void TextFilePreprocessor::macroChanged(MacroDefinition* macro)
+{
+    if (macro->m_defined)
+    {
+        CRC64 crc;
+        crc << macro->m_name;
+        crc << (uint8_t)macro->m_hasArguments;
+
+        for (const auto& arg : macro->m_arguments)
+            crc << arg;
+
+        for (auto token = macro->m_replacement.head(); token; token = token->next())
+        {
+            crc << (uint8_t)token->type();
+            crc << token->view();
+        }
+
+        macro->m_signature = crc.crc() ? crc.crc() : 1;
+    }
+    else
+    {
+        macro->m_signature = 0;
+    }
+
+    if (!m_includeRecorders.empty())
+        recordMacroWrite(macro->m_name);
+}
+
+//---
+
+void TextFilePreprocessor::attachIncludeCache(TextIncludeCache* cache)
+{
+    m_includeCache = cache;
+}
+
+void TextFilePreprocessor::recordMacroRead(StringView name, uint64_t signature)
+{
+    for (auto* recorder : m_includeRecorders)
+    {
+        // we only care about the state of the macro from before the file was included
+        if (!recorder->macroWrites.contains(name) && !recorder->macroReads.contains(name))
+            recorder->macroReads[StringBuf(name)] = signature;
+    }
+}
+
+void TextFilePreprocessor::recordMacroWrite(StringView name)
+{
+    for (auto* recorder : m_includeRecorders)
+        recorder->macroWrites.insert(StringBuf(name));
+}
+
+void TextFilePreprocessor::recordPragmaOnceRead(StringView path, bool processed)
+{
+    for (auto* recorder : m_includeRecorders)
+    {
+        if (!recorder->pragmaOnceWrites.contains(path) && !recorder->pragmaOnceReads.contains(path))
+            recorder->pragmaOnceReads[StringBuf(path)] = processed;
+    }
+}
+
+void TextFilePreprocessor::recordPragmaOnceWrite(StringView path)
+{
+    for (auto* recorder : m_includeRecorders)
+        recorder->pragmaOnceWrites.insert(StringBuf(path));
+}
+
+void TextFilePreprocessor::recordIncludeLoad(const TextIncludeCache::IncludeLoad& load)
+{
+    for (auto* recorder : m_includeRecorders)
+        recorder->loads.pushBack(load);
+}
+
+bool TextFilePreprocessor::processCachedInclude(uint64_t fileKey)
+{
+    InplaceArray<const TextIncludeCache::Variant*, 8> variants;
+    m_includeCache->findVariants(fileKey, variants);
+
+    for (const auto* variant : variants)
+    {
+        if (matchesCachedInclude(*variant))
+        {
+            applyCachedInclude(*variant);
+            m_includeCache->reportHit();
+            return true;
+        }
+    }
+
+    m_includeCache->reportMiss();
+    return false;
+}
+
+bool TextFilePreprocessor::matchesCachedInclude(const TextIncludeCache::Variant& variant)
+{
+    for (const auto& read : variant.macroReads)
+    {
+        MacroDefinition* macro = nullptr;
+        m_defineMap.find(read.name, macro);
+
+        const auto signature = macro ? macro->m_signature : 0;
+        if (signature != read.signature)
+            return false;
+    }
+
+    for (const auto& read : variant.pragmaOnceReads)
+        if (m_pragmaOnceFilePaths.contains(read.path) != read.processed)
+            return false;
+
+    // nested includes may resolve differently or may have changed since the variant was created
+    for (const auto& load : variant.loads)
+    {
+        Buffer content;
+        StringBuf resolvedPath;
+        if (!m_includeHandler.loadInclude(load.global, load.path, load.referencePath, content, resolvedPath))
+            return false;
+
+        if (resolvedPath != load.resolvedPath)
+            return false;
+
+        if (ContentHash64(content.data(), content.size()) != load.contentHash)
+            return false;
+    }
+
+    return true;
+}
+
+void TextFilePreprocessor::applyCachedInclude(const TextIncludeCache::Variant& variant)
+{
+    // outer files that are being recorded depend on the same things as the cached file
+    if (!m_includeRecorders.empty())
+    {
+        for (const auto& read : variant.macroReads)
+            recordMacroRead(read.name, read.signature);
+
+        for (const auto& read : variant.pragmaOnceReads)
+            recordPragmaOnceRead(read.path, read.processed);
+
+        for (const auto& load : variant.loads)
+            recordIncludeLoad(load);
+    }
+
+    for (auto token = variant.tokens.head(); token; token = token->next())
+        m_finalTokens.pushBack(copyToken(token));
+
+    for (const auto& write : variant.macroWrites)
+    {
+        auto macro = createDefine(write.name);
+        macro->m_definedAt = write.definedAt;
+        macro->m_defined = write.defined;
+        macro->m_hasArguments = write.hasArguments;
+        macro->m_arguments = write.arguments;
+        macro->m_replacement.clear();
+        copyTokens(write.replacement, macro->m_replacement);
+        macro->m_signature = write.signature;
+
+        if (!m_includeRecorders.empty())
+            recordMacroWrite(write.name);
+    }
+
+    for (const auto& path : variant.pragmaOnceWrites)
+    {
+        m_pragmaOnceFilePaths.insert(path);
+
+        if (!m_includeRecorders.empty())
+            recordPragmaOnceWrite(path);
+    }
+}
+
+namespace helper
+{
+    static void CopyCachedTokens(LinearAllocator& mem, const Token* token, TokenList& outList)
+    {
+        for (; token; token = token->next())
+        {
+            const auto view = token->view();
+            const auto* text = mem.strcpy(view.data(), view.length());
+
+            auto* copy = mem.create<Token>(token->type(), text, text + view.length(), token->keywordID());
+            copy->assignLocation(token->location());
+            outList.pushBack(copy);
+        }
+    }
+} // helper
+
+TextIncludeCache::Variant* TextFilePreprocessor::createCachedInclude(const IncludeRecorder& recorder)
+{
+    auto* variant = new TextIncludeCache::Variant();
+
+    // tokens produced by the file, text is copied since it may point into the file buffer or into our allocator
+    const auto* firstToken = recorder.lastTokenBefore ? recorder.lastTokenBefore->next() : m_finalTokens.head();
+    helper::CopyCachedTokens(variant->mem, firstToken, variant->tokens);
+
+    for (const auto& pair : recorder.macroReads.pairs())
+    {
+        auto& entry = variant->macroReads.emplaceBack();
+        entry.name = pair.key;
+        entry.signature = pair.value;
+    }
+
+    for (const auto& pair : recorder.pragmaOnceReads.pairs())
+    {
+        auto& entry = variant->pragmaOnceReads.emplaceBack();
+        entry.path = pair.key;
+        entry.processed = pair.value;
+    }
+
+    variant->loads = recorder.loads;
+
+    // final state of all the macros the file changed
+    for (const auto& name : recorder.macroWrites.keys())
+    {
+        MacroDefinition* macro = nullptr;
+        if (m_defineMap.find(name, macro))
+        {
+            auto& entry = variant->macroWrites.emplaceBack();
+            entry.name = macro->m_name;
+            entry.definedAt = macro->m_definedAt;
+            entry.arguments = macro->m_arguments;
+            entry.signature = macro->m_signature;
+            entry.hasArguments = macro->m_hasArguments;
+            entry.defined = macro->m_defined;
+            helper::CopyCachedTokens(variant->mem, macro->m_replacement.head(), entry.replacement);
+        }
+    }
+
+    variant->pragmaOnceWrites = recorder.pragmaOnceWrites.keys();
+    return variant;
+}
+
 bool TextFilePreprocessor::evaluateExpression(TokenList& list, bool& result)
 {
     if (list.empty())
@@ -0,0 +1,84 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: parser #]
+***/
+
+#include "build.h"
+#include "textIncludeCache.h"
+
+#include "core/containers/include/contentHash.h"
+
+BEGIN_BOOMER_NAMESPACE_EX(parser)
+
+//---
+
+TextIncludeCache::Variant::Variant()
+    : mem(POOL_TEMP)
+{}
+
+//---
+
+TextIncludeCache::TextIncludeCache(uint32_t maxVariantsPerFile)
+    : m_maxVariantsPerFile(maxVariantsPerFile)
+{}
+
+TextIncludeCache::~TextIncludeCache()
+{
+    m_files.clear();
+    m_variants.clearPtr();
+}
+
+uint64_t TextIncludeCache::CalcFileKey(StringView resolvedPath, uint64_t contentHash)
+{
+    return ContentHashCombine(ContentHash64(resolvedPath.data(), resolvedPath.length()), contentHash);
+}
+
+void TextIncludeCache::findVariants(uint64_t fileKey, Array<const Variant*>& outVariants) const
+{
+    auto lock = CreateLock(m_lock);
+
+    if (const auto* variants = m_files.find(fileKey))
+        outVariants.pushBack(variants->typedData(), variants->size());
+}
+
+void TextIncludeCache::storeVariant(uint64_t fileKey, Variant* variant)
+{
+    DEBUG_CHECK_RETURN_EX(variant, "Invalid variant");
+
+    auto lock = CreateLock(m_lock);
+
+    // file is included with too many different macro states, there's no point in caching it
+    auto& variants = m_files[fileKey];
+    if (variants.size() >= m_maxVariantsPerFile)
+    {
+        lock.release();
+        delete variant;
+        return;
+    }
+
+    variants.pushBack(variant);
+    m_variants.pushBack(variant);
+}
+
+void TextIncludeCache::reportHit()
+{
+    m_numHits += 1;
+}
+
+void TextIncludeCache::reportMiss()
+{
+    m_numMisses += 1;
+}
+
+void TextIncludeCache::print(IFormatStream& f) const
+{
+    auto lock = CreateLock(m_lock);
+    f.appendf("{} hits, {} misses, {} variants of {} files", m_numHits.load(), m_numMisses.load(), m_variants.size(), m_files.size());
+}
+
+//---
+
+END_BOOMER_NAMESPACE_EX(parser)
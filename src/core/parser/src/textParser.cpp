@@ -555,7 +555,7 @@ Token* TextParser::parseToken(LinearAllocator& mem, const ILanguageDefinition& l
 
     // parse
     auto cur  = m_pos;
-    auto token  = mem.createNoCleanup<Token>();
+    auto token  = mem.create<Token>();
     if (!language.eatToken(cur, m_end, *token))
         return nullptr;
 
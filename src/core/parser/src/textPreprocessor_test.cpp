@@ -1192,4 +1192,137 @@ TEST(Preprocessor, IfDefUndef)
     EXPECT_TRUE(test.tokens().empty());
 }
 
-END_BOOMER_NAMESPACE()
\ No newline at end of file
+//--
+
+class TestIncluderMap : public parser::IIncludeHandler
+{
+public:
+    HashMap<StringBuf, StringBuf> m_files;
+    uint32_t m_numLoads = 0;
+
+    virtual bool loadInclude(bool global, StringView path, StringView referencePath, Buffer& outContent, StringBuf& outPath) override
+    {
+        const auto* txt = m_files.find(path);
+        if (!txt)
+            return false;
+
+        outContent = Buffer::Create(POOL_TEMP, txt->length(), 1, txt->c_str());
+        outPath = StringBuf(path);
+        m_numLoads += 1;
+        return true;
+    }
+};
+
+static StringBuf PreprocessWithCache(TestIncluderMap& includer, parser::TextIncludeCache* cache, StringView code, StringView defineName = "")
+{
+    LinearAllocator allocator(POOL_TEMP);
+    HelperErrorReporter errorReporter;
+    parser::TextFilePreprocessor test(allocator, includer, errorReporter, parser::ICommentEater::StandardComments(), GetTestLanguage());
+    test.attachIncludeCache(cache);
+
+    if (!defineName.empty())
+        test.defineSymbol(defineName, "1");
+
+    if (!test.processContent(code, "TestFile"))
+        return "<error>";
+
+    StringBuilder txt;
+    for (auto t = test.tokens().head(); t; t = t->next())
+    {
+        if (!txt.empty())
+            txt.append(" ");
+        txt.append(t->view());
+    }
+
+    return txt.toString();
+}
+
+TEST(PreprocessorIncludeCache, CachedOutputMatches)
+{
+    TestIncluderMap includer;
+    includer.m_files["common"] = "#define SCALE(x) (x * 2)\nfloat common = SCALE(3);\n";
+    includer.m_files["other"] = "#include \"common\"\nfloat other = SCALE(common);\n";
+
+    const char* code = "#include \"other\"\nfloat main = SCALE(other);";
+
+    const auto reference = PreprocessWithCache(includer, nullptr, code);
+
+    parser::TextIncludeCache cache;
+    EXPECT_EQ(reference, PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(0, cache.numHits());
+    EXPECT_EQ(2, cache.numMisses());
+
+    EXPECT_EQ(reference, PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(1, cache.numHits());
+    EXPECT_EQ(2, cache.numMisses());
+}
+
+TEST(PreprocessorIncludeCache, DefinesSelectVariant)
+{
+    TestIncluderMap includer;
+    includer.m_files["other"] = "#ifdef MSAA\nmsaa\n#else\nno_msaa\n#endif\n";
+
+    const char* code = "#include \"other\"";
+
+    parser::TextIncludeCache cache;
+    EXPECT_EQ(StringBuf("no_msaa"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(StringBuf("msaa"), PreprocessWithCache(includer, &cache, code, "MSAA"));
+    EXPECT_EQ(0, cache.numHits());
+
+    EXPECT_EQ(StringBuf("msaa"), PreprocessWithCache(includer, &cache, code, "MSAA"));
+    EXPECT_EQ(StringBuf("no_msaa"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(2, cache.numHits());
+
+    // macros that were never looked at don't affect the reuse
+    EXPECT_EQ(StringBuf("no_msaa"), PreprocessWithCache(includer, &cache, code, "UNRELATED"));
+    EXPECT_EQ(3, cache.numHits());
+}
+
+TEST(PreprocessorIncludeCache, MacrosDefinedByIncludeAreRestored)
+{
+    TestIncluderMap includer;
+    includer.m_files["other"] = "#define VALUE 42\n#define ADD(a,b) a + b\n#undef MISSING\n";
+
+    const char* code = "#include \"other\"\nADD(VALUE, 1)\n#ifdef MISSING\nbad\n#endif";
+
+    parser::TextIncludeCache cache;
+    EXPECT_EQ(StringBuf("42 + 1"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(StringBuf("42 + 1"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(1, cache.numHits());
+
+    // different state of undefined macro, file must be processed again but the result is the same
+    EXPECT_EQ(StringBuf("42 + 1"), PreprocessWithCache(includer, &cache, code, "MISSING"));
+    EXPECT_EQ(1, cache.numHits());
+}
+
+TEST(PreprocessorIncludeCache, ChangedContentIsNotReused)
+{
+    TestIncluderMap includer;
+    includer.m_files["nested"] = "first";
+    includer.m_files["other"] = "#include \"nested\"\n";
+
+    const char* code = "#include \"other\"";
+
+    parser::TextIncludeCache cache;
+    EXPECT_EQ(StringBuf("first"), PreprocessWithCache(includer, &cache, code));
+
+    includer.m_files["nested"] = "second";
+    EXPECT_EQ(StringBuf("second"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(0, cache.numHits());
+}
+
+TEST(PreprocessorIncludeCache, PragmaOnceRespected)
+{
+    TestIncluderMap includer;
+    includer.m_files["once"] = "#pragma once\nonce\n";
+    includer.m_files["other"] = "#include \"once\"\nother\n";
+
+    const char* code = "#include \"once\"\n#include \"other\"";
+
+    parser::TextIncludeCache cache;
+    EXPECT_EQ(StringBuf("once other"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(StringBuf("once other"), PreprocessWithCache(includer, &cache, code));
+    EXPECT_EQ(StringBuf("once other"), PreprocessWithCache(includer, &cache, "#include \"other\"\n#include \"once\""));
+}
+
+END_BOOMER_NAMESPACE()
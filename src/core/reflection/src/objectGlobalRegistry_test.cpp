@@ -0,0 +1,298 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/object/include/objectGlobalRegistry.h"
+#include "core/system/include/thread.h"
+
+DECLARE_TEST_FILE(ObjectGlobalRegistry);
+
+BEGIN_BOOMER_NAMESPACE_EX(test);
+
+//--
+
+class RegistryTestA : public IObject
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(RegistryTestA, IObject);
+
+public:
+};
+
+RTTI_BEGIN_TYPE_CLASS(RegistryTestA);
+RTTI_END_TYPE();
+
+class RegistryTestA2 : public RegistryTestA
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(RegistryTestA2, RegistryTestA);
+
+public:
+};
+
+RTTI_BEGIN_TYPE_CLASS(RegistryTestA2);
+RTTI_END_TYPE();
+
+class RegistryTestB : public IObject
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(RegistryTestB, IObject);
+
+public:
+};
+
+RTTI_BEGIN_TYPE_CLASS(RegistryTestB);
+RTTI_END_TYPE();
+
+static uint32_t CountObjectsOfClass(ClassType cls);
+
+// classifies itself in the registry while still being constructed, registry sees it as the base class
+class RegistryTestC : public IObject
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(RegistryTestC, IObject);
+
+public:
+    static bool ClassifyInConstructor;
+
+    RegistryTestC()
+    {
+        if (ClassifyInConstructor)
+            CountObjectsOfClass(RegistryTestC::GetStaticClass());
+    }
+};
+
+bool RegistryTestC::ClassifyInConstructor = false;
+
+RTTI_BEGIN_TYPE_CLASS(RegistryTestC);
+RTTI_END_TYPE();
+
+class RegistryTestC2 : public RegistryTestC
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(RegistryTestC2, RegistryTestC);
+
+public:
+};
+
+RTTI_BEGIN_TYPE_CLASS(RegistryTestC2);
+RTTI_END_TYPE();
+
+//--
+
+static uint32_t CountObjectsOfClass(ClassType cls)
+{
+    uint32_t count = 0;
+    ObjectGlobalRegistry::GetInstance().iterateObjectsOfClass(cls, [&count](IObject*) { count += 1; return false; });
+    return count;
+}
+
+TEST(ObjectGlobalRegistry, CreatedObjectIsFound)
+{
+    auto obj = RefNew<RegistryTestA>();
+    ASSERT_NE(0, obj->id());
+
+    auto found = ObjectGlobalRegistry::GetInstance().findObject(obj->id());
+    EXPECT_EQ(obj.get(), found.get());
+}
+
+TEST(ObjectGlobalRegistry, DestroyedObjectIsNotFound)
+{
+    auto obj = RefNew<RegistryTestA>();
+    const auto id = obj->id();
+    obj.reset();
+
+    EXPECT_TRUE(ObjectGlobalRegistry::GetInstance().findObject(id).empty());
+}
+
+TEST(ObjectGlobalRegistry, InvalidIdIsNotFound)
+{
+    EXPECT_TRUE(ObjectGlobalRegistry::GetInstance().findObject(0).empty());
+    EXPECT_TRUE(ObjectGlobalRegistry::GetInstance().findObject(0xFFFFFFFF).empty());
+}
+
+TEST(ObjectGlobalRegistry, ManyObjectsAreFound)
+{
+    Array<RefPtr<RegistryTestA>> objects;
+    for (uint32_t i = 0; i < 20000; ++i)
+        objects.pushBack(RefNew<RegistryTestA>());
+
+    // destroy every other object to leave holes in the tables
+    for (uint32_t i = 0; i < objects.size(); i += 2)
+        objects[i].reset();
+
+    for (uint32_t i = 1; i < objects.size(); i += 2)
+        ASSERT_EQ(objects[i].get(), ObjectGlobalRegistry::GetInstance().findObject(objects[i]->id()).get());
+}
+
+TEST(ObjectGlobalRegistry, IterateClassVisitsOnlyMatchingObjects)
+{
+    const auto baseCountA = CountObjectsOfClass(RegistryTestA::GetStaticClass());
+    const auto baseCountA2 = CountObjectsOfClass(RegistryTestA2::GetStaticClass());
+    const auto baseCountB = CountObjectsOfClass(RegistryTestB::GetStaticClass());
+
+    Array<ObjectPtr> objects;
+    for (uint32_t i = 0; i < 10; ++i)
+        objects.pushBack(RefNew<RegistryTestA>());
+    for (uint32_t i = 0; i < 20; ++i)
+        objects.pushBack(RefNew<RegistryTestA2>());
+    for (uint32_t i = 0; i < 30; ++i)
+        objects.pushBack(RefNew<RegistryTestB>());
+
+    EXPECT_EQ(baseCountA + 30, CountObjectsOfClass(RegistryTestA::GetStaticClass()));
+    EXPECT_EQ(baseCountA2 + 20, CountObjectsOfClass(RegistryTestA2::GetStaticClass()));
+    EXPECT_EQ(baseCountB + 30, CountObjectsOfClass(RegistryTestB::GetStaticClass()));
+
+    objects.reset();
+
+    EXPECT_EQ(baseCountA, CountObjectsOfClass(RegistryTestA::GetStaticClass()));
+    EXPECT_EQ(baseCountA2, CountObjectsOfClass(RegistryTestA2::GetStaticClass()));
+    EXPECT_EQ(baseCountB, CountObjectsOfClass(RegistryTestB::GetStaticClass()));
+}
+
+TEST(ObjectGlobalRegistry, IterateClassFindsObjectsClassifiedDuringConstruction)
+{
+    // make sure there's a list for the final class in every shard before the base class list is created
+    Array<ObjectPtr> objects;
+    for (uint32_t i = 0; i < 256; ++i)
+        objects.pushBack(RefNew<RegistryTestC2>());
+
+    const auto count = CountObjectsOfClass(RegistryTestC2::GetStaticClass());
+    EXPECT_LE(256, count);
+
+    // these end up on the base class list and have to be moved to the existing list of the final class
+    RegistryTestC::ClassifyInConstructor = true;
+    for (uint32_t i = 0; i < 64; ++i)
+        objects.pushBack(RefNew<RegistryTestC2>());
+    RegistryTestC::ClassifyInConstructor = false;
+
+    EXPECT_EQ(count + 64, CountObjectsOfClass(RegistryTestC2::GetStaticClass()));
+    EXPECT_EQ(count + 64, CountObjectsOfClass(RegistryTestC::GetStaticClass()));
+}
+
+TEST(ObjectGlobalRegistry, IterateClassCanStop)
+{
+    Array<ObjectPtr> objects;
+    for (uint32_t i = 0; i < 10; ++i)
+        objects.pushBack(RefNew<RegistryTestB>());
+
+    uint32_t count = 0;
+    EXPECT_TRUE(ObjectGlobalRegistry::GetInstance().iterateObjectsOfClass(RegistryTestB::GetStaticClass(), [&count](IObject*) { return ++count == 5; }));
+    EXPECT_EQ(5, count);
+}
+
+TEST(ObjectGlobalRegistry, ObjectCanBeReleasedDuringIteration)
+{
+    Array<ObjectPtr> objects;
+    for (uint32_t i = 0; i < 10; ++i)
+        objects.pushBack(RefNew<RegistryTestB>());
+
+    // registry must not be locked while we are called
+    ObjectGlobalRegistry::GetInstance().iterateObjectsOfClass(RegistryTestB::GetStaticClass(), [&objects](IObject*) { objects.reset(); return false; });
+    EXPECT_EQ(0, CountObjectsOfClass(RegistryTestB::GetStaticClass()));
+}
+
+TEST(ObjectGlobalRegistry, ConcurrentCreateAndFind)
+{
+    static const uint32_t NUM_THREADS = 8;
+    static const uint32_t NUM_OBJECTS = 20000;
+
+    std::atomic<uint32_t> numErrors = 0;
+
+    Array<Thread> threads;
+    threads.resize(NUM_THREADS);
+
+    for (uint32_t i = 0; i < NUM_THREADS; ++i)
+    {
+        ThreadSetup setup;
+        setup.m_name = "RegistryTest";
+        setup.m_function = [&numErrors]()
+        {
+            // objects in the window are alive, all of them must be found
+            ObjectPtr window[16];
+            for (uint32_t j = 0; j < NUM_OBJECTS; ++j)
+            {
+                window[j % ARRAY_COUNT(window)] = RefNew<RegistryTestA>();
+
+                for (const auto& obj : window)
+                    if (obj && ObjectGlobalRegistry::GetInstance().findObject(obj->id()) != obj)
+                        numErrors += 1;
+            }
+        };
+        threads[i].init(setup);
+    }
+
+    for (auto& thread : threads)
+        thread.close();
+
+    EXPECT_EQ(0, numErrors.load());
+}
+
+//--
+
+TEST(ObjectGlobalRegistry, Perf_Contention)
+{
+    static const uint32_t NUM_OBJECTS = 100000; // per thread
+    static const uint32_t NUM_LOOKUPS = 4; // per created object
+
+    for (uint32_t numThreads = 1; numThreads <= 32; numThreads *= 2)
+    {
+        std::atomic<uint32_t> check = 0;
+
+        ScopeTimer timer;
+        {
+            Array<Thread> threads;
+            threads.resize(numThreads);
+
+            for (uint32_t i = 0; i < numThreads; ++i)
+            {
+                ThreadSetup setup;
+                setup.m_name = "RegistryPerf";
+                setup.m_function = [&check]()
+                {
+                    // keep a window of live objects, create, look up and destroy them all the time
+                    uint32_t localCheck = 0;
+                    ObjectPtr window[64];
+                    for (uint32_t j = 0; j < NUM_OBJECTS; ++j)
+                    {
+                        auto& slot = window[j % ARRAY_COUNT(window)];
+                        slot = RefNew<RegistryTestA>();
+
+                        for (uint32_t k = 0; k < NUM_LOOKUPS; ++k)
+                        {
+                            const auto& other = window[(j + k * 17) % ARRAY_COUNT(window)];
+                            if (other && ObjectGlobalRegistry::GetInstance().findObject(other->id()))
+                                localCheck += 1;
+                        }
+                    }
+                    check += localCheck;
+                };
+                threads[i].init(setup);
+            }
+
+            for (auto& thread : threads)
+                thread.close();
+        }
+
+        const auto timePerObject = timer.timeElapsed() / (NUM_OBJECTS * (double)numThreads);
+        TRACE_WARNING("ObjectGlobalRegistry with {} threads: {}, {} ns per created object ({})", numThreads, timer, Prec(timePerObject * 1e9, 1), check.load());
+    }
+
+    // class filtered iteration only visits the few objects of the class
+    {
+        Array<ObjectPtr> objects;
+        for (uint32_t i = 0; i < 100; ++i)
+            objects.pushBack(RefNew<RegistryTestA2>());
+
+        ScopeTimer timer;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < 100; ++i)
+            count += CountObjectsOfClass(RegistryTestA2::GetStaticClass());
+
+        TRACE_WARNING("ObjectGlobalRegistry class iteration over {} of {} objects: {}", count / 100, ObjectGlobalRegistry::GetInstance().totalObjectCount(), TimeInterval(timer.timeElapsed() / 100.0));
+    }
+}
+
+END_BOOMER_NAMESPACE_EX(test)
@@ -11,6 +11,8 @@
 #include "core/app/include/localService.h"
 #include "core/io/include/directoryWatcher.h"
 
+#include "depotArchive.h"
+
 BEGIN_BOOMER_NAMESPACE()
 
 //---
@@ -31,11 +33,18 @@ public:
     /// get absolute path to project depot directory
     INLINE const StringBuf& projectDepotPath() const { return m_projectDepotPath; }
 
+    /// get mounted packed archives, files in archives take precedence over the loose files
+    INLINE const Array<DepotArchivePtr>& archives() const { return m_archives; }
+
     //--
 
     /// get the file information
     bool queryFileTimestamp(StringView depotPath, TimeStamp& outTimestamp) const;
 
+    /// get the size of the data needed to load the objects from a serialized file without reading the header first
+    /// NOTE: known only for files in packed archives, returns 0 if not known
+    uint64_t queryFileKnownMainSize(StringView depotPath) const;
+
     /// if the file is loaded from a physical file query it's path
     /// NOTE: is present only for files physically on disk, not in archives or over the network
     bool queryFileAbsolutePath(StringView depotPath, StringBuf& outAbsolutePath) const;
@@ -56,6 +65,11 @@ public:
     /// NOTE: creating a reader may take some time
     AsyncFileHandlePtr createFileAsyncReader(StringView depotPath) const;
 
+    /// create a read only memory mapped view of the file's content, the file is unmapped when the last buffer reference is released
+    /// NOTE: the content is paged in lazily, first access to the data may stall
+    /// NOTE: only physical files on disk can be mapped, files in archives should be read with the async reader
+    Buffer createFileMappedView(StringView depotPath, FileMappingHint hint = FileMappingHint::Normal) const;
+
     //--
 
     struct DirectoryInfo
@@ -108,6 +122,11 @@ private:
     RefPtr<IDirectoryWatcher> m_engineObserver;
     RefPtr<IDirectoryWatcher> m_projectObserver;
 
+    Array<DepotArchivePtr> m_archives;
+
+    const DepotArchive::Entry* findArchiveFile(StringView depotPath, const DepotArchive** outArchive = nullptr) const;
+    void mountArchive(StringView absolutePath);
+
     //--
 
     virtual app::ServiceInitializationResult onInitializeService(const app::CommandLine& cmdLine) override final;
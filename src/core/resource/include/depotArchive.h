@@ -0,0 +1,142 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: service #]
+***/
+
+#pragma once
+
+#include "core/containers/include/array.h"
+#include "core/containers/include/stringBuf.h"
+#include "core/io/include/asyncFileHandle.h"
+#include "core/io/include/timestamp.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+/// Packed depot archive - read only container for many depot files, used in shipping builds instead of loose files
+/// Layout: [Header][Entries sorted by path][Hash table][Path strings] ... [File data, each entry page aligned]
+/// The whole table of contents is read once when archive is opened, file lookups are done with the hash table (O(1)) and never touch the disk
+class CORE_RESOURCE_API DepotArchive : public IReferencable
+{
+public:
+    static const uint32_t FILE_MAGIC;
+    static const uint32_t FILE_VERSION;
+    static const uint32_t DATA_ALIGNMENT; // alignment of the file data in the archive
+
+    struct Header
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t numEntries = 0; // number of files in the archive
+        uint32_t hashTableSize = 0; // number of slots in the hash table, power of two
+        uint32_t entriesOffset = 0; // offset to the entry table
+        uint32_t hashTableOffset = 0; // offset to the hash table
+        uint32_t stringsOffset = 0; // offset to the path strings
+        uint32_t stringsSize = 0; // size of the path strings
+        uint64_t tocSize = 0; // size of the header and all the tables, data starts after this
+        uint32_t tocCRC = 0; // CRC of the tables (not including the header)
+        uint32_t headerCRC = 0; // CRC of the header (not including this field)
+    };
+
+    struct Entry
+    {
+        uint64_t pathHash = 0; // CRC64 of the full depot path
+        uint32_t pathOffset = 0; // offset to the full depot path in the string table
+        uint32_t pathLength = 0; // length of the depot path
+        uint64_t dataOffset = 0; // offset to the data in the archive
+        uint64_t dataSize = 0; // size of the data stored in the archive (compressed size if compressed)
+        uint64_t size = 0; // size of the file after decompression
+        uint64_t timestamp = 0; // timestamp of the source file
+        uint64_t mainFileSize = 0; // for serialized resources: size of the data needed to load the objects (without the buffers), 0 for other files
+        uint32_t crc = 0; // CRC of the uncompressed data
+        CompressionType compression = CompressionType::Uncompressed;
+        uint8_t padding[3] = { 0,0,0 };
+    };
+
+    //--
+
+    /// open an archive, reads and validates the table of contents
+    /// NOTE: the file is kept open as long as the archive object exists
+    static DepotArchivePtr Open(StringView absolutePath);
+
+    DepotArchive(StringView path, AsyncFileHandlePtr file, Buffer toc); // use Open()
+    ~DepotArchive();
+
+    //--
+
+    /// absolute path to the archive file
+    INLINE const StringBuf& path() const { return m_path; }
+
+    /// number of files in the archive
+    INLINE uint32_t numFiles() const { return m_header->numEntries; }
+
+    /// get all entries (sorted by path)
+    INLINE const Entry* entries() const { return m_entries; }
+
+    //--
+
+    /// find file entry by depot path, O(1)
+    const Entry* findFile(StringView depotPath) const;
+
+    /// get the full depot path of the entry
+    StringView entryPath(const Entry& entry) const;
+
+    /// enumerate files directly in given depot directory (path must end with "/")
+    bool enumFiles(StringView depotDirectoryPath, const std::function<bool(StringView name)>& enumFunc) const;
+
+    /// enumerate directories directly in given depot directory (path must end with "/")
+    bool enumDirectories(StringView depotDirectoryPath, const std::function<bool(StringView name)>& enumFunc) const;
+
+    //--
+
+    /// load (and decompress) the content of the file
+    CAN_YIELD Buffer loadFile(const Entry& entry) const;
+
+    /// create an async reader for the file, uncompressed files are read directly from the archive, compressed ones are loaded into memory first
+    CAN_YIELD AsyncFileHandlePtr createAsyncReader(const Entry& entry) const;
+
+private:
+    StringBuf m_path;
+    AsyncFileHandlePtr m_file; // shared by all readers
+
+    Buffer m_toc;
+    const Header* m_header = nullptr;
+    const Entry* m_entries = nullptr;
+    const uint32_t* m_hashTable = nullptr;
+    const char* m_strings = nullptr;
+
+    uint32_t findFirstEntryWithPrefix(StringView prefix) const;
+};
+
+//--
+
+/// Builder for depot archives
+class CORE_RESOURCE_API DepotArchiveBuilder : public NoCopy
+{
+public:
+    DepotArchiveBuilder(CompressionType compression = CompressionType::LZ4);
+
+    /// add file to archive, the content is read when the archive is saved
+    void addFile(StringView depotPath, StringView absoluteSourcePath);
+
+    /// write the archive
+    bool save(StringView absolutePath) const;
+
+private:
+    struct SourceFile
+    {
+        StringBuf depotPath;
+        StringBuf absolutePath;
+    };
+
+    Array<SourceFile> m_files;
+    CompressionType m_compression;
+};
+
+//--
+
+END_BOOMER_NAMESPACE()
@@ -12,6 +12,16 @@ BEGIN_BOOMER_NAMESPACE()
 
 //--
 
+/// stats gathered while loading the object data
+struct FileLoadingStats
+{
+    uint32_t numBatches = 0; // number of reads done to load the object data
+    uint64_t numBytesRead = 0; // total size of the object data read
+    double readTime = 0.0; // total time the reads took (seconds)
+    double stallTime = 0.0; // time we waited for the reads, anything below readTime was hidden behind deserialization (seconds)
+    uint32_t numBatchesReadAhead = 0; // batches that were already read when we got to them, their reads fully overlapped with deserialization
+};
+
 /// read context for loading file deserialization
 struct CORE_RESOURCE_API FileLoadingContext
 {
@@ -32,11 +42,17 @@ struct CORE_RESOURCE_API FileLoadingContext
     // class override for root object - force changes the root object class but still tries to load properties
     ClassType mutatedRootClass;
 
+    // size of the buffers the object data is read into in batches, 0 uses the default (8MB), never smaller than the biggest object
+    uint64_t loadBufferSize = 0;
+
     //--
 
     // all loaded root objects (without parents)
     Array<ObjectPtr> loadedRoots;
 
+    // loading stats
+    FileLoadingStats stats;
+
     //--
 
     // get loaded root
@@ -77,4 +93,12 @@ CAN_YIELD extern CORE_RESOURCE_API ResourceMetadataPtr LoadFileMetadata(IAsyncFi
 
 //--
 
+// load objects from a file that is already fully in memory (usually memory mapped), object data is read in place without any copies
+extern CORE_RESOURCE_API bool LoadFile(const Buffer& fileData, FileLoadingContext& context);
+
+// validate file tables of a file that is already in memory, NOTE: tables data will share the whole file buffer
+extern CORE_RESOURCE_API bool LoadFileTables(const Buffer& fileData, Buffer& tablesData);
+
+//--
+
 END_BOOMER_NAMESPACE()
@@ -21,6 +21,10 @@ struct CORE_RESOURCE_API FileSavingContext
     // NOTE: final version of loading code does not support the protected stream
     bool protectedStream = true;
 
+    // save structures that contain only raw data as memory blocks (much faster to load)
+    // NOTE: disable to always save structures as tagged properties
+    bool bulkData = true;
+
     //--
 
     // root object to save
@@ -10,6 +10,7 @@
 
 #include "core/containers/include/array.h"
 #include "core/containers/include/queue.h"
+#include "core/containers/include/flatHashMap.h"
 #include "core/object/include/globalEventKey.h"
 #include "core/io/include/timestamp.h"
 
@@ -90,7 +91,7 @@ protected:
     typedef HashMap<ResourcePath, RefWeakPtr<LoadingJob>> TLoadingJobMap;
     TLoadingJobMap m_loadingJobs;       // map for active loading jobs
 
-    typedef HashMap<ResourcePath, RefPtr<LoadedResource>> TResourceMap;
+    typedef FlatHashMap<ResourcePath, RefPtr<LoadedResource>> TResourceMap;
     TResourceMap m_loadedResources;       // map for active loading jobs
 
     //--
@@ -17,6 +17,9 @@ typedef RefWeakPtr<ObjectIndirectTemplate> ObjectIndirectTemplateWeakPtr;
 
 class DepotService;
 
+class DepotArchive;
+typedef RefPtr<DepotArchive> DepotArchivePtr;
+
 DECLARE_GLOBAL_EVENT(EVENT_RESOURCE_LOADER_FILE_LOADING, ResourceKey)
 DECLARE_GLOBAL_EVENT(EVENT_RESOURCE_LOADER_FILE_LOADED, ResourcePtr)
 DECLARE_GLOBAL_EVENT(EVENT_RESOURCE_LOADER_FILE_UNLOADED, ResourceKey)
@@ -9,6 +9,7 @@
 #include "build.h"
 #include "depot.h"
 #include "core/io/include/fileHandle.h"
+#include "core/io/include/fileHandleMemory.h"
 #include "core/app/include/commandline.h"
 
 BEGIN_BOOMER_NAMESPACE()
@@ -23,6 +24,29 @@ RTTI_END_TYPE();
 DepotService::DepotService()
 {}
 
+const DepotArchive::Entry* DepotService::findArchiveFile(StringView depotPath, const DepotArchive** outArchive) const
+{
+    for (const auto& archive : m_archives)
+    {
+        if (const auto* entry = archive->findFile(depotPath))
+        {
+            if (outArchive)
+                *outArchive = archive.get();
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+uint64_t DepotService::queryFileKnownMainSize(StringView depotPath) const
+{
+    if (const auto* entry = findArchiveFile(depotPath))
+        return entry->mainFileSize;
+
+    return 0;
+}
+
 bool DepotService::queryFileAbsolutePath(StringView depotPath, StringBuf& outAbsolutePath) const
 {
     DEBUG_CHECK_RETURN_EX_V(ValidateDepotPath(depotPath, DepotPathClass::AnyAbsolutePath), "Invalid path", false);
@@ -61,6 +85,12 @@ bool DepotService::queryFileDepotPath(StringView absolutePath, StringBuf& outDep
 
 bool DepotService::queryFileTimestamp(StringView depotPath, TimeStamp& outTimestamp) const
 {
+    if (const auto* entry = findArchiveFile(depotPath))
+    {
+        outTimestamp = TimeStamp(entry->timestamp);
+        return true;
+    }
+
     StringBuf absolutePath;
     if (!queryFileAbsolutePath(depotPath, absolutePath))
         return false;
@@ -70,6 +100,14 @@ bool DepotService::queryFileTimestamp(StringView depotPath, TimeStamp& outTimest
 
 ReadFileHandlePtr DepotService::createFileReader(StringView depotPath) const
 {
+    const DepotArchive* archive = nullptr;
+    if (const auto* entry = findArchiveFile(depotPath, &archive))
+    {
+        if (auto data = archive->loadFile(*entry))
+            return RefNew<MemoryReaderFileHandle>(data);
+        return nullptr;
+    }
+
     StringBuf absolutePath;
     if (!queryFileAbsolutePath(depotPath, absolutePath))
         return nullptr;
@@ -88,6 +126,10 @@ WriteFileHandlePtr DepotService::createFileWriter(StringView depotPath) const
 
 AsyncFileHandlePtr DepotService::createFileAsyncReader(StringView depotPath) const
 {
+    const DepotArchive* archive = nullptr;
+    if (const auto* entry = findArchiveFile(depotPath, &archive))
+        return archive->createAsyncReader(*entry);
+
     StringBuf absolutePath;
     if (!queryFileAbsolutePath(depotPath, absolutePath))
         return nullptr;
@@ -95,13 +137,44 @@ AsyncFileHandlePtr DepotService::createFileAsyncReader(StringView depotPath) con
     return OpenForAsyncReading(absolutePath);
 }
 
+Buffer DepotService::createFileMappedView(StringView depotPath, FileMappingHint hint) const
+{
+    if (findArchiveFile(depotPath))
+        return nullptr;
+
+    StringBuf absolutePath;
+    if (!queryFileAbsolutePath(depotPath, absolutePath))
+        return nullptr;
+
+    return OpenMemoryMappedForReading(absolutePath, hint);
+}
+
 bool DepotService::enumDirectoriesAtPath(StringView rawDirectoryPath, const std::function<bool(const DirectoryInfo& info) >& enumFunc) const
 {
     DEBUG_CHECK_RETURN_EX_V(ValidateDepotPath(rawDirectoryPath, DepotPathClass::AbsoluteDirectoryPath), "Invalid directory path", false);
 
+    // directories from the archives are reported first, loose directories with the same names are skipped
+    InplaceArray<StringView, 64> archiveDirectories;
+    for (const auto& archive : m_archives)
+    {
+        if (archive->enumDirectories(rawDirectoryPath, [&archiveDirectories, &enumFunc](StringView name)
+            {
+                if (archiveDirectories.contains(name))
+                    return false;
+
+                archiveDirectories.pushBack(name);
+
+                DirectoryInfo info;
+                info.fileSystemRoot = true;
+                info.name = name;
+                return enumFunc(info);
+            }))
+            return true;
+    }
+
     if (rawDirectoryPath == "/")
     {
-        if (m_engineDepotPath)
+        if (m_engineDepotPath && !archiveDirectories.contains("engine"))
         {
             DirectoryInfo info;
             info.fileSystemRoot = true;
@@ -110,7 +183,7 @@ bool DepotService::enumDirectoriesAtPath(StringView rawDirectoryPath, const std:
                 return true;
         }
 
-        if (m_projectDepotPath)
+        if (m_projectDepotPath && !archiveDirectories.contains("project"))
         {
             DirectoryInfo info;
             info.fileSystemRoot = true;
@@ -124,8 +197,11 @@ bool DepotService::enumDirectoriesAtPath(StringView rawDirectoryPath, const std:
         StringBuf absolutePath;
         if (queryFileAbsolutePath(rawDirectoryPath, absolutePath))
         {
-            return FindSubDirs(absolutePath, [&enumFunc](StringView name)
+            return FindSubDirs(absolutePath, [&enumFunc, &archiveDirectories](StringView name)
                 {
+                    if (archiveDirectories.contains(name))
+                        return false;
+
                     DirectoryInfo info;
                     info.fileSystemRoot = true;
                     info.name = name;
@@ -143,11 +219,31 @@ bool DepotService::enumFilesAtPath(StringView rawDirectoryPath, const std::funct
 
     if (rawDirectoryPath != "/")
     {
+        // files from the archives are reported first, loose files with the same names are skipped
+        for (const auto& archive : m_archives)
+        {
+            if (archive->enumFiles(rawDirectoryPath, [this, &archive, &enumFunc, rawDirectoryPath](StringView name)
+                {
+                    // file may be also in an archive that was mounted earlier
+                    const DepotArchive* ownerArchive = nullptr;
+                    if (findArchiveFile(TempString("{}{}", rawDirectoryPath, name), &ownerArchive) && ownerArchive != archive.get())
+                        return false;
+
+                    FileInfo info;
+                    info.name = name;
+                    return enumFunc(info);
+                }))
+                return true;
+        }
+
         StringBuf absolutePath;
         if (queryFileAbsolutePath(rawDirectoryPath, absolutePath))
         {
-            return FindLocalFiles(absolutePath, "*.*", [&enumFunc](StringView name)
+            return FindLocalFiles(absolutePath, "*.*", [this, &enumFunc, rawDirectoryPath](StringView name)
                 {
+                    if (!m_archives.empty() && findArchiveFile(TempString("{}{}", rawDirectoryPath, name)))
+                        return false;
+
                     FileInfo info;
                     info.name = name;
                     return enumFunc(info);
@@ -296,14 +392,44 @@ app::ServiceInitializationResult DepotService::onInitializeService(const app::Co
         }
     }
 
+    // packed archives, explicitly specified ones are mounted first so they can override the default ones
+    for (const auto& path : cmdLine.allValues("depotArchive"))
+        mountArchive(path);
+
+    {
+        const auto engineArchivePath = StringBuf(TempString("{}data/depot.bpak", engineDir));
+        if (FileExists(engineArchivePath))
+            mountArchive(engineArchivePath);
+    }
+
+    if (!projectDir.empty())
+    {
+        const auto projectArchivePath = StringBuf(TempString("{}data/depot.bpak", projectDir));
+        if (FileExists(projectArchivePath))
+            mountArchive(projectArchivePath);
+    }
+
     m_engineObserver = CreateDirectoryWatcher(m_engineDepotPath);
     m_engineObserver->attachListener(this);
 
     return app::ServiceInitializationResult::Finished;
 }
 
+void DepotService::mountArchive(StringView absolutePath)
+{
+    for (const auto& archive : m_archives)
+        if (archive->path() == absolutePath)
+            return;
+
+    if (auto archive = DepotArchive::Open(absolutePath))
+        m_archives.pushBack(archive);
+    else
+        TRACE_ERROR("Failed to mount depot archive '{}'", absolutePath);
+}
+
 void DepotService::onShutdownService()
 {
+    m_archives.clear();
 
 }
 
@@ -355,11 +481,37 @@ void DepotService::handleEvent(const DirectoryWatcherEvent& evt)
 
 //--
 
+// files smaller than this are cheaper to just read than to map
+static const uint64_t MIN_MAPPED_FILE_SIZE = 64 * 1024;
+
 bool DepotService::loadFileToBuffer(StringView depotPath, Buffer& outContent, TimeStamp* timestamp) const
 {
+    const DepotArchive* archive = nullptr;
+    if (const auto* entry = findArchiveFile(depotPath, &archive))
+    {
+        if (auto data = archive->loadFile(*entry))
+        {
+            outContent = data;
+            return true;
+        }
+
+        return false;
+    }
+
     if (auto file = createFileReader(depotPath))
     {
         auto size = file->size();
+
+        // big files are mapped, the content is used directly from the page cache instead of being copied
+        if (size >= MIN_MAPPED_FILE_SIZE)
+        {
+            if (auto data = createFileMappedView(depotPath, FileMappingHint::Sequential))
+            {
+                outContent = data;
+                return true;
+            }
+        }
+
         if (auto data = Buffer::Create(POOL_TEMP, size, 16))
         {
             if (size == file->readSync(data.data(), size))
@@ -375,6 +527,18 @@ bool DepotService::loadFileToBuffer(StringView depotPath, Buffer& outContent, Ti
 
 bool DepotService::loadFileToString(StringView depotPath, StringBuf& outContent, TimeStamp* timestamp) const
 {
+    const DepotArchive* archive = nullptr;
+    if (const auto* entry = findArchiveFile(depotPath, &archive))
+    {
+        if (auto data = archive->loadFile(*entry))
+        {
+            outContent = StringBuf(data.data(), data.size());
+            return true;
+        }
+
+        return false;
+    }
+
     if (auto file = createFileReader(depotPath))
     {
         auto size = file->size();
@@ -0,0 +1,531 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: service #]
+***/
+
+#include "build.h"
+#include "depotArchive.h"
+#include "fileTables.h"
+
+#include "core/io/include/fileHandle.h"
+#include "core/io/include/fileHandleMemory.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+const uint32_t DepotArchive::FILE_MAGIC = 0x4B415042; // 'BPAK'
+const uint32_t DepotArchive::FILE_VERSION = 1;
+const uint32_t DepotArchive::DATA_ALIGNMENT = 4096;
+
+static uint64_t CalcPathHash(StringView path)
+{
+    return CRC64().append(path.data(), path.length()).crc();
+}
+
+static uint32_t CalcHeaderCRC(const DepotArchive::Header& header)
+{
+    return CRC32().append(&header, offsetof(DepotArchive::Header, headerCRC)).crc();
+}
+
+//--
+
+// view of a single uncompressed file in the archive, reads go directly to the shared archive handle
+class DepotArchiveEntryAsyncFileHandle : public IAsyncFileHandle
+{
+public:
+    DepotArchiveEntryAsyncFileHandle(AsyncFileHandlePtr archiveFile, uint64_t offset, uint64_t size)
+        : m_archiveFile(archiveFile)
+        , m_offset(offset)
+        , m_size(size)
+    {}
+
+    virtual uint64_t size() const override final
+    {
+        return m_size;
+    }
+
+    virtual CAN_YIELD uint64_t readAsync(uint64_t offset, uint64_t size, void* readBuffer) override final
+    {
+        if (offset >= m_size)
+            return 0;
+
+        const auto maxSize = std::min<uint64_t>(size, m_size - offset);
+        return m_archiveFile->readAsync(m_offset + offset, maxSize, readBuffer);
+    }
+
+private:
+    AsyncFileHandlePtr m_archiveFile;
+    uint64_t m_offset = 0;
+    uint64_t m_size = 0;
+};
+
+//--
+
+DepotArchive::DepotArchive(StringView path, AsyncFileHandlePtr file, Buffer toc)
+    : m_path(path)
+    , m_file(file)
+    , m_toc(toc)
+{
+    m_header = (const Header*)m_toc.data();
+    m_entries = (const Entry*)(m_toc.data() + m_header->entriesOffset);
+    m_hashTable = (const uint32_t*)(m_toc.data() + m_header->hashTableOffset);
+    m_strings = (const char*)(m_toc.data() + m_header->stringsOffset);
+}
+
+DepotArchive::~DepotArchive()
+{}
+
+DepotArchivePtr DepotArchive::Open(StringView absolutePath)
+{
+    // NOTE: the table of contents is read with a normal handle, we may be called outside of a fiber during service initialization
+    auto file = OpenForReading(absolutePath);
+    if (!file)
+    {
+        TRACE_WARNING("DepotArchive: Failed to open '{}'", absolutePath);
+        return nullptr;
+    }
+
+    Header header;
+    if (file->readSync(&header, sizeof(header)) != sizeof(header))
+    {
+        TRACE_WARNING("DepotArchive: Failed to read header of '{}'", absolutePath);
+        return nullptr;
+    }
+
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.headerCRC != CalcHeaderCRC(header))
+    {
+        TRACE_WARNING("DepotArchive: File '{}' is not a valid depot archive", absolutePath);
+        return nullptr;
+    }
+
+    // validate table layout
+    const auto entriesEnd = (uint64_t)header.entriesOffset + (uint64_t)header.numEntries * sizeof(Entry);
+    const auto hashTableEnd = (uint64_t)header.hashTableOffset + (uint64_t)header.hashTableSize * sizeof(uint32_t);
+    const auto stringsEnd = (uint64_t)header.stringsOffset + header.stringsSize;
+    if (header.tocSize < sizeof(Header) || header.tocSize > file->size() || entriesEnd > header.tocSize || hashTableEnd > header.tocSize || stringsEnd > header.tocSize)
+    {
+        TRACE_WARNING("DepotArchive: File '{}' has invalid table of contents", absolutePath);
+        return nullptr;
+    }
+
+    // lookups mask the hash with the table size and probe until they find an empty slot so there must always be one
+    if (header.hashTableSize == 0 || (header.hashTableSize & (header.hashTableSize - 1)) || header.hashTableSize <= header.numEntries)
+    {
+        TRACE_WARNING("DepotArchive: File '{}' has invalid hash table size {} for {} entries", absolutePath, header.hashTableSize, header.numEntries);
+        return nullptr;
+    }
+
+    // load the whole table of contents
+    auto toc = Buffer::Create(POOL_IO, header.tocSize, 16);
+    if (!toc)
+    {
+        TRACE_WARNING("DepotArchive: Unable to allocate {} for table of contents of '{}'", MemSize(header.tocSize), absolutePath);
+        return nullptr;
+    }
+
+    if (!file->pos(0) || file->readSync(toc.data(), header.tocSize) != header.tocSize)
+    {
+        TRACE_WARNING("DepotArchive: Failed to read table of contents of '{}'", absolutePath);
+        return nullptr;
+    }
+
+    const auto tocCRC = CRC32().append(toc.data() + sizeof(Header), header.tocSize - sizeof(Header)).crc();
+    if (tocCRC != header.tocCRC)
+    {
+        TRACE_WARNING("DepotArchive: Table of contents of '{}' is corrupted", absolutePath);
+        return nullptr;
+    }
+
+    // validate the hash table, slots store entry index + 1, 0 is an empty slot
+    const auto* hashTable = (const uint32_t*)(toc.data() + header.hashTableOffset);
+    uint32_t numUsedSlots = 0;
+    for (uint32_t i = 0; i < header.hashTableSize; ++i)
+    {
+        if (hashTable[i] > header.numEntries)
+        {
+            TRACE_WARNING("DepotArchive: Hash table slot {} in '{}' is corrupted", i, absolutePath);
+            return nullptr;
+        }
+
+        numUsedSlots += (hashTable[i] != 0);
+    }
+
+    if (numUsedSlots > header.numEntries)
+    {
+        TRACE_WARNING("DepotArchive: Hash table in '{}' has more slots used than there are entries", absolutePath);
+        return nullptr;
+    }
+
+    // validate the entries so we never have to do it later
+    const auto* entries = (const Entry*)(toc.data() + header.entriesOffset);
+    for (uint32_t i = 0; i < header.numEntries; ++i)
+    {
+        const auto& entry = entries[i];
+        if ((uint64_t)entry.pathOffset + entry.pathLength > header.stringsSize || entry.dataOffset + entry.dataSize > file->size() || entry.compression >= CompressionType::MAX)
+        {
+            TRACE_WARNING("DepotArchive: Entry {} in '{}' is corrupted", i, absolutePath);
+            return nullptr;
+        }
+    }
+
+    // all reads from now on go through the shared async handle
+    auto asyncFile = OpenForAsyncReading(absolutePath);
+    if (!asyncFile)
+    {
+        TRACE_WARNING("DepotArchive: Failed to open '{}' for async reading", absolutePath);
+        return nullptr;
+    }
+
+    TRACE_INFO("DepotArchive: Mounted '{}' with {} files", absolutePath, header.numEntries);
+    return RefNew<DepotArchive>(absolutePath, asyncFile, toc);
+}
+
+//--
+
+StringView DepotArchive::entryPath(const Entry& entry) const
+{
+    return StringView(m_strings + entry.pathOffset, entry.pathLength);
+}
+
+const DepotArchive::Entry* DepotArchive::findFile(StringView depotPath) const
+{
+    const auto hash = CalcPathHash(depotPath);
+    const auto mask = m_header->hashTableSize - 1;
+
+    auto slot = (uint32_t)hash & mask;
+    while (const auto index = m_hashTable[slot])
+    {
+        const auto& entry = m_entries[index - 1];
+        if (entry.pathHash == hash && entryPath(entry) == depotPath)
+            return &entry;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return nullptr;
+}
+
+uint32_t DepotArchive::findFirstEntryWithPrefix(StringView prefix) const
+{
+    // entries are sorted by path so all files in a directory (and it's sub directories) are next to each other
+    uint32_t first = 0;
+    uint32_t count = m_header->numEntries;
+    while (count > 0)
+    {
+        const auto step = count / 2;
+        const auto mid = first + step;
+        if (entryPath(m_entries[mid]) < prefix)
+        {
+            first = mid + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+bool DepotArchive::enumFiles(StringView depotDirectoryPath, const std::function<bool(StringView name)>& enumFunc) const
+{
+    for (auto i = findFirstEntryWithPrefix(depotDirectoryPath); i < m_header->numEntries; ++i)
+    {
+        const auto path = entryPath(m_entries[i]);
+        if (!path.beginsWith(depotDirectoryPath))
+            break;
+
+        const auto name = path.subString(depotDirectoryPath.length());
+        if (name.findFirstChar('/') == -1)
+            if (enumFunc(name))
+                return true;
+    }
+
+    return false;
+}
+
+bool DepotArchive::enumDirectories(StringView depotDirectoryPath, const std::function<bool(StringView name)>& enumFunc) const
+{
+    StringView lastName;
+    for (auto i = findFirstEntryWithPrefix(depotDirectoryPath); i < m_header->numEntries; ++i)
+    {
+        const auto path = entryPath(m_entries[i]);
+        if (!path.beginsWith(depotDirectoryPath))
+            break;
+
+        const auto rest = path.subString(depotDirectoryPath.length());
+        const auto separator = rest.findFirstChar('/');
+        if (separator == -1)
+            continue;
+
+        // files in the same sub directory are next to each other
+        const auto name = rest.leftPart(separator);
+        if (name != lastName)
+        {
+            lastName = name;
+            if (enumFunc(name))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+//--
+
+Buffer DepotArchive::loadFile(const Entry& entry) const
+{
+    // empty files are valid, they still need a non-null buffer so the caller does not treat them as missing
+    if (entry.size == 0)
+    {
+        auto data = Buffer::Create(POOL_IO, 1, 16);
+        if (data)
+            data.adjustSize(0);
+        return data;
+    }
+
+    auto data = Buffer::Create(POOL_IO, entry.dataSize, 16);
+    if (!data)
+    {
+        TRACE_WARNING("DepotArchive: Unable to allocate {} to load '{}'", MemSize(entry.dataSize), entryPath(entry));
+        return nullptr;
+    }
+
+    if (m_file->readAsync(entry.dataOffset, entry.dataSize, data.data()) != entry.dataSize)
+    {
+        TRACE_WARNING("DepotArchive: Failed to read '{}' from '{}'", entryPath(entry), m_path);
+        return nullptr;
+    }
+
+    if (entry.compression != CompressionType::Uncompressed)
+    {
+        data = Decompress(entry.compression, data.data(), data.size(), entry.size, POOL_IO);
+        if (!data)
+        {
+            TRACE_WARNING("DepotArchive: Failed to decompress '{}' from '{}'", entryPath(entry), m_path);
+            return nullptr;
+        }
+    }
+
+    return data;
+}
+
+AsyncFileHandlePtr DepotArchive::createAsyncReader(const Entry& entry) const
+{
+    if (entry.compression == CompressionType::Uncompressed)
+        return RefNew<DepotArchiveEntryAsyncFileHandle>(m_file, entry.dataOffset, entry.size);
+
+    if (auto data = loadFile(entry))
+        return RefNew<MemoryAsyncReaderFileHandle>(data);
+
+    return nullptr;
+}
+
+//--
+
+DepotArchiveBuilder::DepotArchiveBuilder(CompressionType compression)
+    : m_compression(compression)
+{}
+
+void DepotArchiveBuilder::addFile(StringView depotPath, StringView absoluteSourcePath)
+{
+    auto& entry = m_files.emplaceBack();
+    entry.depotPath = StringBuf(depotPath);
+    entry.absolutePath = StringBuf(absoluteSourcePath);
+}
+
+static bool WriteZeros(IWriteFileHandle* file, uint64_t size)
+{
+    static const uint8_t zeros[4096] = { 0 };
+
+    while (size > 0)
+    {
+        const auto blockSize = std::min<uint64_t>(size, sizeof(zeros));
+        if (file->writeSync(zeros, blockSize) != blockSize)
+            return false;
+        size -= blockSize;
+    }
+
+    return true;
+}
+
+static bool WritePadding(IWriteFileHandle* file, uint64_t alignment)
+{
+    return WriteZeros(file, Align<uint64_t>(file->pos(), alignment) - file->pos());
+}
+
+bool DepotArchiveBuilder::save(StringView absolutePath) const
+{
+    ScopeTimer timer;
+
+    // sort files by path, this groups directories together and gives the final order of the data
+    Array<const SourceFile*> files;
+    files.reserve(m_files.size());
+    for (const auto& file : m_files)
+        files.pushBack(&file);
+    std::sort(files.begin(), files.end(), [](const SourceFile* a, const SourceFile* b) { return a->depotPath.view() < b->depotPath.view(); });
+
+    for (uint32_t i = 1; i < files.size(); ++i)
+    {
+        if (files[i - 1]->depotPath == files[i]->depotPath)
+        {
+            TRACE_ERROR("DepotArchive: File '{}' was added more than once", files[i]->depotPath);
+            return false;
+        }
+    }
+
+    // prepare the table of contents, everything except the data placement is known up front
+    DepotArchive::Header header;
+    header.magic = DepotArchive::FILE_MAGIC;
+    header.version = DepotArchive::FILE_VERSION;
+    header.numEntries = files.size();
+    header.hashTableSize = 16;
+    while (header.hashTableSize < files.size() * 2)
+        header.hashTableSize *= 2;
+
+    Array<DepotArchive::Entry> entries;
+    entries.resize(files.size());
+
+    Array<char> strings;
+    for (uint32_t i = 0; i < files.size(); ++i)
+    {
+        const auto path = files[i]->depotPath.view();
+        auto& entry = entries[i];
+        entry.pathHash = CalcPathHash(path);
+        entry.pathOffset = strings.size();
+        entry.pathLength = path.length();
+
+        auto* ptr = strings.allocateUninitialized(path.length());
+        memcpy(ptr, path.data(), path.length());
+    }
+
+    Array<uint32_t> hashTable;
+    hashTable.resizeWith(header.hashTableSize, 0);
+    for (uint32_t i = 0; i < entries.size(); ++i)
+    {
+        auto slot = (uint32_t)entries[i].pathHash & (header.hashTableSize - 1);
+        while (hashTable[slot])
+            slot = (slot + 1) & (header.hashTableSize - 1);
+        hashTable[slot] = i + 1;
+    }
+
+    header.entriesOffset = sizeof(DepotArchive::Header);
+    header.hashTableOffset = header.entriesOffset + entries.dataSize();
+    header.stringsOffset = header.hashTableOffset + hashTable.dataSize();
+    header.stringsSize = strings.dataSize();
+    header.tocSize = header.stringsOffset + header.stringsSize;
+
+    // write the data first, the table of contents is written at the end when all the offsets are known
+    auto file = OpenForWriting(absolutePath, FileWriteMode::StagedWrite);
+    if (!file)
+    {
+        TRACE_ERROR("DepotArchive: Failed to open '{}' for writing", absolutePath);
+        return false;
+    }
+
+    if (!WriteZeros(file.get(), header.tocSize))
+    {
+        TRACE_ERROR("DepotArchive: Failed to write '{}'", absolutePath);
+        file->discardContent();
+        return false;
+    }
+
+    uint64_t totalSize = 0;
+    uint64_t totalStoredSize = 0;
+    for (uint32_t i = 0; i < files.size(); ++i)
+    {
+        const auto& source = *files[i];
+        auto& entry = entries[i];
+
+        // NOTE: empty files load as null buffer
+        TimeStamp timestamp;
+        uint64_t fileSize = 0;
+        auto content = LoadFileToBuffer(source.absolutePath);
+        if (!FileTimeStamp(source.absolutePath, timestamp, &fileSize) || (!content && fileSize != 0))
+        {
+            TRACE_ERROR("DepotArchive: Failed to load '{}'", source.absolutePath);
+            file->discardContent();
+            return false;
+        }
+
+        entry.size = content.size();
+        entry.timestamp = timestamp.value();
+        entry.crc = CRC32().append(content.data(), content.size()).crc();
+
+        // serialized resources can be loaded without reading the header first
+        if (content.size() >= sizeof(FileTables::Header))
+        {
+            const auto& fileHeader = *(const FileTables::Header*)content.data();
+            if (FileTables::ValidateHeader(fileHeader) && fileHeader.objectsEnd <= content.size())
+                entry.mainFileSize = fileHeader.objectsEnd;
+        }
+
+        // compress only if it's worth it, uncompressed entries can be read directly from the archive
+        auto stored = content;
+        entry.compression = CompressionType::Uncompressed;
+        if (m_compression != CompressionType::Uncompressed && content)
+        {
+            if (auto compressed = Compress(m_compression, content, POOL_IO))
+            {
+                if (compressed.size() < (content.size() * 9) / 10)
+                {
+                    stored = compressed;
+                    entry.compression = m_compression;
+                }
+            }
+        }
+
+        if (!WritePadding(file.get(), DepotArchive::DATA_ALIGNMENT))
+        {
+            TRACE_ERROR("DepotArchive: Failed to write '{}'", absolutePath);
+            file->discardContent();
+            return false;
+        }
+
+        entry.dataOffset = file->pos();
+        entry.dataSize = stored.size();
+        if (stored && file->writeSync(stored.data(), stored.size()) != stored.size())
+        {
+            TRACE_ERROR("DepotArchive: Failed to write '{}'", absolutePath);
+            file->discardContent();
+            return false;
+        }
+
+        totalSize += entry.size;
+        totalStoredSize += entry.dataSize;
+    }
+
+    // write the table of contents
+    {
+        CRC32 crc;
+        crc.append(entries.data(), entries.dataSize());
+        crc.append(hashTable.data(), hashTable.dataSize());
+        crc.append(strings.data(), strings.dataSize());
+        header.tocCRC = crc.crc();
+        header.headerCRC = CalcHeaderCRC(header);
+
+        bool valid = file->pos(0);
+        valid &= file->writeSync(&header, sizeof(header)) == sizeof(header);
+        valid &= file->writeSync(entries.data(), entries.dataSize()) == entries.dataSize();
+        valid &= file->writeSync(hashTable.data(), hashTable.dataSize()) == hashTable.dataSize();
+        valid &= file->writeSync(strings.data(), strings.dataSize()) == strings.dataSize();
+        if (!valid)
+        {
+            TRACE_ERROR("DepotArchive: Failed to write table of contents to '{}'", absolutePath);
+            file->discardContent();
+            return false;
+        }
+    }
+
+    TRACE_INFO("DepotArchive: Saved '{}' with {} files, {} -> {} in {}", absolutePath, files.size(), MemSize(totalSize), MemSize(totalStoredSize), timer);
+    return true;
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
@@ -0,0 +1,324 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+
+#include "depotArchive.h"
+#include "core/containers/include/crc.h"
+
+DECLARE_TEST_FILE(DepotArchive);
+
+BEGIN_BOOMER_NAMESPACE_EX(test)
+
+namespace helper
+{
+    static StringBuf MakeTempFile(StringView name, StringView content)
+    {
+        const StringBuf path = TempString("{}depotArchiveTest_{}", SystemPath(PathCategory::LocalTempDir), name);
+        SaveFileFromString(path, content);
+        return path;
+    }
+
+    static StringBuf MakeTestArchive(CompressionType compression)
+    {
+        StringBuilder bigText;
+        for (uint32_t i = 0; i < 1000; ++i)
+            bigText.appendf("Line {} of the compressible file\n", i);
+
+        DepotArchiveBuilder builder(compression);
+        builder.addFile("/engine/textures/b.txt", MakeTempFile("b.txt", "Content of B"));
+        builder.addFile("/engine/textures/a.txt", MakeTempFile("a.txt", "Content of A"));
+        builder.addFile("/engine/meshes/box.txt", MakeTempFile("box.txt", bigText.view()));
+        builder.addFile("/engine/readme.txt", MakeTempFile("readme.txt", "Readme"));
+        builder.addFile("/engine/empty.txt", MakeTempFile("empty.txt", ""));
+
+        const StringBuf path = TempString("{}depotArchiveTest.bpak", SystemPath(PathCategory::LocalTempDir));
+        if (!builder.save(path))
+            return StringBuf();
+
+        return path;
+    }
+
+    // modify the archive and fix up the CRCs so the damage is not caught by them
+    static StringBuf MakeModifiedArchive(StringView name, const std::function<void(DepotArchive::Header& header, uint8_t* data)>& func)
+    {
+        const auto path = MakeTestArchive(CompressionType::Uncompressed);
+        if (path.empty())
+            return StringBuf();
+
+        auto data = LoadFileToBuffer(path);
+        if (!data)
+            return StringBuf();
+
+        auto& header = *(DepotArchive::Header*)data.data();
+        func(header, data.data());
+
+        if (header.tocSize >= sizeof(DepotArchive::Header) && header.tocSize <= data.size())
+            header.tocCRC = CRC32().append(data.data() + sizeof(DepotArchive::Header), header.tocSize - sizeof(DepotArchive::Header)).crc();
+        header.headerCRC = CRC32().append(&header, offsetof(DepotArchive::Header, headerCRC)).crc();
+
+        const StringBuf modifiedPath = TempString("{}depotArchiveTest_{}.bpak", SystemPath(PathCategory::LocalTempDir), name);
+        if (!SaveFileFromBuffer(modifiedPath, data))
+            return StringBuf();
+
+        return modifiedPath;
+    }
+
+    static uint32_t* HashTable(const DepotArchive::Header& header, uint8_t* data)
+    {
+        return (uint32_t*)(data + header.hashTableOffset);
+    }
+
+    static StringBuf LoadText(const DepotArchive& archive, StringView path)
+    {
+        if (const auto* entry = archive.findFile(path))
+            if (auto data = archive.loadFile(*entry))
+                return StringBuf(data.data(), data.size());
+
+        return StringBuf();
+    }
+
+} // helper
+
+TEST(DepotArchive, SaveAndOpen)
+{
+    const auto path = helper::MakeTestArchive(CompressionType::Uncompressed);
+    ASSERT_FALSE(path.empty());
+
+    auto archive = DepotArchive::Open(path);
+    ASSERT_TRUE(archive);
+    EXPECT_EQ(5, archive->numFiles());
+}
+
+TEST(DepotArchive, EntriesAreSortedAndAligned)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::Uncompressed));
+    ASSERT_TRUE(archive);
+
+    for (uint32_t i = 0; i < archive->numFiles(); ++i)
+    {
+        EXPECT_EQ(0, archive->entries()[i].dataOffset % DepotArchive::DATA_ALIGNMENT);
+        if (i > 0)
+            EXPECT_TRUE(archive->entryPath(archive->entries()[i - 1]) < archive->entryPath(archive->entries()[i]));
+    }
+}
+
+TEST(DepotArchive, FindFile)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::Uncompressed));
+    ASSERT_TRUE(archive);
+
+    EXPECT_TRUE(archive->findFile("/engine/textures/a.txt") != nullptr);
+    EXPECT_TRUE(archive->findFile("/engine/textures/b.txt") != nullptr);
+    EXPECT_TRUE(archive->findFile("/engine/readme.txt") != nullptr);
+    EXPECT_TRUE(archive->findFile("/engine/textures/c.txt") == nullptr);
+    EXPECT_TRUE(archive->findFile("/engine/textures/") == nullptr);
+    EXPECT_TRUE(archive->findFile("") == nullptr);
+}
+
+TEST(DepotArchive, LoadUncompressed)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::Uncompressed));
+    ASSERT_TRUE(archive);
+
+    EXPECT_STREQ("Content of A", helper::LoadText(*archive, "/engine/textures/a.txt").c_str());
+    EXPECT_STREQ("Content of B", helper::LoadText(*archive, "/engine/textures/b.txt").c_str());
+    EXPECT_STREQ("Readme", helper::LoadText(*archive, "/engine/readme.txt").c_str());
+}
+
+TEST(DepotArchive, LoadCompressed)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::LZ4));
+    ASSERT_TRUE(archive);
+
+    const auto* entry = archive->findFile("/engine/meshes/box.txt");
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(CompressionType::LZ4, entry->compression);
+    EXPECT_LT(entry->dataSize, entry->size);
+
+    const auto text = helper::LoadText(*archive, "/engine/meshes/box.txt");
+    EXPECT_EQ(entry->size, text.length());
+    EXPECT_TRUE(text.view().beginsWith("Line 0 of the compressible file"));
+
+    // small files are not worth compressing
+    EXPECT_EQ(CompressionType::Uncompressed, archive->findFile("/engine/readme.txt")->compression);
+}
+
+TEST(DepotArchive, LoadEmptyFile)
+{
+    for (auto compression : { CompressionType::Uncompressed, CompressionType::LZ4 })
+    {
+        auto archive = DepotArchive::Open(helper::MakeTestArchive(compression));
+        ASSERT_TRUE(archive);
+
+        const auto* entry = archive->findFile("/engine/empty.txt");
+        ASSERT_TRUE(entry != nullptr);
+        EXPECT_EQ(0, entry->size);
+        EXPECT_EQ(CompressionType::Uncompressed, entry->compression);
+
+        // empty but not missing
+        auto data = archive->loadFile(*entry);
+        ASSERT_TRUE(data);
+        EXPECT_EQ(0, data.size());
+
+        auto reader = archive->createAsyncReader(*entry);
+        ASSERT_TRUE(reader);
+        EXPECT_EQ(0, reader->size());
+    }
+}
+
+TEST(DepotArchive, AsyncReaderIsClampedToFile)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::Uncompressed));
+    ASSERT_TRUE(archive);
+
+    const auto* entry = archive->findFile("/engine/textures/b.txt");
+    ASSERT_TRUE(entry != nullptr);
+
+    auto reader = archive->createAsyncReader(*entry);
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(12, reader->size());
+
+    char buffer[64];
+    memset(buffer, 0, sizeof(buffer));
+    EXPECT_EQ(4, reader->readAsync(8, sizeof(buffer), buffer));
+    EXPECT_STREQ("of B", buffer);
+    EXPECT_EQ(0, reader->readAsync(12, sizeof(buffer), buffer));
+}
+
+TEST(DepotArchive, EnumFilesAndDirectories)
+{
+    auto archive = DepotArchive::Open(helper::MakeTestArchive(CompressionType::Uncompressed));
+    ASSERT_TRUE(archive);
+
+    Array<StringBuf> files;
+    archive->enumFiles("/engine/textures/", [&files](StringView name) { files.emplaceBack(name); return false; });
+    ASSERT_EQ(2, files.size());
+    EXPECT_STREQ("a.txt", files[0].c_str());
+    EXPECT_STREQ("b.txt", files[1].c_str());
+
+    Array<StringBuf> rootFiles;
+    archive->enumFiles("/engine/", [&rootFiles](StringView name) { rootFiles.emplaceBack(name); return false; });
+    ASSERT_EQ(2, rootFiles.size());
+    EXPECT_STREQ("empty.txt", rootFiles[0].c_str());
+    EXPECT_STREQ("readme.txt", rootFiles[1].c_str());
+
+    Array<StringBuf> dirs;
+    archive->enumDirectories("/engine/", [&dirs](StringView name) { dirs.emplaceBack(name); return false; });
+    ASSERT_EQ(2, dirs.size());
+    EXPECT_STREQ("meshes", dirs[0].c_str());
+    EXPECT_STREQ("textures", dirs[1].c_str());
+
+    Array<StringBuf> topDirs;
+    archive->enumDirectories("/", [&topDirs](StringView name) { topDirs.emplaceBack(name); return false; });
+    ASSERT_EQ(1, topDirs.size());
+    EXPECT_STREQ("engine", topDirs[0].c_str());
+}
+
+TEST(DepotArchive, CorruptedArchiveIsRejected)
+{
+    const auto path = helper::MakeTestArchive(CompressionType::Uncompressed);
+    ASSERT_FALSE(path.empty());
+
+    auto data = LoadFileToBuffer(path);
+    ASSERT_TRUE(data);
+    data.data()[sizeof(DepotArchive::Header) + 4] ^= 0xFF; // inside the entry table
+
+    const StringBuf corruptedPath = TempString("{}depotArchiveTestCorrupted.bpak", SystemPath(PathCategory::LocalTempDir));
+    ASSERT_TRUE(SaveFileFromBuffer(corruptedPath, data));
+    EXPECT_FALSE(DepotArchive::Open(corruptedPath));
+}
+
+TEST(DepotArchive, ModifiedArchiveWithValidCRCOpens)
+{
+    // make sure the corruption tests below fail because of what they break and not because of the CRCs
+    const auto path = helper::MakeModifiedArchive("unmodified", [](DepotArchive::Header& header, uint8_t* data) {});
+    ASSERT_FALSE(path.empty());
+    EXPECT_TRUE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, ZeroHashTableSizeIsRejected)
+{
+    const auto path = helper::MakeModifiedArchive("zeroHashTable", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            header.hashTableSize = 0;
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, NonPowerOfTwoHashTableSizeIsRejected)
+{
+    const auto path = helper::MakeModifiedArchive("nonPow2HashTable", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            header.hashTableSize -= 1;
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, FullHashTableIsRejected)
+{
+    // without a free slot the lookup of a missing file would never end
+    const auto path = helper::MakeModifiedArchive("fullHashTable", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            header.hashTableSize = 4;
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, OutOfRangeHashSlotIsRejected)
+{
+    const auto path = helper::MakeModifiedArchive("badHashSlot", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            auto* slots = helper::HashTable(header, data);
+            for (uint32_t i = 0; i < header.hashTableSize; ++i)
+            {
+                if (slots[i] == 0)
+                {
+                    slots[i] = header.numEntries + 1;
+                    break;
+                }
+            }
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, DuplicatedHashSlotsAreRejected)
+{
+    const auto path = helper::MakeModifiedArchive("duplicatedHashSlots", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            auto* slots = helper::HashTable(header, data);
+            for (uint32_t i = 0; i < header.hashTableSize; ++i)
+                slots[i] = 1;
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+TEST(DepotArchive, TruncatedTableOfContentsIsRejected)
+{
+    const auto path = helper::MakeModifiedArchive("truncatedToc", [](DepotArchive::Header& header, uint8_t* data)
+        {
+            header.tocSize = sizeof(DepotArchive::Header) - 1;
+        });
+
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(DepotArchive::Open(path));
+}
+
+END_BOOMER_NAMESPACE_EX(test)
@@ -15,6 +15,7 @@
 
 #include "core/io/include/asyncFileHandle.h"
 #include "core/object/include/streamOpcodeReader.h"
+#include "core/object/include/rttiClassType.h"
 #include "core/object/include/object.h"
 
 BEGIN_BOOMER_NAMESPACE()
@@ -223,10 +224,12 @@ static const uint64_t BlockSize = 4096;
 
 uint64_t DetermineLoadBufferSize(IAsyncFileHandle* file, const FileTables& tables, FileLoadingContext& context, const stream::OpcodeResolvedReferences& resolvedReferences)
 {
+    const auto loadBufferSize = context.loadBufferSize ? context.loadBufferSize : DefaultLoadBufferSize;
+
     // whole file is smaller than the load buffer
     // NOTE: use this ONLY if we indeed want to load the whole file
     if (!context.loadSpecificClass)
-        if (tables.header()->objectsEnd <= DefaultLoadBufferSize)
+        if (tables.header()->objectsEnd <= loadBufferSize)
             return tables.header()->objectsEnd;
 
     // file is bigger than the load buffer - we can't load it all at once
@@ -248,32 +251,102 @@ uint64_t DetermineLoadBufferSize(IAsyncFileHandle* file, const FileTables& table
 
     // account for misalignment
     maxObjectSize += BlockSize;
-    return std::max<uint32_t>(maxObjectSize, DefaultLoadBufferSize);
+    return std::max<uint64_t>(maxObjectSize, loadBufferSize);
 }
 
-bool LoadFileObjects(IAsyncFileHandle* file, const FileTables& tables, FileLoadingContext& context)
+bool ValidateObjects(const FileTables& tables, const stream::OpcodeResolvedReferences& resolvedReferences, uint32_t firstObject, uint32_t lastObject, const uint8_t* data, uint64_t dataFileOffset)
+{
+    const auto* objectTable = tables.exportTable();
+    for (uint32_t i = firstObject; i < lastObject; ++i)
+    {
+        if (resolvedReferences.objects[i])
+        {
+            const auto& objectEntry = objectTable[i];
+            const auto* objectData = data + (objectEntry.dataOffset - dataFileOffset);
+
+            const auto crc = CRC32().append(objectData, objectEntry.dataSize).crc();
+            if (crc != objectEntry.crc)
+            {
+                TRACE_WARNING("LoadFile: Invalid CRC for object {} ({} != {})", i, crc, objectEntry.crc);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ReadObjects(const FileTables& tables, const stream::OpcodeResolvedReferences& resolvedReferences, uint32_t firstObject, uint32_t lastObject, const uint8_t* data, uint64_t dataFileOffset)
 {
     // do we have "safe layout" in the file ?
     const bool protectedFileLayout = 0 != (tables.header()->flags & FileTables::FileFlag_ProtectedLayout);
 
-    // resolve all references
-    // NOTE: this will also create all objects that we want to load
-    stream::OpcodeResolvedReferences resolvedReferences;
-    ResolveReferences(tables, context, resolvedReferences);
+    const auto* objectTable = tables.exportTable();
+    for (uint32_t i = firstObject; i < lastObject; ++i)
+    {
+        if (auto object = resolvedReferences.objects[i])
+        {
+            // get the memory range in the loaded data where the object content is
+            const auto& objectEntry = objectTable[i];
+            const auto objectOffsetInBuffer = (objectEntry.dataOffset - dataFileOffset);
+            const auto objectDataSize = objectEntry.dataSize;
 
-    // get the size of the load buffer and allocate it
-    const auto loadBufferSize = DetermineLoadBufferSize(file, tables, context, resolvedReferences);
-    const auto loadBuffer = Buffer::Create(POOL_SERIALIZATION, loadBufferSize, 16);
-    if (!loadBuffer)
+            // get object data in the buffer
+            const auto* objectData = data + objectOffsetInBuffer;
+
+            // read the crap
+            stream::OpcodeReader reader(resolvedReferences, objectData, objectDataSize, protectedFileLayout, tables.header()->version);
+            if (reader.version() >= VER_BULK_LAYOUT_TABLE)
+                IClassType::ReadBinaryLayoutTable(reader);
+
+            object->onReadBinary(reader);
+
+            if (reader.corrupted())
+            {
+                TRACE_WARNING("LoadFile: Corrupted data in object {} ('{}')", i, object->cls()->name());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void PostLoadObjects(const FileTables& tables, const stream::OpcodeResolvedReferences& resolvedReferences)
+{
+    const auto numObjects = tables.chunkCount(FileTables::ChunkType::Exports);
+    for (uint32_t i=0; i<numObjects; ++i)
     {
-        TRACE_WARNING("LoadFile: Unable to allocate loading buffer of size {}", MemSize(loadBufferSize));
-        return false;
+        if (auto obj = resolvedReferences.objects[i])
+            obj->onPostLoad();
     }
+}
+
+//--
+
+// number of load buffers we rotate, while one is being deserialized the next one is being loaded
+static const uint32_t NumLoadBuffers = 2;
+
+struct LoadBatch
+{
+    uint32_t firstObject = 0;
+    uint32_t lastObject = 0; // exclusive
+    uint64_t startOffset = 0;
+    uint64_t endOffset = 0;
+
+    FiberSemaphore loaded;
+    uint64_t loadedSize = 0;
+    double loadTime = 0.0;
+    bool valid = true;
 
-    // load data and process it
+    INLINE uint64_t size() const { return endOffset - startOffset; }
+};
+
+void PrepareLoadBatches(const FileTables& tables, const stream::OpcodeResolvedReferences& resolvedReferences, uint64_t loadBufferSize, Array<LoadBatch>& outBatches)
+{
     const auto* objectTable = tables.exportTable();
     const auto numObjects = tables.chunkCount(FileTables::ChunkType::Exports);
-    auto objectIndex = 0;
+    uint32_t objectIndex = 0;
     while (objectIndex < numObjects)
     {
         // do not consider objects that were disabled from loading
@@ -284,9 +357,10 @@ bool LoadFileObjects(IAsyncFileHandle* file, const FileTables& tables, FileLoadi
         }
 
         // find the load batch size
-        uint32_t firstLoadObject = objectIndex;
-        uint64_t batchStartOffset = (objectTable[objectIndex].dataOffset / BlockSize) * BlockSize; // NOTE: aligned to block size (4K)
-        uint64_t batchEndOffset = objectTable[objectIndex].dataOffset + objectTable[objectIndex].dataSize;
+        auto& batch = outBatches.emplaceBack();
+        batch.firstObject = objectIndex;
+        batch.startOffset = (objectTable[objectIndex].dataOffset / BlockSize) * BlockSize; // NOTE: aligned to block size (4K)
+        batch.endOffset = objectTable[objectIndex].dataOffset + objectTable[objectIndex].dataSize;
         objectIndex += 1; // we load at least one
 
         // but do we fit more ?
@@ -296,64 +370,113 @@ bool LoadFileObjects(IAsyncFileHandle* file, const FileTables& tables, FileLoadi
             if (resolvedReferences.objects[objectIndex])
             {
                 const auto currentLoadEnd = objectTable[objectIndex].dataOffset + objectTable[objectIndex].dataSize;
-                if (currentLoadEnd > batchStartOffset + loadBufferSize)
+                if (currentLoadEnd > batch.startOffset + loadBufferSize)
                     break; // it won't fit
-                batchEndOffset = currentLoadEnd;
+                batch.endOffset = currentLoadEnd;
             }
 
             objectIndex += 1;
         }
 
-        // load the data
-        const auto loadSize = batchEndOffset - batchStartOffset;
-        ASSERT_EX(loadSize <= loadBufferSize, "Load size greated than load buffer");
-        const auto loadSizeActual = file->readAsync(batchStartOffset, loadSize, loadBuffer.data());
-        if (loadSizeActual != loadSize)
+        batch.lastObject = objectIndex;
+        ASSERT_EX(batch.size() <= loadBufferSize, "Load size greated than load buffer");
+    }
+}
+
+void StartBatchLoad(IAsyncFileHandle* file, const FileTables& tables, const stream::OpcodeResolvedReferences& resolvedReferences, LoadBatch& batch, uint8_t* loadMemory)
+{
+    batch.loaded = CreateFence("LoadFileBatch");
+
+    RunChildFiber("LoadFileBatch") << [file, &tables, &resolvedReferences, &batch, loadMemory](FIBER_FUNC)
+    {
+        ScopeTimer timer;
+        batch.loadedSize = file->readAsync(batch.startOffset, batch.size(), loadMemory);
+        batch.loadTime = timer.timeElapsed();
+
+        if (batch.loadedSize != batch.size())
         {
-            TRACE_WARNING("LoadFile: AsyncIO failure, loaded {}, expected {} at offset {}", loadSizeActual, loadSize, batchStartOffset);
-            return false; // cancels everything
+            TRACE_WARNING("LoadFile: AsyncIO failure, loaded {}, expected {} at offset {}", batch.loadedSize, batch.size(), batch.startOffset);
+            batch.valid = false;
         }
 
-        // deserialize objects that were loaded in that batch
-        // TODO: technically this can overlap waiting for the next batch
+        // validate the data here, this runs while the previous batch is being deserialized
+        else if (tables.header()->flags & FileTables::FileFlag_ProtectedLayout)
+        {
+            batch.valid = ValidateObjects(tables, resolvedReferences, batch.firstObject, batch.lastObject, loadMemory, batch.startOffset);
+        }
+
+        SignalFence(batch.loaded);
+    };
+}
+
+bool LoadFileObjects(IAsyncFileHandle* file, const FileTables& tables, FileLoadingContext& context)
+{
+    // resolve all references
+    // NOTE: this will also create all objects that we want to load
+    stream::OpcodeResolvedReferences resolvedReferences;
+    ResolveReferences(tables, context, resolvedReferences);
 
-        for (uint32_t i = firstLoadObject; i < objectIndex; ++i)
+    // split the object data into batches that fit in the load buffer
+    const auto loadBufferSize = DetermineLoadBufferSize(file, tables, context, resolvedReferences);
+    Array<LoadBatch> batches;
+    PrepareLoadBatches(tables, resolvedReferences, loadBufferSize, batches);
+
+    // allocate the load buffers, no point having more than we have batches
+    const auto numLoadBuffers = std::min<uint32_t>(NumLoadBuffers, batches.size());
+    Buffer loadBuffers[NumLoadBuffers];
+    for (uint32_t i = 0; i < numLoadBuffers; ++i)
+    {
+        loadBuffers[i] = Buffer::Create(POOL_SERIALIZATION, loadBufferSize, 16);
+        if (!loadBuffers[i])
         {
-            if (auto object = resolvedReferences.objects[i])
-            {
-                // get the memory range in the loaded buffer where the object content is
-                const auto& objectEntry = objectTable[i];
-                const auto objectOffsetInBuffer = (objectEntry.dataOffset - batchStartOffset);
-                const auto objectDataSize = objectEntry.dataSize;
-                        
-                // get object data in the buffer
-                const auto* objectData = loadBuffer.data() + objectOffsetInBuffer;
-
-                // invalid data loaded ?
-                if (protectedFileLayout)
-                {
-                    const auto crc = CRC32().append(objectData, objectDataSize).crc();
-                    if (crc != objectEntry.crc)
-                    {
-                        TRACE_WARNING("LoadFile: Invalid CRC for object {} ({} != {})", i, crc, objectEntry.crc);
-                        return false;
-                    }
-                }
-
-                // read the crap
-                stream::OpcodeReader reader(resolvedReferences, objectData, objectDataSize, protectedFileLayout, tables.header()->version);
-                object->onReadBinary(reader);
-            }
+            TRACE_WARNING("LoadFile: Unable to allocate loading buffer of size {}", MemSize(loadBufferSize));
+            return false;
         }
     }
 
-    // post load objects
-    for (uint32_t i=0; i<numObjects; ++i)
+    // start loading first batches
+    uint32_t numStartedBatches = 0;
+    for (; numStartedBatches < numLoadBuffers; ++numStartedBatches)
+        StartBatchLoad(file, tables, resolvedReferences, batches[numStartedBatches], loadBuffers[numStartedBatches].data());
+
+    // deserialize batches as they arrive, each time a buffer is released the read of the next batch that will use it is started
+    // NOTE: all started reads must be waited for, even if we fail, as they reference our local data
+    bool valid = true;
+    for (uint32_t i = 0; i < numStartedBatches; ++i)
     {
-        if (auto obj = resolvedReferences.objects[i])
-            obj->onPostLoad();
+        auto& batch = batches[i];
+        const auto& loadBuffer = loadBuffers[i % numLoadBuffers];
+
+        if (CheckSemaphore(batch.loaded))
+            context.stats.numBatchesReadAhead += 1;
+
+        {
+            ScopeTimer timer;
+            WaitForFence(batch.loaded);
+            context.stats.stallTime += timer.timeElapsed();
+        }
+
+        context.stats.numBatches += 1;
+        context.stats.numBytesRead += batch.loadedSize;
+        context.stats.readTime += batch.loadTime;
+
+        if (!valid || !batch.valid || !ReadObjects(tables, resolvedReferences, batch.firstObject, batch.lastObject, loadBuffer.data(), batch.startOffset))
+            valid = false;
+
+        // buffer is free, reuse it for the next batch
+        if (valid && numStartedBatches < batches.size())
+        {
+            StartBatchLoad(file, tables, resolvedReferences, batches[numStartedBatches], loadBuffer.data());
+            numStartedBatches += 1;
+        }
     }
 
+    if (!valid)
+        return false; // cancels everything
+
+    // post load objects
+    PostLoadObjects(tables, resolvedReferences);
+
     // loaded
     return true;
 }
@@ -416,6 +539,27 @@ bool LoadFileTables(IAsyncFileHandle* file, Buffer& tablesData)
 
 bool LoadFile(IAsyncFileHandle* file, FileLoadingContext& context)
 {
+    // if we know up front how much data is needed (packed files) and it's not much just read it all at once, saves the separate reads for the header and the tables
+    if (context.knownMainFileSize && context.knownMainFileSize <= DefaultLoadBufferSize && context.knownMainFileSize <= file->size() && !context.loadSpecificClass)
+    {
+        if (auto fileData = Buffer::Create(POOL_IO, context.knownMainFileSize, 16))
+        {
+            ScopeTimer timer;
+            if (file->readAsync(0, fileData.size(), fileData.data()) != fileData.size())
+            {
+                TRACE_WARNING("LoadFile: Failed to read {} of file data", MemSize(fileData.size()));
+                return false;
+            }
+
+            context.stats.numBatches = 1;
+            context.stats.numBytesRead = fileData.size();
+            context.stats.readTime = timer.timeElapsed();
+            context.stats.stallTime = context.stats.readTime;
+
+            return LoadFile(fileData, context);
+        }
+    }
+
     // load file tables
     Buffer tablesData;
     if (!LoadFileTables(file, tablesData))
@@ -429,6 +573,79 @@ bool LoadFile(IAsyncFileHandle* file, FileLoadingContext& context)
     return true;
 }
 
+bool LoadFileTables(const Buffer& fileData, Buffer& tablesData)
+{
+    // no file
+    if (!fileData)
+        return false;
+
+    // check the header
+    if (fileData.size() < sizeof(FileTables::Header))
+    {
+        TRACE_WARNING("LoadFile: File too small to contain the header");
+        return false;
+    }
+
+    const auto& header = *(const FileTables::Header*)fileData.data();
+    if (!FileTables::ValidateHeader(header))
+    {
+        TRACE_WARNING("LoadFile: Failed to validate header");
+        return false;
+    }
+
+    if (header.headersEnd > fileData.size() || header.headersEnd < sizeof(header))
+    {
+        TRACE_WARNING("LoadFile: Invalid size of file tables ({})", header.headersEnd);
+        return false;
+    }
+
+    // validate the file tables
+    const auto* tables = (const FileTables*)fileData.data();
+    if (!tables->validate(header.headersEnd))
+    {
+        TRACE_WARNING("LoadFile: Failed to validate file tables");
+        return false;
+    }
+
+    // tables are at the start of the file, share the data instead of copying it
+    tablesData = fileData;
+    return true;
+}
+
+bool LoadFile(const Buffer& fileData, FileLoadingContext& context)
+{
+    // validate file tables
+    Buffer tablesData;
+    if (!LoadFileTables(fileData, tablesData))
+        return false;
+
+    // make sure all object data is there before we create anything
+    const auto& tables = *(const FileTables*)tablesData.data();
+    if (tables.header()->objectsEnd > fileData.size())
+    {
+        TRACE_WARNING("LoadFile: File is truncated, expected {}, got {}", tables.header()->objectsEnd, fileData.size());
+        return false;
+    }
+
+    // resolve all references
+    // NOTE: this will also create all objects that we want to load
+    stream::OpcodeResolvedReferences resolvedReferences;
+    ResolveReferences(tables, context, resolvedReferences);
+
+    // whole file is in memory, read the objects directly from it
+    const auto numObjects = tables.chunkCount(FileTables::ChunkType::Exports);
+    if (tables.header()->flags & FileTables::FileFlag_ProtectedLayout)
+        if (!ValidateObjects(tables, resolvedReferences, 0, numObjects, fileData.data(), 0))
+            return false;
+
+    if (!ReadObjects(tables, resolvedReferences, 0, numObjects, fileData.data(), 0))
+        return false;
+
+    // post load objects
+    PostLoadObjects(tables, resolvedReferences);
+    return true;
+}
+
 //--
 
 FileLoadingDependency::FileLoadingDependency()
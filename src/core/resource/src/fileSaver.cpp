@@ -14,6 +14,7 @@
 #include "core/object/include/streamOpcodes.h"
 #include "core/object/include/streamOpcodeWriter.h"
 #include "core/object/include/streamOpcodeBinarizer.h"
+#include "core/object/include/rttiClassType.h"
 #include "core/containers/include/queue.h"
 #include "core/io/include/fileHandle.h"
 #include "fileTablesBuilder.h"
@@ -44,6 +45,7 @@ public:
     FileSerializedObject* parent = nullptr;
     ObjectPtr object;
     stream::OpcodeWriterReferences localReferences;
+    stream::OpcodeStream layoutStream; // layouts of data saved in bulk, written before the object data
     stream::OpcodeStream stream;
 };
 
@@ -196,8 +198,14 @@ bool CollectObjects(const FileSavingContext& context, FileSerializedObjectCollec
 
         // serialize object to opcodes
         stream::OpcodeWriter writer(obj->stream, obj->localReferences);
+        writer.allowBulkData(context.bulkData);
         obj->object->onWriteBinary(writer);
-        if (obj->stream.corrupted())
+
+        // layouts of the data saved in bulk, we need them before any data is read so they are not lost with a skipped block
+        stream::OpcodeWriter layoutWriter(obj->layoutStream, obj->localReferences);
+        IClassType::WriteBinaryLayoutTable(layoutWriter, writer.bulkLayouts());
+
+        if (obj->stream.corrupted() || obj->layoutStream.corrupted())
         {
             TRACE_WARNING("Opcode stream corruption at object '{}' 0x{}. Possible OOM.", obj->object->cls()->name(), Hex(obj->object.get()));
             return false;
@@ -325,6 +333,7 @@ bool WriteObjects(const FileSavingContext& context, const FileSerializedObjectCo
         const auto objectStartPos = file->pos();
         {
             stream::OpcodeFileWriter fileWriter(file);
+            stream::WriteOpcodes(context.protectedStream, object->layoutStream, mappedReferences, fileWriter);
             stream::WriteOpcodes(context.protectedStream, object->stream, mappedReferences, fileWriter);
             fileWriter.flush();
 
@@ -15,11 +15,22 @@
 #include "core/system/include/scopeLock.h"
 #include "fileLoader.h"
 #include "core/object/include/objectGlobalRegistry.h"
+#include "core/app/include/configService.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
 //--
 
+// NOTE: only POSIX maps the file for real, on Windows the mapping still reads the whole file synchronously
+#ifdef PLATFORM_POSIX
+ConfigProperty<bool> cvLoadMemoryMappedFiles("Loader", "UseMemoryMappedFiles", true);
+#else
+ConfigProperty<bool> cvLoadMemoryMappedFiles("Loader", "UseMemoryMappedFiles", false);
+#endif
+ConfigProperty<uint32_t> cvLoadMemoryMappedFilesMinSize("Loader", "MemoryMappedFileMinSize", 1U << 20);
+
+//--
+
 #pragma optimize("", off)
 
 ResourceLoader::ResourceLoader()
@@ -189,9 +200,31 @@ ResourcePtr ResourceLoader::loadResourceOnce(StringView path, TimeStamp& outTime
     FileLoadingContext context;
     context.resourceLoadPath = StringBuf(path);
     context.resourceLoader = this;
+    context.knownMainFileSize = GetService<DepotService>()->queryFileKnownMainSize(path);
+
+    // big files are mapped and the objects are read in place, saves copying everything through the load buffer
+    if (cvLoadMemoryMappedFiles.get() && file->size() >= cvLoadMemoryMappedFilesMinSize.get())
+    {
+        if (auto fileData = GetService<DepotService>()->createFileMappedView(path, FileMappingHint::Sequential))
+        {
+            if (LoadFile(fileData, context))
+                return context.root<IResource>();
+
+            return nullptr;
+        }
+    }
 
     if (LoadFile(file, context))
+    {
+        // report how well the IO was hidden for the big files
+        if (context.stats.numBatches > 1)
+        {
+            TRACE_INFO("Loaded '{}': {} in {} batches ({} read ahead), read time {}, stall time {}", path, MemSize(context.stats.numBytesRead), context.stats.numBatches,
+                context.stats.numBatchesReadAhead, TimeInterval(context.stats.readTime), TimeInterval(context.stats.stallTime));
+        }
+
         return context.root<IResource>();
+    }
 
     return nullptr;
 }
@@ -12,9 +12,13 @@
 #include "core/object/include/object.h"
 #include "core/reflection/include/reflectionMacros.h"
 #include "core/io/include/fileHandleMemory.h"
+#include "core/fibers/include/fiberSystem.h"
 #include "core/object/include/streamOpcodes.h"
 #include "core/object/include/streamOpcodeWriter.h"
+#include "core/object/include/streamOpcodeReader.h"
+#include "core/object/include/streamOpcodeBinarizer.h"
 #include "core/object/include/rttiProperty.h"
+#include "core/object/include/rttiClassType.h"
 
 #include "fileSaver.h"
 #include "fileTables.h"
@@ -64,6 +68,198 @@ RTTI_PROPERTY(m_crap);
 RTTI_PROPERTY(m_child);
 RTTI_END_TYPE();
 
+struct BulkTestEntry
+{
+    RTTI_DECLARE_NONVIRTUAL_CLASS(BulkTestEntry);
+
+public:
+    Vector3 m_pos;
+    float m_radius = 0.0f;
+    uint8_t m_flags = 0; // padding after this one
+    int m_id = 0;
+};
+
+RTTI_BEGIN_TYPE_STRUCT(BulkTestEntry);
+    RTTI_PROPERTY(m_pos);
+    RTTI_PROPERTY(m_radius);
+    RTTI_PROPERTY(m_flags);
+    RTTI_PROPERTY(m_id);
+RTTI_END_TYPE();
+
+// BulkTestEntry after a refactor: properties reordered, m_flags removed, m_id changed type and a new property added
+struct BulkTestEntryV2
+{
+    RTTI_DECLARE_NONVIRTUAL_CLASS(BulkTestEntryV2);
+
+public:
+    float m_id = 0.0f;
+    Vector3 m_pos;
+    float m_extra = 5.0f;
+    float m_radius = 0.0f;
+};
+
+RTTI_BEGIN_TYPE_STRUCT(BulkTestEntryV2);
+    RTTI_PROPERTY(m_id);
+    RTTI_PROPERTY(m_pos);
+    RTTI_PROPERTY(m_extra);
+    RTTI_PROPERTY(m_radius);
+RTTI_END_TYPE();
+
+class BulkTestObject : public IObject
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(BulkTestObject, IObject);
+
+public:
+    Array<BulkTestEntry> m_entries;
+    Array<float> m_values;
+    BulkTestEntry m_single;
+};
+
+RTTI_BEGIN_TYPE_CLASS(BulkTestObject);
+    RTTI_PROPERTY(m_entries);
+    RTTI_PROPERTY(m_values);
+    RTTI_PROPERTY(m_single);
+RTTI_END_TYPE();
+
+// structure with bulk data inside, "removed" in the tests by clearing it from the resolved types
+struct BulkTestGroup
+{
+    RTTI_DECLARE_NONVIRTUAL_CLASS(BulkTestGroup);
+
+public:
+    Array<BulkTestEntry> m_entries;
+};
+
+RTTI_BEGIN_TYPE_STRUCT(BulkTestGroup);
+    RTTI_PROPERTY(m_entries);
+RTTI_END_TYPE();
+
+struct BulkTestGroupHolder
+{
+    RTTI_DECLARE_NONVIRTUAL_CLASS(BulkTestGroupHolder);
+
+public:
+    BulkTestGroup m_group; // saved first, has the first bulk block of BulkTestEntry
+    Array<BulkTestEntry> m_entries;
+};
+
+RTTI_BEGIN_TYPE_STRUCT(BulkTestGroupHolder);
+    RTTI_PROPERTY(m_group);
+    RTTI_PROPERTY(m_entries);
+RTTI_END_TYPE();
+
+/// order of the file reads and object deserialization in the streaming test
+/// NOTE: reads are gated on the deserialization of the previous object, deserialization is gated on the read of the next object, so overlap does not depend on timing
+struct StreamingTestLog
+{
+    static const uint32_t MAX_OBJECTS = 16;
+
+    std::atomic<uint32_t> eventCounter = 0;
+    std::atomic<uint32_t> numObjectsStarted = 0;
+    uint32_t numObjects = 0;
+
+    FiberSemaphore objectStarted[MAX_OBJECTS];
+    FiberSemaphore objectRead[MAX_OBJECTS];
+    uint32_t objectReadEvent[MAX_OBJECTS];
+
+    void reset(uint32_t count)
+    {
+        eventCounter = 0;
+        numObjectsStarted = 0;
+        numObjects = count;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            objectStarted[i] = CreateFence("StreamingTestObjectStarted");
+            objectRead[i] = CreateFence("StreamingTestObjectRead");
+            objectReadEvent[i] = 0;
+        }
+    }
+};
+
+static StreamingTestLog GStreamingTestLog;
+
+/// object that records when it was deserialized, used to check that the reads of the next batches are done in the meantime
+class StreamingTestObject : public IObject
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(StreamingTestObject, IObject);
+
+public:
+    Array<uint32_t> m_payload;
+
+    uint32_t deserializationStart = 0;
+    uint32_t deserializationEnd = 0;
+
+    virtual void onReadBinary(stream::OpcodeReader& reader) override
+    {
+        // objects are deserialized in the file order
+        auto& log = GStreamingTestLog;
+        const auto index = log.numObjectsStarted++;
+        deserializationStart = ++log.eventCounter;
+        SignalFence(log.objectStarted[index]);
+
+        TBaseClass::onReadBinary(reader);
+
+        // we can't finish before the next object is read, blocks forever if the read waits for us to finish
+        if (index + 1 < log.numObjects)
+            WaitForFence(log.objectRead[index + 1]);
+
+        deserializationEnd = ++log.eventCounter;
+    }
+};
+
+RTTI_BEGIN_TYPE_CLASS(StreamingTestObject);
+    RTTI_PROPERTY(m_payload);
+RTTI_END_TYPE();
+
+/// file in memory that reads object data only after the previous object started deserializing
+class GatedAsyncReaderFileHandle : public IAsyncFileHandle
+{
+public:
+    GatedAsyncReaderFileHandle(const Buffer& data)
+        : m_reader(RefNew<MemoryAsyncReaderFileHandle>(data))
+    {
+        const auto* tables = (const FileTables*)data.data();
+        const auto* objects = tables->exportTable();
+        for (uint32_t i = 0; i < tables->chunkCount(FileTables::ChunkType::Exports); ++i)
+            m_objects.emplaceBack(objects[i].dataOffset, objects[i].dataOffset + objects[i].dataSize);
+    }
+
+    INLINE uint32_t numObjectReads() const { return m_numObjectReads.load(); }
+
+    virtual uint64_t size() const override
+    {
+        return m_reader->size();
+    }
+
+    virtual CAN_YIELD uint64_t readAsync(uint64_t offset, uint64_t size, void* readBuffer) override
+    {
+        // find the first object in the read, reads of the header and tables don't contain any
+        uint32_t objectIndex = 0;
+        while (objectIndex < m_objects.size() && m_objects[objectIndex].first < offset)
+            objectIndex += 1;
+
+        if (objectIndex == m_objects.size() || m_objects[objectIndex].second > offset + size)
+            return m_reader->readAsync(offset, size, readBuffer);
+
+        auto& log = GStreamingTestLog;
+        if (objectIndex > 0)
+            WaitForFence(log.objectStarted[objectIndex - 1]);
+
+        const auto ret = m_reader->readAsync(offset, size, readBuffer);
+
+        m_numObjectReads += 1;
+        log.objectReadEvent[objectIndex] = ++log.eventCounter;
+        SignalFence(log.objectRead[objectIndex]);
+        return ret;
+    }
+
+private:
+    RefPtr<MemoryAsyncReaderFileHandle> m_reader;
+    Array<std::pair<uint64_t, uint64_t>> m_objects;
+    std::atomic<uint32_t> m_numObjectReads = 0;
+};
+
 //--
 
 void HelperSave(const ObjectPtr& obj, Buffer& outData)
@@ -81,11 +277,12 @@ void HelperSave(const ObjectPtr& obj, Buffer& outData)
     ASSERT_LT(0, outData.size()) << "No data in buffer";
 }
 
-void HelperSave(const Array<ObjectPtr>& roots, Buffer& outData, bool protectedStream)
+void HelperSave(const Array<ObjectPtr>& roots, Buffer& outData, bool protectedStream, bool bulkData = true)
 {
     FileSavingContext context;
     context.rootObject = roots;
     context.protectedStream = protectedStream;
+    context.bulkData = bulkData;
 
     auto writer = RefNew<MemoryWriterFileHandle>();
 
@@ -122,6 +319,50 @@ void HelperLoad(const Buffer& data, Array<ObjectPtr>& outRoots)
     outRoots = context.loadedRoots;
 }
 
+// write the table of bulk layouts used by the writer, as the file saver does after the object is written
+void HelperWriteLayoutTable(const stream::OpcodeWriter& writer, stream::OpcodeWriterReferences& references, stream::OpcodeStream& outLayoutStream)
+{
+    stream::OpcodeWriter layoutWriter(outLayoutStream, references);
+    IClassType::WriteBinaryLayoutTable(layoutWriter, writer.bulkLayouts());
+}
+
+// binarize opcode stream of single object, references are mapped in the order they were collected
+void HelperBinarize(const stream::OpcodeStream& stream, const stream::OpcodeWriterReferences& references, bool protectedStream, Buffer& outData, stream::OpcodeResolvedReferences& outRefs, const stream::OpcodeStream* layoutStream = nullptr)
+{
+    stream::OpcodeMappedReferences mappedReferences;
+
+    for (const auto& name : references.stringIds.keys())
+    {
+        mappedReferences.mappedNames[name] = outRefs.stringIds.size();
+        outRefs.stringIds.pushBack(name);
+    }
+
+    for (const auto& type : references.types.keys())
+    {
+        mappedReferences.mappedTypes[type] = outRefs.types.size();
+        outRefs.types.pushBack(type);
+        outRefs.typeNames.pushBack(type->name());
+    }
+
+    for (const auto* prop : references.properties.keys())
+    {
+        mappedReferences.mappedProperties[prop] = outRefs.properties.size();
+        outRefs.properties.pushBack(prop);
+        outRefs.propertyNames.pushBack(prop->name());
+    }
+
+    auto writer = RefNew<MemoryWriterFileHandle>();
+    {
+        stream::OpcodeFileWriter fileWriter(writer);
+        if (layoutStream)
+            stream::WriteOpcodes(protectedStream, *layoutStream, mappedReferences, fileWriter);
+        stream::WriteOpcodes(protectedStream, stream, mappedReferences, fileWriter);
+        fileWriter.flush();
+    }
+
+    outData = writer->extract();
+}
+
 const char* HelperGetName(const FileTables& tables, uint32_t index)
 {
     const auto numNames = tables.chunkCount(FileTables::ChunkType::Names);
@@ -343,6 +584,135 @@ TEST(Serialization, SaveLoadSimple)
     EXPECT_EQ(objectChild->m_text, loadedEx2->m_text);
 }
 
+TEST(Serialization, LoadReportsStats)
+{
+    RefPtr<TestObject> object = RefNew<TestObject>();
+    object->m_text = "I want to belive";
+
+    Buffer data;
+    HelperSave(object, data);
+
+    FileLoadingContext context;
+    auto reader = RefNew<MemoryAsyncReaderFileHandle>(data);
+    ASSERT_TRUE(LoadFile(reader, context)) << "Deserialization failed";
+
+    // small file is loaded in one go, nothing to overlap the read with
+    const auto& header = *(const FileTables::Header*)data.data();
+    EXPECT_EQ(1, context.stats.numBatches);
+    EXPECT_LE(header.objectsEnd - header.headersEnd, context.stats.numBytesRead);
+    EXPECT_LE(context.stats.numBatchesReadAhead, context.stats.numBatches);
+}
+
+TEST(Serialization, BatchReadsOverlapDeserialization)
+{
+    static const uint32_t NUM_OBJECTS = StreamingTestLog::MAX_OBJECTS;
+    static const uint32_t PAYLOAD_SIZE = 6000; // ~24KB of data per object
+    static const uint64_t LOAD_BUFFER_SIZE = 32 * 1024; // one object per batch
+
+    Array<ObjectPtr> roots;
+    for (uint32_t i = 0; i < NUM_OBJECTS; ++i)
+    {
+        auto object = RefNew<StreamingTestObject>();
+        object->m_payload.resize(PAYLOAD_SIZE);
+        for (uint32_t j = 0; j < PAYLOAD_SIZE; ++j)
+            object->m_payload[j] = i * PAYLOAD_SIZE + j;
+        roots.pushBack(object);
+    }
+
+    Buffer data;
+    HelperSave(roots, data, true);
+
+    // each object is read while the previous one is deserialized, loader that does not read ahead never finishes
+    GStreamingTestLog.reset(NUM_OBJECTS);
+
+    FileLoadingContext context;
+    context.loadBufferSize = LOAD_BUFFER_SIZE;
+    auto reader = RefNew<GatedAsyncReaderFileHandle>(data);
+    ASSERT_TRUE(LoadFile(reader, context)) << "Deserialization failed";
+
+    ASSERT_EQ(NUM_OBJECTS, context.loadedRoots.size());
+    for (uint32_t i = 0; i < NUM_OBJECTS; ++i)
+    {
+        auto loaded = rtti_cast<StreamingTestObject>(context.loadedRoots[i]);
+        ASSERT_FALSE(loaded.empty());
+        ASSERT_EQ(PAYLOAD_SIZE, loaded->m_payload.size());
+        EXPECT_EQ(i * PAYLOAD_SIZE, loaded->m_payload[0]);
+        EXPECT_EQ(i * PAYLOAD_SIZE + PAYLOAD_SIZE - 1, loaded->m_payload.back());
+    }
+
+    // each batch was read once
+    const auto& header = *(const FileTables::Header*)data.data();
+    EXPECT_EQ(NUM_OBJECTS, context.stats.numBatches);
+    EXPECT_EQ(NUM_OBJECTS, reader->numObjectReads());
+    EXPECT_LE(header.objectsEnd - header.headersEnd, context.stats.numBytesRead);
+    EXPECT_LE(context.stats.numBatchesReadAhead, context.stats.numBatches);
+
+    // every object was read while the previous one was deserialized
+    const auto& log = GStreamingTestLog;
+    for (uint32_t i = 1; i < NUM_OBJECTS; ++i)
+    {
+        auto previous = rtti_cast<StreamingTestObject>(context.loadedRoots[i - 1]);
+        auto current = rtti_cast<StreamingTestObject>(context.loadedRoots[i]);
+        EXPECT_LT(previous->deserializationStart, log.objectReadEvent[i]);
+        EXPECT_LT(log.objectReadEvent[i], previous->deserializationEnd);
+        EXPECT_LT(log.objectReadEvent[i], current->deserializationStart);
+    }
+}
+
+TEST(Serialization, SaveLoadSimpleInPlace)
+{
+    RefPtr<TestObject> object = RefNew<TestObject>();
+    object->m_int = 123;
+    object->m_text = "I want to belive";
+
+    RefPtr<TestObject> objectChild = RefNew<TestObject>();
+    objectChild->parent(object);
+    objectChild->m_int = 456;
+    objectChild->m_text = "crap";
+    object->m_child = objectChild;
+
+    // save to memory
+    Buffer data;
+    HelperSave(object, data);
+
+    // tables should be shared with the file data, not copied
+    Buffer tablesData;
+    ASSERT_TRUE(LoadFileTables(data, tablesData));
+    EXPECT_EQ(data.data(), tablesData.data());
+
+    // load directly from the buffer
+    FileLoadingContext context;
+    ASSERT_TRUE(LoadFile(data, context)) << "Deserialization failed";
+    ASSERT_EQ(1, context.loadedRoots.size()) << "Nothing loaded";
+
+    auto loadedEx = rtti_cast<TestObject>(context.loadedRoots[0]);
+    ASSERT_FALSE(loadedEx.empty());
+    auto loadedEx2 = loadedEx->m_child;
+    ASSERT_FALSE(loadedEx2.empty());
+
+    EXPECT_EQ(object->m_int, loadedEx->m_int);
+    EXPECT_EQ(object->m_text, loadedEx->m_text);
+    EXPECT_EQ(objectChild->m_int, loadedEx2->m_int);
+    EXPECT_EQ(objectChild->m_text, loadedEx2->m_text);
+}
+
+TEST(Serialization, LoadInPlaceFailsOnTruncatedData)
+{
+    RefPtr<TestObject> object = RefNew<TestObject>();
+    object->m_text = "I want to belive";
+
+    Buffer data;
+    HelperSave(object, data);
+
+    // cut the last byte of object data
+    const auto& header = *(const FileTables::Header*)data.data();
+    const auto truncatedSize = header.objectsEnd - 1;
+    auto truncated = Buffer::Create(POOL_SERIALIZATION, truncatedSize, 16, data.data(), truncatedSize);
+
+    FileLoadingContext context;
+    EXPECT_FALSE(LoadFile(truncated, context));
+}
+
 static void GenerateCrapContent(uint32_t objectCount, uint32_t contentSize, Array<RefPtr<MassTestObject>>& outTestObjects, Array<ObjectPtr>& outRoots)
 {
     FastRandState rand;
@@ -487,4 +857,340 @@ TEST(Serialization, SaveLoadMassiveMostlyObjectsUnprotected)
     }
 }
 
+//--
+
+static void GenerateBulkContent(uint32_t objectCount, uint32_t entryCount, uint8_t paddingFill, Array<ObjectPtr>& outRoots)
+{
+    FastRandState rand;
+
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        auto ptr = RefNew<BulkTestObject>();
+
+        // fill the memory first so the padding is not zero
+        ptr->m_entries.resize(entryCount);
+        memset(ptr->m_entries.data(), paddingFill, ptr->m_entries.dataSize());
+
+        for (uint32_t j = 0; j < entryCount; ++j)
+        {
+            auto& entry = ptr->m_entries[j];
+            entry.m_pos.x = rand.range(-1000.0f, 1000.0f);
+            entry.m_pos.y = rand.range(-1000.0f, 1000.0f);
+            entry.m_pos.z = rand.range(-1000.0f, 1000.0f);
+            entry.m_radius = rand.range(1.0f, 10.0f);
+            entry.m_flags = (uint8_t)rand.range(256);
+            entry.m_id = j;
+
+            ptr->m_values.pushBack(rand.range(-1.0f, 1.0f));
+        }
+
+        ptr->m_single.m_pos = Vector3(1, 2, 3);
+        ptr->m_single.m_id = 42;
+
+        outRoots.pushBack(ptr);
+    }
+}
+
+static bool HelperCompareBulkContent(const Array<ObjectPtr>& expected, const Array<ObjectPtr>& loaded)
+{
+    if (expected.size() != loaded.size())
+        return false;
+
+    for (uint32_t i = 0; i < expected.size(); ++i)
+    {
+        const auto a = rtti_cast<BulkTestObject>(expected[i]);
+        const auto b = rtti_cast<BulkTestObject>(loaded[i]);
+        if (!a || !b || a->m_entries.size() != b->m_entries.size() || a->m_values != b->m_values)
+            return false;
+
+        for (uint32_t j = 0; j < a->m_entries.size(); ++j)
+        {
+            const auto& ea = a->m_entries[j];
+            const auto& eb = b->m_entries[j];
+            if (ea.m_pos != eb.m_pos || ea.m_radius != eb.m_radius || ea.m_flags != eb.m_flags || ea.m_id != eb.m_id)
+                return false;
+        }
+
+        if (a->m_single.m_pos != b->m_single.m_pos || a->m_single.m_id != b->m_single.m_id)
+            return false;
+    }
+
+    return true;
+}
+
+TEST(Serialization, BulkLayoutOnlyForRawStructures)
+{
+    EXPECT_NE(0, BulkTestEntry::GetStaticClass()->binaryLayoutHash());
+    EXPECT_NE(0, Box::GetStaticClass()->binaryLayoutHash());
+    EXPECT_EQ(0, BulkTestObject::GetStaticClass()->binaryLayoutHash());
+    EXPECT_NE(Box::GetStaticClass()->binaryLayoutHash(), Vector3::GetStaticClass()->binaryLayoutHash());
+}
+
+TEST(Serialization, SaveLoadBulkData)
+{
+    Array<ObjectPtr> roots;
+    GenerateBulkContent(10, 100, 0xCD, roots);
+
+    for (uint32_t protectedStream = 0; protectedStream <= 1; ++protectedStream)
+    {
+        for (uint32_t bulkData = 0; bulkData <= 1; ++bulkData)
+        {
+            Buffer data;
+            HelperSave(roots, data, protectedStream, bulkData);
+
+            Array<ObjectPtr> loaded;
+            HelperLoad(data, loaded);
+
+            EXPECT_TRUE(HelperCompareBulkContent(roots, loaded)) << "Content differs, protected: " << protectedStream << ", bulk: " << bulkData;
+        }
+    }
+}
+
+TEST(Serialization, BulkDataIsDeterministic)
+{
+    // padding in the memory is different but the saved data must be the same
+    Array<ObjectPtr> rootsA, rootsB;
+    GenerateBulkContent(1, 100, 0x00, rootsA);
+    GenerateBulkContent(1, 100, 0xFF, rootsB);
+
+    Buffer dataA, dataB;
+    HelperSave(rootsA, dataA, false);
+    HelperSave(rootsB, dataB, false);
+
+    ASSERT_EQ(dataA.size(), dataB.size());
+    EXPECT_EQ(0, memcmp(dataA.data(), dataB.data(), dataA.size()));
+}
+
+TEST(Serialization, BulkLayoutWrittenOncePerStream)
+{
+    Array<BulkTestEntry> entries;
+    entries.emplaceBack().m_id = 1;
+    entries.emplaceBack().m_id = 2;
+
+    TypeSerializationContext typeContext;
+    const auto arrayType = GetTypeObject<Array<BulkTestEntry>>();
+
+    for (uint32_t protectedStream = 0; protectedStream <= 1; ++protectedStream)
+    {
+        // same data saved once and twice
+        Buffer dataOnce, dataTwice;
+        stream::OpcodeResolvedReferences refsOnce, refsTwice;
+        {
+            stream::OpcodeStream stream, layoutStream;
+            stream::OpcodeWriterReferences references;
+            stream::OpcodeWriter writer(stream, references);
+            writer.allowBulkData(true);
+            arrayType->writeBinary(typeContext, writer, &entries, nullptr);
+            HelperWriteLayoutTable(writer, references, layoutStream);
+            HelperBinarize(stream, references, protectedStream, dataOnce, refsOnce, &layoutStream);
+        }
+        {
+            stream::OpcodeStream stream, layoutStream;
+            stream::OpcodeWriterReferences references;
+            stream::OpcodeWriter writer(stream, references);
+            writer.allowBulkData(true);
+            arrayType->writeBinary(typeContext, writer, &entries, nullptr);
+            arrayType->writeBinary(typeContext, writer, &entries, nullptr);
+            EXPECT_EQ(1, writer.bulkLayouts().size());
+            HelperWriteLayoutTable(writer, references, layoutStream);
+            HelperBinarize(stream, references, protectedStream, dataTwice, refsTwice, &layoutStream);
+        }
+
+        // second block has no layout description, just the data
+        EXPECT_LT(dataTwice.size() - dataOnce.size(), dataOnce.size()) << "Protected: " << protectedStream;
+
+        // both blocks are readable
+        stream::OpcodeReader reader(refsTwice, dataTwice.data(), dataTwice.size(), protectedStream, VER_CURRENT);
+        IClassType::ReadBinaryLayoutTable(reader);
+
+        Array<BulkTestEntry> loadedA, loadedB;
+        arrayType->readBinary(typeContext, reader, &loadedA);
+        arrayType->readBinary(typeContext, reader, &loadedB);
+        EXPECT_EQ(1, reader.numBulkLayouts());
+
+        ASSERT_EQ(2, loadedA.size());
+        ASSERT_EQ(2, loadedB.size());
+        EXPECT_EQ(2, loadedA[1].m_id);
+        EXPECT_EQ(2, loadedB[1].m_id);
+    }
+}
+
+TEST(Serialization, BulkLayoutChangeIsConverted)
+{
+    Array<BulkTestEntry> entries;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        auto& entry = entries.emplaceBack();
+        entry.m_pos = Vector3(i, i * 2, i * 3);
+        entry.m_radius = 0.5f + i;
+        entry.m_flags = 0xAA;
+        entry.m_id = 100 + i;
+    }
+
+    TypeSerializationContext typeContext;
+
+    for (uint32_t protectedStream = 0; protectedStream <= 1; ++protectedStream)
+    {
+        stream::OpcodeStream stream, layoutStream;
+        stream::OpcodeWriterReferences references;
+        stream::OpcodeWriter writer(stream, references);
+        writer.allowBulkData(true);
+        GetTypeObject<Array<BulkTestEntry>>()->writeBinary(typeContext, writer, &entries, nullptr);
+        HelperWriteLayoutTable(writer, references, layoutStream);
+
+        Buffer data;
+        stream::OpcodeResolvedReferences refs;
+        HelperBinarize(stream, references, protectedStream, data, refs, &layoutStream);
+
+        // load as the new version of the structure, properties are matched by name
+        Array<BulkTestEntryV2> loaded;
+        stream::OpcodeReader reader(refs, data.data(), data.size(), protectedStream, VER_CURRENT);
+        IClassType::ReadBinaryLayoutTable(reader);
+        GetTypeObject<Array<BulkTestEntryV2>>()->readBinary(typeContext, reader, &loaded);
+
+        ASSERT_EQ(entries.size(), loaded.size()) << "Protected: " << protectedStream;
+        for (uint32_t i = 0; i < entries.size(); ++i)
+        {
+            EXPECT_EQ(entries[i].m_pos, loaded[i].m_pos);
+            EXPECT_EQ(entries[i].m_radius, loaded[i].m_radius);
+            EXPECT_EQ((float)entries[i].m_id, loaded[i].m_id);
+            EXPECT_EQ(5.0f, loaded[i].m_extra);
+        }
+    }
+}
+
+TEST(Serialization, BulkLayoutSurvivesDiscardedBlock)
+{
+    BulkTestGroupHolder holder;
+    holder.m_group.m_entries.emplaceBack().m_id = 1;
+    holder.m_entries.emplaceBack().m_id = 2;
+    holder.m_entries.emplaceBack().m_id = 3;
+
+    TypeSerializationContext typeContext;
+    const auto holderType = GetTypeObject<BulkTestGroupHolder>();
+
+    // only the protected stream can skip the data of a missing type
+    stream::OpcodeStream stream, layoutStream;
+    stream::OpcodeWriterReferences references;
+    stream::OpcodeWriter writer(stream, references);
+    writer.allowBulkData(true);
+    holderType->writeBinary(typeContext, writer, &holder, nullptr);
+    HelperWriteLayoutTable(writer, references, layoutStream);
+
+    Buffer data;
+    stream::OpcodeResolvedReferences refs;
+    HelperBinarize(stream, references, true, data, refs, &layoutStream);
+
+    // remove the outer type, the block with the first use of the BulkTestEntry layout gets discarded
+    for (auto& type : refs.types)
+        if (type == GetTypeObject<BulkTestGroup>())
+            type = Type();
+
+    stream::OpcodeReader reader(refs, data.data(), data.size(), true, VER_CURRENT);
+    IClassType::ReadBinaryLayoutTable(reader);
+
+    BulkTestGroupHolder loaded;
+    holderType->readBinary(typeContext, reader, &loaded);
+    EXPECT_FALSE(reader.corrupted());
+
+    EXPECT_EQ(0, loaded.m_group.m_entries.size());
+    ASSERT_EQ(2, loaded.m_entries.size());
+    EXPECT_EQ(2, loaded.m_entries[0].m_id);
+    EXPECT_EQ(3, loaded.m_entries[1].m_id);
+}
+
+TEST(Serialization, InvalidBulkLayoutIsReportedAsCorruption)
+{
+    Array<BulkTestEntry> entries;
+    entries.emplaceBack().m_id = 1;
+
+    TypeSerializationContext typeContext;
+    const auto arrayType = GetTypeObject<Array<BulkTestEntry>>();
+
+    // data references a layout that is not in the (empty) layout table
+    stream::OpcodeStream stream, layoutStream;
+    stream::OpcodeWriterReferences references;
+    stream::OpcodeWriter writer(stream, references);
+    writer.allowBulkData(true);
+    arrayType->writeBinary(typeContext, writer, &entries, nullptr);
+
+    stream::OpcodeWriter layoutWriter(layoutStream, references);
+    IClassType::WriteBinaryLayoutTable(layoutWriter, Array<Type>());
+
+    Buffer data;
+    stream::OpcodeResolvedReferences refs;
+    HelperBinarize(stream, references, true, data, refs, &layoutStream);
+
+    stream::OpcodeReader reader(refs, data.data(), data.size(), true, VER_CURRENT);
+    IClassType::ReadBinaryLayoutTable(reader);
+    EXPECT_EQ(0, reader.numBulkLayouts());
+
+    Array<BulkTestEntry> loaded;
+    arrayType->readBinary(typeContext, reader, &loaded);
+    EXPECT_TRUE(reader.corrupted());
+}
+
+TEST(Serialization, ArraysFromOldFilesAreReadPerElement)
+{
+    Array<int> values;
+    values.pushBack(1);
+    values.pushBack(2);
+    values.pushBack(3);
+
+    Array<BulkTestEntry> entries;
+    entries.emplaceBack().m_id = 7;
+    entries.emplaceBack().m_id = 8;
+
+    TypeSerializationContext typeContext;
+
+    for (uint32_t protectedStream = 0; protectedStream <= 1; ++protectedStream)
+    {
+        // files saved before VER_BULK_BINARY_DATA had every element saved separately, exactly as with the bulk data disabled
+        stream::OpcodeStream stream;
+        stream::OpcodeWriterReferences references;
+        stream::OpcodeWriter writer(stream, references);
+        writer.allowBulkData(false);
+        GetTypeObject<Array<int>>()->writeBinary(typeContext, writer, &values, nullptr);
+        GetTypeObject<Array<BulkTestEntry>>()->writeBinary(typeContext, writer, &entries, nullptr);
+
+        Buffer data;
+        stream::OpcodeResolvedReferences refs;
+        HelperBinarize(stream, references, protectedStream, data, refs);
+
+        // old file version and current one (file saved with the bulk data disabled)
+        for (const auto version : { VER_THREAD_SAFE_GRAPHS, VER_CURRENT })
+        {
+            stream::OpcodeReader reader(refs, data.data(), data.size(), protectedStream, version);
+
+            Array<int> loadedValues;
+            GetTypeObject<Array<int>>()->readBinary(typeContext, reader, &loadedValues);
+            EXPECT_EQ(values, loadedValues) << "Protected: " << protectedStream << ", version: " << version;
+
+            Array<BulkTestEntry> loadedEntries;
+            GetTypeObject<Array<BulkTestEntry>>()->readBinary(typeContext, reader, &loadedEntries);
+            ASSERT_EQ(2, loadedEntries.size());
+            EXPECT_EQ(7, loadedEntries[0].m_id);
+            EXPECT_EQ(8, loadedEntries[1].m_id);
+        }
+    }
+}
+
+TEST(Serialization, Perf_LoadBulkData)
+{
+    // resembles streamed world content - lots of simple placement data
+    Array<ObjectPtr> roots;
+    GenerateBulkContent(100, 10000, 0, roots);
+
+    for (uint32_t bulkData = 0; bulkData <= 1; ++bulkData)
+    {
+        Buffer data;
+        HelperSave(roots, data, false, bulkData);
+
+        ScopeTimer timer;
+        Array<ObjectPtr> loaded;
+        HelperLoad(data, loaded);
+        TRACE_WARNING("Load {} took {}, content {}", bulkData ? "bulk" : "tagged", timer, MemSize(data.size()));
+    }
+}
+
 END_BOOMER_NAMESPACE_EX(test)
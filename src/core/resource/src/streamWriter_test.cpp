@@ -371,6 +371,46 @@ TEST(StreamOpcodes, DynamicArray)
     ASSERT_FALSE(it);
 }
 
+TEST(StreamOpcodes, DynamicArrayBulkData)
+{
+    stream::OpcodeStream stream;
+    stream::OpcodeWriterReferences references;
+    stream::OpcodeWriter writer(stream, references);
+    writer.allowBulkData(true);
+
+    Array<int> ar;
+    ar.pushBack(1);
+    ar.pushBack(2);
+    ar.pushBack(3);
+
+    HelperWriteType(writer, ar);
+
+    ASSERT_EQ(3, stream.totalOpcodeCount()); // all data in one block + begin/end array
+
+    stream::OpcodeIterator it(&stream);
+    {
+        ASSERT_EQ(stream::StreamOpcode::Array, it->op);
+        const auto* op = (const stream::StreamOpArray*)(*it);
+        ASSERT_EQ(3, op->count);
+        ++it;
+    }
+    {
+        ASSERT_EQ(stream::StreamOpcode::DataRaw, it->op);
+        const auto* op = (const stream::StreamOpDataRaw*)(*it);
+        ASSERT_EQ(12, op->dataSize());
+        const auto* data = (const uint32_t*)op->data();
+        ASSERT_EQ(1, data[0]);
+        ASSERT_EQ(2, data[1]);
+        ASSERT_EQ(3, data[2]);
+        ++it;
+    }
+    {
+        ASSERT_EQ(stream::StreamOpcode::ArrayEnd, it->op);
+        ++it;
+    }
+    ASSERT_FALSE(it);
+}
+
 TEST(StreamOpcodes, ResourceAsyncRef)
 {
     stream::OpcodeStream stream;
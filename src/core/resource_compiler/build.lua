@@ -17,3 +17,4 @@ Dependency("core_fibers")
 Dependency("core_math")
 Dependency("core_config")
 Dependency("core_xml")
+Dependency("core_test")
\ No newline at end of file
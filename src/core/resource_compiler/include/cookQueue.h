@@ -0,0 +1,87 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: cook #]
+***/
+
+#pragma once
+
+#include "core/fibers/include/fiberSystem.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+/// file waiting to be processed by one of the cooking jobs
+struct CookQueueEntry
+{
+    ResourcePath key;
+    int parent = -1; // index of the record of the file that referenced this file (-1 for seed files)
+};
+
+/// timing of single processed file
+struct CookedFileRecord
+{
+    ResourcePath key;
+    int parent = -1;
+    double checkTime = 0.0; // checking if the cooked file is up to date
+    double cookTime = 0.0;
+    double pathTime = 0.0; // total time of the chain of files that led to this file, including this one
+    bool cooked = false;
+};
+
+/// queue of files shared by all cooking jobs, files referenced by the processed files are put back into it
+/// NOTE: thread safe
+class CORE_RESOURCE_COMPILER_API CookQueue : public NoCopy
+{
+public:
+    CookQueue();
+    ~CookQueue();
+
+    /// was the cooking canceled ?
+    INLINE bool canceled() const { return m_canceled.load(); }
+
+    /// records of all processed files, in the order of processing
+    /// NOTE: safe to access only when all cooking jobs are done
+    INLINE const Array<CookedFileRecord>& records() const { return m_records; }
+
+    //--
+
+    /// add seed file to the queue
+    void push(const ResourcePath& key);
+
+    /// get next file to process, returns false if there's nothing more to do (or cooking was canceled)
+    /// NOTE: if the queue is empty but other jobs are still processing files we wait (without spinning) for them to finish
+    bool pop(CookQueueEntry& outEntry);
+
+    /// finish processing of file returned by pop(), record is NULL if file was skipped
+    /// referenced files are added to the queue and wake up the waiting jobs
+    void finish(const CookedFileRecord* record, Array<CookQueueEntry>& referencedFiles);
+
+    /// stop cooking, all waiting and future pop() calls return false
+    void cancel();
+
+    //--
+
+    /// get the slowest processed files, slowest first
+    void collectSlowestFiles(uint32_t maxCount, Array<const CookedFileRecord*>& outRecords) const;
+
+    /// get the critical path - the longest chain of files that had to be processed one after another, starts with the seed file
+    /// NOTE: no amount of cooking jobs will make the cooking faster than this
+    void collectCriticalPath(Array<const CookedFileRecord*>& outRecords) const;
+
+private:
+    SpinLock m_lock;
+    Array<CookQueueEntry> m_entries;
+    Array<CookedFileRecord> m_records;
+    uint32_t m_numFilesInFlight = 0;
+    std::atomic<bool> m_canceled = false;
+
+    FiberSemaphore m_fileFinishedFence; // created by the first pop() that has to wait, signaled by next finish()
+};
+
+//--
+
+END_BOOMER_NAMESPACE()
@@ -77,6 +77,9 @@ enum class FingerpintCalculationStatus : uint8_t
     ErrorOutOfMemory,
 };
 
+/// NOTE: fingerprint is a 64-bit hash of the content (XXH3 of 1MB chunks, merged in order), all functions below give the same result for the same content
+/// NOTE: chunks of bigger files are hashed in parallel on child fibers
+
 /// calculate file content fingerprint, returns false if canceled or error occurs
 extern CORE_RESOURCE_COMPILER_API FingerpintCalculationStatus CalculateMemoryFingerprint(const void* data, uint64_t size, IProgressTracker* progress, ImportFileFingerprint& outFingerpint);
 
@@ -8,68 +8,87 @@
 
 #pragma once
 
-#include "core/io/include/timestamp.h"
-#include "core/containers/include/hashMap.h"
+#include "core/io/include/public.h"
+#include "core/containers/include/flatHashMap.h"
 #include "importFileFingerprint.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
 //---
 
-struct CORE_RESOURCE_COMPILER_API ImportFileFingerprintTimestampEntry
+/// persistent database of file fingerprints
+/// the file is a small header followed by fixed size records, new records are appended at the end so the file is not rewritten during normal use
+/// records are keyed by the hash of the path and are only valid if the identity of the file (ID, size and modification time) did not change
+/// NOTE: not thread safe
+class CORE_RESOURCE_COMPILER_API ImportFingerprintCache : public NoCopy
 {
-    RTTI_DECLARE_NONVIRTUAL_CLASS(ImportFileFingerprintTimestampEntry);
-
-    uint64_t timestamp = 0;
-    ImportFileFingerprint fingerprint;
-};
-
-struct CORE_RESOURCE_COMPILER_API ImportFileFingerprintCacheEntry
-{
-    RTTI_DECLARE_NONVIRTUAL_CLASS(ImportFileFingerprintCacheEntry);
-
-    StringBuf absolutePathUTF8; // conformed - lower case
-    Array<ImportFileFingerprintTimestampEntry> timestampEntries; // sorted by time
-};
-
-//--
-            
-// trivial "cache" for fingerprints
-class CORE_RESOURCE_COMPILER_API ImportFingerprintCache : public IResource
-{
-    RTTI_DECLARE_VIRTUAL_CLASS(ImportFingerprintCache, IResource);
-
 public:
     ImportFingerprintCache();
-    virtual ~ImportFingerprintCache();
+    ~ImportFingerprintCache();
 
     //--
 
     /// get number of entries in cache
     INLINE uint32_t size() const { return m_entries.size(); }
 
+    /// get number of entries not yet written to file
+    INLINE uint32_t numPendingEntries() const { return m_pendingEntries.size(); }
+
+    //--
+
+    /// load entries from file (memory mapped), damaged records (ie. partially written ones) are ignored
+    /// NOTE: the file is rewritten on next flush if it's missing or damaged
+    bool load(StringView absolutePath);
+
+    /// write pending entries to file, appending them at the end
+    /// NOTE: the whole file is rewritten if it contains too many outdated records
+    bool flush(StringView absolutePath);
+
     //--
 
     /// clear the cache
     void clear();
 
-    /// find entry for given path and timestamp
-    bool findEntry(StringView path, TimeStamp timestamp, ImportFileFingerprint& outFingerprint);
+    /// find entry for given path and file identity
+    bool findEntry(StringView path, const FileIdentity& identity, ImportFileFingerprint& outFingerprint) const;
 
-    /// store entry for given path and timestamp
-    void storeEntry(StringView path, TimeStamp timestamp, const ImportFileFingerprint& fingerprint);
+    /// store entry for given path and file identity
+    void storeEntry(StringView path, const FileIdentity& identity, const ImportFileFingerprint& fingerprint);
 
 private:
-    HashMap<StringBuf, uint32_t> m_entriesMap;
-    Array<ImportFileFingerprintCacheEntry> m_entries;
+    struct Record
+    {
+        uint64_t pathHash = 0;
+        uint64_t fileId = 0;
+        uint64_t size = 0;
+        uint64_t timestamp = 0;
+        uint64_t fingerprint = 0;
+        uint64_t check = 0; // hash of the rest of the record, detects partially written records
+    };
+
+    struct Header
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t recordSize = 0;
+        uint32_t reserved = 0;
+    };
+
+    static_assert(sizeof(Record) == 48, "Record size is part of the file format");
+    static_assert(sizeof(Header) == 16, "Header size is part of the file format");
+
+    FlatHashMap<uint64_t, Record> m_entries;
+    Array<Record> m_pendingEntries;
+
+    uint32_t m_numFileRecords = 0; // records in the file, including the outdated ones
+    bool m_rewriteFile = true; // file is missing or damaged, can't append to it
 
     //--
 
-    void rebuildMap();
-
-    void conformPath(StringView path, StringBuf& outPath) const;
+    static uint64_t PathHash(StringView path);
+    static uint64_t RecordCheck(const Record& record);
 
-    virtual void onPostLoad() override;
+    bool writeAll(StringView absolutePath);
 };
 
 //---
@@ -8,7 +8,7 @@
 
 #pragma once
 
-#include "core/io/include/timestamp.h"
+#include "core/io/include/public.h"
 #include "core/containers/include/hashMap.h"
 #include "core/fibers/include/fiberSystem.h"
 #include "importFileFingerprint.h"
@@ -39,12 +39,8 @@ public:
     //---
 
 private:
-    static const uint32_t HEADER_MAGIC = 0x43524343;//'CRCC';
-
-    //--
-
     Mutex m_cacheLock;
-    RefPtr<ImportFingerprintCache> m_cache;
+    UniquePtr<ImportFingerprintCache> m_cache;
 
     StringBuf m_cacheFilePath;
     NativeTimePoint m_nextCacheWriteCheck;
@@ -56,7 +52,7 @@ private:
     struct CacheJob : public IReferencable
     {
         StringBuf path;
-        TimeStamp timestamp;
+        FileIdentity identity;
         ImportFileFingerprint fingerprint;
         FingerpintCalculationStatus status = FingerpintCalculationStatus::OK;
         FiberSemaphore signal;
@@ -72,7 +68,7 @@ private:
     virtual void onShutdownService() override;
     virtual void onSyncUpdate() override;
 
-    void saveCacheIfDirty();
+    void flushCache();
 
     //--
 };
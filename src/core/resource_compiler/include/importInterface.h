@@ -126,6 +126,32 @@ private:
 
 //--
 
+/// limit number of resources imported at the same time with given importer class (ie. when the importer uses a library that is not thread safe)
+/// NOTE: importers without this metadata can run on as many jobs as the import queue has
+class CORE_RESOURCE_COMPILER_API ResourceImporterConcurrencyMetadata : public IMetadata
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(ResourceImporterConcurrencyMetadata, IMetadata);
+
+public:
+    ResourceImporterConcurrencyMetadata();
+
+    INLINE ResourceImporterConcurrencyMetadata& maxConcurrentJobs(uint32_t count)
+    {
+        m_maxConcurrentJobs = count;
+        return *this;
+    }
+
+    INLINE uint32_t maxConcurrentJobs() const
+    {
+        return m_maxConcurrentJobs;
+    }
+
+private:
+    uint32_t m_maxConcurrentJobs = 0; // 0 - no limit
+};
+
+//--
+
 /// asset importer, class accessible strictly only in the dev projects
 class CORE_RESOURCE_COMPILER_API IResourceImporter : public IReferencable
 {
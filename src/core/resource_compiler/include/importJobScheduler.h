@@ -0,0 +1,73 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: import #]
+***/
+
+#pragma once
+
+#include "core/fibers/include/fiberSystem.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+/// concurrency limit shared by all jobs of one importer class
+struct ImportJobSlots
+{
+    uint32_t maxRunning = 0; // 0 - no limit
+    uint32_t numRunning = 0;
+};
+
+/// scheduling state of single import job
+struct ImportScheduledJob : public NoCopy
+{
+    ImportJobSlots* slots = nullptr; // not set if there's no importer for this job, it will fail anyway
+    const ImportScheduledJob* dependency = nullptr; // earlier job importing from the same asset file, the asset is loaded by it first and then reused from the cache
+    bool finished = false;
+};
+
+/// decides which of the waiting import jobs can start
+/// jobs start in the scheduling order as soon as the earlier job for the same asset is finished and their importer is below its limit
+/// NOTE: thread safe
+class CORE_RESOURCE_COMPILER_API ImportJobScheduler : public NoCopy
+{
+public:
+    ImportJobScheduler();
+    ~ImportJobScheduler();
+
+    /// number of jobs that were started and are not yet finished
+    uint32_t numRunningJobs() const;
+
+    /// number of jobs waiting to start
+    uint32_t numWaitingJobs() const;
+
+    //--
+
+    /// add job at the end of the waiting list, jobs from the same asset file run one after another
+    /// NOTE: job must stay alive for as long as the scheduler exists
+    void push(ImportScheduledJob* job, const StringBuf& assetKey);
+
+    /// get next job that can start, returns NULL if there are no more jobs
+    /// NOTE: if none of the waiting jobs can start yet we wait (without spinning) until one of the running jobs finishes
+    ImportScheduledJob* pop();
+
+    /// mark started job as finished, wakes up all jobs waiting in pop()
+    void finish(ImportScheduledJob* job);
+
+private:
+    mutable SpinLock m_lock;
+    Array<ImportScheduledJob*> m_waitingJobs; // in the order of scheduling
+    HashMap<StringBuf, ImportScheduledJob*> m_lastJobPerAsset;
+    uint32_t m_numRunningJobs = 0;
+
+    FiberSemaphore m_jobFinishedFence; // created by the first pop() that has to wait, signaled by next finish()
+
+    ImportScheduledJob* popReadyJob_NoLock();
+};
+
+//--
+
+END_BOOMER_NAMESPACE()
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "importer.h"
+#include "importJobScheduler.h"
 
 #include "core/app/include/localService.h"
 #include "core/socket/include/tcpServer.h"
@@ -75,9 +76,13 @@ public:
     void scheduleJob(const ImportJobInfo& job);
 
     /// process next job from the list, returns false if there are no more jobs
-    /// NOTE: thread safe
+    /// NOTE: thread safe, if other jobs are still running but none of the waiting ones can start yet we wait for one of them to finish
     bool processNextJob(IProgressTracker* progressTracker);
 
+    /// process all jobs (including the follow up ones) using up to given number of concurrent fiber jobs, returns when there are no more jobs
+    /// NOTE: importers can limit how many of their jobs run at the same time with ResourceImporterConcurrencyMetadata
+    void processAllJobs(IProgressTracker* progressTracker, uint32_t maxConcurrentJobs);
+
     //--
 
 private:
@@ -90,7 +95,12 @@ private:
 
     //--
 
-    struct LocalJobInfo : public NoCopy
+    struct ImporterSlots : public ImportJobSlots
+    {
+        SpecificClassType<IResourceImporter> importerClass;
+    };
+
+    struct LocalJobInfo : public ImportScheduledJob
     {
         RTTI_DECLARE_POOL(POOL_IMPORT)
 
@@ -101,15 +111,20 @@ private:
     SpinLock m_jobLock;
     Array<LocalJobInfo*> m_jobsList;
     HashMap<StringBuf, LocalJobInfo*> m_jobsMap;
-    Queue<LocalJobInfo*> m_jobQueue;
+    Array<ImporterSlots*> m_importerSlots;
+
+    UniquePtr<ImportJobScheduler> m_scheduler;
+
+    std::atomic<uint32_t> m_numTotalJobsDone = 0;
+    std::atomic<uint32_t> m_numTotalJobsScheduled = 0;
 
-    volatile uint32_t m_numTotalJobsDone = 0;
-    volatile uint32_t m_numTotalJobsScheduled = 0;
+    ImporterSlots* importerSlots(SpecificClassType<IResourceImporter> importerClass);
 
-    const LocalJobInfo* popNextJob();
+    void processJob(const LocalJobInfo* job, IProgressTracker* progressTracker);
 
     //--
 
+    UniquePtr<IImportQueueCallbacks> m_serializedCallbacks;
     IImportQueueCallbacks* m_callbacks = nullptr;
 };
 
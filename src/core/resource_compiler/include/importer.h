@@ -62,6 +62,9 @@ public:
     /// import single resource, produces imported resource (with meta data)
     ImportStatus importResource(const ImportJobInfo& info, const IResource* existingData, ResourcePtr& outImportedResource, IProgressTracker* progress=nullptr) const;
 
+    /// find importer class that will be used to import given job, null if the job can't be imported
+    SpecificClassType<IResourceImporter> findImporterClass(const ImportJobInfo& info) const;
+
     //--
 
 private:
@@ -17,12 +17,14 @@
 #include "core/io/include/fileHandle.h"
 #include "core/containers/include/stringBuilder.h"
 #include "core/resource/include/tags.h"
+#include "core/fibers/include/fiberSystem.h"
 
 #include "cookerSaveThread.h"
 
 #include "commandCook.h"
 #include "core/resource/include/fileLoader.h"
 #include "core/resource/include/depot.h"
+#include "core/resource/include/depotArchive.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
@@ -45,6 +47,7 @@ bool CommandCook::run(IProgressTracker* progress, const app::CommandLine& comman
 
     m_captureLogs = !commandline.hasParam("verboseLogs");
     m_discardCookedLogs = !commandline.hasParam("keepAllLogs");
+    m_maxConcurrentJobs = std::clamp<int>(commandline.singleValueInt("cookConcurrency", WorkerThreadCount()), 1, 256);
 
     TRACE_INFO("Cooking output directory: '{}'", m_outputDir);
 
@@ -70,6 +73,30 @@ bool CommandCook::run(IProgressTracker* progress, const app::CommandLine& comman
 
     //--
 
+    // capture all names used by the cooked content so the game can load them in one go at startup
+    // NOTE: the snapshot is part of the cook output, packaging copies it to where the launcher loads it from (<engine>/data/names.snapshot)
+    {
+        auto snapshotPath = commandline.singleValue("nameSnapshot");
+        if (snapshotPath.empty())
+            snapshotPath = StringBuf(TempString("{}names.snapshot", m_outputDir));
+
+        if (!SaveFileFromBuffer(snapshotPath, StringID::SaveSnapshot()))
+            TRACE_WARNING("Failed to save name snapshot to '{}'", snapshotPath);
+    }
+
+    //--
+
+    // pack all the cooked files into a single archive that can be mounted instead of the loose depot
+    const auto& archivePath = commandline.singleValue("archive");
+    if (!archivePath.empty())
+    {
+        const auto compression = (commandline.singleValue("archiveCompression") == "none") ? CompressionType::Uncompressed : CompressionType::LZ4;
+        if (!packCookedFiles(archivePath, compression))
+            return false;
+    }
+
+    //--
+
     TRACE_INFO("Total {} files processed", m_allCollectedFiles.size());
     return true;
 }
@@ -160,105 +187,183 @@ bool CommandCook::collectSeedFiles()
 
 //--
 
+bool CommandCook::ConcurrentFileSet::insert(const ResourcePath& key)
+{
+    auto& shard = shards[key.hash() % NUM_SHARDS];
+    auto lock = CreateLock(shard.lock);
+    return shard.files.insert(key);
+}
+
+uint32_t CommandCook::ConcurrentFileSet::size() const
+{
+    uint32_t ret = 0;
+    for (const auto& shard : shards)
+        ret += shard.files.size();
+    return ret;
+}
+
+//--
+
 bool CommandCook::processSeedFiles()
 {
-    for (uint32_t i = 0; i<m_seedFiles.size(); ++i)
-    {
-        const auto& seedFilePath = m_seedFiles.keys()[i];
-        TRACE_INFO("Processing seed file {}/{}: {}", i + 1, m_seedFiles.size(), seedFilePath);
+    ScopeTimer timer;
 
-        processSingleSeedFile(seedFilePath);
+    // all seed files go to the queue at once, files referenced from them are discovered while cooking
+    for (const auto& seedFilePath : m_seedFiles.keys())
+        m_cookingQueue.push(seedFilePath);
 
-        if (m_numTotalFailed > 100)
+    TRACE_INFO("Processing {} seed files using {} cooking jobs", m_seedFiles.size(), m_maxConcurrentJobs);
+
+    if (m_maxConcurrentJobs <= 1)
+    {
+        processCookingJobs();
+    }
+    else
+    {
+        auto jobsDone = CreateFence("CookingJobs", m_maxConcurrentJobs);
+        RunChildFiber("CookingJob").invocations(m_maxConcurrentJobs) << [this, jobsDone](FIBER_FUNC)
         {
-            // something is really wrong
-            TRACE_ERROR("More than 100 files failed cooking, something must be VERY wrong. Stopping now.");
-            return false;
-        }
+            processCookingJobs();
+            SignalFence(jobsDone);
+        };
+
+        WaitForFence(jobsDone);
     }
 
-    TRACE_INFO("Finished processing {} seed files.", m_seedFiles.size());
-    TRACE_INFO("Visited {} files, {} up to date, {} copied, {} cooked and {} failed", m_numTotalVisited, m_numTotalUpToDate, m_numTotalCopied, m_numTotalCooked, m_numTotalFailed);
+    if (m_cookingQueue.canceled())
+    {
+        // something is really wrong
+        TRACE_ERROR("More than 100 files failed cooking, something must be VERY wrong. Stopping now.");
+        return false;
+    }
+
+    TRACE_INFO("Finished processing {} seed files in {}", m_seedFiles.size(), timer);
+    TRACE_INFO("Visited {} files, {} up to date, {} copied, {} cooked and {} failed", m_numTotalVisited.load(), m_numTotalUpToDate.load(), m_numTotalCopied.load(), m_numTotalCooked.load(), m_numTotalFailed.load());
+
+    printCookingTimings();
 
     m_saveThread->waitUntilDone();
 
     return m_numTotalFailed == 0;
 }
 
-void CommandCook::processSingleSeedFile(const ResourcePath& seedFileKey)
+void CommandCook::processCookingJobs()
 {
-    bool valid = true;
+    CookQueueEntry entry;
+    while (m_cookingQueue.pop(entry))
+    {
+        CookedFileRecord record;
+        Array<CookQueueEntry> referencedFiles;
+        const auto processed = processSingleFile(entry, record, referencedFiles);
 
-    Array<PendingCookingEntry> cookingQueue;
-    ScopeTimer cookingTimer;
+        // NOTE: referenced files are shared with other jobs only after the file is done so its path time is known
+        m_cookingQueue.finish(processed ? &record : nullptr, referencedFiles);
 
-    auto& rootEntry = cookingQueue.emplaceBack();
-    rootEntry.key = seedFileKey;
+        if (m_numTotalFailed > 100)
+            m_cookingQueue.cancel();
+    }
+}
 
-    uint32_t localProcessed = 0;
-    while (!cookingQueue.empty())
-    {
-        // get entry to cook
-        auto topEntry = std::move(cookingQueue.back());
-        cookingQueue.popBack();
-        localProcessed += 1;
-        m_numTotalVisited += 1;
-
-        // prevent this file from being recooked second time this session
-        if (!m_allSeenFile.insert(topEntry.key))
-            continue;
+bool CommandCook::processSingleFile(const CookQueueEntry& entry, CookedFileRecord& record, Array<CookQueueEntry>& referencedFiles)
+{
+    m_numTotalVisited += 1;
 
-        /// check if can cook this file at all
-        SpecificClassType<IResource> cookedClass;
-        /*if (!m_cooker->canCook(topEntry.key, cookedClass))
-        {
-            TRACE_WARNING("Resource '{}' is not cookable and will be skipped. Why is it referenced though?");
-            continue;
-        }*/
+    // prevent this file from being recooked second time this session
+    if (!m_allSeenFile.insert(entry.key))
+        return false;
 
-        // assemble cooked output path - cooked file will be stored there
-        StringBuf cookedFilePath;
-        if (!assembleCookedOutputPath(topEntry.key, cookedClass, cookedFilePath))
-        {
-            TRACE_WARNING("Resource '{}' is not cookable (no valid cooked extension)");
-            continue;
-        }
+    record.key = entry.key;
+    record.parent = entry.parent;
+
+    ScopeTimer checkTimer;
 
-        // evaluate dirty state of the file, especially if we can skip cooking it :)
-        // first, target file must exist to have any chance of skipping the cook :)
-        if (FileExists(cookedFilePath))
+    /// check if can cook this file at all
+    SpecificClassType<IResource> cookedClass;
+    /*if (!m_cooker->canCook(entry.key, cookedClass))
+    {
+        TRACE_WARNING("Resource '{}' is not cookable and will be skipped. Why is it referenced though?");
+        return;
+    }*/
+
+    // assemble cooked output path - cooked file will be stored there
+    StringBuf cookedFilePath;
+    if (!assembleCookedOutputPath(entry.key, cookedClass, cookedFilePath))
+    {
+        TRACE_WARNING("Resource '{}' is not cookable (no valid cooked extension)");
+        return false;
+    }
+
+    // evaluate dirty state of the file, especially if we can skip cooking it :)
+    // first, target file must exist to have any chance of skipping the cook :)
+    bool upToDate = false;
+    if (FileExists(cookedFilePath))
+    {
+        // load the source dependencies of the file (metadata)
+        auto metadata = loadFileMetadata(cookedFilePath);
+        if (metadata)
         {
-            // load the source dependencies of the file (metadata)
-            auto metadata = loadFileMetadata(cookedFilePath);
-            if (metadata)
+            // if all our dependencies check out then we don't have to cook that file
+            if (checkDependenciesUpToDate(*metadata))
             {
-                // if all our dependencies check out then we don't have to cook that file
-                if (checkDependenciesUpToDate(*metadata))
-                {
-                    // we can skip this file but make sure the loading dependencies are cooked
-                    queueDependencies(cookedFilePath, cookingQueue);
-                    m_numTotalUpToDate += 1;
-                    continue;;
-                }
-            }
-            else
-            {
-                TRACE_WARNING("Failed to load metadata for output file '{}'. It might be corrupted, recooking.", topEntry.key);
+                // we can skip this file but make sure the loading dependencies are cooked
+                queueDependencies(cookedFilePath, referencedFiles);
+                m_numTotalUpToDate += 1;
+                upToDate = true;
             }
         }
-
-        // cook the file
-        if (cookFile(topEntry.key, cookedClass, cookedFilePath, cookingQueue))
+        else
         {
-            m_numTotalCooked += 1;
+            TRACE_WARNING("Failed to load metadata for output file '{}'. It might be corrupted, recooking.", entry.key);
         }
+    }
+
+    record.checkTime = checkTimer.timeElapsed();
+
+    // cook the file
+    if (!upToDate)
+    {
+        ScopeTimer cookTimer;
+
+        if (cookFile(entry.key, cookedClass, cookedFilePath, referencedFiles))
+            m_numTotalCooked += 1;
         else
-        {
             m_numTotalFailed += 1;
+
+        record.cookTime = cookTimer.timeElapsed();
+        record.cooked = true;
+    }
+
+    return true;
+}
+
+void CommandCook::printCookingTimings() const
+{
+    if (m_cookingQueue.records().empty())
+        return;
+
+    // slowest files
+    {
+        Array<const CookedFileRecord*> slowestRecords;
+        m_cookingQueue.collectSlowestFiles(20, slowestRecords);
+
+        TRACE_INFO("Slowest {} of {} processed files:", slowestRecords.size(), m_cookingQueue.records().size());
+        for (uint32_t i = 0; i < slowestRecords.size(); ++i)
+        {
+            const auto* record = slowestRecords[i];
+            TRACE_INFO("  [{}] '{}': {} ({} check, {} cook)", i + 1, record->key, TimeInterval(record->checkTime + record->cookTime),
+                TimeInterval(record->checkTime), record->cooked ? TimeInterval(record->cookTime) : TimeInterval(0.0));
         }
     }
 
-    TRACE_INFO("Processed {} source files for seed file '{}' in {}", localProcessed, seedFileKey, cookingTimer);
+    // critical path - the longest chain of files that had to be processed one after another
+    {
+        Array<const CookedFileRecord*> path;
+        m_cookingQueue.collectCriticalPath(path);
+
+        TRACE_INFO("Critical path: {} files, {}", path.size(), TimeInterval(path.back()->pathTime));
+        for (const auto* record : path)
+            TRACE_INFO("  '{}': {}", record->key, TimeInterval(record->checkTime + record->cookTime));
+    }
 }
 
 bool CommandCook::checkDependenciesUpToDate(const ResourceMetadata& deps) const
@@ -302,6 +407,38 @@ bool CommandCook::checkDependenciesUpToDate(const ResourceMetadata& deps) const
     return true;
 }
 
+bool CommandCook::packCookedFiles(StringView archivePath, CompressionType compression) const
+{
+    ScopeTimer timer;
+
+    const StringBuf cookedDir = TempString("{}cooked/", m_outputDir);
+
+    DepotArchiveBuilder builder(compression);
+    uint32_t numFiles = 0;
+    FindFiles(cookedDir, "*.*", [&builder, &cookedDir, &numFiles](StringView fullPath, StringView fileName)
+        {
+            // cooked files are stored at their depot paths
+            auto relativePath = StringBuf(fullPath.subString(cookedDir.length()));
+            relativePath.replaceChar('\\', '/');
+            while (relativePath.view().beginsWith("/"))
+                relativePath = StringBuf(relativePath.view().subString(1));
+
+            builder.addFile(TempString("/{}", relativePath), fullPath);
+            numFiles += 1;
+            return false;
+        }, true);
+
+    TRACE_INFO("Packing {} cooked files into '{}'", numFiles, archivePath);
+    if (!builder.save(archivePath))
+    {
+        TRACE_ERROR("Failed to pack cooked files into '{}'", archivePath);
+        return false;
+    }
+
+    TRACE_INFO("Packed {} cooked files in {}", numFiles, timer);
+    return true;
+}
+
 ResourceMetadataPtr CommandCook::loadFileMetadata(StringView cookedOutputPath) const
 {
     if (auto fileReader = OpenForAsyncReading(cookedOutputPath))
@@ -335,7 +472,7 @@ bool CommandCook::assembleCookedOutputPath(const ResourcePath& key, SpecificClas
 
 //--
 
-void CommandCook::queueDependencies(const IResource& object, Array<PendingCookingEntry>& outCookingQueue)
+void CommandCook::queueDependencies(const IResource& object, Array<CookQueueEntry>& outCookingQueue)
 {
     HashSet<ResourcePath> referencedResources;
 
@@ -362,7 +499,7 @@ void CommandCook::queueDependencies(const IResource& object, Array<PendingCookin
     }
 }
 
-void CommandCook::queueDependencies(StringView cookedFilePath, Array<PendingCookingEntry>& outCookingQueue)
+void CommandCook::queueDependencies(StringView cookedFilePath, Array<CookQueueEntry>& outCookingQueue)
 {
     if (auto fileReader = OpenForAsyncReading(cookedFilePath))
     {
@@ -381,15 +518,15 @@ void CommandCook::queueDependencies(StringView cookedFilePath, Array<PendingCook
     }
 }
 
-bool CommandCook::cookFile(const ResourcePath& key, SpecificClassType<IResource> cookedClass, StringBuf& outPath, Array<PendingCookingEntry>& outCookingQueue)
+bool CommandCook::cookFile(const ResourcePath& key, SpecificClassType<IResource> cookedClass, StringBuf& outPath, Array<CookQueueEntry>& outCookingQueue)
 {
     // do not cook files more than once, also promote the resource key to it's true class, ie ITexture:lena.png -> StaticTexture:lena.png
     if (!m_allCookedFiles.insert(key))
         return true;
 
     // print header
-    TRACE_INFO("Cooking file {}: {}", m_cookFileIndex, key);
-    m_cookFileIndex += 1;
+    const auto cookFileIndex = m_cookFileIndex++;
+    TRACE_INFO("Cooking file {}: {}", cookFileIndex, key);
     // TODO: break on file
 
     // capture all log output, we are only interested in success/failure
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "cookQueue.h"
+
 BEGIN_BOOMER_NAMESPACE()
 
 //--
@@ -30,14 +32,27 @@ private:
 
     //--
 
-    struct PendingCookingEntry
+    /// set of files shared by all cooking jobs
+    struct ConcurrentFileSet
     {
-        ResourcePath key;
-        ResourcePtr alreadyLoadedResource;
+        static const uint32_t NUM_SHARDS = 16;
+
+        struct Shard
+        {
+            SpinLock lock;
+            HashSet<ResourcePath> files;
+        };
+
+        Shard shards[NUM_SHARDS];
+
+        bool insert(const ResourcePath& key); // true if file was not yet in the set
+        uint32_t size() const;
     };
 
     bool processSeedFiles();
-    void processSingleSeedFile(const ResourcePath& key);
+    void processCookingJobs();
+    bool processSingleFile(const CookQueueEntry& entry, CookedFileRecord& outRecord, Array<CookQueueEntry>& outReferencedFiles);
+    void printCookingTimings() const;
 
     bool assembleCookedOutputPath(const ResourcePath& key, SpecificClassType<IResource> cookedClass, StringBuf& outPath) const;
 
@@ -45,20 +60,26 @@ private:
 
     bool checkDependenciesUpToDate(const ResourceMetadata& deps) const;
 
-    bool cookFile(const ResourcePath& key, SpecificClassType<IResource> cookedClass, StringBuf& outPath, Array<PendingCookingEntry>& outCookingQueue);
-    void queueDependencies(const IResource& object, Array<PendingCookingEntry>& outCookingQueue);
-    void queueDependencies(StringView cookedFile, Array<PendingCookingEntry>& outCookingQueue);
+    bool packCookedFiles(StringView archivePath, CompressionType compression) const;
+
+    bool cookFile(const ResourcePath& key, SpecificClassType<IResource> cookedClass, StringBuf& outPath, Array<CookQueueEntry>& outCookingQueue);
+    void queueDependencies(const IResource& object, Array<CookQueueEntry>& outCookingQueue);
+    void queueDependencies(StringView cookedFile, Array<CookQueueEntry>& outCookingQueue);
+
+    ConcurrentFileSet m_allCollectedFiles;
+    ConcurrentFileSet m_allCookedFiles;
+    ConcurrentFileSet m_allSeenFile;
 
-    HashSet<ResourcePath> m_allCollectedFiles;
-    HashSet<ResourcePath> m_allCookedFiles;
-    HashSet<ResourcePath> m_allSeenFile;
+    // shared cooking queue, jobs take files from it and put the referenced files back
+    CookQueue m_cookingQueue;
+    uint32_t m_maxConcurrentJobs = 1;
 
-    uint32_t m_cookFileIndex = 0;
-    uint32_t m_numTotalVisited = 0;
-    uint32_t m_numTotalUpToDate = 0;
-    uint32_t m_numTotalCopied = 0;
-    uint32_t m_numTotalCooked = 0;
-    uint32_t m_numTotalFailed = 0;
+    std::atomic<uint32_t> m_cookFileIndex = 0;
+    std::atomic<uint32_t> m_numTotalVisited = 0;
+    std::atomic<uint32_t> m_numTotalUpToDate = 0;
+    std::atomic<uint32_t> m_numTotalCopied = 0;
+    std::atomic<uint32_t> m_numTotalCooked = 0;
+    std::atomic<uint32_t> m_numTotalFailed = 0;
 
     bool m_captureLogs = true;
     bool m_discardCookedLogs = true;
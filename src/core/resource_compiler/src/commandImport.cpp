@@ -18,6 +18,7 @@
 #include "importInterface.h"
 
 #include "core/app/include/command.h"
+#include "core/fibers/include/fiberSystem.h"
 #include "core/app/include/commandline.h"
 #include "core/resource/include/loadingService.h"
 #include "core/resource/include/loader.h"
@@ -218,11 +219,9 @@ bool CommandImport::run(IProgressTracker* progress, const app::CommandLine& comm
         // add work to queue
         if (AddWorkToQueue(commandline, queue))
         {
-            // process all the jobs
-            while (queue.processNextJob(progress))
-            {
-                // placeholder for optional work we may want to do BETWEEN JOBS
-            }
+            // process all the jobs, independent assets are imported in parallel
+            const auto maxConcurrentJobs = std::clamp<int>(commandline.singleValueInt("importConcurrency", WorkerThreadCount()), 1, 256);
+            queue.processAllJobs(progress, maxConcurrentJobs);
         }
         else
         {
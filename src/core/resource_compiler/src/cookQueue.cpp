@@ -0,0 +1,155 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: cook #]
+***/
+
+#include "build.h"
+#include "cookQueue.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+CookQueue::CookQueue()
+{}
+
+CookQueue::~CookQueue()
+{
+    DEBUG_CHECK_EX(m_numFilesInFlight == 0, "Files still being cooked");
+    DEBUG_CHECK_EX(m_fileFinishedFence.empty(), "Cooking jobs still waiting");
+}
+
+void CookQueue::push(const ResourcePath& key)
+{
+    auto lock = CreateLock(m_lock);
+
+    auto& entry = m_entries.emplaceBack();
+    entry.key = key;
+}
+
+bool CookQueue::pop(CookQueueEntry& outEntry)
+{
+    for (;;)
+    {
+        FiberSemaphore fenceToWait;
+
+        {
+            auto lock = CreateLock(m_lock);
+
+            // nothing more will come when nobody is cooking
+            if (m_canceled || (m_entries.empty() && m_numFilesInFlight == 0))
+                return false;
+
+            // take the last one so the files referenced by the file we just cooked are processed first
+            if (!m_entries.empty())
+            {
+                outEntry = std::move(m_entries.back());
+                m_entries.popBack();
+                m_numFilesInFlight += 1;
+                return true;
+            }
+
+            // other jobs may still find new files to cook, sleep until one of them finishes
+            if (m_fileFinishedFence.empty())
+                m_fileFinishedFence = CreateFence("CookFileFinished", 1);
+            fenceToWait = m_fileFinishedFence;
+        }
+
+        WaitForFence(fenceToWait);
+    }
+}
+
+void CookQueue::finish(const CookedFileRecord* record, Array<CookQueueEntry>& referencedFiles)
+{
+    FiberSemaphore fenceToSignal;
+
+    {
+        auto lock = CreateLock(m_lock);
+        DEBUG_CHECK_RETURN_EX(m_numFilesInFlight > 0, "No files being cooked");
+
+        // store the record and share the referenced files with other jobs, they can't start before we are done so the path time is known here
+        if (record)
+        {
+            const auto recordIndex = (int)m_records.size();
+
+            auto& storedRecord = m_records.emplaceBack(*record);
+            storedRecord.pathTime = storedRecord.checkTime + storedRecord.cookTime;
+            if (storedRecord.parent >= 0)
+                storedRecord.pathTime += m_records[storedRecord.parent].pathTime;
+
+            for (auto& referencedFile : referencedFiles)
+            {
+                referencedFile.parent = recordIndex;
+                m_entries.pushBack(std::move(referencedFile));
+            }
+        }
+
+        m_numFilesInFlight -= 1;
+
+        fenceToSignal = m_fileFinishedFence;
+        m_fileFinishedFence = FiberSemaphore();
+    }
+
+    if (!fenceToSignal.empty())
+        SignalFence(fenceToSignal);
+}
+
+void CookQueue::cancel()
+{
+    FiberSemaphore fenceToSignal;
+
+    {
+        auto lock = CreateLock(m_lock);
+        m_canceled = true;
+
+        fenceToSignal = m_fileFinishedFence;
+        m_fileFinishedFence = FiberSemaphore();
+    }
+
+    if (!fenceToSignal.empty())
+        SignalFence(fenceToSignal);
+}
+
+//--
+
+void CookQueue::collectSlowestFiles(uint32_t maxCount, Array<const CookedFileRecord*>& outRecords) const
+{
+    Array<const CookedFileRecord*> sortedRecords;
+    sortedRecords.reserve(m_records.size());
+    for (const auto& record : m_records)
+        sortedRecords.pushBack(&record);
+
+    std::sort(sortedRecords.begin(), sortedRecords.end(), [](const CookedFileRecord* a, const CookedFileRecord* b)
+        {
+            return (a->checkTime + a->cookTime) > (b->checkTime + b->cookTime);
+        });
+
+    const auto count = std::min<uint32_t>(maxCount, sortedRecords.size());
+    for (uint32_t i = 0; i < count; ++i)
+        outRecords.pushBack(sortedRecords[i]);
+}
+
+void CookQueue::collectCriticalPath(Array<const CookedFileRecord*>& outRecords) const
+{
+    if (m_records.empty())
+        return;
+
+    int lastRecord = 0;
+    for (uint32_t i = 1; i < m_records.size(); ++i)
+        if (m_records[i].pathTime > m_records[lastRecord].pathTime)
+            lastRecord = i;
+
+    InplaceArray<const CookedFileRecord*, 32> path;
+    for (int index = lastRecord; index >= 0; index = m_records[index].parent)
+        path.pushBack(&m_records[index]);
+
+    for (int i = path.lastValidIndex(); i >= 0; --i)
+        outRecords.pushBack(path[i]);
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
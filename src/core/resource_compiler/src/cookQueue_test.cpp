@@ -0,0 +1,212 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+
+#include "cookQueue.h"
+
+DECLARE_TEST_FILE(CookQueue);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    // run the cooking jobs the same way the cook command does
+    static void RunCookingJobs(CookQueue& queue, uint32_t numFibers, const std::function<bool(const CookQueueEntry&, CookedFileRecord&, Array<CookQueueEntry>&)>& func)
+    {
+        auto jobsDone = CreateFence("TestCookingJobs", numFibers);
+        RunChildFiber("TestCookingJob").invocations(numFibers) << [&queue, &func, jobsDone](FIBER_FUNC)
+        {
+            CookQueueEntry entry;
+            while (queue.pop(entry))
+            {
+                CookedFileRecord record;
+                record.key = entry.key;
+                record.parent = entry.parent;
+
+                Array<CookQueueEntry> referencedFiles;
+                const auto processed = func(entry, record, referencedFiles);
+                queue.finish(processed ? &record : nullptr, referencedFiles);
+            }
+
+            SignalFence(jobsDone);
+        };
+
+        WaitForFence(jobsDone);
+    }
+
+    static void AddReference(Array<CookQueueEntry>& outReferencedFiles, StringView path)
+    {
+        auto& entry = outReferencedFiles.emplaceBack();
+        entry.key = ResourcePath(path);
+    }
+
+    // referenced files are named after the file that references them: seed0.xfile -> seed0_a.xfile -> seed0_a_b.xfile
+    static uint32_t ReferenceDepth(const ResourcePath& key)
+    {
+        uint32_t ret = 0;
+        for (const auto ch : key.view().fileStem())
+            if (ch == '_')
+                ret += 1;
+        return ret;
+    }
+
+} // helper
+
+TEST(CookQueue, EmptyQueueHasNoWork)
+{
+    CookQueue queue;
+
+    CookQueueEntry entry;
+    EXPECT_FALSE(queue.pop(entry));
+    EXPECT_TRUE(queue.records().empty());
+}
+
+TEST(CookQueue, ReferencedFilesAreProcessedByAllJobs)
+{
+    static const uint32_t NUM_SEEDS = 8;
+    static const uint32_t DEPTH = 5; // each file references two more files until this depth
+
+    CookQueue queue;
+    for (uint32_t i = 0; i < NUM_SEEDS; ++i)
+        queue.push(ResourcePath(TempString("/test/seed{}.xfile", i)));
+
+    // the seeds run out right away so most of the jobs have to wait for the files referenced by the running ones
+    std::atomic<uint32_t> numProcessed = 0;
+    helper::RunCookingJobs(queue, 16, [&numProcessed](const CookQueueEntry& entry, CookedFileRecord& record, Array<CookQueueEntry>& outReferencedFiles)
+        {
+            numProcessed += 1;
+
+            if (helper::ReferenceDepth(entry.key) < DEPTH)
+            {
+                helper::AddReference(outReferencedFiles, TempString("{}_a.xfile", entry.key.view().beforeLast(".")));
+                helper::AddReference(outReferencedFiles, TempString("{}_b.xfile", entry.key.view().beforeLast(".")));
+            }
+
+            record.cookTime = 0.001;
+            return true;
+        });
+
+    const auto expectedCount = NUM_SEEDS * ((2U << DEPTH) - 1);
+    EXPECT_EQ(expectedCount, numProcessed.load());
+    EXPECT_EQ(expectedCount, queue.records().size());
+    EXPECT_FALSE(queue.canceled());
+
+    // every record knows the file that referenced it
+    for (const auto& record : queue.records())
+    {
+        if (helper::ReferenceDepth(record.key) == 0)
+        {
+            EXPECT_EQ(-1, record.parent);
+        }
+        else
+        {
+            ASSERT_GE(record.parent, 0);
+            EXPECT_TRUE(record.key.view().beginsWith(queue.records()[record.parent].key.view().beforeLast(".")));
+        }
+    }
+}
+
+TEST(CookQueue, SkippedFilesHaveNoRecords)
+{
+    CookQueue queue;
+    queue.push(ResourcePath("/test/a.xfile"));
+    queue.push(ResourcePath("/test/b.xfile"));
+
+    helper::RunCookingJobs(queue, 4, [](const CookQueueEntry& entry, CookedFileRecord& record, Array<CookQueueEntry>& outReferencedFiles)
+        {
+            return entry.key.view().fileStem() == "a";
+        });
+
+    ASSERT_EQ(1, queue.records().size());
+    EXPECT_EQ(ResourcePath("/test/a.xfile"), queue.records()[0].key);
+}
+
+TEST(CookQueue, CancelStopsAllJobs)
+{
+    CookQueue queue;
+    queue.push(ResourcePath("/test/seed.xfile"));
+
+    // every file references new files, cooking would never end without the cancel
+    std::atomic<uint32_t> numProcessed = 0;
+    helper::RunCookingJobs(queue, 8, [&queue, &numProcessed](const CookQueueEntry& entry, CookedFileRecord& record, Array<CookQueueEntry>& outReferencedFiles)
+        {
+            const auto index = ++numProcessed;
+            helper::AddReference(outReferencedFiles, TempString("/test/file{}_a.xfile", index));
+            helper::AddReference(outReferencedFiles, TempString("/test/file{}_b.xfile", index));
+
+            if (index == 100)
+                queue.cancel();
+
+            return true;
+        });
+
+    EXPECT_TRUE(queue.canceled());
+    EXPECT_GE(numProcessed.load(), 100);
+}
+
+TEST(CookQueue, CriticalPathFollowsLongestChain)
+{
+    CookQueue queue;
+    queue.push(ResourcePath("/test/root.xfile"));
+
+    // root -> fast -> fastchild
+    // root -> slow -> slowchild
+    // "fast" is the slowest single file but the chain through "slow" takes longer
+    helper::RunCookingJobs(queue, 1, [](const CookQueueEntry& entry, CookedFileRecord& record, Array<CookQueueEntry>& outReferencedFiles)
+        {
+            const auto name = entry.key.view().fileStem();
+            if (name == "root")
+            {
+                helper::AddReference(outReferencedFiles, "/test/fast.xfile");
+                helper::AddReference(outReferencedFiles, "/test/slow.xfile");
+                record.cookTime = 1.0;
+            }
+            else if (name == "fast")
+            {
+                helper::AddReference(outReferencedFiles, "/test/fastchild.xfile");
+                record.cookTime = 5.0;
+            }
+            else if (name == "slow")
+            {
+                helper::AddReference(outReferencedFiles, "/test/slowchild.xfile");
+                record.checkTime = 1.0;
+                record.cookTime = 3.0;
+            }
+            else if (name == "fastchild")
+            {
+                record.cookTime = 0.5;
+            }
+            else if (name == "slowchild")
+            {
+                record.cookTime = 4.0;
+            }
+
+            return true;
+        });
+
+    ASSERT_EQ(5, queue.records().size());
+
+    Array<const CookedFileRecord*> path;
+    queue.collectCriticalPath(path);
+    ASSERT_EQ(3, path.size());
+    EXPECT_EQ(ResourcePath("/test/root.xfile"), path[0]->key);
+    EXPECT_EQ(ResourcePath("/test/slow.xfile"), path[1]->key);
+    EXPECT_EQ(ResourcePath("/test/slowchild.xfile"), path[2]->key);
+    EXPECT_DOUBLE_EQ(9.0, path[2]->pathTime);
+
+    Array<const CookedFileRecord*> slowest;
+    queue.collectSlowestFiles(2, slowest);
+    ASSERT_EQ(2, slowest.size());
+    EXPECT_EQ(ResourcePath("/test/fast.xfile"), slowest[0]->key);
+    EXPECT_TRUE(slowest[1]->key == ResourcePath("/test/slow.xfile") || slowest[1]->key == ResourcePath("/test/slowchild.xfile"));
+}
+
+END_BOOMER_NAMESPACE()
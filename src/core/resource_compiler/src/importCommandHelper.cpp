@@ -18,6 +18,7 @@
 #include "importInterface.h"
 
 #include "core/app/include/command.h"
+#include "core/fibers/include/fiberSystem.h"
 #include "core/app/include/commandline.h"
 #include "core/resource/include/loadingService.h"
 #include "core/resource/include/loader.h"
@@ -142,11 +143,8 @@ bool ProcessImport(const ImportList* files, IProgressTracker* mainProgress, IImp
         // add work to queue
         if (AddWorkToQueue(files, queue, force))
         {
-            // process all the jobs
-            while (queue.processNextJob(mainProgress))
-            {
-                // placeholder for optional work we may want to do BETWEEN JOBS
-            }
+            // process all the jobs, independent assets are imported in parallel
+            queue.processAllJobs(mainProgress, std::max<uint32_t>(1, WorkerThreadCount()));
         }
         else
         {
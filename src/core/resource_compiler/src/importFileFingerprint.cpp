@@ -12,6 +12,8 @@
 #include "core/object/include/streamOpcodeWriter.h"
 #include "core/io/include/fileHandle.h"
 #include "core/io/include/asyncFileHandle.h"
+#include "core/containers/include/contentHash.h"
+#include "core/containers/include/inplaceArray.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
@@ -25,7 +27,13 @@ RTTI_END_TYPE();
 
 //--
 
-typedef CRC32 FingerPrintCalculator;
+// fingerprint is computed from hashes of fixed size chunks of the file merged in order, chunks are hashed in parallel
+// NOTE: changing the chunk size changes all fingerprints
+static const uint64_t FINGERPRINT_CHUNK_SIZE = 1ULL << 20;
+
+// type byte in the serialized data
+static const uint8_t FINGERPRINT_TYPE_CRC32 = 0; // legacy, never matches the current fingerprints
+static const uint8_t FINGERPRINT_TYPE_XXH3_CHUNKED = 1;
 
 //--
 
@@ -33,7 +41,7 @@ void ImportFileFingerprint::print(IFormatStream& f) const
 {
     if (m_value != 0)
     {
-        f.appendf("CRC32: {}", Hex((uint32_t)m_value));
+        f.appendf("XXH3: {}", Hex(m_value));
     }
     else
     {
@@ -43,7 +51,7 @@ void ImportFileFingerprint::print(IFormatStream& f) const
 
 void ImportFileFingerprint::writeBinary(stream::OpcodeWriter& stream) const
 {
-    stream.writeTypedData<uint8_t>(0);
+    stream.writeTypedData<uint8_t>(FINGERPRINT_TYPE_XXH3_CHUNKED);
     stream.writeTypedData(m_value);
 }
 
@@ -52,22 +60,20 @@ void ImportFileFingerprint::readBinary(stream::OpcodeReader& stream)
     uint8_t type = 0;
     stream.readTypedData(type);
 
-    if (type == 0)
+    if (type == FINGERPRINT_TYPE_CRC32 || type == FINGERPRINT_TYPE_XXH3_CHUNKED)
         stream.readTypedData(m_value);
 }
 
 uint32_t ImportFileFingerprint::CalcHash(const ImportFileFingerprint& entry)
 {
-    return entry.m_value;
+    return (uint32_t)(entry.m_value ^ (entry.m_value >> 32));
 }
 
 //--
 
-static const uint64_t MIN_BATCH_SIZE = 4096;
-
-static const ConfigProperty<uint64_t> cvFingerprintMemoryBatchSize("Assets.Fingerprint", "MemoryBatchSize", 1U << 20);
-static const ConfigProperty<uint64_t> cvFingerprintSyncFileBatchSize("Assets.Fingerprint", "SyncFileBatchSize", 64 << 10);
-static const ConfigProperty<uint64_t> cvFingerprintAsyncFileBatchSize("Assets.Fingerprint", "AsyncFileBatchSize", 1U << 20);
+static const ConfigProperty<uint64_t> cvFingerprintMemoryBatchSize("Assets.Fingerprint", "MemoryBatchSize", 16U << 20);
+static const ConfigProperty<uint64_t> cvFingerprintSyncFileBatchSize("Assets.Fingerprint", "SyncFileBatchSize", 4U << 20);
+static const ConfigProperty<uint64_t> cvFingerprintAsyncFileBatchSize("Assets.Fingerprint", "AsyncFileBatchSize", 16U << 20);
 static const ConfigProperty<double> cvFingerprintFiberAutoYieldInterval("Assets.Fingerprint", "FiberAutoYieldInterval", 20);
 
 //--
@@ -99,6 +105,53 @@ public:
     }
 };
 
+//--
+
+// batches must contain whole chunks
+static uint64_t FingerprintBatchSize(uint64_t configuredSize)
+{
+    const auto numChunks = std::max<uint64_t>(1, (configuredSize + FINGERPRINT_CHUNK_SIZE - 1) / FINGERPRINT_CHUNK_SIZE);
+    return numChunks * FINGERPRINT_CHUNK_SIZE;
+}
+
+struct FingerPrintCalculator
+{
+public:
+    FingerPrintCalculator(uint64_t totalSize = 0)
+        : m_hash(totalSize)
+    {}
+
+    // hash a batch of data, all but the last batch must be made of whole chunks
+    void append(const void* data, uint64_t size)
+    {
+        const auto* ptr = (const uint8_t*)data;
+        const auto numChunks = (uint32_t)((size + FINGERPRINT_CHUNK_SIZE - 1) / FINGERPRINT_CHUNK_SIZE);
+
+        InplaceArray<uint64_t, 64> chunkHashes;
+        chunkHashes.resize(numChunks);
+
+        RunFiberLoop("FileFingerprintChunk", numChunks, -1, [ptr, size, &chunkHashes](uint32_t index)
+            {
+                const auto offset = index * FINGERPRINT_CHUNK_SIZE;
+                chunkHashes[index] = ContentHash64(ptr + offset, std::min<uint64_t>(FINGERPRINT_CHUNK_SIZE, size - offset));
+            });
+
+        // merge in order
+        for (const auto chunkHash : chunkHashes)
+            m_hash = ContentHashCombine(m_hash, chunkHash);
+    }
+
+    ImportFileFingerprint fingerprint() const
+    {
+        return ImportFileFingerprint(m_hash ? m_hash : 1); // zero is reserved for "no fingerprint"
+    }
+
+private:
+    uint64_t m_hash = 0;
+};
+
+//--
+
 /// calculate file content fingerprint, returns false if canceled or error occurs
 FingerpintCalculationStatus CalculateMemoryFingerprint(const void* data, uint64_t size, IProgressTracker* progress, ImportFileFingerprint& outFingerpint)
 {
@@ -107,10 +160,10 @@ FingerpintCalculationStatus CalculateMemoryFingerprint(const void* data, uint64_
     uint64_t originalSize = size;
     auto* readPtr = (const uint8_t*)data;
 
-    const auto batchSize = std::max<uint64_t>(MIN_BATCH_SIZE, cvFingerprintMemoryBatchSize.get());
+    const auto batchSize = FingerprintBatchSize(cvFingerprintMemoryBatchSize.get());
 
     AutoYielder yielder;
-    FingerPrintCalculator calc;
+    FingerPrintCalculator calc(originalSize);
     while (size)
     {
         // update progress
@@ -124,7 +177,7 @@ FingerpintCalculationStatus CalculateMemoryFingerprint(const void* data, uint64_
         // this is a very log job, release CPU resources from time to time
         yielder.conditionalYield();
 
-        // calculate CRC
+        // calculate hashes of the chunks
         const auto readSize = std::min(batchSize, size);
         calc.append(readPtr, readSize);
                 
@@ -133,7 +186,7 @@ FingerpintCalculationStatus CalculateMemoryFingerprint(const void* data, uint64_
         readPtr += readSize;
     }
 
-    outFingerpint = ImportFileFingerprint(calc.crc());
+    outFingerpint = calc.fingerprint();
     return FingerpintCalculationStatus::OK;
 }
 
@@ -147,13 +200,13 @@ FingerpintCalculationStatus CalculateFileFingerprint(IReadFileHandle* file, IPro
     if (!file->pos(0))
         return FingerpintCalculationStatus::ErrorInvalidRead;
             
-    const auto batchSize = std::max<uint64_t>(MIN_BATCH_SIZE, cvFingerprintSyncFileBatchSize.get());
+    const auto batchSize = FingerprintBatchSize(cvFingerprintSyncFileBatchSize.get());
 
     auto batchBuffer = Buffer::CreateInSystemMemory(POOL_IO, batchSize);
     if (!batchBuffer)
         return FingerpintCalculationStatus::ErrorOutOfMemory;
 
-    FingerPrintCalculator calc;
+    FingerPrintCalculator calc(size);
     uint64_t pos = 0;
     AutoYielder yielder;
     while (pos < size)
@@ -170,12 +223,12 @@ FingerpintCalculationStatus CalculateFileFingerprint(IReadFileHandle* file, IPro
         yielder.conditionalYield();
 
         // load file content
-        const auto readSize = std::min(batchSize, pos - size);
+        const auto readSize = std::min(batchSize, size - pos);
         const auto actualReadSize = file->readSync(batchBuffer.data(), readSize);
         if (actualReadSize != readSize)
             return FingerpintCalculationStatus::ErrorInvalidRead;
 
-        // calculate CRC
+        // calculate hashes of the chunks
         calc.append(batchBuffer.data(), actualReadSize);
 
         // advance
@@ -184,7 +237,7 @@ FingerpintCalculationStatus CalculateFileFingerprint(IReadFileHandle* file, IPro
 
     ASSERT(pos == size);
 
-    outFingerpint = ImportFileFingerprint(calc.crc());
+    outFingerpint = calc.fingerprint();
     return FingerpintCalculationStatus::OK;
 }
 
@@ -206,9 +259,10 @@ CAN_YIELD extern CORE_RESOURCE_COMPILER_API FingerpintCalculationStatus Calculat
 
     state.pos = 0;
     state.size = file->size();
+    state.calc = FingerPrintCalculator(state.size);
     state.status = FingerpintCalculationStatus::OK; // changed only if we fail for some reason
 
-    state.batchSize = std::max<uint64_t>(MIN_BATCH_SIZE, cvFingerprintAsyncFileBatchSize.get());
+    state.batchSize = FingerprintBatchSize(cvFingerprintAsyncFileBatchSize.get());
     state.readBuffer = Buffer::CreateInSystemMemory(POOL_IO, state.batchSize);
     state.calcBuffer = Buffer::CreateInSystemMemory(POOL_IO, state.batchSize);
 
@@ -272,7 +326,7 @@ CAN_YIELD extern CORE_RESOURCE_COMPILER_API FingerpintCalculationStatus Calculat
     WaitForFence(state.doneCounter);
                 
     if (state.status == FingerpintCalculationStatus::OK)
-        outFingerpint = ImportFileFingerprint(state.calc.crc());
+        outFingerpint = state.calc.fingerprint();
 
     return state.status;
 }
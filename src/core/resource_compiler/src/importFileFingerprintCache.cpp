@@ -9,75 +9,57 @@
 #include "build.h"
 #include "importFileFingerprint.h"
 #include "importFileFingerprintCache.h"
-#include "core/resource/include/tags.h"
+#include "core/io/include/io.h"
+#include "core/io/include/fileHandle.h"
+#include "core/containers/include/contentHash.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
 //--
 
-RTTI_BEGIN_TYPE_CLASS(ImportFileFingerprintTimestampEntry);
-    RTTI_PROPERTY(timestamp);
-    RTTI_PROPERTY(fingerprint);
-RTTI_END_TYPE();
+static const uint32_t FINGERPRINT_DB_MAGIC = 0x42445046; // 'FPDB'
+static const uint32_t FINGERPRINT_DB_VERSION = 1;
 
-RTTI_BEGIN_TYPE_CLASS(ImportFileFingerprintCacheEntry);
-    RTTI_PROPERTY(absolutePathUTF8);
-    RTTI_PROPERTY(timestampEntries);
-RTTI_END_TYPE();
+// rewrite the file if it contains more outdated records than valid ones
+static const uint32_t FINGERPRINT_DB_MIN_OUTDATED_RECORDS_TO_COMPACT = 1024;
 
 //--
 
-RTTI_BEGIN_TYPE_CLASS(ImportFingerprintCache);
-    RTTI_METADATA(ResourceExtensionMetadata).extension("v4fingerprints");
-    RTTI_METADATA(ResourceDescriptionMetadata).description("Fingerprint Cache");
-    RTTI_METADATA(ResourceTagColorMetadata).color(0x70, 0x70, 0x70);
-    RTTI_PROPERTY(m_entries);
-RTTI_END_TYPE();
-
 ImportFingerprintCache::ImportFingerprintCache()
 {}
 
 ImportFingerprintCache::~ImportFingerprintCache()
 {}
 
-void ImportFingerprintCache::clear()
+uint64_t ImportFingerprintCache::PathHash(StringView path)
 {
-    m_entries.clear();
-    m_entriesMap.clear();
-    markModified();
+    return ContentHash64(path.data(), path.length());
 }
 
-void ImportFingerprintCache::conformPath(StringView path, StringBuf& outPath) const
+uint64_t ImportFingerprintCache::RecordCheck(const Record& record)
 {
-    outPath = StringBuf(path);
-    //outPath = outPath.toLower();
-    //outPath.replaceChar('\\', '/');
+    return ContentHash64(&record, offsetof(Record, check)) ^ FINGERPRINT_DB_MAGIC;
 }
 
-bool ImportFingerprintCache::findEntry(StringView path, TimeStamp timestamp, ImportFileFingerprint& outFingerprint)
+void ImportFingerprintCache::clear()
 {
-    DEBUG_CHECK_EX(path, "Invalid path");
-    DEBUG_CHECK_EX(!timestamp.empty(), "Invalid timestamp");
-
-    if (!path || timestamp.empty())
-        return false;
+    m_entries.clear();
+    m_pendingEntries.clear();
+    m_rewriteFile = true;
+}
 
-    StringBuf conformedPath;
-    conformPath(path, conformedPath);
+bool ImportFingerprintCache::findEntry(StringView path, const FileIdentity& identity, ImportFileFingerprint& outFingerprint) const
+{
+    DEBUG_CHECK_EX(path, "Invalid path");
 
-    uint32_t index = 0;
-    if (!m_entriesMap.find(conformedPath, index))
+    if (!path)
         return false;
 
-    // TODO: sorted array
-
-    const auto& entry = m_entries[index];
-    const auto timestampValue = timestamp.value();
-    for (const auto& timeEntry : entry.timestampEntries)
+    if (const auto* record = m_entries.find(PathHash(path)))
     {
-        if (timeEntry.timestamp == timestampValue)
+        if (record->fileId == identity.fileId && record->size == identity.size && record->timestamp == identity.timestamp)
         {
-            outFingerprint = timeEntry.fingerprint;
+            outFingerprint = ImportFileFingerprint(record->fingerprint);
             return true;
         }
     }
@@ -85,65 +67,147 @@ bool ImportFingerprintCache::findEntry(StringView path, TimeStamp timestamp, Imp
     return false;
 }
 
-void ImportFingerprintCache::storeEntry(StringView path, TimeStamp timestamp, const ImportFileFingerprint& fingerprint)
+void ImportFingerprintCache::storeEntry(StringView path, const FileIdentity& identity, const ImportFileFingerprint& fingerprint)
 {
     DEBUG_CHECK_EX(path, "Invalid path");
-    DEBUG_CHECK_EX(!timestamp.empty(), "Invalid timestamp");
+    DEBUG_CHECK_EX(fingerprint, "Invalid fingerprint");
 
-    if (!path || timestamp.empty())
+    if (!path || !fingerprint)
         return;
 
-    StringBuf conformedPath;
-    conformPath(path, conformedPath);
+    Record record;
+    record.pathHash = PathHash(path);
+    record.fileId = identity.fileId;
+    record.size = identity.size;
+    record.timestamp = identity.timestamp;
+    record.fingerprint = fingerprint.rawValue();
+    record.check = RecordCheck(record);
 
-    // find/create entry
-    uint32_t index = 0;
-    if (!m_entriesMap.find(conformedPath, index))
+    m_entries[record.pathHash] = record;
+    m_pendingEntries.pushBack(record);
+
+    TRACE_INFO("Fingerprint: Stored fingerprint for '{}' at {}: {}", path, TimeStamp(identity.timestamp), fingerprint);
+}
+
+//--
+
+bool ImportFingerprintCache::load(StringView absolutePath)
+{
+    m_entries.reset();
+    m_pendingEntries.reset();
+    m_numFileRecords = 0;
+    m_rewriteFile = true;
+
+    const auto data = OpenMemoryMappedForReading(absolutePath, FileMappingHint::Sequential);
+    if (!data)
+        return false;
+
+    if (data.size() < sizeof(Header))
     {
-        index = m_entries.size();
-        auto& entry = m_entries.emplaceBack();
-        entry.absolutePathUTF8 = conformedPath;
-        m_entriesMap[conformedPath] = index;
+        TRACE_WARNING("Fingerprint: Cache file '{}' is too small", absolutePath);
+        return false;
     }
 
-    // find/create time entry
-    auto& entry = m_entries[index];
-    const auto timestampValue = timestamp.value();
-    for (auto& timeEntry : entry.timestampEntries)
+    const auto* header = (const Header*)data.data();
+    if (header->magic != FINGERPRINT_DB_MAGIC || header->version != FINGERPRINT_DB_VERSION || header->recordSize != sizeof(Record))
     {
-        if (timeEntry.timestamp == timestampValue)
-        {
-            TRACE_INFO("Fingerprint: Stored fingerprint for '{}' at {}: {}", path, timestamp, fingerprint);
-            timeEntry.fingerprint = fingerprint;
-            markModified();
-            return;
-        }
+        TRACE_WARNING("Fingerprint: Cache file '{}' has incompatible format", absolutePath);
+        return false;
+    }
+
+    // later records override the earlier ones
+    const auto numRecords = (uint32_t)((data.size() - sizeof(Header)) / sizeof(Record));
+    const auto* records = (const Record*)(data.data() + sizeof(Header));
+    m_entries.reserve(numRecords);
+
+    uint32_t numInvalidRecords = 0;
+    for (uint32_t i = 0; i < numRecords; ++i)
+    {
+        const auto& record = records[i];
+        if (record.check == RecordCheck(record) && record.fingerprint != 0)
+            m_entries[record.pathHash] = record;
+        else
+            numInvalidRecords += 1;
     }
 
-    // add new entry
-    auto& timeEntry = entry.timestampEntries.emplaceBack();
-    timeEntry.fingerprint = fingerprint;
-    timeEntry.timestamp = timestampValue;
-    TRACE_INFO("Fingerprint: Stored NEW fingerprint for '{}' at {}: {}", path, timestamp, fingerprint);
+    // we can only append to a file that is not damaged, otherwise it's written again
+    const auto hasTrailingData = (sizeof(Header) + numRecords * sizeof(Record)) != data.size();
+    m_rewriteFile = hasTrailingData || (numInvalidRecords > 0);
+    m_numFileRecords = numRecords;
+
+    if (m_rewriteFile)
+        TRACE_WARNING("Fingerprint: Cache file '{}' is damaged ({} invalid record(s)), it will be rewritten", absolutePath, numInvalidRecords);
 
-    markModified();
+    TRACE_INFO("Fingerprint: Loaded cache with {} entrie(s) ({} record(s) in file)", m_entries.size(), numRecords);
+    return true;
 }
 
-void ImportFingerprintCache::rebuildMap()
+bool ImportFingerprintCache::writeAll(StringView absolutePath)
 {
-    m_entriesMap.reserve(m_entries.size());
+    auto file = OpenForWriting(absolutePath, FileWriteMode::StagedWrite);
+    if (!file)
+    {
+        TRACE_WARNING("Fingerprint: Unable to open '{}' for writing", absolutePath);
+        return false;
+    }
 
-    for (uint32_t i = 0; i < m_entries.size(); ++i)
+    Header header;
+    header.magic = FINGERPRINT_DB_MAGIC;
+    header.version = FINGERPRINT_DB_VERSION;
+    header.recordSize = sizeof(Record);
+
+    const auto& records = m_entries.values();
+    const auto recordsDataSize = records.dataSize();
+    if (file->writeSync(&header, sizeof(header)) != sizeof(header) || file->writeSync(records.data(), recordsDataSize) != recordsDataSize)
     {
-        TRACE_INFO("Fingerprint: Loaded entry '{}': {}", m_entries[i].absolutePathUTF8, i);
-        m_entriesMap[m_entries[i].absolutePathUTF8] = i;
+        TRACE_WARNING("Fingerprint: Failed to write '{}'", absolutePath);
+        file->discardContent();
+        return false;
     }
+
+    file.reset(); // move staged file into place
+
+    TRACE_INFO("Fingerprint: Written cache with {} entrie(s)", records.size());
+    m_numFileRecords = records.size();
+    m_pendingEntries.reset();
+    m_rewriteFile = false;
+    return true;
 }
 
-void ImportFingerprintCache::onPostLoad()
+bool ImportFingerprintCache::flush(StringView absolutePath)
 {
-    TBaseClass::onPostLoad();
-    rebuildMap();
+    // compact file if it contains mostly the outdated records
+    const auto numFileRecords = m_numFileRecords + m_pendingEntries.size();
+    if (numFileRecords > m_entries.size() + std::max<uint32_t>(m_entries.size(), FINGERPRINT_DB_MIN_OUTDATED_RECORDS_TO_COMPACT))
+        m_rewriteFile = true;
+
+    if (m_rewriteFile)
+        return writeAll(absolutePath);
+
+    if (m_pendingEntries.empty())
+        return true;
+
+    // append new records at the end, previous content is not touched
+    auto file = OpenForWriting(absolutePath, FileWriteMode::DirectAppend);
+    if (!file)
+    {
+        TRACE_WARNING("Fingerprint: Unable to open '{}' for appending", absolutePath);
+        return false;
+    }
+
+    const auto dataSize = m_pendingEntries.dataSize();
+    const auto writtenSize = file->writeSync(m_pendingEntries.data(), dataSize);
+    if (writtenSize != dataSize)
+    {
+        // we may have written part of the data, we can't append any more
+        TRACE_WARNING("Fingerprint: Failed to append to '{}'", absolutePath);
+        m_rewriteFile = true;
+        return false;
+    }
+
+    m_numFileRecords += m_pendingEntries.size();
+    m_pendingEntries.reset();
+    return true;
 }
 
 //--
@@ -12,49 +12,12 @@
 #include "importFileFingerprintCache.h"
 #include "core/io/include/asyncFileHandle.h"
 #include "core/io/include/io.h"
-#include "core/resource/include/fileLoader.h"
-#include "core/resource/include/fileSaver.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
 //--
 
-static RefPtr<ImportFingerprintCache> LoadCache(StringView path)
-{
-    if (auto file = OpenForAsyncReading(path))
-    {
-        FileLoadingContext context;
-                
-        if (LoadFile(file, context))
-        {
-            if (auto cache = context.root<ImportFingerprintCache>())
-            {
-                TRACE_INFO("Fingerprint: Loaded cache with {} entrie(s)", cache->size());
-                return cache;
-            }
-        }
-    }
-
-    TRACE_INFO("Fingerprint: Created new cache");
-    return RefNew<ImportFingerprintCache>();
-}
-
-static bool SaveCache(StringView path, const RefPtr<ImportFingerprintCache>& cache)
-{
-    if (auto file = OpenForWriting(path))
-    {
-        FileSavingContext context;
-        context.rootObject.pushBack(cache);
-
-        return SaveFile(file, context);
-    }
-
-    return false;
-}
-
-//--
-
-static const ConfigProperty<double> cvFingerprintCacheSaveInterval("Assets.Fingerprint", "CacheSaveInterval", 10);
+static const ConfigProperty<double> cvFingerprintCacheSaveInterval("Assets.Fingerprint", "CacheSaveInterval", 2);
 
 //--
 
@@ -70,39 +33,43 @@ ImportFileFingerprintService::~ImportFileFingerprintService()
 app::ServiceInitializationResult ImportFileFingerprintService::onInitializeService(const app::CommandLine& cmdLine)
 {
     // determine the fingerprint cache file
-    m_cacheFilePath = TempString("{}fingerprint.cache", SystemPath(PathCategory::UserConfigDir));
+    m_cacheFilePath = TempString("{}fingerprint.db", SystemPath(PathCategory::UserConfigDir));
     TRACE_INFO("Fingerprint: Cache located at '{}'", m_cacheFilePath);
 
-    // load/cache the cache
-    m_cache = LoadCache(m_cacheFilePath);
+    // load the cache, if it's missing or damaged we will start with an empty one
+    m_cache.create();
+    if (!m_cache->load(m_cacheFilePath))
+        TRACE_INFO("Fingerprint: Created new cache");
+
     m_nextCacheWriteCheck = NativeTimePoint::Now() + cvFingerprintCacheSaveInterval.get();
     return app::ServiceInitializationResult::Finished;
 }
 
 void ImportFileFingerprintService::onShutdownService()
 {
-    saveCacheIfDirty();
+    flushCache();
 }
 
 void ImportFileFingerprintService::onSyncUpdate()
 {
     if (m_nextCacheWriteCheck.reached())
     {
-        saveCacheIfDirty();
+        flushCache();
         m_nextCacheWriteCheck = NativeTimePoint::Now() + cvFingerprintCacheSaveInterval.get();
     }
 }
 
-void ImportFileFingerprintService::saveCacheIfDirty()
+void ImportFileFingerprintService::flushCache()
 {
     if (1 == m_hasNewCacheEntries.exchange(0))
     {
         auto lock = CreateLock(m_cacheLock);
 
-        // save cache to file
-        if (!SaveCache(m_cacheFilePath, m_cache))
+        // append new entries to the file, usually very small write
+        if (!m_cache->flush(m_cacheFilePath))
         {
             TRACE_WARNING("Fingerprint: Failed to save fingerprint cache");
+            m_hasNewCacheEntries = 1; // try again later
         }
     }
 }
@@ -111,15 +78,15 @@ void ImportFileFingerprintService::saveCacheIfDirty()
 
 CAN_YIELD FingerpintCalculationStatus ImportFileFingerprintService::calculateFingerprint(StringView absolutePath, bool background, IProgressTracker* progress, ImportFileFingerprint& outFingerprint)
 {
-    // first, check the file timestamp, maybe we have the data in cache
-    TimeStamp timestamp;
-    if (!FileTimeStamp(absolutePath, timestamp))
+    // first, check the file identity (ID, size, timestamp), maybe we have the data in cache
+    FileIdentity identity;
+    if (!FileIdentityInfo(absolutePath, identity))
         return FingerpintCalculationStatus::ErrorNoFile;
 
     // locate in cache
     {
         auto lock = CreateLock(m_cacheLock);
-        if (m_cache->findEntry(absolutePath, timestamp, outFingerprint))
+        if (m_cache->findEntry(absolutePath, identity, outFingerprint))
             return FingerpintCalculationStatus::OK;
     }
 
@@ -150,7 +117,7 @@ CAN_YIELD FingerpintCalculationStatus ImportFileFingerprintService::calculateFin
     // create a cache job entry
     auto validCacheJob = RefNew<CacheJob>();
     validCacheJob->path = StringBuf(absolutePath);
-    validCacheJob->timestamp = timestamp;
+    validCacheJob->identity = identity;
     validCacheJob->signal = CreateFence("ImportFileFingerprintServiceCalcJob");
     m_activeJobMap[validCacheJob->path] = validCacheJob;
 
@@ -171,7 +138,7 @@ CAN_YIELD FingerpintCalculationStatus ImportFileFingerprintService::calculateFin
     if (validCacheJob->status == FingerpintCalculationStatus::OK)
     {
         auto lock = CreateLock(m_cacheLock);
-        m_cache->storeEntry(absolutePath, validCacheJob->timestamp, validCacheJob->fingerprint);
+        m_cache->storeEntry(absolutePath, validCacheJob->identity, validCacheJob->fingerprint);
         m_hasNewCacheEntries.exchange(1);
     }
 
@@ -0,0 +1,361 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/io/include/io.h"
+#include "core/io/include/fileHandle.h"
+
+#include "importFileFingerprint.h"
+#include "importFileFingerprintCache.h"
+
+DECLARE_TEST_FILE(ImportFileFingerprint);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    static void FillRandom(Array<uint8_t>& data, uint64_t size, uint32_t seed)
+    {
+        srand(seed);
+        data.resize(size);
+        for (auto& val : data)
+            val = (uint8_t)rand();
+    }
+
+    static StringBuf TestPath(StringView name)
+    {
+        return TempString("{}fingerprintTest/{}", SystemPath(PathCategory::LocalTempDir), name);
+    }
+
+    static FileIdentity MakeIdentity(uint64_t id, uint64_t size, uint64_t timestamp)
+    {
+        FileIdentity ret;
+        ret.fileId = id;
+        ret.size = size;
+        ret.timestamp = timestamp;
+        return ret;
+    }
+
+} // helper
+
+TEST(ImportFileFingerprint, MemoryAndFileFingerprintsAreTheSame)
+{
+    Array<uint8_t> data;
+    helper::FillRandom(data, (5ULL << 20) + 12345, 0); // few chunks
+
+    const auto path = helper::TestPath("multiChunk.bin");
+    ASSERT_TRUE(CreatePath(path));
+    ASSERT_TRUE(SaveFileFromBuffer(path, data.data(), data.dataSize()));
+
+    ImportFileFingerprint memoryFingerprint;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateMemoryFingerprint(data.data(), data.dataSize(), nullptr, memoryFingerprint));
+    EXPECT_FALSE(memoryFingerprint.empty());
+
+    auto file = OpenForReading(path);
+    ASSERT_TRUE(file);
+
+    ImportFileFingerprint fileFingerprint;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateFileFingerprint(file, nullptr, fileFingerprint));
+    EXPECT_EQ(memoryFingerprint, fileFingerprint);
+}
+
+TEST(ImportFileFingerprint, ContentChangeIsDetected)
+{
+    Array<uint8_t> data;
+    helper::FillRandom(data, 3ULL << 20, 1);
+
+    ImportFileFingerprint original;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateMemoryFingerprint(data.data(), data.dataSize(), nullptr, original));
+
+    data[(2ULL << 20) + 7] ^= 0x10;
+
+    ImportFileFingerprint changed;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateMemoryFingerprint(data.data(), data.dataSize(), nullptr, changed));
+    EXPECT_NE(original, changed);
+
+    // truncated file
+    ImportFileFingerprint truncated;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateMemoryFingerprint(data.data(), data.dataSize() - 1, nullptr, truncated));
+    EXPECT_NE(changed, truncated);
+}
+
+TEST(ImportFileFingerprint, EmptyDataHasValidFingerprint)
+{
+    const uint8_t data[1] = { 0 };
+
+    ImportFileFingerprint fingerprint;
+    ASSERT_EQ(FingerpintCalculationStatus::OK, CalculateMemoryFingerprint(data, 0, nullptr, fingerprint));
+    EXPECT_FALSE(fingerprint.empty());
+}
+
+TEST(ImportFileFingerprint, CacheRoundTrip)
+{
+    const auto path = helper::TestPath("roundTrip.db");
+    ASSERT_TRUE(CreatePath(path));
+    DeleteFile(path);
+
+    {
+        ImportFingerprintCache cache;
+        EXPECT_FALSE(cache.load(path));
+
+        for (uint32_t i = 0; i < 100; ++i)
+            cache.storeEntry(TempString("/depot/file{}.png", i), helper::MakeIdentity(i, i * 10, 1000 + i), ImportFileFingerprint(500 + i));
+
+        EXPECT_EQ(100U, cache.numPendingEntries());
+        ASSERT_TRUE(cache.flush(path));
+        EXPECT_EQ(0U, cache.numPendingEntries());
+    }
+
+    {
+        ImportFingerprintCache cache;
+        ASSERT_TRUE(cache.load(path));
+        EXPECT_EQ(100U, cache.size());
+
+        ImportFileFingerprint fingerprint;
+        EXPECT_TRUE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(42, 420, 1042), fingerprint));
+        EXPECT_EQ(542U, fingerprint.rawValue());
+
+        // any change of the identity invalidates the entry
+        EXPECT_FALSE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(43, 420, 1042), fingerprint));
+        EXPECT_FALSE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(42, 421, 1042), fingerprint));
+        EXPECT_FALSE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(42, 420, 1043), fingerprint));
+        EXPECT_FALSE(cache.findEntry("/depot/file1000.png", helper::MakeIdentity(42, 420, 1042), fingerprint));
+
+        // update existing entry, it's appended
+        cache.storeEntry("/depot/file42.png", helper::MakeIdentity(42, 420, 2000), ImportFileFingerprint(777));
+        ASSERT_TRUE(cache.flush(path));
+    }
+
+    {
+        ImportFingerprintCache cache;
+        ASSERT_TRUE(cache.load(path));
+        EXPECT_EQ(100U, cache.size());
+
+        ImportFileFingerprint fingerprint;
+        EXPECT_FALSE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(42, 420, 1042), fingerprint));
+        EXPECT_TRUE(cache.findEntry("/depot/file42.png", helper::MakeIdentity(42, 420, 2000), fingerprint));
+        EXPECT_EQ(777U, fingerprint.rawValue());
+    }
+}
+
+TEST(ImportFileFingerprint, CachePartialRecordIsIgnored)
+{
+    const auto path = helper::TestPath("partial.db");
+    ASSERT_TRUE(CreatePath(path));
+    DeleteFile(path);
+
+    {
+        ImportFingerprintCache cache;
+        for (uint32_t i = 0; i < 10; ++i)
+            cache.storeEntry(TempString("/depot/file{}.png", i), helper::MakeIdentity(i, i, i), ImportFileFingerprint(1 + i));
+        ASSERT_TRUE(cache.flush(path));
+    }
+
+    // simulate write that was interrupted
+    {
+        auto file = OpenForWriting(path, FileWriteMode::DirectAppend);
+        ASSERT_TRUE(file);
+
+        const uint8_t garbage[20] = { 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20 };
+        ASSERT_EQ(sizeof(garbage), file->writeSync(garbage, sizeof(garbage)));
+    }
+
+    {
+        ImportFingerprintCache cache;
+        ASSERT_TRUE(cache.load(path));
+        EXPECT_EQ(10U, cache.size());
+
+        // file is rewritten without the garbage
+        cache.storeEntry("/depot/new.png", helper::MakeIdentity(100, 100, 100), ImportFileFingerprint(100));
+        ASSERT_TRUE(cache.flush(path));
+    }
+
+    {
+        ImportFingerprintCache cache;
+        ASSERT_TRUE(cache.load(path));
+        EXPECT_EQ(11U, cache.size());
+
+        ImportFileFingerprint fingerprint;
+        EXPECT_TRUE(cache.findEntry("/depot/new.png", helper::MakeIdentity(100, 100, 100), fingerprint));
+        EXPECT_TRUE(cache.findEntry("/depot/file5.png", helper::MakeIdentity(5, 5, 5), fingerprint));
+    }
+}
+
+//--
+
+namespace helper
+{
+    static const uint32_t SCAN_NUM_FILES = 1000; // small enough for every test run
+    static const uint32_t SCAN_NUM_FILES_PERF = 100000; // size of a real project depot
+    static const uint32_t SCAN_FILES_PER_DIR = 500;
+
+    static StringBuf ScanFilePath(uint32_t index)
+    {
+        return TempString("{}fingerprintScan/dir{}/file{}.bin", SystemPath(PathCategory::LocalTempDir), index / SCAN_FILES_PER_DIR, index);
+    }
+
+    static StringBuf ScanDirPath(uint32_t dirIndex)
+    {
+        return TempString("{}fingerprintScan/dir{}/", SystemPath(PathCategory::LocalTempDir), dirIndex);
+    }
+
+    // remove the scan depot and the cache so we don't leave junk in the temp dir
+    static void CleanupScanDepot(uint32_t numFiles, StringView cachePath)
+    {
+        for (uint32_t i = 0; i < numFiles; ++i)
+            DeleteFile(ScanFilePath(i));
+
+        for (uint32_t i = 0; i < numFiles; i += SCAN_FILES_PER_DIR)
+            DeleteDir(ScanDirPath(i / SCAN_FILES_PER_DIR));
+
+        DeleteDir(TempString("{}fingerprintScan/", SystemPath(PathCategory::LocalTempDir)));
+        DeleteFile(cachePath);
+    }
+
+    // depot of small files (few KB each)
+    static void PrepareScanDepot(uint32_t numFiles)
+    {
+        Array<uint8_t> data;
+        FillRandom(data, 16 << 10, 0);
+
+        for (uint32_t i = 0; i < numFiles; ++i)
+        {
+            const auto path = ScanFilePath(i);
+            if ((i % SCAN_FILES_PER_DIR) == 0)
+                CreatePath(path);
+
+            if (!FileExists(path))
+            {
+                const auto size = 1024 + ((i * 7919) % (data.size() - 1024));
+                *(uint32_t*)data.data() = i; // unique content
+                SaveFileFromBuffer(path, data.data(), size);
+            }
+        }
+    }
+
+    // fingerprint all files in the depot using the cache, returns number of files that had to be read
+    static uint32_t ScanDepot(uint32_t numFiles, ImportFingerprintCache& cache)
+    {
+        uint32_t numFilesRead = 0;
+        for (uint32_t i = 0; i < numFiles; ++i)
+        {
+            const auto path = ScanFilePath(i);
+
+            FileIdentity identity;
+            if (!FileIdentityInfo(path, identity))
+                continue;
+
+            ImportFileFingerprint fingerprint;
+            if (cache.findEntry(path, identity, fingerprint))
+                continue;
+
+            if (auto file = OpenForReading(path))
+            {
+                if (FingerpintCalculationStatus::OK == CalculateFileFingerprint(file, nullptr, fingerprint))
+                {
+                    cache.storeEntry(path, identity, fingerprint);
+                    numFilesRead += 1;
+                }
+            }
+        }
+
+        return numFilesRead;
+    }
+
+    // first scan of the depot, every file has to be read
+    static void RunColdScan(uint32_t numFiles)
+    {
+        PrepareScanDepot(numFiles);
+
+        const auto cachePath = TestPath("coldScan.db");
+        CreatePath(cachePath);
+        DeleteFile(cachePath);
+
+        ImportFingerprintCache cache;
+
+        ScopeTimer timer;
+        const auto numFilesRead = ScanDepot(numFiles, cache);
+        const auto scanTime = timer.timeElapsed();
+
+        ScopeTimer flushTimer;
+        EXPECT_TRUE(cache.flush(cachePath));
+        const auto flushTime = flushTimer.timeElapsed();
+
+        EXPECT_EQ(numFiles, numFilesRead);
+        TRACE_WARNING("Fingerprint cold scan of {} files: {} ms ({} us per file), flush {} ms", numFilesRead,
+            Prec(scanTime * 1000.0, 1), Prec(scanTime * 1e6 / numFiles, 2), Prec(flushTime * 1000.0, 1));
+
+        CleanupScanDepot(numFiles, cachePath);
+    }
+
+    // scan with the cache from the previous run, nothing should be read
+    static void RunWarmScan(uint32_t numFiles)
+    {
+        PrepareScanDepot(numFiles);
+
+        const auto cachePath = TestPath("warmScan.db");
+        CreatePath(cachePath);
+        DeleteFile(cachePath);
+
+        {
+            ImportFingerprintCache cache;
+            ScanDepot(numFiles, cache);
+            EXPECT_TRUE(cache.flush(cachePath));
+        }
+
+        TimingStatistics loadStats, scanStats;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            ImportFingerprintCache cache;
+
+            {
+                ScopeTimer timer;
+                EXPECT_TRUE(cache.load(cachePath));
+                loadStats.update(timer.timeElapsed());
+            }
+
+            EXPECT_EQ(numFiles, cache.size());
+
+            {
+                ScopeTimer timer;
+                EXPECT_EQ(0U, ScanDepot(numFiles, cache));
+                scanStats.update(timer.timeElapsed());
+            }
+        }
+
+        TRACE_WARNING("Fingerprint warm scan of {} files: load {} ms, scan {} ms ({} us per file)", numFiles,
+            Prec(loadStats.mean() * 1000.0, 2), Prec(scanStats.mean() * 1000.0, 1), Prec(scanStats.mean() * 1e6 / numFiles, 2));
+
+        CleanupScanDepot(numFiles, cachePath);
+    }
+
+} // helper
+
+TEST(ImportFileFingerprint, ColdScan)
+{
+    helper::RunColdScan(helper::SCAN_NUM_FILES);
+}
+
+TEST(ImportFileFingerprint, WarmScan)
+{
+    helper::RunWarmScan(helper::SCAN_NUM_FILES);
+}
+
+TEST(ImportFileFingerprint, Perf_ColdScan100k)
+{
+    helper::RunColdScan(helper::SCAN_NUM_FILES_PERF);
+}
+
+TEST(ImportFileFingerprint, Perf_WarmScan100k)
+{
+    helper::RunWarmScan(helper::SCAN_NUM_FILES_PERF);
+}
+
+END_BOOMER_NAMESPACE()
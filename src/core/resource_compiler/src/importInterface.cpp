@@ -27,6 +27,15 @@ ResourceImporterConfigurationClassMetadata::ResourceImporterConfigurationClassMe
 {
 
 }
+
+//--
+
+RTTI_BEGIN_TYPE_CLASS(ResourceImporterConcurrencyMetadata);
+RTTI_END_TYPE();
+
+ResourceImporterConcurrencyMetadata::ResourceImporterConcurrencyMetadata()
+{}
+
 //--
 
 RTTI_BEGIN_TYPE_ABSTRACT_CLASS(IResourceImporter);
@@ -0,0 +1,140 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: import #]
+***/
+
+#include "build.h"
+#include "importJobScheduler.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+ImportJobScheduler::ImportJobScheduler()
+{}
+
+ImportJobScheduler::~ImportJobScheduler()
+{
+    DEBUG_CHECK_EX(m_numRunningJobs == 0, "Import jobs still running");
+    DEBUG_CHECK_EX(m_jobFinishedFence.empty(), "Import jobs still waiting");
+}
+
+uint32_t ImportJobScheduler::numRunningJobs() const
+{
+    auto lock = CreateLock(m_lock);
+    return m_numRunningJobs;
+}
+
+uint32_t ImportJobScheduler::numWaitingJobs() const
+{
+    auto lock = CreateLock(m_lock);
+    return m_waitingJobs.size();
+}
+
+void ImportJobScheduler::push(ImportScheduledJob* job, const StringBuf& assetKey)
+{
+    DEBUG_CHECK_RETURN_EX(job, "Invalid job");
+
+    FiberSemaphore fenceToSignal;
+
+    {
+        auto lock = CreateLock(m_lock);
+
+        ImportScheduledJob* previousAssetJob = nullptr;
+        if (m_lastJobPerAsset.find(assetKey, previousAssetJob) && !previousAssetJob->finished)
+            job->dependency = previousAssetJob;
+        m_lastJobPerAsset[assetKey] = job;
+
+        m_waitingJobs.pushBack(job);
+
+        // new job may be able to start right away
+        fenceToSignal = m_jobFinishedFence;
+        m_jobFinishedFence = FiberSemaphore();
+    }
+
+    if (!fenceToSignal.empty())
+        SignalFence(fenceToSignal);
+}
+
+ImportScheduledJob* ImportJobScheduler::popReadyJob_NoLock()
+{
+    // take the first job that can run now, jobs that wait for their asset or importer don't block other jobs
+    for (auto i : m_waitingJobs.indexRange())
+    {
+        auto* job = m_waitingJobs[i];
+
+        if (job->dependency && !job->dependency->finished)
+            continue;
+
+        if (job->slots && job->slots->maxRunning && job->slots->numRunning >= job->slots->maxRunning)
+            continue;
+
+        if (job->slots)
+            job->slots->numRunning += 1;
+
+        m_waitingJobs.erase(i);
+        m_numRunningJobs += 1;
+        return job;
+    }
+
+    return nullptr;
+}
+
+ImportScheduledJob* ImportJobScheduler::pop()
+{
+    for (;;)
+    {
+        FiberSemaphore fenceToWait;
+
+        {
+            auto lock = CreateLock(m_lock);
+
+            if (auto* job = popReadyJob_NoLock())
+                return job;
+
+            // running jobs may still schedule follow ups
+            if (m_waitingJobs.empty() && m_numRunningJobs == 0)
+                return nullptr;
+
+            // all waiting jobs depend on the running ones, sleep until one of them finishes
+            // NOTE: the first job waiting always has something running (its dependency or a job of the same importer) so this can't dead lock
+            if (m_jobFinishedFence.empty())
+                m_jobFinishedFence = CreateFence("ImportJobFinished", 1);
+            fenceToWait = m_jobFinishedFence;
+        }
+
+        WaitForFence(fenceToWait);
+    }
+}
+
+void ImportJobScheduler::finish(ImportScheduledJob* job)
+{
+    DEBUG_CHECK_RETURN_EX(job, "Invalid job");
+
+    FiberSemaphore fenceToSignal;
+
+    {
+        auto lock = CreateLock(m_lock);
+        DEBUG_CHECK_RETURN_EX(!job->finished, "Job already finished");
+        DEBUG_CHECK_RETURN_EX(m_numRunningJobs > 0, "No jobs running");
+
+        if (job->slots)
+            job->slots->numRunning -= 1;
+
+        job->finished = true;
+        m_numRunningJobs -= 1;
+
+        fenceToSignal = m_jobFinishedFence;
+        m_jobFinishedFence = FiberSemaphore();
+    }
+
+    if (!fenceToSignal.empty())
+        SignalFence(fenceToSignal);
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
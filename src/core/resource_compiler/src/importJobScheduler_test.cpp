@@ -0,0 +1,244 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/system/include/thread.h"
+#include "core/system/include/timedScope.h"
+
+#include "importJobScheduler.h"
+
+DECLARE_TEST_FILE(ImportJobScheduler);
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace helper
+{
+    struct TestJob : public ImportScheduledJob
+    {
+        uint32_t index = 0;
+    };
+
+    static void CreateJobs(ImportJobScheduler& scheduler, Array<UniquePtr<TestJob>>& outJobs, uint32_t count, ImportJobSlots* slots, StringView assetPrefix, uint32_t numAssets)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto job = new TestJob;
+            job->index = outJobs.size();
+            job->slots = slots;
+            outJobs.emplaceBack(job);
+
+            scheduler.push(job, TempString("{}{}", assetPrefix, i % numAssets));
+        }
+    }
+
+    // keep the worker busy, the import jobs we care about are CPU bound
+    static uint32_t SimulateWork(uint32_t seed, uint32_t iterations)
+    {
+        uint32_t ret = seed;
+        for (uint32_t i = 0; i < iterations; ++i)
+            ret = (ret * 1664525U) + 1013904223U;
+        return ret;
+    }
+
+    static void RunJobs(ImportJobScheduler& scheduler, uint32_t numFibers, const std::function<void(TestJob*)>& func)
+    {
+        auto jobsDone = CreateFence("TestImportJobs", numFibers);
+        RunChildFiber("TestImportJob").invocations(numFibers) << [&scheduler, &func, jobsDone](FIBER_FUNC)
+        {
+            while (auto* job = static_cast<TestJob*>(scheduler.pop()))
+            {
+                func(job);
+                scheduler.finish(job);
+            }
+
+            SignalFence(jobsDone);
+        };
+
+        WaitForFence(jobsDone);
+    }
+
+} // helper
+
+TEST(ImportJobScheduler, EmptySchedulerHasNoWork)
+{
+    ImportJobScheduler scheduler;
+    EXPECT_EQ(nullptr, scheduler.pop());
+}
+
+TEST(ImportJobScheduler, LimitedImporterDoesNotBlockOtherImporters)
+{
+    ImportJobScheduler scheduler;
+    Array<UniquePtr<helper::TestJob>> jobs;
+
+    ImportJobSlots limited;
+    limited.maxRunning = 1;
+    helper::CreateJobs(scheduler, jobs, 2, &limited, "limited", 2);
+
+    ImportJobSlots unlimited;
+    helper::CreateJobs(scheduler, jobs, 2, &unlimited, "unlimited", 2);
+
+    auto* first = scheduler.pop();
+    ASSERT_EQ(jobs[0].get(), first);
+    EXPECT_EQ(1, limited.numRunning);
+
+    // second job of the limited importer has to wait, the ones after it don't
+    EXPECT_EQ(jobs[2].get(), scheduler.pop());
+    EXPECT_EQ(jobs[3].get(), scheduler.pop());
+    EXPECT_EQ(1, scheduler.numWaitingJobs());
+    EXPECT_EQ(3, scheduler.numRunningJobs());
+
+    scheduler.finish(first);
+    EXPECT_EQ(0, limited.numRunning);
+    EXPECT_EQ(jobs[1].get(), scheduler.pop());
+
+    for (uint32_t i = 1; i < jobs.size(); ++i)
+        scheduler.finish(jobs[i].get());
+
+    EXPECT_EQ(nullptr, scheduler.pop());
+    EXPECT_EQ(0, unlimited.numRunning);
+}
+
+TEST(ImportJobScheduler, JobsFromSameAssetWaitForEachOther)
+{
+    ImportJobScheduler scheduler;
+    Array<UniquePtr<helper::TestJob>> jobs;
+    helper::CreateJobs(scheduler, jobs, 3, nullptr, "asset", 1);
+    helper::CreateJobs(scheduler, jobs, 1, nullptr, "other", 1);
+
+    EXPECT_EQ(nullptr, jobs[0]->dependency);
+    EXPECT_EQ(jobs[0].get(), jobs[1]->dependency);
+    EXPECT_EQ(jobs[1].get(), jobs[2]->dependency);
+    EXPECT_EQ(nullptr, jobs[3]->dependency);
+
+    auto* first = scheduler.pop();
+    ASSERT_EQ(jobs[0].get(), first);
+    EXPECT_EQ(jobs[3].get(), scheduler.pop());
+    scheduler.finish(jobs[3].get());
+
+    scheduler.finish(first);
+    EXPECT_EQ(jobs[1].get(), scheduler.pop());
+    scheduler.finish(jobs[1].get());
+    EXPECT_EQ(jobs[2].get(), scheduler.pop());
+    scheduler.finish(jobs[2].get());
+
+    EXPECT_EQ(nullptr, scheduler.pop());
+}
+
+TEST(ImportJobScheduler, ConcurrencyLimitIsRespected)
+{
+    ImportJobScheduler scheduler;
+    Array<UniquePtr<helper::TestJob>> jobs;
+
+    ImportJobSlots limited;
+    limited.maxRunning = 2;
+    helper::CreateJobs(scheduler, jobs, 24, &limited, "limited", 24);
+
+    ImportJobSlots unlimited;
+    helper::CreateJobs(scheduler, jobs, 24, &unlimited, "unlimited", 24);
+
+    std::atomic<uint32_t> numLimitedRunning = 0;
+    std::atomic<uint32_t> maxLimitedRunning = 0;
+    std::atomic<uint32_t> numDone = 0;
+
+    helper::RunJobs(scheduler, 8, [&](helper::TestJob* job)
+        {
+            if (job->slots == &limited)
+            {
+                const auto count = ++numLimitedRunning;
+
+                auto prevMax = maxLimitedRunning.load();
+                while (count > prevMax && !maxLimitedRunning.compare_exchange_weak(prevMax, count))
+                {}
+
+                Sleep(1);
+                --numLimitedRunning;
+            }
+            else
+            {
+                Sleep(1);
+            }
+
+            ++numDone;
+        });
+
+    EXPECT_EQ(jobs.size(), numDone.load());
+    EXPECT_LE(maxLimitedRunning.load(), 2u);
+    EXPECT_EQ(0, limited.numRunning);
+    EXPECT_EQ(0, scheduler.numRunningJobs());
+    EXPECT_EQ(0, scheduler.numWaitingJobs());
+}
+
+TEST(ImportJobScheduler, JobsWaitingForAssetRunInOrder)
+{
+    ImportJobScheduler scheduler;
+    Array<UniquePtr<helper::TestJob>> jobs;
+    helper::CreateJobs(scheduler, jobs, 64, nullptr, "asset", 4);
+
+    SpinLock orderLock;
+    Array<uint32_t> order;
+
+    helper::RunJobs(scheduler, 8, [&](helper::TestJob* job)
+        {
+            helper::SimulateWork(job->index, 10000);
+
+            auto lock = CreateLock(orderLock);
+            order.pushBack(job->index);
+        });
+
+    ASSERT_EQ(jobs.size(), order.size());
+
+    // jobs of the same asset finished in the order they were scheduled
+    uint32_t lastIndex[4] = { 0,0,0,0 };
+    bool seen[4] = { false,false,false,false };
+    for (const auto index : order)
+    {
+        const auto asset = index % 4;
+        if (seen[asset])
+            EXPECT_LT(lastIndex[asset], index);
+        lastIndex[asset] = index;
+        seen[asset] = true;
+    }
+}
+
+//--
+
+TEST(ImportJobScheduler, Perf_ParallelJobs)
+{
+    static const uint32_t NUM_JOBS = 256;
+    static const uint32_t NUM_ITERATIONS = 200000;
+
+    const auto numWorkers = std::max<uint32_t>(1, WorkerThreadCount());
+
+    double timeSerial = 0.0;
+    double timeParallel = 0.0;
+
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        ImportJobScheduler scheduler;
+        Array<UniquePtr<helper::TestJob>> jobs;
+        helper::CreateJobs(scheduler, jobs, NUM_JOBS, nullptr, "asset", NUM_JOBS);
+
+        std::atomic<uint32_t> check = 0;
+
+        ScopeTimer timer;
+        helper::RunJobs(scheduler, pass ? numWorkers : 1, [&check](helper::TestJob* job)
+            {
+                check += helper::SimulateWork(job->index, NUM_ITERATIONS) & 1;
+            });
+
+        (pass ? timeParallel : timeSerial) = timer.timeElapsed();
+        EXPECT_EQ(0, scheduler.numRunningJobs());
+    }
+
+    TRACE_WARNING("Running {} import jobs: serial {}, {} fibers {} ({}x)", NUM_JOBS,
+        TimeInterval(timeSerial), numWorkers, TimeInterval(timeParallel), Prec(timeSerial / timeParallel, 2));
+}
+
+END_BOOMER_NAMESPACE()
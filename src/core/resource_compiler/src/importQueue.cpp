@@ -11,6 +11,8 @@
 #include "importQueue.h"
 #include "core/resource/include/metadata.h"
 #include "importSaveThread.h"
+#include "importInterface.h"
+#include "core/fibers/include/fiberSystem.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
@@ -33,6 +35,43 @@ public:
     {}
 };
 
+// callbacks are called from multiple jobs but the implementations were never written with that in mind
+class ImportQueueSerializedCallbacks : public IImportQueueCallbacks
+{
+public:
+    ImportQueueSerializedCallbacks(IImportQueueCallbacks* callbacks)
+        : m_callbacks(callbacks)
+    {}
+
+    virtual void queueJobAdded(const ImportJobInfo& info) override final
+    {
+        auto lock = CreateLock(m_lock);
+        m_callbacks->queueJobAdded(info);
+    }
+
+    virtual void queueJobStarted(StringView depotPath) override final
+    {
+        auto lock = CreateLock(m_lock);
+        m_callbacks->queueJobStarted(depotPath);
+    }
+
+    virtual void queueJobFinished(StringView depotPath, ImportStatus status, double timeTaken) override final
+    {
+        auto lock = CreateLock(m_lock);
+        m_callbacks->queueJobFinished(depotPath, status, timeTaken);
+    }
+
+    virtual void queueJobProgressUpdate(StringView depotPath, uint64_t currentCount, uint64_t totalCount, StringView text) override final
+    {
+        auto lock = CreateLock(m_lock);
+        m_callbacks->queueJobProgressUpdate(depotPath, currentCount, totalCount, text);
+    }
+
+private:
+    Mutex m_lock;
+    IImportQueueCallbacks* m_callbacks = nullptr;
+};
+
 class ImportQueueDepotChecker : public IImportDepotChecker
 {
 public:
@@ -70,25 +109,38 @@ ImportQueue::ImportQueue(SourceAssetRepository* assets, IImportDepotLoader* load
         static ImportQueueNullCallbacks theNullCallbacks;
         m_callbacks = &theNullCallbacks;
     }
+
+    m_serializedCallbacks.reset(new ImportQueueSerializedCallbacks(m_callbacks));
+    m_callbacks = m_serializedCallbacks.get();
+
+    m_scheduler.create();
 }
 
 ImportQueue::~ImportQueue()
-{}
+{
+    m_scheduler.reset();
+    m_jobsList.clearPtr();
+    m_importerSlots.clearPtr();
+}
 
 void ImportQueue::scheduleJob(const ImportJobInfo& job)
 {
     if (job.depotFilePath && job.assetFilePath)
     {
         const auto key = job.depotFilePath.toLower();
+        const auto assetKey = job.assetFilePath.toLower();
+        const auto importerClass = m_importer->findImporterClass(job);
 
         auto lock = CreateLock(m_jobLock);
         if (!m_jobsMap.contains(key))
         {
             auto* jobInfo = new LocalJobInfo;
             jobInfo->info = job;
+            jobInfo->slots = importerSlots(importerClass);
+
             m_jobsList.pushBack(jobInfo);
-            m_jobQueue.push(jobInfo);
             m_jobsMap[key] = jobInfo;
+            m_scheduler->push(jobInfo, assetKey);
             m_numTotalJobsScheduled += 1;
 
             m_callbacks->queueJobAdded(job);
@@ -96,15 +148,23 @@ void ImportQueue::scheduleJob(const ImportJobInfo& job)
     }
 }
 
-const ImportQueue::LocalJobInfo* ImportQueue::popNextJob()
+ImportQueue::ImporterSlots* ImportQueue::importerSlots(SpecificClassType<IResourceImporter> importerClass)
 {
-    auto lock = CreateLock(m_jobLock);
-    if (m_jobQueue.empty())
+    if (!importerClass)
         return nullptr;
 
-    auto* job = m_jobQueue.top();
-    m_jobQueue.pop();
-    return job;
+    for (auto* slots : m_importerSlots)
+        if (slots->importerClass == importerClass)
+            return slots;
+
+    auto* slots = new ImporterSlots;
+    slots->importerClass = importerClass;
+
+    if (const auto* metadata = importerClass->findMetadata<ResourceImporterConcurrencyMetadata>())
+        slots->maxRunning = metadata->maxConcurrentJobs();
+
+    m_importerSlots.pushBack(slots);
+    return slots;
 }
 
 class ImportQueueProgressTracker : public IProgressTracker
@@ -136,11 +196,40 @@ private:
 
 bool ImportQueue::processNextJob(IProgressTracker* progressTracker)
 {
-    // get next job to process
-    const auto* job = popNextJob();
+    // get next job to process, waits if all waiting jobs depend on the running ones
+    auto* job = static_cast<LocalJobInfo*>(m_scheduler->pop());
     if (!job)
         return false;
 
+    processJob(job, progressTracker);
+    m_scheduler->finish(job);
+    return true;
+}
+
+void ImportQueue::processAllJobs(IProgressTracker* progressTracker, uint32_t maxConcurrentJobs)
+{
+    if (maxConcurrentJobs <= 1)
+    {
+        while (processNextJob(progressTracker))
+        {}
+    }
+    else
+    {
+        auto jobsDone = CreateFence("ImportJobs", maxConcurrentJobs);
+        RunChildFiber("ImportJob").invocations(maxConcurrentJobs) << [this, progressTracker, jobsDone](FIBER_FUNC)
+        {
+            while (processNextJob(progressTracker))
+            {}
+
+            SignalFence(jobsDone);
+        };
+
+        WaitForFence(jobsDone);
+    }
+}
+
+void ImportQueue::processJob(const LocalJobInfo* job, IProgressTracker* progressTracker)
+{
     // update status
     progressTracker->reportProgress(m_numTotalJobsDone, m_numTotalJobsScheduled, TempString("{}", job->info.depotFilePath));
     m_numTotalJobsDone += 1;
@@ -153,7 +242,7 @@ bool ImportQueue::processNextJob(IProgressTracker* progressTracker)
     if (progressTracker->checkCancelation())
     {
         m_callbacks->queueJobFinished(job->info.depotFilePath, ImportStatus::Canceled, 0.0);
-        return true;
+        return;
     }
 
     // check if resource is up to date
@@ -177,12 +266,12 @@ bool ImportQueue::processNextJob(IProgressTracker* progressTracker)
                     scheduleJob(jobInfo);
                 }
 
-                return true;
+                return;
             }
             else if (status == ImportStatus::Canceled)
             {
                 m_callbacks->queueJobFinished(job->info.depotFilePath, ImportStatus::Canceled, timer.timeElapsed());
-                return true;
+                return;
             }
 
             if (!job->info.externalConfig)
@@ -199,7 +288,7 @@ bool ImportQueue::processNextJob(IProgressTracker* progressTracker)
     if (progressTracker->checkCancelation())
     {
         m_callbacks->queueJobFinished(job->info.depotFilePath, ImportStatus::Canceled, timer.timeElapsed());
-        return true;
+        return;
     }
 
     // import resource
@@ -230,9 +319,6 @@ bool ImportQueue::processNextJob(IProgressTracker* progressTracker)
     // if resource was imported send it to saving
     if (importedResource && m_saver)
         m_saver->scheduleSave(importedResource, job->info.depotFilePath);
-
-    // we are done
-    return true;
 }
 
 //--
@@ -82,6 +82,9 @@ SourceAssetPtr SourceAssetRepository::loadSourceAsset(StringView assetImportPath
         return entry->asset;
     }
 
+    // load without holding the lock, import jobs for other assets can load their stuff in the mean time
+    lock.release();
+
     // load content to buffer
     TimeStamp assetContentTimestamp;
     ImportFileFingerprint assetContentFingerprint;
@@ -100,22 +103,35 @@ SourceAssetPtr SourceAssetRepository::loadSourceAsset(StringView assetImportPath
     auto assetPtr = ISourceAssetLoader::LoadFromMemory(assetImportPath, contextPath, contentData);
 
     // add to cache
-    if (assetPtr->shouldCacheInMemory())
+    if (assetPtr && assetPtr->shouldCacheInMemory())
     {
+        lock.aquire();
+
+        // asset may have been loaded by other job in the mean time, use the cached one so all jobs share the same asset
+        entry = nullptr;
+        m_cacheEntriesMap.find(keyPath, entry);
+        if (entry && entry->asset)
+        {
+            outTimestamp = entry->timestamp;
+            outFingerprint = entry->fingerprint;
+            entry->lruTick = m_lruTick++;
+            return entry->asset;
+        }
+
         // calculate the memory used by the loaded assets
         const auto memorySize = assetPtr->calcMemoryUsage();
         ensureMemoryForAsset(memorySize);
 
         // add entry to cache
-        auto* entry = new CacheEntry;
-        entry->assetImportPath = keyPath;
-        entry->asset = assetPtr;
-        entry->timestamp = assetContentTimestamp;
-        entry->fingerprint = assetContentFingerprint;
-        entry->lruTick = m_lruTick++;
-        entry->memorySize = memorySize;
-        m_cacheEntries.pushBack(entry);
-        m_cacheEntriesMap[keyPath] = entry;
+        auto* newEntry = new CacheEntry;
+        newEntry->assetImportPath = keyPath;
+        newEntry->asset = assetPtr;
+        newEntry->timestamp = assetContentTimestamp;
+        newEntry->fingerprint = assetContentFingerprint;
+        newEntry->lruTick = m_lruTick++;
+        newEntry->memorySize = memorySize;
+        m_cacheEntries.pushBack(newEntry);
+        m_cacheEntriesMap[keyPath] = newEntry;
     }
 
     // return loaded asset
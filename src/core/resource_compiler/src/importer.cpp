@@ -309,6 +309,20 @@ ImportStatus Importer::importResource(const ImportJobInfo& info, const IResource
     return ImportStatus::NewAssetImported;
 }
 
+SpecificClassType<IResourceImporter> Importer::findImporterClass(const ImportJobInfo& info) const
+{
+    const auto depotExtension = info.depotFilePath.view().afterLast(".");
+    const auto targetResourceClass = IResource::FindResourceClassByExtension(depotExtension);
+    if (!targetResourceClass)
+        return nullptr;
+
+    SpecificClassType<IResourceImporter> importerClass;
+    if (!findBestImporter(info.assetFilePath, targetResourceClass, importerClass))
+        return nullptr;
+
+    return importerClass;
+}
+
 //--
 
 void Importer::buildClassMap()
@@ -7,6 +7,7 @@ FileFilter("src/debugPOSIX.cpp", "posix")
 FileFilter("src/mutexPOSIX.cpp", "posix")
 FileFilter("src/eventPOSIX.cpp", "posix")
 FileFilter("src/multiQueuePOSIX.cpp", "posix")
+FileFilter("src/orderedQueuePOSIX.cpp", "posix")
 FileFilter("src/semaphorePOSIX.cpp", "posix")
 FileFilter("src/threadPOSIX.cpp", "posix")
 FileFilter("src/systemInfoPOSIX.cpp", "posix")
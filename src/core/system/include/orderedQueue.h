@@ -18,6 +18,9 @@ BEGIN_BOOMER_NAMESPACE()
 class CORE_SYSTEM_API IOrderedQueue : public NoCopy
 {
 public:
+    ///! destroy the queue, it must be closed and nobody can be waiting in pop()
+    virtual ~IOrderedQueue();
+
     ///! close queue, all jobs are discarded
     virtual void close() = 0;
 
@@ -34,9 +37,6 @@ public:
 
     //! Create a job queue
     static IOrderedQueue* Create();
-
-protected:
-    virtual ~IOrderedQueue();
 };
 
 //-----------------------------------------------------------------------------
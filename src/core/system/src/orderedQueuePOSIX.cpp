@@ -0,0 +1,360 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: platform\threading\posix #]
+* [#platform: posix #]
+***/
+
+#include "build.h"
+#include "orderedQueuePOSIX.h"
+
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
+{
+
+    //--
+
+    POSIXOrderedQueue* POSIXOrderedQueue::Create()
+    {
+        return new POSIXOrderedQueue();
+    }
+
+    //--
+
+    POSIXOrderedQueue::POSIXOrderedQueue()
+    {}
+
+    POSIXOrderedQueue::~POSIXOrderedQueue()
+    {
+        for (uint32_t i = 0; i < m_orderList.heapSize; ++i)
+        {
+            auto* bucket = m_orderList.heap[i];
+            while (auto* entry = bucket->head)
+            {
+                bucket->head = entry->next;
+                delete entry;
+            }
+
+            delete bucket;
+        }
+
+        while (auto* entry = m_entryFreeList)
+        {
+            m_entryFreeList = entry->next;
+            delete entry;
+        }
+
+        while (auto* bucket = m_orderBucketFreeList)
+        {
+            m_orderBucketFreeList = bucket->hashNext;
+            delete bucket;
+        }
+
+        delete[] m_orderList.heap;
+        delete[] m_orderList.hash;
+    }
+
+    void POSIXOrderedQueue::FutexWait(std::atomic<int32_t>* addr, int32_t expected)
+    {
+        // NOTE: returns right away if the value is no longer the expected one, spurious wake ups are handled by the caller
+        syscall(SYS_futex, (int32_t*)addr, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    void POSIXOrderedQueue::FutexWake(std::atomic<int32_t>* addr, int32_t count)
+    {
+        syscall(SYS_futex, (int32_t*)addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+
+    void POSIXOrderedQueue::lockList()
+    {
+        // uncontended case
+        int32_t state = 0;
+        if (m_listLock.compare_exchange_strong(state, 1))
+            return;
+
+        // the lock is held for very short time so spin a little before going to sleep
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            state = 0;
+            if (m_listLock.compare_exchange_weak(state, 1))
+                return;
+        }
+
+        // mark the lock as contended and sleep until it's released
+        while (m_listLock.exchange(2) != 0)
+            FutexWait(&m_listLock, 2);
+    }
+
+    void POSIXOrderedQueue::unlockList()
+    {
+        if (m_listLock.exchange(0) == 2)
+            FutexWake(&m_listLock, 1);
+    }
+
+    void POSIXOrderedQueue::close()
+    {
+        // changing the futex word makes sure nobody goes to sleep after this point
+        m_numAvailable.fetch_or(EXIT_FLAG);
+        FutexWake(&m_numAvailable, INT_MAX);
+    }
+
+    void POSIXOrderedQueue::push(void* jobData, uint64_t order)
+    {
+        // insert into the ordered list
+        lockList();
+        {
+            auto* entry = allocEntry();
+            entry->payload = jobData;
+            entry->next = nullptr;
+
+            auto* bucket = getBucket(order);
+            if (bucket->tail)
+                bucket->tail->next = entry;
+            else
+                bucket->head = entry;
+            bucket->tail = entry;
+        }
+        unlockList();
+
+        // publish entry, the entry is already in the list so whoever grabs the count will find something to pop
+        ++m_numAvailable;
+
+        // wake up one sleeper, only if there's any
+        if (m_numWaiters.load() > 0)
+            FutexWake(&m_numAvailable, 1);
+    }
+
+    void* POSIXOrderedQueue::pop()
+    {
+        // grab one of the available entries
+        uint32_t spinCount = 0;
+        for (;;)
+        {
+            auto count = m_numAvailable.load();
+            if (count & EXIT_FLAG)
+                return nullptr;
+
+            if (count > 0)
+            {
+                if (m_numAvailable.compare_exchange_weak(count, count - 1))
+                    break;
+                continue;
+            }
+
+            // spin for a moment before going to sleep, the work usually comes in bursts
+            if (++spinCount < 64)
+                continue;
+
+            // sleep, the push will see us as a waiter after it publishes the entry, or we will see the non-zero count in the futex check
+            ++m_numWaiters;
+            FutexWait(&m_numAvailable, 0);
+            --m_numWaiters;
+            spinCount = 0;
+        }
+
+        // pop the entry with the smallest order
+        lockList();
+
+        ASSERT_EX(m_orderList.heapSize > 0, "Queue count and content mismatch");
+        auto* bucket = m_orderList.heap[0];
+
+        auto* entry = bucket->head;
+        bucket->head = entry->next;
+        if (!bucket->head)
+        {
+            bucket->tail = nullptr;
+            removeTopBucket();
+        }
+
+        auto* ret = entry->payload;
+        releaseEntry(entry);
+
+        unlockList();
+        return ret;
+    }
+
+    void POSIXOrderedQueue::inspect(const TQueueInspectorFunc& inspectorFunc)
+    {
+        lockList();
+
+        // NOTE: buckets are visited in the heap order, not the pop order
+        for (uint32_t i = 0; i < m_orderList.heapSize; ++i)
+            for (auto* entry = m_orderList.heap[i]->head; entry; entry = entry->next)
+                inspectorFunc(entry->payload);
+
+        unlockList();
+    }
+
+    //--
+
+    POSIXOrderedQueue::Entry* POSIXOrderedQueue::allocEntry()
+    {
+        if (auto* entry = m_entryFreeList)
+        {
+            m_entryFreeList = entry->next;
+            return entry;
+        }
+
+        return new Entry();
+    }
+
+    void POSIXOrderedQueue::releaseEntry(Entry* entry)
+    {
+        entry->payload = nullptr;
+        entry->next = m_entryFreeList;
+        m_entryFreeList = entry;
+    }
+
+    POSIXOrderedQueue::OrderBucket* POSIXOrderedQueue::allocBucket()
+    {
+        if (auto* bucket = m_orderBucketFreeList)
+        {
+            m_orderBucketFreeList = bucket->hashNext;
+            return bucket;
+        }
+
+        return new OrderBucket();
+    }
+
+    void POSIXOrderedQueue::releaseBucket(OrderBucket* bucket)
+    {
+        bucket->hashNext = m_orderBucketFreeList;
+        m_orderBucketFreeList = bucket;
+    }
+
+    static INLINE uint32_t HashOrder(uint64_t order)
+    {
+        return (uint32_t)(order ^ (order >> 32)) * 2654435761U;
+    }
+
+    void POSIXOrderedQueue::growLists()
+    {
+        const auto newCapacity = std::max<uint32_t>(256, m_orderList.heapCapacity * 2);
+
+        // heap
+        auto* newHeap = new OrderBucket*[newCapacity];
+        memcpy(newHeap, m_orderList.heap, sizeof(OrderBucket*) * m_orderList.heapSize);
+        delete[] m_orderList.heap;
+        m_orderList.heap = newHeap;
+        m_orderList.heapCapacity = newCapacity;
+
+        // rehash, there's one slot for each possible bucket
+        auto* newHash = new OrderBucket*[newCapacity];
+        memset(newHash, 0, sizeof(OrderBucket*) * newCapacity);
+        delete[] m_orderList.hash;
+        m_orderList.hash = newHash;
+        m_orderList.hashMask = newCapacity - 1;
+
+        for (uint32_t i = 0; i < m_orderList.heapSize; ++i)
+        {
+            auto* bucket = m_orderList.heap[i];
+            auto& slot = m_orderList.hash[HashOrder(bucket->order) & m_orderList.hashMask];
+            bucket->hashNext = slot;
+            slot = bucket;
+        }
+    }
+
+    POSIXOrderedQueue::OrderBucket* POSIXOrderedQueue::getBucket(uint64_t order)
+    {
+        // most of the time we push into the same bucket
+        if (m_orderList.lastUsed && m_orderList.lastUsed->order == order)
+            return m_orderList.lastUsed;
+
+        // find existing bucket
+        if (m_orderList.hash)
+        {
+            for (auto* bucket = m_orderList.hash[HashOrder(order) & m_orderList.hashMask]; bucket; bucket = bucket->hashNext)
+            {
+                if (bucket->order == order)
+                {
+                    m_orderList.lastUsed = bucket;
+                    return bucket;
+                }
+            }
+        }
+
+        // make space
+        if (m_orderList.heapSize == m_orderList.heapCapacity)
+            growLists();
+
+        // create new bucket
+        auto* bucket = allocBucket();
+        bucket->order = order;
+        bucket->head = nullptr;
+        bucket->tail = nullptr;
+
+        auto& slot = m_orderList.hash[HashOrder(order) & m_orderList.hashMask];
+        bucket->hashNext = slot;
+        slot = bucket;
+
+        // sift up in the heap
+        auto index = m_orderList.heapSize++;
+        while (index > 0)
+        {
+            const auto parent = (index - 1) / 2;
+            if (m_orderList.heap[parent]->order <= order)
+                break;
+
+            m_orderList.heap[index] = m_orderList.heap[parent];
+            index = parent;
+        }
+        m_orderList.heap[index] = bucket;
+
+        m_orderList.lastUsed = bucket;
+        return bucket;
+    }
+
+    void POSIXOrderedQueue::removeTopBucket()
+    {
+        auto* bucket = m_orderList.heap[0];
+        DEBUG_CHECK(bucket->head == nullptr);
+
+        // remove from hash
+        auto* slot = &m_orderList.hash[HashOrder(bucket->order) & m_orderList.hashMask];
+        while (*slot != bucket)
+            slot = &(*slot)->hashNext;
+        *slot = bucket->hashNext;
+
+        if (m_orderList.lastUsed == bucket)
+            m_orderList.lastUsed = nullptr;
+
+        // move last element to the top and sift it down
+        auto* last = m_orderList.heap[--m_orderList.heapSize];
+        const auto size = m_orderList.heapSize;
+        uint32_t index = 0;
+        for (;;)
+        {
+            auto child = (index * 2) + 1;
+            if (child >= size)
+                break;
+
+            if (child + 1 < size && m_orderList.heap[child + 1]->order < m_orderList.heap[child]->order)
+                child += 1;
+
+            if (last->order <= m_orderList.heap[child]->order)
+                break;
+
+            m_orderList.heap[index] = m_orderList.heap[child];
+            index = child;
+        }
+
+        if (size > 0)
+            m_orderList.heap[index] = last;
+
+        releaseBucket(bucket);
+    }
+
+    //--
+
+} // prv
+
+END_BOOMER_NAMESPACE()
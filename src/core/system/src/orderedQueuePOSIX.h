@@ -0,0 +1,102 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [#filter: platform\threading\posix #]
+* [#platform: posix #]
+***/
+
+#pragma once
+
+#include "thread.h"
+#include "orderedQueue.h"
+#include "atomic.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+namespace prv
+{
+    /// POSIX (futex) based queue
+    /// the number of available entries is tracked with a futex word so push/pop don't enter the kernel unless somebody has to sleep
+    /// the ordered buckets are protected with a small futex lock that is held only for few pointer operations
+    class POSIXOrderedQueue : public IOrderedQueue
+    {
+    public:
+        static POSIXOrderedQueue* Create();
+
+    private:
+        POSIXOrderedQueue();
+        virtual ~POSIXOrderedQueue();
+
+        virtual void close() override final;
+        virtual void push(void* jobData, uint64_t order) override final;
+        virtual void* pop() override final;
+        virtual void inspect(const TQueueInspectorFunc& inspectorFunc) override final;
+
+        //---
+
+        struct Entry
+        {
+            void* payload = nullptr;
+            Entry* next = nullptr;
+        };
+
+        struct OrderBucket
+        {
+            uint64_t order = 0;
+            OrderBucket* hashNext = nullptr; // next bucket in the same hash slot (or in the free list)
+
+            Entry* head = nullptr;
+            Entry* tail = nullptr;
+        };
+
+        // non-empty buckets: min-heap by order (for pop) + hash table by order (for push)
+        struct OrderList
+        {
+            OrderBucket** heap = nullptr;
+            uint32_t heapSize = 0;
+            uint32_t heapCapacity = 0;
+
+            OrderBucket** hash = nullptr;
+            uint32_t hashMask = 0;
+
+            OrderBucket* lastUsed = nullptr; // most pushes go to the same order (child jobs of the same chain)
+        };
+
+        OrderBucket* getBucket(uint64_t order);
+        void removeTopBucket();
+        void growLists();
+
+        Entry* allocEntry();
+        void releaseEntry(Entry* entry);
+
+        OrderBucket* allocBucket();
+        void releaseBucket(OrderBucket* bucket);
+
+        //--
+
+        static const int32_t EXIT_FLAG = 0x40000000;
+
+        static void FutexWait(std::atomic<int32_t>* addr, int32_t expected);
+        static void FutexWake(std::atomic<int32_t>* addr, int32_t count);
+
+        void lockList();
+        void unlockList();
+
+        //--
+
+        Entry* m_entryFreeList = nullptr; // intrusive, O(1) alloc/release
+        OrderBucket* m_orderBucketFreeList = nullptr;
+        OrderList m_orderList;
+        std::atomic<int32_t> m_listLock = 0; // 0 - unlocked, 1 - locked, 2 - locked with possible sleepers
+
+        std::atomic<int32_t> m_numAvailable = 0; // futex word: number of entries that can be popped (+ EXIT_FLAG when closed)
+        std::atomic<int32_t> m_numWaiters = 0; // number of threads sleeping (or about to) on the futex
+
+        //----
+    };
+
+} // prv
+
+END_BOOMER_NAMESPACE()
@@ -26,6 +26,9 @@ public:
     // get current (animated) camera rotation
     INLINE const Angles& rotation() const { return m_rotation; }
 
+    // get current camera velocity (world space)
+    INLINE const Vector3& velocity() const { return m_velocity; }
+
     ///--
 
     /// reset input state of the controller
@@ -70,7 +70,7 @@ public:
     //--
 
     /// create content streaming task for this world so all required content is streamed
-    RefPtr<StreamingTask> createStreamingTask() const;
+    RefPtr<StreamingTask> createStreamingTask(const StreamingTaskSettings& settings = StreamingTaskSettings()) const;
 
     /// apply finished streaming update task
     void applyStreamingTask(const StreamingTask* task);
@@ -277,6 +277,11 @@ void Game::applyGameWorldTransition(const GameGameWorldTransition& setup)
 
 void Game::processGameWorldStreaming(GameLoadingScreenState loadingScreenState)
 {
+    // stop loading content for a world that is no longer current, whatever was loaded so far is still applied
+    if (m_currentGameWorldStreaming && !m_currentGameWorldStreaming->flagFinished)
+        if (m_currentGameWorldStreaming->world.lock() != m_currentGameWorld)
+            m_currentGameWorldStreaming->task->requestCancel();
+
     // finish current streaming
     if (m_currentGameWorldStreaming && m_currentGameWorldStreaming->flagFinished)
     {
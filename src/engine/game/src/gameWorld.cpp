@@ -153,7 +153,7 @@ bool GameWorld::calculateCamera(CameraSetup& outCamera)
     return false;
 }
 
-RefPtr<StreamingTask> GameWorld::createStreamingTask() const
+RefPtr<StreamingTask> GameWorld::createStreamingTask(const StreamingTaskSettings& settings) const
 {
     // collect streaming observers
     InplaceArray<StreamingObserverInfo, 4> observers;
@@ -163,6 +163,7 @@ RefPtr<StreamingTask> GameWorld::createStreamingTask() const
     {
         auto& info = observers.emplaceBack();
         info.position = m_freeCamera->position();
+        info.velocity = m_freeCamera->velocity();
     }
 
     // use each entity from the stack as the streaming observer
@@ -174,7 +175,7 @@ RefPtr<StreamingTask> GameWorld::createStreamingTask() const
 
     // request streaming task
     auto streaming = system<StreamingSystem>();
-    return streaming->createStreamingTask(observers);
+    return streaming->createStreamingTask(observers, settings);
 }
 
 void GameWorld::applyStreamingTask(const StreamingTask* task)
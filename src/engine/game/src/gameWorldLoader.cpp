@@ -61,14 +61,19 @@ bool GameGameWorldTransition::processInit(const GameStartInfo& setup)
     auto streaming = world->system<StreamingSystem>();
     streaming->bindScene(content);
 
+    // we are behind the loading screen, load and attach everything in one go
+    StreamingTaskSettings streamingSettings;
+    streamingSettings.loadTimeBudget = 0.0;
+
     // create the initial streaming task with no observers - this will load the "always loaded" content
     {
         Array<StreamingObserverInfo> observers;
-        if (auto task = streaming->createStreamingTask(observers))
+        if (auto task = streaming->createStreamingTask(observers, streamingSettings))
         {
             ScopeTimer timer;
             task->process();
             streaming->applyStreamingTask(task);
+            streaming->attachPendingIslands();
 
             TRACE_INFO("Loaded initial content in {}", timer);
         }
@@ -99,11 +104,12 @@ bool GameGameWorldTransition::processInit(const GameStartInfo& setup)
 
     // create normal streaming task for the world
     {
-        if (auto task = world->createStreamingTask())
+        if (auto task = world->createStreamingTask(streamingSettings))
         {
             ScopeTimer timer;
             task->process();
             streaming->applyStreamingTask(task);
+            streaming->attachPendingIslands();
 
             TRACE_INFO("Loaded view dependent content in {}", timer);
         }
@@ -62,6 +62,9 @@ public:
 
     bool checkParameterUsed(IMaterialTemplateParam* param) const;
 
+    // get information about parameters used to compile the material techniques
+    void collectParameterInfos(Array<MaterialTemplateParamInfo>& outParams) const;
+
     bool renameParameter(IMaterialTemplateParam* param, StringID name);
 
     void attachParameter(IMaterialTemplateParam* param);
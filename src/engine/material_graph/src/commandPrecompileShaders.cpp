@@ -0,0 +1,427 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: commands #]
+***/
+
+#include "build.h"
+#include "graph.h"
+#include "techniqueCompiler.h"
+#include "commandPrecompileShaders.h"
+
+#include "core/app/include/commandline.h"
+#include "core/io/include/io.h"
+#include "core/containers/include/stringBuilder.h"
+#include "core/fibers/include/fiberSystem.h"
+#include "core/resource/include/depot.h"
+#include "engine/material/include/runtimeTechnique.h"
+#include "gpu/device/include/shaderService.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+RTTI_BEGIN_TYPE_CLASS(CommandPrecompileShaders);
+    RTTI_METADATA(app::CommandNameMetadata).name("precompileShaders");
+RTTI_END_TYPE();
+
+//--
+
+namespace helper
+{
+    static bool IsIdentifierStart(char ch)
+    {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch == '_');
+    }
+
+    static bool IsIdentifierChar(char ch)
+    {
+        return IsIdentifierStart(ch) || (ch >= '0' && ch <= '9');
+    }
+
+    static void ExtractIdentifiers(StringView text, Array<StringView>& outIdentifiers)
+    {
+        const auto* pos = text.data();
+        const auto* end = text.data() + text.length();
+        while (pos < end)
+        {
+            if (IsIdentifierStart(*pos))
+            {
+                const auto* start = pos;
+                while (pos < end && IsIdentifierChar(*pos))
+                    ++pos;
+
+                outIdentifiers.emplaceBack(start, pos - start);
+            }
+            else if (*pos >= '0' && *pos <= '9')
+            {
+                // skip numbers with suffixes (1u, 0x10, etc)
+                while (pos < end && IsIdentifierChar(*pos))
+                    ++pos;
+            }
+            else
+            {
+                ++pos;
+            }
+        }
+    }
+
+    // find names of the symbols the shader code can be configured with - all symbols tested in preprocessor conditions that are not defined by the file itself
+    static void ExtractSelectorSymbols(StringView code, Array<StringID>& outSymbols)
+    {
+        InplaceArray<StringView, 1024> lines;
+        code.slice("\n\r", false, lines);
+
+        InplaceArray<StringView, 32> testedSymbols;
+        InplaceArray<StringView, 32> definedSymbols;
+        for (const auto& rawLine : lines)
+        {
+            const auto line = rawLine.trim();
+            if (!line.beginsWith("#"))
+                continue;
+
+            const auto directive = line.subString(1).trimLeft();
+
+            InplaceArray<StringView, 8> identifiers;
+            ExtractIdentifiers(directive.beforeFirstOrFull("//"), identifiers);
+            if (identifiers.empty())
+                continue;
+
+            const auto name = identifiers[0];
+            if (name == "define")
+            {
+                if (identifiers.size() >= 2)
+                    definedSymbols.pushBackUnique(identifiers[1]);
+            }
+            else if (name == "if" || name == "ifdef" || name == "ifndef" || name == "elif")
+            {
+                for (uint32_t i = 1; i < identifiers.size(); ++i)
+                    if (identifiers[i] != "defined")
+                        testedSymbols.pushBackUnique(identifiers[i]);
+            }
+        }
+
+        for (const auto& symbol : testedSymbols)
+            if (!definedSymbols.contains(symbol))
+                outSymbols.pushBack(StringID(symbol));
+    }
+
+} // helper
+
+//--
+
+bool CommandPrecompileShaders::run(IProgressTracker* progress, const app::CommandLine& commandline)
+{
+    m_maxConcurrentJobs = std::clamp<int>(commandline.singleValueInt("shaderConcurrency", WorkerThreadCount()), 1, 256);
+    m_maxSelectorSymbols = std::clamp<int>(commandline.singleValueInt("maxSelectorSymbols", 6), 0, gpu::ShaderSelector::MAX_SELECTORS);
+
+    auto shaderService = GetService<gpu::ShaderService>();
+    if (!shaderService)
+    {
+        TRACE_ERROR("Shader service not started, shaders can't be compiled");
+        return false;
+    }
+
+    //--
+
+    if (!commandline.hasParam("noStaticShaders"))
+        collectStaticShaders();
+
+    if (!commandline.hasParam("noMaterials"))
+        collectMaterials();
+
+    if (m_jobs.empty())
+    {
+        TRACE_WARNING("No shaders to compile");
+        return true;
+    }
+
+    //--
+
+    const auto initialStats = shaderService->stats();
+
+    ScopeTimer timer;
+    TRACE_INFO("Compiling {} shader permutation(s) using {} job(s)", m_jobs.size(), m_maxConcurrentJobs);
+
+    if (m_maxConcurrentJobs <= 1)
+    {
+        processCompilationJobs();
+    }
+    else
+    {
+        auto jobsDone = CreateFence("ShaderCompilationJobs", m_maxConcurrentJobs);
+        RunChildFiber("ShaderCompilationJob").invocations(m_maxConcurrentJobs) << [this, jobsDone](FIBER_FUNC)
+        {
+            processCompilationJobs();
+            SignalFence(jobsDone);
+        };
+
+        WaitForFence(jobsDone);
+    }
+
+    TRACE_INFO("Finished processing {} shader permutation(s) in {}, {} compiled, {} failed", m_jobs.size(), timer, m_numCompiled.load(), m_numFailed.load());
+
+    // report what the shader service did, it tells us how many shaders came from the cache
+    {
+        const auto finalStats = shaderService->stats();
+
+        gpu::ShaderCacheStats stats;
+        stats.numMemoryHits = finalStats.numMemoryHits - initialStats.numMemoryHits;
+        stats.numDiskHits = finalStats.numDiskHits - initialStats.numDiskHits;
+        stats.numDiskOutdated = finalStats.numDiskOutdated - initialStats.numDiskOutdated;
+        stats.numWaits = finalStats.numWaits - initialStats.numWaits;
+        stats.numCompiled = finalStats.numCompiled - initialStats.numCompiled;
+        stats.numFailed = finalStats.numFailed - initialStats.numFailed;
+        stats.diskLoadTime = finalStats.diskLoadTime - initialStats.diskLoadTime;
+        stats.compilationTime = finalStats.compilationTime - initialStats.compilationTime;
+        TRACE_INFO("Shader cache: {}", stats);
+    }
+
+    printCompilationTimings();
+
+    return m_numFailed == 0;
+}
+
+//--
+
+void CommandPrecompileShaders::collectStaticShaders()
+{
+    const StringBuf shaderDirectory = TempString("{}data/shaders/", SystemPath(PathCategory::EngineDir));
+
+    Array<StringBuf> shaderFiles;
+    FindFiles(shaderDirectory, "*.fx", shaderFiles, true);
+
+    const auto numJobs = m_jobs.size();
+    for (const auto& absolutePath : shaderFiles)
+    {
+        StringBuf code;
+        if (!LoadFileToString(absolutePath, code))
+        {
+            TRACE_WARNING("Unable to load shader file '{}'", absolutePath);
+            continue;
+        }
+
+        // shader service uses paths relative to the shader directory
+        auto path = StringBuf(absolutePath.view().subString(shaderDirectory.length()));
+        path.replaceChar('\\', '/');
+
+        collectStaticShaderPermutations(path, code);
+    }
+
+    TRACE_INFO("Found {} static shader(s) with {} permutation(s)", shaderFiles.size(), m_jobs.size() - numJobs);
+}
+
+void CommandPrecompileShaders::collectStaticShaderPermutations(StringView path, StringView code)
+{
+    InplaceArray<StringID, 16> symbols;
+    helper::ExtractSelectorSymbols(code, symbols);
+
+    // all combinations of the symbols being defined or not
+    if (symbols.size() <= m_maxSelectorSymbols)
+    {
+        const auto numPermutations = 1U << symbols.size();
+        for (uint32_t mask = 0; mask < numPermutations; ++mask)
+        {
+            auto& job = m_jobs.emplaceBack();
+            job.staticShaderPath = StringBuf(path);
+
+            for (uint32_t i = 0; i < symbols.size(); ++i)
+                if (mask & (1U << i))
+                    job.selector.set(symbols[i], 1);
+        }
+    }
+
+    // too many combinations, compile each symbol on it's own
+    else
+    {
+        TRACE_WARNING("Shader '{}' has {} selector symbols, only single symbol permutations will be compiled", path, symbols.size());
+
+        m_jobs.emplaceBack().staticShaderPath = StringBuf(path);
+
+        for (const auto& symbol : symbols)
+        {
+            auto& job = m_jobs.emplaceBack();
+            job.staticShaderPath = StringBuf(path);
+            job.selector.set(symbol, 1);
+        }
+    }
+}
+
+//--
+
+void CommandPrecompileShaders::scanDepotDirectoryForMaterials(StringView depotPath, StringView extension, Array<StringBuf>& outPaths) const
+{
+    auto depot = GetService<DepotService>();
+
+    depot->enumFilesAtPath(depotPath, [&depotPath, &extension, &outPaths](const DepotService::FileInfo& info)
+        {
+            if (info.name.endsWith(extension))
+                outPaths.emplaceBack(TempString("{}{}", depotPath, info.name));
+            return false;
+        });
+
+    depot->enumDirectoriesAtPath(depotPath, [this, &depotPath, &extension, &outPaths](const DepotService::DirectoryInfo& info)
+        {
+            const StringBuf path = TempString("{}{}/", depotPath, info.name);
+            scanDepotDirectoryForMaterials(path, extension, outPaths);
+            return false;
+        });
+}
+
+void CommandPrecompileShaders::collectMaterials()
+{
+    const StringBuf extension = TempString(".{}", IResource::GetResourceExtensionForClass(MaterialGraph::GetStaticClass()));
+
+    Array<StringBuf> materialPaths;
+    scanDepotDirectoryForMaterials("/", extension, materialPaths);
+
+    // each material is compiled for all the setups it may be rendered with
+    Array<MaterialCompilationSetup> setups;
+    GatherMaterialPermutations(setups);
+
+    const auto numJobs = m_jobs.size();
+    for (const auto& path : materialPaths)
+    {
+        const auto graph = LoadResource<MaterialGraph>(path);
+        if (!graph || !graph->graph())
+        {
+            TRACE_WARNING("Unable to load material graph '{}'", path);
+            continue;
+        }
+
+        // NOTE: context name must be the same as the one used by the material at runtime or the shader keys won't match
+        auto material = CreateUniquePtr<MaterialSource>();
+        material->contextName = graph->loadPath() ? graph->loadPath() : path;
+        material->graph = graph->graph();
+        graph->collectParameterInfos(material->params);
+
+        for (const auto& setup : setups)
+        {
+            auto& job = m_jobs.emplaceBack();
+            job.material = material.get();
+            job.setup = setup;
+        }
+
+        m_materials.pushBack(std::move(material));
+    }
+
+    TRACE_INFO("Found {} material graph(s) with {} technique permutation(s)", m_materials.size(), m_jobs.size() - numJobs);
+}
+
+//--
+
+void CommandPrecompileShaders::processCompilationJobs()
+{
+    for (;;)
+    {
+        const auto index = m_jobIndex++;
+        if (index >= m_jobs.size())
+            break;
+
+        processSingleJob(m_jobs[index]);
+    }
+}
+
+void CommandPrecompileShaders::processSingleJob(CompilationJob& job)
+{
+    ScopeTimer timer;
+
+    if (job.material)
+    {
+        if (auto* technique = CompileTechnique(job.material->contextName, job.material->params, job.material->graph, job.setup))
+        {
+            job.compiled = (bool)technique->shader;
+            delete technique;
+        }
+    }
+    else
+    {
+        job.compiled = (bool)GetService<gpu::ShaderService>()->loadSystemShader(job.staticShaderPath, job.selector);
+    }
+
+    job.compileTime = timer.timeElapsed();
+
+    if (job.compiled)
+    {
+        m_numCompiled += 1;
+    }
+    else
+    {
+        m_numFailed += 1;
+
+        if (job.material)
+            TRACE_ERROR("Failed to compile material '{}' for '{}'", job.material->contextName, job.setup);
+        else
+            TRACE_ERROR("Failed to compile shader '{}' with '{}'", job.staticShaderPath, job.selector);
+    }
+}
+
+//--
+
+void CommandPrecompileShaders::printCompilationTimings() const
+{
+    // histogram of compilation times
+    {
+        static const double BUCKET_LIMITS[] = { 0.001, 0.01, 0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 5.0 };
+        static const uint32_t NUM_LIMITS = ARRAY_COUNT(BUCKET_LIMITS);
+        static const uint32_t NUM_BUCKETS = NUM_LIMITS + 1;
+
+        uint32_t bucketCounts[NUM_BUCKETS];
+        memzero(bucketCounts, sizeof(bucketCounts));
+
+        for (const auto& job : m_jobs)
+        {
+            uint32_t bucket = 0;
+            while (bucket < NUM_LIMITS && job.compileTime >= BUCKET_LIMITS[bucket])
+                bucket += 1;
+
+            bucketCounts[bucket] += 1;
+        }
+
+        uint32_t maxBucketCount = 1;
+        for (const auto count : bucketCounts)
+            maxBucketCount = std::max<uint32_t>(maxBucketCount, count);
+
+        TRACE_INFO("Compilation time histogram:");
+        for (uint32_t i = 0; i < NUM_BUCKETS; ++i)
+        {
+            StringBuilder bar;
+            bar.appendPadding('#', (bucketCounts[i] * 50 + maxBucketCount - 1) / maxBucketCount);
+
+            if (i < NUM_LIMITS)
+                TRACE_INFO("  < {}: {} {}", TimeInterval(BUCKET_LIMITS[i]), bucketCounts[i], bar);
+            else
+                TRACE_INFO("  >= {}: {} {}", TimeInterval(BUCKET_LIMITS[i - 1]), bucketCounts[i], bar);
+        }
+    }
+
+    // slowest permutations
+    {
+        Array<const CompilationJob*> sortedJobs;
+        sortedJobs.reserve(m_jobs.size());
+        for (const auto& job : m_jobs)
+            sortedJobs.pushBack(&job);
+
+        std::sort(sortedJobs.begin(), sortedJobs.end(), [](const CompilationJob* a, const CompilationJob* b)
+            {
+                return a->compileTime > b->compileTime;
+            });
+
+        const auto numPrinted = std::min<uint32_t>(20, sortedJobs.size());
+        TRACE_INFO("Slowest {} of {} shader permutations:", numPrinted, sortedJobs.size());
+        for (uint32_t i = 0; i < numPrinted; ++i)
+        {
+            const auto* job = sortedJobs[i];
+            if (job->material)
+                TRACE_INFO("  [{}] '{}' ({}): {}", i + 1, job->material->contextName, job->setup, TimeInterval(job->compileTime));
+            else
+                TRACE_INFO("  [{}] '{}' ({}): {}", i + 1, job->staticShaderPath, job->selector, TimeInterval(job->compileTime));
+        }
+    }
+}
+
+//--
+
+END_BOOMER_NAMESPACE()
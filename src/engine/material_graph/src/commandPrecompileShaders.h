@@ -0,0 +1,72 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: commands #]
+***/
+
+#pragma once
+
+#include "core/app/include/command.h"
+#include "gpu/device/include/shaderSelector.h"
+
+BEGIN_BOOMER_NAMESPACE()
+
+//--
+
+/// compile all known shader permutations (static shaders and material techniques) and store them in the shader cache
+class CommandPrecompileShaders : public app::ICommand
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(CommandPrecompileShaders, app::ICommand);
+
+public:
+    virtual bool run(IProgressTracker* progress, const app::CommandLine& commandline) override final;
+
+private:
+    struct MaterialSource
+    {
+        StringBuf contextName;
+        Array<MaterialTemplateParamInfo> params;
+        MaterialGraphContainerPtr graph;
+    };
+
+    struct CompilationJob
+    {
+        StringBuf staticShaderPath; // set for static shaders
+        gpu::ShaderSelector selector;
+
+        const MaterialSource* material = nullptr; // set for material techniques
+        MaterialCompilationSetup setup;
+
+        double compileTime = 0.0;
+        bool compiled = false;
+    };
+
+    uint32_t m_maxSelectorSymbols = 6;
+    uint32_t m_maxConcurrentJobs = 1;
+
+    Array<UniquePtr<MaterialSource>> m_materials;
+    Array<CompilationJob> m_jobs;
+
+    std::atomic<uint32_t> m_jobIndex = 0;
+    std::atomic<uint32_t> m_numCompiled = 0;
+    std::atomic<uint32_t> m_numFailed = 0;
+
+    //--
+
+    void collectStaticShaders();
+    void collectStaticShaderPermutations(StringView path, StringView code);
+
+    void collectMaterials();
+    void scanDepotDirectoryForMaterials(StringView depotPath, StringView extension, Array<StringBuf>& outPaths) const;
+
+    void processCompilationJobs();
+    void processSingleJob(CompilationJob& job);
+
+    void printCompilationTimings() const;
+};
+
+//--
+
+END_BOOMER_NAMESPACE()
@@ -205,20 +205,25 @@ MaterialTemplatePtr MaterialGraph::createPreviewTemplate(StringView label) const
 
 //--
 
-RefPtr<IMaterialTemplateDynamicCompiler> MaterialGraph::queryDynamicCompiler() const
+void MaterialGraph::collectParameterInfos(Array<MaterialTemplateParamInfo>& outParams) const
 {
-    Array<MaterialTemplateParamInfo> paramInfos;
-    paramInfos.reserve(m_parameters.size());
+    outParams.reserve(m_parameters.size());
 
     for (const auto& param : m_parameters)
     {
         if (param->name() && param->queryDataType())
         {
-            auto& info = paramInfos.emplaceBack();
+            auto& info = outParams.emplaceBack();
             info.name = param->name();
             info.parameterType = param->queryType();
         }
     }
+}
+
+RefPtr<IMaterialTemplateDynamicCompiler> MaterialGraph::queryDynamicCompiler() const
+{
+    Array<MaterialTemplateParamInfo> paramInfos;
+    collectParameterInfos(paramInfos);
 
     // create a version of material template that supports runtime compilation from the source graph
     return RefNew<PreviewGraphTechniqueCompiler>(m_graph, paramInfos);
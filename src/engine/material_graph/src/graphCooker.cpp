@@ -86,7 +86,7 @@ const bool BOOL_STATE[] =
 	true,
 };
 
-static void GatherMaterialPermutations(Array<MaterialCompilationSetup>& outSetupList)
+void GatherMaterialPermutations(Array<MaterialCompilationSetup>& outSetupList)
 {
     for (auto pass : PERM_PASS_LIST)
     {
@@ -16,6 +16,9 @@ BEGIN_BOOMER_NAMESPACE()
 struct MaterialCompiledTechnique;
 extern MaterialCompiledTechnique* CompileTechnique(const StringBuf& contextName, const Array<MaterialTemplateParamInfo>& params, const MaterialGraphContainerPtr& graph, const MaterialCompilationSetup& setup);
 
+/// list all the compilation setups (pass, vertex format, etc) material techniques are normally used with
+extern void GatherMaterialPermutations(Array<MaterialCompilationSetup>& outSetupList);
+
 //---
 
 /// a local compiler used to compile a single technique of given material
@@ -11,6 +11,7 @@
 #include "object.h"
 
 #include "core/object/include/objectSelection.h"
+#include "core/containers/include/flatHashMap.h"
 #include "engine/material/include/runtimeService.h"
 
 BEGIN_BOOMER_NAMESPACE_EX(rendering)
@@ -189,10 +190,6 @@ private:
 
 	struct LocalObject
 	{
-		VisibilityBox box;
-        Vector3 distanceRefPoint;
-        float maxDistanceSquared = 0.0f;
-        //uint16_t chunkCount = 0;
 		ObjectProxyMeshPtr data = nullptr;
 	};
 
@@ -207,7 +204,24 @@ private:
 		uint16_t materialIndex = 0;
 	};
 
-	HashMap<ObjectProxyMesh*, LocalObject> m_localObjects;
+	FlatHashMap<ObjectProxyMesh*, LocalObject> m_localObjects;
+
+	// culling data of local objects, packed and in the same order as m_localObjects.values()
+	VisibilityBoxList m_localObjectBoxes;
+	Array<Vector4> m_localObjectDistances; // XYZ - LOD reference point, W - max visibility distance squared
+
+	struct VisibleObject
+	{
+		const ObjectProxyMesh* object = nullptr;
+		uint32_t lodMask = 0;
+	};
+
+	struct VisibleObjectList
+	{
+		Array<VisibleObject> objects;
+		Array<uint8_t> frustumTest; // temp
+		Array<uint32_t> jobCounts; // visible objects found by each job
+	};
 
 	struct VisibleChunkList
 	{
@@ -223,6 +237,7 @@ private:
 		VisibleChunkList depthLists[2];
 		VisibleChunkList forwardLists[3];
 		VisibleChunkList selectionOutlineList;
+		VisibleObjectList visibleObjects;
 
 		void prepare(uint32_t totalChunkCount);
 	};
@@ -231,6 +246,7 @@ private:
     {
         VisibleChunkList mainList;
 		VisibleChunkList selectionOutlineList;
+		VisibleObjectList visibleObjects;
 
         void prepare(uint32_t totalChunkCount);
     };
@@ -238,6 +254,7 @@ private:
     struct VisibleCaptureCollector
     {
         VisibleChunkList mainList;
+		VisibleObjectList visibleObjects;
 
         void prepare(uint32_t totalChunkCount);
     };
@@ -252,6 +269,8 @@ private:
 
 	//--
 
+	void cullObjects(const FrameViewSingleCamera& view, VisibleObjectList& outVisibleObjects) const;
+
 	void collectMainViewChunks(const FrameViewSingleCamera& view, VisibleMainViewCollector& outCollector, ObjectMeshVisibilityStats& outStats) const;
 	void collectWireframeViewChunks(const FrameViewSingleCamera& view, VisibleWireframeViewCollector& outCollector) const;
 	void collectCaptureChunks(const FrameViewSingleCamera& view, VisibleCaptureCollector& outCollector) const;
@@ -23,6 +23,7 @@
 #include "engine/material/include/runtimeTemplate.h"
 
 #include "gpu/device/include/descriptor.h"
+#include "core/fibers/include/fiberSystem.h"
 
 BEGIN_BOOMER_NAMESPACE_EX(rendering)
 
@@ -393,6 +394,89 @@ void ObjectManagerMesh::VisibleCaptureCollector::prepare(uint32_t totalChunkCoun
 
 //--
 
+static ConfigProperty<uint32_t> cvMeshCullingObjectsPerJob("Rendering.Culling", "MeshObjectsPerJob", 4096);
+
+void ObjectManagerMesh::cullObjects(const FrameViewSingleCamera& view, VisibleObjectList& outVisibleObjects) const
+{
+	PC_SCOPE_LVL1(CullMeshObjects);
+
+	const auto numObjects = m_localObjects.values().size();
+	DEBUG_CHECK_EX(numObjects == m_localObjectBoxes.size(), "Culling data out of sync");
+
+	// prepare culling camera
+	VisibilityFrustum frustum;
+	frustum.setup(view.visibilityCamera());
+
+	const auto lodReferencePoint = view.lodReferencePoint();
+
+	// objects are split between jobs, each job writes visible objects into its own part of the output
+	const auto objectsPerJob = Align<uint32_t>(std::max<uint32_t>(64, cvMeshCullingObjectsPerJob.get()), 4);
+	const auto numJobs = (numObjects + objectsPerJob - 1) / objectsPerJob;
+
+	// keep the memory between frames, everything is written by the jobs
+	outVisibleObjects.objects.reset();
+	outVisibleObjects.frustumTest.reset();
+	outVisibleObjects.jobCounts.reset();
+
+	const auto* objects = m_localObjects.values().typedData();
+	const auto* distances = m_localObjectDistances.typedData();
+	auto* frustumTest = outVisibleObjects.frustumTest.allocateUninitialized(numObjects);
+	auto* visibleObjects = outVisibleObjects.objects.allocateUninitialized(numObjects);
+	auto* jobCounts = outVisibleObjects.jobCounts.allocateUninitialized(numJobs);
+
+	const auto cullJob = [this, &frustum, &lodReferencePoint, objects, distances, frustumTest, visibleObjects, jobCounts, objectsPerJob, numObjects](uint32_t jobIndex)
+	{
+		const auto first = jobIndex * objectsPerJob;
+		const auto last = std::min<uint32_t>(first + objectsPerJob, numObjects);
+
+		// test bounding boxes 4 at a time
+		m_localObjectBoxes.testFrustum(frustum, first, last - first, frustumTest + first);
+
+		// check distance and select LODs only for objects that passed
+		auto* writePtr = visibleObjects + first;
+		for (uint32_t i = first; i < last; ++i)
+		{
+			if (!frustumTest[i])
+				continue;
+
+			const auto& distance = distances[i];
+			const auto lodDistance = lodReferencePoint.squareDistance(distance.xyz());
+			if (lodDistance >= distance.w)
+				continue;
+
+			const auto* object = objects[i].data.get();
+			const auto lodMask = object->calcDetailMask(lodDistance);
+			if (!lodMask)
+				continue;
+
+			writePtr->object = object;
+			writePtr->lodMask = lodMask;
+			++writePtr;
+		}
+
+		jobCounts[jobIndex] = writePtr - (visibleObjects + first);
+	};
+
+	if (numJobs > 1)
+		RunFiberLoop("CullMeshObjects", numJobs, -1, cullJob);
+	else if (numJobs)
+		cullJob(0);
+
+	// merge results of all jobs, order is the same as if culling was done on one thread
+	uint32_t numVisibleObjects = 0;
+	for (uint32_t i = 0; i < numJobs; ++i)
+	{
+		const auto first = i * objectsPerJob;
+		const auto count = jobCounts[i];
+		if (count && first != numVisibleObjects)
+			memmove(visibleObjects + numVisibleObjects, visibleObjects + first, count * sizeof(VisibleObject));
+		numVisibleObjects += count;
+	}
+
+	if (numVisibleObjects < numObjects)
+		outVisibleObjects.objects.erase(numVisibleObjects, numObjects - numVisibleObjects);
+}
+
 void ObjectManagerMesh::collectMainViewChunks(const FrameViewSingleCamera& view, VisibleMainViewCollector& outCollector, ObjectMeshVisibilityStats& outStats) const
 {
 	PC_SCOPE_LVL1(CollectMainView);
@@ -402,41 +486,26 @@ void ObjectManagerMesh::collectMainViewChunks(const FrameViewSingleCamera& view,
     // render only chunks that we want to show in the main view
     const auto renderMask = (uint32_t)MeshChunkRenderingMaskBit::Scene;
 
-	// visit all objects
-	const auto* objects = m_localObjects.values().typedData();
-    const auto* objectsEnd = objects + m_localObjects.values().size();
-	outStats.numTestedObjects += m_localObjects.values().size();
-
-    // prepare culling camera
-    VisibilityFrustum frustum;
-    frustum.setup(view.visibilityCamera());
-
 	// prepare output
 	outCollector.prepare(1024);
 
-	// cull objects and collect visible chunks
-	while (objects < objectsEnd)
-	{
-		// cull against frustum
-		const auto& object = *objects++;
-		if (!object.box.isInFrustum(frustum))
-			continue;
-
-		const auto lodDistance = view.lodReferencePoint().squareDistance(object.distanceRefPoint);
-		if (lodDistance >= object.maxDistanceSquared)
-			continue;
+	// cull all objects
+	cullObjects(view, outCollector.visibleObjects);
+	outStats.numTestedObjects += m_localObjects.values().size();
 
-		const auto lodMask = object.data->calcDetailMask(lodDistance);
-		if (!lodMask)
-			continue;
+	// collect visible chunks
+	for (const auto& visibleObject : outCollector.visibleObjects.objects)
+	{
+		const auto* object = visibleObject.object;
+		const auto lodMask = visibleObject.lodMask;
 
-        const auto selected = object.data->m_flags.test(ObjectProxyFlagBit::Selected);
+        const auto selected = object->m_flags.test(ObjectProxyFlagBit::Selected);
 
 		outStats.numVisibleObjects += 1;
-		outStats.numTestedChunks += object.data->m_numChunks;
+		outStats.numTestedChunks += object->m_numChunks;
 
-		const auto* chunk = object.data->chunks();
-		const auto* chunkEnd = chunk + object.data->m_numChunks;
+		const auto* chunk = object->chunks();
+		const auto* chunkEnd = chunk + object->m_numChunks;
 		while (chunk < chunkEnd)
 		{
 			if (chunk->lodMask & lodMask)
@@ -446,7 +515,7 @@ void ObjectManagerMesh::collectMainViewChunks(const FrameViewSingleCamera& view,
 					outStats.numVisibleChunks += 1;
 
 					auto& visChunk = outCollector.forwardLists[chunk->forwardPassType].standaloneChunks.emplaceBack();
-					visChunk.object = object.data;
+					visChunk.object = object;
 					visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 					visChunk.material = chunk->material;
 					visChunk.shader = chunk->shader;
@@ -457,7 +526,7 @@ void ObjectManagerMesh::collectMainViewChunks(const FrameViewSingleCamera& view,
 					outStats.numVisibleChunks += 1;
 
 					auto& visChunk = outCollector.depthLists[chunk->depthPassType].standaloneChunks.emplaceBack();
-					visChunk.object = object.data;
+					visChunk.object = object;
 					visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 					visChunk.material = chunk->material;
 					visChunk.shader = chunk->shader; // TODO: allow fallback to simpler depth-only shader ?
@@ -468,7 +537,7 @@ void ObjectManagerMesh::collectMainViewChunks(const FrameViewSingleCamera& view,
 					outStats.numVisibleChunks += 1;
 
 					auto& visChunk = outCollector.selectionOutlineList.standaloneChunks.emplaceBack();
-					visChunk.object = object.data;
+					visChunk.object = object;
 					visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 					visChunk.material = chunk->material;
 					visChunk.shader = chunk->shader;
@@ -489,41 +558,26 @@ void ObjectManagerMesh::collectCaptureChunks(const FrameViewSingleCamera& view,
 	// render only chunks that we want to show in the main view
 	const auto renderMask = (uint32_t)MeshChunkRenderingMaskBit::Scene;
 
-	// visit all objects
-	const auto* objects = m_localObjects.values().typedData();
-	const auto* objectsEnd = objects + m_localObjects.values().size();
-
-	// prepare culling camera
-	VisibilityFrustum frustum;
-	frustum.setup(view.visibilityCamera());
-
 	// prepare output
 	outCollector.prepare(1024);
 
-	// cull objects and collect visible chunks
-	while (objects < objectsEnd)
-	{
-		// cull against frustum
-		const auto& object = *objects++;
-		if (!object.box.isInFrustum(frustum))
-			continue;
+	// cull all objects
+	cullObjects(view, outCollector.visibleObjects);
 
-        const auto lodDistance = view.lodReferencePoint().squareDistance(object.distanceRefPoint);
-        if (lodDistance >= object.maxDistanceSquared)
-            continue;
-
-        const auto lodMask = object.data->calcDetailMask(lodDistance);
-        if (!lodMask)
-            continue;
+	// collect visible chunks
+	for (const auto& visibleObject : outCollector.visibleObjects.objects)
+	{
+		const auto* object = visibleObject.object;
+		const auto lodMask = visibleObject.lodMask;
 
-		const auto* chunk = object.data->chunks();
-		const auto* chunkEnd = chunk + object.data->m_numChunks;
+		const auto* chunk = object->chunks();
+		const auto* chunkEnd = chunk + object->m_numChunks;
 		while (chunk < chunkEnd)
 		{
 			if (chunk->lodMask & lodMask)
 			{
 				auto& visChunk = outCollector.mainList.standaloneChunks.emplaceBack();
-				visChunk.object = object.data;
+				visChunk.object = object;
 				visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 				visChunk.material = chunk->material;
 				visChunk.materialIndex = chunk->materialIndex;
@@ -542,37 +596,22 @@ void ObjectManagerMesh::collectWireframeViewChunks(const FrameViewSingleCamera&
 	// render only chunks that we want to show in the main view
 	const auto renderMask = (uint32_t)MeshChunkRenderingMaskBit::Scene;
 
-	// visit all objects
-	const auto* objects = m_localObjects.values().typedData();
-	const auto* objectsEnd = objects + m_localObjects.values().size();
-
-	// prepare culling camera
-	VisibilityFrustum frustum;
-	frustum.setup(view.visibilityCamera());
-
 	// prepare output
 	outCollector.prepare(1024);
 
-	// cull objects and collect visible chunks
-	while (objects < objectsEnd)
-	{
-		// cull against frustum
-		const auto& object = *objects++;
-		if (!object.box.isInFrustum(frustum))
-			continue;
-
-        const auto lodDistance = view.lodReferencePoint().squareDistance(object.distanceRefPoint);
-        if (lodDistance >= object.maxDistanceSquared)
-            continue;
+	// cull all objects
+	cullObjects(view, outCollector.visibleObjects);
 
-        const auto lodMask = object.data->calcDetailMask(lodDistance);
-        if (!lodMask)
-            continue;
+	// collect visible chunks
+	for (const auto& visibleObject : outCollector.visibleObjects.objects)
+	{
+		const auto* object = visibleObject.object;
+		const auto lodMask = visibleObject.lodMask;
 
-		const auto selected = object.data->m_flags.test(ObjectProxyFlagBit::Selected);
+		const auto selected = object->m_flags.test(ObjectProxyFlagBit::Selected);
 
-		const auto* chunk = object.data->chunks();
-		const auto* chunkEnd = chunk + object.data->m_numChunks;
+		const auto* chunk = object->chunks();
+		const auto* chunkEnd = chunk + object->m_numChunks;
 		while (chunk < chunkEnd)
 		{
 			if (chunk->lodMask & lodMask)
@@ -580,7 +619,7 @@ void ObjectManagerMesh::collectWireframeViewChunks(const FrameViewSingleCamera&
 				if (chunk->forwardPassType != 2)
 				{
 					auto& visChunk = outCollector.mainList.standaloneChunks.emplaceBack();
-					visChunk.object = object.data;
+					visChunk.object = object;
 					visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 					visChunk.material = chunk->material;
 					visChunk.shader = chunk->shader;
@@ -588,7 +627,7 @@ void ObjectManagerMesh::collectWireframeViewChunks(const FrameViewSingleCamera&
 					if (selected)
 					{
 						auto& visChunk = outCollector.selectionOutlineList.standaloneChunks.emplaceBack();
-						visChunk.object = object.data;
+						visChunk.object = object;
 						visChunk.chunk = (const MeshChunkProxy_Standalone*)chunk->data.get();
 						visChunk.material = chunk->material;
 						visChunk.shader = chunk->shader;
@@ -792,20 +831,27 @@ void ObjectManagerMesh::attachProxy(ObjectProxyMeshPtr meshProxy)
 		const auto box = meshProxy->m_localToWorld.transformBox(meshProxy->m_localBox);
 
 		LocalObject obj;
-		obj.box.setup(box);
 		obj.data = meshProxy;
-		obj.distanceRefPoint = box.center();
-		obj.maxDistanceSquared = meshProxy->visibilityDistanceSquared();
 
+		// new objects are always added at the end
 		m_localObjects[meshProxy] = obj;
+		m_localObjectBoxes.add(box);
+		m_localObjectDistances.pushBack(Vector4(box.center(), meshProxy->visibilityDistanceSquared()));
+		DEBUG_CHECK(m_localObjectBoxes.size() == m_localObjects.size() && m_localObjectDistances.size() == m_localObjects.size());
 		});
 }
 
 void ObjectManagerMesh::detachProxy(ObjectProxyMeshPtr meshProxy)
 {
 	runNowOrBuffer([this, meshProxy]() {
-		DEBUG_CHECK_RETURN_EX(m_localObjects.contains(meshProxy), "Proxy not registered");
+		const auto* localObject = m_localObjects.find(meshProxy);
+		DEBUG_CHECK_RETURN_EX(localObject != nullptr, "Proxy not registered");
+
+		// map moves the last object into the hole, do the same with the culling data
+		const auto index = localObject - m_localObjects.values().typedData();
 		m_localObjects.remove(meshProxy);
+		m_localObjectBoxes.removeUnordered(index);
+		m_localObjectDistances.eraseUnordered(index);
 		});
 }
 
@@ -819,8 +865,10 @@ void ObjectManagerMesh::moveProxy(ObjectProxyMeshPtr meshProxy, Matrix localToWo
 
 		const auto* proxy = localObject->data.get();
 		const auto box = proxy->m_localToWorld.transformBox(proxy->m_localBox);
-		localObject->box.setup(box);
-		localObject->distanceRefPoint = box.center();
+
+		const auto index = localObject - m_localObjects.values().typedData();
+		m_localObjectBoxes.update(index, box);
+		m_localObjectDistances[index].xyz() = box.center();
 		});
 }
 
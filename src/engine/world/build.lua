@@ -18,6 +18,7 @@ Dependency("core_input")
 Dependency("core_fibers")
 Dependency("core_math")
 Dependency("core_image")
+Dependency("core_test")
 
 Dependency("engine_imgui")
 
@@ -27,6 +27,8 @@ enum class EntityFlagBit : uint64_t
     Detaching = FLAG(11),
     Attached = FLAG(12),
     DirtyTransform = FLAG(13),
+    SerialTransformUpdate = FLAG(14), // handleTransformUpdate touches shared state and must be called on main thread
+    ParallelTick = FLAG(15), // handlePreTick/handlePostTick only modify the entity itself and can be called on worker fibers
     //CastShadows = FLAG(10),
     //ReceiveShadows = FLAG(11),
 };
@@ -136,13 +138,16 @@ public:
     //--
 
     /// update part before the systems are updated (good place to process input and send it to systems)
+    /// NOTE: for entities with ParallelTick flag this is called on worker fibers, only the entity itself can be modified and world changes (attach/detach/transform requests) are deferred
     virtual void handlePreTick(float dt);
 
     /// update part after the systems are updated (good place to suck data from systems)
+    /// NOTE: same threading rules as for handlePreTick apply
     virtual void handlePostTick(float dt);
 
     /// update transform chain of this entity, NOTE: can be called even if we don't have world attached (it will basically dry-move entity to new place)
-    virtual void handleTransformUpdate(const AbsoluteTransform& transform);
+    /// NOTE: world updates transforms in batches and calls this on worker fibers unless the SerialTransformUpdate flag is set, only the entity itself can be modified in here
+    virtual void handleTransformUpdate(const AbsoluteTransform& transform, const Matrix& localToWorld);
 
     /// handle attachment to world, called during world update
     virtual void handleAttach();
@@ -200,12 +205,25 @@ public:
     // initialize entity from template properties
     virtual bool initializeFromTemplateProperties(const ITemplatePropertyValueContainer& templateProperties) override;
 
+protected:
+    /// force the handleTransformUpdate to be called on main thread, required if it touches anything outside the entity
+    void serialTransformUpdate(bool flag);
+
+    /// allow the entity to be ticked on worker fibers together with other such entities
+    void parallelTick(bool flag);
+
+    /// make sure this entity is ticked after given entity (ex: weapon after the owner), works for both serial and parallel entities
+    /// NOTE: serial entity that ticks after a parallel one is ticked after all parallel entities
+    void tickAfter(Entity* entity);
+
 private:
     World* m_world = nullptr;
     EntityFlags m_flags;
 
     uint32_t m_selectionOwner = 0;
 
+    EntityWeakPtr m_tickAfter;
+
     //--
 
     AbsoluteTransform m_absoluteTransform; // absolute entity transform
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "core/resource/include/resource.h"
+#include "core/system/include/timing.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
@@ -37,14 +38,27 @@ public:
 
     INLINE const uint32_t size() const { return m_entites.size(); }
 
+    // number of entities already attached to the world
+    INLINE uint32_t numAttached() const { return m_numAttached; }
+
+    // are all entities attached and streamed in ?
+    INLINE bool attached() const { return m_numStreamedIn == m_entites.size(); }
+
     // TODO: named lookup ?
     // TODO: flag to hide island when children are loaded (mesh proxy)
 
-    void attach(World* world); // tempshit, attaches all entities
-    void detach(World* world); // tempshit, detaches all entities
+    // attach next slice of entities to the world, entities are streamed in once all of them are attached, returns true when island is fully attached
+    // NOTE: each attached or streamed in entity decrements the budget, we also stop once the deadline (if valid) is reached, at least one entity is always processed
+    bool attach(World* world, uint32_t& entityBudget, NativeTimePoint deadline = NativeTimePoint());
+
+    // detach all entities that were attached so far
+    void detach(World* world);
 
 protected:
     Array<StreamingIslandPackedEntity> m_entites;
+
+    uint32_t m_numAttached = 0;
+    uint32_t m_numStreamedIn = 0;
 };
 
 //---
@@ -104,6 +118,12 @@ public:
     // NOTE: loaded entities are not yet linked to parent entities
     CAN_YIELD StreamingIslandInstancePtr load(ResourceLoader* loader) const;
 
+    // first stage of loading: decompress the packed entity data, can be called on any thread
+    CAN_YIELD Buffer unpack() const;
+
+    // second stage of loading: create entities from the unpacked data (resolves prefabs and loads resources), can be called on any thread
+    CAN_YIELD StreamingIslandInstancePtr instance(const Buffer& unpackedData, ResourceLoader* loader) const;
+
     //--
 
     // TODO: embedded resources 
@@ -40,28 +40,136 @@ public:
 
 //--
 
+// bounding volume hierarchy of the island streaming boxes, built once when scene is bound
+class ENGINE_WORLD_API StreamingIslandTree : public NoCopy
+{
+public:
+    StreamingIslandTree();
+
+    /// build the tree for given islands
+    void build(const Array<StreamingIslandInfo>& islands);
+
+    /// remove all data
+    void clear();
+
+    /// collect islands with streaming box touching given box, returns number of tested islands
+    uint32_t collect(const Box& box, Array<uint32_t>& outIslands) const;
+
+private:
+    static const uint32_t MAX_ISLANDS_PER_LEAF = 8;
+
+    struct Node
+    {
+        Box box;
+        uint32_t first = 0; // first island in leaf or index of second child (first child directly follows the node)
+        uint32_t count = 0; // zero for inner nodes
+    };
+
+    Array<Node> m_nodes;
+    Array<uint32_t> m_islandIndices;
+    Array<Box> m_islandBoxes; // in the order of m_islandIndices
+
+    void buildNode(const Array<StreamingIslandInfo>& islands, uint32_t first, uint32_t count);
+};
+
+//--
+
+// stage of the island in the streaming pipeline
+enum class StreamingIslandStage : uint8_t
+{
+    Unloaded,
+    Queued, // selected for loading by the streaming task
+    Unpacking, // entity data is decompressed
+    Instancing, // entities are created, prefabs and resources are loaded
+    Loaded, // waiting for the streaming task to be applied
+    PendingAttach, // waiting in the attach queue
+    Attaching, // entities are attached to the world in slices
+    Attached,
+};
+
+// stages of all islands of the bound scene, shared with the streaming tasks that update them as islands are loaded
+// NOTE: task may still be running when a different scene is bound, it keeps the old stages alive and nobody looks at them any more
+class ENGINE_WORLD_API StreamingIslandStages : public IReferencable
+{
+public:
+    StreamingIslandStages(uint32_t count);
+    virtual ~StreamingIslandStages();
+
+    INLINE uint32_t size() const { return m_count; }
+
+    StreamingIslandStage stage(uint32_t index) const;
+    void stage(uint32_t index, StreamingIslandStage stage);
+
+private:
+    std::atomic<uint8_t>* m_stages = nullptr;
+    uint32_t m_count = 0;
+};
+
+//--
+
+// settings for the streaming update
+struct ENGINE_WORLD_API StreamingTaskSettings
+{
+    float velocityPredictionTime = 2.0f; // extend observers by this many seconds of movement
+    double loadTimeBudget = 0.0; // stop loading islands after this time (in seconds), 0 - no limit
+
+    StreamingTaskSettings(); // defaults from World.Streaming config
+};
+
+// stats of the streaming update
+struct ENGINE_WORLD_API StreamingStats
+{
+    uint32_t numIslandsTested = 0; // islands tested against observers in last task
+    uint32_t numIslandsInRange = 0;
+    uint32_t numIslandsLoaded = 0; // islands loaded in last task
+    uint32_t numIslandsUnloaded = 0;
+    uint32_t numIslandsPostponed = 0; // islands in range we did not get to because of the time budget or cancellation
+    double findTime = 0.0;
+    double loadTime = 0.0;
+
+    uint32_t numIslandsAttached = 0; // islands attached in last update
+    uint32_t numIslandsDetached = 0;
+    uint32_t numIslandsPendingAttach = 0;
+    uint32_t numEntitiesAttached = 0; // entities attached (or streamed in) in last update
+    double attachTime = 0.0;
+};
+
+//--
+
 // world streaming update tasks
 class ENGINE_WORLD_API StreamingTask : public IReferencable
 {
 public:
-    StreamingTask(const Array<StreamingObserverInfo>& observers, const Array<StreamingIslandInfo>& islands, const Array<uint32_t>& attachedIslands, const BitSet<>& attachedIslandsMask);
+    StreamingTask(const Array<StreamingObserverInfo>& observers, const StreamingTaskSettings& settings, const Array<StreamingIslandInfo>& islands, const StreamingIslandTree& tree, const Array<uint32_t>& attachedIslands, const BitSet<>& attachedIslandsMask, const RefPtr<StreamingIslandStages>& islandStages);
 
-    /// request streaming task to be canceled
+    /// request streaming task to be canceled, islands already loaded are still valid and can be applied
     void requestCancel();
 
     /// process the task, can be called directly (blocking) 
     /// but it should be called on job
     CAN_YIELD void process();
 
+    /// stats of the processed task
+    INLINE const StreamingStats& stats() const { return m_stats; }
+
+    /// were there islands in range that we did not load (budget or cancellation)
+    INLINE bool hasMoreWork() const { return m_stats.numIslandsPostponed > 0; }
+
     //--
 
 private:
     Array<StreamingObserverInfo> m_observers;
+    StreamingTaskSettings m_settings;
+    std::atomic<bool> m_canceled = false;
+
+    StreamingStats m_stats;
 
     Array<uint32_t> m_attachedIslands; // modified
     BitSet<> m_attachedIslandsMask; // modified
 
     const Array<StreamingIslandInfo>& m_islands;
+    const StreamingIslandTree& m_tree;
+    RefPtr<StreamingIslandStages> m_islandStages; // shared with the streaming system, updated as islands are loaded
 
     Array<uint32_t> m_unloadedIslands;
     Array<uint32_t> m_loadedIslands;
@@ -91,26 +199,56 @@ public:
 
     //--
 
+    /// get stats of the last streaming update
+    INLINE const StreamingStats& stats() const { return m_stats; }
+
+    /// get number of islands in the bound scene
+    INLINE uint32_t islandCount() const { return m_islands.size(); }
+
+    /// get current stage of the island in the streaming pipeline
+    StreamingIslandStage islandStage(uint32_t index) const;
+
+    /// get loaded island instance, valid only once the island started attaching
+    INLINE const StreamingIslandInstance* islandInstance(uint32_t index) const { return m_islandInstances[index].get(); }
+
+    //--
+
     /// create streaming update tasks using current observers and other settings
     /// NOTE: may return NULL if there's nothing to stream in/out
-    RefPtr<StreamingTask> createStreamingTask(const Array<StreamingObserverInfo>& observers) const;
+    RefPtr<StreamingTask> createStreamingTask(const Array<StreamingObserverInfo>& observers, const StreamingTaskSettings& settings = StreamingTaskSettings()) const;
 
     /// apply finished streaming update task
-    /// first outgoing entities are detached then new entities are attached
-    /// TODO: partial "budgeted" attach to minimize hitching
+    /// first outgoing entities are detached then new entities are attached, attaching is done within the time budget, rest of islands is attached in following frames
     void applyStreamingTask(const StreamingTask* task);
 
+    /// attach islands that are loaded but were not yet attached due to the time/entity budget, 0 - no limit
+    void attachPendingIslands(double timeBudget = 0.0, uint32_t entityBudget = 0);
+
 protected:
     virtual void handleShutdown() override;
+    virtual void handlePreTick(double dt) override;
 
     //--
 
     Array<StreamingIslandInfo> m_islands;
     Array<StreamingIslandInstancePtr> m_islandInstances;
+    StreamingIslandTree m_islandTree;
 
-    Array<uint32_t> m_attachedIslands;
+    Array<uint32_t> m_attachedIslands; // including the pending ones
     BitSet<> m_attachedIslandsMask;
 
+    struct PendingIsland
+    {
+        uint32_t index = 0;
+        StreamingIslandInstancePtr data;
+    };
+
+    Array<PendingIsland> m_pendingIslands; // loaded but not yet attached, parents are always before children, first one may be partially attached
+
+    RefPtr<StreamingIslandStages> m_islandStages; // stage of each island, shared with the running streaming task
+
+    StreamingStats m_stats;
+
     //--
 };
 
@@ -10,6 +10,8 @@
 
 #include "core/memory/include/structurePool.h"
 #include "core/object/include/object.h"
+#include "core/containers/include/flatHashMap.h"
+#include "core/system/include/spinLock.h"
 
 BEGIN_BOOMER_NAMESPACE()
 
@@ -38,10 +40,15 @@ struct ENGINE_WORLD_API WorldStats
 
     uint32_t numTransformUpdateBaches = 0;
     uint32_t numTransformUpdateEntities = 0;
+    uint32_t numTransformUpdateSerialEntities = 0; // entities that had to be updated on main thread
     double transformUpdateTime = 0.0;
+    double transformGatherTime = 0.0; // collecting requests into batch
+    double transformParallelTime = 0.0; // computing matrices and thread safe updates on fibers
+    double transformSerialTime = 0.0; // updates that must run on main thread
 
     uint32_t numPreTickLoops = 0;
     uint32_t numPreTickEntites = 0;
+    uint32_t numPreTickParallelEntites = 0; // entities ticked on worker fibers
     double preTickSystemTime = 0.0;
     double preTickEntityTime = 0.0;
     double preTickFixupTime = 0.0;
@@ -49,8 +56,11 @@ struct ENGINE_WORLD_API WorldStats
     double mainTickTime = 0.0;
 
     uint32_t numPostTickEntites = 0;
+    uint32_t numPostTickParallelEntites = 0;
     double postTickSystemTime = 0.0;
     double postTickEntityTime = 0.0;
+
+    uint32_t numDeferredCommands = 0; // world changes requested during parallel entity tick
 };
 
 ///----
@@ -110,12 +120,12 @@ public:
     /// attach entity to the world
     /// NOTE: entity cannot be already attached
     /// NOTE: world will add a reference to the entity object
-    /// NOTE: must be called on main thread
+    /// NOTE: must be called on main thread or from the parallel entity tick (the attachment is deferred)
     void attachEntity(Entity* entity);
 
     /// detach previously attached entity from the world
     /// NOTE: world will remove a reference to the entity object (the entity object may get destroyed)
-    /// NOTE: must be called on main thread
+    /// NOTE: must be called on main thread or from the parallel entity tick (the detachment is deferred)
     void detachEntity(Entity* entity);
 
     ///---
@@ -154,6 +164,42 @@ private:
 
     //--
 
+    struct DeferredEntityCommand
+    {
+        enum class Type : uint8_t
+        {
+            Attach,
+            Detach,
+            TransformUpdate,
+            Transform,
+        };
+
+        Type type = Type::Attach;
+        EntityPtr entity;
+        AbsoluteTransform transform;
+    };
+
+    bool m_parallelTickRegion = false; // entities are ticked on fibers, all world changes must be deferred
+    SpinLock m_deferredCommandsLock;
+    Array<DeferredEntityCommand> m_deferredCommands;
+
+    struct EntityTickSchedule
+    {
+        Array<Entity*> serialEntities; // ticked on main thread before parallel entities, in dependency order
+        Array<Entity*> parallelEntities; // ordered by level, entities on the same level are independent
+        Array<uint32_t> levelOffsets;
+        Array<Entity*> overflowEntities; // serial entities waiting for parallel ones, dependency chains that were too long (or cycles), ticked on main thread at the end in dependency order
+    };
+
+    EntityTickSchedule m_tickSchedule;
+
+    void buildTickSchedule();
+    uint32_t tickEntities(const std::function<void(Entity*)>& func, WorldStats& outStats);
+    bool deferEntityCommand(DeferredEntityCommand::Type type, Entity* entity, const AbsoluteTransform* transform = nullptr);
+    void applyDeferredEntityCommands(WorldStats& outStats);
+
+    //--
+
     struct TransformUpdateRequest
     {
         EntityWeakPtr entity = nullptr;
@@ -162,8 +208,18 @@ private:
     };
 
     StructurePool<TransformUpdateRequest> m_transformRequetsPool;
-    HashMap<Entity*, TransformUpdateRequest*> m_transformRequestsMap;
-    HashMap<Entity*, TransformUpdateRequest*> m_transformRequestsMap2;
+    FlatHashMap<Entity*, TransformUpdateRequest*> m_transformRequestsMap;
+    FlatHashMap<Entity*, TransformUpdateRequest*> m_transformRequestsMap2;
+
+    struct TransformUpdateBatch
+    {
+        Array<EntityPtr> entities;
+        Array<AbsoluteTransform> transforms;
+        Array<Matrix> localToWorld;
+        Array<uint32_t> serialEntities; // entities that must be updated on main thread
+    };
+
+    TransformUpdateBatch m_transformBatch;
 
     void cancelAllTransformRequests();
     void cancelTransformRequest(Entity* entity);
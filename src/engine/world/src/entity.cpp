@@ -83,6 +83,9 @@ void Entity::requestTransformUpdate()
 {
     if (m_world)
     {
+        if (m_world->deferEntityCommand(World::DeferredEntityCommand::Type::TransformUpdate, this))
+            return;
+
         if (!m_flags.test(EntityFlagBit::DirtyTransform))
         {
             m_flags |= EntityFlagBit::DirtyTransform;
@@ -91,7 +94,7 @@ void Entity::requestTransformUpdate()
     }
     else
     {
-        handleTransformUpdate(m_absoluteTransform);
+        handleTransformUpdate(m_absoluteTransform, m_absoluteTransform.approximate());
     }
 }
 
@@ -99,12 +102,15 @@ void Entity::requestTransform(const AbsoluteTransform& newTransform)
 {
     if (m_world)
     {
+        if (m_world->deferEntityCommand(World::DeferredEntityCommand::Type::Transform, this, &newTransform))
+            return;
+
         m_flags |= EntityFlagBit::DirtyTransform;
         m_world->scheduleEntityForTransformUpdateWithTransform(this, newTransform);
     }
     else
     {
-        handleTransformUpdate(newTransform);
+        handleTransformUpdate(newTransform, newTransform.approximate());
     }
 }
 
@@ -141,15 +147,37 @@ void Entity::bindSelectionOwner(uint32_t selectionOwner)
     m_selectionOwner = selectionOwner;
 }
 
+void Entity::serialTransformUpdate(bool flag)
+{
+    if (flag)
+        m_flags |= EntityFlagBit::SerialTransformUpdate;
+    else
+        m_flags -= EntityFlagBit::SerialTransformUpdate;
+}
+
+void Entity::parallelTick(bool flag)
+{
+    if (flag)
+        m_flags |= EntityFlagBit::ParallelTick;
+    else
+        m_flags -= EntityFlagBit::ParallelTick;
+}
+
+void Entity::tickAfter(Entity* entity)
+{
+    DEBUG_CHECK_RETURN_EX(entity != this, "Entity can't tick after itself");
+    m_tickAfter = entity;
+}
+
 void Entity::handleSelectionChanged()
 {
 }
 
-void Entity::handleTransformUpdate(const AbsoluteTransform& transform)
+void Entity::handleTransformUpdate(const AbsoluteTransform& transform, const Matrix& localToWorld)
 {
     // update entity transform
     m_absoluteTransform = transform;
-    m_localToWorld = m_absoluteTransform.approximate();
+    m_localToWorld = localToWorld;
 
     // transform is no longer invalid
     m_flags -= EntityFlagBit::DirtyTransform;
@@ -249,6 +277,8 @@ void Entity::queryTemplateProperties(ITemplatePropertyBuilder& outTemplateProper
     outTemplateProperties.prop("Streaming"_id, "streamingDistanceOverride"_id, 0.0f, PropertyEditorData().comment("Override distance for the streaming range"));
 
     outTemplateProperties.prop("Transform"_id, "attachToParentEntity"_id, false, PropertyEditorData().comment("In game follow parent entity"));
+
+    outTemplateProperties.prop("Tick"_id, "parallelTick"_id, false, PropertyEditorData().comment("Tick this entity on worker fibers together with other such entities (only if the entity's tick does not touch anything outside of it)"));
 }
 
 bool Entity::initializeFromTemplateProperties(const ITemplatePropertyValueContainer& templateProperties)
@@ -256,6 +286,11 @@ bool Entity::initializeFromTemplateProperties(const ITemplatePropertyValueContai
     if (!TBaseClass::initializeFromTemplateProperties(templateProperties))
         return false;
 
+    // entity class may already allow the parallel tick on it's own, change it only if the template says so
+    bool parallelTickFlag = false;
+    if (templateProperties.compileValue("parallelTick"_id, parallelTickFlag))
+        parallelTick(parallelTickFlag);
+
     return true;
 }
 
@@ -27,38 +27,60 @@ StreamingIslandInstance::StreamingIslandInstance(Array<StreamingIslandPackedEnti
 StreamingIslandInstance::~StreamingIslandInstance()
 {}
 
-void StreamingIslandInstance::attach(World* world)
+bool StreamingIslandInstance::attach(World* world, uint32_t& entityBudget, NativeTimePoint deadline)
 {
+    // always process at least one entity so we make progress even with a tiny time budget
+    uint32_t numProcessed = 0;
+    const auto hasBudget = [&entityBudget, &numProcessed, &deadline]()
+    {
+        return entityBudget && !(numProcessed && deadline && deadline.reached());
+    };
+
     {
         PC_SCOPE_LVL1(AttachStreamedIn);
-        for (const auto& ent : m_entites)
-            if (ent.data)
-                world->attachEntity(ent.data);
+        while (m_numAttached < m_entites.size() && hasBudget())
+        {
+            if (const auto& ent = m_entites[m_numAttached++].data)
+                world->attachEntity(ent);
+            entityBudget -= 1;
+            numProcessed += 1;
+        }
     }
 
+    // stream in only after all entities are in the world
+    if (m_numAttached == m_entites.size())
     {
         PC_SCOPE_LVL1(OnStreamIn);
-        for (const auto& ent : m_entites)
-            if (ent.data)
-                ent.data->handleStreamIn(this);
+        while (m_numStreamedIn < m_entites.size() && hasBudget())
+        {
+            if (const auto& ent = m_entites[m_numStreamedIn++].data)
+                ent->handleStreamIn(this);
+            entityBudget -= 1;
+            numProcessed += 1;
+        }
     }
+
+    return attached();
 }
 
 void StreamingIslandInstance::detach(World* world)
 {
     {
         PC_SCOPE_LVL1(OnStreamOut);
-        for (const auto& ent : m_entites)
-            if (ent.data)
-                ent.data->handleStreamOut(this);
+        for (uint32_t i = 0; i < m_numStreamedIn; ++i)
+            if (const auto& ent = m_entites[i].data)
+                ent->handleStreamOut(this);
     }
 
     {
         PC_SCOPE_LVL1(DetachStreamedOut);
-        for (const auto& ent : m_entites)
-            if (ent.data)
-                world->detachEntity(ent.data);
+        for (uint32_t i = 0; i < m_numAttached; ++i)
+            if (const auto& ent = m_entites[i].data)
+                world->detachEntity(ent);
     }
+
+    m_numAttached = 0;
+    m_numStreamedIn = 0;
 }
 
 //---
@@ -128,12 +150,29 @@ StreamingIslandInstancePtr StreamingIsland::load(ResourceLoader* loader) const
 {
     PC_SCOPE_LVL1(LoadStreamingIsland);
 
+    if (const auto data = unpack())
+        return instance(data, loader);
+
+    return nullptr;
+}
+
+Buffer StreamingIsland::unpack() const
+{
+    PC_SCOPE_LVL1(UnpackStreamingIsland);
+
     // decompress buffer
     auto data = Decompress(CompressionType::LZ4HC, m_entityPackedData.data(), m_entityPackedData.size(), m_entityUnpackedDataSize, POOL_WORLD_STREAMING);
-    DEBUG_CHECK_RETURN_EX_V(data, "Unable to decompress entity data", nullptr);
+    DEBUG_CHECK_RETURN_EX_V(data, "Unable to decompress entity data", Buffer());
+
+    return data;
+}
+
+StreamingIslandInstancePtr StreamingIsland::instance(const Buffer& unpackedData, ResourceLoader* loader) const
+{
+    PC_SCOPE_LVL1(InstanceStreamingIsland);
 
     // unpack the objects
-    auto objects = rtti_cast<StreamingIslandPackedEntities>(LoadObjectFromBuffer(data.data(), data.size(), loader));
+    auto objects = rtti_cast<StreamingIslandPackedEntities>(LoadObjectFromBuffer(unpackedData.data(), unpackedData.size(), loader));
     DEBUG_CHECK_RETURN_EX_V(objects, "Unable to load packed entities", nullptr);
 
     // create runtime island
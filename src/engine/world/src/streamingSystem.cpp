@@ -33,25 +33,198 @@ StreamingIslandInfo::StreamingIslandInfo()
             
 ///---
 
-StreamingTask::StreamingTask(const Array<StreamingObserverInfo>& observers, const Array<StreamingIslandInfo>& islands, const Array<uint32_t>& attachedIslands, const BitSet<>& attachedIslandsMask)
+static ConfigProperty<float> cvStreamingVelocityPredictionTime("World.Streaming", "VelocityPredictionTime", 2.0f);
+static ConfigProperty<float> cvStreamingLoadTimeBudgetMS("World.Streaming", "LoadTimeBudgetMS", 100.0f);
+static ConfigProperty<float> cvStreamingAttachTimeBudgetMS("World.Streaming", "AttachTimeBudgetMS", 4.0f);
+static ConfigProperty<uint32_t> cvStreamingAttachEntityBudget("World.Streaming", "AttachEntityBudget", 500);
+
+static void SetIslandStage(StreamingIslandStages* stages, uint32_t index, StreamingIslandStage stage)
+{
+    if (stages)
+        stages->stage(index, stage);
+}
+
+static StreamingIslandStage GetIslandStage(const StreamingIslandStages* stages, uint32_t index)
+{
+    return stages ? stages->stage(index) : StreamingIslandStage::Unloaded;
+}
+
+StreamingIslandStages::StreamingIslandStages(uint32_t count)
+    : m_count(count)
+{
+    m_stages = new std::atomic<uint8_t>[count];
+    for (uint32_t i = 0; i < count; ++i)
+        m_stages[i] = (uint8_t)StreamingIslandStage::Unloaded;
+}
+
+StreamingIslandStages::~StreamingIslandStages()
+{
+    delete[] m_stages;
+}
+
+StreamingIslandStage StreamingIslandStages::stage(uint32_t index) const
+{
+    DEBUG_CHECK_RETURN_EX_V(index < m_count, "Invalid island index", StreamingIslandStage::Unloaded);
+    return (StreamingIslandStage)m_stages[index].load(std::memory_order_relaxed);
+}
+
+void StreamingIslandStages::stage(uint32_t index, StreamingIslandStage stage)
+{
+    DEBUG_CHECK_RETURN_EX(index < m_count, "Invalid island index");
+    m_stages[index].store((uint8_t)stage, std::memory_order_relaxed);
+}
+
+///---
+
+StreamingTaskSettings::StreamingTaskSettings()
+{
+    velocityPredictionTime = std::max<float>(0.0f, cvStreamingVelocityPredictionTime.get());
+    loadTimeBudget = std::max<float>(0.0f, cvStreamingLoadTimeBudgetMS.get()) / 1000.0;
+}
+
+///---
+
+StreamingIslandTree::StreamingIslandTree()
+{}
+
+void StreamingIslandTree::clear()
+{
+    m_nodes.clear();
+    m_islandIndices.clear();
+    m_islandBoxes.clear();
+}
+
+void StreamingIslandTree::build(const Array<StreamingIslandInfo>& islands)
+{
+    PC_SCOPE_LVL0(BuildStreamingIslandTree);
+
+    clear();
+
+    // always loaded islands don't need to be tested at all
+    m_islandIndices.reserve(islands.size());
+    for (const auto& island : islands)
+        if (!island.alwaysLoaded)
+            m_islandIndices.pushBack(island.index);
+
+    if (!m_islandIndices.empty())
+    {
+        m_nodes.reserve(2 * (m_islandIndices.size() / MAX_ISLANDS_PER_LEAF) + 1);
+        buildNode(islands, 0, m_islandIndices.size());
+
+        // boxes are stored in the leaf order so the leaf tests don't jump around the memory
+        m_islandBoxes.reserve(m_islandIndices.size());
+        for (const auto index : m_islandIndices)
+            m_islandBoxes.pushBack(islands[index].streamingBox);
+    }
+}
+
+void StreamingIslandTree::buildNode(const Array<StreamingIslandInfo>& islands, uint32_t first, uint32_t count)
+{
+    const auto nodeIndex = m_nodes.size();
+    m_nodes.emplaceBack();
+
+    Box bounds, centers;
+    bounds.clear();
+    centers.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto& box = islands[m_islandIndices[first + i]].streamingBox;
+        bounds.merge(box);
+        centers.merge(box.center());
+    }
+
+    m_nodes[nodeIndex].box = bounds;
+
+    if (count <= MAX_ISLANDS_PER_LEAF)
+    {
+        m_nodes[nodeIndex].first = first;
+        m_nodes[nodeIndex].count = count;
+        return;
+    }
+
+    // split at the median of the island centers along the longest axis
+    const auto extents = centers.size();
+    const int axis = (extents.x >= extents.y && extents.x >= extents.z) ? 0 : ((extents.y >= extents.z) ? 1 : 2);
+    const auto half = count / 2;
+
+    auto* indices = m_islandIndices.typedData() + first;
+    std::nth_element(indices, indices + half, indices + count, [&islands, axis](uint32_t a, uint32_t b)
+        {
+            return islands[a].streamingBox.center()[axis] < islands[b].streamingBox.center()[axis];
+        });
+
+    buildNode(islands, first, half);
+
+    m_nodes[nodeIndex].first = m_nodes.size();
+    buildNode(islands, first + half, count - half);
+}
+
+uint32_t StreamingIslandTree::collect(const Box& box, Array<uint32_t>& outIslands) const
+{
+    if (m_nodes.empty())
+        return 0;
+
+    uint32_t numTested = 0;
+
+    InplaceArray<uint32_t, 64> stack;
+    stack.pushBack(0);
+
+    while (!stack.empty())
+    {
+        const auto nodeIndex = stack.back();
+        const auto& node = m_nodes[nodeIndex];
+        stack.popBack();
+
+        if (!node.box.touches(box))
+            continue;
+
+        if (node.count)
+        {
+            const auto* islandBoxes = m_islandBoxes.typedData() + node.first;
+            for (uint32_t i = 0; i < node.count; ++i)
+                if (islandBoxes[i].touches(box))
+                    outIslands.pushBack(m_islandIndices[node.first + i]);
+
+            numTested += node.count;
+        }
+        else
+        {
+            stack.pushBack(node.first);
+            stack.pushBack(nodeIndex + 1);
+        }
+    }
+
+    return numTested;
+}
+
+///---
+
+StreamingTask::StreamingTask(const Array<StreamingObserverInfo>& observers, const StreamingTaskSettings& settings, const Array<StreamingIslandInfo>& islands, const StreamingIslandTree& tree, const Array<uint32_t>& attachedIslands, const BitSet<>& attachedIslandsMask, const RefPtr<StreamingIslandStages>& islandStages)
     : m_observers(observers)
+    , m_settings(settings)
     , m_attachedIslands(attachedIslands)
     , m_attachedIslandsMask(attachedIslandsMask)
     , m_islands(islands)
+    , m_tree(tree)
+    , m_islandStages(islandStages)
 {}
 
 void StreamingTask::requestCancel()
 {
-
+    m_canceled = true;
 }
 
-static bool CheckStreamingRange(const Array<StreamingObserverInfo>& observers, const Box& box)
+static float CalcStreamingDistance(const Array<StreamingObserverInfo>& observers, const Box& box)
 {
+    auto ret = VERY_LARGE_FLOAT;
+
     for (const auto& observer : observers)
-        if (box.contains(observer.position))
-            return true;
+    {
+        const auto closestPoint = Clamp(observer.position, box.min, box.max);
+        ret = std::min<float>(ret, closestPoint.squareDistance(observer.position));
+    }
 
-    return false;
+    return ret;
 }
 
 void StreamingTask::process()
@@ -59,33 +232,39 @@ void StreamingTask::process()
     PC_SCOPE_LVL0(WorldStreamingTask);
 
     // determine which islands are within streaming range
-    // TODO: split on fibers based on observer count + number of islands
     Array<uint32_t> islandsInRange;
     BitSet islandsInRangeMask;
     {
         PC_SCOPE_LVL0(FindIslandsInRange);
+        ScopeTimer findTimer;
+
         islandsInRangeMask.resizeWithZeros(m_islands.size());
-        islandsInRange.reserve(m_islands.size() / 4); // experimental
 
-        // TODO: extend the streaming box based on the projected velocity
+        // always loaded islands are not in the tree
+        for (const auto& island : m_islands)
+            if (island.alwaysLoaded)
+                islandsInRange.pushBack(island.index);
 
-        const auto* ptr = m_islands.typedData();
-        const auto* ptrEnd = ptr + m_islands.size();
-        uint32_t index = 0;
-        while (ptr < ptrEnd)
+        // observer covers the area it will move through in the near future
+        for (const auto& observer : m_observers)
         {
-            if (!islandsInRangeMask[index])
-            {
-                if (ptr->alwaysLoaded || CheckStreamingRange(m_observers, ptr->streamingBox))
-                {
-                    islandsInRangeMask.set(index);
-                    islandsInRange.pushBack(index);
-                }
-            }
+            const auto predictedPosition = observer.position + observer.velocity * m_settings.velocityPredictionTime;
+            const auto observerBox = Box(Min(observer.position, predictedPosition), Max(observer.position, predictedPosition));
+            m_stats.numIslandsTested += m_tree.collect(observerBox, islandsInRange);
+        }
 
-            ++ptr;
-            ++index;
+        // remove duplicates from overlapping observers
+        for (auto& index : islandsInRange)
+        {
+            if (islandsInRangeMask[index])
+                index = INDEX_MAX;
+            else
+                islandsInRangeMask.set(index);
         }
+
+        islandsInRange.removeAll(INDEX_MAX);
+        m_stats.numIslandsInRange = islandsInRange.size();
+        m_stats.findTime = findTimer.timeElapsed();
     }
 
     // any of the currently loaded islands that is not in range should be unloaded
@@ -110,34 +289,136 @@ void StreamingTask::process()
             }
         }
 
-        // TODO: optimize
         if (hadUnloadedIslands)
             m_attachedIslands.removeAll(INDEX_MAX);
+
+        m_stats.numIslandsUnloaded = m_unloadedIslands.size();
     }
 
-    // load new islands
-    // TODO: cancelation
-    // TODO: time budgeting (ie. 100ms etc of loading)
+    // order the islands to load: always loaded content first, then the closest islands
+    // NOTE: child island can't be loaded before the parent so it's never considered closer than the parent
+    Array<uint32_t> islandsToLoad;
     {
-        PC_SCOPE_LVL0(LoadIslands);
+        PC_SCOPE_LVL0(SortIslandsToLoad);
+
+        struct LoadOrder
+        {
+            float distance = 0.0f;
+            uint32_t depth = 0;
+        };
+
+        Array<LoadOrder> order;
+        order.resize(m_islands.size());
 
         for (const auto index : islandsInRange)
+            if (!m_attachedIslandsMask[index])
+                islandsToLoad.pushBack(index);
+
+        // islands are stored with parents before children
+        std::sort(islandsToLoad.begin(), islandsToLoad.end());
+        for (const auto index : islandsToLoad)
         {
-            const auto& islandInfo = m_islands.typedData()[index];
+            const auto& islandInfo = m_islands[index];
+            auto& entry = order[index];
+            entry.distance = islandInfo.alwaysLoaded ? 0.0f : CalcStreamingDistance(m_observers, islandInfo.streamingBox);
 
-            if (!m_attachedIslandsMask[index]) // island is not currently attached
+            if (islandInfo.parent)
             {
-                // make sure parent island is properly attached - without it we can't load the inner data
-                if (islandInfo.parent)
-                    if (!m_attachedIslandsMask[islandInfo.parentIndex])
-                        continue;
-
-                // load the island data
-                ScopeTimer islandLoadTimer;
-                if (const auto instance = islandInfo.data->load(GlobalLoader()))
-                {
-                    TRACE_INFO("Instanced island '{}', {} entitie(s) in {}", index, instance->size(), islandLoadTimer);
+                entry.distance = std::max<float>(entry.distance, order[islandInfo.parentIndex].distance);
+                entry.depth = order[islandInfo.parentIndex].depth + 1;
+            }
+        }
+
+        std::stable_sort(islandsToLoad.begin(), islandsToLoad.end(), [&order](uint32_t a, uint32_t b)
+            {
+                if (order[a].distance != order[b].distance)
+                    return order[a].distance < order[b].distance;
+                return order[a].depth < order[b].depth;
+            });
+    }
+
+    // load new islands, as many as we can in the time budget
+    // islands are unpacked and instanced in parallel, child islands are loaded in the next wave after their parents
+    {
+        PC_SCOPE_LVL0(LoadIslands);
+        ScopeTimer loadTimer;
 
+        const auto budgetExceeded = [this, &loadTimer]()
+        {
+            return m_canceled || (m_settings.loadTimeBudget > 0.0 && loadTimer.timeElapsed() > m_settings.loadTimeBudget);
+        };
+
+        BitSet<> islandsVisitedMask;
+        islandsVisitedMask.resizeWithZeros(m_islands.size());
+
+        Array<uint32_t> wave;
+        Array<StreamingIslandInstancePtr> waveInstances;
+        Array<uint8_t> waveSkipped;
+        for (;;)
+        {
+            // collect islands that can be loaded now - without the parent island we can't load the inner data
+            wave.reset();
+            for (const auto index : islandsToLoad)
+            {
+                if (islandsVisitedMask[index])
+                    continue;
+
+                const auto& islandInfo = m_islands.typedData()[index];
+                if (islandInfo.parent && !m_attachedIslandsMask[islandInfo.parentIndex])
+                    continue;
+
+                islandsVisitedMask.set(index);
+                wave.pushBack(index);
+                SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Queued);
+            }
+
+            if (wave.empty())
+                break;
+
+            waveInstances.reset();
+            waveInstances.resize(wave.size());
+            waveSkipped.reset();
+            waveSkipped.resizeWith(wave.size(), 0);
+
+            RunFiberLoop("LoadStreamingIsland", wave.size(), -1, [this, &wave, &waveInstances, &waveSkipped, &budgetExceeded](uint32_t i)
+                {
+                    const auto index = wave[i];
+                    const auto& islandInfo = m_islands.typedData()[index];
+
+                    // stop if there's no more time, remaining islands will be loaded by next task
+                    if (budgetExceeded())
+                    {
+                        SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Unloaded);
+                        waveSkipped[i] = 1;
+                        return;
+                    }
+
+                    ScopeTimer islandLoadTimer;
+
+                    SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Unpacking);
+                    if (const auto data = islandInfo.data->unpack())
+                    {
+                        SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Instancing);
+                        waveInstances[i] = islandInfo.data->instance(data, GlobalLoader());
+                    }
+
+                    if (waveInstances[i])
+                    {
+                        TRACE_INFO("Instanced island '{}', {} entitie(s) in {}", index, waveInstances[i]->size(), islandLoadTimer);
+                        SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Loaded);
+                    }
+                    else
+                    {
+                        SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Unloaded);
+                    }
+                });
+
+            // collect the results in order
+            for (auto i : wave.indexRange())
+            {
+                const auto index = wave[i];
+                if (const auto& instance = waveInstances[i])
+                {
                     // island was loaded properly, add it to the list attached islands
                     m_attachedIslandsMask.set(index);
                     m_attachedIslands.pushBack(index);
@@ -146,8 +427,15 @@ void StreamingTask::process()
                     m_loadedIslands.pushBack(index);
                     m_loadedIslandsData.pushBack(instance);
                 }
+                else if (waveSkipped[i])
+                {
+                    m_stats.numIslandsPostponed += 1;
+                }
             }
         }
+
+        m_stats.numIslandsLoaded = m_loadedIslands.size();
+        m_stats.loadTime = loadTimer.timeElapsed();
     }
 }
 
@@ -161,7 +449,13 @@ StreamingSystem::StreamingSystem()
 }
 
 StreamingSystem::~StreamingSystem()
-{}
+{
+}
+
+StreamingIslandStage StreamingSystem::islandStage(uint32_t index) const
+{
+    return GetIslandStage(m_islandStages.get(), index);
+}
 
 void StreamingSystem::unbindEntities()
 {
@@ -181,11 +475,13 @@ void StreamingSystem::unbindEntities()
             }
 
             m_attachedIslandsMask.clear(index);
+            SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Unloaded);
         }
     }
 
     m_attachedIslandsMask.clearAll();
     m_attachedIslands.clear();
+    m_pendingIslands.clear();
 }
 
 void StreamingSystem::handleShutdown()
@@ -194,6 +490,21 @@ void StreamingSystem::handleShutdown()
     unbindEntities();
 }
 
+void StreamingSystem::handlePreTick(double dt)
+{
+    TBaseClass::handlePreTick(dt);
+
+    // continue attaching islands that did not fit in the budget
+    if (!m_pendingIslands.empty())
+    {
+        m_stats.numIslandsAttached = 0;
+        m_stats.numIslandsDetached = 0;
+        m_stats.numEntitiesAttached = 0;
+        m_stats.attachTime = 0.0;
+        attachPendingIslands(std::max<float>(0.0f, cvStreamingAttachTimeBudgetMS.get()) / 1000.0, cvStreamingAttachEntityBudget.get());
+    }
+}
+
 static uint32_t CountIslands(StreamingIsland* island)
 {
     uint32_t ret = 1;
@@ -220,6 +531,7 @@ static void ExtractIslands(StreamingIslandInfo* extarctedIslands, uint32_t& inde
     entry.parent = parent;
     entry.parentIndex = parent ? parent->index : 0;
     entry.data = AddRef(data);
+    entry.alwaysLoaded = data->alwaysLoaded();
 
     entry.streamingBox = data->streamingBounds();
 
@@ -243,6 +555,10 @@ void StreamingSystem::bindScene(const CompiledScene* scene)
     m_islandInstances.clear();
     m_attachedIslands.clear();
     m_attachedIslandsMask.clear();
+    m_pendingIslands.clear();
+    m_islandTree.clear();
+
+    m_islandStages.reset();
 
     // bind new data
     if (scene)
@@ -253,24 +569,30 @@ void StreamingSystem::bindScene(const CompiledScene* scene)
         m_attachedIslands.reserve(numIslands);
         m_attachedIslandsMask.resizeWithZeros(numIslands);
 
+        m_islandStages = RefNew<StreamingIslandStages>(numIslands);
+
         uint32_t index = 0;
         for (const auto& rootIsland : scene->rootIslands())
             ExtractIslands(m_islands.typedData(), index, nullptr, rootIsland);
+
+        m_islandTree.build(m_islands);
     }
 }
 
-RefPtr<StreamingTask> StreamingSystem::createStreamingTask(const Array<StreamingObserverInfo>& observers) const
+RefPtr<StreamingTask> StreamingSystem::createStreamingTask(const Array<StreamingObserverInfo>& observers, const StreamingTaskSettings& settings) const
 {
-    return RefNew<StreamingTask>(observers, m_islands, m_attachedIslands, m_attachedIslandsMask);
+    return RefNew<StreamingTask>(observers, settings, m_islands, m_islandTree, m_attachedIslands, m_attachedIslandsMask, m_islandStages);
 }
 
 void StreamingSystem::applyStreamingTask(const StreamingTask* task)
 {
     PC_SCOPE_LVL0(ApplyStreamingTask);
 
-    // TODO: time budgets for detach/attach
     // TODO: flags like "don't unload"
 
+    // take the stats of the finished task, attach/detach stats are filled below
+    m_stats = task->stats();
+
     // unload/detach first
     // NOTE: this might release resources
     uint32_t numDetachedIslands = 0;
@@ -291,44 +613,90 @@ void StreamingSystem::applyStreamingTask(const StreamingTask* task)
             }
 
             m_attachedIslandsMask.clear(index);
+            SetIslandStage(m_islandStages.get(), index, StreamingIslandStage::Unloaded);
             numDetachedIslands += 1;
         }
-    }
-
-    // attach newcomers
-    uint32_t numAttachedIslands = 0;
-    {
-        PC_SCOPE_LVL1(AttachIslands);
 
-        for (auto i : task->m_loadedIslands.indexRange())
+        // islands that were waiting for attachment are just dropped, partially attached island was detached above
+        if (!task->m_unloadedIslands.empty() && !m_pendingIslands.empty())
         {
-            auto index = task->m_loadedIslands[i];
-            auto data = task->m_loadedIslandsData[i];
-
-            DEBUG_CHECK_EX(!m_attachedIslandsMask[index], "Island marked as attached");
-            DEBUG_CHECK_EX(!m_islandInstances[index], "Island already has data");
+            for (auto i : m_pendingIslands.indexRange().reversed())
+                if (!m_attachedIslandsMask[m_pendingIslands[i].index])
+                    m_pendingIslands.erase(i);
+        }
+    }
 
-            if (!m_islandInstances[index])
-            {
-                //DEBUG_CHECK(!m_islandInstances.contains(data));
-                m_islandInstances[index] = data;
-                data->attach(world());
-            }
+    // queue newcomers, they are attached in the order they were loaded (parents before children)
+    for (auto i : task->m_loadedIslands.indexRange())
+    {
+        auto& entry = m_pendingIslands.emplaceBack();
+        entry.index = task->m_loadedIslands[i];
+        entry.data = task->m_loadedIslandsData[i];
+        SetIslandStage(m_islandStages.get(), entry.index, StreamingIslandStage::PendingAttach);
 
-            m_attachedIslandsMask.set(index);
-            numAttachedIslands += 1;
-        }
+        DEBUG_CHECK_EX(!m_attachedIslandsMask[entry.index], "Island marked as attached");
+        DEBUG_CHECK_EX(!m_islandInstances[entry.index], "Island already has data");
     }
 
-    // update internal state
+    // update internal state, pending islands are considered attached already
     m_attachedIslands = task->m_attachedIslands;
     m_attachedIslandsMask = task->m_attachedIslandsMask;       
 
+    // attach as much as we can in the budget
+    m_stats.numIslandsDetached = numDetachedIslands;
+    attachPendingIslands(std::max<float>(0.0f, cvStreamingAttachTimeBudgetMS.get()) / 1000.0, cvStreamingAttachEntityBudget.get());
+
     // stats
-    if (numAttachedIslands || numDetachedIslands)
+    if (m_stats.numIslandsAttached || numDetachedIslands)
+    {
+        TRACE_INFO("Streaming: attached {}, detached {} (current {}, pending {}) islands", m_stats.numIslandsAttached, numDetachedIslands, m_attachedIslands.size(), m_pendingIslands.size());
+    }
+}
+
+void StreamingSystem::attachPendingIslands(double timeBudget, uint32_t entityBudget)
+{
+    PC_SCOPE_LVL1(AttachIslands);
+
+    ScopeTimer timer;
+
+    // the time budget is checked after every entity, a single big island can't blow the frame
+    NativeTimePoint deadline;
+    if (timeBudget > 0.0)
+        deadline = NativeTimePoint::Now() + timeBudget;
+
+    // island are attached in slices, always attach at least something so we make progress
+    const auto maxEntities = entityBudget ? entityBudget : std::numeric_limits<uint32_t>::max();
+    uint32_t numEntitiesLeft = maxEntities;
+
+    uint32_t numAttachedIslands = 0;
+    while (numAttachedIslands < m_pendingIslands.size() && numEntitiesLeft)
     {
-        TRACE_INFO("Streaming: attached {}, detached {} (current {}) islands", numAttachedIslands, numDetachedIslands, m_attachedIslands.size());
+        if (numEntitiesLeft != maxEntities && deadline && deadline.reached())
+            break;
+
+        const auto& entry = m_pendingIslands[numAttachedIslands];
+        DEBUG_CHECK_EX(m_attachedIslandsMask[entry.index], "Pending island not marked as attached");
+        DEBUG_CHECK_EX(!m_islandInstances[entry.index] || m_islandInstances[entry.index] == entry.data, "Island already has different data");
+
+        // once we start attaching the island it's visible as instanced so it can be detached
+        m_islandInstances[entry.index] = entry.data;
+        SetIslandStage(m_islandStages.get(), entry.index, StreamingIslandStage::Attaching);
+
+        // attach next slice, if not finished we will continue next frame
+        if (!entry.data->attach(world(), numEntitiesLeft, deadline))
+            break;
+
+        SetIslandStage(m_islandStages.get(), entry.index, StreamingIslandStage::Attached);
+        numAttachedIslands += 1;
     }
+
+    if (numAttachedIslands)
+        m_pendingIslands.erase(0, numAttachedIslands);
+
+    m_stats.numIslandsAttached += numAttachedIslands;
+    m_stats.numIslandsPendingAttach = m_pendingIslands.size();
+    m_stats.numEntitiesAttached += maxEntities - numEntitiesLeft;
+    m_stats.attachTime += timer.timeElapsed();
 }
 
 //--
@@ -13,6 +13,8 @@
 #include "entity.h"
 #include "prefab.h"
 #include "path.h"
+#include "streamingSystem.h"
+#include "streamingIsland.h"
 
 #include "engine/imgui/include/imgui.h"
 
@@ -110,8 +112,7 @@ void World::updatePreTick(double dt, WorldStats& outStats)
         PC_SCOPE_LVL1(PreTickEntitesMain);
 
         ScopeTimer timer;
-        for (const auto& ent : m_entities.keys())
-            ent->handlePreTick(dt);
+        outStats.numPreTickParallelEntites = tickEntities([dt](Entity* ent) { ent->handlePreTick(dt); }, outStats);
 
         outStats.preTickEntityTime = timer.timeElapsed();
         outStats.numPreTickEntites = m_entities.size();
@@ -168,8 +169,7 @@ void World::updatePostTick(double dt, WorldStats& outStats)
         PC_SCOPE_LVL1(PostTickSystems);
 
         ScopeTimer timer;
-        for (const auto& ent : m_entities.keys())
-            ent->handlePostTick(dt);
+        outStats.numPostTickParallelEntites = tickEntities([dt](Entity* ent) { ent->handlePostTick(dt); }, outStats);
 
         outStats.numPostTickEntites = m_entities.size();
         outStats.postTickEntityTime = timer.timeElapsed();
@@ -190,6 +190,226 @@ void World::updatePostTick(double dt, WorldStats& outStats)
     serviceTransformRequests(outStats); // last update before render
 }
 
+static ConfigProperty<bool> cvTickParallel("World.Tick", "Parallel", true);
+static ConfigProperty<uint32_t> cvTickParallelMinEntities("World.Tick", "ParallelMinEntities", 64);
+static ConfigProperty<uint32_t> cvTickParallelBatchSize("World.Tick", "ParallelBatchSize", 32);
+
+static const uint32_t MAX_TICK_LEVELS = 8;
+
+void World::buildTickSchedule()
+{
+    PC_SCOPE_LVL1(BuildTickSchedule);
+
+    auto& schedule = m_tickSchedule;
+    schedule.serialEntities.reset();
+    schedule.parallelEntities.reset();
+    schedule.overflowEntities.reset();
+    schedule.levelOffsets.reset();
+
+    const auto allowParallel = cvTickParallel.get();
+
+    // where each entity ticks: 0..MAX_TICK_LEVELS-1 is the parallel level, the rest are the serial passes before and after the levels
+    static const uint8_t SLOT_NONE = 0xFE; // no dependency to wait for
+    static const uint8_t SLOT_PENDING = 0xFF; // being resolved, reaching it again means a cycle
+    static const uint8_t SLOT_SERIAL = MAX_TICK_LEVELS;
+    static const uint8_t SLOT_OVERFLOW = MAX_TICK_LEVELS + 1;
+
+    HashMap<Entity*, uint8_t> entitySlots;
+    entitySlots.reserve(m_entities.size());
+
+    InplaceArray<Entity*, 256> parallelEntities;
+    InplaceArray<uint8_t, 256> parallelLevels;
+    InplaceArray<Entity*, 64> chain;
+    uint32_t levelCounts[MAX_TICK_LEVELS];
+    memzero(levelCounts, sizeof(levelCounts));
+
+    for (const auto& ent : m_entities.keys())
+    {
+        if (entitySlots.contains(ent.get()))
+            continue;
+
+        // follow the dependencies until we reach entity that was already placed (or there are no more dependencies)
+        // NOTE: reaching entity from the same chain means a cycle, it's broken there and the whole chain goes to the overflow pass
+        chain.reset();
+        uint8_t dependencySlot = SLOT_NONE;
+        for (auto* cur = ent.get(); cur; )
+        {
+            chain.pushBack(cur);
+            entitySlots[cur] = SLOT_PENDING;
+
+            const auto dependency = cur->m_tickAfter.lock();
+            if (!dependency || dependency->m_world != this)
+                break;
+
+            if (const auto* slot = entitySlots.find(dependency.get()))
+            {
+                dependencySlot = (*slot == SLOT_PENDING) ? SLOT_OVERFLOW : *slot;
+                break;
+            }
+
+            cur = dependency.get();
+        }
+
+        // place the chain starting from the entity with no dependencies, each entity ticks after the previous one:
+        //  - serial entities tick before the levels unless they depend on entity from the levels, then they go to the overflow pass
+        //  - parallel entities are one level after the parallel entity they depend on, long chains go to the overflow pass
+        //  - anything that depends on the overflow pass is in the overflow pass as well
+        // NOTE: serial and overflow entities are added in the dependency order
+        for (int i = chain.lastValidIndex(); i >= 0; --i)
+        {
+            auto* chainEnt = chain[i];
+
+            uint8_t slot = SLOT_OVERFLOW;
+            if (!allowParallel || !chainEnt->m_flags.test(EntityFlagBit::ParallelTick))
+                slot = (dependencySlot == SLOT_NONE || dependencySlot == SLOT_SERIAL) ? SLOT_SERIAL : SLOT_OVERFLOW;
+            else if (dependencySlot == SLOT_NONE || dependencySlot == SLOT_SERIAL)
+                slot = 0;
+            else if (dependencySlot + 1 < MAX_TICK_LEVELS)
+                slot = dependencySlot + 1;
+
+            entitySlots[chainEnt] = slot;
+            dependencySlot = slot;
+
+            if (slot == SLOT_SERIAL)
+            {
+                schedule.serialEntities.pushBack(chainEnt);
+            }
+            else if (slot == SLOT_OVERFLOW)
+            {
+                schedule.overflowEntities.pushBack(chainEnt);
+            }
+            else
+            {
+                parallelEntities.pushBack(chainEnt);
+                parallelLevels.pushBack(slot);
+                levelCounts[slot] += 1;
+            }
+        }
+    }
+
+    // sort entities by level
+    if (!parallelEntities.empty())
+    {
+        schedule.levelOffsets.resize(MAX_TICK_LEVELS + 1);
+        schedule.levelOffsets[0] = 0;
+        for (uint32_t i = 0; i < MAX_TICK_LEVELS; ++i)
+            schedule.levelOffsets[i + 1] = schedule.levelOffsets[i] + levelCounts[i];
+
+        uint32_t writeOffsets[MAX_TICK_LEVELS];
+        memcpy(writeOffsets, schedule.levelOffsets.typedData(), sizeof(writeOffsets));
+
+        schedule.parallelEntities.resize(parallelEntities.size());
+        for (auto i : parallelEntities.indexRange())
+            schedule.parallelEntities[writeOffsets[parallelLevels[i]]++] = parallelEntities[i];
+    }
+}
+
+uint32_t World::tickEntities(const std::function<void(Entity*)>& func, WorldStats& outStats)
+{
+    buildTickSchedule();
+
+    const auto& schedule = m_tickSchedule;
+
+    // entities that did not opt in (and don't wait for parallel entities) are ticked first
+    for (auto* ent : schedule.serialEntities)
+        func(ent);
+
+    // parallel entities are ticked level by level, entities on one level don't depend on each other
+    uint32_t numParallelEntities = 0;
+    if (!schedule.parallelEntities.empty())
+    {
+        PC_SCOPE_LVL1(ParallelTick);
+
+        const auto minEntities = cvTickParallelMinEntities.get();
+        const auto batchSize = std::max<uint32_t>(1, cvTickParallelBatchSize.get());
+
+        for (uint32_t level = 0; level < MAX_TICK_LEVELS; ++level)
+        {
+            const auto first = schedule.levelOffsets[level];
+            const auto count = schedule.levelOffsets[level + 1] - first;
+            if (!count)
+                continue;
+
+            const auto* entities = schedule.parallelEntities.typedData() + first;
+            if (count >= minEntities && count > batchSize)
+            {
+                m_parallelTickRegion = true;
+
+                const auto numBatches = (count + batchSize - 1) / batchSize;
+                RunFiberLoop("TickEntities", numBatches, -1, [&func, entities, count, batchSize](uint32_t batchIndex)
+                    {
+                        const auto batchFirst = batchIndex * batchSize;
+                        const auto batchLast = std::min<uint32_t>(batchFirst + batchSize, count);
+                        for (uint32_t i = batchFirst; i < batchLast; ++i)
+                            func(entities[i]);
+                    });
+
+                m_parallelTickRegion = false;
+                numParallelEntities += count;
+
+                // apply world changes before next level so it can see them
+                applyDeferredEntityCommands(outStats);
+            }
+            else
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    func(entities[i]);
+            }
+        }
+    }
+
+    for (auto* ent : schedule.overflowEntities)
+        func(ent);
+
+    return numParallelEntities;
+}
+
+bool World::deferEntityCommand(DeferredEntityCommand::Type type, Entity* entity, const AbsoluteTransform* transform)
+{
+    if (!m_parallelTickRegion)
+        return false;
+
+    auto lock = CreateLock(m_deferredCommandsLock);
+
+    auto& command = m_deferredCommands.emplaceBack();
+    command.type = type;
+    command.entity = AddRef(entity);
+    if (transform)
+        command.transform = *transform;
+
+    return true;
+}
+
+void World::applyDeferredEntityCommands(WorldStats& outStats)
+{
+    DEBUG_CHECK_EX(!m_parallelTickRegion, "Deferred commands can only be applied on main thread");
+
+    auto commands = std::move(m_deferredCommands);
+    for (const auto& command : commands)
+    {
+        switch (command.type)
+        {
+            case DeferredEntityCommand::Type::Attach:
+                attachEntity(command.entity.get());
+                break;
+
+            case DeferredEntityCommand::Type::Detach:
+                detachEntity(command.entity.get());
+                break;
+
+            case DeferredEntityCommand::Type::TransformUpdate:
+                command.entity->requestTransformUpdate();
+                break;
+
+            case DeferredEntityCommand::Type::Transform:
+                command.entity->requestTransform(command.transform);
+                break;
+        }
+    }
+
+    outStats.numDeferredCommands += commands.size();
+}
+
 void World::destroyEntities()
 {
     DEBUG_CHECK(m_removedEntities.empty());
@@ -239,11 +459,14 @@ void World::attachEntity(Entity* entity)
     DEBUG_CHECK_EX(entity, "Invalid entity");
     if (entity)
     {
+        if (deferEntityCommand(DeferredEntityCommand::Type::Attach, entity))
+            return;
+
         ASSERT_EX(!entity->attached(), "Entity already attached");
         ASSERT_EX(entity->world() == nullptr, "Entity already owned by some world");
         ASSERT_EX(!m_entities.contains(entity), "Entity already registered");
 
-        entity->handleTransformUpdate(entity->absoluteTransform()); // calculate initial positions
+        entity->handleTransformUpdate(entity->absoluteTransform(), entity->absoluteTransform().approximate()); // calculate initial positions
 
         if (m_protectedEntityRegion)
         {
@@ -263,6 +486,9 @@ void World::detachEntity(Entity* entity)
     DEBUG_CHECK_EX(entity, "Invalid entity");
     if (entity)
     {
+        if (deferEntityCommand(DeferredEntityCommand::Type::Detach, entity))
+            return;
+
         ASSERT_EX(entity->attached(), "Entity not attached");
         ASSERT_EX(entity->world() == this, "Entity not owned by this world");
         ASSERT_EX(m_entities.contains(entity), "Entity not registered");
@@ -589,6 +815,9 @@ static T& SwapMaps(T& a, T& b)
     return b;
 }
 
+static ConfigProperty<uint32_t> cvTransformParallelMinEntities("World.Transform", "ParallelMinEntities", 256);
+static ConfigProperty<uint32_t> cvTransformParallelBatchSize("World.Transform", "ParallelBatchSize", 128);
+
 void World::serviceTransformRequests(WorldStats& outStats)
 {
     PC_SCOPE_LVL1(TransformEntities);
@@ -599,26 +828,96 @@ void World::serviceTransformRequests(WorldStats& outStats)
     {
         ScopeTimer timer;
 
-        for (auto* token : requests.values())
+        auto& batch = m_transformBatch;
+
+        // collect entities that are still alive into the batch
         {
-            // apply the transform update
-            if (auto actualEntity = token->entity.lock())
+            PC_SCOPE_LVL1(GatherTransforms);
+            ScopeTimer gatherTimer;
+
+            batch.entities.reserve(requests.size());
+            batch.transforms.reserve(requests.size());
+
+            for (auto* token : requests.values())
             {
-                if (token->hasNewTransform)
-                    actualEntity->handleTransformUpdate(token->newTransform);
-                else
-                    actualEntity->handleTransformUpdate(actualEntity->absoluteTransform());
+                if (auto actualEntity = token->entity.lock())
+                {
+                    if (actualEntity->m_flags.test(EntityFlagBit::SerialTransformUpdate))
+                        batch.serialEntities.pushBack(batch.entities.size());
+
+                    batch.transforms.pushBack(token->hasNewTransform ? token->newTransform : actualEntity->absoluteTransform());
+                    batch.entities.pushBack(std::move(actualEntity));
+                }
+
+                // release token back to pool
+                m_transformRequetsPool.free(token);
             }
 
-            // release token back to pool
-            m_transformRequetsPool.free(token);
+            batch.localToWorld.resize(batch.entities.size());
+
+            requests.reset();
+
+            outStats.transformGatherTime += gatherTimer.timeElapsed();
+        }
+
+        // compute matrices and update entities that can be updated outside main thread
+        {
+            PC_SCOPE_LVL1(ComputeTransforms);
+            ScopeTimer parallelTimer;
+
+            const auto updateRange = [&batch](uint32_t first, uint32_t last)
+            {
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    batch.localToWorld[i] = batch.transforms[i].approximate();
+
+                    auto* entity = batch.entities[i].get();
+                    if (!entity->m_flags.test(EntityFlagBit::SerialTransformUpdate))
+                        entity->handleTransformUpdate(batch.transforms[i], batch.localToWorld[i]);
+                }
+            };
+
+            const auto numEntities = batch.entities.size();
+            const auto batchSize = std::max<uint32_t>(1, cvTransformParallelBatchSize.get());
+            if (numEntities >= cvTransformParallelMinEntities.get() && numEntities > batchSize)
+            {
+                const auto numBatches = (numEntities + batchSize - 1) / batchSize;
+                RunFiberLoop("TransformEntities", numBatches, -1, [&updateRange, numEntities, batchSize](uint32_t batchIndex)
+                    {
+                        const auto first = batchIndex * batchSize;
+                        updateRange(first, std::min<uint32_t>(first + batchSize, numEntities));
+                    });
+            }
+            else
+            {
+                updateRange(0, numEntities);
+            }
+
+            outStats.transformParallelTime += parallelTimer.timeElapsed();
+        }
+
+        // update entities that must be updated on main thread
+        if (!batch.serialEntities.empty())
+        {
+            PC_SCOPE_LVL1(SerialTransforms);
+            ScopeTimer serialTimer;
+
+            for (const auto index : batch.serialEntities)
+                batch.entities[index]->handleTransformUpdate(batch.transforms[index], batch.localToWorld[index]);
+
+            outStats.numTransformUpdateSerialEntities += batch.serialEntities.size();
+            outStats.transformSerialTime += serialTimer.timeElapsed();
         }
 
         outStats.numTransformUpdateBaches += 1;
-        outStats.numTransformUpdateEntities += requests.size();
+        outStats.numTransformUpdateEntities += batch.entities.size();
         outStats.transformUpdateTime += timer.timeElapsed();
 
-        requests.reset();
+        // keep the memory for next batch
+        batch.entities.reset();
+        batch.transforms.reset();
+        batch.localToWorld.reset();
+        batch.serialEntities.reset();
     }
 }
 
@@ -642,10 +941,13 @@ static void RenderWorldStats(const WorldStats& stats)
 
     ImGui::Text("Transform update: %u baches (%u entities)", stats.numTransformUpdateBaches, stats.numTransformUpdateEntities);
     ImGui::Text("Transform time: %d [us]", (int)(stats.transformUpdateTime * 1000000.0));
+    ImGui::Text("  Gather: %d [us]", (int)(stats.transformGatherTime * 1000000.0));
+    ImGui::Text("  Parallel: %d [us]", (int)(stats.transformParallelTime * 1000000.0));
+    ImGui::Text("  Serial: %d [us] (%u entities)", (int)(stats.transformSerialTime * 1000000.0), stats.numTransformUpdateSerialEntities);
 
     ImGui::Separator();
 
-    ImGui::Text("PreTick: %u entities", stats.numPreTickEntites);
+    ImGui::Text("PreTick: %u entities (%u parallel)", stats.numPreTickEntites, stats.numPreTickParallelEntites);
     ImGui::Text("PreTick system time: %u [us]", (int)(stats.preTickSystemTime * 1000000.0));
     ImGui::Text("PreTick entity time: %u [us]", (int)(stats.preTickEntityTime * 1000000.0));
     ImGui::Text("PreTick fixup time: %u [us] (%u loops)", (int)(stats.preTickFixupTime * 1000000.0), stats.numPreTickLoops);
@@ -656,9 +958,85 @@ static void RenderWorldStats(const WorldStats& stats)
 
     ImGui::Separator();
 
-    ImGui::Text("PostTick: %u entities", stats.numPostTickEntites);
+    ImGui::Text("PostTick: %u entities (%u parallel)", stats.numPostTickEntites, stats.numPostTickParallelEntites);
     ImGui::Text("PostTick system time: %u [us]", (int)(stats.postTickSystemTime * 1000000.0));
     ImGui::Text("PostTick entity time: %u [us]", (int)(stats.postTickEntityTime * 1000000.0));
+
+    ImGui::Separator();
+
+    ImGui::Text("Deferred commands: %u", stats.numDeferredCommands);
+}
+
+static ConfigProperty<bool> cvDebugPageWorldStreaming("DebugPage.World.Streaming", "IsVisible", false);
+
+static void RenderStreamingStats(const StreamingStats& stats)
+{
+    ImGui::Text("Islands tested: %u (%u in range)", stats.numIslandsTested, stats.numIslandsInRange);
+    ImGui::Text("Find time: %d [us]", (int)(stats.findTime * 1000000.0));
+
+    ImGui::Separator();
+
+    ImGui::Text("Islands loaded: %u", stats.numIslandsLoaded);
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1, 0, 0, 1), "  (-%u)", stats.numIslandsUnloaded);
+    ImGui::Text("Islands postponed: %u", stats.numIslandsPostponed);
+    ImGui::Text("Load time: %d [ms]", (int)(stats.loadTime * 1000.0));
+
+    ImGui::Separator();
+
+    ImGui::Text("Islands attached: %u", stats.numIslandsAttached);
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1, 0, 0, 1), "  (-%u)", stats.numIslandsDetached);
+    ImGui::Text("Islands waiting for attach: %u", stats.numIslandsPendingAttach);
+    ImGui::Text("Entities attached: %u", stats.numEntitiesAttached);
+    ImGui::Text("Attach time: %d [us]", (int)(stats.attachTime * 1000000.0));
+}
+
+static const char* StreamingIslandStageName(StreamingIslandStage stage)
+{
+    switch (stage)
+    {
+        case StreamingIslandStage::Unloaded: return "Unloaded";
+        case StreamingIslandStage::Queued: return "Queued";
+        case StreamingIslandStage::Unpacking: return "Unpacking";
+        case StreamingIslandStage::Instancing: return "Instancing";
+        case StreamingIslandStage::Loaded: return "Loaded";
+        case StreamingIslandStage::PendingAttach: return "PendingAttach";
+        case StreamingIslandStage::Attaching: return "Attaching";
+        case StreamingIslandStage::Attached: return "Attached";
+    }
+
+    return "Unknown";
+}
+
+static void RenderStreamingIslandStages(const StreamingSystem& streaming)
+{
+    static const uint32_t NUM_STAGES = (uint32_t)StreamingIslandStage::Attached + 1;
+
+    uint32_t stageCounts[NUM_STAGES];
+    memzero(stageCounts, sizeof(stageCounts));
+
+    for (uint32_t i = 0; i < streaming.islandCount(); ++i)
+        stageCounts[(uint32_t)streaming.islandStage(i)] += 1;
+
+    for (uint32_t i = 0; i < NUM_STAGES; ++i)
+        ImGui::Text("%s: %u", StreamingIslandStageName((StreamingIslandStage)i), stageCounts[i]);
+
+    // islands that are somewhere in the pipeline
+    if (ImGui::CollapsingHeader("Islands in flight"))
+    {
+        for (uint32_t i = 0; i < streaming.islandCount(); ++i)
+        {
+            const auto stage = streaming.islandStage(i);
+            if (stage == StreamingIslandStage::Unloaded || stage == StreamingIslandStage::Attached)
+                continue;
+
+            if (const auto* instance = streaming.islandInstance(i))
+                ImGui::Text("[%u]: %s (%u/%u)", i, StreamingIslandStageName(stage), instance->numAttached(), instance->size());
+            else
+                ImGui::Text("[%u]: %s", i, StreamingIslandStageName(stage));
+        }
+    }
 }
 
 void World::renderDebugGui()
@@ -668,6 +1046,20 @@ void World::renderDebugGui()
         RenderWorldStats(m_stats);
         ImGui::End();
     }
+
+    if (cvDebugPageWorldStreaming.get())
+    {
+        if (const auto* streaming = system<StreamingSystem>())
+        {
+            if (ImGui::Begin("World streaming"))
+            {
+                RenderStreamingStats(streaming->stats());
+                ImGui::Separator();
+                RenderStreamingIslandStages(*streaming);
+                ImGui::End();
+            }
+        }
+    }
 }
 
 //---
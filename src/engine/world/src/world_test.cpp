@@ -0,0 +1,213 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+
+#include "world.h"
+#include "entity.h"
+
+DECLARE_TEST_FILE(World);
+
+BEGIN_BOOMER_NAMESPACE_EX(test)
+
+static std::atomic<uint32_t> GTickCounter = 0;
+
+/// entity that remembers when it was ticked
+class TickOrderTestEntity : public Entity
+{
+    RTTI_DECLARE_VIRTUAL_CLASS(TickOrderTestEntity, Entity);
+
+public:
+    uint32_t preTickIndex = 0;
+    uint32_t postTickIndex = 0;
+
+    EntityPtr entityToAttach; // attached to the world from the pre tick
+
+    bool moveDuringTick = false;
+
+    void setup(bool parallel, Entity* after = nullptr)
+    {
+        parallelTick(parallel);
+        if (after)
+            tickAfter(after);
+    }
+
+    virtual void handlePreTick(float dt) override
+    {
+        preTickIndex = ++GTickCounter;
+
+        if (entityToAttach)
+        {
+            auto entity = std::move(entityToAttach);
+            world()->attachEntity(entity.get());
+        }
+
+        if (moveDuringTick)
+            requestTransform(AbsoluteTransform(AbsolutePosition(10.0, 0.0, 0.0)));
+    }
+
+    virtual void handlePostTick(float dt) override
+    {
+        postTickIndex = ++GTickCounter;
+    }
+};
+
+RTTI_BEGIN_TYPE_CLASS(TickOrderTestEntity);
+RTTI_END_TYPE();
+
+typedef RefPtr<TickOrderTestEntity> TickOrderTestEntityPtr;
+
+static TickOrderTestEntityPtr CreateTestEntity(World* world, bool parallel, Entity* after = nullptr)
+{
+    auto entity = RefNew<TickOrderTestEntity>();
+    entity->setup(parallel, after);
+    world->attachEntity(entity.get());
+    return entity;
+}
+
+static void ExpectTickedAfter(const TickOrderTestEntity* entity, const TickOrderTestEntity* dependency)
+{
+    EXPECT_LT(dependency->preTickIndex, entity->preTickIndex);
+    EXPECT_LT(dependency->postTickIndex, entity->postTickIndex);
+}
+
+//--
+
+TEST(World, ParallelTickRespectsTickAfter)
+{
+    auto world = RefNew<World>();
+
+    // enough independent entities to use the worker fibers
+    Array<TickOrderTestEntityPtr> independentEntities;
+    for (uint32_t i = 0; i < 200; ++i)
+        independentEntities.pushBack(CreateTestEntity(world.get(), true));
+
+    // long chain, the end of it does not fit into the parallel levels
+    // NOTE: created from the last one so the dependencies come after the entities in the world's list
+    static const uint32_t CHAIN_LENGTH = 50;
+    Array<TickOrderTestEntityPtr> chain;
+    chain.resize(CHAIN_LENGTH);
+    for (uint32_t i = 0; i < CHAIN_LENGTH; ++i)
+        chain[i] = RefNew<TickOrderTestEntity>();
+    for (uint32_t i = 0; i < CHAIN_LENGTH; ++i)
+        chain[i]->setup(true, i ? chain[i - 1].get() : nullptr);
+    for (int i = CHAIN_LENGTH - 1; i >= 0; --i)
+        world->attachEntity(chain[i].get());
+
+    // cycle with an entity waiting for it, only the cycle itself can't be ordered
+    auto cycleA = CreateTestEntity(world.get(), true);
+    auto cycleB = CreateTestEntity(world.get(), true, cycleA.get());
+    auto cycleC = CreateTestEntity(world.get(), true, cycleB.get());
+    cycleA->setup(true, cycleC.get());
+    auto afterCycle = CreateTestEntity(world.get(), true, cycleC.get());
+
+    // entities that did not opt in
+    Array<TickOrderTestEntityPtr> serialEntities;
+    for (uint32_t i = 0; i < 10; ++i)
+        serialEntities.pushBack(CreateTestEntity(world.get(), false));
+
+    world->update(0.1);
+
+    EXPECT_LE(independentEntities.size(), world->stats().numPreTickParallelEntites);
+    EXPECT_LE(independentEntities.size(), world->stats().numPostTickParallelEntites);
+
+    for (const auto& entity : independentEntities)
+    {
+        EXPECT_NE(0, entity->preTickIndex);
+        EXPECT_NE(0, entity->postTickIndex);
+    }
+
+    for (const auto& entity : serialEntities)
+    {
+        EXPECT_NE(0, entity->preTickIndex);
+        EXPECT_NE(0, entity->postTickIndex);
+    }
+
+    EXPECT_NE(0, chain[0]->preTickIndex);
+    for (uint32_t i = 1; i < CHAIN_LENGTH; ++i)
+        ExpectTickedAfter(chain[i].get(), chain[i - 1].get());
+
+    EXPECT_NE(0, cycleA->preTickIndex);
+    EXPECT_NE(0, cycleB->preTickIndex);
+    EXPECT_NE(0, cycleC->preTickIndex);
+    ExpectTickedAfter(afterCycle.get(), cycleC.get());
+}
+
+TEST(World, SerialTickRespectsTickAfter)
+{
+    auto world = RefNew<World>();
+
+    Array<TickOrderTestEntityPtr> parallelEntities;
+    for (uint32_t i = 0; i < 200; ++i)
+        parallelEntities.pushBack(CreateTestEntity(world.get(), true));
+
+    // serial entity waiting for serial entity that is added later
+    auto serialLater = RefNew<TickOrderTestEntity>();
+    auto serialAfterSerial = CreateTestEntity(world.get(), false, serialLater.get());
+    serialLater->setup(false);
+    world->attachEntity(serialLater.get());
+
+    // serial entity waiting for a parallel one, and parallel entity waiting for it
+    auto serialAfterParallel = CreateTestEntity(world.get(), false, parallelEntities[50].get());
+    auto parallelAfterSerial = CreateTestEntity(world.get(), true, serialAfterParallel.get());
+    auto serialAtEnd = CreateTestEntity(world.get(), false, parallelAfterSerial.get());
+
+    world->update(0.1);
+
+    EXPECT_LE(parallelEntities.size(), world->stats().numPreTickParallelEntites);
+
+    ExpectTickedAfter(serialAfterSerial.get(), serialLater.get());
+    ExpectTickedAfter(serialAfterParallel.get(), parallelEntities[50].get());
+    ExpectTickedAfter(parallelAfterSerial.get(), serialAfterParallel.get());
+    ExpectTickedAfter(serialAtEnd.get(), parallelAfterSerial.get());
+
+    // serial entities that don't wait for parallel ones still tick first
+    for (const auto& entity : parallelEntities)
+        EXPECT_LT(serialAfterSerial->preTickIndex, entity->preTickIndex);
+}
+
+TEST(World, ParallelTickDefersWorldChanges)
+{
+    auto world = RefNew<World>();
+
+    Array<TickOrderTestEntityPtr> entities;
+    for (uint32_t i = 0; i < 200; ++i)
+        entities.pushBack(CreateTestEntity(world.get(), true));
+
+    auto spawned = RefNew<Entity>();
+    entities[10]->entityToAttach = spawned;
+    entities[20]->moveDuringTick = true;
+
+    world->update(0.1);
+
+    // changes were recorded during the parallel tick and applied before the update finished
+    EXPECT_TRUE(spawned->attached());
+    EXPECT_EQ(world.get(), spawned->world());
+
+    EXPECT_EQ(10.0f, entities[20]->absoluteTransform().position().approximate().x);
+
+    EXPECT_LE(2, world->stats().numDeferredCommands);
+}
+
+TEST(World, SerialTickChangesWorldDirectly)
+{
+    auto world = RefNew<World>();
+
+    auto entity = CreateTestEntity(world.get(), false);
+    auto spawned = RefNew<Entity>();
+    entity->entityToAttach = spawned;
+
+    world->update(0.1);
+
+    EXPECT_TRUE(spawned->attached());
+    EXPECT_EQ(0, world->stats().numDeferredCommands);
+}
+
+END_BOOMER_NAMESPACE_EX(test)
@@ -10,9 +10,12 @@
 
 #include "shaderSelector.h"
 #include "core/io/include/timestamp.h"
+#include "core/fibers/include/fiberSystem.h"
 
 BEGIN_BOOMER_NAMESPACE_EX(gpu)
 
+class ShaderDiskCache;
+
 //----
 
 /// shader code dependency
@@ -47,6 +50,30 @@ public:
         StringView code, // code to compile
         HashMap<StringID, StringBuf>* defines,
         Array<ShaderDependency>& outDependencies) = 0;  // defines and their values
+
+    // get current timestamp of the file reported as dependency, returns false if file does not exist
+    virtual bool dependencyTimestamp(StringView path, TimeStamp& outTimestamp) = 0;
+
+    // version of the compiler, changes whenever the generated data changes, invalidates all cached shaders
+    virtual uint32_t version() const = 0;
+};
+
+//----
+
+/// shader cache statistics
+struct GPU_DEVICE_API ShaderCacheStats
+{
+    uint32_t numMemoryHits = 0; // shader was already loaded
+    uint32_t numDiskHits = 0; // shader was loaded from the disk cache
+    uint32_t numDiskOutdated = 0; // shader was in the disk cache but the source files changed since
+    uint32_t numWaits = 0; // shader was being compiled by someone else, we waited for the results
+    uint32_t numCompiled = 0; // shader was compiled
+    uint32_t numFailed = 0; // shader failed to compile
+
+    double diskLoadTime = 0.0; // total time spent loading shaders from disk cache
+    double compilationTime = 0.0; // total time spent compiling shaders
+
+    void print(IFormatStream& f) const;
 };
 
 //----
@@ -58,6 +85,7 @@ class GPU_DEVICE_API ShaderService : public app::ILocalService
 
 public:
 	ShaderService();
+	virtual ~ShaderService();
 
 	//--
 
@@ -70,17 +98,43 @@ public:
 	ShaderDataPtr loadCustomShader(uint64_t hash);
 
     // compile custom shader
+    // NOTE: compiled shader is cached (in memory and on disk) based on the hash, the code and the defines
     ShaderDataPtr compileCustomShader(uint64_t hash, StringView code, HashMap<StringID, StringBuf>* defines = nullptr);
 
     //--
 
+    // get statistics of the shader cache
+    ShaderCacheStats stats() const;
+
+    //--
+
 private:
     RefPtr<IShaderRuntimeCompiler> m_runtimeCompiler;
+    UniquePtr<ShaderDiskCache> m_diskCache;
 
     //--
 
+    // shader being loaded/compiled, others asking for the same shader wait for it
+    struct PendingShader : public IReferencable
+    {
+        FiberSemaphore signal;
+        ShaderDataPtr data;
+    };
+
     SpinLock m_loadedShadersLock;
     HashMap<uint64_t, ShaderDataPtr> m_loadedShaders;
+    HashMap<uint64_t, RefPtr<PendingShader>> m_pendingShaders;
+
+    //--
+
+    SpinLock m_statsLock;
+    ShaderCacheStats m_stats;
+    std::atomic<uint32_t> m_numMemoryHits = 0; // very frequent, not counted under the lock
+
+    //--
+
+    typedef std::function<ShaderDataPtr(Array<ShaderDependency>& outDependencies)> TCompileFunction;
+    ShaderDataPtr loadOrCompileShader(uint64_t key, const TCompileFunction& compileFunc);
 
     //--
 
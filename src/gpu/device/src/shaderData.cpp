@@ -42,6 +42,10 @@ ShaderData::~ShaderData()
 void ShaderData::onPostLoad()
 {
 	TBaseClass::onPostLoad();
+
+	// loaded shaders (ie. from shader cache) need the device objects as well
+	if (!m_deviceShader && !m_data.empty() && m_metadata)
+		createDeviceObjects();
 }
 
 void ShaderData::createDeviceObjects()
@@ -0,0 +1,236 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: shader #]
+*/
+
+#include "build.h"
+#include "shaderData.h"
+#include "shaderDiskCache.h"
+
+#include "core/io/include/io.h"
+
+BEGIN_BOOMER_NAMESPACE_EX(gpu)
+
+//--
+
+static const uint32_t SHADER_CACHE_MAGIC = 0x43444853; // 'SHDC'
+static const uint32_t SHADER_CACHE_VERSION = 1; // format of the cache file, NOT the compiler version
+
+namespace helper
+{
+    struct ShaderCacheFileHeader
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t compilerVersion = 0;
+        uint32_t numDependencies = 0;
+        uint64_t key = 0;
+        uint64_t dependencyHash = 0; // hash of dependency paths and their timestamps at the moment the shader was compiled
+        uint64_t dataSize = 0;
+        uint64_t dataCRC = 0;
+    };
+
+    struct ShaderCacheFileDependency
+    {
+        uint64_t timestamp = 0;
+        uint32_t pathLength = 0;
+        uint32_t padding = 0;
+    };
+
+    template< typename T >
+    static void Write(Array<uint8_t>& output, const T& data)
+    {
+        auto* ptr = output.allocateUninitialized(sizeof(T));
+        memcpy(ptr, &data, sizeof(T));
+    }
+
+    static void WriteData(Array<uint8_t>& output, const void* data, uint64_t size)
+    {
+        auto* ptr = output.allocateUninitialized(size);
+        memcpy(ptr, data, size);
+    }
+
+    struct Reader
+    {
+        const uint8_t* pos = nullptr;
+        const uint8_t* end = nullptr;
+
+        template< typename T >
+        bool read(T& outData)
+        {
+            if (pos + sizeof(T) > end)
+                return false;
+
+            memcpy(&outData, pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        const uint8_t* skip(uint64_t size)
+        {
+            if (size > (uint64_t)(end - pos))
+                return nullptr;
+
+            const auto* ret = pos;
+            pos += size;
+            return ret;
+        }
+    };
+
+} // helper
+
+//--
+
+ShaderDiskCache::ShaderDiskCache(StringView directory, IShaderRuntimeCompiler* compiler)
+    : m_directory(directory)
+    , m_compiler(compiler)
+    , m_compilerVersion(compiler->version())
+{
+    CreatePath(m_directory);
+    TRACE_INFO("Shader cache located at '{}' (compiler version {})", m_directory, m_compilerVersion);
+}
+
+ShaderDiskCache::~ShaderDiskCache()
+{}
+
+StringBuf ShaderDiskCache::filePath(uint64_t key) const
+{
+    // different compiler versions use different files so we can switch between them without thrashing the cache
+    CRC64 crc;
+    crc << key;
+    crc << m_compilerVersion;
+    return TempString("{}{}.shader", m_directory, Hex(crc.crc()));
+}
+
+bool ShaderDiskCache::dependencyHash(const Array<ShaderDependency>& dependencies, bool current, uint64_t& outHash) const
+{
+    CRC64 crc;
+    for (const auto& dep : dependencies)
+    {
+        auto timestamp = dep.timestamp;
+        if (current && !m_compiler->dependencyTimestamp(dep.path, timestamp))
+            return false;
+
+        crc << dep.path;
+        crc << timestamp.value();
+    }
+
+    outHash = crc.crc();
+    return true;
+}
+
+ShaderDataPtr ShaderDiskCache::load(uint64_t key, bool& outOutdated) const
+{
+    outOutdated = false;
+
+    const auto path = filePath(key);
+    if (!FileExists(path))
+        return nullptr;
+
+    const auto content = LoadFileToBuffer(path);
+    if (!content)
+        return nullptr;
+
+    helper::Reader reader;
+    reader.pos = content.data();
+    reader.end = content.data() + content.size();
+
+    helper::ShaderCacheFileHeader header;
+    if (!reader.read(header) || header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION)
+    {
+        TRACE_WARNING("Shader cache file '{}' is invalid", path);
+        return nullptr;
+    }
+
+    // the same file name may be produced by a different key
+    if (header.key != key || header.compilerVersion != m_compilerVersion)
+        return nullptr;
+
+    // load the dependencies
+    Array<ShaderDependency> dependencies;
+    dependencies.reserve(header.numDependencies);
+    for (uint32_t i = 0; i < header.numDependencies; ++i)
+    {
+        helper::ShaderCacheFileDependency dep;
+        if (!reader.read(dep))
+            return nullptr;
+
+        const auto* pathText = reader.skip(dep.pathLength);
+        if (!pathText)
+            return nullptr;
+
+        auto& entry = dependencies.emplaceBack();
+        entry.path = StringBuf(StringView((const char*)pathText, dep.pathLength));
+        entry.timestamp = TimeStamp(dep.timestamp);
+    }
+
+    // check if any of the source files changed since the shader was compiled
+    uint64_t currentDependencyHash = 0;
+    if (!dependencyHash(dependencies, true, currentDependencyHash) || currentDependencyHash != header.dependencyHash)
+    {
+        outOutdated = true;
+        return nullptr;
+    }
+
+    // validate the data
+    const auto* data = reader.skip(header.dataSize);
+    if (!data || header.dataCRC != CRC64().append(data, header.dataSize).crc())
+    {
+        TRACE_WARNING("Shader cache file '{}' is damaged", path);
+        return nullptr;
+    }
+
+    // load the shader object
+    auto ret = rtti_cast<ShaderData>(IObject::FromBuffer(data, (uint32_t)header.dataSize));
+    if (!ret)
+    {
+        TRACE_WARNING("Shader cache file '{}' contains invalid shader data", path);
+        return nullptr;
+    }
+
+    return ret;
+}
+
+void ShaderDiskCache::store(uint64_t key, const Array<ShaderDependency>& dependencies, const ShaderData* data) const
+{
+    const auto objectData = data->toBuffer();
+    if (!objectData)
+        return;
+
+    helper::ShaderCacheFileHeader header;
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.compilerVersion = m_compilerVersion;
+    header.numDependencies = dependencies.size();
+    header.key = key;
+    header.dataSize = objectData.size();
+    header.dataCRC = CRC64().append(objectData.data(), objectData.size()).crc();
+    dependencyHash(dependencies, false, header.dependencyHash);
+
+    Array<uint8_t> content;
+    content.reserve(sizeof(header) + dependencies.size() * 64 + objectData.size());
+
+    helper::Write(content, header);
+    for (const auto& dep : dependencies)
+    {
+        helper::ShaderCacheFileDependency entry;
+        entry.timestamp = dep.timestamp.value();
+        entry.pathLength = dep.path.length();
+        helper::Write(content, entry);
+        helper::WriteData(content, dep.path.c_str(), entry.pathLength);
+    }
+
+    helper::WriteData(content, objectData.data(), objectData.size());
+
+    // NOTE: file is first written to a temporary location so a partially written file is never visible
+    const auto path = filePath(key);
+    if (!SaveFileFromBuffer(path, content.data(), content.dataSize()))
+        TRACE_WARNING("Failed to store shader in cache file '{}'", path);
+}
+
+//--
+
+END_BOOMER_NAMESPACE_EX(gpu)
@@ -0,0 +1,46 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: shader #]
+***/
+
+#pragma once
+
+#include "shaderService.h"
+
+BEGIN_BOOMER_NAMESPACE_EX(gpu)
+
+//----
+
+/// content addressed disk cache for compiled shaders, one file per shader
+/// file name is derived from the shader key and the compiler version, file contains the list of source files the shader was compiled from
+/// NOTE: cached shader is only used if none of the source files changed since it was compiled
+class ShaderDiskCache : public NoCopy
+{
+public:
+    ShaderDiskCache(StringView directory, IShaderRuntimeCompiler* compiler);
+    ~ShaderDiskCache();
+
+    //--
+
+    // load shader from cache, returns nullptr if the shader is not there
+    // NOTE: outdated entries are reported via the flag so they can be counted
+    ShaderDataPtr load(uint64_t key, bool& outOutdated) const;
+
+    // store compiled shader in the cache
+    void store(uint64_t key, const Array<ShaderDependency>& dependencies, const ShaderData* data) const;
+
+private:
+    StringBuf m_directory;
+    IShaderRuntimeCompiler* m_compiler = nullptr;
+    uint32_t m_compilerVersion = 0;
+
+    StringBuf filePath(uint64_t key) const;
+    bool dependencyHash(const Array<ShaderDependency>& dependencies, bool current, uint64_t& outHash) const;
+};
+
+//----
+
+END_BOOMER_NAMESPACE_EX(gpu)
@@ -10,8 +10,10 @@
 #include "shaderData.h"
 #include "shaderService.h"
 #include "shaderMetadata.h"
+#include "shaderDiskCache.h"
 
 #include "gpu/device/include/shader.h"
+#include "core/app/include/commandline.h"
 
 BEGIN_BOOMER_NAMESPACE_EX(gpu)
 
@@ -35,12 +37,27 @@ IShaderRuntimeCompiler::~IShaderRuntimeCompiler()
 
 //--
 
+void ShaderCacheStats::print(IFormatStream& f) const
+{
+    f.appendf("{} loaded, {} from disk cache ({} outdated), {} compiled ({} failed), {} waited. Disk load time: {}, compilation time: {}",
+        numMemoryHits, numDiskHits, numDiskOutdated, numCompiled, numFailed, numWaits, TimeInterval(diskLoadTime), TimeInterval(compilationTime));
+}
+
+//--
+
+static const ConfigProperty<bool> cvShaderDiskCacheEnabled("Rendering.Shaders", "DiskCacheEnabled", true);
+
+//--
+
 RTTI_BEGIN_TYPE_CLASS(ShaderService);
 RTTI_END_TYPE();
 
 ShaderService::ShaderService()
 {}
 
+ShaderService::~ShaderService()
+{}
+
 app::ServiceInitializationResult ShaderService::onInitializeService(const app::CommandLine& cmdLine)
 {
     // find runtime compiler
@@ -54,64 +71,139 @@ app::ServiceInitializationResult ShaderService::onInitializeService(const app::C
         TRACE_INFO("No runtime shader compiler found, missing shaders won't be compiled");
     }
 
-    // TODO: load global shader cache
-    // TODO: load local shader cache
+    // compiled shaders are cached on disk so we don't have to compile them again on next run
+    if (m_runtimeCompiler && cvShaderDiskCacheEnabled.get() && !cmdLine.hasParam("noShaderCache"))
+    {
+        const auto directory = StringBuf(TempString("{}shaders/", SystemPath(PathCategory::LocalTempDir)));
+        m_diskCache.create(directory, m_runtimeCompiler.get());
+    }
 
     return app::ServiceInitializationResult::Finished;
 }
 
 void ShaderService::onShutdownService()
 {
-    // nothing
+    TRACE_INFO("Shader cache: {}", stats());
+    m_diskCache.reset();
 }
 
 void ShaderService::onSyncUpdate()
 {
-    // TODO: periodically save shader cache
+    // nothing
 }
 
-ShaderDataPtr ShaderService::loadSystemShader(StringView path, const ShaderSelector& selector)
+ShaderCacheStats ShaderService::stats() const
 {
-    // build key
-    CRC64 key;
-    key << "SHADER_";
-    key << path;
-    selector.hash(key);
+    auto lock = CreateLock(m_statsLock);
+    auto ret = m_stats;
+    ret.numMemoryHits = m_numMemoryHits.load();
+    return ret;
+}
 
-    // find in runtime cache
+ShaderDataPtr ShaderService::loadOrCompileShader(uint64_t key, const TCompileFunction& compileFunc)
+{
+    // find in runtime cache or join the job that is already loading/compiling this shader
+    auto lock = CreateLock(m_loadedShadersLock);
+
+    ShaderDataPtr existingData;
+    if (m_loadedShaders.find(key, existingData))
     {
-        auto lock = CreateLock(m_loadedShadersLock);
+        lock.release();
 
-        ShaderDataPtr data;
-        if (m_loadedShaders.find(key.crc(), data))
-            return data;
+        m_numMemoryHits += 1;
+        return existingData;
     }
 
-    // compile
-    ShaderDataPtr ret;
-    if (m_runtimeCompiler)
+    RefPtr<PendingShader> pending;
+    if (m_pendingShaders.find(key, pending))
     {
-        HashMap<StringID, StringBuf> defines;
-        selector.defines(defines);
+        lock.release();
+
+        {
+            auto statsLock = CreateLock(m_statsLock);
+            m_stats.numWaits += 1;
+        }
 
-        Array<ShaderDependency> dependencies; // not used now
-        ret = m_runtimeCompiler->compileFile(path, &defines, dependencies);
+        WaitForFence(pending->signal);
+        return pending->data;
     }
-    else
+
+    pending = RefNew<PendingShader>();
+    pending->signal = CreateFence("ShaderServiceCompilation");
+    m_pendingShaders[key] = pending;
+
+    // release lock so other threads may join waiting
+    lock.release();
+
+    // try the disk cache first
+    if (m_diskCache)
     {
-        TRACE_WARNING("Shader compilation not possible");
+        ScopeTimer timer;
+
+        bool outdated = false;
+        pending->data = m_diskCache->load(key, outdated);
+
+        auto statsLock = CreateLock(m_statsLock);
+        m_stats.diskLoadTime += timer.timeElapsed();
+        m_stats.numDiskHits += pending->data ? 1 : 0;
+        m_stats.numDiskOutdated += outdated ? 1 : 0;
     }
 
-    // store in memory cache
-    if (ret)
+    // compile
+    if (!pending->data)
+    {
+        ScopeTimer timer;
+
+        Array<ShaderDependency> dependencies;
+        pending->data = compileFunc(dependencies);
+
+        {
+            auto statsLock = CreateLock(m_statsLock);
+            m_stats.compilationTime += timer.timeElapsed();
+            m_stats.numCompiled += pending->data ? 1 : 0;
+            m_stats.numFailed += pending->data ? 0 : 1;
+        }
+
+        if (pending->data && m_diskCache)
+            m_diskCache->store(key, dependencies, pending->data.get());
+    }
+
+    // store in memory cache, failed shaders are not stored so we will retry compiling them
     {
         auto lock = CreateLock(m_loadedShadersLock);
-        m_loadedShaders[key.crc()] = ret;
+
+        if (pending->data)
+            m_loadedShaders[key] = pending->data;
+
+        m_pendingShaders.remove(key);
     }
 
-    // TODO: add to persistent local cache
+    // wake up all waiting
+    SignalFence(pending->signal);
+    return pending->data;
+}
 
-    return ret;
+ShaderDataPtr ShaderService::loadSystemShader(StringView path, const ShaderSelector& selector)
+{
+    // build key
+    CRC64 key;
+    key << "SHADER_";
+    key << path;
+    selector.hash(key);
+
+    return loadOrCompileShader(key.crc(), [this, path, &selector](Array<ShaderDependency>& outDependencies) -> ShaderDataPtr
+        {
+            if (!m_runtimeCompiler)
+            {
+                TRACE_WARNING("Shader compilation not possible");
+                return nullptr;
+            }
+
+            HashMap<StringID, StringBuf> defines;
+            selector.defines(defines);
+
+            return m_runtimeCompiler->compileFile(path, &defines, outDependencies);
+        });
 }
 
 ShaderDataPtr ShaderService::loadCustomShader(uint64_t hash)
@@ -127,15 +219,24 @@ ShaderDataPtr ShaderService::compileCustomShader(uint64_t hash, StringView code,
 {
     DEBUG_CHECK_RETURN_EX_V(m_runtimeCompiler, "No runtime shader compiler", nullptr);
 
-    Array<ShaderDependency> dependencies; // not used now
-    auto ret = m_runtimeCompiler->compileCode(code, defines, dependencies);
-    if (ret)
+    // the hash alone does not describe the content (ie. material being edited), key must include the code and the defines
+    CRC64 key;
+    key << "CUSTOM_";
+    key << hash;
+    key << code;
+    if (defines)
     {
-        //auto lock = CreateLock(m_loadedShadersLock);
-        //m_loadedShaders[hash] = ret;
+        for (const auto& pair : defines->pairs())
+        {
+            key << pair.key;
+            key << pair.value;
+        }
     }
-        
-    return ret;
+
+    return loadOrCompileShader(key.crc(), [this, code, defines](Array<ShaderDependency>& outDependencies)
+        {
+            return m_runtimeCompiler->compileCode(code, defines, outDependencies);
+        });
 }
 
 //--
@@ -184,7 +285,7 @@ ShaderObjectPtr LoadStaticShaderDeviceObject(StringView path)
 ShaderObjectPtr LoadStaticShaderDeviceObject(StringView path, const ShaderSelector& selectors)
 {
     if (auto service = GetService<ShaderService>())
-        if (auto data = service->loadSystemShader(path))
+        if (auto data = service->loadSystemShader(path, selectors))
             if (data->deviceShader())
                 return data->deviceShader();
 
@@ -15,6 +15,7 @@ Dependency("core_fibers")
 Dependency("core_parser")
 Dependency("core_resource") -- remove!
 Dependency("core_io")
+Dependency("core_test")
 
 Dependency("gpu_device")
 
@@ -111,6 +111,9 @@ private:
     // type library where are composite and enum types are registered
     TypeLibrary* m_typeLibrary;
 
+    // additional allocators used when parsing code in parallel
+    Array<UniquePtr<LinearAllocator>> m_parsingAllocators;
+
     // all top-level global functions
     typedef HashMap<StringID, Function*> TGlobalFunctionMap;
     TGlobalFunctionMap m_globalFunctions;
@@ -23,9 +23,15 @@ class GPU_SHADER_COMPILER_API ShaderCompiler : public IShaderRuntimeCompiler
 
 public:
     ShaderCompiler();
+    virtual ~ShaderCompiler();
 
     virtual ShaderDataPtr compileFile(StringView filePath, HashMap<StringID, StringBuf>* defines, Array<ShaderDependency>& outDependencies) override final;
     virtual ShaderDataPtr compileCode(StringView code, HashMap<StringID, StringBuf>* defines, Array<ShaderDependency>& outDependencies) override final;
+    virtual bool dependencyTimestamp(StringView path, TimeStamp& outTimestamp) override final;
+    virtual uint32_t version() const override final;
+
+    // preprocessed includes shared by all compilations
+    INLINE const parser::TextIncludeCache& includeCache() const { return *m_includeCache; }
 
 private:
     StringBuf m_path; // /data/s
@@ -45,6 +51,10 @@ private:
 
     //--
 
+    UniquePtr<parser::TextIncludeCache> m_includeCache; // preprocessed includes shared by all compilations
+
+    //--
+
     ShaderDataPtr compileInternal(StringView filePath, StringView code, HashMap<StringID, StringBuf>* defines, Array<ShaderDependency>& outDependencies);
 
     //--
@@ -18,6 +18,8 @@
 #include "fileParser.h"
 #include "dataType.h"
 
+#include "core/fibers/include/fiberSystem.h"
+
 BEGIN_BOOMER_NAMESPACE_EX(gpu::compiler)
 
 //---
@@ -1368,12 +1370,33 @@ bool CodeLibrary::parseCode(parser::IErrorReporter& err)
         }
     }
 
-    // compile stuff
-    // TODO: fibers
-    for (auto& entry : entries)
+    // parse the code of all entries, parsing only reads the library so it's done in parallel
+    // NOTE: linear allocator is not thread safe so each batch of entries gets it's own one, it must live as long as the library
+    Array<CodeNode*> parsedCode;
+    parsedCode.resizeWith(entries.size(), nullptr);
     {
-        // parse the code from the tokens
-        auto code  = Analyzecode(allocator(), err, entry.tokens, *this, entry.function, entry.program);
+        const auto numBatches = std::min<uint32_t>(entries.size(), std::max<uint32_t>(1, WorkerThreadCount()));
+        const auto firstAllocator = m_parsingAllocators.size();
+        for (uint32_t i = 0; i < numBatches; ++i)
+            m_parsingAllocators.emplaceBack(new LinearAllocator(POOL_SHADER_COMPILATION));
+
+        RunFiberLoop("ParseShaderCode", numBatches, -1, [this, &entries, &parsedCode, &err, numBatches, firstAllocator](uint32_t batchIndex)
+            {
+                auto& mem = *m_parsingAllocators[firstAllocator + batchIndex];
+                for (uint32_t i = batchIndex; i < entries.size(); i += numBatches)
+                {
+                    const auto& entry = entries[i];
+                    parsedCode[i] = Analyzecode(mem, err, entry.tokens, *this, entry.function, entry.program);
+                }
+            });
+    }
+
+    // resolve types in order, resolving may create program parameters on demand so it's not safe to do it in parallel
+    for (uint32_t entryIndex = 0; entryIndex < entries.size(); ++entryIndex)
+    {
+        auto& entry = entries[entryIndex];
+
+        auto code = parsedCode[entryIndex];
         if (!code)
         {
             valid = false;
@@ -22,6 +22,7 @@
 #include "core/object/include/stubBuilder.h"
 #include "core/object/include/stubLoader.h"
 #include "core/parser/include/textToken.h"
+#include "core/fibers/include/fiberSystem.h"
 
 BEGIN_BOOMER_NAMESPACE_EX(gpu::compiler)
 
@@ -117,27 +118,45 @@ public:
 	{
 		clear();
 
-		// build stages
+		// fold (optimize and suck-in constants) the stage functions to their final form
+		// NOTE: stages are independent so they are folded in parallel, each with it's own memory as the linear allocator is not thread safe
+		InplaceArray<uint32_t, NUM_STAGES> activeStages;
 		for (uint32_t i=0; i<NUM_STAGES; ++i)
-		{
-			const auto& sourceStage = bundle.stages[i];
-			if (sourceStage.func)
+			if (bundle.stages[i].func)
+				activeStages.pushBack(i);
+
+		Function* finalFuncs[NUM_STAGES];
+		memzero(finalFuncs, sizeof(finalFuncs));
+
+		UniquePtr<LinearAllocator> foldingMemory[NUM_STAGES];
+		for (auto i : activeStages)
+			foldingMemory[i].reset(new LinearAllocator(POOL_SHADER_COMPILATION));
+
+		RunFiberLoop("FoldShaderStages", activeStages.size(), -1, [this, &bundle, &activeStages, &finalFuncs, &foldingMemory, &err](uint32_t index)
 			{
-				FunctionFolder folder(m_mem, const_cast<CodeLibrary&>(m_lib)); // TODO: fix const cast
+				const auto stageIndex = activeStages[index];
+				const auto& sourceStage = bundle.stages[stageIndex];
+
+				FunctionFolder folder(*foldingMemory[stageIndex], const_cast<CodeLibrary&>(m_lib)); // TODO: fix const cast
 
-				// fold (optimize and suck-in constants) the function to it's final form 
 				ProgramConstants emptyConstants;
-				if (auto* finalFunc = folder.foldFunction(sourceStage.func, sourceStage.pi, emptyConstants, err))
-				{
-					m_activeStage = &m_stages[i];
-					m_activeStage->stage = (ShaderStage)i;
-					m_activeStage->sourceEntryFunction = sourceStage.func;
-					m_activeStage->m_entryFunction = exportFunction(finalFunc);
-				}
-				else
-				{
-					return nullptr;
-				}
+				finalFuncs[stageIndex] = folder.foldFunction(sourceStage.func, sourceStage.pi, emptyConstants, err);
+			});
+
+		// build stages
+		for (auto i : activeStages)
+		{
+			const auto& sourceStage = bundle.stages[i];
+			if (auto* finalFunc = finalFuncs[i])
+			{
+				m_activeStage = &m_stages[i];
+				m_activeStage->stage = (ShaderStage)i;
+				m_activeStage->sourceEntryFunction = sourceStage.func;
+				m_activeStage->m_entryFunction = exportFunction(finalFunc);
+			}
+			else
+			{
+				return nullptr;
 			}
 		}
 
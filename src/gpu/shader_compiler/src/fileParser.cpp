@@ -496,7 +496,7 @@ CodeNode* Analyzecode(
     // root node must be a scope node
     if (rootNode->opCode() != OpCode::Scope && contextFunction)
     {
-        auto scopeNode = lib.allocator().create<CodeNode>(rootNode->location(), OpCode::Scope);
+        auto scopeNode = mem.create<CodeNode>(rootNode->location(), OpCode::Scope);
         scopeNode->addChild(rootNode);
         rootNode = scopeNode;
     }
@@ -22,6 +22,7 @@
 #include "core/containers/include/stringBuilder.h"
 #include "core/resource/include/resource.h"
 #include "core/parser/include/textFilePreprocessor.h"
+#include "core/parser/include/textIncludeCache.h"
 #include "core/io/include/io.h"
 
 #include "gpu/device/include/shaderData.h"
@@ -79,6 +80,11 @@ private:
 
 //---
 
+// bump whenever the generated shader data changes, invalidates all shaders in the shader cache
+static const uint32_t SHADER_COMPILER_VERSION = 1;
+
+//---
+
 RTTI_BEGIN_TYPE_CLASS(ShaderCompiler);
 RTTI_END_TYPE();
 
@@ -88,6 +94,13 @@ ShaderCompiler::ShaderCompiler()
 	const auto engineRootDirectory = SystemPath(PathCategory::EngineDir);
 	m_path = StringBuf(TempString("{}data/shaders/", engineRootDirectory));
 	TRACE_INFO("Engine s directory: '{}'", m_path);
+
+	m_includeCache.reset(new parser::TextIncludeCache());
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	TRACE_INFO("Shader include cache: {}", *m_includeCache);
 }
 
 void StoreDependency(Array<ShaderDependency>* outDependencies, StringView path, TimeStamp timestamp)
@@ -202,14 +215,22 @@ ShaderDataPtr ShaderCompiler::compileCode(StringView code, HashMap<StringID, Str
 	return ret;
 }
 
-//--
+bool ShaderCompiler::dependencyTimestamp(StringView path, TimeStamp& outTimestamp)
+{
+	const auto fullPath = StringBuf(TempString("{}{}", m_path, path));
+	return FileTimeStamp(fullPath, outTimestamp);
+}
+
+uint32_t ShaderCompiler::version() const
+{
+	return SHADER_COMPILER_VERSION;
+}
 
-Mutex GGlobalcompilationMutex;
+//--
 
+// NOTE: compilations don't share any state except the source file and include caches so many of them can run at the same time
 ShaderDataPtr ShaderCompiler::compileInternal(StringView filePath, StringView code, HashMap<StringID, StringBuf>* defines, Array<ShaderDependency>& outDependencies)
 {
-	auto lock = CreateLock(GGlobalcompilationMutex);
-
     LinearAllocator mem(POOL_SHADER_COMPILATION);
     ScopeTimer timer;
 
@@ -220,6 +241,7 @@ ShaderDataPtr ShaderCompiler::compileInternal(StringView filePath, StringView co
 	{
 		// setup preprocessor
 		parser::TextFilePreprocessor parser(mem, includeHandler, errorReporter, parser::ICommentEater::StandardComments(), GetlanguageDefinition());
+		parser.attachIncludeCache(m_includeCache.get());
 
 		// inject given defines
 		if (nullptr != defines)
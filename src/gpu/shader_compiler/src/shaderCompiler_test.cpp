@@ -0,0 +1,193 @@
+/***
+* Boomer Engine v4
+* Written by Tomasz Jonarski (RexDex)
+* Source code licensed under LGPL 3.0 license
+*
+* [# filter: tests #]
+***/
+
+#include "build.h"
+
+#include "core/test/include/gtest/gtest.h"
+#include "core/parser/include/textIncludeCache.h"
+#include "core/io/include/io.h"
+
+#include "gpu/device/include/shaderData.h"
+
+#include "shaderCompiler.h"
+
+DECLARE_TEST_FILE(ShaderCompiler);
+
+BEGIN_BOOMER_NAMESPACE_EX(gpu::compiler)
+
+namespace helper
+{
+    // shaders used by the rendering tests, small but they share the common includes
+    static void ListTestShaders(Array<StringBuf>& outPaths)
+    {
+        Array<StringBuf> fileNames;
+        FindLocalFiles(TempString("{}data/shaders/tests/", SystemPath(PathCategory::EngineDir)), "*.csl", fileNames);
+        std::sort(fileNames.begin(), fileNames.end(), [](const StringBuf& a, const StringBuf& b) { return a.view() < b.view(); });
+
+        for (const auto& name : fileNames)
+            outPaths.pushBack(StringBuf(TempString("tests/{}", name)));
+    }
+
+    static ShaderDataPtr CompileShader(ShaderCompiler& compiler, StringView path, HashMap<StringID, StringBuf>* defines = nullptr)
+    {
+        Array<ShaderDependency> dependencies;
+        return compiler.compileFile(path, defines, dependencies);
+    }
+
+    static void CompileShaders(ShaderCompiler& compiler, const Array<StringBuf>& paths, bool parallel, Array<ShaderDataPtr>& outShaders)
+    {
+        outShaders.reset();
+        outShaders.resize(paths.size());
+
+        if (parallel)
+        {
+            RunFiberLoop("TestCompileShaders", paths.size(), -1, [&compiler, &paths, &outShaders](uint32_t index)
+                {
+                    outShaders[index] = CompileShader(compiler, paths[index]);
+                });
+        }
+        else
+        {
+            for (uint32_t i = 0; i < paths.size(); ++i)
+                outShaders[i] = CompileShader(compiler, paths[i]);
+        }
+    }
+
+    static bool SameShaderData(const ShaderData* a, const ShaderData* b)
+    {
+        if (!a || !b)
+            return a == b;
+
+        return a->data().size() == b->data().size() && 0 == memcmp(a->data().data(), b->data().data(), a->data().size());
+    }
+
+} // helper
+
+//--
+
+TEST(ShaderCompiler, CompileReportsIncludes)
+{
+    ShaderCompiler compiler;
+
+    Array<ShaderDependency> dependencies;
+    auto data = compiler.compileFile("tests/TriangleDefineColorRed.csl", nullptr, dependencies);
+    ASSERT_TRUE(data);
+    EXPECT_NE(0, data->data().size());
+
+    bool hasInclude = false;
+    for (const auto& dep : dependencies)
+        hasInclude |= dep.path.view().endsWith("TriangleDefineColor.h");
+    EXPECT_TRUE(hasInclude);
+}
+
+TEST(ShaderCompiler, CachedIncludesRespectMacros)
+{
+    ShaderCompiler compiler;
+
+    // the same include is used with different value of the macro
+    auto red = helper::CompileShader(compiler, "tests/TriangleDefineColorRed.csl");
+    auto blue = helper::CompileShader(compiler, "tests/TriangleDefineColorBlue.csl");
+    auto redAgain = helper::CompileShader(compiler, "tests/TriangleDefineColorRed.csl");
+    ASSERT_TRUE(red);
+    ASSERT_TRUE(blue);
+    ASSERT_TRUE(redAgain);
+
+    EXPECT_LT(0, compiler.includeCache().numHits());
+    EXPECT_FALSE(helper::SameShaderData(red, blue));
+    EXPECT_TRUE(helper::SameShaderData(red, redAgain));
+
+    // same as without any cached includes
+    ShaderCompiler freshCompiler;
+    auto blueFresh = helper::CompileShader(freshCompiler, "tests/TriangleDefineColorBlue.csl");
+    EXPECT_TRUE(helper::SameShaderData(blue, blueFresh));
+}
+
+TEST(ShaderCompiler, DefinesSelectPermutation)
+{
+    ShaderCompiler compiler;
+
+    HashMap<StringID, StringBuf> greenDefines;
+    greenDefines["TRIANGLE_COLOR"_id] = StringBuf("vec3(0,1,0)");
+
+    // the file has a default color if the macro is not given
+    auto defaultColor = helper::CompileShader(compiler, "tests/TriangleDefineColor.h");
+    auto green = helper::CompileShader(compiler, "tests/TriangleDefineColor.h", &greenDefines);
+    auto defaultColorAgain = helper::CompileShader(compiler, "tests/TriangleDefineColor.h");
+    auto greenAgain = helper::CompileShader(compiler, "tests/TriangleDefineColor.h", &greenDefines);
+    ASSERT_TRUE(defaultColor);
+    ASSERT_TRUE(green);
+
+    EXPECT_FALSE(helper::SameShaderData(defaultColor, green));
+    EXPECT_TRUE(helper::SameShaderData(defaultColor, defaultColorAgain));
+    EXPECT_TRUE(helper::SameShaderData(green, greenAgain));
+}
+
+TEST(ShaderCompiler, ParallelCompilationMatchesSerial)
+{
+    Array<StringBuf> paths;
+    helper::ListTestShaders(paths);
+    ASSERT_LT(10, paths.size());
+
+    Array<ShaderDataPtr> serialShaders;
+    {
+        ShaderCompiler compiler;
+        helper::CompileShaders(compiler, paths, false, serialShaders);
+    }
+
+    Array<ShaderDataPtr> parallelShaders;
+    {
+        ShaderCompiler compiler;
+        helper::CompileShaders(compiler, paths, true, parallelShaders);
+    }
+
+    uint32_t numCompiled = 0;
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        EXPECT_TRUE(helper::SameShaderData(serialShaders[i], parallelShaders[i])) << "Different results for " << paths[i].c_str();
+        if (serialShaders[i])
+            numCompiled += 1;
+    }
+
+    EXPECT_LT(paths.size() / 2, numCompiled);
+}
+
+//--
+
+static const uint32_t SHADER_COMPILER_PERF_ITERATIONS = 3;
+
+TEST(ShaderCompiler, Perf_CompileTestShaders)
+{
+    Array<StringBuf> paths;
+    helper::ListTestShaders(paths);
+
+    // each run starts with empty caches, as the first compilation after the engine starts
+    TimingStatistics serialStats, parallelStats;
+    for (uint32_t run = 0; run < SHADER_COMPILER_PERF_ITERATIONS; ++run)
+    {
+        Array<ShaderDataPtr> shaders;
+
+        {
+            ShaderCompiler compiler;
+            ScopeTimer timer;
+            helper::CompileShaders(compiler, paths, false, shaders);
+            serialStats.update(timer.timeElapsed());
+        }
+
+        {
+            ShaderCompiler compiler;
+            ScopeTimer timer;
+            helper::CompileShaders(compiler, paths, true, shaders);
+            parallelStats.update(timer.timeElapsed());
+        }
+    }
+
+    TRACE_WARNING("ShaderCompiler {} files: serial {} avg, parallel {} avg, speedup {}x", paths.size(),
+        TimeInterval(serialStats.mean()), TimeInterval(parallelStats.mean()), Prec(serialStats.mean() / parallelStats.mean(), 2));
+}
+
+END_BOOMER_NAMESPACE_EX(gpu::compiler)